@@ -27,6 +27,7 @@
 #include "printf.h"
 #include "scan.h"
 #include "thread.h"
+#include "timeline.h"
 #include "type.h"
 #include "vlog/vlog-phase.h"
 #include "sdf/sdf-phase.h"
@@ -796,6 +797,42 @@ bool is_body(tree_t t)
    }
 }
 
+static void clock_edge_cb(tree_t t, void *ctx)
+{
+   bool *clocked = ctx;
+
+   // Simple heuristic to detect clock expressions
+   switch (tree_kind(t)) {
+   case T_ATTR_REF:
+      if (tree_subkind(t) == ATTR_EVENT)
+         *clocked = true;
+      break;
+
+   case T_FCALL:
+      {
+         switch (is_well_known(tree_ident2(tree_ref(t)))) {
+         case W_IEEE_1164_RISING_EDGE:
+         case W_IEEE_1164_FALLING_EDGE:
+            *clocked = true;
+            break;
+         default:
+            break;
+         }
+      }
+      break;
+
+   default:
+      break;
+   }
+}
+
+bool has_clock_edge(tree_t expr)
+{
+   bool clocked = false;
+   tree_visit(expr, clock_edge_cb, &clocked);
+   return clocked;
+}
+
 bool is_guarded_signal(tree_t decl)
 {
    switch (tree_kind(decl)) {
@@ -2602,6 +2639,8 @@ void capture_syntax(text_buf_t *tb)
 void analyse_file(const char *file, jit_t *jit, unit_registry_t *ur,
                   mir_context_t *mc)
 {
+   TIMELINE_BEGIN("analyse", istr(ident_new(file)));
+
    input_from_file(file);
 
    switch (source_kind()) {
@@ -2625,11 +2664,17 @@ void analyse_file(const char *file, jit_t *jit, unit_registry_t *ur,
 
    case SOURCE_VERILOG:
       {
-         LOCAL_TEXT_BUF tb = tb_new();
-         vlog_preprocess(tb, true);
-
-         file_ref_t file_ref = loc_file_ref(file, NULL);
-         input_from_buffer(tb_get(tb), tb_len(tb), file_ref, SOURCE_VERILOG);
+         // Avoid copying the whole file into memory when it does not
+         // contain any macros or conditional compilation directives
+         LOCAL_TEXT_BUF tb = NULL;
+         if (vlog_needs_preprocess()) {
+            tb = tb_new();
+            vlog_preprocess(tb, true);
+
+            file_ref_t file_ref = loc_file_ref(file, NULL);
+            input_from_buffer(tb_get(tb), tb_len(tb), file_ref,
+                              SOURCE_VERILOG);
+         }
 
          lib_t work = lib_work();
          vlog_node_t module;
@@ -2658,6 +2703,8 @@ void analyse_file(const char *file, jit_t *jit, unit_registry_t *ur,
       }
       break;
    }
+
+   TIMELINE_END("analyse");
 }
 
 bool all_character_literals(type_t type)
@@ -208,6 +208,9 @@ typedef enum {
    COVER_MASK_TOGGLE_INCLUDE_MEMS         = (1 << 10),
    COVER_MASK_EXCLUDE_UNREACHABLE         = (1 << 11),
    COVER_MASK_FSM_NO_DEFAULT_ENUMS        = (1 << 12),
+   COVER_MASK_TOGGLE_PER_TIME_STEP        = (1 << 13),
+   COVER_MASK_HIT_ONLY                    = (1 << 14),
+   COVER_MASK_SAMPLED                     = (1 << 15),
    COVER_MASK_DONT_PRINT_COVERED          = (1 << 16),
    COVER_MASK_DONT_PRINT_UNCOVERED        = (1 << 17),
    COVER_MASK_DONT_PRINT_EXCLUDED         = (1 << 18),
@@ -226,6 +229,7 @@ typedef enum {
 cover_data_t *cover_data_init(cover_mask_t mask, int array_limit, int threshold);
 void cover_data_free(cover_data_t *db);
 bool cover_enabled(cover_data_t *data, cover_mask_t mask);
+void cover_set_sampling(cover_data_t *db, uint64_t window, uint64_t period);
 
 void cover_write(cover_data_t *db, fbuf_t *f, cover_dump_t dt);
 cover_data_t *cover_read(fbuf_t *f, uint32_t pre_mask);
@@ -63,7 +63,7 @@ static const struct {
 };
 
 #define COVER_FILE_MAGIC   0x6e636462   // ASCII "ncdb"
-#define COVER_FILE_VERSION 6
+#define COVER_FILE_VERSION 7
 
 static inline unsigned get_next_tag(cover_block_t *b)
 {
@@ -725,29 +725,47 @@ static void cover_write_items(const cover_item_t *item, fbuf_t *f,
    fbuf_put_uint(f, item->kind);
    fbuf_put_uint(f, item->source);
 
+   // Each field of the consecutive items is written as a separate
+   // column which groups similar values together and lets tags, which
+   // are usually sequential, be stored as small deltas
    for (int i = 0; i < item->consecutive; i++) {
       assert(item[i].kind == item->kind);
       assert(item[i].consecutive == item->consecutive - i);
       assert(item[i].source == item->source);
 
-      fbuf_put_uint(f, item[i].tag);
+      fbuf_put_int(f, item[i].tag - (i > 0 ? item[i - 1].tag : 0));
+   }
+
+   for (int i = 0; i < item->consecutive; i++)
       fbuf_put_uint(f, item[i].data);
+
+   for (int i = 0; i < item->consecutive; i++)
       fbuf_put_uint(f, item[i].flags);
+
+   for (int i = 0; i < item->consecutive; i++)
       fbuf_put_uint(f, item[i].atleast);
-      fbuf_put_uint(f, item[i].n_ranges);
+
+   for (int i = 0; i < item->consecutive; i++)
       fbuf_put_uint(f, item[i].metadata);
 
+   for (int i = 0; i < item->consecutive; i++) {
+      fbuf_put_uint(f, item[i].n_ranges);
+
       for (int j = 0; j < item[i].n_ranges; j++) {
          fbuf_put_uint(f, item[i].ranges[j].min);
          fbuf_put_uint(f, item[i].ranges[j].max);
       }
+   }
 
+   for (int i = 0; i < item->consecutive; i++) {
       loc_write(&(item[i].loc), loc_ctx);
       if (item[i].flags & COVER_FLAGS_LHS_RHS_BINS) {
          loc_write(&(item[i].loc_lhs), loc_ctx);
          loc_write(&(item[i].loc_rhs), loc_ctx);
       }
+   }
 
+   for (int i = 0; i < item->consecutive; i++) {
       ident_write(item[i].hier, ident_ctx);
       if (item[i].kind == COV_ITEM_EXPRESSION ||
           item[i].kind == COV_ITEM_STATE ||
@@ -871,6 +889,17 @@ void cover_data_free(cover_data_t *db)
    free(db);
 }
 
+void cover_set_sampling(cover_data_t *db, uint64_t window, uint64_t period)
+{
+   assert(window > 0 && window < period);
+
+   db->sample_window = window;
+   db->sample_period = period;
+
+   // Saved with the database so merged results can be identified
+   db->mask |= COVER_MASK_SAMPLED;
+}
+
 bool cover_enabled(cover_data_t *data, cover_mask_t mask)
 {
    return data != NULL && (data->mask & mask);
@@ -1012,28 +1041,45 @@ static cover_item_t *cover_read_item(cover_data_t *db, fbuf_t *f,
       item[i].consecutive = consecutive - i;
       item[i].kind        = kind;
       item[i].source      = src;
-      item[i].tag         = fbuf_get_uint(f);
-      item[i].data        = fbuf_get_uint(f);
-      item[i].flags       = fbuf_get_uint(f);
-      item[i].atleast     = fbuf_get_uint(f);
-      item[i].n_ranges    = fbuf_get_uint(f);
-      item[i].metadata    = fbuf_get_uint(f);
+      item[i].tag         = fbuf_get_int(f) + (i > 0 ? item[i - 1].tag : 0);
+   }
+
+   for (int i = 0; i < consecutive; i++)
+      item[i].data = fbuf_get_uint(f);
+
+   for (int i = 0; i < consecutive; i++)
+      item[i].flags = fbuf_get_uint(f);
+
+   for (int i = 0; i < consecutive; i++)
+      item[i].atleast = fbuf_get_uint(f);
+
+   for (int i = 0; i < consecutive; i++)
+      item[i].metadata = fbuf_get_uint(f);
+
+   for (int i = 0; i < consecutive; i++) {
+      item[i].n_ranges = fbuf_get_uint(f);
 
       if (item[i].n_ranges > 0)
          item[i].ranges = pool_malloc_array(db->pool, item[i].n_ranges,
                                             sizeof(cover_range_t));
+      else
+         item[i].ranges = NULL;
 
       for (int j = 0; j < item[i].n_ranges; j++) {
          item[i].ranges[j].min = fbuf_get_uint(f);
          item[i].ranges[j].max = fbuf_get_uint(f);
       }
+   }
 
+   for (int i = 0; i < consecutive; i++) {
       loc_read(&(item[i].loc), loc_rd);
       if (item[i].flags & COVER_FLAGS_LHS_RHS_BINS) {
          loc_read(&(item[i].loc_lhs), loc_rd);
          loc_read(&(item[i].loc_rhs), loc_rd);
       }
+   }
 
+   for (int i = 0; i < consecutive; i++) {
       item[i].hier = ident_read(ident_ctx);
       if (item[i].kind == COV_ITEM_EXPRESSION ||
           item[i].kind == COV_ITEM_STATE ||
@@ -1221,10 +1267,20 @@ static void cover_merge_scope(cover_data_t *db, cover_scope_t *dst_s,
 
    for (int i = 0; i < src_s->children.count; i++) {
       cover_scope_t *new_c = src_s->children.items[i];
+
+      // Try the same index first assuming the scopes are identical
+      if (i < dst_s->children.count) {
+         cover_scope_t *old_c = dst_s->children.items[i];
+         if (new_c->name == old_c->name) {
+            cover_merge_scope(db, old_c, new_c, mode);
+            continue;
+         }
+      }
+
       bool found = false;
       for (int j = 0; j < dst_s->children.count; j++) {
          cover_scope_t *old_c = dst_s->children.items[j];
-         if (new_c->name == old_c->name) {
+         if (j != i && new_c->name == old_c->name) {
             cover_merge_scope(db, old_c, new_c, mode);
             found = true;
             break;
@@ -1242,6 +1298,12 @@ static void cover_merge_scope(cover_data_t *db, cover_scope_t *dst_s,
 
 void cover_merge(cover_data_t *dst, const cover_data_t *src, merge_mode_t mode)
 {
+   if ((dst->mask ^ src->mask) & COVER_MASK_SAMPLED)
+      warnf("merging sampled coverage data with data from a full coverage "
+            "run, the merged counts are approximate");
+
+   dst->mask |= src->mask & COVER_MASK_SAMPLED;
+
    cover_merge_scope(dst, dst->root_scope, src->root_scope, mode);
 
    if (opt_get_int(OPT_COVER_VERBOSE))
@@ -54,6 +54,8 @@ struct _cover_data {
    cover_mask_t     mask;
    int              array_limit;
    int              threshold;
+   uint64_t         sample_window;
+   uint64_t         sample_period;
    cover_rpt_buf_t *rpt_buf;
    cover_spec_t    *spec;
    cover_ef_t      *ef;
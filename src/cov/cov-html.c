@@ -183,10 +183,32 @@ static inline void cover_print_char(FILE *f, char c)
    }
 }
 
+static void cover_print_text(FILE *f, const char *text, size_t len)
+{
+   // Write runs of characters which do not need escaping in one call
+   const char *run = text;
+   for (const char *p = text; p < text + len; p++) {
+      switch (*p) {
+      case '\n':
+      case ' ':
+      case '<':
+      case '>':
+      case '&':
+         fwrite(run, 1, p - run, f);
+         cover_print_char(f, *p);
+         run = p + 1;
+         break;
+      default:
+         break;
+      }
+   }
+
+   fwrite(run, 1, text + len - run, f);
+}
+
 static void cover_print_string(FILE *f, const char *s)
 {
-   while (*s != '\0')
-      cover_print_char(f, *s++);
+   cover_print_text(f, s, strlen(s));
 }
 
 static void cover_print_single_code_line(FILE *f, loc_t loc,
@@ -198,17 +220,22 @@ static void cover_print_single_code_line(FILE *f, loc_t loc,
       return;
 
    const size_t len = strlen(line->text);
-   for (int curr_char = 0; curr_char < len; curr_char++) {
+   const size_t first = loc.first_column;
+   const size_t last = first + loc.column_delta;
+   const size_t start = MIN(first, len);
+   const size_t end = MIN(last + 1, len);
 
-      // Highlight code location
-      if (curr_char == loc.first_column)
-         fprintf(f, "<code class=\"cbg\">");
+   cover_print_text(f, line->text, start);
 
-      cover_print_char(f, line->text[curr_char]);
+   if (start < len) {
+      // Highlight code location
+      fprintf(f, "<code class=\"cbg\">");
+      cover_print_text(f, line->text + start, end - start);
 
-      // Finish code highlight
-      if (curr_char == (loc.first_column + loc.column_delta))
+      if (last < len)
          fprintf(f, "</code>");
+
+      cover_print_text(f, line->text + end, len - end);
    }
 }
 
@@ -415,11 +442,7 @@ static void cover_print_code_loc(FILE *f, const cover_item_t *item,
          else
             fprintf(f, "%zu:", loc.first_line + (curr_line - line));
 
-         int curr_char = 0;
-         while (curr_char < curr_line->len) {
-            cover_print_char(f, curr_line->text[curr_char]);
-            curr_char++;
-         }
+         cover_print_text(f, curr_line->text, curr_line->len);
 
          if (curr_line < last_line)
             fprintf(f, "<br>");
@@ -1258,8 +1281,7 @@ static void cover_file_page_cb(const rpt_file_t *f, void *ctx)
    fprintf(fp, "<pre><code>");
    for (int i = 0; i < f->n_lines; i++) {
       fprintf(fp, "%6d: &nbsp; ", i);
-      for (const char *p = f->lines[i].text; *p; p++)
-         cover_print_char(fp, *p);
+      cover_print_string(fp, f->lines[i].text);
       fprintf(fp, "\n");
    }
    fprintf(fp, "</code></pre>");
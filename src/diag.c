@@ -99,6 +99,21 @@ typedef struct _hint_rec {
    void           *context;
 } hint_rec_t;
 
+typedef struct {
+   uint32_t size;
+   uint32_t to_stderr;
+} async_record_t;
+
+typedef struct {
+   char         *buf;
+   size_t        capacity;
+   uint64_t      head;
+   uint64_t      tail;
+   bool          stop;
+   int           sleeping;
+   nvc_thread_t *thread;
+} async_ring_t;
+
 static unsigned    n_diags[DIAG_FATAL + 1];
 static unsigned    error_limit = 0;
 static file_list_t loc_files;
@@ -106,6 +121,8 @@ static nvc_lock_t  diag_lock   = 0;
 
 static __thread diag_consumer_t  consumer_fn = NULL;
 static __thread void            *consumer_ctx = NULL;
+static __thread diag_t          *spare_diag = NULL;
+static async_ring_t             *async_ring = NULL;
 
 #define MAX_HINT_RECS 4
 static __thread hint_rec_t hint_recs[MAX_HINT_RECS];
@@ -501,8 +518,16 @@ static void diag_set_ostream(diag_t *d)
 
 diag_t *diag_new(diag_level_t level, const loc_t *loc)
 {
-   diag_t *d = xcalloc(sizeof(diag_t));
-   d->msg      = tb_new();
+   // Reuse the last diagnostic emitted on this thread to avoid
+   // allocating for every report statement in chatty testbenches
+   diag_t *d = spare_diag;
+   if (d != NULL)
+      spare_diag = NULL;
+   else {
+      d = xcalloc(sizeof(diag_t));
+      d->msg = tb_new();
+   }
+
    d->level    = level;
    d->source   = loc != NULL && !loc_invalid_p(loc);
    d->suppress = false;
@@ -1055,6 +1080,189 @@ static void diag_format_full(diag_t *d, ostream_t *os)
 #endif
 }
 
+static void async_backoff(int *spins)
+{
+   if (++(*spins) < 64)
+      spin_wait();
+   else
+      thread_sleep(10);
+}
+
+static void async_notify(async_ring_t *r)
+{
+   // Wake the writer thread if it is blocked waiting for new records
+   full_barrier();
+   if (relaxed_load(&r->sleeping)) {
+      store_release(&r->sleeping, 0);
+      thread_wake(&r->sleeping);
+   }
+}
+
+static void *async_writer_thread(void *arg)
+{
+   async_ring_t *r = arg;
+
+   uint64_t tail = r->tail;
+   for (int spins = 0;;) {
+      const uint64_t head = load_acquire(&r->head);
+      if (head == tail) {
+         if (load_acquire(&r->stop) && load_acquire(&r->head) == tail)
+            break;
+         else if (++spins < 64) {
+            spin_wait();
+            continue;
+         }
+
+         // Block rather than poll until a producer publishes a record or
+         // the ring is stopped
+         store_release(&r->sleeping, 1);
+         full_barrier();
+         if (load_acquire(&r->head) == tail && !load_acquire(&r->stop))
+            thread_wait(&r->sleeping, 1);
+         store_release(&r->sleeping, 0);
+
+         spins = 0;
+         continue;
+      }
+
+      for (spins = 0; tail != head; ) {
+         const size_t off = tail % r->capacity;
+         const async_record_t *rec = (async_record_t *)(r->buf + off);
+
+         if (r->capacity - off < sizeof(async_record_t) || rec->size == 0)
+            tail += r->capacity - off;   // Padding at the end of the buffer
+         else {
+            if (rec->to_stderr) {
+               fflush(stdout);   // Same ordering as diag_emit
+               fwrite(rec + 1, rec->size, 1, stderr);
+            }
+            else
+               fwrite(rec + 1, rec->size, 1, stdout);
+
+            tail += ALIGN_UP(sizeof(async_record_t) + rec->size, 8);
+         }
+      }
+
+      // Only flush once the buffer has been drained so a burst of
+      // messages is written with as few system calls as possible
+      fflush(stdout);
+      store_release(&r->tail, tail);
+   }
+
+   return NULL;
+}
+
+static void diag_async_push(diag_t *d)
+{
+   static __thread text_buf_t *tb = NULL;
+
+   if (tb == NULL)
+      tb = tb_new();
+   else
+      tb_rewind(tb);
+
+   ostream_t os = {
+      tb_ostream_write, tb, d->ostream->charset, d->ostream->flags
+   };
+   FILE *f = d->ostream->context;
+
+   SCOPED_LOCK(diag_lock);
+
+   if (get_message_style() == MESSAGE_COMPACT)
+      diag_format_compact(d, &os);
+   else
+      diag_format_full(d, &os);
+
+   async_ring_t *r = async_ring;
+
+   const size_t size = tb_len(tb);
+   const size_t need = ALIGN_UP(sizeof(async_record_t) + size, 8);
+
+   if (size == 0)
+      return;
+   else if (need > r->capacity) {
+      // Too large to ever fit in the buffer: wait for the writer thread
+      // to become idle and then write the message directly
+      for (int spins = 0; load_acquire(&r->tail) != r->head; )
+         async_backoff(&spins);
+
+      fflush(stdout);
+      fwrite(tb_get(tb), size, 1, f);
+      fflush(f);
+      return;
+   }
+
+   uint64_t head = r->head;
+
+   // Apply back-pressure when the writer thread falls behind
+   const size_t off = head % r->capacity;
+   if (r->capacity - off < need) {
+      // Records never wrap around so pad to the start of the buffer
+      for (int spins = 0; head - load_acquire(&r->tail) > off; )
+         async_backoff(&spins);
+
+      if (r->capacity - off >= sizeof(async_record_t))
+         ((async_record_t *)(r->buf + off))->size = 0;
+
+      head += r->capacity - off;
+      store_release(&r->head, head);
+      async_notify(r);
+   }
+
+   const uint64_t end = head + need;
+   for (int spins = 0; end - load_acquire(&r->tail) > r->capacity; )
+      async_backoff(&spins);
+
+   async_record_t *rec = (async_record_t *)(r->buf + head % r->capacity);
+   rec->size      = size;
+   rec->to_stderr = (f == stderr);
+   memcpy(rec + 1, tb_get(tb), size);
+
+   store_release(&r->head, end);
+   async_notify(r);
+}
+
+void diag_async_start(size_t capacity)
+{
+   assert(async_ring == NULL);
+
+   async_ring_t *r = xcalloc(sizeof(async_ring_t));
+   r->capacity = ALIGN_UP(capacity, 8);
+   r->buf      = xmalloc(r->capacity);
+   r->thread   = thread_create(async_writer_thread, r, "diag writer");
+
+   async_ring = r;
+}
+
+void diag_async_flush(void)
+{
+   async_ring_t *r = async_ring;
+   if (r == NULL)
+      return;
+
+   // The writer thread flushes stdout before updating the tail
+   for (int spins = 0; load_acquire(&r->tail) != load_acquire(&r->head); )
+      async_backoff(&spins);
+}
+
+void diag_async_stop(void)
+{
+   async_ring_t *r = async_ring;
+   if (r == NULL)
+      return;
+
+   store_release(&r->stop, true);
+   async_notify(r);
+   thread_join(r->thread);
+
+   assert(r->head == r->tail);
+
+   async_ring = NULL;
+
+   free(r->buf);
+   free(r);
+}
+
 void diag_emit(diag_t *d)
 {
    if (d->suppress)
@@ -1065,21 +1273,35 @@ void diag_emit(diag_t *d)
             && diag_has_message(d))
       goto cleanup;
    else {
-      // The stderr and stdout streams are often redirected to the same
-      // file so ensure that the output appears in a logical order
-      fflush(stderr);
-      fflush(stdout);
-
       diag_set_ostream(d);  // Level may have changed
 
-      SCOPED_LOCK(diag_lock);
+      if (async_ring != NULL && d->level < DIAG_FATAL)
+         diag_async_push(d);
+      else {
+         // Fatal errors are written synchronously as the process is
+         // about to exit but must appear after any queued messages
+         diag_async_flush();
 
-      if (get_message_style() == MESSAGE_COMPACT)
-         diag_format_compact(d, d->ostream);
-      else
-         diag_format_full(d, d->ostream);
+         // The stderr and stdout streams are often redirected to the
+         // same file so ensure that the output appears in a logical
+         // order
+         fflush(stderr);
+         fflush(stdout);
 
-      fflush(d->ostream->context);
+         SCOPED_LOCK(diag_lock);
+
+         if (get_message_style() == MESSAGE_COMPACT)
+            diag_format_compact(d, d->ostream);
+         else
+            diag_format_full(d, d->ostream);
+
+         // Output to a pipe or file is left in the stdio buffer so that
+         // many reports can be written with a single system call: the
+         // stdout buffer is always flushed above before writing to
+         // stderr
+         if (d->ostream != nvc_stdout() || (d->ostream->flags & OS_TERMINAL))
+            fflush(d->ostream->context);
+      }
    }
 
    const unsigned count = relaxed_add(&n_diags[d->level], 1);
@@ -1090,14 +1312,22 @@ void diag_emit(diag_t *d)
  cleanup:
    for (int i = 0; i < d->hints.count; i++)
       free(d->hints.items[i].text);
-   ACLEAR(d->hints);
 
    for (int i = 0; i < d->trace.count; i++)
       free(d->trace.items[i].text);
-   ACLEAR(d->trace);
 
-   tb_free(d->msg);
-   free(d);
+   if (spare_diag == NULL) {
+      ATRIM(d->hints, 0);
+      ATRIM(d->trace, 0);
+      tb_rewind(d->msg);
+      spare_diag = d;
+   }
+   else {
+      ACLEAR(d->hints);
+      ACLEAR(d->trace);
+      tb_free(d->msg);
+      free(d);
+   }
 }
 
 void diag_show_source(diag_t *d, bool show)
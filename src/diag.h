@@ -88,6 +88,10 @@ typedef void (*diag_hint_fn_t)(diag_t *, void *);
 void diag_add_hint_fn(diag_hint_fn_t fn, void *context);
 void diag_remove_hint_fn(diag_hint_fn_t fn, void *context);
 
+void diag_async_start(size_t capacity);
+void diag_async_flush(void);
+void diag_async_stop(void);
+
 diag_t *diag_new(diag_level_t level, const loc_t *loc);
 void diag_printf(diag_t *d, const char *fmt, ...)
    __attribute__((format(printf, 2, 3)));
@@ -20,6 +20,7 @@
 #include "common.h"
 #include "cov/cov-api.h"
 #include "diag.h"
+#include "driver.h"
 #include "eval.h"
 #include "hash.h"
 #include "inst.h"
@@ -45,12 +46,31 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <string.h>
 
 #define MAX_DEPTH 127    // Limited by vcode type indexes
+#define STAMP_MAGIC 0x73746d70
 
 typedef A(tree_t) tree_list_t;
 
 typedef struct _elab_ctx elab_ctx_t;
+
+typedef struct {
+   ident_t  dotted;
+   unsigned collapse[COLLAPSE_NUM_REASONS];
+} port_stats_t;
+
+typedef A(port_stats_t) port_stats_list_t;
+
+typedef struct {
+   unsigned clocked;
+   unsigned comb;
+   unsigned feedback;
+   unsigned other;
+   unsigned maxdepth;
+} proc_stats_t;
+
+typedef A(unsigned) index_list_t;
 typedef struct _generic_list generic_list_t;
 
 typedef struct _elab_ctx {
@@ -73,6 +93,8 @@ typedef struct _elab_ctx {
    rt_scope_t       *scope;
    mem_pool_t       *pool;
    cover_scope_t    *cscope;
+   port_stats_list_t *portstats;
+   proc_stats_t     *procstats;
    unsigned          depth;
    unsigned          errors;
 } elab_ctx_t;
@@ -1432,6 +1454,8 @@ static void elab_inherit_context(elab_ctx_t *ctx, const elab_ctx_t *parent)
    ctx->errors   = error_count();
    ctx->pool     = parent->pool;
    ctx->cscope   = parent->cscope;
+   ctx->portstats = parent->portstats;
+   ctx->procstats = parent->procstats;
 }
 
 static bool elab_new_errors(const elab_ctx_t *ctx)
@@ -1439,6 +1463,126 @@ static bool elab_new_errors(const elab_ctx_t *ctx)
    return error_count() - ctx->errors;
 }
 
+static bool elab_is_clocked_process(tree_t proc, bool is_static)
+{
+   const int nstmts = tree_stmts(proc);
+   for (int i = 0; i < nstmts; i++) {
+      tree_t s = tree_stmt(proc, i);
+      switch (tree_kind(s)) {
+      case T_IF:
+         if (is_static) {
+            const int nconds = tree_conds(s);
+            for (int j = 0; j < nconds; j++) {
+               tree_t c = tree_cond(s, j);
+               if (tree_has_value(c) && has_clock_edge(tree_value(c)))
+                  return true;
+            }
+         }
+         break;
+      case T_WAIT:
+         if (tree_has_value(s) && has_clock_edge(tree_value(s)))
+            return true;
+         break;
+      default:
+         break;
+      }
+   }
+
+   return false;
+}
+
+static void elab_process_stats(tree_t b, proc_stats_t *ps)
+{
+   // Classify the processes in this block as clocked or combinational
+   // and sort the combinational processes into levels where each
+   // process only depends on the outputs of lower levels
+   tree_list_t comb = AINIT;
+   hash_t *index = hash_new(16);
+
+   const int nstmts = tree_stmts(b);
+   for (int i = 0; i < nstmts; i++) {
+      tree_t s = tree_stmt(b, i);
+      if (tree_kind(s) != T_PROCESS)
+         continue;
+
+      const int nsub = tree_stmts(s);
+      tree_t last = nsub > 0 ? tree_stmt(s, nsub - 1) : NULL;
+      const bool is_static = last != NULL && tree_kind(last) == T_WAIT
+         && (tree_flags(last) & TREE_F_STATIC_WAIT);
+
+      if (elab_is_clocked_process(s, is_static))
+         ps->clocked++;
+      else if (is_static) {
+         APUSH(comb, s);
+         hash_put(index, s, (void *)(uintptr_t)comb.count);
+      }
+      else
+         ps->other++;
+   }
+
+   const int ncomb = comb.count;
+   ps->comb += ncomb;
+
+   if (ncomb > 0) {
+      driver_set_t *ds = find_drivers(b);
+
+      index_list_t *succs LOCAL = xcalloc_array(ncomb, sizeof(index_list_t));
+      unsigned *indegree LOCAL = xcalloc_array(ncomb, sizeof(unsigned));
+      unsigned *level LOCAL = xcalloc_array(ncomb, sizeof(unsigned));
+
+      for (int i = 0; i < ncomb; i++) {
+         tree_t proc = comb.items[i];
+         tree_t wait = tree_stmt(proc, tree_stmts(proc) - 1);
+
+         const int ntriggers = tree_triggers(wait);
+         for (int j = 0; j < ntriggers; j++) {
+            tree_t ref = name_to_ref(tree_trigger(wait, j));
+            if (ref == NULL || !tree_has_ref(ref))
+               continue;
+
+            driver_info_t *di = get_drivers(ds, tree_ref(ref));
+            for (; di; di = di->chain_decl) {
+               const uintptr_t from = (uintptr_t)hash_get(index, di->where);
+               if (from > 0) {
+                  APUSH(succs[from - 1], i);
+                  indegree[i]++;
+               }
+            }
+         }
+      }
+
+      index_list_t queue = AINIT;
+      for (int i = 0; i < ncomb; i++) {
+         if (indegree[i] == 0)
+            APUSH(queue, i);
+      }
+
+      for (int i = 0; i < queue.count; i++) {
+         const unsigned from = queue.items[i];
+         ps->maxdepth = MAX(ps->maxdepth, level[from] + 1);
+
+         for (int j = 0; j < succs[from].count; j++) {
+            const unsigned to = succs[from].items[j];
+            level[to] = MAX(level[to], level[from] + 1);
+            if (--indegree[to] == 0)
+               APUSH(queue, to);
+         }
+      }
+
+      // Anything not reached is part of or depends on a feedback loop
+      ps->feedback += ncomb - queue.count;
+
+      for (int i = 0; i < ncomb; i++)
+         ACLEAR(succs[i]);
+
+      ACLEAR(queue);
+      free_drivers(ds);
+   }
+
+   ACLEAR(comb);
+   hash_free(index);
+}
+
 static void elab_lower(tree_t b, elab_ctx_t *ctx)
 {
    tree_t hier = tree_decl(b, 0);
@@ -1450,6 +1594,15 @@ static void elab_lower(tree_t b, elab_ctx_t *ctx)
       ctx->lowered = lower_instance(ctx->registry, ctx->parent->lowered,
                                     ctx->cover, ctx->cscope, b);
 
+      if (ctx->portstats != NULL && tree_params(b) > 0) {
+         port_stats_t ps = { .dotted = ctx->dotted };
+         memcpy(ps.collapse, ctx->lowered->collapse, sizeof(ps.collapse));
+         APUSH(*ctx->portstats, ps);
+      }
+
+      if (ctx->procstats != NULL)
+         elab_process_stats(b, ctx->procstats);
+
 #ifdef DEBUG
       if (ctx->cloned != NULL) {
          // Cloned blocks must have identical layout
@@ -2135,6 +2288,7 @@ static void elab_architecture(tree_t inst, tree_t arch, const elab_ctx_t *ctx)
       ei->cscope = new_ctx.cscope;
 
       elab_fold_generics(ei->block, &new_ctx);
+      model_plan_splits(ctx->model, ei->block);
 
       elab_context(arch);
       elab_context(tree_primary(arch));
@@ -2199,6 +2353,7 @@ static void elab_configuration(tree_t inst, tree_t unit, const elab_ctx_t *ctx)
 
       elab_bind_components(ei->block, ei->block);
       elab_fold_generics(ei->block, &new_ctx);
+      model_plan_splits(ctx->model, ei->block);
 
       elab_context(arch);
       elab_context(tree_primary(arch));
@@ -2861,6 +3016,58 @@ static void elab_print_stats(const elab_ctx_t *ctx)
    printf("\n");
 }
 
+static void elab_print_port_stats(const port_stats_list_t *list)
+{
+   unsigned total[COLLAPSE_NUM_REASONS] = {};
+
+   nvc_printf("$bold$%-50s %10s %10s$$\n", "Instance", "Collapsed",
+              "Retained");
+
+   for (int i = 0; i < list->count; i++) {
+      const port_stats_t *ps = &(list->items[i]);
+
+      unsigned retained = 0;
+      for (int j = COLLAPSE_DONE + 1; j < COLLAPSE_NUM_REASONS; j++)
+         retained += ps->collapse[j];
+
+      printf("%-50s %10u %10u", istr(ps->dotted),
+             ps->collapse[COLLAPSE_DONE], retained);
+
+      const char *sep = "  ";
+      for (int j = COLLAPSE_DONE + 1; j < COLLAPSE_NUM_REASONS; j++) {
+         if (ps->collapse[j] > 0) {
+            printf("%s%s: %u", sep, collapse_reason_str(j), ps->collapse[j]);
+            sep = ", ";
+         }
+      }
+
+      printf("\n");
+
+      for (int j = 0; j < COLLAPSE_NUM_REASONS; j++)
+         total[j] += ps->collapse[j];
+   }
+
+   nvc_printf("\n$bold$%-50s %10s$$\n", "Port associations", "Total");
+
+   for (int j = 0; j < COLLAPSE_NUM_REASONS; j++) {
+      if (total[j] > 0 || j == COLLAPSE_DONE)
+         printf("%-50s %10u\n", collapse_reason_str(j), total[j]);
+   }
+
+   printf("\n");
+}
+
+static void elab_print_process_stats(const proc_stats_t *ps)
+{
+   nvc_printf("$bold$%-50s %10s$$\n", "Processes", "Total");
+   printf("%-50s %10u\n", "clocked", ps->clocked);
+   printf("%-50s %10u\n", "combinational", ps->comb);
+   printf("%-50s %10u\n", "combinational in feedback loop", ps->feedback);
+   printf("%-50s %10u\n", "other", ps->other);
+   printf("%-50s %10u\n", "maximum combinational depth", ps->maxdepth);
+   printf("\n");
+}
+
 tree_t elab(object_t *top, jit_t *jit, unit_registry_t *ur, mir_context_t *mc,
             cover_data_t *cover, sdf_file_t *sdf, rt_model_t *m)
 {
@@ -2902,13 +3109,24 @@ tree_t elab(object_t *top, jit_t *jit, unit_registry_t *ur, mir_context_t *mc,
       .pool      = pool_new(),
    };
 
+   port_stats_list_t portstats = AINIT;
+   proc_stats_t procstats = {};
+   if (opt_get_int(OPT_ELAB_STATS)) {
+      ctx.portstats = &portstats;
+      ctx.procstats = &procstats;
+   }
+
    if (vhdl != NULL)
       call_with_model(m, elab_vhdl_root_cb, &ctx);
    else
       call_with_model(m, elab_verilog_root_cb, &ctx);
 
-   if (opt_get_int(OPT_ELAB_STATS))
+   if (opt_get_int(OPT_ELAB_STATS)) {
       elab_print_stats(&ctx);
+      elab_print_port_stats(&portstats);
+      elab_print_process_stats(&procstats);
+      ACLEAR(portstats);
+   }
 
    const void *key;
    void *value;
@@ -2936,3 +3154,100 @@ tree_t elab(object_t *top, jit_t *jit, unit_registry_t *ur, mir_context_t *mc,
    freeze_global_arena();
    return e;
 }
+
+typedef struct {
+   timestamp_t mtime;
+   bool        stale;
+} elab_stamp_check_t;
+
+static void elab_stamp_index_cb(lib_t lib, ident_t name, int kind, void *ctx)
+{
+   elab_stamp_check_t *check = ctx;
+
+   if (kind != T_ELAB && lib_get_mtime(lib, name) > check->mtime)
+      check->stale = true;
+}
+
+static bool elab_stamp_lib_cb(lib_t lib, void *ctx)
+{
+   A(lib_t) *libs = ctx;
+   if (lib_path(lib) != NULL)
+      APUSH(*libs, lib);
+   return true;
+}
+
+static void elab_stamp_name(ident_t top, text_buf_t *tb)
+{
+   tb_printf(tb, "_%s.%s.stamp", istr(top), istr(well_known(W_ELAB)));
+}
+
+bool elab_is_current(lib_t work, ident_t top, uint64_t key)
+{
+   // The elaborated design can be reused if it was produced with the
+   // same options and no unit in any library it was elaborated against
+   // has been analysed since
+
+   LOCAL_TEXT_BUF tb = tb_new();
+   elab_stamp_name(top, tb);
+
+   fbuf_t *f = lib_fbuf_open(work, tb_get(tb), FBUF_IN, FBUF_CS_NONE);
+   if (f == NULL)
+      return false;
+
+   ident_t ename = ident_prefix(top, well_known(W_ELAB), '.');
+   elab_stamp_check_t check = {
+      .mtime = lib_get_mtime(work, ename),
+      .stale = false,
+   };
+
+   if (read_u32(f) != STAMP_MAGIC || read_u64(f) != key || check.mtime == 0)
+      check.stale = true;
+
+   ident_rd_ctx_t ictx = ident_read_begin(f);
+
+   const int nlibs = check.stale ? 0 : read_u32(f);
+   for (int i = 0; i < nlibs && !check.stale; i++) {
+      ident_t name = ident_read(ictx);
+      ident_t path = ident_read(ictx);
+
+      lib_t lib = lib_find(name);
+      if (lib == NULL || ident_new(lib_path(lib)) != path)
+         check.stale = true;
+      else
+         lib_walk_index(lib, elab_stamp_index_cb, &check);
+   }
+
+   ident_read_end(ictx);
+   fbuf_close(f, NULL);
+
+   return !check.stale;
+}
+
+void elab_write_stamp(lib_t work, ident_t top, uint64_t key)
+{
+   LOCAL_TEXT_BUF tb = tb_new();
+   elab_stamp_name(top, tb);
+
+   fbuf_t *f = lib_fbuf_open(work, tb_get(tb), FBUF_OUT, FBUF_CS_NONE);
+   if (f == NULL)
+      fatal_errno("failed to create %s", tb_get(tb));
+
+   A(lib_t) libs = AINIT;
+   lib_for_all(elab_stamp_lib_cb, &libs);
+
+   write_u32(STAMP_MAGIC, f);
+   write_u64(key, f);
+
+   ident_wr_ctx_t ictx = ident_write_begin(f);
+
+   write_u32(libs.count, f);
+   for (int i = 0; i < libs.count; i++) {
+      ident_write(lib_name(libs.items[i]), ictx);
+      ident_write(ident_new(lib_path(libs.items[i])), ictx);
+   }
+
+   ident_write_end(ictx);
+   fbuf_close(f, NULL);
+
+   ACLEAR(libs);
+}
@@ -218,9 +218,152 @@ static void *thunk_result_cb(jit_scalar_t *args, void *user)
       return eval_value_to_tree(args[0], tree_type(expr), tree_loc(expr));
 }
 
+#define MEMO_MAX_ARGS 8
+
+typedef struct {
+   ident_t  name;
+   tree_t   decl;
+   int      nargs;
+   int64_t  args[MEMO_MAX_ARGS];
+} memo_key_t;
+
+typedef struct {
+   tree_t       expr;
+   jit_scalar_t value;
+} memo_result_t;
+
+static ghash_t    *memo_hash = NULL;
+static mem_pool_t *memo_pool = NULL;
+
+static uint32_t memo_hash_key(const void *key)
+{
+   const memo_key_t *k = key;
+   uint64_t h = (uintptr_t)k->name;
+   for (int i = 0; i < k->nargs; i++)
+      h = mix_bits_64(h ^ k->args[i]);
+   return h;
+}
+
+static bool memo_cmp_key(const void *a, const void *b)
+{
+   const memo_key_t *ka = a, *kb = b;
+   return ka->name == kb->name && ka->decl == kb->decl
+      && ka->nargs == kb->nargs
+      && memcmp(ka->args, kb->args, ka->nargs * sizeof(int64_t)) == 0;
+}
+
+static bool memo_make_key(tree_t expr, memo_key_t *key)
+{
+   // Calls to pure package functions whose arguments are all scalar
+   // literals always produce the same result so can be memoised
+   if (tree_kind(expr) != T_FCALL || !type_is_scalar(tree_type(expr)))
+      return false;
+
+   tree_t decl = tree_ref(expr);
+   switch (tree_kind(decl)) {
+   case T_FUNC_DECL:
+   case T_FUNC_BODY:
+   case T_FUNC_INST:
+      break;
+   default:
+      return false;
+   }
+
+   if (tree_subkind(decl) != S_USER || (tree_flags(decl) & TREE_F_IMPURE))
+      return false;
+
+   const int nparams = tree_params(expr);
+   if (nparams > MEMO_MAX_ARGS)
+      return false;
+
+   for (int i = 0; i < nparams; i++) {
+      tree_t p = tree_param(expr, i);
+      if (tree_subkind(p) != P_POS)
+         return false;
+
+      tree_t value = tree_value(p);
+      switch (tree_kind(value)) {
+      case T_LITERAL:
+         switch (tree_subkind(value)) {
+         case L_INT:
+         case L_PHYSICAL:
+            key->args[i] = tree_ival(value);
+            break;
+         case L_REAL:
+            {
+               const double dval = tree_dval(value);
+               memcpy(&(key->args[i]), &dval, sizeof(double));
+            }
+            break;
+         default:
+            return false;
+         }
+         break;
+      case T_REF:
+         {
+            tree_t lit = tree_ref(value);
+            if (tree_kind(lit) != T_ENUM_LIT)
+               return false;
+
+            key->args[i] = tree_pos(lit);
+         }
+         break;
+      default:
+         return false;
+      }
+   }
+
+   key->name = tree_ident2(decl);
+   key->decl = decl;
+   key->nargs = nparams;
+   return true;
+}
+
+static void *memo_result_cb(jit_scalar_t *args, void *user)
+{
+   memo_result_t *mr = user;
+   mr->value = args[0];
+   return thunk_result_cb(args, mr->expr);
+}
+
+static tree_t eval_memo_fold(jit_t *jit, vcode_unit_t thunk, tree_t expr,
+                             const memo_key_t *key)
+{
+   memo_result_t mr = { .expr = expr };
+   tree_t result = jit_call_thunk(jit, thunk, NULL, memo_result_cb, &mr);
+   if (result == NULL)
+      return NULL;   // Errors are not cached so they are reported each time
+
+   if (memo_hash == NULL) {
+      memo_hash = ghash_new(128, memo_hash_key, memo_cmp_key);
+      memo_pool = pool_new();
+   }
+
+   memo_key_t *copy = pool_malloc(memo_pool, sizeof(memo_key_t));
+   *copy = *key;
+
+   jit_scalar_t *value = pool_malloc(memo_pool, sizeof(jit_scalar_t));
+   *value = mr.value;
+
+   ghash_put(memo_hash, copy, value);
+   return result;
+}
+
 static tree_t eval_do_fold(jit_t *jit, tree_t expr, lower_unit_t *parent,
                            unit_registry_t *registry, void *context)
 {
+   // Only global thunks are memoised as the result of a thunk lowered
+   // in context may depend on the values of local constants
+   memo_key_t key;
+   const bool memo = parent == NULL && context == NULL
+      && memo_make_key(expr, &key);
+
+   if (memo && memo_hash != NULL) {
+      const jit_scalar_t *cached = ghash_get(memo_hash, &key);
+      if (cached != NULL)
+         return eval_value_to_tree(*cached, tree_type(expr), tree_loc(expr));
+   }
+
    vcode_unit_t thunk;
    if (parent != NULL)
       thunk = lower_thunk_in_context(registry, expr, parent);
@@ -232,7 +375,11 @@ static tree_t eval_do_fold(jit_t *jit, tree_t expr, lower_unit_t *parent,
 
    const bool verbose = opt_get_verbose(OPT_EVAL_VERBOSE, NULL);
 
-   tree_t result = jit_call_thunk(jit, thunk, context, thunk_result_cb, expr);
+   tree_t result;
+   if (memo)
+      result = eval_memo_fold(jit, thunk, expr, &key);
+   else
+      result = jit_call_thunk(jit, thunk, context, thunk_result_cb, expr);
 
    vcode_unit_unref(thunk);
    thunk = NULL;
@@ -18,6 +18,8 @@
 #include "util.h"
 #include "fbuf.h"
 #include "fastlz.h"
+#include "option.h"
+#include "thread.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -38,6 +40,15 @@
 
 #define FBUF_HEADER_SZ 20
 
+#define ZSTD_MT_THRESHOLD (4 * 1024 * 1024)
+#define ZSTD_MAX_WORKERS  4
+
+#ifndef __MINGW32__
+// Output is written to a temporary file which replaces the target when
+// closed so concurrent readers never observe a partially written file
+#define ATOMIC_REPLACE 1
+#endif
+
 #if DEBUG
 #define ASSERT_AVAIL(f, n) do {                                 \
       if (unlikely((f)->rptr + (n) > (f)->origsz))              \
@@ -69,11 +80,14 @@ typedef struct {
 struct _fbuf {
    fbuf_mode_t  mode;
    char        *fname;
+   char        *tmpname;
    FILE        *file;
    uint8_t     *wbuf;
    size_t       wpend;
    size_t       wtotal;
    uint8_t     *rbuf;
+   uint8_t     *rmap;
+   size_t       rmapsz;
    size_t       rptr;
    size_t       origsz;
    fbuf_t      *next;
@@ -83,9 +97,11 @@ struct _fbuf {
    ZSTD_CCtx   *zstd;
    uint8_t     *zbuf;
    size_t       zbufsz;
+   bool         zstd_mt;
 };
 
 static fbuf_t *open_list = NULL;
+static nvc_lock_t open_lock = 0;
 
 #define ADLER_MOD               65521
 #define ADLER_CHUNK_LEN_32      5552
@@ -268,7 +284,7 @@ void fbuf_cleanup(void)
    for (fbuf_t *it = open_list; it != NULL; it = it->next) {
       fclose(it->file);
       if (it->mode == FBUF_OUT)
-         remove(it->fname);
+         remove(it->tmpname ?: it->fname);
    }
 }
 
@@ -403,19 +419,30 @@ static void fbuf_decompress(fbuf_t *f)
 
    f->origsz = len;
    f->checksum.expect = checksum;
-   f->rbuf = xmalloc(f->origsz);
 
    uint8_t *payload = rmap + header_sz + userheader;
    const size_t payloadsz = filesz - header_sz - userheader;
 
+   if (header[4] == FBUF_ZIP_NONE) {
+      if (payloadsz < f->origsz)
+         fatal("%s has inconsistent uncompressed size %u vs payload size %zu",
+               f->fname, len, payloadsz);
+
+      // Read directly from the mapping rather than copying the
+      // contents into a separate buffer
+      checksum_update(&(f->checksum), payload, f->origsz);
+      f->rbuf   = payload;
+      f->rmap   = rmap;
+      f->rmapsz = filesz;
+      return;
+   }
+
+   f->rbuf = xmalloc(f->origsz);
+
    switch (header[4]) {
    case FBUF_ZIP_FASTLZ:
       fbuf_decompress_fastlz(f, payload, payloadsz);
       break;
-   case FBUF_ZIP_NONE:
-      memcpy(f->rbuf, payload, f->origsz);
-      checksum_update(&(f->checksum), f->rbuf, f->origsz);
-      break;
    case FBUF_ZIP_ZSTD:
       fbuf_decompress_zstd(f, payload, payloadsz);
       break;
@@ -429,16 +456,33 @@ static void fbuf_decompress(fbuf_t *f)
 
 fbuf_t *fbuf_open(const char *file, fbuf_mode_t mode, fbuf_cs_t csum)
 {
-   FILE *h = fopen(file, mode == FBUF_OUT ? "wb" : "rb");
-   if (h == NULL)
+   return fbuf_open_zip(file, mode, csum, DEFAULT_ZIP);
+}
+
+fbuf_t *fbuf_open_zip(const char *file, fbuf_mode_t mode, fbuf_cs_t csum,
+                      fbuf_zip_t zip)
+{
+   char *tmpname = NULL;
+#if ATOMIC_REPLACE
+   if (mode == FBUF_OUT) {
+      static int counter = 0;
+      tmpname = xasprintf("%s.%d.%d.tmp", file, getpid(),
+                          atomic_add(&counter, 1));
+   }
+#endif
+
+   FILE *h = fopen(tmpname ?: file, mode == FBUF_OUT ? "wb" : "rb");
+   if (h == NULL) {
+      free(tmpname);
       return NULL;
+   }
 
    fbuf_t *f = xcalloc(sizeof(struct _fbuf));
-   f->file  = h;
-   f->fname = xstrdup(file);
-   f->mode  = mode;
-   f->next  = open_list;
-   f->zip   = DEFAULT_ZIP;
+   f->file    = h;
+   f->fname   = xstrdup(file);
+   f->tmpname = tmpname;
+   f->mode    = mode;
+   f->zip     = zip;
 
    checksum_init(&(f->checksum), csum);
 
@@ -446,7 +490,9 @@ fbuf_t *fbuf_open(const char *file, fbuf_mode_t mode, fbuf_cs_t csum)
       if ((f->zstd = ZSTD_createCCtx()) == NULL)
          fatal_trace("ZSTD_createCCtx() failed");
 
-      size_t rc = ZSTD_CCtx_setParameter(f->zstd, ZSTD_c_compressionLevel, 3);
+      const int level = opt_get_int(OPT_ZSTD_LEVEL);
+      size_t rc = ZSTD_CCtx_setParameter(f->zstd, ZSTD_c_compressionLevel,
+                                         level);
       if (ZSTD_isError(rc))
          fatal("failed to set ZSTD compression level: %s",
                ZSTD_getErrorName(rc));
@@ -462,10 +508,16 @@ fbuf_t *fbuf_open(const char *file, fbuf_mode_t mode, fbuf_cs_t csum)
    else
       fbuf_decompress(f);
 
-   if (open_list != NULL)
-      open_list->prev = f;
+   {
+      SCOPED_LOCK(open_lock);
 
-   return (open_list = f);
+      if ((f->next = open_list) != NULL)
+         open_list->prev = f;
+
+      open_list = f;
+   }
+
+   return f;
 }
 
 const char *fbuf_file_name(fbuf_t *f)
@@ -491,9 +543,28 @@ static void fbuf_compress_fastlz(fbuf_t *f)
    fbuf_write_raw(f, out, ret);
 }
 
+static void fbuf_enable_zstd_mt(fbuf_t *f)
+{
+   f->zstd_mt = true;
+
+   const int nworkers = MIN(nvc_nprocs() - 1, ZSTD_MAX_WORKERS);
+   if (nworkers < 1)
+      return;
+
+   // Fails if the library was built without multi-threading support in
+   // which case compression continues on the calling thread
+   (void)ZSTD_CCtx_setParameter(f->zstd, ZSTD_c_nbWorkers, nworkers);
+}
+
 static void fbuf_compress_zstd(fbuf_t *f, bool end)
 {
-   ZSTD_EndDirective mode = end ? ZSTD_e_end : ZSTD_e_continue;
+   // Once the output is large end the current frame so the remainder
+   // can be compressed by worker threads in a new frame: the reader
+   // decompresses concatenated frames in one call
+   const bool split =
+      !end && !f->zstd_mt && f->wtotal + f->wpend >= ZSTD_MT_THRESHOLD;
+
+   ZSTD_EndDirective mode = (end || split) ? ZSTD_e_end : ZSTD_e_continue;
    ZSTD_inBuffer input = { f->wbuf, f->wpend, 0 };
    bool finished;
    do {
@@ -505,10 +576,16 @@ static void fbuf_compress_zstd(fbuf_t *f, bool end)
       if (output.pos > 0)
          fbuf_write_raw(f, f->zbuf, output.pos);
 
-      finished = end ? (remaining == 0) : (input.pos == input.size);
+      if (mode == ZSTD_e_end)
+         finished = (remaining == 0);
+      else
+         finished = (input.pos == input.size);
    } while (!finished);
 
    assert(input.pos == input.size);
+
+   if (split)
+      fbuf_enable_zstd_mt(f);
 }
 
 static void fbuf_maybe_flush(fbuf_t *f, size_t more, bool end)
@@ -556,7 +633,9 @@ void fbuf_close(fbuf_t *f, uint32_t *checksum)
    if (checksum != NULL)
       *checksum = cs;
 
-   if (f->rbuf != NULL)
+   if (f->rmap != NULL)
+      unmap_file(f->rmap, f->rmapsz);
+   else if (f->rbuf != NULL)
       free(f->rbuf);
 
    if (f->wbuf != NULL) {
@@ -566,16 +645,23 @@ void fbuf_close(fbuf_t *f, uint32_t *checksum)
 
    fclose(f->file);
 
-   if (f->prev == NULL) {
-      assert(f == open_list);
-      if (f->next != NULL)
-         f->next->prev = NULL;
-      open_list = f->next;
-   }
-   else {
-      f->prev->next = f->next;
-      if (f->next != NULL)
-         f->next->prev = f->prev;
+   if (f->tmpname != NULL && rename(f->tmpname, f->fname) != 0)
+      fatal_errno("rename: %s", f->fname);
+
+   {
+      SCOPED_LOCK(open_lock);
+
+      if (f->prev == NULL) {
+         assert(f == open_list);
+         if (f->next != NULL)
+            f->next->prev = NULL;
+         open_list = f->next;
+      }
+      else {
+         f->prev->next = f->next;
+         if (f->next != NULL)
+            f->next->prev = f->prev;
+      }
    }
 
    if (checksum != NULL)
@@ -586,6 +672,7 @@ void fbuf_close(fbuf_t *f, uint32_t *checksum)
 
    free(f->zbuf);
 
+   free(f->tmpname);
    free(f->fname);
    free(f);
 }
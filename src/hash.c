@@ -16,24 +16,203 @@
 //
 
 #include "hash.h"
+#include "stats.h"
 #include "thread.h"
 
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 
+#ifdef ARCH_X86_64
+#include <x86intrin.h>
+#endif
+
 #define HASH_MIN_SIZE 4
 
+////////////////////////////////////////////////////////////////////////////////
+// Open addressing with a byte of control data per slot
+//
+// The control bytes are probed a group of GROUP_WIDTH slots at a time
+// using SIMD comparisons where available.  Each full slot stores the
+// top seven bits of the hash so most mismatching keys are rejected
+// without touching the key array, which allows a much higher load
+// factor than plain linear probing.
+
+#define CTRL_EMPTY   0x80
+#define CTRL_DELETED 0xfe
+
+#ifdef ARCH_X86_64
+#define GROUP_WIDTH 16
+typedef __m128i group_t;
+typedef uint32_t group_mask_t;
+#else
+// Portable fallback treats eight control bytes as one 64-bit word
+#define GROUP_WIDTH 8
+#define GROUP_LSBS  UINT64_C(0x0101010101010101)
+#define GROUP_MSBS  UINT64_C(0x8080808080808080)
+typedef uint64_t group_t;
+typedef uint64_t group_mask_t;
+#endif
+
+typedef struct {
+   uint8_t  *ctrl;
+   unsigned  size;
+   unsigned  members;
+   unsigned  growth_left;
+} group_tab_t;
+
+static inline group_t group_load(const uint8_t *ctrl)
+{
+#ifdef ARCH_X86_64
+   return _mm_loadu_si128((const __m128i *)ctrl);
+#else
+   group_t group;
+   memcpy(&group, ctrl, sizeof(group_t));
+   return group;
+#endif
+}
+
+static inline group_mask_t group_match(group_t group, uint8_t h2)
+{
+#ifdef ARCH_X86_64
+   return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(h2)));
+#else
+   // May have false positives which are rejected by the key comparison
+   const uint64_t x = group ^ (GROUP_LSBS * h2);
+   return (x - GROUP_LSBS) & ~x & GROUP_MSBS;
+#endif
+}
+
+static inline group_mask_t group_match_free(group_t group)
+{
+   // Empty and deleted slots are the only ones with the top bit set
+#ifdef ARCH_X86_64
+   return _mm_movemask_epi8(group);
+#else
+   return group & GROUP_MSBS;
+#endif
+}
+
+static inline group_mask_t group_match_empty(group_t group)
+{
+#ifdef ARCH_X86_64
+   return group_match(group, CTRL_EMPTY);
+#else
+   return group & ~(group << 6) & GROUP_MSBS;
+#endif
+}
+
+static inline unsigned group_lowest(group_mask_t mask)
+{
+#ifdef ARCH_X86_64
+   return __builtin_ctz(mask);
+#else
+   return __builtin_ctzll(mask) / 8;
+#endif
+}
+
+static inline unsigned group_start(const group_tab_t *t, uint64_t hash)
+{
+   return (hash * GROUP_WIDTH) & (t->size - 1);
+}
+
+static inline unsigned group_next(const group_tab_t *t, unsigned pos,
+                                  unsigned *stride)
+{
+   // Triangular probing visits every group when the number of groups
+   // is a power of two
+   *stride += GROUP_WIDTH;
+   return (pos + *stride) & (t->size - 1);
+}
+
+static inline bool group_is_full(const group_tab_t *t, unsigned slot)
+{
+   return !(t->ctrl[slot] & 0x80);
+}
+
+static unsigned group_size_for(int size)
+{
+   return MAX(GROUP_WIDTH, next_power_of_2(size));
+}
+
+static char *group_tab_alloc(group_tab_t *t, unsigned size, size_t slotsz)
+{
+   // The slot array is placed before the control bytes in a single
+   // allocation which is returned to the caller
+   char *mem = xmalloc(size * (slotsz + 1));
+   t->ctrl        = (uint8_t *)(mem + size * slotsz);
+   t->size        = size;
+   t->members     = 0;
+   t->growth_left = size - size / 8;   // Maximum load factor of 7/8
+
+   memset(t->ctrl, CTRL_EMPTY, size);
+   return mem;
+}
+
+static unsigned group_grow_size(const group_tab_t *t)
+{
+   // Rebuild at the same size if most of the used slots are deleted
+   const unsigned max_load = t->size - t->size / 8;
+   return t->members < max_load / 2 ? t->size : t->size * 2;
+}
+
+static unsigned group_find_free(const group_tab_t *t, uint64_t hash)
+{
+   unsigned pos = group_start(t, hash), stride = 0;
+   for (;; pos = group_next(t, pos, &stride)) {
+      const group_mask_t free = group_match_free(group_load(t->ctrl + pos));
+      if (free != 0)
+         return pos + group_lowest(free);
+   }
+}
+
+static inline void group_set_full(group_tab_t *t, unsigned slot, uint8_t h2)
+{
+   assert(!group_is_full(t, slot));
+
+   if (t->ctrl[slot] == CTRL_EMPTY)
+      t->growth_left--;
+
+   t->ctrl[slot] = h2;
+   t->members++;
+}
+
+static void group_erase(group_tab_t *t, unsigned slot)
+{
+   assert(group_is_full(t, slot));
+
+   // A probe sequence that reaches a group with an empty slot stops
+   // there so the slot can be marked empty rather than deleted
+   const unsigned pos = slot & ~(GROUP_WIDTH - 1);
+   if (group_match_empty(group_load(t->ctrl + pos))) {
+      t->ctrl[slot] = CTRL_EMPTY;
+      t->growth_left++;
+   }
+   else
+      t->ctrl[slot] = CTRL_DELETED;
+
+   t->members--;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Hash table of pointers to pointers
 
+typedef struct {
+   const void *key;
+   void       *value;
+} hash_slot_t;
+
 struct _hash {
-   unsigned     size;
-   unsigned     members;
-   void       **values;
-   const void **keys;
+   group_tab_t  tab;
+   hash_slot_t *slots;
 };
 
+static inline uint64_t hash_ptr(const void *key)
+{
+   assert(key != NULL);
+   return mix_bits_64((uintptr_t)key);
+}
+
 static inline int hash_slot(unsigned size, const void *key)
 {
    assert(key != NULL);
@@ -45,115 +224,112 @@ hash_t *hash_new(int size)
    assert(size > 0);
 
    hash_t *h = xmalloc(sizeof(hash_t));
-   h->size    = MAX(HASH_MIN_SIZE, next_power_of_2(size));
-   h->members = 0;
-
-   char *mem = xcalloc(h->size * 2 * sizeof(void *));
-   h->values = (void **)mem;
-   h->keys   = (const void **)(mem + (h->size * sizeof(void *)));
-
+   h->slots = (hash_slot_t *)group_tab_alloc(&h->tab, group_size_for(size),
+                                             sizeof(hash_slot_t));
    return h;
 }
 
 void hash_free(hash_t *h)
 {
    if (h != NULL) {
-      free(h->values);
+      free(h->slots);
       free(h);
    }
 }
 
-bool hash_put(hash_t *h, const void *key, void *value)
+static void hash_grow(hash_t *h)
 {
-   if (unlikely(h->members > h->size / 2)) {
-      // Rebuild the hash table with a larger size
-      // This is expensive so a conservative initial size should be chosen
+   // This is expensive so a conservative initial size should be chosen
 
-      const int old_size = h->size;
-      h->size *= 2;
+   const group_tab_t old_tab = h->tab;
+   hash_slot_t *old_slots = h->slots;
 
-      const void **old_keys = h->keys;
-      void **old_values = h->values;
+   h->slots = (hash_slot_t *)group_tab_alloc(&h->tab, group_grow_size(&old_tab),
+                                             sizeof(hash_slot_t));
 
-      char *mem = xcalloc(h->size * 2 * sizeof(void *));
-      h->values = (void **)mem;
-      h->keys   = (const void **)(mem + (h->size * sizeof(void *)));
+   for (unsigned i = 0; i < old_tab.size; i++) {
+      if (group_is_full(&old_tab, i)) {
+         const uint64_t hash = hash_ptr(old_slots[i].key);
+         const unsigned slot = group_find_free(&h->tab, hash);
+         h->slots[slot] = old_slots[i];
+         group_set_full(&h->tab, slot, hash >> 57);
+      }
+   }
 
-      h->members = 0;
+   free(old_slots);
+}
 
-      for (int i = 0; i < old_size; i++) {
-         if (old_keys[i] != NULL && old_values[i] != NULL) {
-            int slot = hash_slot(h->size, old_keys[i]);
-
-            for (; ; slot = (slot + 1) & (h->size - 1)) {
-               if (h->keys[slot] == NULL) {
-                  h->values[slot] = old_values[i];
-                  h->keys[slot] = old_keys[i];
-                  h->members++;
-                  break;
-               }
-               else
-                  assert(h->keys[slot] != old_keys[i]);
-            }
-         }
+static inline int hash_find(hash_t *h, const void *key, uint64_t hash)
+{
+   // Returns the slot containing the key or if it is not present the
+   // first free slot in the probe sequence encoded as a negative number
+   const uint8_t h2 = hash >> 57;
+   int free_slot = -1;
+
+   unsigned pos = group_start(&h->tab, hash), stride = 0;
+   for (;; pos = group_next(&h->tab, pos, &stride)) {
+      const group_t group = group_load(h->tab.ctrl + pos);
+      for (group_mask_t m = group_match(group, h2); m; m &= m - 1) {
+         const unsigned slot = pos + group_lowest(m);
+         if (likely(h->slots[slot].key == key))
+            return slot;
       }
 
-      free(old_values);
+      const group_mask_t free = group_match_free(group);
+      if (free != 0) {
+         if (free_slot < 0)
+            free_slot = pos + group_lowest(free);
+         if (likely(group_match_empty(group)))
+            return -free_slot - 1;
+      }
    }
+}
 
-   int slot = hash_slot(h->size, key);
+bool hash_put(hash_t *h, const void *key, void *value)
+{
+   const uint64_t hash = hash_ptr(key);
 
-   for (; ; slot = (slot + 1) & (h->size - 1)) {
-      if (h->keys[slot] == key) {
-         h->values[slot] = value;
-         return true;
-      }
-      else if (h->keys[slot] == NULL) {
-         h->values[slot] = value;
-         h->keys[slot] = key;
-         h->members++;
-         break;
-      }
+   int slot = hash_find(h, key, hash);
+   if (slot >= 0) {
+      h->slots[slot].value = value;
+      return true;
    }
 
+   slot = -slot - 1;
+
+   if (unlikely(h->tab.growth_left == 0) && h->tab.ctrl[slot] == CTRL_EMPTY) {
+      hash_grow(h);
+      slot = group_find_free(&h->tab, hash);
+   }
+
+   h->slots[slot] = (hash_slot_t){ key, value };
+   group_set_full(&h->tab, slot, hash >> 57);
+
    return false;
 }
 
 void hash_delete(hash_t *h, const void *key)
 {
-   int slot = hash_slot(h->size, key);
-
-   for (; ; slot = (slot + 1) & (h->size - 1)) {
-      if (h->keys[slot] == key) {
-         h->values[slot] = NULL;
-         return;
-      }
-      else if (h->keys[slot] == NULL)
-         return;
-   }
+   const int slot = hash_find(h, key, hash_ptr(key));
+   if (slot >= 0)
+      group_erase(&h->tab, slot);
 }
 
 void *hash_get(hash_t *h, const void *key)
 {
-   int slot = hash_slot(h->size, key);
-
-   for (; ; slot = (slot + 1) & (h->size - 1)) {
-      if (h->keys[slot] == key)
-         return h->values[slot];
-      else if (h->keys[slot] == NULL)
-         return NULL;
-   }
+   const int slot = hash_find(h, key, hash_ptr(key));
+   return slot < 0 ? NULL : h->slots[slot].value;
 }
 
 bool hash_iter(hash_t *h, hash_iter_t *now, const void **key, void **value)
 {
    assert(*now != HASH_END);
 
-   while (*now < h->size) {
+   while (*now < h->tab.size) {
       const unsigned old = (*now)++;
-      if (h->keys[old] != NULL && h->values[old] != NULL) {
-         *key   = h->keys[old];
-         *value = h->values[old];
+      if (group_is_full(&h->tab, old) && h->slots[old].value != NULL) {
+         *key   = h->slots[old].key;
+         *value = h->slots[old].value;
          return true;
       }
    }
@@ -164,7 +340,7 @@ bool hash_iter(hash_t *h, hash_iter_t *now, const void **key, void **value)
 
 unsigned hash_members(hash_t *h)
 {
-   return h->members;
+   return h->tab.members;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -312,122 +488,119 @@ bool shash_iter(shash_t *h, hash_iter_t *now, const char **key, void **value)
 ////////////////////////////////////////////////////////////////////////////////
 // Hash of unsigned integers to pointers
 
+typedef struct {
+   uint64_t  key;
+   void     *value;
+} ihash_slot_t;
+
 struct _ihash {
-   unsigned   size;
-   unsigned   members;
-   void     **values;
-   uint64_t  *keys;
-   uint64_t  *mask;
-   uint64_t   cachekey;
-   void      *cacheval;
+   group_tab_t   tab;
+   ihash_slot_t *slots;
+   uint64_t      cachekey;
+   void         *cacheval;
 };
 
-static inline int ihash_slot(ihash_t *h, uint64_t key)
+static inline uint64_t ihash_hash(uint64_t key)
 {
    key = (key ^ (key >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
    key = (key ^ (key >> 27)) * UINT64_C(0x94d049bb133111eb);
-   key = key ^ (key >> 31);
-
-   return key & (h->size - 1);
+   return key ^ (key >> 31);
 }
 
 ihash_t *ihash_new(int size)
 {
-   ihash_t *h = xmalloc(sizeof(ihash_t));
-   h->size    = MAX(HASH_MIN_SIZE, next_power_of_2(size));
-   h->members = 0;
-
-   const size_t bytes =
-      h->size * sizeof(void *) +
-      h->size * sizeof(uint64_t) +
-      (h->size + 63 / 64) * sizeof(uint64_t);
-
-   char *mem = xcalloc(bytes);
-   h->values = (void **)mem;
-   h->keys   = (uint64_t *)(mem + (h->size * sizeof(void *)));
-   h->mask   = (uint64_t *)(mem + (h->size * sizeof(void *))
-                            + (h->size * sizeof(uint64_t)));
-
+   ihash_t *h = xcalloc(sizeof(ihash_t));
+   h->slots = (ihash_slot_t *)group_tab_alloc(&h->tab, group_size_for(size),
+                                              sizeof(ihash_slot_t));
    return h;
 }
 
 void ihash_free(ihash_t *h)
 {
    if (h != NULL) {
-      free(h->values);
+      free(h->slots);
       free(h);
    }
 }
 
-void ihash_put(ihash_t *h, uint64_t key, void *value)
+static void ihash_grow(ihash_t *h)
 {
-   if (unlikely(h->members > h->size / 2)) {
-      // Rebuild the hash table with a larger size
-
-      const int old_size = h->size;
-      h->size *= 2;
-
-      uint64_t *old_keys = h->keys;
-      uint64_t *old_mask = h->mask;
-      void **old_values = h->values;
-
-      const size_t bytes =
-         h->size * sizeof(void *) +
-         h->size * sizeof(uint64_t) +
-         (ALIGN_UP(h->size, 64) / 64) * sizeof(uint64_t);
-
-      char *mem = xcalloc(bytes);
-      h->values = (void **)mem;
-      h->keys   = (uint64_t *)(mem + (h->size * sizeof(void *)));
-      h->mask   = (uint64_t *)(mem + (h->size * sizeof(void *))
-                               + (h->size * sizeof(uint64_t)));
+   const group_tab_t old_tab = h->tab;
+   ihash_slot_t *old_slots = h->slots;
+
+   h->slots = (ihash_slot_t *)group_tab_alloc(&h->tab,
+                                              group_grow_size(&old_tab),
+                                              sizeof(ihash_slot_t));
+
+   for (unsigned i = 0; i < old_tab.size; i++) {
+      if (group_is_full(&old_tab, i)) {
+         const uint64_t hash = ihash_hash(old_slots[i].key);
+         const unsigned slot = group_find_free(&h->tab, hash);
+         h->slots[slot] = old_slots[i];
+         group_set_full(&h->tab, slot, hash >> 57);
+      }
+   }
 
-      h->members = 0;
+   free(old_slots);
+}
 
-      for (int i = 0; i < old_size; i++) {
-         if (old_mask[i / 64] & (UINT64_C(1) << (i % 64)))
-            ihash_put(h, old_keys[i], old_values[i]);
+static inline int ihash_find(ihash_t *h, uint64_t key, uint64_t hash)
+{
+   const uint8_t h2 = hash >> 57;
+   int free_slot = -1;
+
+   unsigned pos = group_start(&h->tab, hash), stride = 0;
+   for (;; pos = group_next(&h->tab, pos, &stride)) {
+      const group_t group = group_load(h->tab.ctrl + pos);
+      for (group_mask_t m = group_match(group, h2); m; m &= m - 1) {
+         const unsigned slot = pos + group_lowest(m);
+         if (likely(h->slots[slot].key == key))
+            return slot;
       }
 
-      free(old_values);
+      const group_mask_t free = group_match_free(group);
+      if (free != 0) {
+         if (free_slot < 0)
+            free_slot = pos + group_lowest(free);
+         if (likely(group_match_empty(group)))
+            return -free_slot - 1;
+      }
    }
+}
 
+void ihash_put(ihash_t *h, uint64_t key, void *value)
+{
    h->cachekey = key;
    h->cacheval = value;
 
-   int slot = ihash_slot(h, key);
+   const uint64_t hash = ihash_hash(key);
 
-   for (; ; slot = (slot + 1) & (h->size - 1)) {
-      if (!(h->mask[slot / 64] & (UINT64_C(1) << (slot % 64)))) {
-         h->values[slot] = value;
-         h->keys[slot] = key;
-         h->mask[slot / 64] |= (UINT64_C(1) << (slot % 64));
-         h->members++;
-         break;
-      }
-      else if (h->keys[slot] == key) {
-         h->values[slot] = value;
-         assert(h->mask[slot / 64] & (UINT64_C(1) << (slot % 64)));
-         return;
-      }
+   int slot = ihash_find(h, key, hash);
+   if (slot >= 0) {
+      h->slots[slot].value = value;
+      return;
+   }
+
+   slot = -slot - 1;
+
+   if (unlikely(h->tab.growth_left == 0) && h->tab.ctrl[slot] == CTRL_EMPTY) {
+      ihash_grow(h);
+      slot = group_find_free(&h->tab, hash);
    }
+
+   h->slots[slot] = (ihash_slot_t){ key, value };
+   group_set_full(&h->tab, slot, hash >> 57);
 }
 
 void *ihash_get(ihash_t *h, uint64_t key)
 {
-   if (h->members > 0 && key == h->cachekey)
+   if (h->tab.members > 0 && key == h->cachekey)
       return h->cacheval;
 
    h->cachekey = key;
 
-   int slot = ihash_slot(h, key);
-
-   for (; ; slot = (slot + 1) & (h->size - 1)) {
-      if (!(h->mask[slot / 64] & (UINT64_C(1) << (slot % 64))))
-         return (h->cacheval = NULL);
-      else if (h->keys[slot] == key)
-         return (h->cacheval = h->values[slot]);
-   }
+   const int slot = ihash_find(h, key, ihash_hash(key));
+   return (h->cacheval = (slot < 0 ? NULL : h->slots[slot].value));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -559,6 +732,7 @@ static void chash_wait_for_resize(chash_t *h)
       if (from == to)
          break;
 
+      stat_add(STAT_CHASH_RESIZE_WAITS, 1);
       thread_sleep(10);
    }
 }
@@ -696,7 +870,8 @@ static bool chash_try_put(chash_t *h, const void *key, void *value)
 
 void chash_put(chash_t *h, const void *key, void *value)
 {
-   while (!chash_try_put(h, key, value));
+   while (!chash_try_put(h, key, value))
+      stat_add(STAT_CHASH_RETRIES, 1);
 }
 
 static bool chash_try_cas(chash_t *h, const void *key, void *cmp, void **value)
@@ -746,7 +921,8 @@ static bool chash_try_cas(chash_t *h, const void *key, void *cmp, void **value)
 
 void *chash_cas(chash_t *h, const void *key, void *cmp, void *value)
 {
-   while (!chash_try_cas(h, key, cmp, &value));
+   while (!chash_try_cas(h, key, cmp, &value))
+      stat_add(STAT_CHASH_RETRIES, 1);
    return value;
 }
 
@@ -813,25 +989,19 @@ void chash_iter(chash_t *h, hash_iter_fn_t fn)
 ////////////////////////////////////////////////////////////////////////////////
 // Generic hash table
 
+typedef struct {
+   const void *key;
+   void       *value;
+   uint32_t    hash;
+} ghash_slot_t;
+
 struct _ghash {
-   unsigned          size;
-   unsigned          members;
-   ghash_hash_fn_t   hash_fn;
-   ghash_cmp_fn_t    cmp_fn;
-   void            **values;
-   const void      **keys;
-   uint32_t         *hashes;
+   group_tab_t      tab;
+   ghash_hash_fn_t  hash_fn;
+   ghash_cmp_fn_t   cmp_fn;
+   ghash_slot_t    *slots;
 };
 
-static void ghash_alloc(ghash_t *h)
-{
-   size_t size = h->size * 2 * sizeof(void *) + h->size * sizeof(uint32_t);
-   char *mem = xcalloc(size);
-   h->values = (void **)mem;
-   h->keys   = (const void **)(mem + (h->size * sizeof(void *)));
-   h->hashes = (uint32_t *)(mem + (2 * h->size * sizeof(void *)));
-}
-
 static inline uint32_t ghash_hash_fn(ghash_t *h, const void *key)
 {
    assert(key != NULL);
@@ -841,110 +1011,98 @@ static inline uint32_t ghash_hash_fn(ghash_t *h, const void *key)
 ghash_t *ghash_new(int size, ghash_hash_fn_t hash_fn, ghash_cmp_fn_t cmp_fn)
 {
    ghash_t *h = xmalloc(sizeof(ghash_t));
-   h->size    = MAX(HASH_MIN_SIZE, next_power_of_2(size));
-   h->members = 0;
    h->hash_fn = hash_fn;
    h->cmp_fn  = cmp_fn;
-
-   ghash_alloc(h);
-
+   h->slots   = (ghash_slot_t *)group_tab_alloc(&h->tab, group_size_for(size),
+                                                sizeof(ghash_slot_t));
    return h;
 }
 
 void ghash_free(ghash_t *h)
 {
    if (h != NULL) {
-      free(h->values);
+      free(h->slots);
       free(h);
    }
 }
 
-void ghash_put(ghash_t *h, const void *key, void *value)
+static void ghash_grow(ghash_t *h)
 {
-   if (unlikely(h->members > h->size / 2)) {
-      // Rebuild the hash table with a larger size
-
-      const int old_size = h->size;
-      h->size *= 2;
-
-      const void **old_keys = h->keys;
-      void **old_values = h->values;
-      uint32_t *old_hashes = h->hashes;
+   const group_tab_t old_tab = h->tab;
+   ghash_slot_t *old_slots = h->slots;
+
+   h->slots = (ghash_slot_t *)group_tab_alloc(&h->tab,
+                                              group_grow_size(&old_tab),
+                                              sizeof(ghash_slot_t));
+
+   for (unsigned i = 0; i < old_tab.size; i++) {
+      if (group_is_full(&old_tab, i)) {
+         const uint32_t hash = old_slots[i].hash;
+         const unsigned slot = group_find_free(&h->tab, hash);
+         h->slots[slot] = old_slots[i];
+         group_set_full(&h->tab, slot, hash >> 25);
+      }
+   }
 
-      ghash_alloc(h);
+   free(old_slots);
+}
 
-      h->members = 0;
+static int ghash_find(ghash_t *h, const void *key, uint32_t hash)
+{
+   const uint8_t h2 = hash >> 25;
+   int free_slot = -1;
+
+   unsigned pos = group_start(&h->tab, hash), stride = 0;
+   for (;; pos = group_next(&h->tab, pos, &stride)) {
+      const group_t group = group_load(h->tab.ctrl + pos);
+      for (group_mask_t m = group_match(group, h2); m; m &= m - 1) {
+         const ghash_slot_t *s = &(h->slots[pos + group_lowest(m)]);
+         if (s->hash != hash)
+            continue;
+         else if (s->key == key || (*h->cmp_fn)(s->key, key))
+            return pos + group_lowest(m);
+      }
 
-      for (int i = 0; i < old_size; i++) {
-         if (old_keys[i] != NULL && old_values[i] != NULL) {
-            int slot = old_hashes[i] & (h->size - 1);
-
-            for (; ; slot = (slot + 1) & (h->size - 1)) {
-               if (h->keys[slot] == NULL) {
-                  h->values[slot] = old_values[i];
-                  h->keys[slot] = old_keys[i];
-                  h->hashes[slot] = old_hashes[i];
-                  h->members++;
-                  break;
-               }
-               else
-                  assert(h->keys[slot] != old_keys[i]);
-            }
-         }
+      const group_mask_t free = group_match_free(group);
+      if (free != 0) {
+         if (free_slot < 0)
+            free_slot = pos + group_lowest(free);
+         if (likely(group_match_empty(group)))
+            return -free_slot - 1;
       }
+   }
+}
 
-      free(old_values);
+void ghash_put(ghash_t *h, const void *key, void *value)
+{
+   const uint32_t hash = ghash_hash_fn(h, key);
+
+   int slot = ghash_find(h, key, hash);
+   if (slot >= 0) {
+      h->slots[slot].value = value;
+      return;
    }
 
-   uint32_t hash = ghash_hash_fn(h, key);
-   int slot = hash & (h->size - 1);
+   slot = -slot - 1;
 
-   for (; ; slot = (slot + 1) & (h->size - 1)) {
-      if (h->keys[slot] == NULL) {
-         h->values[slot] = value;
-         h->keys[slot] = key;
-         h->hashes[slot] = hash;
-         h->members++;
-         break;
-      }
-      else if (h->hashes[slot] != hash)
-         continue;
-      else if (h->keys[slot] == key || (*h->cmp_fn)(h->keys[slot], key)) {
-         h->values[slot] = value;
-         break;
-      }
+   if (unlikely(h->tab.growth_left == 0) && h->tab.ctrl[slot] == CTRL_EMPTY) {
+      ghash_grow(h);
+      slot = group_find_free(&h->tab, hash);
    }
+
+   h->slots[slot] = (ghash_slot_t){ key, value, hash };
+   group_set_full(&h->tab, slot, hash >> 25);
 }
 
 void *ghash_get(ghash_t *h, const void *key)
 {
-   uint32_t hash = ghash_hash_fn(h, key);
-   int slot = hash & (h->size - 1);
-
-   for (; ; slot = (slot + 1) & (h->size - 1)) {
-      if (h->keys[slot] == NULL)
-         return NULL;
-      else if (h->hashes[slot] != hash)
-         continue;
-      else if (h->keys[slot] == key || (*h->cmp_fn)(h->keys[slot], key))
-         return h->values[slot];
-   }
+   const int slot = ghash_find(h, key, ghash_hash_fn(h, key));
+   return slot < 0 ? NULL : h->slots[slot].value;
 }
 
 void ghash_delete(ghash_t *h, const void *key)
 {
-   uint32_t hash = ghash_hash_fn(h, key);
-   int slot = hash & (h->size - 1);
-
-   for (; ; slot = (slot + 1) & (h->size - 1)) {
-      if (h->keys[slot] == NULL)
-         return;
-      else if (h->hashes[slot] != hash)
-         continue;
-      else if (h->keys[slot] == key || (*h->cmp_fn)(h->keys[slot], key)) {
-         h->values[slot] = NULL;
-         h->hashes[slot] = 0;
-         return;
-      }
-   }
+   const int slot = ghash_find(h, key, ghash_hash_fn(h, key));
+   if (slot >= 0)
+      group_erase(&h->tab, slot);
 }
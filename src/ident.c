@@ -41,6 +41,8 @@ typedef uint32_t hash_state_t;
 #define MOVED_TAG     1
 #define MAX_LEN       UINT16_MAX
 #define PRINT_STATS   0
+#define SLAB_SIZE     0x10000
+#define SLAB_MAX      0x400
 
 struct ident_rd_ctx {
    fbuf_t  *file;
@@ -54,15 +56,14 @@ struct ident_rd_ctx {
 struct ident_wr_ctx {
    fbuf_t   *file;
    uint32_t  next_index;
-   uint16_t  generation;
+   uint32_t  generation;
 };
 
 struct _ident {
    hash_state_t hash;
-   uint32_t     length;
-   uint32_t     write_index;
-   uint16_t     write_gen;
+   uint16_t     length;
    uint16_t     key;
+   uint64_t     write_tag;   // Generation and index packed for atomicity
    char         bytes[0];
 };
 
@@ -73,9 +74,17 @@ typedef struct {
    ident_t slots[0];
 } ident_tab_t;
 
+typedef struct {
+   char   *base;
+   size_t  alloc;
+   size_t  prev;
+} ident_slab_t;
+
 static ident_tab_t *table = NULL;
 static ident_tab_t *resizing = NULL;
 
+static __thread ident_slab_t slab;
+
 static const unsigned char canon_table[256] = {
     0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
     0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
@@ -135,19 +144,59 @@ static inline void hash_mix(hash_state_t *state)
    *state = hash;
 }
 
+static inline void hash_unmix(hash_state_t *state)
+{
+   // Inverse of hash_mix to recover the raw FNV-1a state
+   hash_state_t hash = *state;
+   hash ^= (hash >> 13) ^ (hash >> 26);
+   hash *= 0xa5cb9243;
+   hash ^= hash >> 16;
+   *state = hash;
+}
+
 static ident_t ident_alloc(size_t len, hash_state_t hash)
 {
    const size_t aligned = ALIGN_UP(len + 1, 16);
-   ident_t id = xcalloc_flex(sizeof(struct _ident), aligned, sizeof(char));
+   const size_t size = sizeof(struct _ident) + aligned;
+
+   // Identifiers are never freed so small ones are carved out of a
+   // per-thread slab to avoid contention in malloc
+   ident_t id;
+   if (size > SLAB_MAX)
+      id = xcalloc(size);
+   else {
+      if (slab.base == NULL || slab.alloc + size > SLAB_SIZE) {
+         slab.base = xcalloc(SLAB_SIZE);
+         slab.alloc = 0;
+      }
+
+      id = (ident_t)(slab.base + slab.alloc);
+      slab.prev = slab.alloc;
+      slab.alloc += size;
+   }
+
    id->length      = len;
-   id->write_gen   = 0;
-   id->write_index = 0;
+   id->write_tag   = 0;
    id->hash        = hash;
    id->key         = UINT16_MAX;
 
    return id;
 }
 
+static void ident_release(ident_t id)
+{
+   const size_t size = sizeof(struct _ident) + ALIGN_UP(id->length + 1, 16);
+
+   if (size > SLAB_MAX)
+      free(id);
+   else {
+      // Must be the most recent allocation from this thread's slab
+      assert((char *)id == slab.base + slab.prev);
+      memset(id, '\0', size);
+      slab.alloc = slab.prev;
+   }
+}
+
 static inline bool ident_install(ident_t *where, ident_t new, size_t len)
 {
    if (unlikely(len >= MAX_LEN))
@@ -156,7 +205,7 @@ static inline bool ident_install(ident_t *where, ident_t new, size_t len)
    if (atomic_cas(where, NULL, new))
       return true;
    else {
-      free(new);
+      ident_release(new);
       return false;
    }
 }
@@ -320,7 +369,7 @@ static ident_t ident_from_byte_vec(hash_state_t hash, bool uniq, int nparts,
             else
                break;
          }
-         else if (id->length == len) {
+         else if (id->length == len && id->hash == hash) {
             int pos = 0;
             for (const char *p = id->bytes;
                  pos < nparts && memcmp(p, str_vec[pos], len_vec[pos]) == 0;
@@ -380,12 +429,11 @@ const char *istr(ident_t ident)
 
 ident_wr_ctx_t ident_write_begin(fbuf_t *f)
 {
-   static uint16_t ident_wr_gen = 1;
-   assert(ident_wr_gen > 0);
+   static uint32_t ident_wr_gen = 0;
 
    struct ident_wr_ctx *ctx = xcalloc(sizeof(struct ident_wr_ctx));
    ctx->file         = f;
-   ctx->generation   = ident_wr_gen++;
+   ctx->generation   = atomic_add(&ident_wr_gen, 1);
    ctx->next_index   = 1;   // Skip over null ident
 
    return ctx;
@@ -400,16 +448,23 @@ void ident_write(ident_t ident, ident_wr_ctx_t ctx)
 {
    if (ident == NULL)
       fbuf_put_int(ctx->file, 1);   // TODO: change this to zero
-   else if (ident->write_gen == ctx->generation)
-      fbuf_put_int(ctx->file, ident->write_index + 1);
    else {
+      // Several files may be written concurrently in which case another
+      // thread can overwrite the tag and the ident is written again
+      const uint64_t tag = relaxed_load(&ident->write_tag);
+      if ((tag >> 32) == ctx->generation) {
+         fbuf_put_int(ctx->file, (uint32_t)tag + 1);
+         return;
+      }
+
       fbuf_put_int(ctx->file, -ident->length);
 
       assert(ident->bytes[ident->length] == '\0');
       write_raw(ident->bytes, ident->length, ctx->file);
 
-      ident->write_gen   = ctx->generation;
-      ident->write_index = ctx->next_index++;
+      const uint64_t index = ctx->next_index++;
+      relaxed_store(&ident->write_tag,
+                    (uint64_t)ctx->generation << 32 | index);
 
       assert(ctx->next_index != UINT32_MAX);
    }
@@ -448,14 +503,15 @@ ident_t ident_read(ident_rd_ctx_t ctx)
       }
 
       read_raw(ctx->scratch, -index, ctx->file);
-      ctx->scratch[-index] = '\0';
 
       if (unlikely(ctx->cache_sz == ctx->cache_alloc)) {
          ctx->cache_alloc *= 2;
          ctx->cache = xrealloc(ctx->cache, ctx->cache_alloc * sizeof(ident_t));
       }
 
-      return (ctx->cache[ctx->cache_sz++] = ident_new(ctx->scratch));
+      // The length is already known so avoid scanning for the terminator
+      ident_t id = ident_new_n(ctx->scratch, -index);
+      return (ctx->cache[ctx->cache_sz++] = id);
    }
    else if (likely(index > 0 && index - 1 < ctx->cache_sz))
       return ctx->cache[index - 1];
@@ -536,8 +592,9 @@ ident_t ident_prefix(ident_t a, ident_t b, char sep)
    else if (b == NULL)
       return a;
    else if (sep == '\0') {
-      hash_state_t hash = HASH_INIT;
-      hash_update(&hash, a->bytes, a->length);
+      // Resume hashing from the state of the prefix
+      hash_state_t hash = a->hash;
+      hash_unmix(&hash);
       hash_update(&hash, b->bytes, b->length);
 
       const char *str_vec[] = { a->bytes, b->bytes };
@@ -545,8 +602,8 @@ ident_t ident_prefix(ident_t a, ident_t b, char sep)
       return ident_from_byte_vec(hash, false, 2, str_vec, len_vec);
    }
    else {
-      hash_state_t hash = HASH_INIT;
-      hash_update(&hash, a->bytes, a->length);
+      hash_state_t hash = a->hash;
+      hash_unmix(&hash);
       hash_update(&hash, &sep, 1);
       hash_update(&hash, b->bytes, b->length);
 
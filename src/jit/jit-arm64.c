@@ -0,0 +1,1286 @@
+//
+//  Copyright (C) 2026  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "ident.h"
+#include "option.h"
+#include "jit/jit-priv.h"
+#include "jit/jit.h"
+#include "rt/rt.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+
+// Template code generator for AArch64: every JIT register lives in a
+// stack slot and each IR instruction is translated independently using
+// a small set of scratch registers
+
+typedef struct {
+   jit_t        *jit;
+   code_cache_t *code;
+} jit_arm64_state_t;
+
+typedef uint8_t a64_reg_t;
+
+#define __X0  0
+#define __X1  1
+#define __X2  2
+#define __X3  3
+#define __X9  9
+#define __X10 10
+#define __X16 16    // IP0: address computation
+#define __X17 17    // IP1: large immediates
+#define __FP  29
+#define __LR  30
+#define __SP  31
+#define __XZR 31
+
+#define __D0 0
+#define __D1 1
+
+#define ARGS_REG  19
+#define TLAB_REG  20
+#define FLAGS_REG 21
+
+#define FRAME_FIXED_SIZE 64    // Size of fixed part of call frame
+#define ANCHOR_OFFSET    -56   // Offset of frame anchor from FP
+
+#define MAX_FRAME_REGS 4095    // Limit of scaled 12-bit load offset
+#define MAX_FUNC_IRS   16384   // Keep branches within +/-1MB
+
+typedef enum {
+   A64_EQ = 0, A64_NE = 1, A64_HS = 2, A64_LO = 3, A64_MI = 4, A64_PL = 5,
+   A64_VS = 6, A64_VC = 7, A64_HI = 8, A64_LS = 9, A64_GE = 10, A64_LT = 11,
+   A64_GT = 12, A64_LE = 13,
+} a64_cond_t;
+
+static void a64_emit(code_blob_t *blob, uint32_t insn)
+{
+   const uint8_t bytes[4] = {
+      insn & 0xff, (insn >> 8) & 0xff, (insn >> 16) & 0xff, insn >> 24
+   };
+   code_blob_emit(blob, bytes, sizeof(bytes));
+}
+
+#define __(insn) a64_emit(blob, (insn))
+
+#define RRR(op, rd, rn, rm) __((op) | ((rm) << 16) | ((rn) << 5) | (rd))
+
+#define ADD(rd, rn, rm) RRR(0x8b000000, (rd), (rn), (rm))
+#define ADDS(rd, rn, rm) RRR(0xab000000, (rd), (rn), (rm))
+#define SUB(rd, rn, rm) RRR(0xcb000000, (rd), (rn), (rm))
+#define SUBS(rd, rn, rm) RRR(0xeb000000, (rd), (rn), (rm))
+#define ADDSW(rd, rn, rm) RRR(0x2b000000, (rd), (rn), (rm))
+#define SUBSW(rd, rn, rm) RRR(0x6b000000, (rd), (rn), (rm))
+#define ADDW(rd, rn, rm) RRR(0x0b000000, (rd), (rn), (rm))
+#define AND(rd, rn, rm) RRR(0x8a000000, (rd), (rn), (rm))
+#define ORR(rd, rn, rm) RRR(0xaa000000, (rd), (rn), (rm))
+#define EOR(rd, rn, rm) RRR(0xca000000, (rd), (rn), (rm))
+#define MUL(rd, rn, rm) RRR(0x9b007c00, (rd), (rn), (rm))
+#define SMULH(rd, rn, rm) RRR(0x9b407c00, (rd), (rn), (rm))
+#define UMULH(rd, rn, rm) RRR(0x9bc07c00, (rd), (rn), (rm))
+#define SDIV(rd, rn, rm) RRR(0x9ac00c00, (rd), (rn), (rm))
+#define LSLV(rd, rn, rm) RRR(0x9ac02000, (rd), (rn), (rm))
+#define LSRV(rd, rn, rm) RRR(0x9ac02400, (rd), (rn), (rm))
+#define ASRV(rd, rn, rm) RRR(0x9ac02800, (rd), (rn), (rm))
+#define MSUB(rd, rn, rm, ra) RRR(0x9b008000 | ((ra) << 10), (rd), (rn), (rm))
+#define ADDX(rd, rn, rm) RRR(0x8b206000, (rd), (rn), (rm))   // UXTX, allows SP
+#define SUBX(rd, rn, rm) RRR(0xcb206000, (rd), (rn), (rm))   // UXTX, allows SP
+#define MOV(rd, rm) ORR((rd), __XZR, (rm))
+#define NEG(rd, rm) SUB((rd), __XZR, (rm))
+#define CMP(rn, rm) SUBS(__XZR, (rn), (rm))
+#define CMPW(rn, rm) SUBSW(__XZR, (rn), (rm))
+// CMP rn, rm, ASR #63
+#define CMP_ASR63(rn, rm) RRR(0xeb80fc00, __XZR, (rn), (rm))
+
+#define IMM12(op, rd, rn, imm) \
+   __((op) | (((imm) & 0xfff) << 10) | ((rn) << 5) | (rd))
+
+#define ADDI(rd, rn, imm) IMM12(0x91000000, (rd), (rn), (imm))
+#define SUBI(rd, rn, imm) IMM12(0xd1000000, (rd), (rn), (imm))
+#define ADDWI(rd, rn, imm) IMM12(0x11000000, (rd), (rn), (imm))
+#define SUBSWI(rd, rn, imm) IMM12(0x71000000, (rd), (rn), (imm))
+#define SUBSI(rd, rn, imm) IMM12(0xf1000000, (rd), (rn), (imm))
+#define CMPI(rn, imm) SUBSI(__XZR, (rn), (imm))
+#define MOVSP(rd, rn) ADDI((rd), (rn), 0)
+
+#define BFM(op, rd, rn, immr, imms) \
+   __((op) | ((immr) << 16) | ((imms) << 10) | ((rn) << 5) | (rd))
+
+#define SBFM(rd, rn, immr, imms) BFM(0x93400000, (rd), (rn), (immr), (imms))
+#define UBFM(rd, rn, immr, imms) BFM(0xd3400000, (rd), (rn), (immr), (imms))
+#define UBFMW(rd, rn, immr, imms) BFM(0x53000000, (rd), (rn), (immr), (imms))
+#define LSLI(rd, rn, s) UBFM((rd), (rn), (64 - (s)) & 63, 63 - (s))
+#define LSRI(rd, rn, s) UBFM((rd), (rn), (s), 63)
+#define ASRI(rd, rn, s) SBFM((rd), (rn), (s), 63)
+#define LSLWI(rd, rn, s) UBFMW((rd), (rn), (32 - (s)) & 31, 31 - (s))
+#define LSRWI(rd, rn, s) UBFMW((rd), (rn), (s), 31)
+
+#define CSEL(rd, rn, rm, cond) \
+   RRR(0x9a800000 | ((cond) << 12), (rd), (rn), (rm))
+#define CSET(rd, cond) CSEL_INC((rd), (cond) ^ 1)
+#define CSEL_INC(rd, cond) \
+   RRR(0x9a800400 | ((cond) << 12), (rd), __XZR, __XZR)
+
+#define LDST(op, rt, rn, off) \
+   __((op) | (((off) & 0xfff) << 10) | ((rn) << 5) | (rt))
+
+#define LDR(rt, rn, off) LDST(0xf9400000, (rt), (rn), (off) / 8)
+#define STR(rt, rn, off) LDST(0xf9000000, (rt), (rn), (off) / 8)
+#define LDRW(rt, rn, off) LDST(0xb9400000, (rt), (rn), (off) / 4)
+#define STRW(rt, rn, off) LDST(0xb9000000, (rt), (rn), (off) / 4)
+#define LDRH(rt, rn) LDST(0x79400000, (rt), (rn), 0)
+#define STRH(rt, rn) LDST(0x79000000, (rt), (rn), 0)
+#define LDRB(rt, rn) LDST(0x39400000, (rt), (rn), 0)
+#define STRB(rt, rn) LDST(0x39000000, (rt), (rn), 0)
+#define LDRSB(rt, rn) LDST(0x39800000, (rt), (rn), 0)
+#define LDRSH(rt, rn) LDST(0x79800000, (rt), (rn), 0)
+#define LDRSW(rt, rn) LDST(0xb9800000, (rt), (rn), 0)
+
+#define LDXRW(rt, rn) __(0x885f7c00 | ((rn) << 5) | (rt))
+#define STXRW(rs, rt, rn) __(0x88007c00 | ((rs) << 16) | ((rn) << 5) | (rt))
+
+#define LDUR(op, rt, rn, off) \
+   __((op) | (((off) & 0x1ff) << 12) | ((rn) << 5) | (rt))
+
+#define LDURX(rt, rn, off) LDUR(0xf8400000, (rt), (rn), (off))
+#define STURX(rt, rn, off) LDUR(0xf8000000, (rt), (rn), (off))
+#define LDURW(rt, rn, off) LDUR(0xb8400000, (rt), (rn), (off))
+#define STURW(rt, rn, off) LDUR(0xb8000000, (rt), (rn), (off))
+
+#define LDSTP(op, rt, rt2, rn, off) \
+   __((op) | ((((off) / 8) & 0x7f) << 15) | ((rt2) << 10) | ((rn) << 5) | (rt))
+
+#define STP(rt, rt2, rn, off) LDSTP(0xa9000000, (rt), (rt2), (rn), (off))
+#define LDP(rt, rt2, rn, off) LDSTP(0xa9400000, (rt), (rt2), (rn), (off))
+#define STP_PRE(rt, rt2, rn, off) LDSTP(0xa9800000, (rt), (rt2), (rn), (off))
+#define LDP_POST(rt, rt2, rn, off) LDSTP(0xa8c00000, (rt), (rt2), (rn), (off))
+
+#define FRR(op, rd, rn, rm) RRR((op), (rd), (rn), (rm))
+
+#define FADD(rd, rn, rm) FRR(0x1e602800, (rd), (rn), (rm))
+#define FSUB(rd, rn, rm) FRR(0x1e603800, (rd), (rn), (rm))
+#define FMUL(rd, rn, rm) FRR(0x1e600800, (rd), (rn), (rm))
+#define FDIV(rd, rn, rm) FRR(0x1e601800, (rd), (rn), (rm))
+#define FNEG(rd, rn) FRR(0x1e614000, (rd), (rn), 0)
+#define FCMP(rn, rm) FRR(0x1e602000, 0, (rn), (rm))
+#define FMOV_DX(rd, rn) FRR(0x9e670000, (rd), (rn), 0)
+#define FMOV_XD(rd, rn) FRR(0x9e660000, (rd), (rn), 0)
+#define SCVTF(rd, rn) FRR(0x9e620000, (rd), (rn), 0)
+#define FCVTAS(rd, rn) FRR(0x9e640000, (rd), (rn), 0)
+
+#define B_COND(cond, n) __(0x54000000 | (((n) & 0x7ffff) << 5) | (cond))
+#define B(n) __(0x14000000 | ((n) & 0x3ffffff))
+#define CBZ(rt, n) __(0xb4000000 | (((n) & 0x7ffff) << 5) | (rt))
+#define CBNZ(rt, n) __(0xb5000000 | (((n) & 0x7ffff) << 5) | (rt))
+#define TBZ(rt, bit, n) \
+   __(0x36000000 | ((bit) << 19) | (((n) & 0x3fff) << 5) | (rt))
+#define BLR(rn) __(0xd63f0000 | ((rn) << 5))
+#define RET() __(0xd65f03c0)
+#define BRK() __(0xd4200000)
+
+static void a64_mov_imm(code_blob_t *blob, a64_reg_t rd, uint64_t imm)
+{
+   if (imm == 0) {
+      __(0xd2800000 | rd);   // MOVZ
+      return;
+   }
+
+   bool first = true;
+   for (int hw = 0; hw < 4; hw++) {
+      const uint16_t chunk = (imm >> (hw * 16)) & 0xffff;
+      if (chunk == 0)
+         continue;
+
+      const uint32_t op = first ? 0xd2800000 : 0xf2800000;   // MOVZ/MOVK
+      __(op | (hw << 21) | (chunk << 5) | rd);
+      first = false;
+   }
+}
+
+static void a64_add_imm(code_blob_t *blob, a64_reg_t rd, a64_reg_t rn,
+                        int64_t imm)
+{
+   if (imm == 0 && rd == rn)
+      return;
+   else if (imm >= 0 && imm < 4096)
+      ADDI(rd, rn, imm);
+   else if (imm < 0 && imm > -4096)
+      SUBI(rd, rn, -imm);
+   else {
+      a64_mov_imm(blob, __X17, imm);
+      ADDX(rd, rn, __X17);
+   }
+}
+
+static void a64_call(code_blob_t *blob, const void *fn)
+{
+   a64_mov_imm(blob, __X16, (uintptr_t)fn);
+   BLR(__X16);
+}
+
+static uint32_t *a64_forward(code_blob_t *blob)
+{
+   return (uint32_t *)blob->wptr;
+}
+
+static void a64_resolve(code_blob_t *blob, uint32_t *patch)
+{
+   // Resolve a forward branch emitted at PATCH to the current position
+   if (blob->overflow)
+      return;
+
+   const ptrdiff_t rel = (uint32_t *)blob->wptr - patch;
+   if ((*patch & 0xff000010) == 0x54000000)
+      *patch |= (rel & 0x7ffff) << 5;
+   else if ((*patch & 0x7e000000) == 0x34000000)
+      *patch |= (rel & 0x7ffff) << 5;
+   else if ((*patch & 0xfc000000) == 0x14000000)
+      *patch |= rel & 0x3ffffff;
+   else
+      fatal_trace("cannot resolve branch %08x", *patch);
+}
+
+static void jit_arm64_patch(code_blob_t *blob, jit_label_t label,
+                            uint8_t *wptr, const uint8_t *dest)
+{
+   uint32_t *patch = (uint32_t *)wptr - 1;
+   const ptrdiff_t rel = (const uint32_t *)dest - patch;
+
+   if ((*patch & 0xfc000000) == 0x14000000)
+      *patch = (*patch & 0xfc000000) | (rel & 0x3ffffff);
+   else {
+      if (unlikely(rel < -(1 << 18) || rel >= (1 << 18)))
+         fatal_trace("branch displacement %"PRIiPTR" does not fit in "
+                     "19-bit immediate", rel);
+
+      *patch = (*patch & 0xff00001f) | ((rel & 0x7ffff) << 5);
+   }
+}
+
+static int jit_arm64_reg_offset(jit_reg_t reg)
+{
+   return reg * sizeof(int64_t);
+}
+
+static int64_t jit_arm64_locals(code_blob_t *blob, int64_t off)
+{
+   return blob->func->nregs * sizeof(int64_t) + off;
+}
+
+static void jit_arm64_get_reg(code_blob_t *blob, a64_reg_t rd, jit_reg_t reg)
+{
+   LDR(rd, __SP, jit_arm64_reg_offset(reg));
+}
+
+static void jit_arm64_put(code_blob_t *blob, jit_reg_t dst, a64_reg_t rs)
+{
+   STR(rs, __SP, jit_arm64_reg_offset(dst));
+}
+
+static void jit_arm64_get(code_blob_t *blob, a64_reg_t rd, jit_value_t src)
+{
+   switch (src.kind) {
+   case JIT_VALUE_REG:
+      jit_arm64_get_reg(blob, rd, src.reg);
+      break;
+   case JIT_VALUE_INT64:
+   case JIT_VALUE_DOUBLE:
+   case JIT_ADDR_ABS:
+      a64_mov_imm(blob, rd, src.int64);
+      break;
+   case JIT_VALUE_HANDLE:
+      a64_mov_imm(blob, rd, src.handle);
+      break;
+   case JIT_VALUE_LOCUS:
+      a64_mov_imm(blob, rd, (uintptr_t)src.locus);
+      break;
+   case JIT_ADDR_REG:
+      jit_arm64_get_reg(blob, rd, src.reg);
+      a64_add_imm(blob, rd, rd, src.disp);
+      break;
+   case JIT_ADDR_CPOOL:
+      a64_mov_imm(blob, rd, (uintptr_t)(blob->func->cpool + src.int64));
+      break;
+   default:
+      fatal_trace("cannot handle value kind %d in jit_arm64_get", src.kind);
+   }
+}
+
+static void jit_arm64_get_float(code_blob_t *blob, a64_reg_t rd,
+                                a64_reg_t tmp, jit_value_t src)
+{
+   jit_arm64_get(blob, tmp, src);
+   FMOV_DX(rd, tmp);
+}
+
+static void jit_arm64_put_float(code_blob_t *blob, jit_reg_t dst, a64_reg_t rs)
+{
+   FMOV_XD(__X0, rs);
+   jit_arm64_put(blob, dst, __X0);
+}
+
+static int jit_arm64_bits(jit_ir_t *ir)
+{
+   switch (ir->size) {
+   case JIT_SZ_8: return 8;
+   case JIT_SZ_16: return 16;
+   case JIT_SZ_32: return 32;
+   default: return 64;
+   }
+}
+
+static void jit_arm64_sext(code_blob_t *blob, a64_reg_t rd, a64_reg_t rn,
+                           int bits)
+{
+   if (bits < 64)
+      SBFM(rd, rn, 0, bits - 1);
+   else if (rd != rn)
+      MOV(rd, rn);
+}
+
+static void jit_arm64_zext(code_blob_t *blob, a64_reg_t rd, a64_reg_t rn,
+                           int bits)
+{
+   if (bits < 64)
+      UBFM(rd, rn, 0, bits - 1);
+   else if (rd != rn)
+      MOV(rd, rn);
+}
+
+static a64_cond_t jit_arm64_cond(jit_cc_t cc)
+{
+   switch (cc) {
+   case JIT_CC_EQ: return A64_EQ;
+   case JIT_CC_NE: return A64_NE;
+   case JIT_CC_LT: return A64_LT;
+   case JIT_CC_GT: return A64_GT;
+   case JIT_CC_LE: return A64_LE;
+   case JIT_CC_GE: return A64_GE;
+   case JIT_CC_C:  return A64_LO;
+   case JIT_CC_NC: return A64_HS;
+   case JIT_CC_O:  return A64_HI;
+   case JIT_CC_NO: return A64_LS;
+   default:
+      fatal_trace("unhandled JIT comparison code %d", cc);
+   }
+}
+
+static void jit_arm64_set_anchor_irpos(code_blob_t *blob, jit_ir_t *ir)
+{
+   const ptrdiff_t off = offsetof(jit_anchor_t, irpos);
+   a64_mov_imm(blob, __X9, ir - blob->func->irbuf);
+   STURW(__X9, __FP, ANCHOR_OFFSET + off);
+}
+
+static void jit_arm64_recv(code_blob_t *blob, jit_ir_t *ir)
+{
+   assert(ir->arg1.kind == JIT_VALUE_INT64);
+   const int nth = ir->arg1.int64;
+
+   LDR(__X0, ARGS_REG, nth * sizeof(int64_t));
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_send(code_blob_t *blob, jit_ir_t *ir)
+{
+   assert(ir->arg1.kind == JIT_VALUE_INT64);
+   const int nth = ir->arg1.int64;
+
+   jit_arm64_get(blob, __X0, ir->arg2);
+   STR(__X0, ARGS_REG, nth * sizeof(int64_t));
+}
+
+static void jit_arm64_addsub(code_blob_t *blob, jit_ir_t *ir, bool sub)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   jit_arm64_get(blob, __X1, ir->arg2);
+
+   const int bits = jit_arm64_bits(ir);
+
+   // Narrow operations are performed in the top bits of a W register
+   // so the condition flags reflect overflow at that width
+   if (bits == 64) {
+      if (sub)
+         SUBS(__X0, __X0, __X1);
+      else
+         ADDS(__X0, __X0, __X1);
+   }
+   else {
+      const int shift = 32 - bits;
+      if (shift > 0) {
+         LSLWI(__X0, __X0, shift);
+         LSLWI(__X1, __X1, shift);
+      }
+
+      if (sub)
+         SUBSW(__X0, __X0, __X1);
+      else
+         ADDSW(__X0, __X0, __X1);
+   }
+
+   switch (ir->cc) {
+   case JIT_CC_O: CSET(FLAGS_REG, A64_VS); break;
+   case JIT_CC_C: CSET(FLAGS_REG, sub ? A64_LO : A64_HS); break;
+   case JIT_CC_NONE: break;
+   default:
+      fatal_trace("unhandled JIT overflow code %d", ir->cc);
+   }
+
+   if (bits < 64)
+      SBFM(__X0, __X0, 32 - bits, 31);
+
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_mul(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   jit_arm64_get(blob, __X1, ir->arg2);
+
+   const int bits = jit_arm64_bits(ir);
+
+   if (ir->cc == JIT_CC_NONE)
+      MUL(__X0, __X0, __X1);
+   else if (bits == 64) {
+      if (ir->cc == JIT_CC_O) {
+         SMULH(__X2, __X0, __X1);
+         MUL(__X0, __X0, __X1);
+         CMP_ASR63(__X2, __X0);
+      }
+      else {
+         UMULH(__X2, __X0, __X1);
+         MUL(__X0, __X0, __X1);
+         CMPI(__X2, 0);
+      }
+      CSET(FLAGS_REG, A64_NE);
+   }
+   else if (ir->cc == JIT_CC_O) {
+      // The full product of two narrow values fits in 64 bits
+      jit_arm64_sext(blob, __X0, __X0, bits);
+      jit_arm64_sext(blob, __X1, __X1, bits);
+      MUL(__X0, __X0, __X1);
+      jit_arm64_sext(blob, __X2, __X0, bits);
+      CMP(__X0, __X2);
+      CSET(FLAGS_REG, A64_NE);
+   }
+   else {
+      jit_arm64_zext(blob, __X0, __X0, bits);
+      jit_arm64_zext(blob, __X1, __X1, bits);
+      MUL(__X0, __X0, __X1);
+      LSRI(__X2, __X0, bits);
+      CMPI(__X2, 0);
+      CSET(FLAGS_REG, A64_NE);
+   }
+
+   jit_arm64_sext(blob, __X0, __X0, bits);
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_divrem(code_blob_t *blob, jit_ir_t *ir, bool rem)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   jit_arm64_get(blob, __X1, ir->arg2);
+
+   const int bits = jit_arm64_bits(ir);
+
+   jit_arm64_sext(blob, __X0, __X0, bits);
+   jit_arm64_sext(blob, __X1, __X1, bits);
+
+   SDIV(__X2, __X0, __X1);
+
+   if (rem)
+      MSUB(__X0, __X2, __X1, __X0);
+   else
+      MOV(__X0, __X2);
+
+   jit_arm64_sext(blob, __X0, __X0, bits);
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_neg(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   NEG(__X0, __X0);
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_not(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   CMPI(__X0, 0);
+   CSET(__X0, A64_EQ);
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_logical(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   jit_arm64_get(blob, __X1, ir->arg2);
+
+   switch (ir->op) {
+   case J_AND: AND(__X0, __X0, __X1); break;
+   case J_OR:  ORR(__X0, __X0, __X1); break;
+   case J_XOR: EOR(__X0, __X0, __X1); break;
+   default: should_not_reach_here();
+   }
+
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_shift(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   jit_arm64_get(blob, __X1, ir->arg2);
+
+   // Shift counts of 64 or more produce zero or the sign bit as in
+   // the interpreter rather than wrapping around
+   switch (ir->op) {
+   case J_SHL:
+      LSLV(__X2, __X0, __X1);
+      CMPI(__X1, 64);
+      CSEL(__X0, __XZR, __X2, A64_HS);
+      break;
+   case J_SHR:
+      LSRV(__X2, __X0, __X1);
+      CMPI(__X1, 64);
+      CSEL(__X0, __XZR, __X2, A64_HS);
+      break;
+   case J_ASR:
+      a64_mov_imm(blob, __X2, 63);
+      CMPI(__X1, 63);
+      CSEL(__X1, __X2, __X1, A64_HI);
+      ASRV(__X0, __X0, __X1);
+      break;
+   default:
+      should_not_reach_here();
+   }
+
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_clamp(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   CMPI(__X0, 0);
+   CSEL(__X0, __X0, __XZR, A64_GT);
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_mov(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_cmp(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   jit_arm64_get(blob, __X1, ir->arg2);
+
+   CMP(__X0, __X1);
+
+   if (ir->op == J_CCMP) {
+      CSET(__X2, jit_arm64_cond(ir->cc));
+      AND(FLAGS_REG, FLAGS_REG, __X2);
+   }
+   else
+      CSET(FLAGS_REG, jit_arm64_cond(ir->cc));
+}
+
+static void jit_arm64_cset(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_put(blob, ir->result, FLAGS_REG);
+}
+
+static void jit_arm64_csel(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   jit_arm64_get(blob, __X1, ir->arg2);
+
+   CMPI(FLAGS_REG, 0);
+   CSEL(__X0, __X0, __X1, A64_NE);
+
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_jump(code_blob_t *blob, jit_ir_t *ir)
+{
+   switch (ir->cc) {
+   case JIT_CC_NONE: B(0); break;
+   case JIT_CC_T: CBNZ(FLAGS_REG, 0); break;
+   case JIT_CC_F: CBZ(FLAGS_REG, 0); break;
+   default:
+      fatal_trace("invalid JUMP condition code");
+   }
+
+   code_blob_patch(blob, ir->arg1.label, jit_arm64_patch);
+}
+
+static void jit_arm64_ret(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_ir_t *endir = blob->func->irbuf + blob->func->nirs;
+   if (ir + 1 < endir) {
+      B(0);
+      code_blob_patch(blob, JIT_LABEL_INVALID, jit_arm64_patch);
+   }
+}
+
+static void jit_arm64_load(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X16, ir->arg1);
+
+   const bool sext = (ir->op == J_LOAD);
+
+   switch (ir->size) {
+   case JIT_SZ_8:
+      if (sext) LDRSB(__X0, __X16); else LDRB(__X0, __X16);
+      break;
+   case JIT_SZ_16:
+      if (sext) LDRSH(__X0, __X16); else LDRH(__X0, __X16);
+      break;
+   case JIT_SZ_32:
+      if (sext) LDRSW(__X0, __X16); else LDRW(__X0, __X16, 0);
+      break;
+   default:
+      LDR(__X0, __X16, 0);
+      break;
+   }
+
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_store(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   jit_arm64_get(blob, __X16, ir->arg2);
+
+   switch (ir->size) {
+   case JIT_SZ_8: STRB(__X0, __X16); break;
+   case JIT_SZ_16: STRH(__X0, __X16); break;
+   case JIT_SZ_32: STRW(__X0, __X16, 0); break;
+   default: STR(__X0, __X16, 0); break;
+   }
+}
+
+static void jit_arm64_call(code_blob_t *blob, jit_arm64_state_t *state,
+                           jit_ir_t *ir)
+{
+   jit_func_t *f = jit_get_func(state->jit, ir->arg1.handle);
+
+   a64_mov_imm(blob, __X0, (uintptr_t)f);
+   SUBI(__X1, __FP, -ANCHOR_OFFSET);
+   MOV(__X2, ARGS_REG);
+   MOV(__X3, TLAB_REG);
+   LDR(__X16, __X0, offsetof(jit_func_t, entry));
+   BLR(__X16);
+}
+
+static void jit_arm64_fbinary(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get_float(blob, __D0, __X0, ir->arg1);
+   jit_arm64_get_float(blob, __D1, __X1, ir->arg2);
+
+   switch (ir->op) {
+   case J_FADD: FADD(__D0, __D0, __D1); break;
+   case J_FSUB: FSUB(__D0, __D0, __D1); break;
+   case J_FMUL: FMUL(__D0, __D0, __D1); break;
+   case J_FDIV: FDIV(__D0, __D0, __D1); break;
+   default: should_not_reach_here();
+   }
+
+   jit_arm64_put_float(blob, ir->result, __D0);
+}
+
+static void jit_arm64_fneg(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get_float(blob, __D0, __X0, ir->arg1);
+   FNEG(__D0, __D0);
+   jit_arm64_put_float(blob, ir->result, __D0);
+}
+
+static void jit_arm64_fcmp(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get_float(blob, __D0, __X0, ir->arg1);
+   jit_arm64_get_float(blob, __D1, __X1, ir->arg2);
+
+   FCMP(__D0, __D1);
+
+   // All comparisons are false if either operand is NaN
+   switch (ir->cc) {
+   case JIT_CC_EQ: CSET(__X2, A64_EQ); break;
+   case JIT_CC_LT: CSET(__X2, A64_MI); break;
+   case JIT_CC_LE: CSET(__X2, A64_LS); break;
+   case JIT_CC_GT: CSET(__X2, A64_GT); break;
+   case JIT_CC_GE: CSET(__X2, A64_GE); break;
+   case JIT_CC_NE:
+      CSET(__X2, A64_MI);
+      CSET(__X3, A64_GT);
+      ORR(__X2, __X2, __X3);
+      break;
+   default:
+      fatal_trace("unhandled FCMP comparison code %d", ir->cc);
+   }
+
+   if (ir->op == J_FCCMP)
+      AND(FLAGS_REG, FLAGS_REG, __X2);
+   else
+      MOV(FLAGS_REG, __X2);
+}
+
+static void jit_arm64_fcvtns(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get_float(blob, __D0, __X0, ir->arg1);
+   FCVTAS(__X0, __D0);   // Round to nearest with ties away from zero
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_scvtf(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   SCVTF(__D0, __X0);
+   jit_arm64_put_float(blob, ir->result, __D0);
+}
+
+static void jit_arm64_macro_exit(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_set_anchor_irpos(blob, ir);
+
+   a64_mov_imm(blob, __X0, ir->arg1.exit);
+   SUBI(__X1, __FP, -ANCHOR_OFFSET);
+   MOV(__X2, ARGS_REG);
+   MOV(__X3, TLAB_REG);
+   a64_call(blob, __nvc_do_exit);
+
+#ifdef DEBUG
+   if (jit_will_abort(ir))
+      BRK();
+#endif
+}
+
+static void jit_arm64_macro_salloc(code_blob_t *blob, jit_ir_t *ir)
+{
+   assert(ir->arg1.int64 + ir->arg2.int64 <= blob->func->framesz);
+
+   const int64_t off = jit_arm64_locals(blob, ir->arg1.int64);
+   a64_add_imm(blob, __X0, __SP, off);
+
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_macro_lalloc(code_blob_t *blob, jit_ir_t *ir)
+{
+   STATIC_ASSERT(RT_ALIGN_MASK == 7);
+
+   jit_arm64_get(blob, __X0, ir->arg1);
+
+   // Fast path: allocate from TLAB
+   LDRW(__X1, TLAB_REG, offsetof(tlab_t, alloc));
+   ADDW(__X2, __X1, __X0);
+   ADDWI(__X2, __X2, RT_ALIGN_MASK);
+   LSRWI(__X2, __X2, 3);
+   LSLWI(__X2, __X2, 3);
+   LDRW(__X3, TLAB_REG, offsetof(tlab_t, limit));
+   CMPW(__X2, __X3);
+   uint32_t *slow = a64_forward(blob);
+   B_COND(A64_HI, 0);
+   STRW(__X2, TLAB_REG, offsetof(tlab_t, alloc));
+   ADDI(__X0, TLAB_REG, offsetof(tlab_t, data));
+   ADD(__X0, __X0, __X1);
+   uint32_t *done = a64_forward(blob);
+   B(0);
+
+   // Slow path: call into runtime
+   a64_resolve(blob, slow);
+   SUBI(__X1, __FP, -ANCHOR_OFFSET);
+   a64_call(blob, __nvc_mspace_alloc);
+
+   a64_resolve(blob, done);
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_macro_galloc(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   SUBI(__X1, __FP, -ANCHOR_OFFSET);
+   a64_call(blob, __nvc_mspace_alloc);
+
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_macro_bzero(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   jit_arm64_get_reg(blob, __X2, ir->result);
+   MOV(__X1, __XZR);
+   a64_call(blob, memset);
+}
+
+static void jit_arm64_macro_move(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   jit_arm64_get(blob, __X1, ir->arg2);
+   jit_arm64_get_reg(blob, __X2, ir->result);
+   a64_call(blob, memmove);
+}
+
+static void jit_arm64_macro_memset(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   jit_arm64_get(blob, __X1, ir->arg2);
+   jit_arm64_get_reg(blob, __X2, ir->result);
+
+   if (ir->size == JIT_SZ_8 || ir->size == JIT_SZ_UNSPEC) {
+      a64_call(blob, memset);
+      return;
+   }
+
+   const int bytes = jit_arm64_bits(ir) / 8;
+
+   uint32_t *done = a64_forward(blob);
+   CBZ(__X2, 0);
+
+   switch (ir->size) {
+   case JIT_SZ_16: STRH(__X1, __X0); break;
+   case JIT_SZ_32: STRW(__X1, __X0, 0); break;
+   default: STR(__X1, __X0, 0); break;
+   }
+   ADDI(__X0, __X0, bytes);
+   SUBSI(__X2, __X2, bytes);
+   B_COND(A64_GT, -3);
+
+   a64_resolve(blob, done);
+}
+
+static void jit_arm64_macro_getpriv(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_func_t *f = jit_get_func(blob->func->jit, ir->arg1.handle);
+   void **ptr = jit_get_privdata_ptr(blob->func->jit, f);
+
+   a64_mov_imm(blob, __X16, (uintptr_t)ptr);
+   LDR(__X0, __X16, 0);
+
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_macro_putpriv(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_func_t *f = jit_get_func(blob->func->jit, ir->arg1.handle);
+   void **ptr = jit_get_privdata_ptr(blob->func->jit, f);
+
+   jit_arm64_get(blob, __X0, ir->arg2);
+
+   a64_mov_imm(blob, __X16, (uintptr_t)ptr);
+   STR(__X0, __X16, 0);
+}
+
+static void jit_arm64_macro_case(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   jit_arm64_get_reg(blob, __X1, ir->result);
+
+   CMP(__X0, __X1);
+   B_COND(A64_EQ, 0);
+
+   code_blob_patch(blob, ir->arg2.label, jit_arm64_patch);
+}
+
+static void jit_arm64_macro_exp(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X1, ir->arg1);
+   jit_arm64_get(blob, __X2, ir->arg2);
+
+   a64_mov_imm(blob, __X0, 1);
+   CBZ(__X2, 6);
+   TBZ(__X2, 0, 2);
+   MUL(__X0, __X0, __X1);
+   MUL(__X1, __X1, __X1);
+   LSRI(__X2, __X2, 1);
+   CBNZ(__X2, -4);
+
+   jit_arm64_put(blob, ir->result, __X0);
+}
+
+static void jit_arm64_macro_fexp(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get_float(blob, __D0, __X0, ir->arg1);
+   jit_arm64_get_float(blob, __D1, __X1, ir->arg2);
+
+   a64_call(blob, pow);
+
+   jit_arm64_put_float(blob, ir->result, __D0);
+}
+
+static void jit_arm64_macro_trim(code_blob_t *blob, jit_ir_t *ir)
+{
+   const ptrdiff_t off = offsetof(jit_anchor_t, watermark);
+   LDURW(__X9, __FP, ANCHOR_OFFSET + off);
+   STRW(__X9, TLAB_REG, offsetof(tlab_t, alloc));
+}
+
+static void jit_arm64_macro_pack(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   jit_arm64_get(blob, __X1, ir->arg2);
+   MOV(__X2, ARGS_REG);
+   a64_call(blob, __nvc_pack);
+}
+
+static void jit_arm64_macro_unpack(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_get(blob, __X0, ir->arg1);
+   jit_arm64_get(blob, __X1, ir->arg2);
+   MOV(__X2, ARGS_REG);
+   a64_call(blob, __nvc_unpack);
+}
+
+static void jit_arm64_macro_vec4op(code_blob_t *blob, jit_ir_t *ir)
+{
+   jit_arm64_set_anchor_irpos(blob, ir);
+
+   a64_mov_imm(blob, __X0, ir->arg1.int64);
+   SUBI(__X1, __FP, -ANCHOR_OFFSET);
+   MOV(__X2, ARGS_REG);
+   a64_mov_imm(blob, __X3, ir->arg2.int64);
+   a64_call(blob, __nvc_vec4op);
+}
+
+static void jit_arm64_op(code_blob_t *blob, jit_arm64_state_t *state,
+                         jit_ir_t *ir)
+{
+   switch (ir->op) {
+   case J_RECV:
+      jit_arm64_recv(blob, ir);
+      break;
+   case J_SEND:
+      jit_arm64_send(blob, ir);
+      break;
+   case J_ADD:
+      jit_arm64_addsub(blob, ir, false);
+      break;
+   case J_SUB:
+      jit_arm64_addsub(blob, ir, true);
+      break;
+   case J_MUL:
+      jit_arm64_mul(blob, ir);
+      break;
+   case J_DIV:
+      jit_arm64_divrem(blob, ir, false);
+      break;
+   case J_REM:
+      jit_arm64_divrem(blob, ir, true);
+      break;
+   case J_NEG:
+      jit_arm64_neg(blob, ir);
+      break;
+   case J_NOT:
+      jit_arm64_not(blob, ir);
+      break;
+   case J_AND:
+   case J_OR:
+   case J_XOR:
+      jit_arm64_logical(blob, ir);
+      break;
+   case J_SHL:
+   case J_SHR:
+   case J_ASR:
+      jit_arm64_shift(blob, ir);
+      break;
+   case J_CLAMP:
+      jit_arm64_clamp(blob, ir);
+      break;
+   case J_MOV:
+   case J_LEA:
+      jit_arm64_mov(blob, ir);
+      break;
+   case J_DEBUG:
+   case J_NOP:
+      break;
+   case J_JUMP:
+      jit_arm64_jump(blob, ir);
+      break;
+   case J_RET:
+      jit_arm64_ret(blob, ir);
+      break;
+   case J_LOAD:
+   case J_ULOAD:
+      jit_arm64_load(blob, ir);
+      break;
+   case J_STORE:
+      jit_arm64_store(blob, ir);
+      break;
+   case J_CMP:
+   case J_CCMP:
+      jit_arm64_cmp(blob, ir);
+      break;
+   case J_CSET:
+      jit_arm64_cset(blob, ir);
+      break;
+   case J_CSEL:
+      jit_arm64_csel(blob, ir);
+      break;
+   case J_CALL:
+      jit_arm64_call(blob, state, ir);
+      break;
+   case J_TRAP:
+      BRK();
+      break;
+   case J_FADD:
+   case J_FSUB:
+   case J_FMUL:
+   case J_FDIV:
+      jit_arm64_fbinary(blob, ir);
+      break;
+   case J_FNEG:
+      jit_arm64_fneg(blob, ir);
+      break;
+   case J_FCMP:
+   case J_FCCMP:
+      jit_arm64_fcmp(blob, ir);
+      break;
+   case J_FCVTNS:
+      jit_arm64_fcvtns(blob, ir);
+      break;
+   case J_SCVTF:
+      jit_arm64_scvtf(blob, ir);
+      break;
+   case MACRO_EXIT:
+      jit_arm64_macro_exit(blob, ir);
+      break;
+   case MACRO_SALLOC:
+      jit_arm64_macro_salloc(blob, ir);
+      break;
+   case MACRO_LALLOC:
+      jit_arm64_macro_lalloc(blob, ir);
+      break;
+   case MACRO_GALLOC:
+      jit_arm64_macro_galloc(blob, ir);
+      break;
+   case MACRO_BZERO:
+      jit_arm64_macro_bzero(blob, ir);
+      break;
+   case MACRO_COPY:
+   case MACRO_MOVE:
+      jit_arm64_macro_move(blob, ir);
+      break;
+   case MACRO_MEMSET:
+      jit_arm64_macro_memset(blob, ir);
+      break;
+   case MACRO_GETPRIV:
+      jit_arm64_macro_getpriv(blob, ir);
+      break;
+   case MACRO_PUTPRIV:
+      jit_arm64_macro_putpriv(blob, ir);
+      break;
+   case MACRO_CASE:
+      jit_arm64_macro_case(blob, ir);
+      break;
+   case MACRO_EXP:
+      jit_arm64_macro_exp(blob, ir);
+      break;
+   case MACRO_FEXP:
+      jit_arm64_macro_fexp(blob, ir);
+      break;
+   case MACRO_TRIM:
+      jit_arm64_macro_trim(blob, ir);
+      break;
+   case MACRO_PACK:
+      jit_arm64_macro_pack(blob, ir);
+      break;
+   case MACRO_UNPACK:
+      jit_arm64_macro_unpack(blob, ir);
+      break;
+   case MACRO_VEC4OP:
+      jit_arm64_macro_vec4op(blob, ir);
+      break;
+   default:
+      jit_dump_with_mark(blob->func, ir - blob->func->irbuf);
+      fatal_trace("unhandled opcode %s in arm64 backend",
+                  jit_op_name(ir->op));
+   }
+}
+
+static void jit_arm64_tier_up(jit_func_t *f)
+{
+   if (f->next_tier != NULL)
+      jit_tier_up(f);
+}
+
+static bool jit_arm64_can_compile(jit_func_t *f)
+{
+   if (f->nregs > MAX_FRAME_REGS || f->nirs > MAX_FUNC_IRS)
+      return false;
+
+   for (int i = 0; i < f->nirs; i++) {
+      switch (f->irbuf[i].op) {
+      case MACRO_REEXEC:
+      case MACRO_SADD:
+      case MACRO_VEC2OP:
+         return false;   // Leave these to the next tier
+      default:
+         break;
+      }
+   }
+
+   return true;
+}
+
+static void jit_arm64_cgen(jit_t *j, jit_handle_t handle, void *context)
+{
+   jit_arm64_state_t *state = context;
+
+   jit_func_t *f = jit_get_func(j, handle);
+
+#ifdef DEBUG
+   const char *only = getenv("NVC_JIT_ONLY");
+   if (only != NULL && !icmp(f->name, only))
+      return;
+#endif
+
+   if (!jit_arm64_can_compile(f))
+      return;
+
+   code_blob_t *blob = code_blob_new(state->code, f->name, 0);
+   if (blob == NULL)
+      return;
+
+   blob->func = f;
+
+   // Frame layout
+   //
+   //       |-------------------|
+   //    +8 | Caller's LR       |
+   //     0 | Saved FP          |    <--- FP
+   //       |-------------------|
+   //    -8 | Saved X20         |
+   //   -16 | Saved X19         |
+   //   -24 | Saved X22         |
+   //   -32 | Saved X21         |
+   //   -36 | TLAB watermark    |
+   //   -40 | IR position       |
+   //   -48 | Function pointer  |
+   //   -56 | Caller's anchor   |    <--- Frame anchor
+   //       |-------------------|    <--- End of fixed frame
+   //       | Local variables   |
+   //       .                   .
+   //       |-------------------|
+   //       | JIT registers     |
+   //       .                   .
+   //       |-------------------|    <--- SP
+
+   STATIC_ASSERT(offsetof(jit_anchor_t, caller) == 0);
+   STATIC_ASSERT(offsetof(jit_anchor_t, func) == 8);
+   STATIC_ASSERT(offsetof(jit_anchor_t, irpos) == 16);
+   STATIC_ASSERT(offsetof(jit_anchor_t, watermark) == 20);
+
+   const size_t framesz =
+      ALIGN_UP(f->nregs * sizeof(int64_t) + f->framesz, 16)
+      + FRAME_FIXED_SIZE;
+
+   STP_PRE(__FP, __LR, __SP, -16);
+   MOVSP(__FP, __SP);
+
+   if (framesz < 4096)
+      SUBI(__SP, __SP, framesz);
+   else {
+      a64_mov_imm(blob, __X16, framesz);
+      SUBX(__SP, __SP, __X16);
+   }
+
+   // Callee saves
+   STP(19, 20, __FP, -16);
+   STP(21, 22, __FP, -32);
+
+   MOV(ARGS_REG, __X2);
+   MOV(TLAB_REG, __X3);
+   MOV(FLAGS_REG, __XZR);
+
+   // Build frame anchor
+   STURX(__X1, __FP, ANCHOR_OFFSET);
+   STURX(__X0, __FP, ANCHOR_OFFSET + 8);
+   STURW(__XZR, __FP, ANCHOR_OFFSET + 16);
+   LDRW(__X9, TLAB_REG, offsetof(tlab_t, alloc));
+   STURW(__X9, __FP, ANCHOR_OFFSET + 20);
+
+   if (f->next_tier != NULL) {
+      // Count calls until the function is hot enough for the next
+      // tier: the counter is shared with other threads so only the one
+      // which takes it to zero calls jit_tier_up
+      const ptrdiff_t off = offsetof(jit_func_t, hotness);
+      ADDI(__X16, __X0, off);
+      LDXRW(__X10, __X16);
+      SUBSWI(__X10, __X10, 1);
+      STXRW(__X9, __X10, __X16);
+      CBNZ(__X9, -3);
+      uint32_t *skip = a64_forward(blob);
+      B_COND(A64_NE, 0);
+      a64_call(blob, jit_arm64_tier_up);
+      a64_resolve(blob, skip);
+   }
+
+   for (int i = 0; i < f->nirs; i++) {
+      if (f->irbuf[i].target)
+         code_blob_mark(blob, i);
+      code_blob_print_ir(blob, &(f->irbuf[i]));
+      jit_arm64_op(blob, state, &(f->irbuf[i]));
+   }
+
+   code_blob_mark(blob, JIT_LABEL_INVALID);
+
+   LDP(19, 20, __FP, -16);
+   LDP(21, 22, __FP, -32);
+   MOVSP(__SP, __FP);
+   LDP_POST(__FP, __LR, __SP, 16);
+   RET();
+
+   f->stats.code_bytes = code_blob_finalise(blob, &(f->entry));
+}
+
+static void *jit_arm64_init(jit_t *jit)
+{
+   jit_arm64_state_t *state = xcalloc(sizeof(jit_arm64_state_t));
+   state->jit  = jit;
+   state->code = code_cache_new();
+
+   return state;
+}
+
+static void jit_arm64_cleanup(void *context)
+{
+   jit_arm64_state_t *state = context;
+
+   code_cache_free(state->code);
+   free(state);
+}
+
+static const jit_plugin_t jit_arm64 = {
+   .init    = jit_arm64_init,
+   .cgen    = jit_arm64_cgen,
+   .cleanup = jit_arm64_cleanup
+};
+
+void jit_register_native_plugin(jit_t *j)
+{
+   const int threshold = opt_get_int(OPT_NATIVE_THRESHOLD);
+   if (threshold > 0)
+      jit_add_tier(j, threshold, &jit_arm64);
+   else if (threshold < 0)
+      warnf("invalid NVC_NATIVE_THRESHOLD setting %d", threshold);
+}
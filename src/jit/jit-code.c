@@ -23,6 +23,7 @@
 #include "jit/jit-priv.h"
 #include "option.h"
 #include "printf.h"
+#include "stats.h"
 #include "thread.h"
 
 #include <assert.h>
@@ -562,7 +563,7 @@ code_blob_t *code_blob_new(code_cache_t *code, ident_t name, size_t hint)
    return blob;
 }
 
-void code_blob_finalise(code_blob_t *blob, jit_entry_fn_t *entry)
+size_t code_blob_finalise(code_blob_t *blob, jit_entry_fn_t *entry)
 {
    code_span_t *span = blob->span;
    span->size = blob->wptr - span->base;
@@ -580,7 +581,7 @@ void code_blob_finalise(code_blob_t *blob, jit_entry_fn_t *entry)
       freespan->size = freespan->base - span->base;
       freespan->base = span->base;
       free(blob);
-      return;
+      return 0;
    }
    else if (span->size == 0)
       fatal_trace("code span %s is empty", istr(span->name));
@@ -602,10 +603,13 @@ void code_blob_finalise(code_blob_t *blob, jit_entry_fn_t *entry)
    store_release(entry, (jit_entry_fn_t)span->entry);
 
    DEBUG_ONLY(relaxed_add(&span->owner->used, span->size));
+   stat_add(STAT_CODE_BYTES, span->size);
    free(blob);
 
    if (opt_get_int(OPT_PERF_MAP))
       code_write_perf_map(span);
+
+   return span->size;
 }
 
 __attribute__((cold, noinline))
@@ -869,6 +873,16 @@ static void *code_emit_trampoline(code_blob_t *blob, void *dest)
    }
 }
 
+static void *code_resolve_external(code_blob_t *blob, shash_t *external,
+                                   const char *name)
+{
+   void *ptr = shash_get(external, name);
+   if (ptr == NULL && blob->resolve != NULL)
+      ptr = (*blob->resolve)(name, blob->resolve_ctx);
+
+   return ptr;
+}
+
 #if !defined __MINGW32__ && !defined __APPLE__
 static void *code_emit_got(code_blob_t *blob, void *dest)
 {
@@ -955,7 +969,7 @@ static void code_load_pe(code_blob_t *blob, const void *data, size_t size)
             ptr = load_addr[sym->SectionNumber - 1] + sym->Value;
          }
          else
-            ptr = shash_get(external, name);
+            ptr = code_resolve_external(blob, external, name);
 
          if (ptr == NULL && icmp(blob->span->name, name))
             ptr = blob->span->base;
@@ -1110,7 +1124,8 @@ static void code_load_macho(code_blob_t *blob, const void *data, size_t size)
             if (nl->n_type & N_EXT) {
                if (icmp(blob->span->name, name + 1))
                   ptr = blob->span->base;
-               else if ((ptr = shash_get(external, name + 1)) == NULL)
+               else if ((ptr = code_resolve_external(blob, external,
+                                                     name + 1)) == NULL)
                   fatal_trace("failed to resolve symbol %s", name + 1);
             }
             else if (nl->n_sect != NO_SECT)
@@ -1288,7 +1303,8 @@ static void code_load_elf(code_blob_t *blob, const void *data, size_t size)
          case STT_NOTYPE:
          case STT_FUNC:
             if (sym->st_shndx == 0)
-               ptr = shash_get(external, strtab + sym->st_name);
+               ptr = code_resolve_external(blob, external,
+                                           strtab + sym->st_name);
             else
                ptr = load_addr[sym->st_shndx] + sym->st_value;
             break;
@@ -29,10 +29,13 @@
 #include "mir/mir-unit.h"
 #include "object.h"
 #include "option.h"
+#include "printf.h"
 #include "rt/model.h"
 #include "rt/mspace.h"
 #include "rt/structs.h"
+#include "stats.h"
 #include "thread.h"
+#include "timeline.h"
 #include "tree.h"
 #include "type.h"
 #include "vcode.h"
@@ -45,9 +48,11 @@
 #include <string.h>
 #include <unistd.h>
 
-#define FUNC_HASH_SZ    1024
-#define FUNC_LIST_SZ    512
-#define COMPILE_TIMEOUT 10000
+#define FUNC_HASH_SZ     1024
+#define FUNC_LIST_SZ     512
+#define COMPILE_TIMEOUT  10000
+#define STATS_TOP        20
+#define TRACE_SITE_LIMIT 10    // Traces per call stack for notes and warnings
 
 typedef struct _jit_tier {
    jit_tier_t    *next;
@@ -61,6 +66,12 @@ typedef struct {
    jit_func_t *items[0];
 } func_array_t;
 
+typedef struct {
+   jit_func_t *func;
+   jit_tier_t *tier;
+   uint64_t    queued_us;
+} pending_cgen_t;
+
 typedef struct _jit {
    chash_t          *index;
    mspace_t         *mspace;
@@ -76,6 +87,10 @@ typedef struct _jit {
    void             *interrupt_ctx;
    unit_registry_t  *registry;
    mir_context_t    *mir;
+   nvc_lock_t        pending_lock;
+   A(pending_cgen_t) pending;
+   chash_t          *tracesites;
+   unsigned          omitted_traces;
 } jit_t;
 
 static void jit_transition(jit_thread_local_t *thread, jit_t *j,
@@ -126,6 +141,7 @@ jit_t *jit_new(unit_registry_t *ur, mir_context_t *mc)
    jit_t *j = xcalloc(sizeof(jit_t));
    j->registry    = ur;
    j->index       = chash_new(FUNC_HASH_SZ);
+   j->tracesites  = chash_new(64);
    j->mspace      = mspace_new(opt_get_size(OPT_HEAP_SIZE));
    j->exit_status = INT_MIN;
    j->mir         = mc;
@@ -153,15 +169,60 @@ static void jit_free_func(jit_func_t *f)
    free(f);
 }
 
+static int jit_stats_cmp(const void *a, const void *b)
+{
+   const jit_func_t *fa = *(const jit_func_t **)a;
+   const jit_func_t *fb = *(const jit_func_t **)b;
+
+   const uint64_t ta = fa->stats.irgen_us + fa->stats.opt_us
+      + fa->stats.cgen_us;
+   const uint64_t tb = fb->stats.irgen_us + fb->stats.opt_us
+      + fb->stats.cgen_us;
+
+   return ta < tb ? 1 : (ta > tb ? -1 : 0);
+}
+
+static void jit_print_stats(jit_t *j)
+{
+   jit_func_t **sorted = xmalloc_array(j->next_handle, sizeof(jit_func_t *));
+   int count = 0;
+   for (int i = 0; i < j->next_handle; i++) {
+      jit_func_t *f = j->funcs->items[i];
+      if (f->irbuf != NULL)
+         sorted[count++] = f;
+   }
+
+   qsort(sorted, count, sizeof(jit_func_t *), jit_stats_cmp);
+
+   nvc_printf("\n$bold$JIT compile time$$ (%d units)\n\n", count);
+   nvc_printf("   %10s %10s %10s %10s %10s  %s\n", "Irgen (us)",
+              "Opt (us)", "Cgen (us)", "Bytes", "Interp", "Name");
+
+   for (int i = 0; i < count && i < STATS_TOP; i++) {
+      const jit_func_stats_t *s = &(sorted[i]->stats);
+      nvc_printf("   %10u %10u %10u %10u %10u  %s\n", s->irgen_us,
+                 s->opt_us, s->cgen_us, s->code_bytes, s->interp_calls,
+                 istr(sorted[i]->name));
+   }
+
+   free(sorted);
+}
+
 void jit_free(jit_t *j)
 {
    store_release(&j->shutdown, true);
    async_barrier();
 
+   if (opt_get_int(OPT_JIT_LOG))
+      jit_print_stats(j);
+
    for (int i = 0; i < j->next_handle; i++)
       jit_free_func(j->funcs->items[i]);
    free(j->funcs);
 
+   assert(j->pending.count == 0);
+   ACLEAR(j->pending);
+
    for (jit_tier_t *it = j->tiers, *tmp; it; it = tmp) {
       tmp = it->next;
       (*it->plugin.cleanup)(it->context);
@@ -170,8 +231,14 @@ void jit_free(jit_t *j)
 
    diag_remove_hint_fn(jit_diag_cb, j);
 
+   if (j->omitted_traces > 0)
+      notef("stack trace omitted from %u notes and warnings after the "
+            "first %d from the same call stack", j->omitted_traces,
+            TRACE_SITE_LIMIT);
+
    mspace_destroy(j->mspace);
    chash_free(j->index);
+   chash_free(j->tracesites);
    free(j);
 }
 
@@ -344,6 +411,40 @@ jit_handle_t jit_compile(jit_t *j, ident_t name)
    return handle;
 }
 
+static void jit_async_irgen(void *context, void *arg)
+{
+   jit_t *j = context;
+   jit_func_t *f = arg;
+
+   if (jit_is_shutdown(j))
+      return;
+   else if (load_acquire(&(f->state)) != JIT_FUNC_PLACEHOLDER)
+      return;   // Already compiled or being compiled by another thread
+
+   // This is only speculative so a missing unit should be reported
+   // later by the thread that actually calls the function
+   if (mir_get_unit(j->mir, f->name) == NULL) {
+      if (j->registry == NULL)
+         return;
+
+      SCOPED_LOCK(j->lock);
+      if (!unit_registry_query(j->registry, f->name))
+         return;
+   }
+
+   jit_fill_irbuf(f);
+}
+
+void jit_precompile(jit_t *j, jit_handle_t handle)
+{
+   if (!opt_get_int(OPT_JIT_ASYNC))
+      return;
+
+   jit_func_t *f = jit_get_func(j, handle);
+   if (load_acquire(&(f->state)) == JIT_FUNC_PLACEHOLDER)
+      async_do(jit_async_irgen, j, f);
+}
+
 void *jit_link(jit_t *j, jit_handle_t handle)
 {
    if (handle == JIT_HANDLE_INVALID)
@@ -518,6 +619,29 @@ jit_stack_trace_t *jit_stack_trace(void)
    return stack;
 }
 
+static bool jit_want_trace(jit_t *j)
+{
+   // Building and printing the trace dominates the cost of notes and
+   // warnings repeated many times from the same place so only attach
+   // it to the first few from each distinct call stack
+   uint64_t sig = 0;
+   for (jit_anchor_t *a = jit_thread_local()->anchor; a; a = a->caller)
+      sig = mix_bits_64(sig ^ (uintptr_t)a->func ^ a->irpos);
+
+   const void *key = (void *)(uintptr_t)((sig << 3) | 8);
+
+   for (;;) {
+      void *old = chash_get(j->tracesites, key);
+      const uintptr_t count = (uintptr_t)old;
+      if (count >= TRACE_SITE_LIMIT) {
+         relaxed_add(&j->omitted_traces, 1);
+         return false;
+      }
+      else if (chash_cas(j->tracesites, key, old, (void *)(count + 1)) == old)
+         return true;
+   }
+}
+
 static void jit_diag_cb(diag_t *d, void *arg)
 {
    jit_t *j = arg;
@@ -528,6 +652,8 @@ static void jit_diag_cb(diag_t *d, void *arg)
       diag_suppress(d, true);
       return;
    }
+   else if (diag_level(d, NULL) < DIAG_ERROR && !jit_want_trace(j))
+      return;
 
    jit_stack_trace_t *stack LOCAL = jit_stack_trace();
 
@@ -833,27 +959,76 @@ bool jit_exit_status(jit_t *j, int *status)
       return false;
 }
 
+static void jit_cgen(jit_t *j, jit_func_t *f, jit_tier_t *tier)
+{
+   TIMELINE_BEGIN("codegen", istr(f->name));
+
+   const uint64_t start_us = get_timestamp_us();
+   (*tier->plugin.cgen)(j, f->handle, tier->context);
+   f->stats.cgen_us += get_timestamp_us() - start_us;
+
+   TIMELINE_END("codegen");
+}
+
 static void jit_async_cgen(void *context, void *arg)
 {
-   jit_func_t *f = context;
-   jit_tier_t *tier = arg;
+   jit_t *j = context;
+
+   // Each task compiles whichever pending function has been most active
+   // since it was queued rather than the oldest one
+   pending_cgen_t next;
+   {
+      SCOPED_LOCK(j->pending_lock);
+      assert(j->pending.count > 0);
+
+      int best = 0;
+      unsigned maxheat = relaxed_load(&j->pending.items[0].func->heat);
+      for (int i = 1; i < j->pending.count; i++) {
+         const unsigned heat = relaxed_load(&j->pending.items[i].func->heat);
+         if (heat > maxheat) {
+            best = i;
+            maxheat = heat;
+         }
+      }
+
+      next = j->pending.items[best];
+      j->pending.items[best] = APOP(j->pending);
+   }
+
+   if (!jit_is_shutdown(j)) {
+      jit_cgen(j, next.func, next.tier);
 
-   if (!jit_is_shutdown(f->jit))
-      (*tier->plugin.cgen)(f->jit, f->handle, tier->context);
+      // Latency from the tier-up request until the new code is installed
+      stat_sample(STAT_CGEN_LATENCY_US, get_timestamp_us() - next.queued_us);
+   }
 }
 
 void jit_tier_up(jit_func_t *f)
 {
-   assert(f->hotness <= 0);
+   // Called only by the thread whose decrement took the counter to
+   // zero but others may have decremented it again since
    assert(f->next_tier != NULL);
 
-   if (opt_get_int(OPT_JIT_ASYNC))
-      async_do(jit_async_cgen, f, f->next_tier);
-   else
-      (f->next_tier->plugin.cgen)(f->jit, f->handle, f->next_tier->context);
+   // Start counting towards the following tier before generating code
+   // so the code generator can see whether it needs to count calls
+   jit_tier_t *tier = f->next_tier;
+   f->next_tier = tier->next;
+   f->hotness   = tier->next ? tier->next->threshold : 0;
+
+   stat_add(STAT_TIER_UPS, 1);
+
+   if (opt_get_int(OPT_JIT_ASYNC)) {
+      jit_t *j = f->jit;
+      {
+         SCOPED_LOCK(j->pending_lock);
+         const pending_cgen_t p = { f, tier, get_timestamp_us() };
+         APUSH(j->pending, p);
+      }
 
-   f->hotness   = 0;
-   f->next_tier = NULL;
+      async_do(jit_async_cgen, j, NULL);
+   }
+   else
+      jit_cgen(f->jit, f, tier);
 }
 
 void jit_add_tier(jit_t *j, int threshold, const jit_plugin_t *plugin)
@@ -963,6 +1138,7 @@ jit_handle_t jit_assemble(jit_t *j, ident_t name, const char *text)
       { "FDIV",    J_FDIV,       1, 2 },
       { "FNEG",    J_FNEG,       1, 1 },
       { "FCMP",    J_FCMP,       0, 2 },
+      { "FCCMP",   J_FCCMP,      0, 2 },
       { "FCVTNS",  J_FCVTNS,     1, 1 },
       { "SCVTF",   J_SCVTF,      1, 1 },
       { "$EXIT",   MACRO_EXIT,   0, 1 },
@@ -1273,6 +1449,31 @@ void jit_reset(jit_t *j)
    jit_reset_exit_status(j);
 }
 
+void jit_get_tier_stats(jit_t *j, jit_tier_stats_t *stats)
+{
+   memset(stats, '\0', sizeof(jit_tier_stats_t));
+
+   {
+      SCOPED_LOCK(j->lock);
+
+      for (int i = 0; i < j->next_handle; i++) {
+         jit_func_t *f = j->funcs->items[i];
+         if (f->irbuf == NULL)
+            continue;   // Not yet compiled to JIT IR
+
+         stats->functions++;
+
+         if (load_acquire(&(f->entry)) == jit_interp)
+            stats->interpreted++;
+         else
+            stats->compiled++;
+      }
+   }
+
+   SCOPED_LOCK(j->pending_lock);
+   stats->pending = j->pending.count;
+}
+
 jit_t *jit_for_thread(void)
 {
    jit_thread_local_t *thread = jit_thread_local();
@@ -417,9 +417,10 @@ void __nvc_do_exit(jit_exit_t which, jit_anchor_t *anchor, jit_scalar_t *args,
          int32_t       count     = args[4].integer;
          int64_t       after     = args[5].integer;
          int64_t       reject    = args[6].integer;
+         int32_t       kind      = args[7].integer;
 
          x_transfer_signal(target, toffset, source, soffset,
-                           count, after, reject);
+                           count, after, reject, kind);
       }
       break;
 
@@ -872,6 +873,15 @@ void __nvc_do_exit(jit_exit_t which, jit_anchor_t *anchor, jit_scalar_t *args,
       }
       break;
 
+   case JIT_EXIT_AND_TRIGGER:
+      {
+         void *left  = args[0].pointer;
+         void *right = args[1].pointer;
+
+         args[0].pointer = x_and_trigger(left, right);
+      }
+      break;
+
    case JIT_EXIT_CMP_TRIGGER:
       {
          sig_shared_t *shared = args[0].pointer;
@@ -892,6 +902,16 @@ void __nvc_do_exit(jit_exit_t which, jit_anchor_t *anchor, jit_scalar_t *args,
       }
       break;
 
+   case JIT_EXIT_EDGE_TRIGGER:
+      {
+         sig_shared_t *shared = args[0].pointer;
+         int32_t       offset = args[1].integer;
+         int32_t       edge   = args[2].integer;
+
+         args[0].pointer = x_edge_trigger(shared, offset, edge);
+      }
+      break;
+
    case JIT_EXIT_ADD_TRIGGER:
       {
          void *trigger = args[0].pointer;
@@ -944,6 +964,14 @@ void __nvc_do_exit(jit_exit_t which, jit_anchor_t *anchor, jit_scalar_t *args,
       }
       break;
 
+   case JIT_EXIT_BZERO:
+      {
+         void *ptr = args[0].pointer;
+         size_t size = args[1].integer;
+         mspace_bzero(jit_get_mspace(thread->jit), ptr, size);
+      }
+      break;
+
    default:
       fatal_trace("unhandled exit %s", jit_exit_name(which));
    }
@@ -1446,6 +1474,64 @@ object_t *__nvc_get_object(const char *unit, ptrdiff_t offset)
    return object_from_locus(ident_new(unit), offset, lib_load_handler);
 }
 
+// Gather the low bit of each byte in a little-endian word with the
+// first byte ending up in the most significant position
+static inline uint64_t pack_byte(uint64_t word)
+{
+   return ((word & UINT64_C(0x0101010101010101))
+           * UINT64_C(0x8040201008040201)) >> 56;
+}
+
+// Inverse of pack_byte: spread eight bits into the low bit of each byte
+static inline uint64_t unpack_byte(uint64_t bits)
+{
+   const uint64_t spread = ((bits & 0xff) * UINT64_C(0x0101010101010101))
+      & UINT64_C(0x0102040810204080);
+   return ((spread + UINT64_C(0x7f7f7f7f7f7f7f7f)) >> 7)
+      & UINT64_C(0x0101010101010101);
+}
+
+static void pack_bits(const uint8_t *src, int size, uint64_t *abits,
+                      uint64_t *bbits)
+{
+   // Work backwards from the least significant element eight at a time
+   const uint8_t *p = src + size;
+   int pos = 0;
+   for (; pos + 8 <= size; pos += 8) {
+      uint64_t word;
+      memcpy(&word, (p -= 8), sizeof(uint64_t));
+
+      abits[pos / 64] |= pack_byte(word) << (pos % 64);
+      bbits[pos / 64] |= pack_byte(word >> 1) << (pos % 64);
+   }
+
+   for (; pos < size; pos++) {
+      const uint8_t elem = *--p;
+      abits[pos / 64] |= (uint64_t)(elem & 1) << (pos % 64);
+      bbits[pos / 64] |= (uint64_t)((elem >> 1) & 1) << (pos % 64);
+   }
+}
+
+static void unpack_bits(const uint64_t *abits, const uint64_t *bbits,
+                        int size, uint8_t strength, uint8_t *dest)
+{
+   const uint64_t fill = strength * UINT64_C(0x0101010101010101);
+
+   int pos = 0;
+   for (; pos + 8 <= size; pos += 8) {
+      const uint64_t a = abits[pos / 64] >> (pos % 64);
+      const uint64_t b = bbits[pos / 64] >> (pos % 64);
+      const uint64_t word = unpack_byte(a) | (unpack_byte(b) << 1) | fill;
+      memcpy(dest + size - pos - 8, &word, sizeof(uint64_t));
+   }
+
+   for (; pos < size; pos++) {
+      const uint64_t abit = (abits[pos / 64] >> (pos % 64)) & 1;
+      const uint64_t bbit = (bbits[pos / 64] >> (pos % 64)) & 1;
+      dest[size - pos - 1] = abit | (bbit << 1) | strength;
+   }
+}
+
 DLLEXPORT
 void __nvc_pack(const uint8_t *src, int32_t size, jit_scalar_t *args)
 {
@@ -1457,22 +1543,14 @@ void __nvc_pack(const uint8_t *src, int32_t size, jit_scalar_t *args)
       for (int i = 0; i < nwords * 2; i++)
          mem[i] = 0;
 
-      for (int i = 0; i < size; i++) {
-         const int pos = size - 1 - i;
-         abits[pos / 64] |= (uint64_t)(src[i] & 1) << (pos % 64);
-         bbits[pos / 64] |= (uint64_t)((src[i] >> 1) & 1) << (pos % 64);
-      }
+      pack_bits(src, size, abits, bbits);
 
       args[0].pointer = abits;
       args[1].pointer = bbits;
    }
    else {
       uint64_t abits = 0, bbits = 0;
-
-      for (int i = 0; i < size; i++) {
-         abits = (abits << 1) | (src[i] & 1);
-         bbits = (bbits << 1) | ((src[i] >> 1) & 1);
-      }
+      pack_bits(src, size, &abits, &bbits);
 
       args[0].integer = abits;
       args[1].integer = bbits;
@@ -1486,21 +1564,11 @@ void __nvc_unpack(jit_scalar_t aval, jit_scalar_t bval, jit_scalar_t *args)
    size_t size = args[1].integer;
    uint8_t strength = args[2].integer;
 
-   if (size > 64) {
-      const uint64_t *abits = aval.pointer;
-      const uint64_t *bbits = bval.pointer;
-
-      for (int i = 0; i < size; i++) {
-         const uint64_t abit = (abits[i / 64] >> (i % 64)) & 1;
-         const uint64_t bbit = (bbits[i / 64] >> (i % 64)) & 1;
-         dest[size - i - 1] = abit | (bbit << 1) | strength;
-      }
-   }
+   if (size > 64)
+      unpack_bits(aval.pointer, bval.pointer, size, strength, dest);
    else {
-      uint64_t abits = aval.integer;
-      uint64_t bbits = bval.integer;
-
-      for (int i = 0; i < size; i++, abits >>= 1, bbits >>= 1)
-         dest[size - i - 1] = (abits & 1) | ((bbits & 1) << 1) | strength;
+      const uint64_t abits = aval.integer;
+      const uint64_t bbits = bval.integer;
+      unpack_bits(&abits, &bbits, size, strength, dest);
    }
 }
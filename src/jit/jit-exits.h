@@ -35,7 +35,8 @@ void x_sched_waveform(sig_shared_t *ss, uint32_t offset, void *values,
                       int32_t count, int64_t after, int64_t reject);
 void x_transfer_signal(sig_shared_t *target_ss, uint32_t toffset,
                        sig_shared_t *source_ss, uint32_t soffset,
-                       int32_t count, int64_t after, int64_t reject);
+                       int32_t count, int64_t after, int64_t reject,
+                       int32_t kind);
 int32_t x_test_net_event(sig_shared_t *ss, uint32_t offset, int32_t count);
 int32_t x_test_net_active(sig_shared_t *ss, uint32_t offset,
                           int32_t count);
@@ -48,6 +49,7 @@ void x_file_open(int8_t *status, void **_fp, const uint8_t *name_bytes,
                  int32_t name_len, int8_t mode);
 void x_file_write(void **_fp, void *data, int64_t size, int64_t count);
 int64_t x_file_read(void **_fp, void *data, int64_t size, int64_t count);
+ffi_uarray_t *x_file_readline(void **_fp);
 void x_index_fail(int64_t value, int64_t left, int64_t right, int8_t dir,
                   tree_t where, tree_t hint);
 void x_length_fail(int64_t left, int64_t right, int32_t dim, tree_t where);
@@ -98,8 +100,10 @@ void *x_reflect_subtype(void *context, tree_t where,
 void *x_function_trigger(jit_handle_t handle, unsigned nargs,
                          const jit_scalar_t *args);
 rt_trigger_t *x_or_trigger(rt_trigger_t *left, rt_trigger_t *right);
+rt_trigger_t *x_and_trigger(rt_trigger_t *left, rt_trigger_t *right);
 void *x_cmp_trigger(sig_shared_t *ss, uint32_t offset, int64_t right);
 void *x_level_trigger(sig_shared_t *ss, uint32_t offset, int32_t count);
+void *x_edge_trigger(sig_shared_t *ss, uint32_t offset, int32_t edge);
 void x_add_trigger(void *ptr);
 void x_bind_external(tree_t where, jit_handle_t scope, jit_scalar_t *result);
 void x_instance_name(attr_kind_t kind, text_buf_t *tb);
@@ -22,6 +22,7 @@
 #include "jit/jit-priv.h"
 #include "jit/jit.h"
 #include "option.h"
+#include "rt/structs.h"
 #include "thread.h"
 #include "type.h"
 #include "vhpi/vhpi-model.h"
@@ -45,13 +46,20 @@ typedef enum {
    GHDL_ARG_DROP,
    GHDL_ARG_PASS,
    GHDL_ARG_LENGTH,
+   GHDL_ARG_SIGNAL8,    // Pointer to the current value of a signal
+   GHDL_ARG_SIGNAL16,
+   GHDL_ARG_SIGNAL32,
+   GHDL_ARG_SIGNAL64,
 } ghdl_arg_t;
 
+#define GHDL_MAX_DIRECT 6
+
 typedef struct {
    ffi_cif    cif;
    void      *ptr;
    unsigned   nvhdl;
    unsigned   nforeign;
+   bool       direct;
    ghdl_arg_t args[0];
 } ghdl_ffi_t;
 
@@ -339,6 +347,104 @@ static void jit_vhpi_entry(jit_func_t *f, jit_anchor_t *caller,
    thread->anchor = NULL;
 }
 
+static intmax_t ghdl_call_int(void *fn, const intptr_t *a, int nargs)
+{
+   switch (nargs) {
+   case 0: return ((intmax_t (*)(void))fn)();
+   case 1: return ((intmax_t (*)(intptr_t))fn)(a[0]);
+   case 2: return ((intmax_t (*)(intptr_t, intptr_t))fn)(a[0], a[1]);
+   case 3:
+      return ((intmax_t (*)(intptr_t, intptr_t, intptr_t))fn)(
+         a[0], a[1], a[2]);
+   case 4:
+      return ((intmax_t (*)(intptr_t, intptr_t, intptr_t, intptr_t))fn)(
+         a[0], a[1], a[2], a[3]);
+   case 5:
+      return ((intmax_t (*)(intptr_t, intptr_t, intptr_t, intptr_t,
+                            intptr_t))fn)(a[0], a[1], a[2], a[3], a[4]);
+   case 6:
+      return ((intmax_t (*)(intptr_t, intptr_t, intptr_t, intptr_t,
+                            intptr_t, intptr_t))fn)(
+         a[0], a[1], a[2], a[3], a[4], a[5]);
+   default:
+      fatal_trace("too many arguments for direct call");
+   }
+}
+
+static double ghdl_call_real(void *fn, const intptr_t *a, int nargs)
+{
+   switch (nargs) {
+   case 0: return ((double (*)(void))fn)();
+   case 1: return ((double (*)(intptr_t))fn)(a[0]);
+   case 2: return ((double (*)(intptr_t, intptr_t))fn)(a[0], a[1]);
+   case 3:
+      return ((double (*)(intptr_t, intptr_t, intptr_t))fn)(
+         a[0], a[1], a[2]);
+   case 4:
+      return ((double (*)(intptr_t, intptr_t, intptr_t, intptr_t))fn)(
+         a[0], a[1], a[2], a[3]);
+   case 5:
+      return ((double (*)(intptr_t, intptr_t, intptr_t, intptr_t,
+                          intptr_t))fn)(a[0], a[1], a[2], a[3], a[4]);
+   case 6:
+      return ((double (*)(intptr_t, intptr_t, intptr_t, intptr_t,
+                          intptr_t, intptr_t))fn)(
+         a[0], a[1], a[2], a[3], a[4], a[5]);
+   default:
+      fatal_trace("too many arguments for direct call");
+   }
+}
+
+static void *ghdl_signal_data(ghdl_arg_t kind, const jit_scalar_t *args)
+{
+   // Signal arguments are a pointer to the shared signal data followed
+   // by an element offset
+   const sig_shared_t *ss = args[0].pointer;
+   const int scale = 1 << (kind - GHDL_ARG_SIGNAL8);
+   return (void *)ss->data + args[1].integer * scale;
+}
+
+static void ghdl_direct_call(ghdl_ffi_t *gffi, jit_scalar_t *args)
+{
+   // All arguments are passed in integer registers so the function can
+   // be called directly without going through libffi
+   intptr_t a[GHDL_MAX_DIRECT];
+   int opos = 0;
+   for (int ipos = 0; ipos < gffi->nvhdl; ipos++) {
+      switch (gffi->args[ipos]) {
+      case GHDL_ARG_DROP:
+         break;
+      case GHDL_ARG_PASS:
+         a[opos++] = args[ipos].integer;
+         break;
+      case GHDL_ARG_LENGTH:
+         a[opos++] = ffi_array_length(args[ipos].integer);
+         break;
+      default:
+         a[opos++] = (intptr_t)ghdl_signal_data(gffi->args[ipos],
+                                                args + ipos);
+         break;
+      }
+   }
+
+   const ffi_type *rtype = gffi->cif.rtype;
+   if (rtype->type == FFI_TYPE_DOUBLE)
+      args[0].real = ghdl_call_real(gffi->ptr, a, opos);
+   else if (rtype->type == FFI_TYPE_VOID)
+      ghdl_call_int(gffi->ptr, a, opos);
+   else {
+      const intmax_t result = ghdl_call_int(gffi->ptr, a, opos);
+
+      // Only the low bits of the return register are defined
+      switch (rtype->size) {
+      case 1: args[0].integer = (int8_t)result; break;
+      case 2: args[0].integer = (int16_t)result; break;
+      case 4: args[0].integer = (int32_t)result; break;
+      default: args[0].integer = result; break;
+      }
+   }
+}
+
 static void jit_ghdl_entry(jit_func_t *f, jit_anchor_t *caller,
                            jit_scalar_t *args, tlab_t *tlab)
 {
@@ -350,6 +456,8 @@ static void jit_ghdl_entry(jit_func_t *f, jit_anchor_t *caller,
       f->entry = jit_interp;
       jit_interp(f, caller, args, tlab);
    }
+   else if (gffi->direct)
+      ghdl_direct_call(gffi, args);
    else {
       void *aptrs[gffi->nforeign];
       int opos = 0;
@@ -364,6 +472,11 @@ static void jit_ghdl_entry(jit_func_t *f, jit_anchor_t *caller,
             args[ipos].integer = ffi_array_length(args[ipos].integer);
             aptrs[opos++] = &(args[ipos].integer);
             break;
+         default:
+            args[ipos].pointer = ghdl_signal_data(gffi->args[ipos],
+                                                  args + ipos);
+            aptrs[opos++] = &(args[ipos].pointer);
+            break;
          }
       }
 
@@ -462,6 +575,37 @@ static void ghdl_ffi_add_arg(ghdl_ffi_t *gffi, ffi_type **types, tree_t p)
            "VHPIDIRECT calling convention", type_pp(type));
 }
 
+static void ghdl_ffi_add_signal(ghdl_ffi_t *gffi, ffi_type **types,
+                                tree_t p)
+{
+   // Input signals are passed as a read-only pointer to the current
+   // value so large vectors are not copied on each call
+   type_t type = tree_type(p);
+   if (tree_subkind(p) != PORT_IN || !type_is_homogeneous(type)
+       || (type_is_array(type) && dimension_of(type) > 1))
+      jit_msg(tree_loc(p), DIAG_FATAL, "only scalar and one-dimensional "
+              "array SIGNAL parameters of mode IN are supported for "
+              "VHPIDIRECT subprograms using the GHDL calling convention");
+
+   type_t elem = type_is_array(type) ? type_elem_recur(type) : type;
+   switch (type_byte_width(elem)) {
+   case 1: gffi->args[gffi->nvhdl++] = GHDL_ARG_SIGNAL8; break;
+   case 2: gffi->args[gffi->nvhdl++] = GHDL_ARG_SIGNAL16; break;
+   case 4: gffi->args[gffi->nvhdl++] = GHDL_ARG_SIGNAL32; break;
+   default: gffi->args[gffi->nvhdl++] = GHDL_ARG_SIGNAL64; break;
+   }
+   types[gffi->nforeign++] = &ffi_type_pointer;
+
+   gffi->args[gffi->nvhdl++] = GHDL_ARG_DROP;   // Offset
+
+   if (type_is_unconstrained(type)) {
+      gffi->args[gffi->nvhdl++] = GHDL_ARG_DROP;     // Left index
+
+      gffi->args[gffi->nvhdl++] = GHDL_ARG_LENGTH;   // Array length
+      types[gffi->nforeign++] = &ffi_type_sint64;
+   }
+}
+
 static void *ffi_prepare_ghdl(tree_t decl, const char *symbol)
 {
    assert(tree_kind(decl) == T_ATTR_SPEC);
@@ -470,7 +614,7 @@ static void *ffi_prepare_ghdl(tree_t decl, const char *symbol)
    const int nports = tree_ports(sub);
 
    const size_t ghdl_ffi_sz =
-      sizeof(ghdl_ffi_t) + (2 + nports*3) * sizeof(ghdl_arg_t);
+      sizeof(ghdl_ffi_t) + (2 + nports*4) * sizeof(ghdl_arg_t);
    ghdl_ffi_t *gffi =
       jit_mspace_alloc(ghdl_ffi_sz + nports * 2 * sizeof(ffi_type *));
    ffi_type **types = (void *)gffi + ghdl_ffi_sz;
@@ -495,20 +639,22 @@ static void *ffi_prepare_ghdl(tree_t decl, const char *symbol)
    for (int i = 0; i < nports; i++) {
       tree_t p = tree_port(sub, i);
       if (tree_class(p) == C_SIGNAL)
-         jit_msg(tree_loc(p), DIAG_FATAL, "SIGNAL parameters are not "
-                 "supported for VHPIDIRECT subprograms using the GHDL "
-                 "calling convention");
-
-      ghdl_ffi_add_arg(gffi, types, p);
+         ghdl_ffi_add_signal(gffi, types, p);
+      else
+         ghdl_ffi_add_arg(gffi, types, p);
    }
 
-   assert(gffi->nvhdl <= 2 + nports * 3);
+   assert(gffi->nvhdl <= 2 + nports * 4);
    assert(gffi->nforeign <= nports * 2);
 
    if (ffi_prep_cif(&(gffi->cif), FFI_DEFAULT_ABI, gffi->nforeign,
                     ret, types) != FFI_OK)
       fatal("ffi_prep_cif failed for %s", type_pp(type));
 
+   gffi->direct = gffi->nforeign <= GHDL_MAX_DIRECT;
+   for (int i = 0; i < gffi->nforeign; i++)
+      gffi->direct &= types[i] != &ffi_type_double;
+
    return gffi;
 }
 
@@ -24,6 +24,7 @@
 #include "jit/jit-priv.h"
 #include "printf.h"
 #include "rt/mspace.h"
+#include "thread.h"
 #include "tree.h"
 #include "type.h"
 
@@ -34,6 +35,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#define BACKEDGE_WEIGHT 64   // Loop iterations counted as one call
+
 typedef struct _jit_interp {
    jit_scalar_t  *args;
    jit_scalar_t  *regs;
@@ -42,6 +45,7 @@ typedef struct _jit_interp {
    jit_func_t    *func;
    unsigned char *frame;
    unsigned       flags;
+   unsigned       backedges;
    mspace_t      *mspace;
    jit_anchor_t  *anchor;
    tlab_t        *tlab;
@@ -630,24 +634,43 @@ static void interp_branch_to(jit_interp_t *state, jit_value_t label)
    JIT_ASSERT(state->pc < state->func->nirs);
 }
 
+static void interp_back_edge(jit_interp_t *state)
+{
+   // Loop iterations count towards the next tier so that a process
+   // which is called once and then loops is still compiled
+   jit_func_t *f = state->func;
+   if (f->next_tier == NULL || ++(state->backedges) < BACKEDGE_WEIGHT)
+      return;
+
+   state->backedges = 0;
+   relaxed_add(&f->heat, 1);
+
+   if (relaxed_add(&f->hotness, -1) == 0)
+      jit_tier_up(f);
+}
+
 static void interp_jump(jit_interp_t *state, jit_ir_t *ir)
 {
    switch (ir->cc) {
    case JIT_CC_NONE:
-      interp_branch_to(state, ir->arg1);
       break;
    case JIT_CC_T:
-      if (state->flags)
-         interp_branch_to(state, ir->arg1);
+      if (!state->flags)
+         return;
       break;
    case JIT_CC_F:
-      if (!state->flags)
-         interp_branch_to(state, ir->arg1);
+      if (state->flags)
+         return;
       break;
    default:
       interp_dump(state);
       fatal_trace("unhandled jump condition code");
    }
+
+   if (ir->arg1.label < state->pc)
+      interp_back_edge(state);
+
+   interp_branch_to(state, ir->arg1);
 }
 
 static void interp_trap(jit_interp_t *state, jit_ir_t *ir)
@@ -886,10 +909,22 @@ static void interp_putpriv(jit_interp_t *state, jit_ir_t *ir)
 static void interp_case(jit_interp_t *state, jit_ir_t *ir)
 {
    jit_scalar_t test = state->regs[ir->result];
-   const int64_t cmp = interp_get_int(state, ir->arg1);
 
-   if (test.integer == cmp)
-      interp_branch_to(state, ir->arg2);
+   // Evaluate the rest of a chain of $CASE macros with the same test
+   // value here rather than going back through the dispatch loop
+   const jit_ir_t *endir = state->func->irbuf + state->func->nirs;
+   for (;;) {
+      if (test.integer == interp_get_int(state, ir->arg1)) {
+         interp_branch_to(state, ir->arg2);
+         return;
+      }
+      else if (ir + 1 == endir || (ir + 1)->op != MACRO_CASE
+               || (ir + 1)->result != ir->result)
+         return;
+
+      ir++;
+      state->pc++;
+   }
 }
 
 static void interp_trim(jit_interp_t *state, jit_ir_t *ir)
@@ -940,207 +975,147 @@ static void interp_vec4op(jit_interp_t *state, jit_ir_t *ir)
    __nvc_vec4op(ir->arg1.int64, state->anchor, state->args, ir->arg2.int64);
 }
 
+// Opcodes where the handler returns to the dispatch loop afterwards
+#define INTERP_OPS(x)                   \
+   x(J_RECV, recv)                      \
+   x(J_SEND, send)                      \
+   x(J_AND, and)                        \
+   x(J_OR, or)                          \
+   x(J_XOR, xor)                        \
+   x(J_SUB, sub)                        \
+   x(J_FSUB, fsub)                      \
+   x(J_ADD, add)                        \
+   x(J_FADD, fadd)                      \
+   x(J_MUL, mul)                        \
+   x(J_FMUL, fmul)                      \
+   x(J_DIV, div)                        \
+   x(J_FDIV, fdiv)                      \
+   x(J_SHL, shl)                        \
+   x(J_SHR, shr)                        \
+   x(J_ASR, asr)                        \
+   x(J_STORE, store)                    \
+   x(J_ULOAD, uload)                    \
+   x(J_LOAD, load)                      \
+   x(J_CMP, cmp)                        \
+   x(J_CCMP, ccmp)                      \
+   x(J_FCMP, fcmp)                      \
+   x(J_FCCMP, fccmp)                    \
+   x(J_CSET, cset)                      \
+   x(J_JUMP, jump)                      \
+   x(J_TRAP, trap)                      \
+   x(J_CALL, call)                      \
+   x(J_MOV, mov)                        \
+   x(J_CSEL, csel)                      \
+   x(J_NEG, neg)                        \
+   x(J_FNEG, fneg)                      \
+   x(J_NOT, not)                        \
+   x(J_SCVTF, scvtf)                    \
+   x(J_FCVTNS, fcvtns)                  \
+   x(J_LEA, lea)                        \
+   x(J_REM, rem)                        \
+   x(J_CLAMP, clamp)                    \
+   x(MACRO_COPY, copy)                  \
+   x(MACRO_MOVE, move)                  \
+   x(MACRO_BZERO, bzero)                \
+   x(MACRO_MEMSET, memset)              \
+   x(MACRO_GALLOC, galloc)              \
+   x(MACRO_LALLOC, lalloc)              \
+   x(MACRO_SALLOC, salloc)              \
+   x(MACRO_EXIT, exit)                  \
+   x(MACRO_FEXP, fexp)                  \
+   x(MACRO_EXP, exp)                    \
+   x(MACRO_GETPRIV, getpriv)            \
+   x(MACRO_PUTPRIV, putpriv)            \
+   x(MACRO_CASE, case)                  \
+   x(MACRO_TRIM, trim)                  \
+   x(MACRO_SADD, sadd)                  \
+   x(MACRO_PACK, pack)                  \
+   x(MACRO_UNPACK, unpack)              \
+   x(MACRO_VEC4OP, vec4op)
+
+#if defined __GNUC__
+#define INTERP_THREADED 1
+#endif
+
 static void interp_loop(jit_interp_t *state)
 {
+#if INTERP_THREADED
+   // Direct threaded dispatch: jumping through a label table at the end
+   // of each handler gives the branch predictor one indirect branch per
+   // opcode rather than a single shared one for the whole switch
+   static const void *const dispatch[256] = {
+      [0 ... 255] = &&op_invalid,
+#define INTERP_LABEL(op, fn) [op] = &&op_##fn,
+      INTERP_OPS(INTERP_LABEL)
+#undef INTERP_LABEL
+      [J_RET]        = &&op_ret,
+      [J_DEBUG]      = &&op_nop,
+      [J_NOP]        = &&op_nop,
+      [MACRO_REEXEC] = &&op_reexec,
+   };
+
+   jit_ir_t *ir;
+
+#define DISPATCH() do {                                         \
+      JIT_ASSERT(state->pc < state->func->nirs);                \
+      ir = &(state->func->irbuf[state->pc++]);                  \
+      goto *dispatch[ir->op];                                   \
+   } while (0)
+
+   DISPATCH();
+
+#define INTERP_HANDLER(op, fn)                  \
+   op_##fn:                                     \
+      interp_##fn(state, ir);                   \
+      DISPATCH();
+   INTERP_OPS(INTERP_HANDLER)
+#undef INTERP_HANDLER
+
+ op_nop:
+   DISPATCH();
+
+ op_ret:
+   return;
+
+ op_reexec:
+   interp_reexec(state, ir);
+   return;
+
+ op_invalid:
+   interp_dump(state);
+   fatal_trace("cannot interpret opcode %s", jit_op_name(ir->op));
+
+#undef DISPATCH
+#else
    for (;;) {
       JIT_ASSERT(state->pc < state->func->nirs);
       jit_ir_t *ir = &(state->func->irbuf[state->pc++]);
       switch (ir->op) {
-      case J_RECV:
-         interp_recv(state, ir);
-         break;
-      case J_SEND:
-         interp_send(state, ir);
-         break;
-      case J_AND:
-         interp_and(state, ir);
-         break;
-      case J_OR:
-         interp_or(state, ir);
-         break;
-      case J_XOR:
-         interp_xor(state, ir);
-         break;
-      case J_SUB:
-         interp_sub(state, ir);
-         break;
-      case J_FSUB:
-         interp_fsub(state, ir);
-         break;
-      case J_ADD:
-         interp_add(state, ir);
-         break;
-      case J_FADD:
-         interp_fadd(state, ir);
-         break;
-      case J_MUL:
-         interp_mul(state, ir);
-         break;
-      case J_FMUL:
-         interp_fmul(state, ir);
-         break;
-      case J_DIV:
-         interp_div(state, ir);
-         break;
-      case J_FDIV:
-         interp_fdiv(state, ir);
-         break;
-      case J_SHL:
-         interp_shl(state, ir);
-         break;
-      case J_SHR:
-         interp_shr(state, ir);
-         break;
-      case J_ASR:
-         interp_asr(state, ir);
+#define INTERP_CASE(op, fn)                     \
+      case op:                                  \
+         interp_##fn(state, ir);                \
          break;
+      INTERP_OPS(INTERP_CASE)
+#undef INTERP_CASE
       case J_RET:
          return;
-      case J_STORE:
-         interp_store(state, ir);
-         break;
-      case J_ULOAD:
-         interp_uload(state, ir);
-         break;
-      case J_LOAD:
-         interp_load(state, ir);
-         break;
-      case J_CMP:
-         interp_cmp(state, ir);
-         break;
-      case J_CCMP:
-         interp_ccmp(state, ir);
-         break;
-      case J_FCMP:
-         interp_fcmp(state, ir);
-         break;
-      case J_FCCMP:
-         interp_fccmp(state, ir);
-         break;
-      case J_CSET:
-         interp_cset(state, ir);
-         break;
-      case J_JUMP:
-         interp_jump(state, ir);
-         break;
-      case J_TRAP:
-         interp_trap(state, ir);
-         break;
-      case J_CALL:
-         interp_call(state, ir);
-         break;
-      case J_MOV:
-         interp_mov(state, ir);
-         break;
-      case J_CSEL:
-         interp_csel(state, ir);
-         break;
-      case J_NEG:
-         interp_neg(state, ir);
-         break;
-      case J_FNEG:
-         interp_fneg(state, ir);
-         break;
-      case J_NOT:
-         interp_not(state, ir);
-         break;
-      case J_SCVTF:
-         interp_scvtf(state, ir);
-         break;
-      case J_FCVTNS:
-         interp_fcvtns(state, ir);
-         break;
-      case J_LEA:
-         interp_lea(state, ir);
-         break;
-      case J_REM:
-         interp_rem(state, ir);
-         break;
-      case J_CLAMP:
-         interp_clamp(state, ir);
-         break;
       case J_DEBUG:
       case J_NOP:
          break;
-      case MACRO_COPY:
-         interp_copy(state, ir);
-         break;
-      case MACRO_MOVE:
-         interp_move(state, ir);
-         break;
-      case MACRO_BZERO:
-         interp_bzero(state, ir);
-         break;
-      case MACRO_MEMSET:
-         interp_memset(state, ir);
-         break;
-      case MACRO_GALLOC:
-         interp_galloc(state, ir);
-         break;
-      case MACRO_LALLOC:
-         interp_lalloc(state, ir);
-         break;
-      case MACRO_SALLOC:
-         interp_salloc(state, ir);
-         break;
-      case MACRO_EXIT:
-         interp_exit(state, ir);
-         break;
-      case MACRO_FEXP:
-         interp_fexp(state, ir);
-         break;
-      case MACRO_EXP:
-         interp_exp(state, ir);
-         break;
-      case MACRO_GETPRIV:
-         interp_getpriv(state, ir);
-         break;
-      case MACRO_PUTPRIV:
-         interp_putpriv(state, ir);
-         break;
-      case MACRO_CASE:
-         interp_case(state, ir);
-         break;
-      case MACRO_TRIM:
-         interp_trim(state, ir);
-         break;
       case MACRO_REEXEC:
          interp_reexec(state, ir);
          return;
-      case MACRO_SADD:
-         interp_sadd(state, ir);
-         break;
-      case MACRO_PACK:
-         interp_pack(state, ir);
-         break;
-      case MACRO_UNPACK:
-         interp_unpack(state, ir);
-         break;
-      case MACRO_VEC4OP:
-         interp_vec4op(state, ir);
-         break;
       default:
          interp_dump(state);
          fatal_trace("cannot interpret opcode %s", jit_op_name(ir->op));
       }
    }
+#endif
 }
 
-void jit_interp(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
-                tlab_t *tlab)
+static void interp_run(jit_func_t *f, jit_anchor_t *caller,
+                       jit_scalar_t *args, tlab_t *tlab)
 {
-   jit_entry_fn_t entry = load_acquire(&f->entry);
-   if (unlikely(entry != jit_interp)) {
-      // Raced with a code generation thread installing a compiled
-      // version of this function
-      return (*entry)(f, caller, args, tlab);
-   }
-
-   jit_fill_irbuf(f);
-
-   if (f->next_tier && --(f->hotness) <= 0)
-      jit_tier_up(f);
-
    jit_anchor_t anchor = {
       .caller    = caller,
       .func      = f,
@@ -1171,3 +1146,41 @@ void jit_interp(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
 
    interp_loop(&state);
 }
+
+void jit_interp(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
+                tlab_t *tlab)
+{
+   jit_entry_fn_t entry = load_acquire(&f->entry);
+   if (unlikely(entry != jit_interp)) {
+      // Raced with a code generation thread installing a compiled
+      // version of this function
+      return (*entry)(f, caller, args, tlab);
+   }
+
+   jit_fill_irbuf(f);
+
+   if (f->next_tier != NULL) {
+      relaxed_add(&f->heat, 1);
+      f->stats.interp_calls++;
+
+      if (relaxed_add(&f->hotness, -1) == 0) {
+         jit_tier_up(f);
+
+         // Enter the new code immediately if it was generated
+         // synchronously
+         if ((entry = load_acquire(&f->entry)) != jit_interp)
+            return (*entry)(f, caller, args, tlab);
+      }
+   }
+
+   interp_run(f, caller, args, tlab);
+}
+
+void jit_interp_fallback(jit_func_t *f, jit_anchor_t *caller,
+                         jit_scalar_t *args, tlab_t *tlab)
+{
+   // Execute the original body of a function that is normally bound to
+   // an intrinsic without replacing the intrinsic entry point
+   jit_fill_irbuf(f);
+   interp_run(f, caller, args, tlab);
+}
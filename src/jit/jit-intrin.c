@@ -17,11 +17,13 @@
 
 #include "util.h"
 #include "ident.h"
+#include "jit/jit-exits.h"
 #include "jit/jit-priv.h"
 #include "jit/jit.h"
 #include "option.h"
 #include "rt/assert.h"
 #include "thread.h"
+#include "vlog/vlog-defs.h"
 
 #include <assert.h>
 #include <stdlib.h>
@@ -32,7 +34,7 @@
 #define HAVE_NEON
 #endif
 
-#if defined HAVE_AVX2 || defined HAVE_SSE41
+#if defined HAVE_AVX2 || defined HAVE_AVX512BW || defined HAVE_SSE41
 #include <x86intrin.h>
 #endif
 
@@ -45,9 +47,10 @@
 #endif
 
 typedef enum {
-   CPU_AVX2  = 0x1,
-   CPU_SSE41 = 0x2,
-   CPU_NEON  = 0x04,
+   CPU_AVX2   = 0x1,
+   CPU_SSE41  = 0x2,
+   CPU_NEON   = 0x04,
+   CPU_AVX512 = 0x08,
 } cpu_feature_t;
 
 typedef struct {
@@ -125,6 +128,20 @@ static const uint8_t or_table[16][16] = {
    {    _U, _X, _X, _1, _X, _X, _X, _1, _X   },  // | - |
 };
 
+#define MATCH_NONE 0x10   // Matches only '-'
+#define MATCH_ANY  0x80   // Matches every value
+
+// Values in the same class are equal for STD_MATCH
+__attribute__((aligned(16)))
+static const uint8_t match_class[16] = {
+   //  U           X           0     1
+   MATCH_NONE, MATCH_NONE, 0x00, 0x01,
+   //  Z           W           L     H     -
+   MATCH_NONE, MATCH_NONE, 0x00, 0x01, MATCH_ANY,
+   MATCH_NONE, MATCH_NONE, MATCH_NONE, MATCH_NONE,
+   MATCH_NONE, MATCH_NONE, MATCH_NONE,
+};
+
 #if defined HAVE_SSE41
 static const uint8_t not_table[1][16] = {
    // ---------------------------------------------------
@@ -352,6 +369,134 @@ static inline void __invert_bits(const uint8_t *input, int size,
    }
 }
 
+#ifdef HAVE_AVX2
+__attribute__((target("avx2"), always_inline))
+static inline __m256i __load_table_avx2(const void *table)
+{
+   return _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)table));
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline void __map_vector_avx2(const uint8_t *input, int size,
+                                     const void *table, uint8_t *result)
+{
+   __m256i lookup = __load_table_avx2(table);
+
+   for (int pos = 0; pos < size; pos += 32) {
+      __m256i in  = _mm256_loadu_si256((const __m256i *)(input + pos));
+      __m256i out = _mm256_shuffle_epi8(lookup, in);
+      _mm256_storeu_si256((__m256i *)(result + pos), out);
+   }
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline void __logic_vector_avx2(const uint8_t *left,
+                                       const uint8_t *right, int size,
+                                       const void *table, uint8_t *result)
+{
+   __m256i left_tbl  = __load_table_avx2(compress_left);
+   __m256i right_tbl = __load_table_avx2(compress_right);
+   __m256i op_tbl    = __load_table_avx2(table);
+
+   for (int pos = 0; pos < size; pos += 32) {
+      __m256i left1  = _mm256_loadu_si256((const __m256i *)(left + pos));
+      __m256i right1 = _mm256_loadu_si256((const __m256i *)(right + pos));
+      __m256i left2  = _mm256_shuffle_epi8(left_tbl, left1);
+      __m256i right2 = _mm256_shuffle_epi8(right_tbl, right1);
+      __m256i comb   = _mm256_or_si256(left2, right2);
+      __m256i out    = _mm256_shuffle_epi8(op_tbl, comb);
+      _mm256_storeu_si256((__m256i *)(result + pos), out);
+   }
+}
+#endif
+
+#ifdef HAVE_AVX512BW
+// The AVX-512 intrinsics use masked loads and stores for the final
+// partial vector so unlike the others they never read past the end of
+// the input arrays
+
+__attribute__((target("avx512bw"), always_inline))
+static inline __mmask64 __tail_mask_avx512(int remain)
+{
+   return remain >= 64 ? ~UINT64_C(0) : (UINT64_C(1) << remain) - 1;
+}
+
+__attribute__((target("avx512bw"), always_inline))
+static inline __m512i __load_table_avx512(const void *table)
+{
+   return _mm512_broadcast_i32x4(_mm_load_si128((const __m128i *)table));
+}
+
+__attribute__((target("avx512bw"), always_inline))
+static inline void __map_vector_avx512(const uint8_t *input, int size,
+                                       const void *table, uint8_t *result)
+{
+   __m512i lookup = __load_table_avx512(table);
+
+   for (int pos = 0; pos < size; pos += 64) {
+      const __mmask64 mask = __tail_mask_avx512(size - pos);
+      __m512i in  = _mm512_maskz_loadu_epi8(mask, input + pos);
+      __m512i out = _mm512_shuffle_epi8(lookup, in);
+      _mm512_mask_storeu_epi8(result + pos, mask, out);
+   }
+}
+
+__attribute__((target("avx512bw"), always_inline))
+static inline void __logic_vector_avx512(const uint8_t *left,
+                                         const uint8_t *right, int size,
+                                         const void *table, uint8_t *result)
+{
+   __m512i left_tbl  = __load_table_avx512(compress_left);
+   __m512i right_tbl = __load_table_avx512(compress_right);
+   __m512i op_tbl    = __load_table_avx512(table);
+
+   for (int pos = 0; pos < size; pos += 64) {
+      const __mmask64 mask = __tail_mask_avx512(size - pos);
+      __m512i left1  = _mm512_maskz_loadu_epi8(mask, left + pos);
+      __m512i right1 = _mm512_maskz_loadu_epi8(mask, right + pos);
+      __m512i left2  = _mm512_shuffle_epi8(left_tbl, left1);
+      __m512i right2 = _mm512_shuffle_epi8(right_tbl, right1);
+      __m512i comb   = _mm512_or_si512(left2, right2);
+      __m512i out    = _mm512_shuffle_epi8(op_tbl, comb);
+      _mm512_mask_storeu_epi8(result + pos, mask, out);
+   }
+}
+#endif
+
+#ifdef HAVE_AVX512BW
+__attribute__((target("avx512bw")))
+static void std_to_x01_avx512(jit_func_t *func, jit_anchor_t *anchor,
+                              jit_scalar_t *args, tlab_t *tlab)
+{
+   const int size = args[3].integer ^ (args[3].integer >> 63);
+   const uint8_t *input = args[1].pointer;
+
+   uint8_t *result = __tlab_alloc(tlab, size, 8);
+   __map_vector_avx512(input, size, cvt_to_x01, result);
+
+   args[0].pointer = result;
+   args[1].integer = size - 1;
+   args[2].integer = ~size;
+}
+#endif
+
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static void std_to_x01_avx2(jit_func_t *func, jit_anchor_t *anchor,
+                            jit_scalar_t *args, tlab_t *tlab)
+{
+   const int size = args[3].integer ^ (args[3].integer >> 63);
+   const uint8_t *input = args[1].pointer;
+
+   uint8_t *result = __tlab_alloc(tlab, ALIGN_UP(size, 32), 8);
+   __map_vector_avx2(input, size, cvt_to_x01, result);
+
+   args[0].pointer = result;
+   args[1].integer = size - 1;
+   args[2].integer = ~size;
+}
+#endif
+
 #ifdef HAVE_SSE41
 __attribute__((target("sse4.1")))
 static void std_to_x01_sse41(jit_func_t *func, jit_anchor_t *anchor,
@@ -579,6 +724,91 @@ static inline void __unpack_from_u64(uint64_t val,
    }
 }
 
+static char __to_xstring_digit(const uint8_t *bits, int count, int pad,
+                               uint8_t padval)
+{
+   static const char map[16] = "0123456789ABCDEF";
+
+   unsigned digit = 0;
+   int nz = 0;
+   bool is_x = false;
+   for (int i = 0; i < count; i++) {
+      const uint8_t bit = i < pad ? padval : bits[i - pad];
+      switch (bit) {
+      case _0: case _L: digit <<= 1; break;
+      case _1: case _H: digit = (digit << 1) | 1; break;
+      case _Z: nz++; break;
+      default: is_x = true; break;
+      }
+   }
+
+   if (nz == count)
+      return 'Z';
+   else if (nz > 0 || is_x)
+      return 'X';
+   else
+      return map[digit];
+}
+
+static void ieee_to_xstring(jit_func_t *func, jit_anchor_t *anchor,
+                            jit_scalar_t *args, tlab_t *tlab, int log_base)
+{
+   const int size = ffi_array_length(args[3].integer);
+   const uint8_t *input = args[1].pointer;
+
+   if (size == 0)
+      fail_in_interpreter(func, anchor, args, tlab);
+
+   const int result_len = (size + log_base - 1) / log_base;
+   const int pad = result_len * log_base - size;
+   char *result = __tlab_alloc(tlab, result_len, 8);
+
+   args[0].pointer = result;
+   args[1].integer = 1;
+   args[2].integer = result_len;
+
+   // The leading digit is padded with 'Z' if the leftmost bit is 'Z'
+   // and '0' otherwise
+   int pos = 0, out = 0;
+   if (pad > 0) {
+      const uint8_t padval = input[0] == _Z ? _Z : _0;
+      result[out++] = __to_xstring_digit(input, log_base, pad, padval);
+      pos = log_base - pad;
+   }
+
+   if (log_base == 4) {
+      // Convert eight bits at a time to a pair of hex digits when there
+      // are no metavalues
+      static const char map[16] = "0123456789ABCDEF";
+      for (; pos + 8 <= size; pos += 8) {
+         const uint64_t u64 = unaligned_load(input + pos, uint64_t);
+         if (!IS_01(u64))
+            break;
+
+         const uint8_t byte = __pack_low_bits(input + pos);
+         result[out++] = map[byte >> 4];
+         result[out++] = map[byte & 0xf];
+      }
+   }
+
+   for (; pos < size; pos += log_base)
+      result[out++] = __to_xstring_digit(input + pos, log_base, 0, _0);
+
+   assert(out == result_len);
+}
+
+static void ieee_to_hstring(jit_func_t *func, jit_anchor_t *anchor,
+                            jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_to_xstring(func, anchor, args, tlab, 4);
+}
+
+static void ieee_to_ostring(jit_func_t *func, jit_anchor_t *anchor,
+                            jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_to_xstring(func, anchor, args, tlab, 3);
+}
+
 __attribute__((always_inline))
 static inline void __ieee_packed_add_scalar(const uint8_t *left,
                                             const uint8_t *right, int size,
@@ -1331,6 +1561,56 @@ static void ieee_to_integer_signed(jit_func_t *func, jit_anchor_t *anchor,
    __tlab_restore(tlab, mark);
 }
 
+#ifdef HAVE_AVX512BW
+__attribute__((target("avx512bw")))
+static void ieee_and_vector_avx512(jit_func_t *func, jit_anchor_t *anchor,
+                                   jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   const int rsize = ffi_array_length(args[6].integer);
+   uint8_t *left = args[1].pointer;
+   uint8_t *right = args[4].pointer;
+
+   if (unlikely(lsize != rsize))
+      __ieee_msg(func, anchor, SEVERITY_FAILURE,
+                 "STD_LOGIC_1164.\"and\": arguments of overloaded 'and' "
+                 "operator are not of the same length");
+   else {
+      uint8_t *result = __tlab_alloc(tlab, lsize, 8);
+      __logic_vector_avx512(left, right, lsize, small_and_table, result);
+
+      args[0].pointer = result;
+      args[1].integer = 1;
+      args[2].integer = lsize;
+   }
+}
+#endif
+
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static void ieee_and_vector_avx2(jit_func_t *func, jit_anchor_t *anchor,
+                                 jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   const int rsize = ffi_array_length(args[6].integer);
+   uint8_t *left = args[1].pointer;
+   uint8_t *right = args[4].pointer;
+
+   if (unlikely(lsize != rsize))
+      __ieee_msg(func, anchor, SEVERITY_FAILURE,
+                 "STD_LOGIC_1164.\"and\": arguments of overloaded 'and' "
+                 "operator are not of the same length");
+   else {
+      uint8_t *result = __tlab_alloc(tlab, ALIGN_UP(lsize, 32), 8);
+      __logic_vector_avx2(left, right, lsize, small_and_table, result);
+
+      args[0].pointer = result;
+      args[1].integer = 1;
+      args[2].integer = lsize;
+   }
+}
+#endif
+
 #ifdef HAVE_SSE41
 __attribute__((target("sse4.1")))
 static void ieee_and_vector_sse41(jit_func_t *func, jit_anchor_t *anchor,
@@ -1430,6 +1710,56 @@ static void ieee_and_vector(jit_func_t *func, jit_anchor_t *anchor,
    }
 }
 
+#ifdef HAVE_AVX512BW
+__attribute__((target("avx512bw")))
+static void ieee_or_vector_avx512(jit_func_t *func, jit_anchor_t *anchor,
+                                  jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   const int rsize = ffi_array_length(args[6].integer);
+   uint8_t *left = args[1].pointer;
+   uint8_t *right = args[4].pointer;
+
+   if (unlikely(lsize != rsize))
+      __ieee_msg(func, anchor, SEVERITY_FAILURE,
+                 "STD_LOGIC_1164.\"or\": arguments of overloaded 'or' "
+                 "operator are not of the same length");
+   else {
+      uint8_t *result = __tlab_alloc(tlab, lsize, 8);
+      __logic_vector_avx512(left, right, lsize, small_or_table, result);
+
+      args[0].pointer = result;
+      args[1].integer = 1;
+      args[2].integer = lsize;
+   }
+}
+#endif
+
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static void ieee_or_vector_avx2(jit_func_t *func, jit_anchor_t *anchor,
+                                jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   const int rsize = ffi_array_length(args[6].integer);
+   uint8_t *left = args[1].pointer;
+   uint8_t *right = args[4].pointer;
+
+   if (unlikely(lsize != rsize))
+      __ieee_msg(func, anchor, SEVERITY_FAILURE,
+                 "STD_LOGIC_1164.\"or\": arguments of overloaded 'or' "
+                 "operator are not of the same length");
+   else {
+      uint8_t *result = __tlab_alloc(tlab, ALIGN_UP(lsize, 32), 8);
+      __logic_vector_avx2(left, right, lsize, small_or_table, result);
+
+      args[0].pointer = result;
+      args[1].integer = 1;
+      args[2].integer = lsize;
+   }
+}
+#endif
+
 #ifdef HAVE_SSE41
 __attribute__((target("sse4.1")))
 static void ieee_or_vector_sse41(jit_func_t *func, jit_anchor_t *anchor,
@@ -1529,6 +1859,56 @@ static void ieee_or_vector(jit_func_t *func, jit_anchor_t *anchor,
    }
 }
 
+#ifdef HAVE_AVX512BW
+__attribute__((target("avx512bw")))
+static void ieee_xor_vector_avx512(jit_func_t *func, jit_anchor_t *anchor,
+                                   jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   const int rsize = ffi_array_length(args[6].integer);
+   uint8_t *left = args[1].pointer;
+   uint8_t *right = args[4].pointer;
+
+   if (unlikely(lsize != rsize))
+      __ieee_msg(func, anchor, SEVERITY_FAILURE,
+                 "STD_LOGIC_1164.\"xor\": arguments of overloaded 'xor' "
+                 "operator are not of the same length");
+   else {
+      uint8_t *result = __tlab_alloc(tlab, lsize, 8);
+      __logic_vector_avx512(left, right, lsize, small_xor_table, result);
+
+      args[0].pointer = result;
+      args[1].integer = 1;
+      args[2].integer = lsize;
+   }
+}
+#endif
+
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static void ieee_xor_vector_avx2(jit_func_t *func, jit_anchor_t *anchor,
+                                 jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   const int rsize = ffi_array_length(args[6].integer);
+   uint8_t *left = args[1].pointer;
+   uint8_t *right = args[4].pointer;
+
+   if (unlikely(lsize != rsize))
+      __ieee_msg(func, anchor, SEVERITY_FAILURE,
+                 "STD_LOGIC_1164.\"xor\": arguments of overloaded 'xor' "
+                 "operator are not of the same length");
+   else {
+      uint8_t *result = __tlab_alloc(tlab, ALIGN_UP(lsize, 32), 8);
+      __logic_vector_avx2(left, right, lsize, small_xor_table, result);
+
+      args[0].pointer = result;
+      args[1].integer = 1;
+      args[2].integer = lsize;
+   }
+}
+#endif
+
 #ifdef HAVE_SSE41
 __attribute__((target("sse4.1")))
 static void ieee_xor_vector_sse41(jit_func_t *func, jit_anchor_t *anchor,
@@ -1628,6 +2008,40 @@ static void std_xor_vector(jit_func_t *func, jit_anchor_t *anchor,
    }
 }
 
+#ifdef HAVE_AVX512BW
+__attribute__((target("avx512bw")))
+static void ieee_not_vector_avx512(jit_func_t *func, jit_anchor_t *anchor,
+                                   jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   uint8_t *left = args[1].pointer;
+
+   uint8_t *result = __tlab_alloc(tlab, lsize, 8);
+   __map_vector_avx512(left, lsize, not_table, result);
+
+   args[0].pointer = result;
+   args[1].integer = 1;
+   args[2].integer = lsize;
+}
+#endif
+
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static void ieee_not_vector_avx2(jit_func_t *func, jit_anchor_t *anchor,
+                                 jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   uint8_t *left = args[1].pointer;
+
+   uint8_t *result = __tlab_alloc(tlab, ALIGN_UP(lsize, 32), 8);
+   __map_vector_avx2(left, lsize, not_table, result);
+
+   args[0].pointer = result;
+   args[1].integer = 1;
+   args[2].integer = lsize;
+}
+#endif
+
 #ifdef HAVE_SSE41
 __attribute__((target("sse4.1")))
 static void ieee_not_vector_sse41(jit_func_t *func, jit_anchor_t *anchor,
@@ -1994,10 +2408,10 @@ static void synopsys_eql_signed(jit_func_t *func, jit_anchor_t *anchor,
    __tlab_restore(tlab, mark);
 }
 
-#ifdef HAVE_SSE41
-__attribute__((target("sse4.1")))
-static void byte_vector_equal_sse41(jit_func_t *func, jit_anchor_t *anchor,
-                                    jit_scalar_t *args, tlab_t *tlab)
+#ifdef HAVE_AVX512BW
+__attribute__((target("avx512bw")))
+static void byte_vector_equal_avx512(jit_func_t *func, jit_anchor_t *anchor,
+                                     jit_scalar_t *args, tlab_t *tlab)
 {
    const int lsize = ffi_array_length(args[2].integer);
    const int rsize = ffi_array_length(args[5].integer);
@@ -2009,21 +2423,76 @@ static void byte_vector_equal_sse41(jit_func_t *func, jit_anchor_t *anchor,
    if (lsize != rsize)
       return;
 
-   __m128i allmask = _mm_set1_epi8(0xff);
-
-   int pos = 0;
-   for (; pos + 15 < lsize; pos += 16) {
-      __m128i left1  = _mm_loadu_si128((const __m128i *)(left + pos));
-      __m128i right1 = _mm_loadu_si128((const __m128i *)(right + pos));
-      __m128i xor    = _mm_xor_si128(left1, right1);
-      if (!_mm_test_all_zeros(xor, allmask))
+   for (int pos = 0; pos < lsize; pos += 64) {
+      const __mmask64 mask = __tail_mask_avx512(lsize - pos);
+      __m512i left1  = _mm512_maskz_loadu_epi8(mask, left + pos);
+      __m512i right1 = _mm512_maskz_loadu_epi8(mask, right + pos);
+      if (_mm512_cmpneq_epi8_mask(left1, right1))
          return;
    }
 
-   if (pos < lsize) {
-      __m128i iota   = _mm_load_si128((const __m128i *)lane_iota);
-      __m128i mask   = _mm_cmplt_epi8(iota, _mm_set1_epi8(lsize - pos));
-      __m128i left1  = _mm_loadu_si128((const __m128i *)(left + pos));
+   args[0].integer = 1;
+}
+#endif
+
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static void byte_vector_equal_avx2(jit_func_t *func, jit_anchor_t *anchor,
+                                   jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[2].integer);
+   const int rsize = ffi_array_length(args[5].integer);
+   uint8_t *left = args[0].pointer;
+   uint8_t *right = args[3].pointer;
+
+   args[0].integer = 0;
+
+   if (lsize != rsize)
+      return;
+
+   int pos = 0;
+   for (; pos + 31 < lsize; pos += 32) {
+      __m256i left1  = _mm256_loadu_si256((const __m256i *)(left + pos));
+      __m256i right1 = _mm256_loadu_si256((const __m256i *)(right + pos));
+      __m256i xor    = _mm256_xor_si256(left1, right1);
+      if (!_mm256_testz_si256(xor, xor))
+         return;
+   }
+
+   args[0].integer = memcmp(left + pos, right + pos, lsize - pos) == 0;
+}
+#endif
+
+#ifdef HAVE_SSE41
+__attribute__((target("sse4.1")))
+static void byte_vector_equal_sse41(jit_func_t *func, jit_anchor_t *anchor,
+                                    jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[2].integer);
+   const int rsize = ffi_array_length(args[5].integer);
+   uint8_t *left = args[0].pointer;
+   uint8_t *right = args[3].pointer;
+
+   args[0].integer = 0;
+
+   if (lsize != rsize)
+      return;
+
+   __m128i allmask = _mm_set1_epi8(0xff);
+
+   int pos = 0;
+   for (; pos + 15 < lsize; pos += 16) {
+      __m128i left1  = _mm_loadu_si128((const __m128i *)(left + pos));
+      __m128i right1 = _mm_loadu_si128((const __m128i *)(right + pos));
+      __m128i xor    = _mm_xor_si128(left1, right1);
+      if (!_mm_test_all_zeros(xor, allmask))
+         return;
+   }
+
+   if (pos < lsize) {
+      __m128i iota   = _mm_load_si128((const __m128i *)lane_iota);
+      __m128i mask   = _mm_cmplt_epi8(iota, _mm_set1_epi8(lsize - pos));
+      __m128i left1  = _mm_loadu_si128((const __m128i *)(left + pos));
       __m128i right1 = _mm_loadu_si128((const __m128i *)(right + pos));
       __m128i xor    = _mm_xor_si128(left1, right1);
       if (!_mm_test_all_zeros(xor, mask))
@@ -2085,6 +2554,266 @@ static void byte_vector_equal(jit_func_t *func, jit_anchor_t *anchor,
    args[0].integer = (lsize == rsize) && (memcmp(left, right, lsize) == 0);
 }
 
+static void ieee_shift_left(jit_func_t *func, jit_anchor_t *anchor,
+                            jit_scalar_t *args, tlab_t *tlab)
+{
+   const int size = args[3].integer ^ (args[3].integer >> 63);
+   const int64_t count = args[4].integer;
+   const uint8_t *input = args[1].pointer;
+
+   if (size == 0) {
+      args[0].pointer = NULL;
+      args[1].integer = 0;
+      args[2].integer = -1;
+      return;
+   }
+
+   uint8_t *result = __tlab_alloc(tlab, size, 8);
+
+   if (count >= size)
+      memset(result, _0, size);
+   else
+      __shift_bits(input, size, count, result);
+
+   args[0].pointer = result;
+   args[1].integer = size - 1;
+   args[2].integer = ~size;
+}
+
+__attribute__((always_inline))
+static inline void __shift_right(jit_func_t *func, jit_anchor_t *anchor,
+                                 jit_scalar_t *args, tlab_t *tlab,
+                                 bool arith)
+{
+   const int size = args[3].integer ^ (args[3].integer >> 63);
+   int64_t count = args[4].integer;
+   const uint8_t *input = args[1].pointer;
+
+   if (size == 0) {
+      args[0].pointer = NULL;
+      args[1].integer = 0;
+      args[2].integer = -1;
+      return;
+   }
+   else if (count == 0 || (arith && size == 1))
+      args[0].pointer = (uint8_t *)input;
+   else {
+      uint8_t *result = __tlab_alloc(tlab, size, 8);
+
+      if (arith && count >= size)
+         count = size - 1;   // Replicate the sign bit into every position
+
+      if (count >= size)
+         memset(result, _0, size);
+      else {
+         memset(result, arith ? input[0] : _0, count);
+         memcpy(result + count, input, size - count);
+      }
+
+      args[0].pointer = result;
+   }
+
+   args[1].integer = size - 1;
+   args[2].integer = ~size;
+}
+
+static void ieee_shift_right_unsigned(jit_func_t *func, jit_anchor_t *anchor,
+                                      jit_scalar_t *args, tlab_t *tlab)
+{
+   __shift_right(func, anchor, args, tlab, false);
+}
+
+static void ieee_shift_right_signed(jit_func_t *func, jit_anchor_t *anchor,
+                                    jit_scalar_t *args, tlab_t *tlab)
+{
+   __shift_right(func, anchor, args, tlab, true);
+}
+
+__attribute__((always_inline))
+static inline void __ieee_equal(jit_func_t *func, jit_anchor_t *anchor,
+                                jit_scalar_t *args, tlab_t *tlab, bool sign)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   const int rsize = ffi_array_length(args[6].integer);
+   const uint8_t *left = args[1].pointer;
+   const uint8_t *right = args[4].pointer;
+
+   args[0].integer = 0;   // Return FALSE by default
+
+   if (lsize < 1 || rsize < 1) {
+      ieee_warn(func, anchor, "NUMERIC_STD.\"=\": null argument detected, "
+                "returning FALSE");
+      return;
+   }
+
+   const uint32_t mark = __tlab_mark(tlab);
+
+   left = __to_01(tlab, left, lsize, _X);
+   right = __to_01(tlab, right, rsize, _X);
+
+   if (left[0] == _X || right[0] == _X) {
+      ieee_warn(func, anchor, "NUMERIC_STD.\"=\": metavalue detected, "
+                "returning FALSE");
+      __tlab_restore(tlab, mark);
+      return;
+   }
+
+   // Compare the common low-order bits and then check the extra
+   // high-order bits of the longer argument match the extension of
+   // the shorter one
+   const int common = MIN(lsize, rsize);
+   const uint8_t *longer = lsize > rsize ? left : right;
+   const uint8_t *shorter = lsize > rsize ? right : left;
+   const int extra = MAX(lsize, rsize) - common;
+   const uint8_t pad = sign ? shorter[0] : _0;
+
+   bool equal = memcmp(left + lsize - common, right + rsize - common,
+                       common) == 0;
+   for (int i = 0; equal && i < extra; i++)
+      equal = (longer[i] == pad);
+
+   args[0].integer = equal;
+
+   __tlab_restore(tlab, mark);
+}
+
+static void ieee_equal_unsigned(jit_func_t *func, jit_anchor_t *anchor,
+                                jit_scalar_t *args, tlab_t *tlab)
+{
+   __ieee_equal(func, anchor, args, tlab, false);
+}
+
+static void ieee_equal_signed(jit_func_t *func, jit_anchor_t *anchor,
+                              jit_scalar_t *args, tlab_t *tlab)
+{
+   __ieee_equal(func, anchor, args, tlab, true);
+}
+
+__attribute__((always_inline))
+static inline bool __std_match_sizes(jit_func_t *func, jit_anchor_t *anchor,
+                                     jit_scalar_t *args, int lsize, int rsize)
+{
+   args[0].integer = 0;   // Return FALSE by default
+
+   if (lsize < 1 || rsize < 1) {
+      ieee_warn(func, anchor, "NUMERIC_STD.STD_MATCH: null detected, "
+                "returning FALSE");
+      return false;
+   }
+   else if (lsize != rsize) {
+      ieee_warn(func, anchor, "NUMERIC_STD.STD_MATCH: L'LENGTH /= R'LENGTH, "
+                "returning FALSE");
+      return false;
+   }
+
+   return true;
+}
+
+__attribute__((always_inline))
+static inline bool __std_match_scalar(const uint8_t *left,
+                                      const uint8_t *right, int size)
+{
+   for (int i = 0; i < size; i++) {
+      const uint8_t lclass = match_class[left[i]];
+      const uint8_t rclass = match_class[right[i]];
+      if (((lclass | rclass) & MATCH_ANY) == 0
+          && (lclass != rclass || (lclass & MATCH_NONE)))
+         return false;
+   }
+
+   return true;
+}
+
+#ifdef HAVE_AVX512BW
+__attribute__((target("avx512bw")))
+static void ieee_std_match_avx512(jit_func_t *func, jit_anchor_t *anchor,
+                                  jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   const int rsize = ffi_array_length(args[6].integer);
+   const uint8_t *left = args[1].pointer;
+   const uint8_t *right = args[4].pointer;
+
+   if (!__std_match_sizes(func, anchor, args, lsize, rsize))
+      return;
+
+   __m512i class_tbl = __load_table_avx512(match_class);
+   __m512i any_bits  = _mm512_set1_epi8(MATCH_ANY);
+   __m512i none_bits = _mm512_set1_epi8(MATCH_NONE);
+
+   for (int pos = 0; pos < lsize; pos += 64) {
+      const __mmask64 mask = __tail_mask_avx512(lsize - pos);
+      __m512i left1  = _mm512_maskz_loadu_epi8(mask, left + pos);
+      __m512i right1 = _mm512_maskz_loadu_epi8(mask, right + pos);
+      __m512i left2  = _mm512_shuffle_epi8(class_tbl, left1);
+      __m512i right2 = _mm512_shuffle_epi8(class_tbl, right1);
+      __m512i comb   = _mm512_or_si512(left2, right2);
+
+      const __mmask64 same = _mm512_cmpeq_epi8_mask(left2, right2)
+         & _mm512_testn_epi8_mask(left2, none_bits);
+      const __mmask64 any = _mm512_test_epi8_mask(comb, any_bits);
+
+      if (((same | any) & mask) != mask)
+         return;
+   }
+
+   args[0].integer = 1;
+}
+#endif
+
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static void ieee_std_match_avx2(jit_func_t *func, jit_anchor_t *anchor,
+                                jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   const int rsize = ffi_array_length(args[6].integer);
+   const uint8_t *left = args[1].pointer;
+   const uint8_t *right = args[4].pointer;
+
+   if (!__std_match_sizes(func, anchor, args, lsize, rsize))
+      return;
+
+   __m256i class_tbl = __load_table_avx2(match_class);
+   __m256i none_bits = _mm256_set1_epi8(MATCH_NONE);
+   __m256i zero      = _mm256_setzero_si256();
+
+   int pos = 0;
+   for (; pos + 31 < lsize; pos += 32) {
+      __m256i left1  = _mm256_loadu_si256((const __m256i *)(left + pos));
+      __m256i right1 = _mm256_loadu_si256((const __m256i *)(right + pos));
+      __m256i left2  = _mm256_shuffle_epi8(class_tbl, left1);
+      __m256i right2 = _mm256_shuffle_epi8(class_tbl, right1);
+      __m256i comb   = _mm256_or_si256(left2, right2);
+      __m256i none   = _mm256_and_si256(left2, none_bits);
+      __m256i same   = _mm256_andnot_si256(_mm256_cmpgt_epi8(none, zero),
+                                           _mm256_cmpeq_epi8(left2, right2));
+
+      // MATCH_ANY is the sign bit so appears directly in the byte mask
+      const uint32_t ok = _mm256_movemask_epi8(same)
+         | _mm256_movemask_epi8(comb);
+      if (ok != UINT32_MAX)
+         return;
+   }
+
+   args[0].integer = __std_match_scalar(left + pos, right + pos, lsize - pos);
+}
+#endif
+
+static void ieee_std_match(jit_func_t *func, jit_anchor_t *anchor,
+                           jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   const int rsize = ffi_array_length(args[6].integer);
+   const uint8_t *left = args[1].pointer;
+   const uint8_t *right = args[4].pointer;
+
+   if (!__std_match_sizes(func, anchor, args, lsize, rsize))
+      return;
+
+   args[0].integer = __std_match_scalar(left, right, lsize);
+}
+
 static void ieee_math_sin(jit_func_t *func, jit_anchor_t *anchor,
                           jit_scalar_t *args, tlab_t *tlab)
 {
@@ -2151,6 +2880,196 @@ static void ieee_math_exp(jit_func_t *func, jit_anchor_t *anchor,
    args[0].real = exp(args[1].real);
 }
 
+static void ieee_math_uniform(jit_func_t *func, jit_anchor_t *anchor,
+                              jit_scalar_t *args, tlab_t *tlab)
+{
+   int32_t *seed1 = args[2].pointer, *seed2 = args[3].pointer;
+   double *x = args[4].pointer;
+
+   if (*seed1 > 2147483562 || *seed2 > 2147483398) {
+      // Let the VHDL implementation report the error
+      jit_interp(func, anchor, args, tlab);
+      return;
+   }
+
+   int32_t k = *seed1 / 53668;
+   int32_t t1 = 40014 * (*seed1 - k * 53668) - k * 12211;
+   if (t1 < 0)
+      t1 += 2147483563;
+
+   k = *seed2 / 52774;
+   int32_t t2 = 40692 * (*seed2 - k * 52774) - k * 3791;
+   if (t2 < 0)
+      t2 += 2147483399;
+
+   int32_t z = t1 - t2;
+   if (z < 1)
+      z += 2147483562;
+
+   *seed1 = t1;
+   *seed2 = t2;
+   *x = (double)z * 4.656613e-10;
+}
+
+static inline int64_t __vital_min(int64_t a, int64_t b)
+{
+   return a < b ? a : b;
+}
+
+static inline int64_t __vital_max(int64_t a, int64_t b)
+{
+   return a > b ? a : b;
+}
+
+typedef enum {
+   VITAL_TR01, VITAL_TR10, VITAL_TR0Z, VITAL_TRZ1, VITAL_TR1Z, VITAL_TRZ0
+} vital_transition_t;
+
+static int vital_value_class(uint8_t value)
+{
+   switch (value) {
+   case _0: case _L: return _0;
+   case _1: case _H: return _1;
+   case _Z: return _Z;
+   default: return _X;
+   }
+}
+
+static int64_t vital_calc_delay(uint8_t newval, uint8_t oldval,
+                                const int64_t *delay, int ndelays)
+{
+   // Transcription of the VitalCalcDelay overloads in timing_b.vhdl
+   if (ndelays == 1)
+      return delay[0];
+
+   const int new = vital_value_class(newval);
+   const int old = vital_value_class(oldval);
+
+   if (ndelays == 2) {
+      if (new == _0)
+         return delay[VITAL_TR10];
+      else if (new == _1)
+         return delay[VITAL_TR01];
+      else if (old == _0)
+         return delay[VITAL_TR01];
+      else if (old == _1)
+         return delay[VITAL_TR10];
+      else if (old == _Z && new == _X)
+         return __vital_min(delay[VITAL_TR10], delay[VITAL_TR01]);
+      else
+         return __vital_max(delay[VITAL_TR10], delay[VITAL_TR01]);
+   }
+
+   assert(ndelays == 6);
+
+   switch (old) {
+   case _0:
+      switch (new) {
+      case _0: return delay[VITAL_TR10];
+      case _1: return delay[VITAL_TR01];
+      case _Z: return delay[VITAL_TR0Z];
+      default: return __vital_min(delay[VITAL_TR01], delay[VITAL_TR0Z]);
+      }
+   case _1:
+      switch (new) {
+      case _0: return delay[VITAL_TR10];
+      case _1: return delay[VITAL_TR01];
+      case _Z: return delay[VITAL_TR1Z];
+      default: return __vital_min(delay[VITAL_TR10], delay[VITAL_TR1Z]);
+      }
+   case _Z:
+      switch (new) {
+      case _0: return delay[VITAL_TRZ0];
+      case _1: return delay[VITAL_TRZ1];
+      case _Z: return __vital_max(delay[VITAL_TR0Z], delay[VITAL_TR1Z]);
+      default: return __vital_min(delay[VITAL_TRZ1], delay[VITAL_TRZ0]);
+      }
+   default:
+      switch (new) {
+      case _0: return __vital_max(delay[VITAL_TR10], delay[VITAL_TRZ0]);
+      case _1: return __vital_max(delay[VITAL_TR01], delay[VITAL_TRZ1]);
+      case _Z: return __vital_max(delay[VITAL_TR1Z], delay[VITAL_TR0Z]);
+      default: return __vital_max(delay[VITAL_TR10], delay[VITAL_TR01]);
+      }
+   }
+}
+
+static void vital_calc_delay01(jit_func_t *func, jit_anchor_t *anchor,
+                               jit_scalar_t *args, tlab_t *tlab)
+{
+   args[0].integer = vital_calc_delay(args[1].integer, args[2].integer,
+                                      args[3].pointer, 2);
+}
+
+static void vital_calc_delay01z(jit_func_t *func, jit_anchor_t *anchor,
+                                jit_scalar_t *args, tlab_t *tlab)
+{
+   args[0].integer = vital_calc_delay(args[1].integer, args[2].integer,
+                                      args[3].pointer, 6);
+}
+
+static void vital_select_path_delay(jit_scalar_t *args, int ndelays)
+{
+   const uint8_t newval = args[1].integer;
+   const uint8_t oldval = args[2].integer;
+   const uint8_t *paths = args[6].pointer;
+   const int npaths = ffi_array_length(args[8].integer);
+   const int64_t *defdelay =
+      ndelays == 1 ? &(args[9].integer) : args[9].pointer;
+   const bool ignore_default = args[10].integer;
+
+   // Each element of the paths array is a record containing the input
+   // change time, the path delay, and the path condition
+   const size_t stride = (ndelays + 2) * sizeof(int64_t);
+
+   int64_t input_age = TIME_HIGH, prop_delay = TIME_HIGH;
+   for (int i = 0; i < npaths; i++, paths += stride) {
+      const int64_t *change_time = (const int64_t *)paths;
+      const int64_t *path_delay = change_time + 1;
+      const uint8_t condition = *(const uint8_t *)(path_delay + ndelays);
+
+      if (!condition || *change_time > input_age)
+         continue;
+
+      const int64_t tmp = vital_calc_delay(newval, oldval, path_delay,
+                                           ndelays);
+
+      if (*change_time < input_age || tmp < prop_delay)
+         prop_delay = tmp;
+
+      input_age = *change_time;
+   }
+
+   if (prop_delay == TIME_HIGH) {
+      if (ignore_default)
+         prop_delay = vital_calc_delay(newval, oldval, defdelay, ndelays);
+   }
+   else if (input_age > prop_delay)
+      prop_delay = vital_calc_delay(newval, oldval, defdelay, ndelays);
+   else
+      prop_delay -= input_age;
+
+   args[0].integer = prop_delay;
+}
+
+static void vital_select_path_delay0(jit_func_t *func, jit_anchor_t *anchor,
+                                     jit_scalar_t *args, tlab_t *tlab)
+{
+   vital_select_path_delay(args, 1);
+}
+
+static void vital_select_path_delay01(jit_func_t *func, jit_anchor_t *anchor,
+                                      jit_scalar_t *args, tlab_t *tlab)
+{
+   vital_select_path_delay(args, 2);
+}
+
+static void vital_select_path_delay01z(jit_func_t *func, jit_anchor_t *anchor,
+                                       jit_scalar_t *args, tlab_t *tlab)
+{
+   vital_select_path_delay(args, 6);
+}
+
 static void std_textio_consume(jit_func_t *func, jit_anchor_t *anchor,
                                jit_scalar_t *args, tlab_t *tlab)
 {
@@ -2183,6 +3102,324 @@ static void std_textio_shrink(jit_func_t *func, jit_anchor_t *anchor,
    args[0].pointer = NULL;
 }
 
+static void std_textio_readline(jit_func_t *func, jit_anchor_t *anchor,
+                                jit_scalar_t *args, tlab_t *tlab)
+{
+   void **file = args[1].pointer;
+   ffi_uarray_t **line = args[2].pointer;
+
+   // The previous line is garbage collected
+   *line = x_file_readline(file);
+}
+
+typedef struct {
+   const uint8_t *data;
+   int64_t        high;
+   int64_t        low;
+   int            size;
+} fixed_arg_t;
+
+__attribute__((always_inline))
+static inline bool __fixed_arg(const jit_scalar_t *args, fixed_arg_t *fa)
+{
+   // The FIXED_PKG intrinsics only handle non-null descending vectors
+   // containing '0' and '1': anything else runs the VHDL body
+   fa->size = ffi_array_length(args[2].integer);
+   if (fa->size < 1 || !ffi_array_dir(args[2].integer))
+      return false;
+
+   fa->data = args[0].pointer;
+   fa->high = args[1].integer;
+   fa->low  = fa->high - fa->size + 1;
+
+   return __all_01(fa->data, fa->size);
+}
+
+__attribute__((always_inline))
+static inline const uint8_t *__fixed_align(tlab_t *tlab,
+                                           const fixed_arg_t *fa,
+                                           int64_t left, int64_t right,
+                                           bool is_signed)
+{
+   assert(left >= fa->high && right <= fa->low);
+
+   if (left == fa->high && right == fa->low)
+      return fa->data;
+
+   const int size = left - right + 1;
+   const int pad = left - fa->high;
+   uint8_t *result = __tlab_alloc(tlab, size, 8);
+
+   memset(result, is_signed ? fa->data[0] : _0, pad);
+   memcpy(result + pad, fa->data, fa->size);
+   memset(result + pad + fa->size, _0, fa->low - right);
+
+   return result;
+}
+
+__attribute__((always_inline))
+static inline bool __any_bit_not(const uint8_t *vec, int size, uint8_t bit)
+{
+   for (int i = 0; i < size; i++) {
+      if (vec[i] != bit)
+         return true;
+   }
+
+   return false;
+}
+
+static void ieee_fixed_add(jit_func_t *func, jit_anchor_t *anchor,
+                           jit_scalar_t *args, tlab_t *tlab,
+                           bool is_signed, bool subtract)
+{
+   fixed_arg_t l, r;
+   if (!__fixed_arg(args + 1, &l) || !__fixed_arg(args + 4, &r)) {
+      jit_interp_fallback(func, anchor, args, tlab);
+      return;
+   }
+
+   // ufixed(a downto b) + ufixed(c downto d) = ufixed(max(a,c)+1 downto
+   // min(b,d)) and likewise for subtraction and sfixed
+   const int64_t left = MAX(l.high, r.high) + 1;
+   const int64_t right = MIN(l.low, r.low);
+   const int size = left - right + 1;
+
+   uint8_t *result = __tlab_alloc(tlab, size, 8);
+   const uint32_t mark = __tlab_mark(tlab);
+
+   const uint8_t *lvec = __fixed_align(tlab, &l, left, right, is_signed);
+   const uint8_t *rvec = __fixed_align(tlab, &r, left, right, is_signed);
+
+   if (subtract) {
+      uint8_t *neg = __tlab_alloc(tlab, size, 8);
+      __invert_bits(rvec, size, neg);
+      (*ieee_packed_add)(lvec, neg, size, 1, result);
+   }
+   else
+      (*ieee_packed_add)(lvec, rvec, size, 0, result);
+
+   __tlab_restore(tlab, mark);
+
+   args[0].pointer = result;
+   args[1].integer = left;
+   args[2].integer = ~size;
+}
+
+static void ieee_plus_ufixed(jit_func_t *func, jit_anchor_t *anchor,
+                             jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_add(func, anchor, args, tlab, false, false);
+}
+
+static void ieee_plus_sfixed(jit_func_t *func, jit_anchor_t *anchor,
+                             jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_add(func, anchor, args, tlab, true, false);
+}
+
+static void ieee_minus_ufixed(jit_func_t *func, jit_anchor_t *anchor,
+                              jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_add(func, anchor, args, tlab, false, true);
+}
+
+static void ieee_minus_sfixed(jit_func_t *func, jit_anchor_t *anchor,
+                              jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_add(func, anchor, args, tlab, true, true);
+}
+
+static void ieee_mul_ufixed(jit_func_t *func, jit_anchor_t *anchor,
+                            jit_scalar_t *args, tlab_t *tlab)
+{
+   fixed_arg_t l, r;
+   if (!__fixed_arg(args + 1, &l) || !__fixed_arg(args + 4, &r)) {
+      jit_interp_fallback(func, anchor, args, tlab);
+      return;
+   }
+
+   // ufixed(a downto b) * ufixed(c downto d) = ufixed(a+c+1 downto b+d)
+   // which has the same bits as the NUMERIC_STD product
+   ieee_mul_unsigned(func, anchor, args, tlab);
+   args[1].integer = l.high + r.high + 1;
+}
+
+static void ieee_mul_sfixed(jit_func_t *func, jit_anchor_t *anchor,
+                            jit_scalar_t *args, tlab_t *tlab)
+{
+   fixed_arg_t l, r;
+   if (!__fixed_arg(args + 1, &l) || !__fixed_arg(args + 4, &r)) {
+      jit_interp_fallback(func, anchor, args, tlab);
+      return;
+   }
+
+   ieee_mul_signed(func, anchor, args, tlab);
+   args[1].integer = l.high + r.high + 1;
+}
+
+__attribute__((always_inline))
+static inline void __fixed_saturate(uint8_t *result, int size,
+                                    bool is_signed, bool negative)
+{
+   memset(result, negative ? _0 : _1, size);
+   if (is_signed)
+      result[0] = negative ? _1 : _0;
+}
+
+static void ieee_fixed_resize(jit_func_t *func, jit_anchor_t *anchor,
+                              jit_scalar_t *args, tlab_t *tlab,
+                              bool is_signed)
+{
+   const int64_t left = args[4].integer;
+   const int64_t right = args[5].integer;
+   const bool saturate = args[6].integer == 0;   // FIXED_SATURATE
+   const bool round = args[7].integer == 0;      // FIXED_ROUND
+
+   // Only handle the case where the new range overlaps the argument
+   // as the VHDL body has special cases for the others
+   fixed_arg_t arg;
+   if (!__fixed_arg(args + 1, &arg) || left < right
+       || right > arg.high || left < arg.low) {
+      jit_interp_fallback(func, anchor, args, tlab);
+      return;
+   }
+
+   const int size = left - right + 1;
+   uint8_t *result = __tlab_alloc(tlab, size, 8);
+
+   args[0].pointer = result;
+   args[1].integer = left;
+   args[2].integer = ~size;
+
+   const uint8_t sign = arg.data[0];
+
+   if (arg.high > left && saturate) {
+      // Saturate if any of the discarded high bits are significant
+      const int ntop = arg.high - left;
+      if (is_signed && __any_bit_not(arg.data + 1, ntop, sign)) {
+         __fixed_saturate(result, size, true, sign == _1);
+         return;
+      }
+      else if (!is_signed && __any_bit_not(arg.data, ntop, _0)) {
+         __fixed_saturate(result, size, false, false);
+         return;
+      }
+   }
+
+   const int64_t hi = MIN(arg.high, left);
+   const int64_t lo = MAX(arg.low, right);
+   const int pad = left - hi;
+
+   memset(result, is_signed && arg.high < left ? sign : _0, pad);
+   memcpy(result + pad, arg.data + arg.high - hi, hi - lo + 1);
+   memset(result + pad + hi - lo + 1, _0, lo - right);
+
+   if (round && arg.low < right) {
+      // Round to nearest with ties to even using the discarded bits
+      const uint8_t *rem = arg.data + arg.high - right + 1;
+      const int remsize = right - arg.low;
+
+      if (rem[0] == _0)
+         return;
+      else if (result[size - 1] == _0
+               && !__any_bit_not(rem + 1, remsize - 1, _0))
+         return;
+
+      const uint8_t msb = result[0];
+
+      int pos = size - 1;
+      for (; pos >= 0 && result[pos] == _1; pos--)
+         result[pos] = _0;
+
+      if (pos >= 0)
+         result[pos] = _1;
+
+      const bool overflow =
+         is_signed ? (msb == _0 && result[0] == _1) : pos < 0;
+      if (overflow && saturate)
+         __fixed_saturate(result, size, is_signed, false);
+   }
+}
+
+static void ieee_resize_ufixed(jit_func_t *func, jit_anchor_t *anchor,
+                               jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_resize(func, anchor, args, tlab, false);
+}
+
+static void ieee_resize_sfixed(jit_func_t *func, jit_anchor_t *anchor,
+                               jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_resize(func, anchor, args, tlab, true);
+}
+
+static const uint8_t logic_to_std[4] = { _0, _1, _Z, _U };
+
+// Verilog net values with strong drive strengths, see verilog-body.vhd
+static const uint8_t std_to_net[9] = {
+   219, 219, 216, 217, 2, 219, 108, 109, 219
+};
+
+static inline uint8_t __net_to_std(uint8_t net)
+{
+   // Small, medium and weak strengths map to L and H
+   const unsigned s0 = (net >> 2) & 7, s1 = (net >> 5) & 7;
+   switch (net & 3) {
+   case 0: return s0 >= 1 && s0 <= 3 ? _L : _0;
+   case 1: return s1 >= 1 && s1 <= 3 ? _H : _1;
+   case 2: return _Z;
+   default: return _U;
+   }
+}
+
+static void verilog_to_vhdl_logic(jit_func_t *func, jit_anchor_t *anchor,
+                                  jit_scalar_t *args, tlab_t *tlab)
+{
+   const int size = ffi_array_length(args[3].integer);
+   const uint8_t *input = args[1].pointer;
+
+   uint8_t *result = __tlab_alloc(tlab, size, 8);
+
+   for (int i = 0; i < size; i++)
+      result[i] = logic_to_std[input[i] & 3];
+
+   args[0].pointer = result;
+   args[1].integer = 1;
+   args[2].integer = size;
+}
+
+static void verilog_to_vhdl_wire(jit_func_t *func, jit_anchor_t *anchor,
+                                 jit_scalar_t *args, tlab_t *tlab)
+{
+   const int size = ffi_array_length(args[3].integer);
+   const uint8_t *input = args[1].pointer;
+
+   uint8_t *result = __tlab_alloc(tlab, size, 8);
+
+   for (int i = 0; i < size; i++)
+      result[i] = __net_to_std(input[i]);
+
+   args[0].pointer = result;
+   args[1].integer = 1;
+   args[2].integer = size;
+}
+
+static void verilog_to_verilog_net(jit_func_t *func, jit_anchor_t *anchor,
+                                   jit_scalar_t *args, tlab_t *tlab)
+{
+   const int size = ffi_array_length(args[3].integer);
+   const uint8_t *input = args[1].pointer;
+
+   uint8_t *result = __tlab_alloc(tlab, size, 8);
+
+   for (int i = 0; i < size; i++)
+      result[i] = std_to_net[input[i]];
+
+   args[0].pointer = result;
+   args[1].integer = 1;
+   args[2].integer = size;
+}
+
 #define UU "36IEEE.NUMERIC_STD.UNRESOLVED_UNSIGNED"
 #define U "25IEEE.NUMERIC_STD.UNSIGNED"
 #define US "34IEEE.NUMERIC_STD.UNRESOLVED_SIGNED"
@@ -2198,6 +3435,19 @@ static void std_textio_shrink(jit_func_t *func, jit_anchor_t *anchor,
 #define SS "IEEE.STD_LOGIC_SIGNED."
 #define AU "29IEEE.STD_LOGIC_ARITH.UNSIGNED"
 #define AS "27IEEE.STD_LOGIC_ARITH.SIGNED"
+#define VT "IEEE.VITAL_TIMING."
+#define VD "32IEEE.VITAL_TIMING.VITALDELAYTYPE"
+#define VD01 "34IEEE.VITAL_TIMING.VITALDELAYTYPE01"
+#define VD01Z "35IEEE.VITAL_TIMING.VITALDELAYTYPE01Z"
+#define VP "36IEEE.VITAL_TIMING.VITALPATHARRAYTYPE"
+#define VP01 "38IEEE.VITAL_TIMING.VITALPATHARRAY01TYPE"
+#define VP01Z "39IEEE.VITAL_TIMING.VITALPATHARRAY01ZTYPE"
+#define NV "NVC.VERILOG."
+#define FX "IEEE.FIXED_PKG."
+#define UF "32IEEE.FIXED_PKG.UNRESOLVED_UFIXED"
+#define SF "32IEEE.FIXED_PKG.UNRESOLVED_SFIXED"
+#define FO "48IEEE.FIXED_FLOAT_TYPES.FIXED_OVERFLOW_STYLE_TYPE"
+#define FR "45IEEE.FIXED_FLOAT_TYPES.FIXED_ROUND_STYLE_TYPE"
 
 static jit_intrinsic_t intrinsic_list[] = {
    { NS "\"+\"(" U U ")" U, ieee_plus_unsigned },
@@ -2230,12 +3480,22 @@ static jit_intrinsic_t intrinsic_list[] = {
    { NS "TO_INTEGER(" UU ")N", ieee_to_integer_unsigned },
    { NS "TO_INTEGER(" S ")I", ieee_to_integer_signed },
    { NS "TO_INTEGER(" US ")I", ieee_to_integer_signed },
+#ifdef HAVE_AVX512BW
+   { SL "TO_X01(V)V", std_to_x01_avx512, CPU_AVX512 },
+   { SL "TO_X01(Y)Y", std_to_x01_avx512, CPU_AVX512 },
+#endif
+#ifdef HAVE_AVX2
+   { SL "TO_X01(V)V", std_to_x01_avx2, CPU_AVX2 },
+   { SL "TO_X01(Y)Y", std_to_x01_avx2, CPU_AVX2 },
+#endif
 #ifdef HAVE_SSE41
    { SL "TO_X01(V)V", std_to_x01_sse41, CPU_SSE41 },
    { SL "TO_X01(Y)Y", std_to_x01_sse41, CPU_SSE41 },
 #endif
    { SL "TO_X01(V)V", std_to_x01 },
    { SL "TO_X01(Y)Y", std_to_x01 },
+   { SL "TO_HSTRING(Y)S", ieee_to_hstring },
+   { SL "TO_OSTRING(Y)S", ieee_to_ostring },
    { NS "TO_01(" U "L)" U, ieee_to_01 },
    { NS "TO_01(" UU "U)" UU, ieee_to_01 },
    { NS "TO_01(" S "L)" U, ieee_to_01 },
@@ -2244,6 +3504,48 @@ static jit_intrinsic_t intrinsic_list[] = {
    { NS "RESIZE(" UU "N)" UU, ieee_resize_unsigned },
    { NS "RESIZE(" S "N)" S, ieee_resize_signed },
    { NS "RESIZE(" US "N)" US, ieee_resize_signed },
+   { NS "SHIFT_LEFT(" U "N)" U, ieee_shift_left },
+   { NS "SHIFT_LEFT(" UU "N)" UU, ieee_shift_left },
+   { NS "SHIFT_LEFT(" S "N)" S, ieee_shift_left },
+   { NS "SHIFT_LEFT(" US "N)" US, ieee_shift_left },
+   { NS "SHIFT_RIGHT(" U "N)" U, ieee_shift_right_unsigned },
+   { NS "SHIFT_RIGHT(" UU "N)" UU, ieee_shift_right_unsigned },
+   { NS "SHIFT_RIGHT(" S "N)" S, ieee_shift_right_signed },
+   { NS "SHIFT_RIGHT(" US "N)" US, ieee_shift_right_signed },
+   { NS "\"=\"(" U U ")B", ieee_equal_unsigned },
+   { NS "\"=\"(" UU UU ")B", ieee_equal_unsigned },
+   { NS "\"=\"(" S S ")B", ieee_equal_signed },
+   { NS "\"=\"(" US US ")B", ieee_equal_signed },
+#ifdef HAVE_AVX512BW
+   { NS "STD_MATCH(" U U ")B", ieee_std_match_avx512, CPU_AVX512 },
+   { NS "STD_MATCH(" UU UU ")B", ieee_std_match_avx512, CPU_AVX512 },
+   { NS "STD_MATCH(" S S ")B", ieee_std_match_avx512, CPU_AVX512 },
+   { NS "STD_MATCH(" US US ")B", ieee_std_match_avx512, CPU_AVX512 },
+   { NS "STD_MATCH(VV)B", ieee_std_match_avx512, CPU_AVX512 },
+   { NS "STD_MATCH(YY)B", ieee_std_match_avx512, CPU_AVX512 },
+#endif
+#ifdef HAVE_AVX2
+   { NS "STD_MATCH(" U U ")B", ieee_std_match_avx2, CPU_AVX2 },
+   { NS "STD_MATCH(" UU UU ")B", ieee_std_match_avx2, CPU_AVX2 },
+   { NS "STD_MATCH(" S S ")B", ieee_std_match_avx2, CPU_AVX2 },
+   { NS "STD_MATCH(" US US ")B", ieee_std_match_avx2, CPU_AVX2 },
+   { NS "STD_MATCH(VV)B", ieee_std_match_avx2, CPU_AVX2 },
+   { NS "STD_MATCH(YY)B", ieee_std_match_avx2, CPU_AVX2 },
+#endif
+   { NS "STD_MATCH(" U U ")B", ieee_std_match },
+   { NS "STD_MATCH(" UU UU ")B", ieee_std_match },
+   { NS "STD_MATCH(" S S ")B", ieee_std_match },
+   { NS "STD_MATCH(" US US ")B", ieee_std_match },
+   { NS "STD_MATCH(VV)B", ieee_std_match },
+   { NS "STD_MATCH(YY)B", ieee_std_match },
+#ifdef HAVE_AVX512BW
+   { SL "\"and\"(VV)V", ieee_and_vector_avx512, CPU_AVX512 },
+   { SL "\"and\"(YY)Y", ieee_and_vector_avx512, CPU_AVX512 },
+#endif
+#ifdef HAVE_AVX2
+   { SL "\"and\"(VV)V", ieee_and_vector_avx2, CPU_AVX2 },
+   { SL "\"and\"(YY)Y", ieee_and_vector_avx2, CPU_AVX2 },
+#endif
 #ifdef HAVE_SSE41
    { SL "\"and\"(VV)V", ieee_and_vector_sse41, CPU_SSE41 },
    { SL "\"and\"(YY)Y", ieee_and_vector_sse41, CPU_SSE41 },
@@ -2254,6 +3556,14 @@ static jit_intrinsic_t intrinsic_list[] = {
 #endif
    { SL "\"and\"(VV)V", ieee_and_vector },
    { SL "\"and\"(YY)Y", ieee_and_vector },
+#ifdef HAVE_AVX512BW
+   { SL "\"or\"(VV)V", ieee_or_vector_avx512, CPU_AVX512 },
+   { SL "\"or\"(YY)Y", ieee_or_vector_avx512, CPU_AVX512 },
+#endif
+#ifdef HAVE_AVX2
+   { SL "\"or\"(VV)V", ieee_or_vector_avx2, CPU_AVX2 },
+   { SL "\"or\"(YY)Y", ieee_or_vector_avx2, CPU_AVX2 },
+#endif
 #ifdef HAVE_SSE41
    { SL "\"or\"(VV)V", ieee_or_vector_sse41, CPU_SSE41 },
    { SL "\"or\"(YY)Y", ieee_or_vector_sse41, CPU_SSE41 },
@@ -2264,6 +3574,14 @@ static jit_intrinsic_t intrinsic_list[] = {
 #endif
    { SL "\"or\"(VV)V", ieee_or_vector },
    { SL "\"or\"(YY)Y", ieee_or_vector },
+#ifdef HAVE_AVX512BW
+   { SL "\"xor\"(VV)V", ieee_xor_vector_avx512, CPU_AVX512 },
+   { SL "\"xor\"(YY)Y", ieee_xor_vector_avx512, CPU_AVX512 },
+#endif
+#ifdef HAVE_AVX2
+   { SL "\"xor\"(VV)V", ieee_xor_vector_avx2, CPU_AVX2 },
+   { SL "\"xor\"(YY)Y", ieee_xor_vector_avx2, CPU_AVX2 },
+#endif
 #ifdef HAVE_SSE41
    { SL "\"xor\"(VV)V", ieee_xor_vector_sse41, CPU_SSE41 },
    { SL "\"xor\"(YY)Y", ieee_xor_vector_sse41, CPU_SSE41 },
@@ -2274,6 +3592,14 @@ static jit_intrinsic_t intrinsic_list[] = {
 #endif
    { SL "\"xor\"(VV)V", std_xor_vector },
    { SL "\"xor\"(YY)Y", std_xor_vector },
+#ifdef HAVE_AVX512BW
+   { SL "\"not\"(V)V", ieee_not_vector_avx512, CPU_AVX512 },
+   { SL "\"not\"(Y)Y", ieee_not_vector_avx512, CPU_AVX512 },
+#endif
+#ifdef HAVE_AVX2
+   { SL "\"not\"(V)V", ieee_not_vector_avx2, CPU_AVX2 },
+   { SL "\"not\"(Y)Y", ieee_not_vector_avx2, CPU_AVX2 },
+#endif
 #ifdef HAVE_SSE41
    { SL "\"not\"(V)V", ieee_not_vector_sse41, CPU_SSE41 },
    { SL "\"not\"(Y)Y", ieee_not_vector_sse41, CPU_SSE41 },
@@ -2282,6 +3608,18 @@ static jit_intrinsic_t intrinsic_list[] = {
    { NS "TO_UNSIGNED(NN)" UU, ieee_to_unsigned },
    { NS "TO_SIGNED(IN)" S, ieee_to_signed },
    { NS "TO_SIGNED(IN)" US, ieee_to_signed },
+#ifdef HAVE_AVX512BW
+   { SL "\"=\"(VV)B$predef", byte_vector_equal_avx512, CPU_AVX512 },
+   { SL "\"=\"(YY)B$predef", byte_vector_equal_avx512, CPU_AVX512 },
+   { ST "\"=\"(QQ)B$predef", byte_vector_equal_avx512, CPU_AVX512 },
+   { ST "\"=\"(SS)B$predef", byte_vector_equal_avx512, CPU_AVX512 },
+#endif
+#ifdef HAVE_AVX2
+   { SL "\"=\"(VV)B$predef", byte_vector_equal_avx2, CPU_AVX2 },
+   { SL "\"=\"(YY)B$predef", byte_vector_equal_avx2, CPU_AVX2 },
+   { ST "\"=\"(QQ)B$predef", byte_vector_equal_avx2, CPU_AVX2 },
+   { ST "\"=\"(SS)B$predef", byte_vector_equal_avx2, CPU_AVX2 },
+#endif
 #ifdef HAVE_SSE41
    { SL "\"=\"(VV)B$predef", byte_vector_equal_sse41, CPU_SSE41 },
    { SL "\"=\"(YY)B$predef", byte_vector_equal_sse41, CPU_SSE41 },
@@ -2309,8 +3647,10 @@ static jit_intrinsic_t intrinsic_list[] = {
    { MR "\"**\"(RR)R", ieee_math_pow_real },
    { MR "\"**\"(IR)R", ieee_math_pow_integer },
    { MR "EXP(R)R", ieee_math_exp },
+   { MR "UNIFORM(PPR)", ieee_math_uniform },
    { TI "CONSUME(" LN "N)", std_textio_consume },
    { TI "SHRINK(" LN "N)", std_textio_shrink },
+   { TI "READLINE(15STD.TEXTIO.TEXT" LN ")", std_textio_readline },
    { SA "\"+\"(" AU AU ")" AU, synopsys_plus_unsigned },
    { SA "\"+\"(" AU AU ")V", synopsys_plus_unsigned },
    { SU "\"+\"(VV)V", synopsys_plus_unsigned },
@@ -2347,6 +3687,24 @@ static jit_intrinsic_t intrinsic_list[] = {
    { SA "\"=\"(" AS AS ")B", synopsys_eql_signed },
    { SS "\"=\"(VV)B", synopsys_eql_signed },
    { SS "\"=\"(YY)B", synopsys_eql_signed },
+   { FX "\"+\"(" UF UF ")" UF, ieee_plus_ufixed },
+   { FX "\"+\"(" SF SF ")" SF, ieee_plus_sfixed },
+   { FX "\"-\"(" UF UF ")" UF, ieee_minus_ufixed },
+   { FX "\"-\"(" SF SF ")" SF, ieee_minus_sfixed },
+   { FX "\"*\"(" UF UF ")" UF, ieee_mul_ufixed },
+   { FX "\"*\"(" SF SF ")" SF, ieee_mul_sfixed },
+   { FX "RESIZE(" UF "II" FO FR ")" UF, ieee_resize_ufixed },
+   { FX "RESIZE(" SF "II" FO FR ")" SF, ieee_resize_sfixed },
+   { NV "TO_VHDL(" T_LOGIC_ARRAY ")Y", verilog_to_vhdl_logic },
+   { NV "TO_VHDL(" T_WIRE_ARRAY ")Y", verilog_to_vhdl_wire },
+   { NV "TO_VERILOG(Y)" T_NET_ARRAY, verilog_to_verilog_net },
+   { VT "VITALCALCDELAY(UU" VD01 ")T", vital_calc_delay01 },
+   { VT "VITALCALCDELAY(UU" VD01Z ")T", vital_calc_delay01z },
+   { VT "VITALSELECTPATHDELAY(LLS" VP VD "B)T", vital_select_path_delay0 },
+   { VT "VITALSELECTPATHDELAY(LLS" VP01 VD01 "B)T",
+     vital_select_path_delay01 },
+   { VT "VITALSELECTPATHDELAY(LLS" VP01Z VD01Z "B)T",
+     vital_select_path_delay01z },
    { NULL, NULL }
 };
 
@@ -2374,6 +3732,10 @@ jit_entry_fn_t jit_bind_intrinsic(ident_t name)
          if (want_vector && __builtin_cpu_supports("avx2"))
             mask |= CPU_AVX2;
 #endif
+#ifdef HAVE_AVX512BW
+         if (want_vector && __builtin_cpu_supports("avx512bw"))
+            mask |= CPU_AVX512;
+#endif
 #ifdef HAVE_NEON
          if (want_vector)
             mask |= CPU_NEON;
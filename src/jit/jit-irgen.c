@@ -26,6 +26,7 @@
 #include "mir/mir-node.h"
 #include "mir/mir-unit.h"
 #include "option.h"
+#include "rt/mspace.h"
 #include "rt/rt.h"
 #include "tree.h"
 
@@ -42,6 +43,7 @@ typedef A(jit_value_t) value_list_t;
 
 #define PATCH_CHUNK_SZ  4
 #define MAX_STACK_ALLOC 65536
+#define MAX_STACK_TEMP  4096
 #define DEDUP_PREFIX    16384
 
 struct _patch_list {
@@ -1402,12 +1404,23 @@ static void irgen_op_set(jit_irgen_t *g, mir_value_t n)
 
    mir_type_t type = mir_get_type(g->mu, n);
 
+   const int scale = irgen_size_bytes(g, type);
+   const bool is_zero = value.kind == JIT_VALUE_INT64 && value.int64 == 0;
+
+   if (is_zero && length.kind == JIT_VALUE_INT64
+       && length.int64 * scale >= LARGE_OBJECT_SIZE) {
+      // Avoid making every page of a large sparse array resident
+      j_send(g, 0, base);
+      j_send(g, 1, jit_value_from_int64(length.int64 * scale));
+      macro_exit(g, JIT_EXIT_BZERO);
+      return;
+   }
+
    jit_value_t addr = jit_addr_from_value(base, 0);
-   jit_value_t scale = jit_value_from_int64(irgen_size_bytes(g, type));
    jit_value_t bytes = irgen_alloc_temp(g);
-   j_mul(g, bytes, length, scale);
+   j_mul(g, bytes, length, jit_value_from_int64(scale));
 
-   if (value.kind == JIT_VALUE_INT64 && value.int64 == 0)
+   if (is_zero)
       macro_bzero(g, addr, bytes);
    else if (value.kind == JIT_VALUE_DOUBLE) {
       jit_value_t bits = jit_value_from_int64(value.int64);
@@ -1628,13 +1641,40 @@ static void irgen_op_mul(jit_irgen_t *g, mir_value_t n)
       j_mul(g, g->map[n.id], arg0, arg1);
 }
 
+static int irgen_pow2_divisor(jit_value_t numer, jit_value_t denom)
+{
+   // Returns log2 of the divisor if division can be replaced by shifts
+   if (numer.kind != JIT_VALUE_REG || denom.kind != JIT_VALUE_INT64)
+      return 0;
+   else if (denom.int64 <= 1 || !is_power_of_2(denom.int64))
+      return 0;
+   else
+      return ilog2(denom.int64);
+}
+
+static jit_value_t irgen_pow2_bias(jit_irgen_t *g, jit_value_t numer, int k)
+{
+   // Adjustment added to a negative dividend so that an arithmetic
+   // shift right by K rounds towards zero: 2^K - 1 if negative else 0
+   jit_value_t bias = irgen_alloc_temp(g);
+   j_asr(g, bias, numer, jit_value_from_int64(63));
+   j_shr(g, bias, bias, jit_value_from_int64(64 - k));
+   return bias;
+}
+
 static void irgen_op_div(jit_irgen_t *g, mir_value_t n)
 {
    jit_value_t arg0 = irgen_get_arg(g, n, 0);
    jit_value_t arg1 = irgen_get_arg(g, n, 1);
 
+   int k;
    if (mir_is(g->mu, n, MIR_TYPE_REAL))
       j_fdiv(g, g->map[n.id], arg0, arg1);
+   else if ((k = irgen_pow2_divisor(arg0, arg1)) > 0) {
+      jit_value_t bias = irgen_pow2_bias(g, arg0, k);
+      j_add(g, g->map[n.id], arg0, bias);
+      j_asr(g, g->map[n.id], g->map[n.id], jit_value_from_int64(k));
+   }
    else
       j_div(g, g->map[n.id], arg0, arg1);
 }
@@ -1646,6 +1686,8 @@ static void irgen_op_exp(jit_irgen_t *g, mir_value_t n)
 
    if (mir_is(g->mu, n, MIR_TYPE_REAL))
       macro_fexp(g, g->map[n.id], arg0, arg1);
+   else if (arg1.kind == JIT_VALUE_INT64 && arg1.int64 == 2)
+      j_mul(g, g->map[n.id], arg0, arg0);
    else
       macro_exp(g, JIT_SZ_UNSPEC, JIT_CC_NONE, g->map[n.id], arg0, arg1);
 }
@@ -1775,6 +1817,13 @@ static void irgen_op_mod(jit_irgen_t *g, mir_value_t n)
    //      r = r + denom;
 
    jit_value_t r = g->map[n.id];
+
+   if (irgen_pow2_divisor(numer, denom) > 0) {
+      // The result always has the sign of the positive divisor
+      j_and(g, r, numer, jit_value_from_int64(denom.int64 - 1));
+      return;
+   }
+
    j_rem(g, r, numer, denom);
 
    irgen_label_t *l1 = irgen_alloc_label(g);
@@ -1802,7 +1851,17 @@ static void irgen_op_rem(jit_irgen_t *g, mir_value_t n)
    jit_value_t arg0 = irgen_get_arg(g, n, 0);
    jit_value_t arg1 = irgen_get_arg(g, n, 1);
 
-   j_rem(g, g->map[n.id], arg0, arg1);
+   const int k = irgen_pow2_divisor(arg0, arg1);
+   if (k > 0) {
+      // Result has the sign of the dividend: ((x + bias) & mask) - bias
+      jit_value_t mask = jit_value_from_int64(arg1.int64 - 1);
+      jit_value_t bias = irgen_pow2_bias(g, arg0, k);
+      j_add(g, g->map[n.id], arg0, bias);
+      j_and(g, g->map[n.id], g->map[n.id], mask);
+      j_sub(g, g->map[n.id], g->map[n.id], bias);
+   }
+   else
+      j_rem(g, g->map[n.id], arg0, arg1);
 }
 
 static void irgen_op_cmp(jit_irgen_t *g, mir_value_t n)
@@ -3054,6 +3113,16 @@ static void irgen_op_alloc(jit_irgen_t *g, mir_value_t n)
 
    const int bytes = irgen_size_bytes(g, type);
 
+   int64_t cval;
+   if (mir_get_mem(g->mu, n) == MIR_MEM_STACK
+       && mir_get_const(g->mu, mir_get_arg(g->mu, n, 0), &cval)
+       && cval * bytes <= MAX_STACK_TEMP
+       && g->func->framesz + cval * bytes <= MAX_STACK_ALLOC) {
+      // Does not escape the function so allocate in the stack frame
+      macro_salloc(g, g->map[n.id], cval * bytes);
+      return;
+   }
+
    jit_value_t count = irgen_get_arg(g, n, 0);
    jit_value_t total = irgen_alloc_temp(g);
    j_mul(g, total, count, jit_value_from_int64(bytes));
@@ -3457,6 +3526,7 @@ static void irgen_op_transfer_signal(jit_irgen_t *g, mir_value_t n)
    jit_value_t count   = irgen_get_arg(g, n, 2);
    jit_value_t reject  = irgen_get_arg(g, n, 3);
    jit_value_t after   = irgen_get_arg(g, n, 4);
+   jit_value_t kind    = irgen_get_arg(g, n, 5);
 
    j_send(g, 0, target);
    j_send(g, 1, toffset);
@@ -3465,6 +3535,7 @@ static void irgen_op_transfer_signal(jit_irgen_t *g, mir_value_t n)
    j_send(g, 4, count);
    j_send(g, 5, after);
    j_send(g, 6, reject);
+   j_send(g, 7, kind);
 
    macro_exit(g, JIT_EXIT_TRANSFER_SIGNAL);
 }
@@ -3903,6 +3974,19 @@ static void irgen_op_or_trigger(jit_irgen_t *g, mir_value_t n)
    j_recv(g, g->map[n.id], 0);
 }
 
+static void irgen_op_and_trigger(jit_irgen_t *g, mir_value_t n)
+{
+   jit_value_t left = irgen_get_arg(g, n, 0);
+   jit_value_t right = irgen_get_arg(g, n, 1);
+
+   j_send(g, 0, left);
+   j_send(g, 1, right);
+
+   macro_exit(g, JIT_EXIT_AND_TRIGGER);
+
+   j_recv(g, g->map[n.id], 0);
+}
+
 static void irgen_op_cmp_trigger(jit_irgen_t *g, mir_value_t n)
 {
    jit_value_t shared = irgen_get_arg_slot(g, n, 0, 0);
@@ -3933,6 +4017,21 @@ static void irgen_op_level_trigger(jit_irgen_t *g, mir_value_t n)
    j_recv(g, g->map[n.id], 0);
 }
 
+static void irgen_op_edge_trigger(jit_irgen_t *g, mir_value_t n)
+{
+   jit_value_t shared = irgen_get_arg_slot(g, n, 0, 0);
+   jit_value_t offset = irgen_get_arg_slot(g, n, 0, 1);
+   jit_value_t edge = irgen_get_arg(g, n, 1);
+
+   j_send(g, 0, shared);
+   j_send(g, 1, offset);
+   j_send(g, 2, edge);
+
+   macro_exit(g, JIT_EXIT_EDGE_TRIGGER);
+
+   j_recv(g, g->map[n.id], 0);
+}
+
 static void irgen_op_add_trigger(jit_irgen_t *g, mir_value_t n)
 {
    jit_value_t trigger = irgen_get_arg(g, n, 0);
@@ -5138,12 +5237,18 @@ static void irgen_block(jit_irgen_t *g, mir_block_t block)
       case MIR_OP_OR_TRIGGER:
          irgen_op_or_trigger(g, n);
          break;
+      case MIR_OP_AND_TRIGGER:
+         irgen_op_and_trigger(g, n);
+         break;
       case MIR_OP_CMP_TRIGGER:
          irgen_op_cmp_trigger(g, n);
          break;
       case MIR_OP_LEVEL_TRIGGER:
          irgen_op_level_trigger(g, n);
          break;
+      case MIR_OP_EDGE_TRIGGER:
+         irgen_op_edge_trigger(g, n);
+         break;
       case MIR_OP_ADD_TRIGGER:
          irgen_op_add_trigger(g, n);
          break;
@@ -5650,7 +5755,7 @@ void jit_irgen(jit_func_t *f, mir_unit_t *mu)
    assert(f->irbuf == NULL);
 
    const bool debug_log = opt_get_int(OPT_JIT_LOG) && f->name != NULL;
-   const uint64_t start_ticks = debug_log ? get_timestamp_us() : 0;
+   const uint64_t start_ticks = get_timestamp_us();
 
    const int num_nodes = mir_count_nodes(mu, MIR_NULL_BLOCK);
 
@@ -5712,6 +5817,9 @@ void jit_irgen(jit_func_t *f, mir_unit_t *mu)
    }
    g->labels = NULL;
 
+   const uint64_t opt_ticks = get_timestamp_us();
+   f->stats.irgen_us = opt_ticks - start_ticks;
+
    if (mir_get_kind(mu) != MIR_UNIT_THUNK) {
       jit_do_mem2reg(f);
       jit_do_lvn(f);
@@ -5720,6 +5828,8 @@ void jit_irgen(jit_func_t *f, mir_unit_t *mu)
       jit_delete_nops(f);
    }
 
+   f->stats.opt_us = get_timestamp_us() - opt_ticks;
+
    // Function can be executed immediately after this store
    store_release(&(f->state), JIT_FUNC_READY);
 
@@ -25,6 +25,7 @@
 #include "type.h"
 
 #include <assert.h>
+#include <stdlib.h>
 
 static int count_sub_elements(type_t type)
 {
@@ -67,14 +68,28 @@ static void print_layout(type_t type, const jit_layout_t *l, bool signal)
    nvc_printf("$$\n");
 }
 
+static const jit_layout_t *cache_layout(chash_t *cache, type_t type,
+                                        jit_layout_t *l)
+{
+   // Another thread may have computed the layout of the same type
+   // concurrently in which case discard this copy
+   jit_layout_t *existing = chash_cas(cache, type, NULL, l);
+   if (existing != NULL) {
+      free(l);
+      return existing;
+   }
+
+   return l;
+}
+
 const jit_layout_t *layout_of(type_t type)
 {
    assert(type_frozen(type));   // Not safe to cache otherwise
-   static hash_t *cache = NULL;
+   static chash_t *cache = NULL;
 
-   INIT_ONCE(cache = hash_new(256));
+   INIT_ONCE(cache = chash_new(256));
 
-   jit_layout_t *l = hash_get(cache, type);
+   jit_layout_t *l = chash_get(cache, type);
    if (l != NULL)
       return l;
 
@@ -177,18 +192,17 @@ const jit_layout_t *layout_of(type_t type)
    if (opt_get_int(OPT_LAYOUT_VERBOSE))
       print_layout(type, l, false);
 
-   hash_put(cache, type, l);
-   return l;
+   return cache_layout(cache, type, l);
 }
 
 const jit_layout_t *signal_layout_of(type_t type)
  {
    assert(type_frozen(type));   // Not safe to cache otherwise
-   static hash_t *cache = NULL;
+   static chash_t *cache = NULL;
 
-   INIT_ONCE(cache = hash_new(256));
+   INIT_ONCE(cache = chash_new(256));
 
-   jit_layout_t *l = hash_get(cache, type);
+   jit_layout_t *l = chash_get(cache, type);
    if (l != NULL)
       return l;
 
@@ -315,6 +329,5 @@ const jit_layout_t *signal_layout_of(type_t type)
    if (opt_get_int(OPT_LAYOUT_VERBOSE))
       print_layout(type, l, true);
 
-   hash_put(cache, type, l);
-   return l;
+   return cache_layout(cache, type, l);
 }
@@ -25,13 +25,18 @@
 #include "option.h"
 #include "rt/rt.h"
 #include "thread.h"
+#include "thirdparty/sha1.h"
 
 #include <assert.h>
+#include <fcntl.h>
 #include <libgen.h>
 #include <stdlib.h>
 #include <limits.h>
 #include <string.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include <llvm-c/Analysis.h>
 #include <llvm-c/Core.h>
@@ -186,6 +191,7 @@ typedef struct _llvm_obj {
    LLVMTypeRef           fntypes[LLVM_LAST_FN];
    LLVMValueRef          strtab;
    unsigned              opt_hint;
+   bool                  relocatable;
 } llvm_obj_t;
 
 typedef struct _cgen_block {
@@ -287,6 +293,25 @@ static LLVMValueRef llvm_ptr(llvm_obj_t *obj, void *ptr)
                             obj->types[LLVM_PTR]);
 }
 
+static LLVMValueRef llvm_extern_ptr(llvm_obj_t *obj, const char *name,
+                                    ptrdiff_t disp)
+{
+   // Address of an external symbol resolved when the object is loaded
+   // which allows the generated code to be cached between runs
+   LLVMValueRef global = LLVMGetNamedGlobal(obj->module, name);
+   if (global == NULL) {
+      global = LLVMAddGlobal(obj->module, obj->types[LLVM_INT8], name);
+      LLVMSetLinkage(global, LLVMExternalLinkage);
+   }
+
+   if (disp == 0)
+      return global;
+
+   LLVMValueRef indexes[] = { llvm_intptr(obj, disp) };
+   return LLVMBuildGEP2(obj->builder, obj->types[LLVM_INT8],
+                        global, indexes, 1, "");
+}
+
 static LLVMValueRef llvm_real(llvm_obj_t *obj, double r)
 {
    return LLVMConstReal(obj->types[LLVM_DOUBLE], r);
@@ -340,6 +365,16 @@ static void llvm_add_func_attr(llvm_obj_t *obj, LLVMValueRef fn,
    LLVMAddAttributeAtIndex(fn, param, ref);
 }
 
+static void llvm_set_cold_call(llvm_obj_t *obj, LLVMValueRef call)
+{
+   const unsigned kind = LLVMGetEnumAttributeKindForName("cold", 4);
+   if (kind == 0)
+      fatal_trace("Cannot get LLVM attribute for cold");
+
+   LLVMAttributeRef ref = LLVMCreateEnumAttribute(obj->context, kind, 0);
+   LLVMAddCallSiteAttribute(call, LLVMAttributeFunctionIndex, ref);
+}
+
 static void llvm_register_types(llvm_obj_t *obj)
 {
    obj->types[LLVM_VOID]   = LLVMVoidTypeInContext(obj->context);
@@ -1164,7 +1199,10 @@ static LLVMValueRef cgen_get_value(llvm_obj_t *obj, cgen_block_t *cgb,
       return llvm_real(obj, value.dval);
    case JIT_ADDR_CPOOL:
       assert(value.int64 >= 0 && value.int64 <= cgb->func->source->cpoolsz);
-      return llvm_ptr(obj, cgb->func->source->cpool + value.int64);
+      if (obj->relocatable)
+         return llvm_extern_ptr(obj, "__nvc_cpool", value.int64);
+      else
+         return llvm_ptr(obj, cgb->func->source->cpool + value.int64);
    case JIT_ADDR_REG:
       {
          assert(value.reg < cgb->func->source->nregs);
@@ -1190,7 +1228,17 @@ static LLVMValueRef cgen_get_value(llvm_obj_t *obj, cgen_block_t *cgb,
    case JIT_ADDR_ABS:
       return llvm_ptr(obj, (void *)(intptr_t)value.int64);
    case JIT_VALUE_LOCUS:
-      return llvm_ptr(obj, value.locus);
+      if (obj->relocatable && value.locus != NULL) {
+         ident_t module;
+         ptrdiff_t offset;
+         object_locus(value.locus, &module, &offset);
+
+         LOCAL_TEXT_BUF tb = tb_new();
+         tb_printf(tb, "__nvc_locus.%s+%td", istr(module), offset);
+         return llvm_extern_ptr(obj, tb_get(tb), 0);
+      }
+      else
+         return llvm_ptr(obj, value.locus);
    default:
       fatal_trace("cannot handle value kind %d", value.kind);
    }
@@ -1341,6 +1389,9 @@ static void cgen_debug_loc(llvm_obj_t *obj, cgen_func_t *func, const loc_t *loc)
 
 static LLVMValueRef cgen_maybe_inline(llvm_obj_t *obj, jit_func_t *callee)
 {
+   if (obj->relocatable)
+      return NULL;   // Constant pool of callee cannot be relocated
+
    if (load_acquire(&callee->state) != JIT_FUNC_READY)
       return NULL;
 
@@ -1887,7 +1938,14 @@ static void cgen_op_call(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
 
    jit_func_t *callee = jit_get_func(cgb->func->source->jit, ir->arg1.handle);
 
-   LLVMValueRef fptr = llvm_ptr(obj, callee);
+   LLVMValueRef fptr;
+   if (obj->relocatable) {
+      LOCAL_TEXT_BUF tb = tb_new();
+      tb_printf(tb, "__nvc_func.%s", istr(callee->name));
+      fptr = llvm_extern_ptr(obj, tb_get(tb), 0);
+   }
+   else
+      fptr = llvm_ptr(obj, callee);
 
    LLVMValueRef entry = cgen_maybe_inline(obj, callee);
    if (entry == NULL) {
@@ -2009,7 +2067,18 @@ static void cgen_macro_move(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
    LLVMValueRef dest  = cgen_coerce_value(obj, cgb, ir->arg1, LLVM_PTR);
    LLVMValueRef src   = cgen_coerce_value(obj, cgb, ir->arg2, LLVM_PTR);
 
-   LLVMBuildMemMove(obj->builder, dest, 0, src, 0, count);
+#ifdef LLVM_HAS_OPAQUE_POINTERS
+   if (LLVMIsConstant(count) && LLVMConstIntGetZExtValue(count) - 1 < 64) {
+      // Loading the whole source before storing is safe with overlap
+      const unsigned bytes = LLVMConstIntGetZExtValue(count);
+      LLVMTypeRef type = LLVMVectorType(obj->types[LLVM_INT8], bytes);
+      LLVMValueRef value = LLVMBuildLoad2(obj->builder, type, src, "");
+      LLVMSetAlignment(value, 1);
+      LLVMSetAlignment(LLVMBuildStore(obj->builder, value, dest), 1);
+   }
+   else
+#endif
+      LLVMBuildMemMove(obj->builder, dest, 0, src, 0, count);
 }
 
 static void cgen_macro_bzero(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
@@ -2040,7 +2109,7 @@ static void cgen_macro_memset(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
                                           LLVM_INT8 + ir->size);
 
    if (ir->size == JIT_SZ_8) {
-#ifdef LLVM_HAS_OPAQUE_POINTERSS
+#ifdef LLVM_HAS_OPAQUE_POINTERS
       if (LLVMIsConstant(count) && LLVMConstIntGetZExtValue(count) <= 64) {
          LLVMValueRef args[] = {
             dest,
@@ -2060,6 +2129,25 @@ static void cgen_macro_memset(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
    }
 }
 
+static bool cgen_is_failure_exit(jit_exit_t which)
+{
+   switch (which) {
+   case JIT_EXIT_INDEX_FAIL:
+   case JIT_EXIT_OVERFLOW:
+   case JIT_EXIT_NULL_DEREF:
+   case JIT_EXIT_LENGTH_FAIL:
+   case JIT_EXIT_UNREACHABLE:
+   case JIT_EXIT_DIV_ZERO:
+   case JIT_EXIT_EXPONENT_FAIL:
+   case JIT_EXIT_ASSERT_FAIL:
+   case JIT_EXIT_RANGE_FAIL:
+   case JIT_EXIT_DIR_FAIL:
+      return true;
+   default:
+      return false;
+   }
+}
+
 static void cgen_macro_exit(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
 {
    cgen_sync_irpos(obj, cgb, ir);
@@ -2119,7 +2207,12 @@ static void cgen_macro_exit(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
             cgb->func->args,
             cgb->func->tlab,
          };
-         llvm_call_fn(obj, LLVM_DO_EXIT, args, ARRAY_LEN(args));
+         LLVMValueRef call =
+            llvm_call_fn(obj, LLVM_DO_EXIT, args, ARRAY_LEN(args));
+
+         // Lets LLVM move the block containing the call out of line
+         if (cgen_is_failure_exit(ir->arg1.exit))
+            llvm_set_cold_call(obj, call);
       }
       break;
    }
@@ -2162,7 +2255,13 @@ static void cgen_macro_salloc(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
 {
    LLVMBasicBlockRef old_bb = LLVMGetInsertBlock(obj->builder);
    LLVMBasicBlockRef first_bb = LLVMGetFirstBasicBlock(cgb->func->llvmfn);
-   LLVMPositionBuilderAtEnd(obj->builder, first_bb);
+
+   // Temporaries may be allocated after the entry block is complete
+   LLVMValueRef term = LLVMGetBasicBlockTerminator(first_bb);
+   if (term != NULL)
+      LLVMPositionBuilderBefore(obj->builder, term);
+   else
+      LLVMPositionBuilderAtEnd(obj->builder, first_bb);
 
    assert(ir->arg2.kind == JIT_VALUE_INT64);
 
@@ -2181,7 +2280,14 @@ static void cgen_macro_salloc(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
 static void cgen_macro_getpriv(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
 {
    jit_func_t *f = jit_get_func(cgb->func->source->jit, ir->arg1.handle);
-   LLVMValueRef ptrptr = llvm_ptr(obj, jit_get_privdata_ptr(f->jit, f));
+   LLVMValueRef ptrptr;
+   if (obj->relocatable) {
+      LOCAL_TEXT_BUF tb = tb_new();
+      tb_printf(tb, "__nvc_priv.%s", istr(f->name));
+      ptrptr = llvm_extern_ptr(obj, tb_get(tb), 0);
+   }
+   else
+      ptrptr = llvm_ptr(obj, jit_get_privdata_ptr(f->jit, f));
 
 #ifndef LLVM_HAS_OPAQUE_POINTERS
    LLVMTypeRef ptr_type = LLVMPointerType(obj->types[LLVM_PTR], 0);
@@ -3141,7 +3247,8 @@ static void cgen_memset_body(llvm_obj_t *obj, llvm_fn_t which,
 // JIT plugin interface
 
 typedef struct {
-   code_cache_t *code;
+   code_cache_t         *code;
+   LLVMTargetMachineRef  machines[MAX_THREADS];
 } llvm_jit_state_t;
 
 static void *jit_llvm_init(jit_t *jit)
@@ -3154,6 +3261,219 @@ static void *jit_llvm_init(jit_t *jit)
    return state;
 }
 
+static void llvm_hash_bytes(SHA1_CTX *ctx, const void *data, size_t size)
+{
+   SHA1Update(ctx, data, size);
+}
+
+static void llvm_hash_str(SHA1_CTX *ctx, const char *str)
+{
+   SHA1Update(ctx, (const unsigned char *)str, strlen(str) + 1);
+}
+
+static bool llvm_hash_value(SHA1_CTX *ctx, jit_t *j, jit_value_t value)
+{
+   // Only hash the fields used by each kind of value as the others
+   // may be uninitialised
+   llvm_hash_bytes(ctx, &value.kind, sizeof(value.kind));
+
+   switch (value.kind) {
+   case JIT_VALUE_INVALID:
+      return true;
+   case JIT_VALUE_REG:
+      llvm_hash_bytes(ctx, &value.reg, sizeof(value.reg));
+      return true;
+   case JIT_VALUE_INT64:
+      llvm_hash_bytes(ctx, &value.int64, sizeof(value.int64));
+      return true;
+   case JIT_ADDR_REG:
+      llvm_hash_bytes(ctx, &value.disp, sizeof(value.disp));
+      llvm_hash_bytes(ctx, &value.reg, sizeof(value.reg));
+      return true;
+   case JIT_ADDR_CPOOL:
+      llvm_hash_bytes(ctx, &value.disp, sizeof(value.disp));
+      llvm_hash_bytes(ctx, &value.int64, sizeof(value.int64));
+      return true;
+   case JIT_ADDR_ABS:
+      // Absolute addresses other than null cannot be relocated
+      llvm_hash_bytes(ctx, &value.disp, sizeof(value.disp));
+      llvm_hash_bytes(ctx, &value.int64, sizeof(value.int64));
+      return value.int64 == 0;
+   case JIT_VALUE_DOUBLE:
+      llvm_hash_bytes(ctx, &value.dval, sizeof(value.dval));
+      return true;
+   case JIT_VALUE_LABEL:
+      llvm_hash_bytes(ctx, &value.label, sizeof(value.label));
+      return true;
+   case JIT_VALUE_HANDLE:
+      // Handles are embedded in the generated code so must match exactly
+      llvm_hash_bytes(ctx, &value.handle, sizeof(value.handle));
+      if (value.handle != JIT_HANDLE_INVALID)
+         llvm_hash_str(ctx, istr(jit_get_name(j, value.handle)));
+      return true;
+   case JIT_VALUE_EXIT:
+      llvm_hash_bytes(ctx, &value.exit, sizeof(value.exit));
+      return true;
+   case JIT_VALUE_LOC:
+      {
+         const uint32_t fields[] = {
+            value.loc.first_line, value.loc.first_column,
+            value.loc.line_delta, value.loc.column_delta
+         };
+         llvm_hash_bytes(ctx, fields, sizeof(fields));
+         llvm_hash_str(ctx, loc_file_str(&value.loc) ?: "");
+      }
+      return true;
+   case JIT_VALUE_VPOS:
+      llvm_hash_bytes(ctx, &value.vpos, sizeof(value.vpos));
+      return true;
+   case JIT_VALUE_LOCUS:
+      if (value.locus != NULL) {
+         ident_t module;
+         ptrdiff_t offset;
+         object_locus(value.locus, &module, &offset);
+
+         llvm_hash_str(ctx, istr(module));
+         llvm_hash_bytes(ctx, &offset, sizeof(offset));
+      }
+      return true;
+   default:
+      return false;
+   }
+}
+
+static bool llvm_cache_key(jit_func_t *f, const char *triple,
+                           char key[SHA_HEX_LEN])
+{
+   SHA1_CTX ctx;
+   SHA1Init(&ctx);
+
+   llvm_hash_str(&ctx, PACKAGE_VERSION);
+   llvm_hash_str(&ctx, LLVM_VERSION);
+   llvm_hash_str(&ctx, triple);
+   llvm_hash_str(&ctx, istr(f->name));
+
+   const unsigned sizes[] = {
+      f->framesz, f->nirs, f->nregs, f->nvars, f->cpoolsz
+   };
+   llvm_hash_bytes(&ctx, sizes, sizeof(sizes));
+   llvm_hash_bytes(&ctx, f->cpool, f->cpoolsz);
+
+   for (int i = 0; i < f->nirs; i++) {
+      const jit_ir_t *ir = &(f->irbuf[i]);
+      const uint32_t fields[] = {
+         ir->op, ir->size, ir->target, ir->cc, ir->result
+      };
+      llvm_hash_bytes(&ctx, fields, sizeof(fields));
+
+      if (!llvm_hash_value(&ctx, f->jit, ir->arg1))
+         return false;
+      else if (!llvm_hash_value(&ctx, f->jit, ir->arg2))
+         return false;
+   }
+
+   unsigned char hash[SHA1_LEN];
+   SHA1Final(hash, &ctx);
+
+   for (int i = 0; i < SHA1_LEN; i++)
+      snprintf(key + i * 2, 3, "%02x", hash[i]);
+
+   return true;
+}
+
+static void *llvm_cache_resolve(const char *name, void *ctx)
+{
+   jit_func_t *f = ctx;
+
+   if (strcmp(name, "__nvc_cpool") == 0)
+      return f->cpool;
+   else if (strncmp(name, "__nvc_func.", 11) == 0) {
+      jit_handle_t handle = jit_lazy_compile(f->jit, ident_new(name + 11));
+      if (handle == JIT_HANDLE_INVALID)
+         return NULL;
+
+      return jit_get_func(f->jit, handle);
+   }
+   else if (strncmp(name, "__nvc_priv.", 11) == 0) {
+      jit_handle_t handle = jit_lazy_compile(f->jit, ident_new(name + 11));
+      if (handle == JIT_HANDLE_INVALID)
+         return NULL;
+
+      return jit_get_privdata_ptr(f->jit, jit_get_func(f->jit, handle));
+   }
+   else if (strncmp(name, "__nvc_locus.", 12) == 0) {
+      const char *plus = strrchr(name, '+');
+      if (plus == NULL)
+         return NULL;
+
+      char *module LOCAL = xstrndup(name + 12, plus - name - 12);
+      ptrdiff_t offset = strtoll(plus + 1, NULL, 10);
+
+      return object_from_locus(ident_new(module), offset, lib_load_handler);
+   }
+   else
+      return NULL;
+}
+
+static bool llvm_cache_load(code_cache_t *code, jit_func_t *f,
+                            const char *dir, const char *key)
+{
+   char *path LOCAL = xasprintf("%s/%s.o", dir, key);
+
+   int fd = open(path, O_RDONLY);
+   if (fd < 0)
+      return false;
+
+   struct stat st;
+   if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      close(fd);
+      return false;
+   }
+
+   void *data = map_file(fd, st.st_size);
+   close(fd);
+
+   code_blob_t *blob = code_blob_new(code, f->name, st.st_size);
+   if (blob == NULL) {
+      unmap_file(data, st.st_size);
+      return true;
+   }
+
+   blob->resolve = llvm_cache_resolve;
+   blob->resolve_ctx = f;
+
+   const uint8_t *base = blob->wptr;
+   code_load_object(blob, data, st.st_size);
+
+   const size_t size = blob->wptr - base;
+   f->stats.code_bytes = code_blob_finalise(blob, &(f->entry));
+
+   unmap_file(data, st.st_size);
+
+   if (opt_get_int(OPT_JIT_LOG))
+      debugf("%s at %p [%zu bytes from cache]", istr(f->name), base, size);
+
+   return true;
+}
+
+static void llvm_cache_store(const char *dir, const char *key,
+                             const void *data, size_t size)
+{
+   char *tmp LOCAL = xasprintf("%s/%s.o.%d", dir, key, getpid());
+   char *path LOCAL = xasprintf("%s/%s.o", dir, key);
+
+   FILE *f = fopen(tmp, "wb");
+   if (f == NULL)
+      return;
+
+   const bool ok = fwrite(data, size, 1, f) == 1;
+   fclose(f);
+
+   // Rename is atomic so concurrent readers never see a partial object
+   if (!ok || rename(tmp, path) != 0)
+      remove(tmp);
+}
+
 static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
 {
    llvm_jit_state_t *state = context;
@@ -3168,12 +3488,32 @@ static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
 
    const uint64_t start_us = get_timestamp_us();
 
-   LLVMTargetMachineRef tm = llvm_target_machine(LLVMRelocStatic,
-                                                 JIT_CODE_MODEL);
+   char key[SHA_HEX_LEN];
+   const char *cache_dir = opt_get_str(OPT_JIT_CACHE);
+   if (cache_dir != NULL) {
+      char *triple = LLVMGetDefaultTargetTriple();
+      if (!llvm_cache_key(f, triple, key))
+         cache_dir = NULL;
+      LLVMDisposeMessage(triple);
+   }
+
+   if (cache_dir != NULL && llvm_cache_load(state->code, f, cache_dir, key))
+      return;
+
+   // Functions may be compiled concurrently on several worker threads
+   // so each thread keeps its own target machine but a fresh context is
+   // created for every function to bound the memory it accumulates:
+   // creating a target machine is cheap so this only avoids churn
+   LLVMTargetMachineRef *tm_slot = &(state->machines[thread_id()]);
+   if (*tm_slot == NULL)
+      *tm_slot = llvm_target_machine(LLVMRelocStatic, JIT_CODE_MODEL);
+
+   LLVMTargetMachineRef tm = *tm_slot;
 
    llvm_obj_t obj = {
-      .context = LLVMContextCreate(),
-      .target  = tm,
+      .context     = LLVMContextCreate(),
+      .target      = tm,
+      .relocatable = cache_dir != NULL,
    };
 
    LOCAL_TEXT_BUF tb = tb_new();
@@ -3235,17 +3575,25 @@ static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
 
    const size_t objsz = LLVMGetBufferSize(buf);
 
+   if (cache_dir != NULL)
+      llvm_cache_store(cache_dir, key, LLVMGetBufferStart(buf), objsz);
+
    code_blob_t *blob = code_blob_new(state->code, f->name, objsz);
    if (blob == NULL)
       return;
 
+   if (obj.relocatable) {
+      blob->resolve = llvm_cache_resolve;
+      blob->resolve_ctx = f;
+   }
+
    const uint8_t *base = blob->wptr;
    const void *entry_addr = blob->wptr;
 
    code_load_object(blob, LLVMGetBufferStart(buf), objsz);
 
    const size_t size = blob->wptr - base;
-   code_blob_finalise(blob, &(f->entry));
+   f->stats.code_bytes = code_blob_finalise(blob, &(f->entry));
 
    if (opt_get_int(OPT_JIT_LOG)) {
       const uint64_t end_us = get_timestamp_us();
@@ -3258,7 +3606,6 @@ static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
 
  skip_emit:
    LLVMDisposeTargetData(obj.data_ref);
-   LLVMDisposeTargetMachine(tm);
    LLVMDisposeBuilder(obj.builder);
    DWARF_ONLY(LLVMDisposeDIBuilder(obj.debuginfo));
    LLVMContextDispose(obj.context);
@@ -3269,6 +3616,12 @@ static void jit_llvm_cleanup(void *context)
 {
    llvm_jit_state_t *state = context;
    code_cache_free(state->code);
+
+   for (int i = 0; i < MAX_THREADS; i++) {
+      if (state->machines[i] != NULL)
+         LLVMDisposeTargetMachine(state->machines[i]);
+   }
+
    free(state);
 }
 
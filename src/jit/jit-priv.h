@@ -177,6 +177,9 @@ typedef enum {
    JIT_EXIT_SCHED_INACTIVE,
    JIT_EXIT_GET_COUNTERS,
    JIT_EXIT_SCHED_ACTIVE,
+   JIT_EXIT_AND_TRIGGER,
+   JIT_EXIT_EDGE_TRIGGER,
+   JIT_EXIT_BZERO,
 } jit_exit_t;
 
 typedef uint16_t jit_reg_t;
@@ -324,6 +327,14 @@ typedef struct {
    unsigned offset;
 } link_tab_t;
 
+typedef struct {
+   uint32_t irgen_us;        // Lowering MIR to JIT IR
+   uint32_t opt_us;          // JIT IR optimisation passes
+   uint32_t cgen_us;         // Native code generation including LLVM
+   uint32_t code_bytes;
+   uint32_t interp_calls;    // Interpreted calls counted towards tier-up
+} jit_func_stats_t;
+
 typedef struct _jit_func {
    jit_entry_fn_t  entry;    // Must be first
    func_state_t    state;
@@ -340,9 +351,11 @@ typedef struct _jit_func {
    unsigned        cpoolsz;
    jit_handle_t    handle;
    unsigned        hotness;
+   unsigned        heat;
    jit_tier_t     *next_tier;
    ffi_spec_t      spec;
    object_t       *object;
+   jit_func_stats_t stats;
 } jit_func_t;
 
 // The code generator knows the layout of this struct
@@ -370,14 +383,18 @@ typedef struct _code_cache code_cache_t;
 typedef struct _code_span code_span_t;
 typedef struct _patch_list patch_list_t;
 
+typedef void *(*code_resolve_fn_t)(const char *, void *);
+
 typedef struct {
-   code_span_t  *span;
-   jit_func_t   *func;
-   uint8_t      *wptr;
-   ihash_t      *labels;
-   patch_list_t *patches;
-   uint8_t      *veneers;
-   bool          overflow;
+   code_span_t       *span;
+   jit_func_t        *func;
+   uint8_t           *wptr;
+   ihash_t           *labels;
+   patch_list_t      *patches;
+   uint8_t           *veneers;
+   bool               overflow;
+   code_resolve_fn_t  resolve;
+   void              *resolve_ctx;
 } code_blob_t;
 
 #define JIT_MAX_ARGS 64
@@ -394,6 +411,8 @@ const char *jit_cc_name(jit_cc_t cc);
 const char *jit_exit_name(jit_exit_t exit);
 void jit_interp(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
                 tlab_t *tlab);
+void jit_interp_fallback(jit_func_t *f, jit_anchor_t *caller,
+                         jit_scalar_t *args, tlab_t *tlab);
 jit_func_t *jit_get_func(jit_t *j, jit_handle_t handle);
 void jit_hexdump(const unsigned char *data, size_t sz, int blocksz,
                  const void *highlight, const char *prefix);
@@ -441,7 +460,7 @@ typedef void (*code_patch_fn_t)(code_blob_t *, jit_label_t, uint8_t *,
 code_blob_t *code_blob_new(code_cache_t *code, ident_t name, size_t hint);
 void code_blob_emit(code_blob_t *blob, const uint8_t *bytes, size_t len);
 void code_blob_align(code_blob_t *blob, unsigned align);
-void code_blob_finalise(code_blob_t *blob, jit_entry_fn_t *entry);
+size_t code_blob_finalise(code_blob_t *blob, jit_entry_fn_t *entry);
 void code_blob_mark(code_blob_t *blob, jit_label_t label);
 void code_blob_patch(code_blob_t *blob, jit_label_t label, code_patch_fn_t fn);
 void code_load_object(code_blob_t *blob, const void *data, size_t size);
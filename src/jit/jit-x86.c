@@ -38,6 +38,10 @@ typedef enum {
    TLAB_STUB,
    FEXP_STUB,
    ROUND_STUB,
+   TIER_STUB,
+   PACK_STUB,
+   UNPACK_STUB,
+   VEC4OP_STUB,
 
    NUM_STUBS
 } jit_x86_stub_t;
@@ -194,6 +198,7 @@ typedef enum {
 #define AND(dst, src, size) asm_and(blob, (dst), (src), (size))
 #define OR(dst, src, size) asm_or(blob, (dst), (src), (size))
 #define SHL(src, size) asm_shl(blob, (src), (size))
+#define SHR(src, size) asm_shr(blob, (src), (size))
 #define SAR(src, count, size) asm_sar(blob, (src), (count), (size))
 #define XOR(dst, src, size) asm_xor(blob, (dst), (src), (size))
 #define NEG(dst, size) asm_neg(blob, (dst), (size))
@@ -864,6 +869,18 @@ static void asm_shl(code_blob_t *blob, x86_operand_t src, x86_size_t size)
    x86_emit(blob, &insn);
 }
 
+static void asm_shr(code_blob_t *blob, x86_operand_t src, x86_size_t size)
+{
+   x86_insn_t insn = {};
+
+   assert(src.kind == X86_REG);
+   x86_rex(&insn, size, src.reg, 0, 0);
+   x86_opcode(&insn, 0xd3);
+   x86_modrm(&insn, 3, 5, src.reg);
+
+   x86_emit(blob, &insn);
+}
+
 static void asm_sar(code_blob_t *blob, x86_operand_t src, x86_operand_t count,
                     x86_size_t size)
 {
@@ -1753,6 +1770,17 @@ static void jit_x86_shl(code_blob_t *blob, jit_ir_t *ir,
    jit_x86_put(blob, ir->result, __EAX, slots);
 }
 
+static void jit_x86_shr(code_blob_t *blob, jit_ir_t *ir,
+                        const phys_slot_t *slots)
+{
+   jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
+   jit_x86_get_copy(blob, __ECX, ir->arg2, slots);
+
+   SHR(__EAX, __QWORD);
+
+   jit_x86_put(blob, ir->result, __EAX, slots);
+}
+
 static void jit_x86_asr(code_blob_t *blob, jit_ir_t *ir,
                         const phys_slot_t *slots)
 {
@@ -1824,12 +1852,8 @@ static void jit_x86_fneg(code_blob_t *blob, jit_ir_t *ir,
    jit_x86_put(blob, ir->result, __XMM1, slots);
 }
 
-static void jit_x86_fcmp(code_blob_t *blob, jit_ir_t *ir,
-                         const phys_slot_t *slots)
+static void jit_x86_fcmp_flags(code_blob_t *blob, jit_ir_t *ir)
 {
-   jit_x86_get_copy(blob, __XMM0, ir->arg1, slots);
-   jit_x86_get_copy(blob, __XMM1, ir->arg2, slots);
-
    UCOMISD(__XMM0, __XMM1);
 
    switch (ir->cc) {
@@ -1856,6 +1880,28 @@ static void jit_x86_fcmp(code_blob_t *blob, jit_ir_t *ir,
    }
 }
 
+static void jit_x86_fcmp(code_blob_t *blob, jit_ir_t *ir,
+                         const phys_slot_t *slots)
+{
+   jit_x86_get_copy(blob, __XMM0, ir->arg1, slots);
+   jit_x86_get_copy(blob, __XMM1, ir->arg2, slots);
+
+   jit_x86_fcmp_flags(blob, ir);
+}
+
+static void jit_x86_fccmp(code_blob_t *blob, jit_ir_t *ir,
+                          const phys_slot_t *slots)
+{
+   jit_x86_get_copy(blob, __XMM0, ir->arg1, slots);
+   jit_x86_get_copy(blob, __XMM1, ir->arg2, slots);
+
+   MOV(__EDX, FLAGS_REG, __DWORD);
+
+   jit_x86_fcmp_flags(blob, ir);
+
+   AND(FLAGS_REG, __EDX, __BYTE);
+}
+
 static void jit_x86_fcvtns(code_blob_t *blob, jit_x86_state_t *state,
                            jit_ir_t *ir, const phys_slot_t *slots)
 {
@@ -1934,9 +1980,63 @@ static void jit_x86_macro_bzero(code_blob_t *blob, jit_ir_t *ir,
    REPSTOS(__BYTE);
 }
 
+static bool jit_x86_const_count(code_blob_t *blob, jit_ir_t *ir,
+                                int64_t *count)
+{
+   // The byte count is always a register but is usually loaded from a
+   // constant by the instruction immediately before
+   if (ir == blob->func->irbuf || ir->target)
+      return false;
+
+   const jit_ir_t *prev = ir - 1;
+   if (prev->op != J_MOV || prev->result != ir->result)
+      return false;
+   else if (prev->arg1.kind != JIT_VALUE_INT64)
+      return false;
+
+   *count = prev->arg1.int64;
+   return true;
+}
+
+static void jit_x86_small_copy(code_blob_t *blob, jit_ir_t *ir,
+                               const phys_slot_t *slots, int64_t count)
+{
+   // Copy COUNT <= 16 bytes with at most two possibly overlapping
+   // loads into registers followed by two stores which is also safe
+   // if the source and destination overlap
+   assert(count > 0 && count <= 16);
+
+   int chunk = 1;
+   while (chunk * 2 <= count && chunk < 8)
+      chunk *= 2;
+
+   const x86_size_t size = chunk == 8 ? __QWORD : chunk == 4 ? __DWORD
+      : chunk == 2 ? __WORD : __BYTE;
+
+   PUSH(__ESI);
+
+   jit_x86_get_copy(blob, __EDI, ir->arg1, slots);
+   jit_x86_get_copy(blob, __ESI, ir->arg2, slots);
+
+   MOV(__EAX, ADDR(__ESI, 0), size);
+   if (count > chunk) {
+      MOV(__ECX, ADDR(__ESI, count - chunk), size);
+      MOV(ADDR(__EDI, count - chunk), __ECX, size);
+   }
+   MOV(ADDR(__EDI, 0), __EAX, size);
+
+   POP(__ESI);
+}
+
 static void jit_x86_macro_copy(code_blob_t *blob, jit_ir_t *ir,
                                const phys_slot_t *slots)
 {
+   int64_t count;
+   if (jit_x86_const_count(blob, ir, &count) && count > 0 && count <= 16) {
+      jit_x86_small_copy(blob, ir, slots, count);
+      return;
+   }
+
    PUSH(__ESI);
 
    jit_x86_get_copy(blob, __EDI, ir->arg1, slots);
@@ -1951,6 +2051,12 @@ static void jit_x86_macro_copy(code_blob_t *blob, jit_ir_t *ir,
 static void jit_x86_macro_move(code_blob_t *blob, jit_ir_t *ir,
                                const phys_slot_t *slots)
 {
+   int64_t count;
+   if (jit_x86_const_count(blob, ir, &count) && count > 0 && count <= 16) {
+      jit_x86_small_copy(blob, ir, slots, count);
+      return;
+   }
+
    PUSH(__ESI);
 
    jit_x86_get_copy(blob, __EDI, ir->arg1, slots);
@@ -2044,6 +2150,74 @@ static void jit_x86_macro_case(code_blob_t *blob, jit_ir_t *ir,
    code_blob_patch(blob, ir->arg2.label, jit_x86_patch);
 }
 
+static int jit_x86_case_table(code_blob_t *blob, jit_ir_t *ir,
+                              const phys_slot_t *slots)
+{
+   // Replace a long chain of $CASE macros with dense constant choices
+   // by an indexed jump into a table of relative jumps
+
+   if (ir > blob->func->irbuf && (ir - 1)->op == MACRO_CASE
+       && (ir - 1)->result == ir->result)
+      return 0;   // Not the start of the chain
+
+   jit_ir_t *endir = blob->func->irbuf + blob->func->nirs;
+
+   int64_t low = INT64_MAX, high = INT64_MIN;
+   int ncases = 0;
+   for (jit_ir_t *p = ir; p < endir && p->op == MACRO_CASE
+           && p->result == ir->result; p++, ncases++) {
+      if (p->arg1.kind != JIT_VALUE_INT64)
+         return 0;
+      else if (p != ir && p->target)
+         return 0;
+
+      low = MIN(low, p->arg1.int64);
+      high = MAX(high, p->arg1.int64);
+   }
+
+   // Keep the table at most four times the number of choices and ensure
+   // every jump across it was estimated to need a 32-bit displacement
+   if (ncases < 8 || (uint64_t)high - (uint64_t)low >= ncases * 4)
+      return 0;
+
+   const int range = high - low + 1;
+
+   jit_x86_get_reg(blob, __EAX, ir->result, slots);
+   MOV(__ECX, IMM(low), __QWORD);
+   SUB(__EAX, __ECX, __QWORD);
+   MOV(__ECX, IMM(range), __DWORD);
+   CMP(__EAX, __ECX, __QWORD);
+
+   const int tablesz = range * 5;
+   const int jae = 7 + 4 + 3 + 2 + tablesz;
+   __(0x0f, 0x83, jae & 0xff, (jae >> 8) & 0xff, (jae >> 16) & 0xff,
+      (jae >> 24) & 0xff);                        // JAE past table
+   __(0x48, 0x8d, 0x0d, 9, 0, 0, 0);              // LEA RCX, [RIP+9]
+   __(0x48, 0x8d, 0x04, 0x80);                    // LEA RAX, [RAX+RAX*4]
+   __(0x48, 0x01, 0xc1);                          // ADD RCX, RAX
+   __(0xff, 0xe1);                                // JMP RCX
+
+   for (int i = 0; i < range; i++) {
+      jit_ir_t *match = NULL;
+      for (int j = 0; j < ncases && match == NULL; j++) {
+         if (ir[j].arg1.int64 == low + i)
+            match = &(ir[j]);
+      }
+
+      if (match != NULL) {
+         JMP(PATCH(INT32_MAX));
+         code_blob_patch(blob, match->arg2.label, jit_x86_patch);
+      }
+      else {
+         const int rel = (range - i - 1) * 5;
+         __(0xe9, rel & 0xff, (rel >> 8) & 0xff, (rel >> 16) & 0xff,
+            (rel >> 24) & 0xff);                  // Fall through
+      }
+   }
+
+   return ncases;
+}
+
 static void jit_x86_macro_exp(code_blob_t *blob, jit_ir_t *ir,
                               const phys_slot_t *slots)
 {
@@ -2081,6 +2255,37 @@ static void jit_x86_macro_trim(code_blob_t *blob, jit_ir_t *ir)
    MOV(ADDR(TLAB_REG, offsetof(tlab_t, alloc)), __EAX, __DWORD);
 }
 
+static void jit_x86_macro_pack(code_blob_t *blob, jit_x86_state_t *state,
+                               jit_ir_t *ir, const phys_slot_t *slots)
+{
+   jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
+   jit_x86_get_copy(blob, __ECX, ir->arg2, slots);
+
+   CALL(PTR(state->stubs[PACK_STUB]));
+}
+
+static void jit_x86_macro_unpack(code_blob_t *blob, jit_x86_state_t *state,
+                                 jit_ir_t *ir, const phys_slot_t *slots)
+{
+   jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
+   jit_x86_get_copy(blob, __ECX, ir->arg2, slots);
+
+   CALL(PTR(state->stubs[UNPACK_STUB]));
+}
+
+static void jit_x86_macro_vec4op(code_blob_t *blob, jit_x86_state_t *state,
+                                 jit_ir_t *ir)
+{
+   const ptrdiff_t off = offsetof(jit_anchor_t, irpos);
+   MOV(__EAX, IMM(ir - blob->func->irbuf), __DWORD);
+   MOV(ADDR(__EBP, ANCHOR_OFFSET + off), __EAX, __DWORD);
+
+   MOV(__EAX, IMM(ir->arg1.int64), __DWORD);
+   MOV(__ECX, IMM(ir->arg2.int64), __DWORD);
+
+   CALL(PTR(state->stubs[VEC4OP_STUB]));
+}
+
 static void jit_x86_op(code_blob_t *blob, jit_x86_state_t *state, jit_ir_t *ir,
                        const phys_slot_t *slots)
 {
@@ -2166,6 +2371,9 @@ static void jit_x86_op(code_blob_t *blob, jit_x86_state_t *state, jit_ir_t *ir,
    case J_SHL:
       jit_x86_shl(blob, ir, slots);
       break;
+   case J_SHR:
+      jit_x86_shr(blob, ir, slots);
+      break;
    case J_ASR:
       jit_x86_asr(blob, ir, slots);
       break;
@@ -2190,6 +2398,9 @@ static void jit_x86_op(code_blob_t *blob, jit_x86_state_t *state, jit_ir_t *ir,
    case J_FCMP:
       jit_x86_fcmp(blob, ir, slots);
       break;
+   case J_FCCMP:
+      jit_x86_fccmp(blob, ir, slots);
+      break;
    case J_FCVTNS:
       jit_x86_fcvtns(blob, state, ir, slots);
       break;
@@ -2238,12 +2449,37 @@ static void jit_x86_op(code_blob_t *blob, jit_x86_state_t *state, jit_ir_t *ir,
    case MACRO_TRIM:
       jit_x86_macro_trim(blob, ir);
       break;
+   case MACRO_PACK:
+      jit_x86_macro_pack(blob, state, ir, slots);
+      break;
+   case MACRO_UNPACK:
+      jit_x86_macro_unpack(blob, state, ir, slots);
+      break;
+   case MACRO_VEC4OP:
+      jit_x86_macro_vec4op(blob, state, ir);
+      break;
    default:
       jit_dump_with_mark(blob->func, ir - blob->func->irbuf);
       fatal_trace("unhandled opcode %s in x86 backend", jit_op_name(ir->op));
    }
 }
 
+static bool jit_x86_can_compile(jit_func_t *f)
+{
+   for (int i = 0; i < f->nirs; i++) {
+      switch (f->irbuf[i].op) {
+      case MACRO_REEXEC:
+      case MACRO_SADD:
+      case MACRO_VEC2OP:
+         return false;   // Leave these to the next tier
+      default:
+         break;
+      }
+   }
+
+   return true;
+}
+
 static void jit_x86_cgen(jit_t *j, jit_handle_t handle, void *context)
 {
    jit_x86_state_t *state = context;
@@ -2256,6 +2492,9 @@ static void jit_x86_cgen(jit_t *j, jit_handle_t handle, void *context)
       return;
 #endif
 
+   if (!jit_x86_can_compile(f))
+      return;
+
    code_blob_t *blob = code_blob_new(state->code, f->name, 0);
    if (blob == NULL)
       return;
@@ -2331,10 +2570,31 @@ static void jit_x86_cgen(jit_t *j, jit_handle_t handle, void *context)
 
    STATIC_ASSERT(ANCHOR_OFFSET == -24);
 
+   if (f->next_tier != NULL) {
+      // Count calls until the function is hot enough for the next
+      // tier: the counter is shared with other threads so only the one
+      // which takes it to zero calls jit_tier_up
+      const ptrdiff_t off = offsetof(jit_func_t, hotness);
+      STATIC_ASSERT(offsetof(jit_func_t, hotness) < 128);
+      MOV(__EAX, ADDR(__EBP, -16), __QWORD);
+      __(0xf0, 0x83, 0x68, off, 0x01);   // LOCK SUB DWORD [RAX+off], 1
+      JNZ(IMM(5));
+      CALL(PTR(state->stubs[TIER_STUB]));
+   }
+
    for (int i = 0; i < f->nirs; i++) {
       if (f->irbuf[i].target)
          code_blob_mark(blob, i);
       code_blob_print_ir(blob, &(f->irbuf[i]));
+
+      if (f->irbuf[i].op == MACRO_CASE) {
+         const int ncases = jit_x86_case_table(blob, &(f->irbuf[i]), slots);
+         if (ncases > 0) {
+            i += ncases - 1;
+            continue;
+         }
+      }
+
       jit_x86_op(blob, state, &(f->irbuf[i]), slots);
    }
 
@@ -2355,7 +2615,7 @@ static void jit_x86_cgen(jit_t *j, jit_handle_t handle, void *context)
    LEAVE();
    RET();
 
-   code_blob_finalise(blob, &(f->entry));
+   f->stats.code_bytes = code_blob_finalise(blob, &(f->entry));
 }
 
 static void jit_x86_gen_exit_stub(jit_x86_state_t *state)
@@ -2539,6 +2799,88 @@ static void jit_x86_gen_round_stub(jit_x86_state_t *state)
    code_blob_finalise(blob, &(state->stubs[ROUND_STUB]));
 }
 
+static void jit_x86_tier_up(jit_func_t *f)
+{
+   if (f->next_tier != NULL)
+      jit_tier_up(f);
+}
+
+static void jit_x86_gen_tier_stub(jit_x86_state_t *state)
+{
+   ident_t name = ident_new("tier stub");
+   code_blob_t *blob = code_blob_new(state->code, name, 0);
+
+   SUB(__ESP, IMM(8), __QWORD);   // Ensure stack aligned
+
+   jit_x86_push_call_clobbered(blob);
+
+   // Function pointer in EAX
+   MOV(CARG0_REG, __EAX, __QWORD);
+
+   MOV(__EAX, PTR(jit_x86_tier_up), __QWORD);
+   CALL(__EAX);
+
+   jit_x86_pop_call_clobbered(blob);
+
+   ADD(__ESP, IMM(8), __QWORD);
+   RET();
+
+   code_blob_finalise(blob, &(state->stubs[TIER_STUB]));
+}
+
+static void jit_x86_gen_args_stub(jit_x86_state_t *state, const char *what,
+                                  void *fn, jit_x86_stub_t which)
+{
+   ident_t name = ident_new(what);
+   code_blob_t *blob = code_blob_new(state->code, name, 0);
+
+   SUB(__ESP, IMM(8), __QWORD);   // Ensure stack aligned
+
+   jit_x86_push_call_clobbered(blob);
+
+   // First argument in EAX, second in ECX, results written to the
+   // argument array
+   MOV(CARG1_REG, __ECX, __QWORD);
+   MOV(CARG0_REG, __EAX, __QWORD);
+   MOV(CARG2_REG, ARGS_REG, __QWORD);
+
+   MOV(__EAX, PTR(fn), __QWORD);
+   CALL(__EAX);
+
+   jit_x86_pop_call_clobbered(blob);
+
+   ADD(__ESP, IMM(8), __QWORD);
+   RET();
+
+   code_blob_finalise(blob, &(state->stubs[which]));
+}
+
+static void jit_x86_gen_vec4op_stub(jit_x86_state_t *state)
+{
+   ident_t name = ident_new("vec4op stub");
+   code_blob_t *blob = code_blob_new(state->code, name, 0);
+
+   SUB(__ESP, IMM(8), __QWORD);   // Ensure stack aligned
+
+   jit_x86_push_call_clobbered(blob);
+
+   // Operation in EAX, size in ECX
+   MOV(CARG3_REG, __ECX, __DWORD);
+   MOV(CARG0_REG, __EAX, __DWORD);
+   LEA(CARG1_REG, ADDR(__EBP, ANCHOR_OFFSET));
+   MOV(CARG2_REG, ARGS_REG, __QWORD);
+
+   MOV(__EAX, PTR(__nvc_vec4op), __QWORD);
+   CALL(__EAX);
+
+   jit_x86_pop_call_clobbered(blob);
+
+   ADD(__ESP, IMM(8), __QWORD);
+   RET();
+
+   code_blob_finalise(blob, &(state->stubs[VEC4OP_STUB]));
+}
+
 static void *jit_x86_init(jit_t *jit)
 {
    jit_x86_state_t *state = xcalloc(sizeof(jit_x86_state_t));
@@ -2550,6 +2892,10 @@ static void *jit_x86_init(jit_t *jit)
    jit_x86_gen_alloc_stub(state);
    jit_x86_gen_tlab_stub(state);
    jit_x86_gen_fexp_stub(state);
+   jit_x86_gen_tier_stub(state);
+   jit_x86_gen_args_stub(state, "pack stub", __nvc_pack, PACK_STUB);
+   jit_x86_gen_args_stub(state, "unpack stub", __nvc_unpack, UNPACK_STUB);
+   jit_x86_gen_vec4op_stub(state);
    DEBUG_ONLY(jit_x86_gen_debug_stub(state));
 
    if (!__builtin_cpu_supports("sse4.1"))
@@ -2574,9 +2920,9 @@ static const jit_plugin_t jit_x86 = {
 
 void jit_register_native_plugin(jit_t *j)
 {
-   const int threshold = opt_get_int(OPT_JIT_THRESHOLD);
+   const int threshold = opt_get_int(OPT_NATIVE_THRESHOLD);
    if (threshold > 0)
       jit_add_tier(j, threshold, &jit_x86);
    else if (threshold < 0)
-      warnf("invalid NVC_JIT_THRESOLD setting %d", threshold);
+      warnf("invalid NVC_NATIVE_THRESHOLD setting %d", threshold);
 }
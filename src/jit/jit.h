@@ -39,6 +39,13 @@ typedef struct {
    void (*cleanup)(void *);
 } jit_plugin_t;
 
+typedef struct {
+   unsigned functions;
+   unsigned interpreted;
+   unsigned compiled;
+   unsigned pending;
+} jit_tier_stats_t;
+
 typedef struct {
    loc_t     loc;
    object_t *object;
@@ -56,6 +63,7 @@ jit_t *jit_new(unit_registry_t *ur, mir_context_t *mc);
 void jit_free(jit_t *j);
 jit_handle_t jit_compile(jit_t *j, ident_t name);
 jit_handle_t jit_lazy_compile(jit_t *j, ident_t name);
+void jit_precompile(jit_t *j, jit_handle_t handle);
 jit_handle_t jit_assemble(jit_t *j, ident_t name, const char *text);
 void *jit_link(jit_t *j, jit_handle_t handle);
 void *jit_get_frame_var(jit_t *j, jit_handle_t handle, void *p, ident_t name);
@@ -71,6 +79,7 @@ void jit_register_llvm_plugin(jit_t *j);
 void jit_interrupt(jit_t *j, jit_irq_fn_t fn, void *ctx);
 void jit_check_interrupt(jit_t *j);
 void jit_reset(jit_t *j);
+void jit_get_tier_stats(jit_t *j, jit_tier_stats_t *stats);
 bool jit_is_shutdown(jit_t *j);
 
 void *jit_mspace_alloc(size_t size) RETURNS_NONNULL;
@@ -16,6 +16,7 @@
 //
 
 #include "util.h"
+#include "array.h"
 #include "common.h"
 #include "diag.h"
 #include "fbuf.h"
@@ -24,6 +25,8 @@
 #include "lib.h"
 #include "object.h"
 #include "option.h"
+#include "thread.h"
+#include "timeline.h"
 #include "tree.h"
 #include "vlog/vlog-node.h"
 #include "vlog/vlog-util.h"
@@ -855,7 +858,13 @@ static void lib_read_meta(fbuf_t *f, unit_meta_t *meta)
       read_raw(meta->cover_file, len + 1, f);
    }
 
-   meta->no_collapse = fbuf_get_uint(f);
+   const unsigned collapse = fbuf_get_uint(f);
+   meta->no_collapse = !!(collapse & 1);
+   meta->aggressive_collapse = !!(collapse & 2);
+   meta->prune_sensitivity = !!(collapse & 4);
+
+   if (collapse & 8)
+      meta->static_size = fbuf_get_uint(f);
 }
 
 static lib_unit_t *lib_read_unit(lib_t lib, ident_t id)
@@ -1063,7 +1072,16 @@ static void lib_save_unit(lib_t lib, lib_unit_t *unit)
    LOCAL_TEXT_BUF tb = tb_new();
    lib_encode_file_name(unit->name, tb);
 
-   fbuf_t *f = lib_fbuf_open(lib, tb_get(tb), FBUF_OUT, FBUF_CS_ADLER32);
+   // Uncompressed units can be read directly from the mapped file
+   const fbuf_zip_t zip =
+      opt_get_int(OPT_LIB_COMPRESS) ? FBUF_ZIP_ZSTD : FBUF_ZIP_NONE;
+
+   fbuf_t *f = NULL;
+   if (lib->path != NULL) {
+      LOCAL_TEXT_BUF path = lib_file_path(lib, tb_get(tb));
+      f = fbuf_open_zip(tb_get(path), FBUF_OUT, FBUF_CS_ADLER32, zip);
+   }
+
    if (f == NULL)
       fatal("failed to create %s in library %s", tb_get(tb), istr(lib->name));
 
@@ -1076,7 +1094,9 @@ static void lib_save_unit(lib_t lib, lib_unit_t *unit)
 
    object_write(unit->object, f, ident_ctx, loc_ctx);
 
-   if (unit->meta.cover_file != NULL || unit->meta.no_collapse) {
+   if (unit->meta.cover_file != NULL || unit->meta.no_collapse
+       || unit->meta.aggressive_collapse || unit->meta.prune_sensitivity
+       || unit->meta.static_size > 0) {
       write_u8('M', f);
 
       if (unit->meta.cover_file != NULL) {
@@ -1087,7 +1107,13 @@ static void lib_save_unit(lib_t lib, lib_unit_t *unit)
       else
          fbuf_put_uint(f, 0);
 
-      fbuf_put_uint(f, unit->meta.no_collapse);
+      fbuf_put_uint(f, unit->meta.no_collapse
+                    | (unit->meta.aggressive_collapse << 1)
+                    | (unit->meta.prune_sensitivity << 2)
+                    | ((unit->meta.static_size > 0) << 3));
+
+      if (unit->meta.static_size > 0)
+         fbuf_put_uint(f, unit->meta.static_size);
    }
 
    write_u8('\0', f);
@@ -1104,16 +1130,101 @@ static void lib_save_unit(lib_t lib, lib_unit_t *unit)
    unit->dirty = false;
 }
 
+typedef struct {
+   lib_t        lib;
+   lib_unit_t **units;
+   int          count;
+} save_batch_t;
+
+typedef struct {
+   hash_t *map;
+   bool    ready;
+} save_deps_t;
+
+static void lib_save_batch_cb(void *context, void *arg)
+{
+   save_batch_t *b = arg;
+
+   for (int i = 0; i < b->count; i++)
+      lib_save_unit(b->lib, b->units[i]);
+}
+
+static void lib_save_deps_cb(object_t *obj, void *ctx)
+{
+   save_deps_t *sd = ctx;
+
+   lib_unit_t *dep = hash_get(sd->map, obj);
+   if (dep != NULL && dep->dirty)
+      sd->ready = false;
+}
+
+static void lib_save_parallel(lib_t lib, lib_unit_t **units, int count,
+                              int jobs)
+{
+   // The checksum of each dependency is written into the unit file so
+   // units are saved in waves where every unit in a wave only depends
+   // on units saved in an earlier wave
+
+   hash_t *map = hash_new(count * 2);
+   for (int i = 0; i < count; i++)
+      hash_put(map, units[i]->object, units[i]);
+
+   workq_t *wq = workq_new(lib);
+
+   lib_unit_t **ready = xmalloc_array(count, sizeof(lib_unit_t *));
+   save_batch_t *batches = xmalloc_array(jobs, sizeof(save_batch_t));
+
+   for (int remain = count; remain > 0; ) {
+      int nready = 0;
+      for (int i = 0; i < count; i++) {
+         if (!units[i]->dirty)
+            continue;
+
+         save_deps_t sd = { map, true };
+         arena_walk_deps(object_arena(units[i]->object),
+                         lib_save_deps_cb, &sd);
+
+         if (sd.ready)
+            ready[nready++] = units[i];
+      }
+
+      assert(nready > 0);
+
+      const int nbatches = MIN(jobs, nready);
+      for (int i = 0, pos = 0; i < nbatches; i++) {
+         batches[i].lib   = lib;
+         batches[i].units = ready + pos;
+         batches[i].count = (nready - pos) / (nbatches - i);
+         pos += batches[i].count;
+
+         workq_do(wq, lib_save_batch_cb, &(batches[i]));
+      }
+
+      workq_start(wq);
+      workq_drain(wq);
+
+      remain -= nready;
+   }
+
+   free(batches);
+   free(ready);
+   workq_free(wq);
+   hash_free(map);
+}
+
 void lib_save(lib_t lib)
 {
    assert(lib != NULL);
 
    assert(lib->lock_fd != -1);   // Should not be called in unit tests
    lib_ensure_writable(lib);
-   file_write_lock(lib->lock_fd);
+
+   TIMELINE_BEGIN("save", istr(lib->name));
 
    freeze_global_arena();
 
+   A(lib_unit_t *) dirty = AINIT;
+
    for (lib_unit_t *lu = lib->units; lu; lu = lu->next) {
       if (lu->dirty) {
          if (lu->error)
@@ -1122,11 +1233,25 @@ void lib_save(lib_t lib)
          else {
             arena_walk_obsolete_deps(object_arena(lu->object),
                                      lib_obsolete_cb, lu);
-            lib_save_unit(lib, lu);
+            APUSH(dirty, lu);
          }
       }
    }
 
+   const int jobs = opt_get_int(OPT_JOBS);
+   if (jobs > 1 && dirty.count > 1)
+      lib_save_parallel(lib, dirty.items, dirty.count, jobs);
+   else {
+      for (int i = 0; i < dirty.count; i++)
+         lib_save_unit(lib, dirty.items[i]);
+   }
+
+   ACLEAR(dirty);
+
+   // Unit files are replaced atomically so the library lock is only
+   // needed to serialise updates to the index
+   file_write_lock(lib->lock_fd);
+
    LOCAL_TEXT_BUF index_path = lib_file_path(lib, "_index");
    file_info_t info;
    if (get_file_info(tb_get(index_path), &info)) {
@@ -1163,6 +1288,8 @@ void lib_save(lib_t lib)
    lib->index_size  = info.size;
 
    file_unlock(lib->lock_fd);
+
+   TIMELINE_END("save");
 }
 
 void lib_walk_index(lib_t lib, lib_index_fn_t fn, void *context)
@@ -26,8 +26,11 @@
 #include "prim.h"
 
 typedef struct {
-   char *cover_file;
-   bool  no_collapse;
+   char   *cover_file;
+   bool    no_collapse;
+   bool    aggressive_collapse;
+   bool    prune_sensitivity;
+   size_t  static_size;   // Model memory used by elaboration
 } unit_meta_t;
 
 lib_t lib_find(ident_t name);
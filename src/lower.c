@@ -24,6 +24,7 @@
 #include "hash.h"
 #include "lib.h"
 #include "lower.h"
+#include "mask.h"
 #include "mir/mir-unit.h"
 #include "object.h"
 #include "option.h"
@@ -32,6 +33,7 @@
 #include "psl/psl-phase.h"
 #include "rt/assert.h"
 #include "rt/rt.h"
+#include "timeline.h"
 #include "type.h"
 #include "vcode.h"
 #include "vhdl/vhdl-lower.h"
@@ -153,6 +155,7 @@ static void lower_driver_field_cb(lower_unit_t *lu, tree_t field,
                                   vcode_reg_t ptr, vcode_reg_t unused,
                                   vcode_reg_t locus, void *__ctx);
 static void lower_dependencies(lower_unit_t *lu, tree_t unit);
+static driver_set_t *unit_registry_drivers(unit_registry_t *ur, tree_t unit);
 
 typedef vcode_reg_t (*lower_signal_flag_fn_t)(vcode_reg_t, vcode_reg_t);
 typedef vcode_reg_t (*arith_fn_t)(vcode_reg_t, vcode_reg_t);
@@ -1651,6 +1654,25 @@ static vcode_reg_t lower_cover_counters(lower_unit_t *lu)
       return emit_load_indirect(emit_var_upref(hops, var));
 }
 
+static void lower_cover_hit(lower_unit_t *lu, vcode_reg_t counters,
+                            uint32_t tag, vcode_op_t kind)
+{
+   if (cover_enabled(lu->cover, COVER_MASK_HIT_ONLY)) {
+      // Only record that the item was reached: a plain store avoids the
+      // load and saturating add of the normal counter increment
+      vcode_type_t vint32 = vtype_int(INT32_MIN, INT32_MAX);
+      vcode_reg_t index = emit_const(vtype_offset(), tag);
+      vcode_reg_t ptr = emit_array_ref(counters, index);
+      emit_store_indirect(emit_const(vint32, 1), ptr);
+   }
+   else if (kind == VCODE_OP_COVER_STMT)
+      emit_cover_stmt(counters, tag);
+   else if (kind == VCODE_OP_COVER_BRANCH)
+      emit_cover_branch(counters, tag);
+   else
+      emit_cover_expr(counters, tag);
+}
+
 static void lower_branch_coverage(lower_unit_t *lu, tree_t b, int nth,
                                   vcode_block_t true_bb, vcode_block_t false_bb,
                                   gen_stack_t *gs)
@@ -1669,7 +1691,7 @@ static void lower_branch_coverage(lower_unit_t *lu, tree_t b, int nth,
       vcode_select_block(blocks[i]);
 
       vcode_reg_t counters = lower_cover_counters(lu);
-      emit_cover_branch(counters, item[i].tag);
+      lower_cover_hit(lu, counters, item[i].tag, VCODE_OP_COVER_BRANCH);
    }
 }
 
@@ -1683,7 +1705,7 @@ static void lower_stmt_coverage(lower_unit_t *lu, tree_t stmt, gen_stack_t *gs)
    cover_item_t *item = cover_get_item(gs->cscope, COV_ITEM_STMT, 0);
    if (item != NULL) {
       vcode_reg_t counters = lower_cover_counters(lu);
-      emit_cover_stmt(counters, item->tag);
+      lower_cover_hit(lu, counters, item->tag, VCODE_OP_COVER_STMT);
    }
 }
 
@@ -1806,7 +1828,7 @@ static void lower_logic_expr_coverage(lower_unit_t *lu, cover_item_t *first,
             emit_cond(test, match_bb, next_bb);
 
             vcode_select_block(match_bb);
-            emit_cover_expr(counters, current->tag);
+            lower_cover_hit(lu, counters, current->tag, VCODE_OP_COVER_EXPR);
             emit_jump(next_bb);
 
             vcode_select_block(next_bb);
@@ -1817,6 +1839,19 @@ static void lower_logic_expr_coverage(lower_unit_t *lu, cover_item_t *first,
    }
 }
 
+static bool lower_is_trivial(tree_t expr)
+{
+   // True if expression is a literal or simple name
+   switch (tree_kind(expr)) {
+   case T_REF:
+   case T_LITERAL:
+   case T_STRING:
+      return true;
+   default:
+      return false;
+   }
+}
+
 static bool lower_side_effect_free(tree_t expr)
 {
    // True if expression is side-effect free with no function calls
@@ -2459,7 +2494,7 @@ static vcode_reg_t lower_expr_coverge(lower_unit_t *lu, cover_item_t *first,
          emit_cond(test, match_bb, next_bb);
 
          vcode_select_block(match_bb);
-         emit_cover_expr(counters, current->tag);
+         lower_cover_hit(lu, counters, current->tag, VCODE_OP_COVER_EXPR);
          emit_jump(next_bb);
 
          vcode_select_block(next_bb);
@@ -2473,7 +2508,7 @@ static vcode_reg_t lower_expr_coverge(lower_unit_t *lu, cover_item_t *first,
                emit_cond(test, match_bb, next_bb);
 
                vcode_select_block(match_bb);
-               emit_cover_expr(counters, current->tag);
+               lower_cover_hit(lu, counters, current->tag, VCODE_OP_COVER_EXPR);
                emit_jump(next_bb);
 
                vcode_select_block(next_bb);
@@ -5734,13 +5769,13 @@ static void lower_assert(lower_unit_t *lu, tree_t stmt, gen_stack_t *gs)
    tree_t message = tree_has_message(stmt) ? tree_message(stmt) : NULL;
    tree_t severity = tree_has_severity(stmt) ? tree_severity(stmt) : NULL;
 
-   // If evaluating the message or severity expressions can have side
-   // effects then branch to a new block
-   const bool has_side_effects =
-      (message != NULL && !lower_side_effect_free(message))
-      || (severity != NULL && !lower_side_effect_free(severity));
+   // Only evaluate the message and severity expressions when the
+   // assertion fails unless they are trivial and need no code
+   const bool lazy =
+      (message != NULL && !lower_is_trivial(message))
+      || (severity != NULL && !lower_is_trivial(severity));
 
-   if (has_side_effects) {
+   if (lazy) {
       fail_bb = emit_block();
       exit_bb = emit_block();
       emit_cond(value_reg, exit_bb, fail_bb);
@@ -8429,6 +8464,40 @@ static void lower_build_wait_cb(tree_t expr, void *ctx)
                            lower_build_wait_field_cb, NULL);
 }
 
+static bool can_transfer_implicit(tree_t prefix)
+{
+   // Implicit signals with a static signal name prefix can be updated
+   // directly by the kernel without running a process
+   tree_t ref = name_to_ref(prefix);
+   if (ref == NULL || class_of(ref) != C_SIGNAL)
+      return false;
+   else if (prefix != longest_static_prefix(prefix))
+      return false;
+   else
+      return type_is_homogeneous(tree_type(prefix));
+}
+
+static void lower_implicit_transfer(lower_unit_t *lu, tree_t decl,
+                                    tree_t prefix, vcode_reg_t delay_reg,
+                                    transfer_kind_t kind)
+{
+   vcode_reg_t nets_reg = lower_signal_ref(lu, decl);
+   vcode_reg_t source_reg = lower_lvalue(lu, prefix);
+
+   type_t type = tree_type(prefix);
+   vcode_reg_t count_reg = lower_type_width(lu, type, source_reg);
+
+   vcode_reg_t reject_reg = delay_reg;
+   if (kind == TRANSFER_COPY)
+      reject_reg = emit_const(vtype_time(), 0);   // Transport delay
+
+   vcode_reg_t kind_reg = emit_const(vtype_offset(), kind);
+   vcode_reg_t target_nets = lower_array_data(nets_reg);
+   vcode_reg_t source_nets = lower_array_data(source_reg);
+   emit_transfer_signal(target_nets, source_nets, count_reg,
+                        reject_reg, delay_reg, kind_reg);
+}
+
 static void lower_implicit_delayed(lower_unit_t *lu, object_t *obj)
 {
    tree_t decl = tree_from_object(obj);
@@ -8454,14 +8523,29 @@ static void lower_implicit_delayed(lower_unit_t *lu, object_t *obj)
       lower_for_each_field(lu, type, nets_reg, VCODE_INVALID_REG,
                            lower_driver_field_cb, NULL);
 
+   vcode_type_t vtime = vtype_time();
+
+   if (can_transfer_implicit(expr)) {
+      vcode_reg_t delay_reg;
+      if (tree_has_delay(wave))
+         delay_reg = lower_rvalue(lu, tree_delay(wave));
+      else
+         delay_reg = emit_const(vtime, 0);
+
+      lower_implicit_transfer(lu, decl, expr, delay_reg, TRANSFER_COPY);
+      emit_return(VCODE_INVALID_REG);
+
+      vcode_select_block(main_bb);
+      emit_return(VCODE_INVALID_REG);
+      return;
+   }
+
    build_wait(expr, lower_build_wait_cb, lu);
 
    emit_return(VCODE_INVALID_REG);
 
    vcode_select_block(main_bb);
 
-   vcode_type_t vtime = vtype_time();
-
    vcode_reg_t delay_reg;
    if (tree_has_delay(wave))
       delay_reg = lower_rvalue(lu, tree_delay(wave));
@@ -8504,7 +8588,19 @@ static void lower_implicit_transaction(lower_unit_t *lu, object_t *obj)
       vcode_reg_t count_reg = emit_const(voffset, 1);
       emit_drive_signal(nets_reg, count_reg);
 
-      lower_sched_event(lu, tree_value(decl), emit_sched_active);
+      tree_t prefix = tree_value(decl);
+      if (can_transfer_implicit(prefix)) {
+         vcode_reg_t delay_reg = emit_const(vtype_time(), 0);
+         lower_implicit_transfer(lu, decl, prefix, delay_reg,
+                                 TRANSFER_TRANSACTION);
+         emit_return(VCODE_INVALID_REG);
+
+         vcode_select_block(start_bb);
+         emit_return(VCODE_INVALID_REG);
+         return;
+      }
+
+      lower_sched_event(lu, prefix, emit_sched_active);
 
       emit_return(VCODE_INVALID_REG);
    }
@@ -8534,8 +8630,6 @@ static void lower_implicit_stable(lower_unit_t *lu, object_t *obj)
    vcode_block_t start_bb = emit_block();
    assert(start_bb == 1);
 
-   vcode_block_t wait_bb = emit_block();
-
    vcode_type_t voffset = vtype_offset();
 
    {
@@ -8543,15 +8637,34 @@ static void lower_implicit_stable(lower_unit_t *lu, object_t *obj)
       vcode_reg_t count_reg = emit_const(voffset, 1);
       emit_drive_signal(nets_reg, count_reg);
 
+      tree_t prefix = tree_value(w);
+      if (can_transfer_implicit(prefix)) {
+         vcode_reg_t delay_reg;
+         if (tree_has_delay(w))
+            delay_reg = lower_rvalue(lu, tree_delay(w));
+         else
+            delay_reg = emit_const(vtype_time(), 0);
+
+         transfer_kind_t kind = tree_subkind(decl) == IMPLICIT_STABLE
+            ? TRANSFER_STABLE : TRANSFER_QUIET;
+         lower_implicit_transfer(lu, decl, prefix, delay_reg, kind);
+         emit_return(VCODE_INVALID_REG);
+
+         vcode_select_block(start_bb);
+         emit_return(VCODE_INVALID_REG);
+         return;
+      }
+
       event_fn_t fn = tree_subkind(decl) == IMPLICIT_STABLE
          ? emit_sched_event : emit_sched_active;
-      lower_sched_event(lu, tree_value(w), fn);
+      lower_sched_event(lu, prefix, fn);
 
       emit_return(VCODE_INVALID_REG);
    }
 
    vcode_select_block(start_bb);
 
+   vcode_block_t wait_bb = emit_block();
    emit_wait(wait_bb);
 
    vcode_select_block(wait_bb);
@@ -10620,6 +10733,31 @@ static void lower_driver_field_cb(lower_unit_t *lu, tree_t field,
                            lower_driver_field_cb, NULL);
 }
 
+static tree_t transfer_source(tree_t value, transfer_kind_t *kind)
+{
+   *kind = TRANSFER_COPY;
+
+   if (tree_kind(value) != T_FCALL || tree_params(value) != 1)
+      return value;
+   else if (!type_is_scalar(tree_type(value)))
+      return value;
+
+   // A process such as "clk <= not clk after 5 ns" can be executed by
+   // the kernel without waking up the process on each edge
+   switch (tree_subkind(tree_ref(value))) {
+   case S_SCALAR_NOT:
+      *kind = TRANSFER_NOT;
+      break;
+   case S_IEEE_NOT:
+      *kind = TRANSFER_NOT_ULOGIC;
+      break;
+   default:
+      return value;
+   }
+
+   return tree_value(tree_param(value, 0));
+}
+
 static bool can_use_transfer_signal(lower_unit_t *lu, tree_t proc,
                                     driver_set_t *ds)
 {
@@ -10655,11 +10793,16 @@ static bool can_use_transfer_signal(lower_unit_t *lu, tree_t proc,
          return false;
    }
 
-   tree_t value = tree_value(w0), ref = name_to_ref(value);
+   transfer_kind_t kind;
+   tree_t value = transfer_source(tree_value(w0), &kind);
+
+   tree_t ref = name_to_ref(value);
    if (ref == NULL || class_of(ref) != C_SIGNAL)
       return false;
    else if (value != longest_static_prefix(value))
       return false;
+   else if (kind != TRANSFER_COPY && !type_is_scalar(tree_type(value)))
+      return false;
 
    tree_t s1 = tree_stmt(proc, 1);
    if (tree_kind(s1) != T_WAIT)
@@ -10676,6 +10819,20 @@ static bool can_use_transfer_signal(lower_unit_t *lu, tree_t proc,
    return true;
 }
 
+static vcode_reg_t lower_edge_trigger(lower_unit_t *lu, tree_t fcall,
+                                      edge_flags_t edge)
+{
+   // RISING_EDGE and FALLING_EDGE can be evaluated by the kernel
+   // without calling into the JIT
+   tree_t value = tree_value(tree_param(fcall, 0));
+   if (tree_kind(value) != T_REF || class_of(value) != C_SIGNAL)
+      return VCODE_INVALID_REG;
+
+   vcode_reg_t nets_reg = lower_lvalue(lu, value);
+   vcode_reg_t edge_reg = emit_const(vtype_offset(), edge);
+   return emit_edge_trigger(nets_reg, edge_reg);
+}
+
 static vcode_reg_t lower_trigger(lower_unit_t *lu, tree_t fcall, tree_t proc)
 {
    tree_t decl = tree_ref(fcall);
@@ -10729,9 +10886,23 @@ static vcode_reg_t lower_trigger(lower_unit_t *lu, tree_t fcall, tree_t proc)
 
       return lower_trigger(lu, other, proc);
    }
+   else if (kind == S_RISING_EDGE)
+      return lower_edge_trigger(lu, fcall, EDGE_RISING);
+   else if (kind == S_FALLING_EDGE)
+      return lower_edge_trigger(lu, fcall, EDGE_FALLING);
    else if (is_open_coded_builtin(kind))
       return VCODE_INVALID_REG;
-   else if (tree_flags(decl) & TREE_F_IMPURE)
+
+   switch (is_well_known(tree_ident2(decl))) {
+   case W_IEEE_1164_RISING_EDGE:
+      return lower_edge_trigger(lu, fcall, EDGE_RISING | EDGE_X01);
+   case W_IEEE_1164_FALLING_EDGE:
+      return lower_edge_trigger(lu, fcall, EDGE_FALLING | EDGE_X01);
+   default:
+      break;
+   }
+
+   if (tree_flags(decl) & TREE_F_IMPURE)
       return VCODE_INVALID_REG;
 
    const int nparams = tree_params(fcall);
@@ -10808,6 +10979,378 @@ static vcode_reg_t lower_process_trigger(lower_unit_t *lu, tree_t proc)
       return emit_or_trigger(branches[0], branches[1]);
 }
 
+static int lower_case_trigger_index(tree_t wait, tree_t name)
+{
+   // Find the sensitivity list entry that covers every element of NAME
+   const int ntriggers = tree_triggers(wait);
+   for (tree_t prefix = name;; prefix = tree_value(prefix)) {
+      for (int i = 0; i < ntriggers; i++) {
+         if (same_tree(tree_trigger(wait, i), prefix))
+            return i;
+      }
+
+      switch (tree_kind(prefix)) {
+      case T_ARRAY_REF:
+      case T_ARRAY_SLICE:
+      case T_RECORD_REF:
+         continue;
+      default:
+         return -1;
+      }
+   }
+}
+
+static bool lower_case_trigger_expr(tree_t expr, tree_t wait,
+                                    bit_mask_t *reads);
+
+static bool lower_case_trigger_range(tree_t r, tree_t wait, bit_mask_t *reads)
+{
+   switch (tree_subkind(r)) {
+   case RANGE_TO:
+   case RANGE_DOWNTO:
+      return lower_case_trigger_expr(tree_left(r), wait, reads)
+         && lower_case_trigger_expr(tree_right(r), wait, reads);
+   default:
+      return false;
+   }
+}
+
+static bool lower_case_trigger_name(tree_t name, tree_t wait,
+                                    bit_mask_t *reads)
+{
+   // Check the index expressions in a signal name
+   switch (tree_kind(name)) {
+   case T_REF:
+      return true;
+   case T_ARRAY_REF:
+      {
+         const int nparams = tree_params(name);
+         for (int i = 0; i < nparams; i++) {
+            tree_t value = tree_value(tree_param(name, i));
+            if (!lower_case_trigger_expr(value, wait, reads))
+               return false;
+         }
+
+         return lower_case_trigger_name(tree_value(name), wait, reads);
+      }
+   case T_ARRAY_SLICE:
+      return lower_case_trigger_range(tree_range(name, 0), wait, reads)
+         && lower_case_trigger_name(tree_value(name), wait, reads);
+   case T_RECORD_REF:
+      return lower_case_trigger_name(tree_value(name), wait, reads);
+   default:
+      return false;
+   }
+}
+
+static bool lower_case_trigger_expr(tree_t expr, tree_t wait,
+                                    bit_mask_t *reads)
+{
+   // Collect the sensitivity list entries read by a side effect free
+   // expression whose value only depends on the current value of
+   // those signals
+   switch (tree_kind(expr)) {
+   case T_LITERAL:
+   case T_STRING:
+   case T_OPEN:
+      return true;
+   case T_REF:
+   case T_ARRAY_REF:
+   case T_ARRAY_SLICE:
+   case T_RECORD_REF:
+      {
+         tree_t ref = name_to_ref(expr);
+         if (ref == NULL || !tree_has_ref(ref))
+            return false;
+
+         switch (class_of(tree_ref(ref))) {
+         case C_SIGNAL:
+            {
+               const int index = lower_case_trigger_index(wait, expr);
+               if (index < 0)
+                  return false;
+
+               type_t type = tree_type(tree_trigger(wait, index));
+               if (!type_is_homogeneous(type))
+                  return false;
+
+               mask_set(reads, index);
+               return lower_case_trigger_name(expr, wait, reads);
+            }
+         case C_CONSTANT:
+         case C_LITERAL:
+         case C_UNITS:
+            if (tree_kind(expr) == T_REF)
+               return true;
+            else
+               return lower_case_trigger_name(expr, wait, reads);
+         default:
+            return false;
+         }
+      }
+   case T_QUALIFIED:
+   case T_TYPE_CONV:
+      return lower_case_trigger_expr(tree_value(expr), wait, reads);
+   case T_ATTR_REF:
+      switch (tree_subkind(expr)) {
+      case ATTR_LENGTH:
+      case ATTR_LEFT:
+      case ATTR_RIGHT:
+      case ATTR_LOW:
+      case ATTR_HIGH:
+      case ATTR_ASCENDING:
+         return true;
+      default:
+         return false;
+      }
+   case T_AGGREGATE:
+      {
+         const int nassocs = tree_assocs(expr);
+         for (int i = 0; i < nassocs; i++) {
+            tree_t a = tree_assoc(expr, i);
+            switch (tree_subkind(a)) {
+            case A_NAMED:
+               if (!lower_case_trigger_expr(tree_name(a), wait, reads))
+                  return false;
+               break;
+            case A_RANGE:
+            case A_SLICE:
+               if (!lower_case_trigger_range(tree_range(a, 0), wait, reads))
+                  return false;
+               break;
+            default:
+               break;
+            }
+
+            if (!lower_case_trigger_expr(tree_value(a), wait, reads))
+               return false;
+         }
+
+         return true;
+      }
+   case T_FCALL:
+      {
+         tree_t decl = tree_ref(expr);
+         if (tree_flags(decl) & TREE_F_IMPURE)
+            return false;
+
+         // Functions with signal parameters may test attributes such
+         // as 'EVENT which change without the value changing
+         const int nports = tree_ports(decl);
+         for (int i = 0; i < nports; i++) {
+            if (tree_class(tree_port(decl, i)) != C_CONSTANT)
+               return false;
+         }
+
+         const int nparams = tree_params(expr);
+         for (int i = 0; i < nparams; i++) {
+            tree_t value = tree_value(tree_param(expr, i));
+            if (!lower_case_trigger_expr(value, wait, reads))
+               return false;
+         }
+
+         return true;
+      }
+   default:
+      return false;
+   }
+}
+
+static bool lower_case_trigger_stmts(tree_t container, tree_t wait,
+                                     bit_mask_t *reads)
+{
+   // Only allow statements that produce the same effect when run again
+   // with the same inputs
+   const int nstmts = tree_stmts(container);
+   for (int i = 0; i < nstmts; i++) {
+      tree_t s = tree_stmt(container, i);
+      switch (tree_kind(s)) {
+      case T_NULL:
+         break;
+      case T_SIGNAL_ASSIGN:
+         {
+            if (tree_has_reject(s) || tree_waveforms(s) != 1)
+               return false;
+
+            tree_t w0 = tree_waveform(s, 0);
+            if (tree_has_delay(w0) || !tree_has_value(w0))
+               return false;
+            else if (!lower_case_trigger_expr(tree_value(w0), wait, reads))
+               return false;
+            else if (!lower_case_trigger_name(tree_target(s), wait, reads))
+               return false;
+         }
+         break;
+      case T_IF:
+         {
+            const int nconds = tree_conds(s);
+            for (int j = 0; j < nconds; j++) {
+               tree_t c = tree_cond(s, j);
+               if (tree_has_value(c)
+                   && !lower_case_trigger_expr(tree_value(c), wait, reads))
+                  return false;
+               else if (!lower_case_trigger_stmts(c, wait, reads))
+                  return false;
+            }
+         }
+         break;
+      case T_CASE:
+         {
+            if (!lower_case_trigger_expr(tree_value(s), wait, reads))
+               return false;
+
+            const int nalts = tree_stmts(s);
+            for (int j = 0; j < nalts; j++) {
+               if (!lower_case_trigger_stmts(tree_stmt(s, j), wait, reads))
+                  return false;
+            }
+         }
+         break;
+      default:
+         return false;
+      }
+   }
+
+   return true;
+}
+
+static vcode_reg_t lower_level_trigger(lower_unit_t *lu, tree_t on)
+{
+   type_t type = tree_type(on);
+   assert(type_is_homogeneous(type));
+
+   vcode_reg_t nets_reg = lower_lvalue(lu, on);
+   vcode_reg_t count_reg = lower_type_width(lu, type, nets_reg);
+   vcode_reg_t data_reg = lower_array_data(nets_reg);
+   return emit_level_trigger(data_reg, count_reg);
+}
+
+static vcode_reg_t lower_case_trigger(lower_unit_t *lu, tree_t proc,
+                                      tree_t wait)
+{
+   // A combinational process consisting of a single case statement
+   // only needs to run when the selector changes or when a signal read
+   // in the branch selected by the current value of the selector
+   // changes
+   if (cover_enabled(lu->cover, COVER_MASK_STMT | COVER_MASK_BRANCH
+                     | COVER_MASK_EXPRESSION))
+      return VCODE_INVALID_REG;   // Would have incorrect coverage
+   else if (tree_stmts(proc) != 2)
+      return VCODE_INVALID_REG;
+
+   tree_t s0 = tree_stmt(proc, 0);
+   if (tree_kind(s0) != T_CASE)
+      return VCODE_INVALID_REG;
+
+   tree_t sel = tree_value(s0);
+   if (tree_kind(sel) != T_REF || class_of(sel) != C_SIGNAL)
+      return VCODE_INVALID_REG;
+   else if (!type_is_scalar(tree_type(sel)))
+      return VCODE_INVALID_REG;
+
+   const int sel_index = lower_case_trigger_index(wait, sel);
+   if (sel_index < 0)
+      return VCODE_INVALID_REG;
+
+   const int nalts = tree_stmts(s0), ntriggers = tree_triggers(wait);
+
+   // The choice values are compared against the raw signal data which
+   // is sign extended so only allow small non-negative values
+   bool *guarded LOCAL = xcalloc_array(nalts, sizeof(bool));
+   for (int i = 0; i < nalts; i++) {
+      tree_t alt = tree_stmt(s0, i);
+
+      guarded[i] = true;
+
+      const int nchoices = tree_choices(alt);
+      for (int j = 0; j < nchoices; j++) {
+         tree_t c = tree_choice(alt, j);
+
+         int64_t ival;
+         if (!tree_has_name(c) || tree_ranges(c) > 0)
+            guarded[i] = false;
+         else if (!folded_int(tree_name(c), &ival) || ival < 0 || ival > 127)
+            return VCODE_INVALID_REG;
+      }
+   }
+
+   bit_mask_t *reads LOCAL = xcalloc_array(nalts, sizeof(bit_mask_t));
+   bool valid = true;
+   int nuseful = 0;
+   for (int i = 0; i < nalts; i++) {
+      mask_init(&(reads[i]), ntriggers);
+
+      if (valid && !lower_case_trigger_stmts(tree_stmt(s0, i), wait,
+                                             &(reads[i])))
+         valid = false;
+
+      mask_clear(&(reads[i]), sel_index);
+
+      if (guarded[i] && mask_popcount(&(reads[i])) > 0)
+         nuseful++;
+   }
+
+   vcode_reg_t result = VCODE_INVALID_REG;
+   if (valid && nuseful > 0) {
+      vcode_reg_t *levels LOCAL =
+         xmalloc_array(ntriggers, sizeof(vcode_reg_t));
+      for (int i = 0; i < ntriggers; i++)
+         levels[i] = VCODE_INVALID_REG;
+
+      levels[sel_index] = lower_level_trigger(lu, sel);
+      result = levels[sel_index];
+
+      vcode_reg_t sel_reg = lower_lvalue(lu, sel);
+      vcode_type_t vtype = lower_type(tree_type(sel));
+
+      for (int i = 0; i < nalts; i++) {
+         vcode_reg_t branch = VCODE_INVALID_REG;
+         for (int j = 0; j < ntriggers; j++) {
+            if (!mask_test(&(reads[i]), j))
+               continue;
+            else if (levels[j] == VCODE_INVALID_REG)
+               levels[j] = lower_level_trigger(lu, tree_trigger(wait, j));
+
+            if (branch == VCODE_INVALID_REG)
+               branch = levels[j];
+            else
+               branch = emit_or_trigger(branch, levels[j]);
+         }
+
+         if (branch == VCODE_INVALID_REG)
+            continue;   // Only depends on the selector
+         else if (guarded[i]) {
+            tree_t alt = tree_stmt(s0, i);
+            vcode_reg_t cond = VCODE_INVALID_REG;
+
+            const int nchoices = tree_choices(alt);
+            for (int j = 0; j < nchoices; j++) {
+               int64_t ival;
+               if (!folded_int(tree_name(tree_choice(alt, j)), &ival))
+                  should_not_reach_here();
+
+               vcode_reg_t value_reg = emit_const(vtype, ival);
+               vcode_reg_t cmp = emit_cmp_trigger(sel_reg, value_reg);
+
+               if (cond == VCODE_INVALID_REG)
+                  cond = cmp;
+               else
+                  cond = emit_or_trigger(cond, cmp);
+            }
+
+            branch = emit_and_trigger(cond, branch);
+         }
+
+         result = emit_or_trigger(result, branch);
+      }
+   }
+
+   for (int i = 0; i < nalts; i++)
+      mask_free(&(reads[i]));
+
+   return result;
+}
+
 static void lower_process(lower_unit_t *lu, object_t *obj)
 {
    tree_t proc = tree_from_object(obj);
@@ -10859,7 +11402,10 @@ static void lower_process(lower_unit_t *lu, object_t *obj)
       vcode_reg_t target_reg = lower_lvalue(lu, target);
 
       tree_t w0 = tree_waveform(s0, 0);
-      vcode_reg_t source_reg = lower_lvalue(lu, tree_value(w0));
+
+      transfer_kind_t kind;
+      tree_t source = transfer_source(tree_value(w0), &kind);
+      vcode_reg_t source_reg = lower_lvalue(lu, source);
 
       vcode_reg_t count_reg =
          lower_type_width(lu, tree_type(target), target_reg);
@@ -10874,10 +11420,12 @@ static void lower_process(lower_unit_t *lu, object_t *obj)
       if (tree_has_reject(s0))
          reject_reg = lower_rvalue(lu, tree_reject(s0));
 
+      vcode_reg_t kind_reg = emit_const(vtype_offset(), kind);
+
       vcode_reg_t target_nets = lower_array_data(target_reg);
       vcode_reg_t source_nets = lower_array_data(source_reg);
       emit_transfer_signal(target_nets, source_nets, count_reg,
-                           reject_reg, delay_reg);
+                           reject_reg, delay_reg, kind_reg);
    }
    else {
       // If the last statement in the process is a static wait then this
@@ -10889,14 +11437,25 @@ static void lower_process(lower_unit_t *lu, object_t *obj)
           && tree_kind((wait = tree_stmt(proc, nstmts - 1))) == T_WAIT
           && (tree_flags(wait) & TREE_F_STATIC_WAIT)) {
 
-         const int ntriggers = tree_triggers(wait);
-         for (int i = 0; i < ntriggers; i++)
-            lower_sched_event(lu, tree_trigger(wait, i), emit_sched_event);
+         vcode_reg_t case_reg = VCODE_INVALID_REG;
+         if (opt_get_int(OPT_PRUNE_SENSITIVITY))
+            case_reg = lower_case_trigger(lu, proc, wait);
 
-         trigger_reg = lower_process_trigger(lu, proc);
+         if (case_reg != VCODE_INVALID_REG) {
+            // Wake up only when the trigger is true rather than on
+            // every event in the sensitivity list
+            emit_sched_event(case_reg, VCODE_INVALID_REG);
+         }
+         else {
+            const int ntriggers = tree_triggers(wait);
+            for (int i = 0; i < ntriggers; i++)
+               lower_sched_event(lu, tree_trigger(wait, i), emit_sched_event);
+
+            trigger_reg = lower_process_trigger(lu, proc);
 
-         if (trigger_reg != VCODE_INVALID_REG)
-            emit_add_trigger(trigger_reg);
+            if (trigger_reg != VCODE_INVALID_REG)
+               emit_add_trigger(trigger_reg);
+         }
       }
    }
 
@@ -11668,9 +12227,166 @@ static void lower_port_map(lower_unit_t *lu, tree_t block, tree_t map,
    }
 }
 
-static void lower_direct_mapped_port(lower_unit_t *lu, tree_t block, tree_t map,
-                                     hset_t *direct, hset_t **poison,
-                                     vcode_reg_t src_reg)
+static bool lower_is_identity_conv(tree_t value)
+{
+   // True if the type conversion does not change the representation
+   // of the signal so the port can alias the actual
+
+   tree_t inner = tree_value(value);
+   if (tree_kind(inner) == T_TYPE_CONV || !lower_is_signal_ref(inner))
+      return false;
+
+   type_t from = tree_type(inner), to = tree_type(value);
+
+   if (type_is_array(from) && type_is_array(to)) {
+      if (dimension_of(from) != dimension_of(to))
+         return false;
+
+      from = type_elem(from);
+      to = type_elem(to);
+   }
+
+   if (!type_is_scalar(from) || !type_is_scalar(to))
+      return false;
+
+   return type_eq(type_base_recur(from), type_base_recur(to));
+}
+
+static type_t lower_resolved_subtype(type_t type)
+{
+   for (type_t t = type; type_kind(t) == T_SUBTYPE; t = type_base(t)) {
+      if (type_has_resolution(t))
+         return t;
+   }
+
+   if (type_is_array(type))
+      return lower_resolved_subtype(type_elem(type));
+   else
+      return NULL;
+}
+
+static tree_t lower_find_unit_signal(tree_t unit, tree_t decl)
+{
+   // Map a signal in an elaborated block back to the corresponding
+   // declaration in the analysed architecture
+
+   ident_t id = tree_ident(decl);
+   tree_t entity = tree_primary(unit);
+
+   if (tree_kind(decl) == T_PORT_DECL) {
+      const int nports = tree_ports(entity);
+      for (int i = 0; i < nports; i++) {
+         tree_t p = tree_port(entity, i);
+         if (tree_ident(p) == id)
+            return p;
+      }
+
+      return NULL;
+   }
+
+   tree_t roots[] = { entity, unit };
+   for (int i = 0; i < ARRAY_LEN(roots); i++) {
+      const int ndecls = tree_decls(roots[i]);
+      for (int j = 0; j < ndecls; j++) {
+         tree_t d = tree_decl(roots[i], j);
+         if (tree_kind(d) == T_SIGNAL_DECL && tree_ident(d) == id)
+            return d;
+      }
+   }
+
+   return NULL;
+}
+
+static driver_set_t *lower_unit_drivers(lower_unit_t *lu)
+{
+   if (lu->drivers == NULL) {
+      tree_t hier = tree_decl(lu->container, 0);
+      assert(tree_kind(hier) == T_HIER);
+
+      lu->drivers = unit_registry_drivers(lu->registry, tree_ref(hier));
+   }
+
+   return lu->drivers;
+}
+
+static bool lower_is_leaf_arch(tree_t unit)
+{
+   if (tree_kind(unit) != T_ARCH)
+      return false;
+
+   tree_t roots[] = { tree_primary(unit), unit };
+   for (int i = 0; i < ARRAY_LEN(roots); i++) {
+      const int nstmts = tree_stmts(roots[i]);
+      for (int j = 0; j < nstmts; j++) {
+         const tree_kind_t kind = tree_kind(tree_stmt(roots[i], j));
+         if (kind != T_PROCESS && kind != T_PSL_DIRECT)
+            return false;
+      }
+   }
+
+   return true;
+}
+
+static bool lower_inout_has_single_source(lower_unit_t *lu, tree_t block,
+                                          tree_t port, tree_t value)
+{
+   // An inout port can alias the actual if there is exactly one driver
+   // for each element inside the instance and nothing else drives the
+   // actual in the parent: the driving value of the actual is then the
+   // same whether or not the port is collapsed
+
+   if (tree_kind(value) != T_REF || lu->parent == NULL)
+      return false;
+
+   tree_t decl = tree_ref(value);
+   const tree_kind_t kind = tree_kind(decl);
+   if (kind != T_SIGNAL_DECL && kind != T_PORT_DECL)
+      return false;
+   else if (tree_has_value(port) || tree_has_value(decl))
+      return false;   // Driver initial value would differ
+
+   type_t port_type = tree_type(port), decl_type = tree_type(decl);
+   type_t elem = type_elem_recur(port_type);
+   if (!type_is_scalar(elem) || elem != type_elem_recur(decl_type))
+      return false;
+   else if (lower_resolved_subtype(port_type)
+            != lower_resolved_subtype(decl_type))
+      return false;
+
+   tree_t unit = tree_ref(tree_decl(block, 0));
+   if (!lower_is_leaf_arch(unit))
+      return false;
+
+   tree_t orig_port = lower_find_unit_signal(unit, port);
+   if (orig_port == NULL)
+      return false;
+   else if (!has_unique_driver(lower_unit_drivers(lu), orig_port))
+      return false;
+
+   tree_t parent = tree_ref(tree_decl(lu->parent->container, 0));
+   if (tree_kind(parent) != T_ARCH)
+      return false;
+
+   tree_t orig_decl = lower_find_unit_signal(parent, decl);
+   if (orig_decl == NULL)
+      return false;
+
+   driver_info_t *di = get_drivers(lower_unit_drivers(lu->parent), orig_decl);
+   if (di == NULL || di->chain_decl != NULL || di->tentative)
+      return false;
+   else if (tree_kind(di->where) != T_INSTANCE)
+      return false;
+   else if (tree_ident(di->where) != tree_ident(block))
+      return false;
+   else
+      return tree_kind(di->prefix) == T_REF;
+}
+
+static collapse_reason_t lower_direct_mapped_port(lower_unit_t *lu,
+                                                  tree_t block, tree_t map,
+                                                  hset_t *direct,
+                                                  hset_t **poison,
+                                                  vcode_reg_t src_reg)
 {
    tree_t port = NULL;
    int field = -1;
@@ -11689,8 +12405,12 @@ static void lower_direct_mapped_port(lower_unit_t *lu, tree_t block, tree_t map,
             kind  = tree_kind(name);
          }
 
-         if (kind != T_REF)
-            return;
+         if (kind == T_CONV_FUNC)
+            return COLLAPSE_CONV_FUNC;
+         else if (kind == T_TYPE_CONV)
+            return COLLAPSE_TYPE_CONV;
+         else if (kind != T_REF)
+            return COLLAPSE_PARTIAL;
 
          port = tree_ref(name);
       }
@@ -11714,11 +12434,35 @@ static void lower_direct_mapped_port(lower_unit_t *lu, tree_t block, tree_t map,
 
       hset_insert(direct, map);
       hset_insert(direct, port);
-      return;
+      return COLLAPSE_DONE;
+   }
+
+   const bool aggressive = opt_get_int(OPT_AGGRESSIVE_COLLAPSE);
+   const port_mode_t mode = tree_subkind(port);
+
+   if (mode == PORT_INOUT && aggressive && field == -1) {
+      if (!lower_inout_has_single_source(lu, block, port, value))
+         return COLLAPSE_DRIVERS;
    }
-   else if (tree_subkind(port) != PORT_IN)
-      return;    // Not safe in general
-   else if (!lower_is_signal_ref(value) || tree_kind(value) == T_TYPE_CONV) {
+   else if (mode != PORT_IN)
+      return COLLAPSE_MODE;    // Not safe in general
+
+   collapse_reason_t reason = COLLAPSE_DONE;
+   const tree_kind_t kind = tree_kind(value);
+   if (kind == T_CONV_FUNC)
+      reason = COLLAPSE_CONV_FUNC;
+   else if (kind == T_TYPE_CONV) {
+      if (aggressive && lower_is_identity_conv(value)) {
+         value = tree_value(value);
+         src_reg = lower_lvalue(lu, value);
+      }
+      else
+         reason = COLLAPSE_TYPE_CONV;
+   }
+   else if (!lower_is_signal_ref(value))
+      reason = COLLAPSE_NOT_SIGNAL;
+
+   if (reason != COLLAPSE_DONE) {
       if (field != -1) {
          // We can't use direct mapping for this record element so make
          // sure we don't direct map any other elements of this signal
@@ -11726,16 +12470,16 @@ static void lower_direct_mapped_port(lower_unit_t *lu, tree_t block, tree_t map,
             *poison = hset_new(32);
          hset_insert(*poison, port);
       }
-      return;
+      return reason;
    }
    else if (*poison != NULL && hset_contains(*poison, port))
-      return;
+      return COLLAPSE_PARTIAL;
 
    type_t type = tree_type(value);
    type_t port_type = tree_type(port);
 
    if (type_is_unconstrained(port_type))
-      return;   // Not supported for now
+      return COLLAPSE_UNCONSTRAINED;   // Not supported for now
 
    int hops = 0;
    vcode_var_t var = lower_search_vcode_obj(port, lu, &hops);
@@ -11809,6 +12553,7 @@ static void lower_direct_mapped_port(lower_unit_t *lu, tree_t block, tree_t map,
 
    hset_insert(direct, map);
    hset_insert(direct, port);
+   return COLLAPSE_DONE;
 }
 
 static void lower_port_signal(lower_unit_t *lu, tree_t port,
@@ -12073,6 +12818,8 @@ static void lower_ports(lower_unit_t *lu, tree_t block, tree_t src,
 
    hset_t *direct = hset_new(nports * 2), *poison = NULL;
    vcode_reg_t *map_regs LOCAL = xmalloc_array(nparams, sizeof(vcode_reg_t));
+   collapse_reason_t *reasons LOCAL =
+      xmalloc_array(nparams, sizeof(collapse_reason_t));
    vcode_var_t *port_vars LOCAL = xmalloc_array(nports, sizeof(vcode_var_t));
 
    for (int i = 0; i < nparams; i++) {
@@ -12104,8 +12851,12 @@ static void lower_ports(lower_unit_t *lu, tree_t block, tree_t src,
       // Filter out "direct mapped" inputs which can be aliased to
       // signals in the scope above
       for (int i = 0; i < nparams; i++)
-         lower_direct_mapped_port(lu, block, tree_param(block, i), direct,
-                                  &poison, map_regs[i]);
+         reasons[i] = lower_direct_mapped_port(lu, block, tree_param(block, i),
+                                               direct, &poison, map_regs[i]);
+   }
+   else {
+      for (int i = 0; i < nparams; i++)
+         reasons[i] = COLLAPSE_DISABLED;
    }
 
    for (int i = 0; i < nports; i++) {
@@ -12135,9 +12886,13 @@ static void lower_ports(lower_unit_t *lu, tree_t block, tree_t src,
          lower_port_map(lu, block, map, map_regs[i]);
       else if (poison != NULL && tree_subkind(map) == P_NAMED) {
          tree_t port = tree_ref(name_to_ref(tree_name(map)));
-         if (hset_contains(poison, port))
+         if (hset_contains(poison, port)) {
             lower_port_map(lu, block, map, map_regs[i]);
+            reasons[i] = COLLAPSE_PARTIAL;
+         }
       }
+
+      lu->collapse[reasons[i]]++;
    }
 
    hset_free(direct);
@@ -12145,6 +12900,19 @@ static void lower_ports(lower_unit_t *lu, tree_t block, tree_t src,
       hset_free(poison);
 }
 
+const char *collapse_reason_str(collapse_reason_t reason)
+{
+   static const char *text[] = {
+      "collapsed", "collapsing disabled", "port mode",
+      "multiple sources", "conversion function", "type conversion",
+      "not a signal", "partial association", "unconstrained port"
+   };
+   STATIC_ASSERT(ARRAY_LEN(text) == COLLAPSE_NUM_REASONS);
+
+   assert(reason < COLLAPSE_NUM_REASONS);
+   return text[reason];
+}
+
 static void lower_check_generic_constraint(lower_unit_t *lu, tree_t expect,
                                            tree_t generic, vcode_reg_t locus)
 {
@@ -12869,6 +13637,7 @@ typedef enum {
    UNIT_DEFERRED = 1,
    UNIT_GENERATED = 2,
    UNIT_FINALISED = 3,
+   UNIT_RELEASED = 4,
 } unit_kind_t;
 
 typedef void (*dep_visit_fn_t)(vcode_unit_t, void *);
@@ -12878,6 +13647,7 @@ typedef struct _unit_registry {
    hash_t        *map;
    hset_t        *visited;
    mir_context_t *mir;
+   hash_t        *drivers;
 } unit_registry_t;
 
 typedef struct {
@@ -12930,15 +13700,42 @@ void unit_registry_free(unit_registry_t *ur)
          }
          break;
 
+      case UNIT_RELEASED:
+         break;
+
       default:
          fatal_trace("invalid tagged pointer %p", value);
       }
    }
 
+   if (ur->drivers != NULL) {
+      for (hash_iter_t it = HASH_BEGIN;
+           hash_iter(ur->drivers, &it, &key, &value); )
+         free_drivers(value);
+
+      hash_free(ur->drivers);
+   }
+
    hash_free(ur->map);
    free(ur);
 }
 
+static driver_set_t *unit_registry_drivers(unit_registry_t *ur, tree_t unit)
+{
+   // The drivers of a design unit are the same for every instance so
+   // only analyse each unit once per elaboration
+   if (ur->drivers == NULL)
+      ur->drivers = hash_new(64);
+
+   driver_set_t *ds = hash_get(ur->drivers, unit);
+   if (ds == NULL) {
+      ds = find_drivers(unit);
+      hash_put(ur->drivers, unit, ds);
+   }
+
+   return ds;
+}
+
 void unit_registry_put(unit_registry_t *ur, lower_unit_t *lu)
 {
    assert(hash_get(ur->map, lu->name) == NULL);
@@ -12983,6 +13780,8 @@ static void walk_dependency_cb(ident_t name, void *ctx)
          vu = lu->vunit;
       }
       break;
+   case UNIT_RELEASED:
+      return;
    default:
       fatal_trace("invalid tagged pointer %p", ptr);
    }
@@ -13011,6 +13810,35 @@ void unit_registry_flush(unit_registry_t *ur, ident_t name)
    ur->visited = NULL;
 }
 
+void unit_registry_purge(unit_registry_t *ur)
+{
+   // Once elaboration is complete the vcode for processes is no longer
+   // needed as it has already been imported into MIR and they cannot be
+   // the context for any unit lowered later
+   const void *key;
+   void *value;
+   for (hash_iter_t it = HASH_BEGIN; hash_iter(ur->map, &it, &key, &value); ) {
+      if (pointer_tag(value) != UNIT_FINALISED)
+         continue;
+
+      vcode_unit_t vu = untag_pointer(value, struct _vcode_unit);
+      switch (vcode_unit_kind(vu)) {
+      case VCODE_UNIT_PROCESS:
+      case VCODE_UNIT_PROPERTY:
+         break;
+      default:
+         continue;
+      }
+
+      vcode_unit_t context = vcode_unit_context(vu);
+      if (context == NULL || vcode_unit_child(vu) != NULL)
+         continue;
+
+      vcode_unit_unref(vu);
+      hash_put(ur->map, key, tag_pointer(context, UNIT_RELEASED));
+   }
+}
+
 void unit_registry_finalise(unit_registry_t *ur, lower_unit_t *lu)
 {
    assert(pointer_tag(hash_get(ur->map, lu->name)) == UNIT_GENERATED);
@@ -13072,6 +13900,8 @@ vcode_unit_t unit_registry_get(unit_registry_t *ur, ident_t ident)
       {
          deferred_unit_t *du = untag_pointer(ptr, deferred_unit_t);
 
+         TIMELINE_BEGIN("lower", istr(ident));
+
          vcode_state_t state;
          vcode_state_save(&state);
 
@@ -13094,6 +13924,8 @@ vcode_unit_t unit_registry_get(unit_registry_t *ur, ident_t ident)
 
          vcode_state_restore(&state);
 
+         TIMELINE_END("lower");
+
          free(du);
          return vu;
       }
@@ -13107,6 +13939,9 @@ vcode_unit_t unit_registry_get(unit_registry_t *ur, ident_t ident)
    case UNIT_FINALISED:
       return untag_pointer(ptr, struct _vcode_unit);
 
+   case UNIT_RELEASED:
+      return NULL;
+
    default:
       fatal_trace("invalid tagged pointer %p", ptr);
    }
@@ -13137,6 +13972,9 @@ vcode_unit_t unit_registry_get_parent(unit_registry_t *ur, ident_t name)
          lower_unit_t *lu = untag_pointer(ptr, lower_unit_t);
          return vcode_unit_context(lu->vunit);
       }
+
+   case UNIT_RELEASED:
+      return untag_pointer(ptr, struct _vcode_unit);
       break;
 
    default:
@@ -37,6 +37,20 @@ typedef enum {
    LOWER_THUNK
 } lower_mode_t;
 
+typedef enum {
+   COLLAPSE_DONE,
+   COLLAPSE_DISABLED,
+   COLLAPSE_MODE,
+   COLLAPSE_DRIVERS,
+   COLLAPSE_CONV_FUNC,
+   COLLAPSE_TYPE_CONV,
+   COLLAPSE_NOT_SIGNAL,
+   COLLAPSE_PARTIAL,
+   COLLAPSE_UNCONSTRAINED,
+
+   COLLAPSE_NUM_REASONS
+} collapse_reason_t;
+
 typedef struct _lower_unit {
    unit_registry_t *registry;
    hash_t          *objects;
@@ -50,6 +64,8 @@ typedef struct _lower_unit {
    bool             finished;
    lower_mode_t     mode;
    unsigned         deferred;
+   driver_set_t    *drivers;
+   unsigned         collapse[COLLAPSE_NUM_REASONS];
 } lower_unit_t;
 
 unit_registry_t *unit_registry_new(mir_context_t *mc);
@@ -66,6 +82,7 @@ void unit_registry_defer2(unit_registry_t *ur, ident_t name,
 bool unit_registry_query(unit_registry_t *ur, ident_t ident);
 void unit_registry_finalise(unit_registry_t *ur, lower_unit_t *lu);
 void unit_registry_flush(unit_registry_t *ur, ident_t name);
+void unit_registry_purge(unit_registry_t *ur);
 vcode_unit_t unit_registry_get_parent(unit_registry_t *ur, ident_t name);
 void unit_registry_import(unit_registry_t *ur, vcode_unit_t vu);
 
@@ -89,6 +106,8 @@ vcode_unit_t lower_thunk_in_context(unit_registry_t *registry, tree_t t,
                                     lower_unit_t *parent);
 vcode_unit_t lower_case_generate_thunk(lower_unit_t *parent, tree_t t);
 
+const char *collapse_reason_str(collapse_reason_t reason);
+
 int lower_search_vcode_obj(void *key, lower_unit_t *scope, int *hops);
 void lower_put_vcode_obj(void *key, int obj, lower_unit_t *scope);
 
@@ -16,6 +16,7 @@
 //
 
 #include "util.h"
+#include "array.h"
 #include "common.h"
 #include "diag.h"
 #include "hash.h"
@@ -34,6 +35,10 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#ifndef __MINGW32__
+#include <sys/wait.h>
+#endif
+
 typedef enum {
    MAKE_TREE,
    MAKE_LIB,
@@ -48,18 +53,31 @@ struct ident_list {
 };
 
 typedef struct rule rule_t;
+typedef A(rule_t *) rule_list_t;
 
 typedef enum {
    RULE_ANALYSE,
    RULE_ELABORATE
 } rule_kind_t;
 
+typedef enum {
+   RULE_NEW,
+   RULE_VISITING,
+   RULE_DONE
+} rule_state_t;
+
 struct rule {
-   rule_t       *next;
-   rule_kind_t   kind;
-   ident_list_t *outputs;
-   ident_list_t *inputs;
-   ident_t       source;
+   rule_t         *next;
+   rule_kind_t     kind;
+   ident_list_t   *outputs;
+   ident_list_t   *inputs;
+   ident_t         source;
+   timestamp_t     mtime;
+   rule_state_t    state;
+   bool            rebuild;
+   int             pending;
+   int             pid;
+   rule_list_t     waiters;
 };
 
 static hash_t *rule_map = NULL;
@@ -156,6 +174,12 @@ static rule_t *make_rule_for_source(rule_t **all, rule_kind_t kind,
    new->kind    = kind;
    new->next    = *ins;
    new->source  = ident;
+   new->mtime   = UINT64_MAX;
+   new->state   = RULE_NEW;
+   new->rebuild = false;
+   new->pending = 0;
+   new->pid     = -1;
+   new->waiters = (rule_list_t)AINIT;
 
    *ins = new;
    return new;
@@ -167,6 +191,7 @@ static void make_free_rules(rule_t *list)
       rule_t *tmp = list->next;
       ident_list_free(list->inputs);
       ident_list_free(list->outputs);
+      ACLEAR(list->waiters);
       free(list);
       list = tmp;
    }
@@ -262,6 +287,9 @@ static void make_rule(tree_t t, rule_t **rules)
       fatal("cannot get products for %s", tree_kind_str(tree_kind(t)));
    }
 
+   // The rule is out of date if the source is newer than any unit
+   r->mtime = MIN(r->mtime, lib_get_mtime(work, tree_ident(t)));
+
    tree_walk_deps(t, make_add_inputs_cb, r);
 
    if (kind == T_ARCH)
@@ -379,23 +407,30 @@ static void make_add_target(lib_t lib, ident_t name, int kind, void *context)
    *(*outp)++ = lib_get(lib, name);
 }
 
-void make(tree_t *targets, int count, FILE *out)
+static rule_t *make_all_rules(tree_t **targets, int *count)
 {
-   rule_map = hash_new(256);
-
-   if (count == 0) {
+   if (*count == 0) {
       lib_t work = lib_work();
-      count = lib_index_size(work);
-      targets = xmalloc_array(count, sizeof(tree_t));
-      tree_t *outp = targets;
+      *count = lib_index_size(work);
+      *targets = xmalloc_array(*count, sizeof(tree_t));
+      tree_t *outp = *targets;
       lib_walk_index(work, make_add_target, &outp);
    }
 
-   make_header(targets, count, out);
-
    rule_t *rules = NULL;
-   for (int i = 0; i < count; i++)
-      make_rule(targets[i], &rules);
+   for (int i = 0; i < *count; i++)
+      make_rule((*targets)[i], &rules);
+
+   return rules;
+}
+
+void make(tree_t *targets, int count, FILE *out)
+{
+   rule_map = hash_new(256);
+
+   rule_t *rules = make_all_rules(&targets, &count);
+
+   make_header(targets, count, out);
 
    make_print_rules(rules, out);
    make_free_rules(rules);
@@ -418,3 +453,178 @@ void make(tree_t *targets, int count, FILE *out)
    hash_free(rule_map);
    rule_map = NULL;
 }
+
+static bool make_check_stale(rule_t *r, hash_t *producers)
+{
+   if (r->state == RULE_DONE)
+      return r->rebuild;
+   else if (r->state == RULE_VISITING)
+      return false;   // Units in the same file depend on each other
+
+   r->state = RULE_VISITING;
+
+   file_info_t info;
+   if (!get_file_info(istr(r->source), &info))
+      warnf("cannot find source file %s", istr(r->source));
+   else if (info.mtime > r->mtime)
+      r->rebuild = true;
+
+   for (ident_list_t *it = r->inputs; it != NULL; it = it->next) {
+      rule_t *dep = hash_get(producers, it->ident);
+      if (dep != NULL && dep != r && make_check_stale(dep, producers))
+         r->rebuild = true;
+   }
+
+   r->state = RULE_DONE;
+   return r->rebuild;
+}
+
+static void make_add_waiter(rule_t *dep, rule_t *r)
+{
+   for (int i = 0; i < dep->waiters.count; i++) {
+      if (dep->waiters.items[i] == r)
+         return;
+   }
+
+   APUSH(dep->waiters, r);
+   r->pending++;
+}
+
+static int make_spawn(rule_t *r, const char **args, int nargs)
+{
+   args[nargs] = istr(r->source);
+
+#ifdef __MINGW32__
+   // No fork on Windows so analyse each file in turn
+   r->pid = -1;
+   return spawnvp(_P_WAIT, args[0], (char *const *)args);
+#else
+   if ((r->pid = fork()) == 0) {
+      execv(args[0], (char *const *)args);
+      fatal_errno("execv");
+   }
+   else if (r->pid < 0)
+      fatal_errno("fork");
+
+   return 0;
+#endif
+}
+
+static rule_t *make_wait(rule_t *rules, int *status)
+{
+#ifdef __MINGW32__
+   should_not_reach_here();
+#else
+   int wstatus;
+   const pid_t pid = waitpid(-1, &wstatus, 0);
+   if (pid < 0)
+      fatal_errno("waitpid");
+
+   *status = WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : EXIT_FAILURE;
+
+   for (rule_t *r = rules; r != NULL; r = r->next) {
+      if (r->pid == pid) {
+         r->pid = -1;
+         return r;
+      }
+   }
+
+   fatal_trace("unexpected child process %d", pid);
+#endif
+}
+
+static void make_finished(rule_t *r, rule_list_t *ready)
+{
+   progress("analysed %s", istr(r->source));
+
+   for (int i = 0; i < r->waiters.count; i++) {
+      if (--(r->waiters.items[i]->pending) == 0)
+         APUSH(*ready, r->waiters.items[i]);
+   }
+}
+
+int make_build(tree_t *targets, int count, const char *const *prefix,
+               int nprefix)
+{
+   rule_map = hash_new(256);
+
+   rule_t *rules = make_all_rules(&targets, &count);
+
+   hash_t *producers = hash_new(256);
+   for (rule_t *r = rules; r != NULL; r = r->next) {
+      if (r->kind == RULE_ANALYSE) {
+         for (ident_list_t *it = r->outputs; it != NULL; it = it->next)
+            hash_put(producers, it->ident, r);
+      }
+   }
+
+   // Elaboration depends on command line options so only analysis
+   // rules are executed here
+   rule_list_t ready = AINIT;
+   for (rule_t *r = rules; r != NULL; r = r->next) {
+      if (r->kind != RULE_ANALYSE || !make_check_stale(r, producers))
+         continue;
+
+      for (ident_list_t *it = r->inputs; it != NULL; it = it->next) {
+         rule_t *dep = hash_get(producers, it->ident);
+         if (dep != NULL && dep != r && dep->rebuild)
+            make_add_waiter(dep, r);
+      }
+   }
+
+   for (rule_t *r = rules; r != NULL; r = r->next) {
+      if (r->rebuild && r->pending == 0)
+         APUSH(ready, r);
+   }
+
+   // Each child gets the global options followed by "-a FILE"
+   const char **args = xmalloc_array(nprefix + 3, sizeof(const char *));
+   memcpy(args, prefix, nprefix * sizeof(const char *));
+   args[nprefix] = "-a";
+   args[nprefix + 2] = NULL;
+
+   const int jobs = opt_get_int(OPT_JOBS);
+   int running = 0, status = EXIT_SUCCESS;
+
+   while (running > 0 || (status == EXIT_SUCCESS && ready.count > 0)) {
+      while (status == EXIT_SUCCESS && ready.count > 0 && running < jobs) {
+         rule_t *r = APOP(ready);
+         if ((status = make_spawn(r, args, nprefix + 1)) == EXIT_SUCCESS) {
+            if (r->pid == -1)
+               make_finished(r, &ready);
+            else
+               running++;
+         }
+      }
+
+      if (running > 0) {
+         int rc;
+         rule_t *r = make_wait(rules, &rc);
+         running--;
+
+         if (rc != EXIT_SUCCESS)
+            status = rc;
+         else
+            make_finished(r, &ready);
+      }
+   }
+
+   for (rule_t *r = rules; status == EXIT_SUCCESS && r; r = r->next) {
+      if (r->rebuild && r->pending > 0) {
+         errorf("cannot analyse %s due to circular dependency between "
+                "source files", istr(r->source));
+         status = EXIT_FAILURE;
+      }
+   }
+
+   ACLEAR(ready);
+   free(args);
+   free(targets);
+
+   make_free_rules(rules);
+   hash_free(producers);
+   hash_free(rule_map);
+   rule_map = NULL;
+
+   return status;
+}
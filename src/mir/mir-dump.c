@@ -152,8 +152,10 @@ const char *mir_op_string(mir_op_t op)
       [MIR_OP_ADD_TRIGGER] = "add trigger",
       [MIR_OP_FUNCTION_TRIGGER] = "function trigger",
       [MIR_OP_OR_TRIGGER] = "or trigger",
+      [MIR_OP_AND_TRIGGER] = "and trigger",
       [MIR_OP_CMP_TRIGGER] = "cmp trigger",
       [MIR_OP_LEVEL_TRIGGER] = "level trigger",
+      [MIR_OP_EDGE_TRIGGER] = "edge trigger",
       [MIR_OP_INSTANCE_NAME] = "instance name",
       [MIR_OP_LAST_EVENT] = "last event",
       [MIR_OP_LAST_ACTIVE] = "last active",
@@ -1468,6 +1470,8 @@ void mir_annotate(mir_unit_t *mu, const mir_annotate_t *cb, void *ctx)
                mir_dump_arg(mu, result, 3, cb, ctx);
                printf(" after ");
                mir_dump_arg(mu, result, 4, cb, ctx);
+               printf(" kind ");
+               mir_dump_arg(mu, result, 5, cb, ctx);
             }
             break;
 
@@ -1649,6 +1653,7 @@ void mir_annotate(mir_unit_t *mu, const mir_annotate_t *cb, void *ctx)
             break;
 
          case MIR_OP_OR_TRIGGER:
+         case MIR_OP_AND_TRIGGER:
          case MIR_OP_CMP_TRIGGER:
             {
                col += mir_dump_value(mu, result, cb, ctx);
@@ -1656,6 +1661,8 @@ void mir_annotate(mir_unit_t *mu, const mir_annotate_t *cb, void *ctx)
                col += mir_dump_value(mu, n->args[0], cb, ctx);
                if (n->op == MIR_OP_OR_TRIGGER)
                   col += printf(" || ");
+               else if (n->op == MIR_OP_AND_TRIGGER)
+                  col += printf(" && ");
                else
                   col += printf(" == ");
                col += mir_dump_value(mu, n->args[1], cb, ctx);
@@ -1676,6 +1683,18 @@ void mir_annotate(mir_unit_t *mu, const mir_annotate_t *cb, void *ctx)
             }
             break;
 
+         case MIR_OP_EDGE_TRIGGER:
+            {
+               col += mir_dump_value(mu, result, cb, ctx);
+               col += printf(" := %s ", mir_op_string(n->op));
+               col += mir_dump_value(mu, n->args[0], cb, ctx);
+               col += printf(" edge ");
+               col += mir_dump_value(mu, n->args[1], cb, ctx);
+               mir_dump_type(mu, col, n->type);
+               mir_dump_stamp(mu, n->type, n->stamp);
+            }
+            break;
+
          case MIR_OP_ENTER_STATE:
             {
                printf("%s ", mir_op_string(n->op));
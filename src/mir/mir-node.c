@@ -489,6 +489,73 @@ void mir_set_arg(mir_unit_t *mu, node_data_t *n, unsigned nth,
    }
 }
 
+mir_value_t mir_copy_node(mir_unit_t *mu, mir_unit_t *from, mir_value_t node,
+                          const mir_value_t *nodemap,
+                          const mir_value_t *parammap)
+{
+   const node_data_t *src = mir_node_data(from, node);
+   mir_stamp_t stamp = mir_copy_stamp(mu, from, src->stamp);
+
+   node_data_t *n = mir_add_node(mu, src->op, src->type, stamp, src->nargs);
+   n->loc = src->loc;
+
+   switch (src->op) {
+   case MIR_OP_CONST:
+      n->iconst = src->iconst;
+      break;
+   case MIR_OP_CONST_REAL:
+      n->dconst = src->dconst;
+      break;
+   case MIR_OP_CONST_VEC:
+      n->bits[0] = src->bits[0];
+      n->bits[1] = src->bits[1];
+      break;
+   case MIR_OP_DEBUG_LOCUS:
+      n->locus = src->locus;
+      break;
+   default:
+      {
+         const mir_value_t *args = mir_get_args(from, src);
+         for (int i = 0; i < src->nargs; i++) {
+            mir_value_t arg = args[i];
+            switch (arg.tag) {
+            case MIR_TAG_NODE:
+               arg = nodemap[arg.id];
+               assert(!mir_is_null(arg));
+               break;
+            case MIR_TAG_PARAM:
+               arg = parammap[arg.id];
+               break;
+            case MIR_TAG_STAMP:
+               {
+                  mir_stamp_t s = { .bits = arg.bits };
+                  arg = mir_cast_value(mir_copy_stamp(mu, from, s));
+               }
+               break;
+            case MIR_TAG_LINKAGE:
+               arg = mir_add_linkage(mu, from->linkage.items[arg.id]);
+               break;
+            case MIR_TAG_EXTVAR:
+               arg = mir_add_extvar(mu, from->extvars.items[arg.id]);
+               break;
+            case MIR_TAG_BLOCK:
+            case MIR_TAG_VAR:
+            case MIR_TAG_COMMENT:
+               fatal_trace("cannot copy %s argument to another unit",
+                           mir_op_string(src->op));
+            default:
+               break;
+            }
+
+            mir_set_arg(mu, n, i, arg);
+         }
+      }
+      break;
+   }
+
+   return (mir_value_t){ .tag = MIR_TAG_NODE, .id = mir_node_id(mu, n) };
+}
+
 node_data_t *mir_node_data(mir_unit_t *mu, mir_value_t value)
 {
    assert(value.tag == MIR_TAG_NODE);
@@ -2784,14 +2851,16 @@ void mir_build_resolve_signal(mir_unit_t *mu, mir_value_t signal,
 
 void mir_build_transfer_signal(mir_unit_t *mu, mir_value_t target,
                                mir_value_t source, mir_value_t count,
-                               mir_value_t reject, mir_value_t after)
+                               mir_value_t reject, mir_value_t after,
+                               mir_value_t kind)
 {
-   mir_build_5(mu, MIR_OP_TRANSFER_SIGNAL, MIR_NULL_TYPE, MIR_NULL_STAMP,
-               target, source, count, reject, after);
+   mir_build_6(mu, MIR_OP_TRANSFER_SIGNAL, MIR_NULL_TYPE, MIR_NULL_STAMP,
+               target, source, count, reject, after, kind);
 
    MIR_ASSERT(mir_is_signal(mu, target), "target is not a signal");
    MIR_ASSERT(mir_is_offset(mu, count), "count argument must be offset");
    MIR_ASSERT(mir_is_signal(mu, source), "source is not a signal");
+   MIR_ASSERT(mir_is_const(mu, kind), "kind must be constant");
 }
 
 mir_value_t mir_build_get_counters(mir_unit_t *mu, ident_t block)
@@ -2999,6 +3068,20 @@ mir_value_t mir_build_level_trigger(mir_unit_t *mu, mir_value_t signal,
    return result;
 }
 
+mir_value_t mir_build_edge_trigger(mir_unit_t *mu, mir_value_t signal,
+                                   mir_value_t edge)
+{
+   mir_type_t type = mir_trigger_type(mu);
+   mir_value_t result = mir_build_2(mu, MIR_OP_EDGE_TRIGGER, type,
+                                    MIR_NULL_STAMP, signal, edge);
+
+   MIR_ASSERT(mir_is_signal(mu, signal),
+              "edge trigger argument must be signal");
+   MIR_ASSERT(mir_is_const(mu, edge), "edge trigger kind must be constant");
+
+   return result;
+}
+
 mir_value_t mir_build_cmp_trigger(mir_unit_t *mu, mir_value_t left,
                                   mir_value_t right)
 {
@@ -3046,6 +3129,21 @@ mir_value_t mir_build_or_trigger(mir_unit_t *mu, mir_value_t left,
    return result;
 }
 
+mir_value_t mir_build_and_trigger(mir_unit_t *mu, mir_value_t left,
+                                  mir_value_t right)
+{
+   mir_type_t type = mir_trigger_type(mu);
+   mir_value_t result = mir_build_2(mu, MIR_OP_AND_TRIGGER, type,
+                                    MIR_NULL_STAMP, left, right);
+
+   MIR_ASSERT(mir_is(mu, left, MIR_TYPE_TRIGGER),
+              "and trigger left argument must be trigger");
+   MIR_ASSERT(mir_is(mu, right, MIR_TYPE_TRIGGER),
+              "and trigger right argument must be trigger");
+
+   return result;
+}
+
 void mir_build_add_trigger(mir_unit_t *mu, mir_value_t trigger)
 {
    mir_build_1(mu, MIR_OP_ADD_TRIGGER, MIR_NULL_TYPE, MIR_NULL_STAMP, trigger);
@@ -268,6 +268,8 @@ typedef enum {
    MIR_OP_GET_COUNTERS,
    MIR_OP_INSTANCE_INIT,
    MIR_OP_SCHED_ACTIVE,
+   MIR_OP_AND_TRIGGER,
+   MIR_OP_EDGE_TRIGGER,
 } mir_op_t;
 
 typedef enum {
@@ -679,7 +681,8 @@ void mir_build_resolve_signal(mir_unit_t *mu, mir_value_t signal,
                               mir_value_t resolution);
 void mir_build_transfer_signal(mir_unit_t *mu, mir_value_t target,
                                mir_value_t source, mir_value_t count,
-                               mir_value_t reject, mir_value_t after);
+                               mir_value_t reject, mir_value_t after,
+                               mir_value_t kind);
 
 // Coverage
 mir_value_t mir_build_get_counters(mir_unit_t *mu, ident_t block);
@@ -715,12 +718,16 @@ void mir_build_map_const(mir_unit_t *mu, mir_value_t src, mir_value_t dst,
 // Triggers
 mir_value_t mir_build_level_trigger(mir_unit_t *mu, mir_value_t signal,
                                     mir_value_t count);
+mir_value_t mir_build_edge_trigger(mir_unit_t *mu, mir_value_t signal,
+                                   mir_value_t edge);
 mir_value_t mir_build_cmp_trigger(mir_unit_t *mu, mir_value_t left,
                                   mir_value_t right);
 mir_value_t mir_build_function_trigger(mir_unit_t *mu, ident_t name,
                                        const mir_value_t *args, unsigned nargs);
 mir_value_t mir_build_or_trigger(mir_unit_t *mu, mir_value_t left,
                                  mir_value_t right);
+mir_value_t mir_build_and_trigger(mir_unit_t *mu, mir_value_t left,
+                                  mir_value_t right);
 void mir_build_add_trigger(mir_unit_t *mu, mir_value_t trigger);
 
 // Linking
@@ -17,6 +17,7 @@
 
 #include "util.h"
 #include "array.h"
+#include "hash.h"
 #include "ident.h"
 #include "mask.h"
 #include "mir/mir-node.h"
@@ -24,6 +25,7 @@
 #include "mir/mir-structs.h"
 #include "option.h"
 #include "printf.h"
+#include "tree.h"
 
 #include <assert.h>
 #include <stdlib.h>
@@ -332,6 +334,206 @@ static void mir_do_liveness(mir_unit_t *mu, mir_optim_t *opt)
    mask_free(&tmp);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Subprogram inlining
+
+#define INLINE_MAX_NODES 16
+
+static bool inline_is_safe(mir_op_t op)
+{
+   switch (op) {
+   case MIR_OP_COMMENT:
+   case MIR_OP_CONST:
+   case MIR_OP_CONST_REAL:
+   case MIR_OP_CONST_VEC:
+   case MIR_OP_DEBUG_LOCUS:
+   case MIR_OP_ADD:
+   case MIR_OP_SUB:
+   case MIR_OP_MUL:
+   case MIR_OP_DIV:
+   case MIR_OP_REM:
+   case MIR_OP_MOD:
+   case MIR_OP_NEG:
+   case MIR_OP_ABS:
+   case MIR_OP_TRAP_ADD:
+   case MIR_OP_TRAP_SUB:
+   case MIR_OP_TRAP_MUL:
+   case MIR_OP_TRAP_NEG:
+   case MIR_OP_AND:
+   case MIR_OP_OR:
+   case MIR_OP_XOR:
+   case MIR_OP_NOT:
+   case MIR_OP_CMP:
+   case MIR_OP_SELECT:
+   case MIR_OP_CAST:
+   case MIR_OP_RANGE_CHECK:
+   case MIR_OP_INDEX_CHECK:
+   case MIR_OP_ZERO_CHECK:
+   case MIR_OP_UARRAY_LEN:
+   case MIR_OP_UARRAY_LEFT:
+   case MIR_OP_UARRAY_RIGHT:
+   case MIR_OP_UARRAY_DIR:
+   case MIR_OP_RANGE_LENGTH:
+   case MIR_OP_RANGE_NULL:
+      return true;
+   default:
+      return false;
+   }
+}
+
+static bool inline_can_inline(mir_unit_t *mu, mir_unit_t *callee,
+                              const node_data_t *call)
+{
+   if (callee == NULL || callee == mu || callee->kind != MIR_UNIT_FUNCTION)
+      return false;
+   else if (callee->blocks.count != 1 || callee->vars.count > 0)
+      return false;
+   else if (callee->params.count != call->nargs - 1)
+      return false;
+
+   const block_data_t *bd = &(callee->blocks.items[0]);
+   if (bd->num_nodes == 0 || bd->num_nodes > INLINE_MAX_NODES)
+      return false;
+
+   for (int i = 0; i < bd->num_nodes - 1; i++) {
+      const node_data_t *n = &(callee->nodes[bd->nodes[i]]);
+      if (n->op != _MIR_DELETED_OP && !inline_is_safe(n->op))
+         return false;
+   }
+
+   const node_data_t *ret = &(callee->nodes[bd->nodes[bd->num_nodes - 1]]);
+   if (ret->op != MIR_OP_RETURN || ret->nargs != 1)
+      return false;
+
+   return mir_equals(callee->result, call->type);
+}
+
+static mir_value_t inline_call(mir_unit_t *mu, mir_block_t block, int pos,
+                               mir_unit_t *callee)
+{
+   block_data_t *bd = mir_block_data(mu, block);
+   const node_id_t id = bd->nodes[pos];
+   node_data_t *call = &(mu->nodes[id]);
+
+   mir_value_t *parammap LOCAL =
+      xmalloc_array(call->nargs, sizeof(mir_value_t));
+   for (int i = 1; i < call->nargs; i++)
+      parammap[i - 1] = mir_get_args(mu, call)[i];
+
+   mir_value_t *nodemap LOCAL =
+      xcalloc_array(callee->num_nodes, sizeof(mir_value_t));
+
+   const int old_count = bd->num_nodes;
+   mir_set_cursor(mu, block, MIR_APPEND);
+
+   const block_data_t *cbd = &(callee->blocks.items[0]);
+   for (int i = 0; i < cbd->num_nodes - 1; i++) {
+      mir_value_t node = { .tag = MIR_TAG_NODE, .id = cbd->nodes[i] };
+      const mir_op_t op = mir_get_op(callee, node);
+      if (op != MIR_OP_COMMENT && op != _MIR_DELETED_OP)
+         nodemap[node.id] = mir_copy_node(mu, callee, node, nodemap, parammap);
+   }
+
+   const node_data_t *ret = &(callee->nodes[cbd->nodes[cbd->num_nodes - 1]]);
+   mir_value_t result = mir_get_args(callee, ret)[0];
+   if (result.tag == MIR_TAG_NODE)
+      result = nodemap[result.id];
+   else if (result.tag == MIR_TAG_PARAM)
+      result = parammap[result.id];
+
+   // Move the copied nodes to where the call was and remove the call
+   const int ncopied = bd->num_nodes - old_count;
+   node_id_t *copied LOCAL = xmalloc_array(ncopied + 1, sizeof(node_id_t));
+   memcpy(copied, bd->nodes + old_count, ncopied * sizeof(node_id_t));
+   memmove(bd->nodes + pos + ncopied, bd->nodes + pos + 1,
+           (old_count - pos - 1) * sizeof(node_id_t));
+   memcpy(bd->nodes + pos, copied, ncopied * sizeof(node_id_t));
+   bd->num_nodes = old_count - 1 + ncopied;
+
+   mu->nodes[id].op = _MIR_DELETED_OP;
+   mu->nodes[id].nargs = 0;
+
+   return result;
+}
+
+static mir_value_t inline_resolve(const mir_value_t *subst, unsigned count,
+                                  mir_value_t value)
+{
+   while (value.tag == MIR_TAG_NODE && value.id < count
+          && !mir_is_null(subst[value.id]))
+      value = subst[value.id];
+
+   return value;
+}
+
+static void mir_do_inline(mir_unit_t *mu)
+{
+   const unsigned count = mu->num_nodes;
+   mir_value_t *subst LOCAL = NULL;
+   int ninlined = 0;
+
+   for (int i = 0; i < mu->blocks.count; i++) {
+      mir_block_t block = { .tag = MIR_TAG_BLOCK, .id = i };
+      for (int j = 0; j < mu->blocks.items[i].num_nodes; j++) {
+         const node_id_t id = mu->blocks.items[i].nodes[j];
+         const node_data_t *n = &(mu->nodes[id]);
+         if (n->op != MIR_OP_FCALL || mir_is_null(n->type))
+            continue;
+
+         mir_value_t link = mir_get_args(mu, n)[0];
+         ident_t name = mu->linkage.items[link.id];
+
+         // Only consider callees that have already been generated as
+         // lowering another unit here could recurse
+         mir_unit_t *callee = mir_peek_unit(mu->context, name);
+         if (!inline_can_inline(mu, callee, n))
+            continue;
+
+         const unsigned before = mu->blocks.items[i].num_nodes;
+
+         if (subst == NULL)
+            subst = xcalloc_array(count, sizeof(mir_value_t));
+
+         subst[id] = inline_call(mu, block, j, callee);
+         ninlined++;
+
+         // Skip over the copied nodes which cannot contain calls
+         j += mu->blocks.items[i].num_nodes - before;
+      }
+   }
+
+   mir_set_cursor(mu, MIR_NULL_BLOCK, MIR_APPEND);
+
+   if (ninlined == 0)
+      return;
+
+   for (int i = 0; i < mu->blocks.count; i++) {
+      const block_data_t *bd = &(mu->blocks.items[i]);
+      for (int j = 0; j < bd->num_nodes; j++) {
+         node_data_t *n = &(mu->nodes[bd->nodes[j]]);
+         switch (n->op) {
+         case MIR_OP_CONST:
+         case MIR_OP_CONST_REAL:
+         case MIR_OP_CONST_VEC:
+         case MIR_OP_DEBUG_LOCUS:
+            continue;
+         default:
+            break;
+         }
+
+         const mir_value_t *args = mir_get_args(mu, n);
+         for (int k = 0; k < n->nargs; k++) {
+            mir_value_t value = inline_resolve(subst, count, args[k]);
+            if (!mir_equals(value, args[k]))
+               mir_set_arg(mu, n, k, value);
+         }
+      }
+   }
+
+   if (opt_get_verbose(OPT_JIT_VERBOSE, istr(mu->name)))
+      printf("%s: inlined %d calls\n", istr(mu->name), ninlined);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Global value numbering
 
@@ -741,7 +943,9 @@ static void gvn_visit_block(mir_unit_t *mu, mir_block_t block,
       case MIR_OP_NULL:
       case MIR_OP_FUNCTION_TRIGGER:
       case MIR_OP_LEVEL_TRIGGER:
+      case MIR_OP_EDGE_TRIGGER:
       case MIR_OP_OR_TRIGGER:
+      case MIR_OP_AND_TRIGGER:
       case MIR_OP_ARRAY_REF:
       case MIR_OP_TABLE_REF:
       case MIR_OP_TEST:
@@ -853,6 +1057,422 @@ static void mir_do_gvn(mir_unit_t *mu, mir_optim_t *opt)
    opt->gvn = NULL;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Bounds check elimination
+
+typedef struct {
+   mir_value_t node;
+   mir_block_t block;
+   int         next;
+} bce_check_t;
+
+static bool bce_get_range(mir_unit_t *mu, mir_value_t value, int64_t *low,
+                          int64_t *high)
+{
+   if (mir_get_const(mu, value, low)) {
+      *high = *low;
+      return true;
+   }
+
+   mir_stamp_t stamp = mir_get_stamp(mu, value);
+   if (!mir_is_null(stamp)) {
+      const stamp_data_t *sd = mir_stamp_data(mu, stamp);
+      if (sd->kind == MIR_STAMP_INT) {
+         *low = sd->u.intg.low;
+         *high = sd->u.intg.high;
+         return true;
+      }
+   }
+
+   // The range of the value's type is not used here as arithmetic
+   // results and loads from unchecked storage may fall outside it
+   return false;
+}
+
+static bool bce_in_bounds(mir_unit_t *mu, mir_value_t node)
+{
+   // The check always passes if the range of the value is contained in
+   // the range spanned by the bounds for every possible direction
+   mir_value_t value = mir_get_arg(mu, node, 0);
+   mir_value_t left = mir_get_arg(mu, node, 1);
+   mir_value_t right = mir_get_arg(mu, node, 2);
+   mir_value_t dir = mir_get_arg(mu, node, 3);
+
+   if (mir_is(mu, value, MIR_TYPE_REAL))
+      return false;
+
+   int64_t vlow, vhigh, llow, lhigh, rlow, rhigh;
+   if (!bce_get_range(mu, value, &vlow, &vhigh))
+      return false;
+   else if (!bce_get_range(mu, left, &llow, &lhigh))
+      return false;
+   else if (!bce_get_range(mu, right, &rlow, &rhigh))
+      return false;
+
+   int64_t cdir;
+   const bool const_dir = mir_get_const(mu, dir, &cdir);
+
+   if (!const_dir || cdir == RANGE_TO) {
+      if (vlow < lhigh || vhigh > rlow)
+         return false;
+   }
+
+   if (!const_dir || cdir == RANGE_DOWNTO) {
+      if (vlow < rhigh || vhigh > llow)
+         return false;
+   }
+
+   return true;
+}
+
+static uint64_t bce_hash_check(mir_unit_t *mu, mir_value_t node)
+{
+   const node_data_t *n = mir_node_data(mu, node);
+   const mir_value_t *args = mir_get_args(mu, n);
+
+   uint64_t hash = n->op;
+   for (int i = 0; i < 4; i++)
+      hash = mix_bits_64(hash ^ args[i].bits);
+
+   return hash;
+}
+
+static bool bce_same_check(mir_unit_t *mu, mir_value_t a, mir_value_t b)
+{
+   const node_data_t *na = mir_node_data(mu, a);
+   const node_data_t *nb = mir_node_data(mu, b);
+
+   if (na->op != nb->op)
+      return false;
+
+   const mir_value_t *a_args = mir_get_args(mu, na);
+   const mir_value_t *b_args = mir_get_args(mu, nb);
+
+   for (int i = 0; i < 4; i++) {
+      if (!mir_equals(a_args[i], b_args[i]))
+         return false;
+   }
+
+   return true;
+}
+
+static void mir_do_bce(mir_unit_t *mu, mir_optim_t *opt)
+{
+   A(bce_check_t) checks = AINIT;
+   ihash_t *index = ihash_new(64);
+   int total = 0, removed = 0;
+
+   for (int i = 0; i < mu->blocks.count; i++) {
+      mir_block_t this = { .tag = MIR_TAG_BLOCK, .id = i };
+      const block_data_t *bd = mir_block_data(mu, this);
+      const cfg_block_t *cb = &(opt->cfg[i]);
+
+      for (int j = 0; j < bd->num_nodes; j++) {
+         mir_value_t node = { .tag = MIR_TAG_NODE, .id = bd->nodes[j] };
+
+         const mir_op_t op = mir_get_op(mu, node);
+         if (op != MIR_OP_INDEX_CHECK && op != MIR_OP_RANGE_CHECK)
+            continue;
+
+         total++;
+
+         bool redundant = bce_in_bounds(mu, node);
+
+         // An identical check in a dominating block must have passed
+         // already
+         const uint64_t hash = bce_hash_check(mu, node);
+         const int head = (intptr_t)ihash_get(index, hash) - 1;
+         for (int k = head; k != -1 && !redundant;
+              k = checks.items[k].next) {
+            const bce_check_t *prev = &(checks.items[k]);
+            if (!mask_test(&cb->dom, prev->block.id))
+               continue;
+            else if (bce_same_check(mu, node, prev->node))
+               redundant = true;
+         }
+
+         if (redundant) {
+            mir_set_cursor(mu, this, j);
+            mir_delete(mu);
+            removed++;
+         }
+         else {
+            const bce_check_t new = { node, this, head };
+            APUSH(checks, new);
+            ihash_put(index, hash, (void *)(intptr_t)checks.count);
+         }
+      }
+   }
+
+   if (removed > 0)
+      mir_compact(mu);
+
+   if (opt_get_verbose(OPT_JIT_VERBOSE, istr(mu->name)))
+      printf("%s: eliminated %d of %d bounds checks\n", istr(mu->name),
+             removed, total);
+
+   ACLEAR(checks);
+   ihash_free(index);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Loop invariant code motion
+
+typedef struct {
+   mir_block_t header;
+   mir_block_t preheader;
+   unsigned    size;
+   bit_mask_t  body;
+} licm_loop_t;
+
+static bool licm_is_pure(mir_op_t op)
+{
+   // Operations without side effects that cannot trap and so may be
+   // executed speculatively in the preheader
+   switch (op) {
+   case MIR_OP_ADD:
+   case MIR_OP_SUB:
+   case MIR_OP_MUL:
+   case MIR_OP_AND:
+   case MIR_OP_OR:
+   case MIR_OP_XOR:
+   case MIR_OP_NOT:
+   case MIR_OP_NEG:
+   case MIR_OP_ABS:
+   case MIR_OP_CMP:
+   case MIR_OP_SELECT:
+   case MIR_OP_CAST:
+   case MIR_OP_WRAP:
+   case MIR_OP_UNWRAP:
+   case MIR_OP_UARRAY_LEN:
+   case MIR_OP_UARRAY_LEFT:
+   case MIR_OP_UARRAY_RIGHT:
+   case MIR_OP_UARRAY_DIR:
+   case MIR_OP_RANGE_LENGTH:
+   case MIR_OP_RANGE_NULL:
+   case MIR_OP_ARRAY_REF:
+   case MIR_OP_RECORD_REF:
+   case MIR_OP_DEBUG_LOCUS:
+      return true;
+   default:
+      return false;
+   }
+}
+
+static bool licm_is_check(mir_unit_t *mu, mir_value_t node)
+{
+   // Operations which may trap but otherwise have no side effects: these
+   // can only be hoisted if they are always executed on loop entry
+   switch (mir_get_op(mu, node)) {
+   case MIR_OP_TRAP_ADD:
+   case MIR_OP_TRAP_SUB:
+   case MIR_OP_TRAP_MUL:
+   case MIR_OP_DIV:
+   case MIR_OP_REM:
+   case MIR_OP_MOD:
+   case MIR_OP_INDEX_CHECK:
+   case MIR_OP_RANGE_CHECK:
+   case MIR_OP_LENGTH_CHECK:
+   case MIR_OP_NULL_CHECK:
+   case MIR_OP_ZERO_CHECK:
+      return true;
+   case MIR_OP_LOAD:
+      return mir_get_mem(mu, mir_get_arg(mu, node, 0)) == MIR_MEM_CONST;
+   default:
+      return false;
+   }
+}
+
+static bool licm_is_invariant(mir_unit_t *mu, mir_value_t node,
+                              const licm_loop_t *loop, const unsigned *defblock)
+{
+   const node_data_t *n = mir_node_data(mu, node);
+   const mir_value_t *args = mir_get_args(mu, n);
+
+   for (int i = 0; i < n->nargs; i++) {
+      if (args[i].tag != MIR_TAG_NODE)
+         continue;
+      else if (defblock[args[i].id] == UINT_MAX)
+         continue;
+      else if (mask_test(&loop->body, defblock[args[i].id]))
+         return false;
+   }
+
+   return true;
+}
+
+static void licm_move_node(mir_unit_t *mu, mir_block_t from, int pos,
+                           mir_block_t to)
+{
+   block_data_t *src = mir_block_data(mu, from);
+   block_data_t *dst = mir_block_data(mu, to);
+
+   const node_id_t id = src->nodes[pos];
+   memmove(src->nodes + pos, src->nodes + pos + 1,
+           (src->num_nodes - pos - 1) * sizeof(node_id_t));
+   src->num_nodes--;
+
+   if (dst->num_nodes == dst->max_nodes) {
+      dst->max_nodes = MAX(4, dst->num_nodes * 2);
+      dst->nodes = xrealloc_array(dst->nodes, dst->max_nodes,
+                                  sizeof(node_id_t));
+   }
+
+   // Insert before the terminator
+   assert(dst->num_nodes > 0);
+   dst->nodes[dst->num_nodes] = dst->nodes[dst->num_nodes - 1];
+   dst->nodes[dst->num_nodes - 1] = id;
+   dst->num_nodes++;
+}
+
+static bool licm_hoist_block(mir_unit_t *mu, mir_block_t block,
+                             const licm_loop_t *loop, unsigned *defblock,
+                             bool allow_checks)
+{
+   bool changed = false, barrier = false;
+
+   block_data_t *bd = mir_block_data(mu, block);
+   for (int i = 0; i < bd->num_nodes - 1;) {
+      mir_value_t node = { .tag = MIR_TAG_NODE, .id = bd->nodes[i] };
+      const mir_op_t op = mir_get_op(mu, node);
+
+      bool movable = false;
+      if (licm_is_pure(op))
+         movable = licm_is_invariant(mu, node, loop, defblock);
+      else if (allow_checks && !barrier && licm_is_check(mu, node))
+         movable = licm_is_invariant(mu, node, loop, defblock);
+
+      if (movable) {
+         licm_move_node(mu, block, i, loop->preheader);
+         defblock[node.id] = loop->preheader.id;
+         changed = true;
+         continue;
+      }
+
+      switch (op) {
+      case MIR_OP_PHI:
+      case MIR_OP_COMMENT:
+      case MIR_OP_CONST:
+      case MIR_OP_CONST_REAL:
+      case MIR_OP_CONST_VEC:
+         break;
+      default:
+         // Any later check might be observed after this operation
+         barrier |= !licm_is_pure(op);
+         break;
+      }
+
+      i++;
+   }
+
+   return changed;
+}
+
+static int licm_loop_cmp(const void *a, const void *b)
+{
+   // Process inner loops first so invariants can move outwards
+   const licm_loop_t *la = a, *lb = b;
+   return la->size - lb->size;
+}
+
+static void mir_do_licm(mir_unit_t *mu, mir_optim_t *opt)
+{
+   mir_compact(mu);
+
+   A(licm_loop_t) loops = AINIT;
+   A(mir_block_t) worklist = AINIT;
+
+   for (int i = 0; i < mu->blocks.count; i++) {
+      const cfg_block_t *cb = &(opt->cfg[i]);
+      if (cb->entry)
+         continue;
+
+      licm_loop_t loop = {
+         .header    = cb->block,
+         .preheader = MIR_NULL_BLOCK,
+      };
+
+      // The header must have a single predecessor outside the loop,
+      // reached only through back edges otherwise
+      bool valid = true;
+      for (int j = 0; j < cb->in.count; j++) {
+         mir_block_t pred = cfg_get_edge(&cb->in, j);
+         if (mask_test(&opt->cfg[pred.id].dom, i))
+            APUSH(worklist, pred);
+         else if (mir_is_null(loop.preheader))
+            loop.preheader = pred;
+         else if (!mir_equals(loop.preheader, pred))
+            valid = false;
+      }
+
+      if (worklist.count == 0 || !valid || mir_is_null(loop.preheader)) {
+         ACLEAR(worklist);
+         continue;
+      }
+
+      mask_init(&loop.body, mu->blocks.count);
+      mask_set(&loop.body, i);
+
+      while (worklist.count > 0) {
+         mir_block_t b = APOP(worklist);
+         if (mask_test_and_set(&loop.body, b.id))
+            continue;
+
+         const cfg_block_t *pb = &(opt->cfg[b.id]);
+         for (int j = 0; j < pb->in.count; j++)
+            APUSH(worklist, cfg_get_edge(&pb->in, j));
+      }
+
+      loop.size = mask_popcount(&loop.body);
+      APUSH(loops, loop);
+   }
+
+   ACLEAR(worklist);
+
+   if (loops.count == 0)
+      return;
+
+   qsort(loops.items, loops.count, sizeof(licm_loop_t), licm_loop_cmp);
+
+   unsigned *defblock LOCAL = xmalloc_array(mu->num_nodes, sizeof(unsigned));
+   for (int i = 0; i < mu->num_nodes; i++)
+      defblock[i] = UINT_MAX;
+
+   for (int i = 0; i < mu->blocks.count; i++) {
+      const block_data_t *bd = &(mu->blocks.items[i]);
+      for (int j = 0; j < bd->num_nodes; j++)
+         defblock[bd->nodes[j]] = i;
+   }
+
+   for (int i = 0; i < loops.count; i++) {
+      const licm_loop_t *loop = &(loops.items[i]);
+
+      // Checks in the header are always executed on entry to the loop
+      // if the preheader jumps there unconditionally
+      const block_data_t *pd = mir_block_data(mu, loop->preheader);
+      const node_data_t *term = &(mu->nodes[pd->nodes[pd->num_nodes - 1]]);
+      const bool allow_checks = (term->op == MIR_OP_JUMP);
+
+      bool changed;
+      do {
+         changed = false;
+         for (size_t bit = -1; mask_iter(&loop->body, &bit);) {
+            mir_block_t b = { .tag = MIR_TAG_BLOCK, .id = bit };
+            const bool is_header = mir_equals(b, loop->header);
+            changed |= licm_hoist_block(mu, b, loop, defblock,
+                                        is_header && allow_checks);
+         }
+      } while (changed);
+
+      mask_free(&(loops.items[i].body));
+   }
+
+   ACLEAR(loops);
+
+   if (opt_get_verbose(OPT_LICM_VERBOSE, istr(mu->name)))
+      mir_dump_optim(mu, opt);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Dead code elimination using liveness information
 
@@ -1157,6 +1777,183 @@ static void mir_do_ra(mir_unit_t *mu, mir_optim_t *opt)
    opt->ra = NULL;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Escape analysis for temporary allocations
+
+#define ESCAPE_NONE -1
+
+static int escape_find(int *set, int id)
+{
+   while (set[id] != id)
+      id = set[id] = set[set[id]];
+   return id;
+}
+
+static bool escape_merge(int *set, bit_mask_t *escaped, int into, int from)
+{
+   const int a = escape_find(set, into);
+   const int b = escape_find(set, from);
+   if (a == b)
+      return false;
+
+   set[b] = a;
+
+   if (mask_test(escaped, b))
+      mask_set(escaped, a);
+
+   return true;
+}
+
+static bool escape_is_pointer(mir_unit_t *mu, mir_type_t type)
+{
+   if (mir_is_null(type))
+      return false;
+
+   switch (mir_get_class(mu, type)) {
+   case MIR_TYPE_UARRAY:
+   case MIR_TYPE_POINTER:
+   case MIR_TYPE_ACCESS:
+      return true;
+   default:
+      return false;
+   }
+}
+
+static bool escape_visit_node(mir_unit_t *mu, mir_value_t node, int *set,
+                              bit_mask_t *escaped)
+{
+   const node_data_t *n = mir_node_data(mu, node);
+   const mir_value_t *args = mir_get_args(mu, n);
+
+   bool changed = false;
+
+   for (int i = 0; i < n->nargs; i++) {
+      if (args[i].tag != MIR_TAG_NODE || set[args[i].id] == ESCAPE_NONE)
+         continue;
+
+      const int root = escape_find(set, args[i].id);
+
+      switch (n->op) {
+      case MIR_OP_LOAD:
+      case MIR_OP_COPY:
+      case MIR_OP_UARRAY_LEN:
+      case MIR_OP_UARRAY_LEFT:
+      case MIR_OP_UARRAY_RIGHT:
+      case MIR_OP_UARRAY_DIR:
+      case MIR_OP_REPORT:
+      case MIR_OP_ASSERT:
+         continue;   // Only reads or writes through the pointer
+      case MIR_OP_STORE:
+      case MIR_OP_SET:
+         if (i == 0)
+            continue;   // Destination pointer
+         break;
+      case MIR_OP_ARRAY_REF:
+      case MIR_OP_RECORD_REF:
+      case MIR_OP_WRAP:
+      case MIR_OP_UNWRAP:
+      case MIR_OP_SELECT:
+         if (set[node.id] == ESCAPE_NONE) {
+            set[node.id] = root;
+            changed = true;
+         }
+         else
+            changed |= escape_merge(set, escaped, node.id, root);
+         continue;
+      case MIR_OP_FCALL:
+         // VHDL functions cannot retain a reference to their arguments
+         // but may return one so the result inherits the allocation
+         if (!escape_is_pointer(mu, n->type))
+            continue;
+         else if (set[node.id] == ESCAPE_NONE) {
+            set[node.id] = root;
+            changed = true;
+         }
+         else
+            changed |= escape_merge(set, escaped, node.id, root);
+         continue;
+      default:
+         break;
+      }
+
+      if (!mask_test(escaped, root)) {
+         mask_set(escaped, root);
+         changed = true;
+      }
+   }
+
+   return changed;
+}
+
+static void mir_do_escape(mir_unit_t *mu, mir_optim_t *opt)
+{
+   // Allocations in functions which are only accessed through pointers
+   // that do not outlive the call are marked as stack memory so the
+   // code generator can place them in the frame rather than the TLAB
+
+   switch (mir_get_kind(mu)) {
+   case MIR_UNIT_FUNCTION:
+   case MIR_UNIT_THUNK:
+      break;
+   default:
+      return;   // Frame may not survive suspension
+   }
+
+   int *set = xmalloc_array(mu->num_nodes, sizeof(int));
+
+   bool any = false;
+   for (int i = 0; i < mu->num_nodes; i++) {
+      const node_data_t *n = &(mu->nodes[i]);
+      if (n->op == MIR_OP_ALLOC && mir_is_null(n->stamp)) {
+         set[i] = i;
+         any = true;
+      }
+      else
+         set[i] = ESCAPE_NONE;
+   }
+
+   if (!any) {
+      free(set);
+      return;
+   }
+
+   bit_mask_t escaped;
+   mask_init(&escaped, mu->num_nodes);
+
+   bool changed;
+   do {
+      changed = false;
+
+      for (int i = 0; i < mu->blocks.count; i++) {
+         mir_block_t this = { .tag = MIR_TAG_BLOCK, .id = i };
+         const block_data_t *bd = mir_block_data(mu, this);
+
+         for (int j = 0; j < bd->num_nodes; j++) {
+            mir_value_t node = { .tag = MIR_TAG_NODE, .id = bd->nodes[j] };
+            changed |= escape_visit_node(mu, node, set, &escaped);
+         }
+      }
+   } while (changed);
+
+   for (int i = 0; i < mu->num_nodes; i++) {
+      node_data_t *n = &(mu->nodes[i]);
+      if (n->op != MIR_OP_ALLOC || set[i] == ESCAPE_NONE)
+         continue;
+      else if (mask_test(&escaped, escape_find(set, i)))
+         continue;
+
+      int64_t count;
+      if (mir_get_const(mu, mir_get_args(mu, n)[0], &count))
+         n->stamp = mir_pointer_stamp(mu, MIR_MEM_STACK, MIR_NULL_STAMP);
+   }
+
+   if (opt_get_verbose(OPT_ESCAPE_VERBOSE, istr(mu->name)))
+      mir_dump_optim(mu, opt);
+
+   mask_free(&escaped);
+   free(set);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Debugging
 
@@ -1289,10 +2086,13 @@ void mir_optimise(mir_unit_t *mu, mir_pass_t passes)
 {
    mir_optim_t opt = {};
 
-   const mir_pass_t need_dom = MIR_PASS_GVN;
+   const mir_pass_t need_dom = MIR_PASS_GVN | MIR_PASS_BCE | MIR_PASS_LICM;
    const mir_pass_t need_liveness = MIR_PASS_DCE | MIR_PASS_RA;
    const mir_pass_t need_cfg = need_dom | need_liveness | MIR_PASS_CFG;
 
+   if (passes & MIR_PASS_INLINE)
+      mir_do_inline(mu);
+
    if (passes & need_cfg)
       opt.cfg = mir_get_cfg(mu);
 
@@ -1305,12 +2105,21 @@ void mir_optimise(mir_unit_t *mu, mir_pass_t passes)
    if (passes & MIR_PASS_GVN)
       mir_do_gvn(mu, &opt);
 
+   if (passes & MIR_PASS_BCE)
+      mir_do_bce(mu, &opt);
+
+   if (passes & MIR_PASS_LICM)
+      mir_do_licm(mu, &opt);
+
    if (passes & need_liveness)
       mir_do_liveness(mu, &opt);
 
    if (passes & MIR_PASS_DCE)
       mir_do_dce(mu, &opt);
 
+   if (passes & MIR_PASS_ESCAPE)
+      mir_do_escape(mu, &opt);
+
    if (passes & MIR_PASS_RA)
       mir_do_ra(mu, &opt);
 
@@ -65,11 +65,18 @@ mir_stamp_t mir_stamp_cmp(mir_unit_t *mu, mir_cmp_t cmp, mir_stamp_t left,
 mir_stamp_t mir_stamp_union(mir_unit_t *mu, mir_stamp_t left,
                             mir_stamp_t right);
 mir_stamp_t mir_stamp_cast(mir_unit_t *mu, mir_type_t type, mir_stamp_t stamp);
+mir_stamp_t mir_copy_stamp(mir_unit_t *mu, mir_unit_t *from,
+                           mir_stamp_t stamp);
 
 bool mir_stamp_const(mir_unit_t *mu, mir_stamp_t stamp, int64_t *cval);
 
 bool mir_is_terminator(mir_op_t op);
 
+mir_unit_t *mir_peek_unit(mir_context_t *mc, ident_t name);
+mir_value_t mir_copy_node(mir_unit_t *mu, mir_unit_t *from, mir_value_t node,
+                          const mir_value_t *nodemap,
+                          const mir_value_t *parammap);
+
 void mir_free_types(type_tab_t *tab);
 void *mir_global_malloc(mir_context_t *mc, size_t fixed, size_t nelems,
                         size_t size);
@@ -1014,6 +1014,19 @@ mir_stamp_t mir_pointer_stamp(mir_unit_t *mu, mir_mem_t mem, mir_stamp_t elem)
    return mir_build_stamp(mu, &sd);
 }
 
+mir_stamp_t mir_copy_stamp(mir_unit_t *mu, mir_unit_t *from,
+                           mir_stamp_t stamp)
+{
+   if (mir_is_null(stamp))
+      return MIR_NULL_STAMP;
+
+   stamp_data_t sd = *mir_stamp_data(from, stamp);
+   if (sd.kind == MIR_STAMP_POINTER)
+      sd.u.pointer.elem = mir_copy_stamp(mu, from, sd.u.pointer.elem);
+
+   return mir_build_stamp(mu, &sd);
+}
+
 bool mir_is_top(mir_unit_t *mu, mir_type_t type, mir_stamp_t stamp)
 {
    const type_data_t *td = mir_type_data(mu, type);
@@ -330,6 +330,16 @@ mir_unit_t *mir_get_unit(mir_context_t *mc, ident_t name)
    }
 }
 
+mir_unit_t *mir_peek_unit(mir_context_t *mc, ident_t name)
+{
+   // Like mir_get_unit but never triggers lowering of a deferred unit
+   void *ptr = chash_get(mc->map, name);
+   if (ptr == NULL || pointer_tag(ptr) != UNIT_GENERATED)
+      return NULL;
+
+   return untag_pointer(ptr, mir_unit_t);
+}
+
 mir_shape_t *mir_get_shape(mir_context_t *mc, ident_t name)
 {
    void *ptr = chash_get(mc->map, name);
@@ -81,14 +81,20 @@ void mir_compare_layout(mir_unit_t *a, mir_unit_t *b);
 #endif
 
 typedef enum {
-   MIR_PASS_GVN = (1 << 0),
-   MIR_PASS_DCE = (1 << 1),
-   MIR_PASS_CFG = (1 << 2),
-   MIR_PASS_RA  = (1 << 3),
+   MIR_PASS_GVN    = (1 << 0),
+   MIR_PASS_DCE    = (1 << 1),
+   MIR_PASS_CFG    = (1 << 2),
+   MIR_PASS_RA     = (1 << 3),
+   MIR_PASS_LICM   = (1 << 4),
+   MIR_PASS_BCE    = (1 << 5),
+   MIR_PASS_INLINE = (1 << 6),
+   MIR_PASS_ESCAPE = (1 << 7),
 } mir_pass_t;
 
 #define MIR_PASS_O0 (MIR_PASS_CFG | MIR_PASS_RA)
-#define MIR_PASS_O1 (MIR_PASS_O0 | MIR_PASS_GVN | MIR_PASS_DCE)
+#define MIR_PASS_O1                                             \
+   (MIR_PASS_O0 | MIR_PASS_INLINE | MIR_PASS_GVN | MIR_PASS_BCE \
+    | MIR_PASS_LICM | MIR_PASS_DCE | MIR_PASS_ESCAPE)
 #define MIR_PASS_O2 (MIR_PASS_O1)
 
 void mir_optimise(mir_unit_t *mu, mir_pass_t passes);
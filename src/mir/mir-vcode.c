@@ -781,9 +781,13 @@ static void import_range_check(mir_unit_t *mu, mir_import_t *imp, int op)
 
 static void import_sched_event(mir_unit_t *mu, mir_import_t *imp, int op)
 {
-   mir_value_t signal = imp->map[vcode_get_arg(op, 0)];
-   mir_value_t count  = imp->map[vcode_get_arg(op, 1)];
-   mir_build_sched_event(mu, signal, count);
+   mir_value_t on = imp->map[vcode_get_arg(op, 0)];
+
+   mir_value_t count = MIR_NULL_VALUE;
+   if (vcode_count_args(op) > 1)
+      count = imp->map[vcode_get_arg(op, 1)];
+
+   mir_build_sched_event(mu, on, count);
 }
 
 static void import_clear_event(mir_unit_t *mu, mir_import_t *imp, int op)
@@ -1024,8 +1028,9 @@ static void import_transfer_signal(mir_unit_t *mu, mir_import_t *imp, int op)
    mir_value_t count = imp->map[vcode_get_arg(op, 2)];
    mir_value_t reject = imp->map[vcode_get_arg(op, 3)];
    mir_value_t after = imp->map[vcode_get_arg(op, 4)];
+   mir_value_t kind = imp->map[vcode_get_arg(op, 5)];
 
-   mir_build_transfer_signal(mu, target, source, count, reject, after);
+   mir_build_transfer_signal(mu, target, source, count, reject, after, kind);
 }
 
 static void import_file_open(mir_unit_t *mu, mir_import_t *imp, int op)
@@ -1204,6 +1209,27 @@ static void import_or_trigger(mir_unit_t *mu, mir_import_t *imp, int op)
    imp->map[vcode_get_result(op)] = mir_build_or_trigger(mu, left, right);
 }
 
+static void import_and_trigger(mir_unit_t *mu, mir_import_t *imp, int op)
+{
+   mir_value_t left = imp->map[vcode_get_arg(op, 0)];
+   mir_value_t right = imp->map[vcode_get_arg(op, 1)];
+   imp->map[vcode_get_result(op)] = mir_build_and_trigger(mu, left, right);
+}
+
+static void import_level_trigger(mir_unit_t *mu, mir_import_t *imp, int op)
+{
+   mir_value_t nets = imp->map[vcode_get_arg(op, 0)];
+   mir_value_t count = imp->map[vcode_get_arg(op, 1)];
+   imp->map[vcode_get_result(op)] = mir_build_level_trigger(mu, nets, count);
+}
+
+static void import_edge_trigger(mir_unit_t *mu, mir_import_t *imp, int op)
+{
+   mir_value_t nets = imp->map[vcode_get_arg(op, 0)];
+   mir_value_t edge = imp->map[vcode_get_arg(op, 1)];
+   imp->map[vcode_get_result(op)] = mir_build_edge_trigger(mu, nets, edge);
+}
+
 static void import_add_trigger(mir_unit_t *mu, mir_import_t *imp, int op)
 {
    mir_value_t trigger = imp->map[vcode_get_arg(op, 0)];
@@ -1680,6 +1706,15 @@ static void import_block(mir_unit_t *mu, mir_import_t *imp)
       case VCODE_OP_OR_TRIGGER:
          import_or_trigger(mu, imp, i);
          break;
+      case VCODE_OP_AND_TRIGGER:
+         import_and_trigger(mu, imp, i);
+         break;
+      case VCODE_OP_LEVEL_TRIGGER:
+         import_level_trigger(mu, imp, i);
+         break;
+      case VCODE_OP_EDGE_TRIGGER:
+         import_edge_trigger(mu, imp, i);
+         break;
       case VCODE_OP_ADD_TRIGGER:
          import_add_trigger(mu, imp, i);
          break;
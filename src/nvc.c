@@ -30,15 +30,18 @@
 #include "rt/assert.h"
 #include "rt/model.h"
 #include "rt/mspace.h"
+#include "rt/random.h"
 #include "rt/rt.h"
 #include "rt/wave.h"
 #include "scan.h"
 #include "tcl/tcl-shell.h"
 #include "thread.h"
+#include "timeline.h"
 #include "vhpi/vhpi-model.h"
 #include "vlog/vlog-node.h"
 #include "vlog/vlog-phase.h"
 #include "vpi/vpi-model.h"
+#include "thirdparty/sha1.h"
 
 #include <getopt.h>
 #include <stdlib.h>
@@ -71,6 +74,8 @@ typedef struct {
    ident_t          top_level;
    const char      *top_level_arg;
    lib_t            work;
+   char           **globals;
+   int              nglobals;
 } cmd_state_t;
 
 const char copy_string[] =
@@ -84,6 +89,7 @@ const char version_string[] =
 
 static int process_command(int argc, char **argv, cmd_state_t *state);
 static int parse_int(const char *str);
+static size_t parse_size(const char *str);
 static jit_t *get_jit(cmd_state_t *state);
 
 static ident_t to_unit_name(const char *str)
@@ -244,13 +250,14 @@ static int analyse(int argc, char **argv, cmd_state_t *state)
       { "keywords",        required_argument, 0, 'k' },
       { "relative",        required_argument, 0, 'r' },
       { "warn",            required_argument, 0, 'W' },
+      { "jobs",            required_argument, 0, 'j' },
       { 0, 0, 0, 0 }
    };
 
    const int next_cmd = scan_cmd(2, argc, argv);
    int c, index = 0, error_limit = 20;
    const char *file_list = NULL;
-   const char *spec = ":D:f:I:W:";
+   const char *spec = ":D:f:I:W:j:";
    bool no_save = false, werror = false;
 
    while ((c = getopt_long(next_cmd, argv, spec, long_options, &index)) != -1) {
@@ -318,6 +325,15 @@ static int analyse(int argc, char **argv, cmd_state_t *state)
       case 'W':
          werror = parse_warn_option(optarg);
          break;
+      case 'j':
+         {
+            const int njobs = parse_int(optarg);
+            if (njobs < 1 || njobs > MAX_THREADS)
+               fatal("invalid job count %s", optarg);
+
+            opt_set_int(OPT_JOBS, njobs);
+         }
+         break;
       default:
          should_not_reach_here();
       }
@@ -421,7 +437,9 @@ static void parse_cover_options(const char *str, cover_mask_t *mask,
       { "count-from-to-z",       COVER_MASK_TOGGLE_COUNT_FROM_TO_Z      },
       { "include-mems",          COVER_MASK_TOGGLE_INCLUDE_MEMS         },
       { "exclude-unreachable",   COVER_MASK_EXCLUDE_UNREACHABLE         },
-      { "fsm-no-default-enums",  COVER_MASK_FSM_NO_DEFAULT_ENUMS        }
+      { "fsm-no-default-enums",  COVER_MASK_FSM_NO_DEFAULT_ENUMS        },
+      { "count-per-time-step",   COVER_MASK_TOGGLE_PER_TIME_STEP        },
+      { "hit-only",              COVER_MASK_HIT_ONLY                    },
    };
 
    for (const char *start = str; ; str++) {
@@ -469,6 +487,27 @@ static int parse_optimise_level(const char *str)
    return level;
 }
 
+static uint64_t elab_cache_key(char **argv, int next_cmd)
+{
+   SHA1_CTX ctx;
+   SHA1Init(&ctx);
+
+   SHA1Update(&ctx, (unsigned char *)version_string, strlen(version_string));
+
+   const vhdl_standard_t std = standard();
+   SHA1Update(&ctx, (unsigned char *)&std, sizeof(std));
+
+   for (int i = 1; i < next_cmd; i++)
+      SHA1Update(&ctx, (unsigned char *)argv[i], strlen(argv[i]) + 1);
+
+   unsigned char digest[SHA1_LEN];
+   SHA1Final(digest, &ctx);
+
+   uint64_t key;
+   memcpy(&key, digest, sizeof(key));
+   return key;
+}
+
 static int elaborate(int argc, char **argv, cmd_state_t *state)
 {
    static struct option long_options[] = {
@@ -482,6 +521,8 @@ static int elaborate(int argc, char **argv, cmd_state_t *state)
       { "no-save",         no_argument,       0, 'N' },
       { "jit",             no_argument,       0, 'j' },
       { "no-collapse",     no_argument,       0, 'C' },
+      { "aggressive-collapse", no_argument,   0, 'A' },
+      { "prune-sensitivity", no_argument,     0, 'P' },
       { "stats",           no_argument,       0, 'S' },
       { "trace",           no_argument,       0, 't' },
       { 0, 0, 0, 0 }
@@ -525,6 +566,14 @@ static int elaborate(int argc, char **argv, cmd_state_t *state)
          opt_set_int(OPT_NO_COLLAPSE, 1);
          meta.no_collapse = true;
          break;
+      case 'A':
+         opt_set_int(OPT_AGGRESSIVE_COLLAPSE, 1);
+         meta.aggressive_collapse = true;
+         break;
+      case 'P':
+         opt_set_int(OPT_PRUNE_SENSITIVITY, 1);
+         meta.prune_sensitivity = true;
+         break;
       case 'j':
          // No effect
          break;
@@ -562,6 +611,22 @@ static int elaborate(int argc, char **argv, cmd_state_t *state)
 
    progress("initialising");
 
+   // Skip elaboration if the design was previously elaborated with
+   // identical arguments and none of its libraries have changed
+   const bool can_reuse = !no_save && cover_mask == 0 && sdf_args == NULL
+      && state->plugins == NULL && opt_get_str(OPT_LOWER_VERBOSE) == NULL
+      && !opt_get_int(OPT_DUMP_LLVM);
+   const uint64_t elab_key = elab_cache_key(argv, next_cmd);
+
+   if (can_reuse && elab_is_current(state->work, state->top_level, elab_key)) {
+      progress("reusing elaborated design");
+
+      argc -= next_cmd - 1;
+      argv += next_cmd - 1;
+
+      return argc > 1 ? process_command(argc, argv, state) : EXIT_SUCCESS;
+   }
+
    object_t *obj = lib_get_generic(state->work, state->top_level, NULL);
    if (obj == NULL)
       fatal("cannot find unit %s in library %s",
@@ -620,12 +685,19 @@ static int elaborate(int argc, char **argv, cmd_state_t *state)
 
    vhpi_run_callbacks(vhpiCbStartOfElaboration);
 
+   TIMELINE_BEGIN("elaborate", istr(state->top_level));
+
    tree_t top = elab(obj, state->jit, state->registry, state->mir,
                      state->cover, NULL, state->model);
 
+   TIMELINE_END("elaborate");
+
    if (top == NULL)
       return EXIT_FAILURE;
 
+   unit_registry_purge(state->registry);
+
+   meta.static_size = model_static_size(state->model);
    lib_put_meta(state->work, top, &meta);
 
    progress("elaborating design");
@@ -638,6 +710,9 @@ static int elaborate(int argc, char **argv, cmd_state_t *state)
    if (!no_save) {
       lib_save(state->work);
       progress("saving library");
+
+      if (can_reuse)
+         elab_write_stamp(state->work, state->top_level, elab_key);
    }
 
    if (state->cover != NULL) {
@@ -755,10 +830,11 @@ static jit_t *get_jit(cmd_state_t *state)
 {
    jit_t *jit = jit_new(state->registry, state->mir);
 
-#if defined HAVE_LLVM && 1
+#ifdef HAVE_LLVM
    jit_register_llvm_plugin(jit);
-#elif defined ARCH_X86_64 && 0
-   jit_register_native_plugin(jit);
+#endif
+#if defined ARCH_X86_64 || defined ARCH_ARM64
+   jit_register_native_plugin(jit);   // Must be registered last
 #endif
 
    _std_standard_init();
@@ -831,13 +907,52 @@ static void enable_ieee_warnings_cb(rt_model_t *m, void *ctx)
    *ptr = 0;
 }
 
+static int run_more_seeds(tree_t top, int count, uint64_t stop_time,
+                          int ieee_warnings, cmd_state_t *state)
+{
+   // Each run creates a fresh model but reuses the code already
+   // compiled by the JIT for previous runs
+   int rc = 0;
+   for (int i = 0; i < count; i++) {
+      opt_set_int(OPT_RANDOM_SEED, opt_get_int(OPT_RANDOM_SEED) + 1);
+      opt_set_int(OPT_IEEE_WARNINGS, ieee_warnings);
+      reset_random();
+      clear_vhdl_assert();
+      jit_reset(state->jit);
+
+      state->model = model_new(state->jit, NULL);
+      reheat(top, state->registry, state->mir, NULL, state->model);
+
+      set_ctrl_c_handler(ctrl_c_handler, state->model);
+
+      model_reset(state->model);
+
+      if (opt_get_int(OPT_IEEE_WARNINGS) == IEEE_WARNINGS_OFF_AT_0)
+         model_set_phase_cb(state->model, END_TIME_STEP,
+                            enable_ieee_warnings_cb, state);
+
+      notef("running with seed %d", opt_get_int(OPT_RANDOM_SEED));
+
+      model_run(state->model, stop_time);
+
+      set_ctrl_c_handler(NULL, NULL);
+
+      rc = rc ?: model_exit_status(state->model);
+
+      model_free(state->model);
+      state->model = NULL;
+   }
+
+   return rc;
+}
+
 static int run_cmd(int argc, char **argv, cmd_state_t *state)
 {
    static struct option long_options[] = {
       { "trace",         no_argument,       0, 't' },
       { "profile",       no_argument,       0, 'p' },   // DEPRECATED 1.14
       { "stop-time",     required_argument, 0, 's' },
-      { "stats",         no_argument,       0, 'S' },
+      { "stats",         optional_argument, 0, 'S' },
       { "wave",          optional_argument, 0, 'w' },
       { "stop-delta",    required_argument, 0, 'd' },
       { "format",        required_argument, 0, 'f' },
@@ -851,6 +966,18 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
       { "vhpi-trace",    no_argument,       0, 'T' },
       { "gtkw",          optional_argument, 0, 'g' },
       { "shuffle",       no_argument,       0, 'H' },
+      { "threads",       required_argument, 0, 'j' },
+      { "profile-report", optional_argument, 0, 'P' },
+      { "profile-counters", no_argument,   0, 'K' },
+      { "delta-report",  required_argument, 0, 'Y' },
+      { "heap-profile",  optional_argument, 0, 'M' },
+      { "wave-buffer",   required_argument, 0, 'B' },
+      { "cover-sample",  required_argument, 0, 'C' },
+      { "wave-start",    required_argument, 0, 'W' },
+      { "wave-stop",     required_argument, 0, 'E' },
+      { "async-output",  optional_argument, 0, 'O' },
+      { "wave-server",   optional_argument, 0, 'R' },
+      { "seeds",         required_argument, 0, 'N' },
       { 0, 0, 0, 0 }
    };
 
@@ -859,6 +986,10 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
    const char   *wave_fname = NULL;
    const char   *gtkw_fname = NULL;
    const char   *pli_plugins = NULL;
+   uint64_t      sample_window = 0, sample_period = 0;
+   uint64_t      wave_start = 0, wave_stop = TIME_HIGH;
+   int           server_port = -1;
+   int           nseeds = 1;
 
    static bool have_run = false;
    if (have_run)
@@ -904,7 +1035,12 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
             fatal("invalid waveform format: %s", optarg);
          break;
       case 'S':
-         opt_set_int(OPT_RT_STATS, 1);
+         if (optarg == NULL)
+            opt_set_int(OPT_RT_STATS, STATS_TEXT);
+         else if (strcmp(optarg, "json") == 0)
+            opt_set_int(OPT_RT_STATS, STATS_JSON);
+         else
+            fatal("invalid statistics format: %s", optarg);
          break;
       case 'w':
          if (optarg == NULL)
@@ -958,6 +1094,79 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
                "as non-deterministic behaviour");
          opt_set_int(OPT_SHUFFLE_PROCS, 1);
          break;
+      case 'j':
+         {
+            const int nthreads = parse_int(optarg);
+            if (nthreads < 1 || nthreads > MAX_THREADS)
+               fatal("invalid thread count %s", optarg);
+
+            opt_set_int(OPT_RT_THREADS, nthreads);
+         }
+         break;
+      case 'P':
+         opt_set_str(OPT_RT_PROFILE, optarg ?: "");
+         break;
+      case 'Y':
+         {
+            const int threshold = parse_int(optarg);
+            if (threshold < 1)
+               fatal("$bold$--delta-report$$ argument must be greater "
+                     "than zero");
+            opt_set_int(OPT_DELTA_REPORT, threshold);
+         }
+         break;
+      case 'M':
+         opt_set_size(OPT_HEAP_PROFILE,
+                      optarg ? parse_size(optarg) : 512 * 1024);
+         break;
+      case 'K':
+         opt_set_int(OPT_PROFILE_COUNTERS, 1);
+         if (opt_get_str(OPT_RT_PROFILE) == NULL)
+            opt_set_str(OPT_RT_PROFILE, "");
+         break;
+      case 'B':
+         if (strcmp(optarg, "0") == 0)
+            opt_set_size(OPT_WAVE_BUFFER, 0);
+         else
+            opt_set_size(OPT_WAVE_BUFFER, parse_size(optarg));
+         break;
+      case 'O':
+         opt_set_size(OPT_ASYNC_OUTPUT,
+                      optarg ? parse_size(optarg) : 1024 * 1024);
+         break;
+      case 'W':
+         wave_start = parse_time(optarg);
+         break;
+      case 'R':
+         if (optarg == NULL)
+            server_port = opt_get_int(OPT_SERVER_PORT);
+         else
+            server_port = parse_int(optarg);
+         break;
+      case 'E':
+         wave_stop = parse_time(optarg);
+         break;
+      case 'N':
+         if ((nseeds = parse_int(optarg)) < 1)
+            fatal("$bold$--seeds$$ argument must be greater than zero");
+         break;
+      case 'C':
+         {
+            char *tmp LOCAL = xstrdup(optarg);
+            char *split = strchr(tmp, '/');
+            if (split == NULL)
+               fatal("invalid coverage sampling format '%s', expected "
+                     "WINDOW/PERIOD", optarg);
+
+            *split = '\0';
+            sample_window = parse_time(tmp);
+            sample_period = parse_time(split + 1);
+
+            if (sample_window == 0 || sample_window >= sample_period)
+               fatal("coverage sampling window must be non-zero and shorter "
+                     "than the period");
+         }
+         break;
       default:
          should_not_reach_here();
       }
@@ -986,6 +1195,8 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
    assert(top != NULL);
 
    opt_set_int(OPT_NO_COLLAPSE, meta->no_collapse);
+   opt_set_int(OPT_AGGRESSIVE_COLLAPSE, meta->aggressive_collapse);
+   opt_set_int(OPT_PRUNE_SENSITIVITY, meta->prune_sensitivity);
 
    wave_dumper_t *dumper = NULL;
    if (wave_fname != NULL) {
@@ -1006,9 +1217,21 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
 
       wave_include_file(argv[optind]);
       dumper = wave_dumper_new(wave_fname, gtkw_fname, top, wave_fmt);
+
+      if (wave_start >= wave_stop)
+         fatal("waveform dump start time must be before the stop time");
+      else if (wave_start > 0 || wave_stop != TIME_HIGH)
+         wave_dumper_set_window(dumper, wave_start, wave_stop);
    }
    else if (gtkw_fname != NULL)
       warnf("$bold$--gtkw$$ option has no effect without $bold$--wave$$");
+   else if (wave_start > 0 || wave_stop != TIME_HIGH)
+      warnf("$bold$--wave-start$$ and $bold$--wave-stop$$ options have no "
+            "effect without $bold$--wave$$");
+
+   wave_server_t *server = NULL;
+   if (server_port >= 0)
+      server = wave_server_new(server_port);
 
    if (opt_get_size(OPT_HEAP_SIZE) < 0x100000)
       warnf("recommended heap size is at least 1M");
@@ -1016,6 +1239,17 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
    if (state->cover == NULL)
       state->cover = load_coverage(meta);
 
+   if (sample_period > 0 && state->cover == NULL)
+      warnf("$bold$--cover-sample$$ option has no effect without "
+            "coverage collection enabled during elaboration");
+   else if (sample_period > 0)
+      cover_set_sampling(state->cover, sample_window, sample_period);
+
+   if (nseeds > 1 && (dumper != NULL || server != NULL || state->cover != NULL
+                      || pli_plugins != NULL || state->plugins != NULL))
+      fatal("$bold$--seeds$$ cannot be combined with waveform dumping, "
+            "coverage collection, or VHPI plugins");
+
    if (state->mir == NULL)
       state->mir = mir_context_new();
 
@@ -1027,6 +1261,7 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
 
    if (state->model == NULL) {
       state->model = model_new(state->jit, state->cover);
+      model_reserve(state->model, meta->static_size);
       reheat(top, state->registry, state->mir, state->cover, state->model);
    }
 
@@ -1052,24 +1287,39 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
 
    set_ctrl_c_handler(ctrl_c_handler, state->model);
 
+   const size_t async_size = opt_get_size(OPT_ASYNC_OUTPUT);
+   if (async_size > 0)
+      diag_async_start(async_size);
+
    model_reset(state->model);
 
    if (dumper != NULL)
       wave_dumper_restart(dumper, state->model, state->jit);
 
+   if (server != NULL)
+      wave_server_restart(server, state->model);
+
    if (opt_get_int(OPT_IEEE_WARNINGS) == IEEE_WARNINGS_OFF_AT_0)
       model_set_phase_cb(state->model, END_TIME_STEP,
                          enable_ieee_warnings_cb, state);
 
+   const int ieee_warnings = opt_get_int(OPT_IEEE_WARNINGS);
+
+   if (nseeds > 1)
+      notef("running with seed %d", opt_get_int(OPT_RANDOM_SEED));
+
    model_run(state->model, stop_time);
 
    set_ctrl_c_handler(NULL, NULL);
 
-   const int rc = model_exit_status(state->model);
+   int rc = model_exit_status(state->model);
 
    if (dumper != NULL)
       wave_dumper_free(dumper);
 
+   if (server != NULL)
+      wave_server_free(server);
+
    if (state->cover != NULL)
       emit_coverage(meta, state->jit, state->cover);
 
@@ -1082,6 +1332,15 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
    model_free(state->model);
    state->model = NULL;
 
+   if (nseeds > 1) {
+      const int rc2 = run_more_seeds(top, nseeds - 1, stop_time,
+                                     ieee_warnings, state);
+      rc = rc ?: rc2;
+   }
+
+   // Only stop the asynchronous writer once every seed has run
+   diag_async_stop();
+
    argc -= next_cmd - 1;
    argv += next_cmd - 1;
 
@@ -1134,18 +1393,16 @@ static int print_deps_cmd(int argc, char **argv, cmd_state_t *state)
 static int make_cmd(int argc, char **argv, cmd_state_t *state)
 {
    static struct option long_options[] = {
-      { "deps-only", no_argument, 0, 'd' },
-      { "posix",     no_argument, 0, 'p' },
+      { "deps-only", no_argument,       0, 'd' },   // DEPRECATED 1.8
+      { "posix",     no_argument,       0, 'p' },   // DEPRECATED 1.8
+      { "jobs",      required_argument, 0, 'j' },
       { 0, 0, 0, 0 }
    };
 
-   warnf("the $bold$--make$$ command is deprecated and may be repurposed in a "
-         "future release");
-   notef("use $bold$--print-deps$$ to print Makefile dependencies instead");
-
    const int next_cmd = scan_cmd(2, argc, argv);
    int c, index = 0;
-   const char *spec = ":";
+   const char *spec = ":j:";
+   bool legacy = false;
    while ((c = getopt_long(next_cmd, argv, spec, long_options, &index)) != -1) {
       switch (c) {
       case 0:
@@ -1153,9 +1410,20 @@ static int make_cmd(int argc, char **argv, cmd_state_t *state)
          break;
       case 'd':
          opt_set_int(OPT_MAKE_DEPS_ONLY, 1);
+         legacy = true;
          break;
       case 'p':
          // Does nothing
+         legacy = true;
+         break;
+      case 'j':
+         {
+            const int njobs = parse_int(optarg);
+            if (njobs < 1 || njobs > MAX_THREADS)
+               fatal("invalid job count %s", optarg);
+
+            opt_set_int(OPT_JOBS, njobs);
+         }
          break;
       case '?':
          bad_option("make", argv);
@@ -1166,6 +1434,18 @@ static int make_cmd(int argc, char **argv, cmd_state_t *state)
       }
    }
 
+   if (legacy) {
+      warnf("the $bold$--deps-only$$ and $bold$--posix$$ options to "
+            "$bold$--make$$ are deprecated");
+      notef("use $bold$--print-deps$$ to print Makefile dependencies instead");
+   }
+   else if (next_cmd < argc)
+      fatal("$bold$--make$$ cannot be followed by another command");
+   else {
+      // Out of date units are about to be reanalysed
+      opt_set_int(OPT_IGNORE_TIME, 1);
+   }
+
    const int count = next_cmd - optind;
    tree_t *targets = xmalloc_array(count, sizeof(tree_t));
 
@@ -1179,6 +1459,20 @@ static int make_cmd(int argc, char **argv, cmd_state_t *state)
       }
    }
 
+   if (!legacy) {
+      LOCAL_TEXT_BUF tb = tb_new();
+      if (!get_exe_path(tb))
+         fatal("cannot determine path to " PACKAGE " executable");
+
+      const char **prefix LOCAL =
+         xmalloc_array(state->nglobals + 1, sizeof(const char *));
+      prefix[0] = tb_get(tb);
+      for (int i = 0; i < state->nglobals; i++)
+         prefix[i + 1] = state->globals[i];
+
+      return make_build(targets, count, prefix, state->nglobals + 1);
+   }
+
    make(targets, count, stdout);
 
    argc -= next_cmd - 1;
@@ -2149,7 +2443,7 @@ static void usage(void)
       struct {
          const char *args;
          const char *usage;
-      } options[16];
+      } options[20];
    } groups[] = {
       { "Commands",
         {
@@ -2172,6 +2466,8 @@ static void usage(void)
            { "--list", "Print all units in the library" },
            { "--preprocess FILE...",
              "Expand FILEs with Verilog preprocessor" },
+           { "--make [-j N] [UNIT]...",
+             "Reanalyse out of date source files" },
            { "--print-deps [UNIT]...",
              "Print dependencies in Makefile format" },
         }
@@ -2193,6 +2489,8 @@ static void usage(void)
            { "--std={1993,..,2019}", "VHDL standard revision to use" },
            { "--stderr={note,warning,error,failure,none}",
              "Print messages of this severity level or higher to stderr" },
+           { "--trace-events=FILE",
+             "Write timeline of compiler and simulator phases to FILE" },
            { "-v, --version", "Display version and copyright information" },
            { "--vhpi-debug", "Report VHPI errors as diagnostic messages" },
            { "--vhpi-trace", "Trace VHPI calls and events" },
@@ -2208,6 +2506,7 @@ static void usage(void)
            { "--error-limit=NUM", "Stop after NUM errors" },
            { "-f, --files=LIST", "Read files to analyse from LIST" },
            { "-I DIR", "Add DIR to list of Verilog include directories" },
+           { "-j, --jobs=N", "Save analysed design units using N threads" },
            { "--keywords=VERSION",
              "Use keywords from specified Verilog version" },
            { "--no-save", "Do not save analysed design units" },
@@ -2223,6 +2522,9 @@ static void usage(void)
       },
       { "Elaboration options",
         {
+           { "--aggressive-collapse",
+             "Also collapse ports through identity conversions and "
+             "singly-driven inout ports" },
            { "--cover[={statement,branch,expression,toggle,...}]",
              "Enable code coverage collection" },
            { "--cover-file=FILE",
@@ -2235,12 +2537,21 @@ static void usage(void)
            { "-O0, -O1, -O2, -O3", "Set optimisation level (default is -O2)" },
            { "--no-collapse", "Do not collapse multiple signals into one" },
            { "--no-save", "Do not save the elaborated design to disk" },
-           { "--stats", "Print statistics about instantiated design units" },
+           { "--prune-sensitivity",
+             "Only wake combinational case processes when the selected "
+             "branch may be affected" },
+           { "--stats",
+             "Print statistics about instantiated design units, "
+             "collapsed ports, and clocked and combinational processes" },
            { "-V, --verbose", "Print resource usage at each step" },
         }
       },
       { "Run options",
         {
+           { "--async-output[=SIZE]", "Write report and assertion messages "
+             "from a background thread buffering up to SIZE bytes" },
+           { "--delta-report=N", "Report signals and processes active in "
+             "time steps with more than N delta cycles" },
            { "--dump-arrays[=N]",
              "Include nested arrays with up to N elements in waveform dump" },
            { "--exclude=GLOB",
@@ -2248,14 +2559,29 @@ static void usage(void)
            { "--exit-severity={note,warning,error,failure}",
              "Exit after an assertion failure of this severity" },
            { "--format={fst,vcd}", "Waveform dump format" },
+           { "--heap-profile[=SIZE]", "Sample heap allocations every SIZE "
+             "bytes and report live bytes by source location" },
            { "--include=GLOB",
              "Include signals matching GLOB in waveform dump" },
+           { "--profile-counters", "Include hardware performance counters "
+             "for each process in the profile report" },
+           { "--profile-report[=FILE]",
+             "Print time spent in each process and signal at end of run "
+             "and optionally write it to JSON FILE" },
+           { "--seeds=N", "Run the simulation N times with consecutive "
+             "random seeds" },
            { "--shuffle", "Run processes in random order" },
-           { "--stats", "Print time and memory usage at end of run" },
+           { "--stats[=json]", "Print time and memory usage at end of run, "
+             "including a breakdown of static memory by structure type, "
+             "or dump simulation counters as JSON" },
            { "--stop-delta=N", "Stop after N delta cycles (default 10000)" },
            { "--stop-time=T", "Stop after simulation time T (e.g. 5ns)" },
+           { "--threads=N", "Evaluate processes using N threads" },
            { "--trace", "Trace simulation events" },
            { "-w, --wave[=FILE]", "Write waveform dump to FILE" },
+           { "--wave-buffer=SIZE",
+             "Buffer up to SIZE bytes of waveform data for the background "
+             "writer thread (default 16m)" },
         }
       },
       { "Coverage report options",
@@ -2440,7 +2766,7 @@ static int process_command(int argc, char **argv, cmd_state_t *state)
 {
    static struct option long_options[] = {
       { "dump",         no_argument, 0, 'd' },
-      { "make",         no_argument, 0, 'm' },   // DEPRECATED 1.8
+      { "make",         no_argument, 0, 'm' },
       { "syntax",       no_argument, 0, 's' },   // DEPRECATED 1.15
       { "list",         no_argument, 0, 'l' },
       { "init",         no_argument, 0, 'n' },
@@ -2527,6 +2853,7 @@ int main(int argc, char **argv)
       { "vhpi-debug",    no_argument,       0, 'D' },
       { "vhpi-trace",    no_argument,       0, 'T' },
       { "seed",          required_argument, 0, 'S' },
+      { "trace-events",  required_argument, 0, 'X' },
       { 0, 0, 0, 0 }
    };
 
@@ -2601,6 +2928,9 @@ int main(int argc, char **argv)
       case 'S':
          opt_set_int(OPT_RANDOM_SEED, parse_int(optarg));
          break;
+      case 'X':
+         timeline_open(optarg);
+         break;
       case '?':
          bad_option("global", argv);
       case ':':
@@ -2612,6 +2942,10 @@ int main(int argc, char **argv)
 
    srand(opt_get_int(OPT_RANDOM_SEED));
 
+   // Passed to child processes spawned by --make
+   state.globals  = argv + 1;
+   state.nglobals = optind - 1;
+
    state.work = lib_new(work_name);
    lib_set_work(state.work);
 
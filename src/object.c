@@ -34,6 +34,7 @@ typedef uint64_t mark_mask_t;
 
 typedef A(object_arena_t *) arena_array_t;
 typedef A(object_t **) object_ptr_array_t;
+typedef A(object_t *) object_array_t;
 
 typedef enum { OBJ_DISK, OBJ_FRESH } obj_src_t;
 
@@ -52,10 +53,12 @@ typedef struct _object_arena {
    arena_key_t     key;
    arena_array_t   deps;
    object_t       *root;
+   object_array_t  gc_roots;
    obj_src_t       source;
    vhdl_standard_t std;
    uint32_t        checksum;
    generation_t    copygen;
+   mem_pool_t     *pool;
    bool            frozen;
    bool            obsolete;
 } object_arena_t;
@@ -103,6 +106,8 @@ static arena_array_t   all_arenas;
 static object_arena_t *global_arena = NULL;
 static chash_t        *arena_lookup;
 
+char *arena_base_map[UINT16_MAX];
+
 static inline bool object_in_arena_p(object_arena_t *arena, object_t *object)
 {
    return (void *)object >= arena->base && (void *)object < arena->limit;
@@ -276,41 +281,136 @@ void object_lookup_failed(object_class_t *class, object_t *object, imask_t mask)
    fatal_exit(EXIT_FAILURE);
 }
 
+static inline object_ref_t object_to_ref(object_t *o)
+{
+   const ptrdiff_t offset = (char *)o - arena_base_map[o->arena];
+   assert(offset >= 0 && (offset & (OBJECT_ALIGN - 1)) == 0);
+   assert((offset >> OBJECT_ALIGN_BITS) <= UINT32_MAX);
+   return offset >> OBJECT_ALIGN_BITS;
+}
+
+static inline unsigned obj_array_limit(const obj_array_t *a)
+{
+   return a->limit_log2 == 0 ? a->count : 1u << a->limit_log2;
+}
+
+static inline size_t obj_array_item_size(bool wide)
+{
+   return wide ? sizeof(object_t *) : sizeof(object_ref_t);
+}
+
+static inline void obj_array_store(obj_array_t *a, unsigned n, object_t *o)
+{
+   if (a->wide)
+      a->ptrs[n] = o;
+   else {
+      assert(o != NULL && o->arena == a->arena);
+      a->refs[n] = object_to_ref(o);
+   }
+}
+
+static void obj_array_widen(obj_array_t **a, object_t *o)
+{
+   if ((*a)->wide || (o != NULL && o->arena == (*a)->arena))
+      return;
+
+   // Items from more than one arena must be stored as full pointers
+   obj_array_t *old = *a;
+   const unsigned limit = obj_array_limit(old);
+
+   obj_array_t *new =
+      xmalloc_flex(sizeof(obj_array_t), limit, sizeof(object_t *));
+   new->count      = old->count;
+   new->wide       = true;
+   new->limit_log2 = old->limit_log2;
+   new->arena      = 0;
+
+   for (unsigned i = 0; i < old->count; i++)
+      new->ptrs[i] = object_from_ref(old->arena, old->refs[i]);
+
+   free(old);
+   *a = new;
+}
+
+static obj_array_t *obj_array_new(object_t *const *items, unsigned count,
+                                  mem_pool_t *pool)
+{
+   // Allocate an array of exactly the right size for the given items
+   // which can be stored compactly if they are all in the same arena
+   assert(count > 0);
+
+   bool wide = false;
+   for (unsigned i = 0; i < count && !wide; i++)
+      wide = items[i] == NULL || items[i]->arena != items[0]->arena;
+
+   const size_t itemsz = obj_array_item_size(wide);
+
+   obj_array_t *a;
+   if (pool != NULL)
+      a = pool_malloc_flex(pool, sizeof(obj_array_t), count, itemsz);
+   else
+      a = xmalloc_flex(sizeof(obj_array_t), count, itemsz);
+
+   a->count      = count;
+   a->wide       = wide;
+   a->limit_log2 = 0;
+   a->arena      = wide ? 0 : items[0]->arena;
+
+   for (unsigned i = 0; i < count; i++)
+      obj_array_store(a, i, items[i]);
+
+   return a;
+}
+
 void obj_array_add(obj_array_t **a, object_t *o)
 {
    if (*a == NULL) {
-      const int defsz = 8;
-      *a = xmalloc_flex(sizeof(obj_array_t), defsz, sizeof(object_t *));
-      (*a)->count = 0;
-      (*a)->limit = defsz;
+      const int defsz_log2 = 3;
+      const bool wide = (o == NULL);
+      *a = xmalloc_flex(sizeof(obj_array_t), 1 << defsz_log2,
+                        obj_array_item_size(wide));
+      (*a)->count      = 0;
+      (*a)->wide       = wide;
+      (*a)->limit_log2 = defsz_log2;
+      (*a)->arena      = wide ? 0 : o->arena;
    }
-   else if ((*a)->count == (*a)->limit) {
-      (*a)->limit *= 2;
-      *a = xrealloc_flex(*a, sizeof(obj_array_t),
-                         (*a)->limit, sizeof(object_t *));
+   else
+      obj_array_widen(a, o);
+
+   if ((*a)->count == obj_array_limit(*a)) {
+      const unsigned limit = next_power_of_2((*a)->count + 1);
+      (*a)->limit_log2 = ilog2(limit);
+      *a = xrealloc_flex(*a, sizeof(obj_array_t), limit,
+                         obj_array_item_size((*a)->wide));
    }
 
-   (*a)->items[(*a)->count++] = o;
+   obj_array_store(*a, (*a)->count++, o);
+}
+
+void obj_array_set(obj_array_t **a, unsigned n, object_t *o)
+{
+   assert(n < (*a)->count);
+
+   obj_array_widen(a, o);
+   obj_array_store(*a, n, o);
 }
 
 void obj_array_copy(obj_array_t **dst, const obj_array_t *src)
 {
    if (src == NULL)
       return;
-
-   if (*dst == NULL) {
-      *dst = xmalloc_flex(sizeof(obj_array_t), src->count, sizeof(object_t *));
-      (*dst)->count = 0;
-      (*dst)->limit = src->count;
+   else if (*dst == NULL && !src->wide) {
+      const size_t bytes = src->count * sizeof(object_ref_t);
+      *dst = xmalloc_flex(sizeof(obj_array_t), src->count,
+                          sizeof(object_ref_t));
+      **dst = *src;
+      (*dst)->limit_log2 = 0;
+      memcpy((*dst)->refs, src->refs, bytes);
    }
-   else if ((*dst)->count + src->count > (*dst)->limit) {
-      (*dst)->limit = (*dst)->count + src->count;
-      *dst = xrealloc_flex(*dst, sizeof(obj_array_t),
-                           (*dst)->limit, sizeof(object_t *));
+   else {
+      for (int i = 0; i < src->count; i++)
+         obj_array_add(dst, obj_array_nth(src, i));
    }
-
-   for (int i = 0; i < src->count; i++)
-      (*dst)->items[(*dst)->count++] = src->items[i];
 }
 
 void obj_array_free(obj_array_t **a)
@@ -319,6 +419,16 @@ void obj_array_free(obj_array_t **a)
    *a = NULL;
 }
 
+static bool is_gc_root(const object_class_t *class, int kind)
+{
+   for (int j = 0; j < class->gc_num_roots; j++) {
+      if (class->gc_roots[j] == kind)
+         return true;
+   }
+
+   return false;
+}
+
 void object_change_kind(const object_class_t *class, object_t *object, int kind)
 {
    if (kind == object->kind)
@@ -359,6 +469,9 @@ void object_change_kind(const object_class_t *class, object_t *object, int kind)
          memset(&(object->items[np++]), '\0', sizeof(item_t));
    }
 
+   if (is_gc_root(class, kind) && !is_gc_root(class, object->kind))
+      APUSH(__object_arena(object)->gc_roots, object);
+
    object->kind = kind;
 }
 
@@ -477,16 +590,6 @@ static void object_one_time_init(void)
       });
 }
 
-static bool is_gc_root(const object_class_t *class, int kind)
-{
-   for (int j = 0; j < class->gc_num_roots; j++) {
-      if (class->gc_roots[j] == kind)
-         return true;
-   }
-
-   return false;
-}
-
 object_t *object_new(object_arena_t *arena,
                      const object_class_t *class, int kind)
 {
@@ -520,8 +623,11 @@ object_t *object_new(object_arena_t *arena,
    object_t *object = arena->alloc;
    arena->alloc = (char *)arena->alloc + size;
 
-   if (arena->root == NULL && is_gc_root(class, kind))
-      arena->root = object;
+   if (is_gc_root(class, kind)) {
+      if (arena->root == NULL)
+         arena->root = object;
+      APUSH(arena->gc_roots, object);
+   }
 
    memset(object, '\0', size);
 
@@ -533,29 +639,35 @@ object_t *object_new(object_arena_t *arena,
    return object;
 }
 
-static void gc_mark_from_root(object_t *object, object_arena_t *arena,
-                              generation_t generation)
+static void gc_mark_from_root(object_t *root, object_arena_t *arena,
+                              generation_t generation, object_array_t *stack)
 {
-   if (object == NULL)
-      return;
-   else if (!object_in_arena_p(arena, object))
-      return;
-   else if (object_marked_p(object, generation))
-      return;
+   // Use an explicit stack rather than recursion as generated netlists
+   // can have very deep trees
+   APUSH(*stack, root);
 
-   const object_class_t *class = classes[object->tag];
+   while (stack->count > 0) {
+      object_t *object = APOP(*stack);
+      if (object == NULL)
+         continue;
+      else if (!object_in_arena_p(arena, object))
+         continue;
+      else if (object_marked_p(object, generation))
+         continue;
 
-   imask_t has = class->has_map[object->kind];
-   for (int n = 0; has; has &= has - 1, n++) {
-      const uint64_t mask = has & -has;
-      item_t *item = &(object->items[n]);
-      if (ITEM_OBJECT & mask)
-         gc_mark_from_root(item->object, arena, generation);
-      else if (ITEM_OBJ_ARRAY & mask) {
-         if (item->obj_array != NULL) {
-            for (unsigned j = 0; j < item->obj_array->count; j++)
-               gc_mark_from_root(item->obj_array->items[j], arena,
-                                 generation);
+      const object_class_t *class = classes[object->tag];
+
+      imask_t has = class->has_map[object->kind];
+      for (int n = 0; has; has &= has - 1, n++) {
+         const uint64_t mask = has & -has;
+         item_t *item = &(object->items[n]);
+         if (ITEM_OBJECT & mask)
+            APUSH(*stack, item->object);
+         else if (ITEM_OBJ_ARRAY & mask) {
+            if (item->obj_array != NULL) {
+               for (unsigned j = 0; j < item->obj_array->count; j++)
+                  APUSH(*stack, obj_array_nth(item->obj_array, j));
+            }
          }
       }
    }
@@ -582,20 +694,15 @@ static void object_arena_gc(object_arena_t *arena)
    const generation_t generation = object_next_generation();
    const uint64_t start_ticks = get_timestamp_us();
 
-   // Mark
-   for (void *p = arena->base; p != arena->alloc; ) {
-      assert(p < arena->alloc);
-      object_t *object = p;
-
-      const object_class_t *class = classes[object->tag];
-
-      if (is_gc_root(class, object->kind))
-         gc_mark_from_root(object, arena, generation);
-
-      const size_t size =
-         ALIGN_UP(class->object_size[object->kind], OBJECT_ALIGN);
-      p = (char *)p + size;
+   // Mark starting from the roots recorded when they were allocated
+   // so only reachable objects are visited here
+   object_array_t stack = AINIT;
+   for (unsigned i = 0; i < arena->gc_roots.count; i++) {
+      object_t *root = arena->gc_roots.items[i];
+      if (is_gc_root(classes[root->tag], root->kind))
+         gc_mark_from_root(root, arena, generation, &stack);
    }
+   ACLEAR(stack);
 
    const size_t fwdsz = (arena->alloc - arena->base) / OBJECT_ALIGN;
    uint32_t *forward = xmalloc_array(fwdsz, sizeof(uint32_t));
@@ -674,7 +781,7 @@ void object_visit(object_t *object, object_visit_ctx_t *ctx)
          else if (ITEM_OBJ_ARRAY & mask) {
             if (item->obj_array != NULL) {
                for (unsigned j = 0; j < item->obj_array->count; j++)
-                  object_visit(item->obj_array->items[j], ctx);
+                  object_visit(obj_array_nth(item->obj_array, j), ctx);
             }
          }
       }
@@ -764,11 +871,11 @@ object_t *object_rewrite(object_t *object, object_rewrite_ctx_t *ctx)
                // The callback may add new items to the array so the
                // array pointer cannot be cached between iterations
                unsigned wptr = 0;
-               for (size_t i = 0; i < object->items[n].obj_array->count; i++) {
-                  object_t *o = object->items[n].obj_array->items[i];
+               for (size_t i = 0; i < (*a)->count; i++) {
+                  object_t *o = obj_array_nth(*a, i);
                   if ((o = object_rewrite(o, ctx))) {
                      object_write_barrier(object, o);
-                     object->items[n].obj_array->items[wptr++] = o;
+                     obj_array_set(a, wptr++, o);
                   }
                }
 
@@ -879,7 +986,7 @@ void object_write(object_t *root, fbuf_t *f, ident_wr_ctx_t ident_ctx,
                const unsigned count = item->obj_array->count;
                fbuf_put_uint(f, count);
                for (unsigned i = 0; i < count; i++)
-                  object_write_ref(item->obj_array->items[i], f);
+                  object_write_ref(obj_array_nth(item->obj_array, i), f);
             }
             else
                fbuf_put_uint(f, 0);
@@ -926,6 +1033,8 @@ object_t *object_read(fbuf_t *f, object_load_fn_t loader_fn,
 {
    object_one_time_init();
 
+   SCOPED_A(object_t *) tmp = AINIT;
+
    const uint32_t ver = read_u32(f);
    if (ver != format_digest)
       fatal("%s: serialised format digest is %x expected %x. This design "
@@ -952,6 +1061,7 @@ object_t *object_read(fbuf_t *f, object_load_fn_t loader_fn,
    object_arena_t *arena = object_arena_new(size, std);
    arena->source = OBJ_DISK;
    arena->flags  = fbuf_get_uint(f);
+   arena->pool   = pool_new();
 
    arena_key_t key = fbuf_get_uint(f);
    ident_t name = ident_read(ident_ctx);
@@ -1034,14 +1144,15 @@ object_t *object_read(fbuf_t *f, object_load_fn_t loader_fn,
          else if (ITEM_OBJ_ARRAY & mask) {
             const unsigned count = fbuf_get_uint(f);
             if (count > 0) {
-               item->obj_array = xmalloc_flex(sizeof(obj_array_t),
-                                              count, sizeof(object_t *));
-               item->obj_array->count =
-                  item->obj_array->limit = count;
-               for (unsigned i = 0; i < count; i++) {
-                  object_t *o = object_read_ref(f, key_map);
-                  item->obj_array->items[i] = o;
-               }
+               // Arenas read from disk are never modified or freed so
+               // carve the arrays out of a pool rather than calling
+               // malloc for each one
+               ATRIM(tmp, 0);
+               for (unsigned i = 0; i < count; i++)
+                  APUSH(tmp, object_read_ref(f, key_map));
+
+               item->obj_array = obj_array_new(tmp.items, count,
+                                               arena->pool);
             }
          }
          else if ((ITEM_INT64 | ITEM_INT32) & mask)
@@ -1104,7 +1215,7 @@ static bool object_copy_mark(object_t *object, object_copy_ctx_t *ctx)
       else if (ITEM_OBJ_ARRAY & mask) {
          if (item->obj_array != NULL) {
             for (unsigned i = 0; i < item->obj_array->count; i++) {
-               object_t *o = item->obj_array->items[i];
+               object_t *o = obj_array_nth(item->obj_array, i);
                marked |= object_copy_mark(o, ctx);
             }
          }
@@ -1146,20 +1257,41 @@ void object_copy_begin(object_copy_ctx_t *ctx)
       __object_arena(ctx->roots[i])->copygen = ctx->generation;
 }
 
-void object_copy_finish(object_copy_ctx_t *ctx)
+typedef struct {
+   object_copy_ctx_t  *ctx;
+   object_t          **from;
+   object_t          **to;
+   unsigned            count;
+   A(object_t *)       barriers;
+} copy_batch_t;
+
+#define COPY_BATCH_SIZE 1024
+
+static inline void object_copy_barrier(object_t *copy, object_t *o,
+                                       copy_batch_t *batch)
 {
-   for (int i = 0; i < ctx->nroots; i++)
-      (void)object_copy_mark(ctx->roots[i], ctx);
+   // The write barrier updates the arena dependency list which is not
+   // thread safe so record references to other arenas here and apply
+   // them once all the batches have finished
+   if (o == NULL || o->arena == copy->arena)
+      return;
+   else if (batch->barriers.count > 0
+            && ATOP(batch->barriers)->arena == o->arena)
+      return;
 
-   unsigned ncopied = 0;
-   const void *key;
-   void *value;
-   for (hash_iter_t it = HASH_BEGIN;
-        hash_iter(ctx->copy_map, &it, &key, &value); ) {
-      const object_t *object = key;
-      object_t *copy = value;
-      assert(copy != object);
-      ncopied++;
+   APUSH(batch->barriers, o);
+}
+
+static void object_copy_batch_cb(void *context, void *arg)
+{
+   copy_batch_t *batch = arg;
+   object_copy_ctx_t *ctx = batch->ctx;
+
+   SCOPED_A(object_t *) tmp = AINIT;
+
+   for (unsigned j = 0; j < batch->count; j++) {
+      const object_t *object = batch->from[j];
+      object_t *copy = batch->to[j];
 
       copy->loc = object->loc;
 
@@ -1175,24 +1307,21 @@ void object_copy_finish(object_copy_ctx_t *ctx)
             to->ident = from->ident;
          else if (ITEM_OBJECT & mask) {
             to->object = object_copy_map(from->object, ctx);
-            object_write_barrier(copy, to->object);
+            object_copy_barrier(copy, to->object, batch);
          }
          else if (ITEM_DOUBLE & mask)
             to->dval = from->dval;
          else if (ITEM_OBJ_ARRAY & mask) {
             if (from->obj_array != NULL) {
-               // TODO: make a resize macro
-               to->obj_array = xmalloc_flex(sizeof(obj_array_t),
-                                            from->obj_array->count,
-                                            sizeof(object_t *));
-               to->obj_array->count =
-                  to->obj_array->limit = from->obj_array->count;
+               ATRIM(tmp, 0);
                for (size_t i = 0; i < from->obj_array->count; i++) {
                   object_t *o =
-                     object_copy_map(from->obj_array->items[i], ctx);
-                  to->obj_array->items[i] = o;
-                  object_write_barrier(copy, o);
+                     object_copy_map(obj_array_nth(from->obj_array, i), ctx);
+                  APUSH(tmp, o);
+                  object_copy_barrier(copy, o, batch);
                }
+
+               to->obj_array = obj_array_new(tmp.items, tmp.count, NULL);
             }
          }
          else if ((ITEM_INT64 | ITEM_INT32) & mask)
@@ -1201,6 +1330,69 @@ void object_copy_finish(object_copy_ctx_t *ctx)
             should_not_reach_here();
       }
    }
+}
+
+void object_copy_finish(object_copy_ctx_t *ctx)
+{
+   for (int i = 0; i < ctx->nroots; i++)
+      (void)object_copy_mark(ctx->roots[i], ctx);
+
+   const unsigned ncopied = hash_members(ctx->copy_map);
+   if (ncopied == 0) {
+      hash_free(ctx->copy_map);
+      return;
+   }
+
+   object_t **from = xmalloc_array(ncopied, sizeof(object_t *));
+   object_t **to = xmalloc_array(ncopied, sizeof(object_t *));
+
+   unsigned pos = 0;
+   const void *key;
+   void *value;
+   for (hash_iter_t it = HASH_BEGIN;
+        hash_iter(ctx->copy_map, &it, &key, &value); pos++) {
+      assert(value != key);
+      from[pos] = (object_t *)key;
+      to[pos] = value;
+   }
+   assert(pos == ncopied);
+
+   // The copy map is read-only while filling in the new objects so
+   // large copies can be split into batches and run in parallel
+   const unsigned nbatches = (ncopied + COPY_BATCH_SIZE - 1) / COPY_BATCH_SIZE;
+   copy_batch_t *batches = xcalloc_array(nbatches, sizeof(copy_batch_t));
+
+   for (unsigned i = 0; i < nbatches; i++) {
+      batches[i].ctx   = ctx;
+      batches[i].from  = from + i * COPY_BATCH_SIZE;
+      batches[i].to    = to + i * COPY_BATCH_SIZE;
+      batches[i].count = MIN(COPY_BATCH_SIZE, ncopied - i * COPY_BATCH_SIZE);
+   }
+
+   if (nbatches > 1 && thread_id() == 0) {
+      workq_t *wq = workq_new(ctx);
+
+      for (unsigned i = 0; i < nbatches; i++)
+         workq_do(wq, object_copy_batch_cb, &(batches[i]));
+
+      workq_start(wq);
+      workq_drain(wq);
+      workq_free(wq);
+   }
+   else {
+      for (unsigned i = 0; i < nbatches; i++)
+         object_copy_batch_cb(ctx, &(batches[i]));
+   }
+
+   for (unsigned i = 0; i < nbatches; i++) {
+      for (unsigned j = 0; j < batches[i].barriers.count; j++)
+         __object_write_barrier(to[0], batches[i].barriers.items[j]);
+      ACLEAR(batches[i].barriers);
+   }
+
+   free(batches);
+   free(from);
+   free(to);
 
    for (hash_iter_t it = HASH_BEGIN;
         hash_iter(ctx->copy_map, &it, &key, &value); ) {
@@ -1245,6 +1437,8 @@ object_arena_t *object_arena_new(size_t size, unsigned std)
    if (all_arenas.count == UINT16_MAX - 1)
       fatal_trace("too many object arenas");
 
+   arena_base_map[arena->key] = arena->base;
+
    return arena;
 }
 
@@ -1258,6 +1452,8 @@ void object_arena_freeze(object_arena_t *arena)
    if (arena->source == OBJ_FRESH)
       object_arena_gc(arena);
 
+   ACLEAR(arena->gc_roots);
+
    if (opt_get_verbose(OPT_OBJECT_VERBOSE, NULL))
       debugf("arena %s frozen (%d bytes)", istr(name),
              (int)(arena->alloc - arena->base));
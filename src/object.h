@@ -124,16 +124,35 @@ STATIC_ASSERT(OBJECT_ALIGN >= sizeof(double));
 typedef uint16_t generation_t;
 typedef uint16_t arena_key_t;
 
+// Compressed reference to an object as an offset in units of
+// OBJECT_ALIGN from the base of its arena
+typedef uint32_t object_ref_t;
+
+extern char *arena_base_map[UINT16_MAX];
+
 typedef struct {
-   unsigned  count;
-   unsigned  limit;
-   object_t *items[0];
+   unsigned      count;
+   uint8_t       wide;        // Items are full pointers
+   uint8_t       limit_log2;  // Zero if allocated with exact size
+   arena_key_t   arena;       // Arena of all items if not wide
+   union {
+      object_ref_t  refs[0];
+      object_t     *ptrs[0];
+   };
 } obj_array_t;
 
-#define obj_array_nth(a, n) ({                  \
-         assert((a) != NULL);                   \
-         assert((n) < (a)->count);              \
-         (a)->items[(n)];                       \
+STATIC_ASSERT(sizeof(obj_array_t) == 8);
+
+#define object_from_ref(key, ref)                                       \
+   ((object_t *)(arena_base_map[(key)]                                  \
+                 + ((uintptr_t)(ref) << OBJECT_ALIGN_BITS)))
+
+#define obj_array_nth(a, n) ({                                          \
+         const obj_array_t *__a = (a);                                  \
+         assert(__a != NULL);                                           \
+         assert((n) < __a->count);                                      \
+         likely(!__a->wide) ? object_from_ref(__a->arena, __a->refs[(n)]) \
+            : __a->ptrs[(n)];                                           \
       })
 
 #define obj_array_count(a) ({                   \
@@ -142,6 +161,7 @@ typedef struct {
       })
 
 void obj_array_add(obj_array_t **a, object_t *o);
+void obj_array_set(obj_array_t **a, unsigned n, object_t *o);
 void obj_array_copy(obj_array_t **dst, const obj_array_t *src);
 
 typedef union {
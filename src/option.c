@@ -128,7 +128,7 @@ static int get_int_env(const char *var, int def)
 
 void set_default_options(void)
 {
-   opt_set_int(OPT_RT_STATS, 0);
+   opt_set_int(OPT_RT_STATS, STATS_OFF);
    opt_set_int(OPT_RT_TRACE, 0);
    opt_set_str(OPT_PLI_TRACE, getenv("NVC_VHPI_VERBOSE"));
    opt_set_int(OPT_DUMP_LLVM, 0);
@@ -156,6 +156,7 @@ void set_default_options(void)
    opt_set_int(OPT_NO_SAVE, 0);
    opt_set_str(OPT_LLVM_VERBOSE, getenv("NVC_LLVM_VERBOSE"));
    opt_set_int(OPT_JIT_THRESHOLD, get_int_env("NVC_JIT_THRESHOLD", 100));
+   opt_set_int(OPT_NATIVE_THRESHOLD, get_int_env("NVC_NATIVE_THRESHOLD", 5));
    opt_set_str(OPT_ASM_VERBOSE, getenv("NVC_ASM_VERBOSE"));
    opt_set_int(OPT_JIT_ASYNC, get_int_env("NVC_JIT_ASYNC", 1));
    opt_set_int(OPT_PERF_MAP, get_int_env("NVC_PERF_MAP", 0));
@@ -170,6 +171,12 @@ void set_default_options(void)
    opt_set_int(OPT_JIT_INTRINSICS, get_int_env("NVC_JIT_INTRINSICS", 1));
    opt_set_int(OPT_VECTOR_INTRINSICS, get_int_env("NVC_VECTOR_INTRINSICS", 1));
    opt_set_int(OPT_SHUFFLE_PROCS, 0);
+   opt_set_int(OPT_RT_THREADS, 1);
+   opt_set_str(OPT_RT_PROFILE, NULL);
+   opt_set_size(OPT_WAVE_BUFFER, 16 * 1024 * 1024);
+   opt_set_int(OPT_JOBS, 1);
+   opt_set_int(OPT_LIB_COMPRESS, get_int_env("NVC_LIB_COMPRESS", 1));
+   opt_set_int(OPT_ZSTD_LEVEL, get_int_env("NVC_ZSTD_LEVEL", 3));
    opt_set_int(OPT_PLI_DEBUG, opt_get_str(OPT_PLI_TRACE) != NULL);
    opt_set_int(OPT_SERVER_PORT, 8888);
    opt_set_int(OPT_STDERR_LEVEL, DIAG_DEBUG);
@@ -182,8 +189,20 @@ void set_default_options(void)
    opt_set_str(OPT_DCE_VERBOSE, getenv("NVC_DCE_VERBOSE"));
    opt_set_str(OPT_CFG_VERBOSE, getenv("NVC_CFG_VERBOSE"));
    opt_set_str(OPT_RA_VERBOSE, getenv("NVC_RA_VERBOSE"));
+   opt_set_str(OPT_LICM_VERBOSE, getenv("NVC_LICM_VERBOSE"));
+   opt_set_str(OPT_ESCAPE_VERBOSE, getenv("NVC_ESCAPE_VERBOSE"));
    opt_set_int(OPT_RANDOM_SEED, mix_bits_32(get_timestamp_us()));
    opt_set_int(OPT_ELAB_STATS, 0);
    opt_set_str(OPT_RELATIVE_PATH, NULL);
    opt_set_int(OPT_EXCL_VERBOSE, get_int_env("NVC_EXCL_VERBOSE", 0));
+   opt_set_str(OPT_JIT_CACHE, getenv("NVC_JIT_CACHE"));
+   opt_set_int(OPT_GC_PARALLEL, get_int_env("NVC_GC_PARALLEL", 1));
+   opt_set_int(OPT_GC_LAZY_SWEEP, get_int_env("NVC_GC_LAZY_SWEEP", 0));
+   opt_set_int(OPT_GC_GENERATIONAL, get_int_env("NVC_GC_GENERATIONAL", 0));
+   opt_set_int(OPT_AGGRESSIVE_COLLAPSE, 0);
+   opt_set_int(OPT_PRUNE_SENSITIVITY, 0);
+   opt_set_int(OPT_PROFILE_COUNTERS, 0);
+   opt_set_int(OPT_DELTA_REPORT, 0);
+   opt_set_size(OPT_HEAP_PROFILE, 0);
+   opt_set_size(OPT_ASYNC_OUTPUT, 0);
 }
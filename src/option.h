@@ -80,7 +80,26 @@ typedef enum {
    OPT_ELAB_STATS,
    OPT_RELATIVE_PATH,
    OPT_RA_VERBOSE,
+   OPT_LICM_VERBOSE,
+   OPT_ESCAPE_VERBOSE,
    OPT_EXCL_VERBOSE,
+   OPT_JIT_CACHE,
+   OPT_RT_THREADS,
+   OPT_RT_PROFILE,
+   OPT_WAVE_BUFFER,
+   OPT_JOBS,
+   OPT_LIB_COMPRESS,
+   OPT_NATIVE_THRESHOLD,
+   OPT_GC_PARALLEL,
+   OPT_GC_LAZY_SWEEP,
+   OPT_GC_GENERATIONAL,
+   OPT_AGGRESSIVE_COLLAPSE,
+   OPT_PRUNE_SENSITIVITY,
+   OPT_ZSTD_LEVEL,
+   OPT_PROFILE_COUNTERS,
+   OPT_DELTA_REPORT,
+   OPT_HEAP_PROFILE,
+   OPT_ASYNC_OUTPUT,
 
    OPT_LAST_NAME
 } opt_name_t;
@@ -91,6 +110,12 @@ typedef enum {
    IEEE_WARNINGS_OFF_AT_0
 } ieee_warnings_t;
 
+typedef enum {
+   STATS_OFF,
+   STATS_TEXT,
+   STATS_JSON
+} stats_format_t;
+
 void opt_set_int(opt_name_t name, int val);
 void opt_set_size(opt_name_t name, size_t val);
 void opt_set_str(opt_name_t name, const char *val);
@@ -45,6 +45,10 @@ tree_t elab(object_t *top, jit_t *jit, unit_registry_t *ur, mir_context_t *mc,
 // Set the value of a top-level generic
 void elab_set_generic(const char *name, const char *value);
 
+// Check whether a saved elaborated design is up to date
+bool elab_is_current(lib_t work, ident_t top, uint64_t key);
+void elab_write_stamp(lib_t work, ident_t top, uint64_t key);
+
 // Reinitialise elaborated design
 void reheat(tree_t top, unit_registry_t *ur, mir_context_t *mc,
             cover_data_t *cover, rt_model_t *m);
@@ -58,6 +62,10 @@ void vhdl_dump(tree_t t, int indent);
 // Generate a makefile for the givein unit
 void make(tree_t *targets, int count, FILE *out);
 
+// Reanalyse out of date source files by running "PREFIX -a FILE"
+int make_build(tree_t *targets, int count, const char *const *prefix,
+               int nprefix);
+
 // Read the next unit from the input file
 tree_t parse(void);
 
@@ -853,6 +853,226 @@ static void psl_prune(psl_fsm_t *fsm)
       it->id = fsm->next_id++;
 }
 
+#define DFA_MAX_STATES 64
+#define DFA_MAX_ATOMS  8    // Transition table has 1 << DFA_MAX_ATOMS entries
+
+static int dfa_find_atom(psl_dfa_t *dfa, psl_node_t p)
+{
+   for (int i = 0; i < dfa->natoms; i++) {
+      if (dfa->atoms[i] == p)
+         return i;
+   }
+
+   return -1;
+}
+
+static bool dfa_collect_atoms(psl_dfa_t *dfa, psl_guard_t g, uint64_t *mask)
+{
+   if (g == NULL)
+      return true;
+
+   switch (psl_guard_kind(g)) {
+   case GUARD_EXPR:
+   case GUARD_NOT:
+      {
+         psl_node_t p = psl_guard_expr(g);
+         int n = dfa_find_atom(dfa, p);
+         if (n < 0) {
+            if (dfa->natoms == 64)
+               return false;
+
+            n = dfa->natoms++;
+            dfa->atoms[n] = p;
+         }
+
+         *mask |= UINT64_C(1) << n;
+         return true;
+      }
+   case GUARD_BINOP:
+      {
+         const guard_binop_t *bop = psl_guard_binop(g);
+         return dfa_collect_atoms(dfa, bop->left, mask)
+            && dfa_collect_atoms(dfa, bop->right, mask);
+      }
+   default:
+      return true;
+   }
+}
+
+static bool dfa_eval_guard(psl_dfa_t *dfa, psl_guard_t g, uint64_t values)
+{
+   if (g == NULL)
+      return true;
+
+   switch (psl_guard_kind(g)) {
+   case GUARD_EXPR:
+   case GUARD_NOT:
+      {
+         const int n = dfa_find_atom(dfa, psl_guard_expr(g));
+         assert(n >= 0);
+
+         const bool value = !!(values & (UINT64_C(1) << n));
+         return psl_guard_kind(g) == GUARD_NOT ? !value : value;
+      }
+   case GUARD_BINOP:
+      {
+         const guard_binop_t *bop = psl_guard_binop(g);
+         const bool left = dfa_eval_guard(dfa, bop->left, values);
+         const bool right = dfa_eval_guard(dfa, bop->right, values);
+
+         if (bop->kind == BINOP_AND)
+            return left && right;
+         else
+            return left || right;
+      }
+   default:
+      return false;
+   }
+}
+
+static int dfa_get_state(psl_fsm_t *fsm, psl_dfa_t *dfa, uint64_t members)
+{
+   for (int i = 0; i < dfa->nstates; i++) {
+      if (dfa->states[i].members == members)
+         return i;
+   }
+
+   if (dfa->nstates == DFA_MAX_STATES)
+      return -1;
+
+   dfa_state_t *ds = &(dfa->states[dfa->nstates]);
+   ds->id      = dfa->nstates++;
+   ds->members = members;
+
+   for (int i = 0; i < fsm->next_id; i++) {
+      if (members & (UINT64_C(1) << i))
+         ds->strong |= dfa->nfa[i]->strong;
+   }
+
+   return ds->id;
+}
+
+static bool dfa_build_state(psl_fsm_t *fsm, psl_dfa_t *dfa, dfa_state_t *ds,
+                            const uint64_t *nfa_atoms)
+{
+   for (int i = 0; i < fsm->next_id; i++) {
+      if (ds->members & (UINT64_C(1) << i))
+         ds->atoms |= nfa_atoms[i];
+   }
+
+   const int natoms = __builtin_popcountll(ds->atoms);
+   if (natoms > DFA_MAX_ATOMS)
+      return false;
+
+   const int size = 1 << natoms;
+   ds->table = pool_malloc_array(fsm->pool, size, sizeof(unsigned));
+   ds->outcomes = pool_malloc_array(fsm->pool, size, sizeof(dfa_outcome_t));
+
+   const bool repeating = psl_fsm_repeating(fsm);
+
+   for (int index = 0; index < size; index++) {
+      // Expand the packed index into a value for each atom
+      uint64_t values = 0;
+      for (int i = 0, bit = 0; i < dfa->natoms; i++) {
+         if (ds->atoms & (UINT64_C(1) << i)) {
+            if (index & (1 << bit++))
+               values |= UINT64_C(1) << i;
+         }
+      }
+
+      uint64_t next = 0, fail = 0;
+      for (int i = 0; i < fsm->next_id; i++) {
+         if (!(ds->members & (UINT64_C(1) << i)))
+            continue;
+
+         fsm_state_t *s = dfa->nfa[i];
+
+         if (s->initial && repeating)
+            next |= UINT64_C(1) << s->id;
+
+         if (s->accept && dfa_eval_guard(dfa, s->guard, values))
+            continue;
+
+         bool taken = false;
+         for (fsm_edge_t *e = s->edges; e; e = e->next) {
+            if (dfa_eval_guard(dfa, e->guard, values)) {
+               next |= UINT64_C(1) << e->dest->id;
+               taken = true;
+            }
+         }
+
+         if (!taken)
+            fail |= UINT64_C(1) << s->id;
+      }
+
+      int dest = -1;
+      if (next != 0 && (dest = dfa_get_state(fsm, dfa, next)) == -1)
+         return false;
+
+      int outcome = 0;
+      for (; outcome < ds->noutcomes; outcome++) {
+         const dfa_outcome_t *o = &(ds->outcomes[outcome]);
+         if (o->dest == dest && o->fail == fail)
+            break;
+      }
+
+      if (outcome == ds->noutcomes) {
+         ds->outcomes[outcome].dest = dest;
+         ds->outcomes[outcome].fail = fail;
+         ds->noutcomes++;
+      }
+
+      ds->table[index] = outcome;
+   }
+
+   return true;
+}
+
+static void psl_determinise(psl_fsm_t *fsm)
+{
+   // Cover and never directives act on each accepting thread separately
+   if (fsm->kind != FSM_BARE && fsm->kind != FSM_ALWAYS)
+      return;
+   else if (fsm->next_id > 64)
+      return;
+
+   psl_dfa_t *dfa = pool_calloc(fsm->pool, sizeof(psl_dfa_t));
+   dfa->atoms  = pool_malloc_array(fsm->pool, 64, sizeof(psl_node_t));
+   dfa->states = pool_calloc(fsm->pool, DFA_MAX_STATES * sizeof(dfa_state_t));
+   dfa->nfa    = pool_malloc_array(fsm->pool, fsm->next_id,
+                                   sizeof(fsm_state_t *));
+
+   uint64_t *nfa_atoms LOCAL = xcalloc_array(fsm->next_id, sizeof(uint64_t));
+
+   for (fsm_state_t *s = fsm->states; s; s = s->next) {
+      dfa->nfa[s->id] = s;
+
+      if (s->accept && !dfa_collect_atoms(dfa, s->guard, &(nfa_atoms[s->id])))
+         return;
+
+      for (fsm_edge_t *e = s->edges; e; e = e->next) {
+         if (!dfa_collect_atoms(dfa, e->guard, &(nfa_atoms[s->id])))
+            return;
+      }
+   }
+
+   assert(fsm->states->initial && fsm->states->id == 0);
+   dfa_get_state(fsm, dfa, 1);
+
+   bool nondet = false;
+   for (int i = 0; i < dfa->nstates; i++) {
+      dfa_state_t *ds = &(dfa->states[i]);
+      if (!dfa_build_state(fsm, dfa, ds, nfa_atoms))
+         return;   // Fall back to simulating the NFA
+
+      nondet |= __builtin_popcountll(ds->members) > 1;
+   }
+
+   // Only worthwhile if more than one NFA state can be active at once
+   if (nondet)
+      fsm->dfa = dfa;
+}
+
 psl_fsm_t *psl_fsm_new(psl_node_t p, ident_t label)
 {
    psl_fsm_t *fsm = xcalloc(sizeof(psl_fsm_t));
@@ -876,10 +1096,16 @@ psl_fsm_t *psl_fsm_new(psl_node_t p, ident_t label)
 
    psl_simplify(fsm);
    psl_prune(fsm);
+   psl_determinise(fsm);
 
-   if (verbose)
+   if (verbose) {
       psl_fsm_dump(fsm, "final");
 
+      if (fsm->dfa != NULL)
+         debugf("determinised %u NFA states into %u DFA states",
+                fsm->next_id, fsm->dfa->nstates);
+   }
+
    return fsm;
 }
 
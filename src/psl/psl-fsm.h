@@ -72,6 +72,29 @@ typedef enum {
    FSM_BARE, FSM_ALWAYS, FSM_NEVER, FSM_COVER
 } fsm_kind_t;
 
+typedef struct {
+   uint64_t  fail;    // NFA states whose assertion fails
+   int       dest;    // Next DFA state or -1 if none
+} dfa_outcome_t;
+
+typedef struct {
+   unsigned       id;
+   uint64_t       members;
+   uint64_t       atoms;
+   bool           strong;
+   unsigned       noutcomes;
+   dfa_outcome_t *outcomes;
+   unsigned      *table;
+} dfa_state_t;
+
+typedef struct {
+   unsigned      natoms;
+   psl_node_t   *atoms;
+   unsigned      nstates;
+   dfa_state_t  *states;
+   fsm_state_t **nfa;
+} psl_dfa_t;
+
 typedef struct {
    fsm_state_t  *states;
    fsm_state_t **tail;
@@ -80,6 +103,7 @@ typedef struct {
    psl_node_t    src;
    unsigned      next_id;
    fsm_kind_t    kind;
+   psl_dfa_t    *dfa;
 } psl_fsm_t;
 
 psl_fsm_t *psl_fsm_new(psl_node_t p, ident_t label);
@@ -163,8 +163,20 @@ static void psl_lower_assert(lower_unit_t *lu, vcode_reg_t taken_reg,
    vcode_reg_t msg_reg = VCODE_INVALID_REG;
    vcode_reg_t len_reg = VCODE_INVALID_REG;
 
+   vcode_block_t exit_bb = VCODE_INVALID_BLOCK;
+
    if (psl_has_message(p)) {
       tree_t t_msg = psl_message(p);
+
+      // Only build the message when the assertion fails
+      int64_t cval;
+      if (tree_kind(t_msg) != T_STRING && !vcode_reg_const(taken_reg, &cval)) {
+         vcode_block_t fail_bb = emit_block();
+         exit_bb = emit_block();
+         emit_cond(taken_reg, exit_bb, fail_bb);
+         vcode_select_block(fail_bb);
+      }
+
       vcode_reg_t message_wrapped = lower_rvalue(lu, t_msg);
       if (vcode_reg_kind(message_wrapped) == VCODE_TYPE_UARRAY) {
          msg_reg = emit_unwrap(message_wrapped);
@@ -179,6 +191,11 @@ static void psl_lower_assert(lower_unit_t *lu, vcode_reg_t taken_reg,
    emit_assert(taken_reg, msg_reg, len_reg,
                severity_reg, locus, VCODE_INVALID_REG,
                VCODE_INVALID_REG);
+
+   if (exit_bb != VCODE_INVALID_BLOCK) {
+      emit_jump(exit_bb);
+      vcode_select_block(exit_bb);
+   }
 }
 
 static void psl_enter_state(fsm_state_t *state)
@@ -264,6 +281,83 @@ static void psl_lower_state(lower_unit_t *lu, psl_fsm_t *fsm,
    emit_return(VCODE_INVALID_REG);
 }
 
+static void psl_lower_dfa_state(lower_unit_t *lu, psl_fsm_t *fsm,
+                                const dfa_state_t *ds)
+{
+   emit_comment("Deterministic property state %d", ds->id);
+
+   const psl_dfa_t *dfa = fsm->dfa;
+
+   vcode_type_t vint32 = vtype_int(INT32_MIN, INT32_MAX);
+   vcode_reg_t outcome_reg = emit_const(vint32, 0);
+
+   if (ds->noutcomes > 1) {
+      // Pack the value of each atom into an index for the transition table
+      vcode_type_t voffset = vtype_offset();
+      vcode_reg_t zero_reg = emit_const(voffset, 0);
+      vcode_reg_t index_reg = zero_reg;
+
+      for (int i = 0, bit = 0; i < dfa->natoms; i++) {
+         if (!(ds->atoms & (UINT64_C(1) << i)))
+            continue;
+
+         vcode_reg_t atom_reg = psl_lower_boolean(lu, dfa->atoms[i]);
+         vcode_reg_t weight_reg = emit_const(voffset, 1 << bit++);
+         vcode_reg_t bit_reg = emit_select(atom_reg, weight_reg, zero_reg);
+         index_reg = emit_add(index_reg, bit_reg);
+      }
+
+      const int size = 1 << __builtin_popcountll(ds->atoms);
+      vcode_reg_t *values LOCAL = xmalloc_array(size, sizeof(vcode_reg_t));
+      for (int i = 0; i < size; i++)
+         values[i] = emit_const(vint32, ds->table[i]);
+
+      vcode_type_t vtable = vtype_carray(size, vint32);
+      vcode_reg_t table_reg = emit_const_array(vtable, values, size);
+      vcode_reg_t ptr_reg = emit_array_ref(emit_address_of(table_reg),
+                                           index_reg);
+      outcome_reg = emit_load_indirect(ptr_reg);
+   }
+
+   vcode_block_t *outcome_bb LOCAL =
+      xmalloc_array(ds->noutcomes, sizeof(vcode_block_t));
+   vcode_reg_t *outcome_ids LOCAL =
+      xmalloc_array(ds->noutcomes, sizeof(vcode_reg_t));
+
+   for (int i = 0; i < ds->noutcomes; i++) {
+      outcome_bb[i] = emit_block();
+      outcome_ids[i] = emit_const(vint32, i);
+   }
+
+   emit_case(outcome_reg, outcome_bb[0], outcome_ids, outcome_bb,
+             ds->noutcomes);
+
+   vcode_reg_t vfalse = emit_const(vtype_bool(), 0);
+
+   for (int i = 0; i < ds->noutcomes; i++) {
+      vcode_select_block(outcome_bb[i]);
+
+      const dfa_outcome_t *o = &(ds->outcomes[i]);
+
+      for (int j = 0; j < fsm->next_id; j++) {
+         if (o->fail & (UINT64_C(1) << j)) {
+            vcode_reg_t locus = psl_debug_locus(dfa->nfa[j]->where);
+            psl_lower_assert(lu, vfalse, locus, fsm->src);
+         }
+      }
+
+      if (o->dest != -1) {
+         vcode_reg_t strong_reg = VCODE_INVALID_REG;
+         if (dfa->states[o->dest].strong)
+            strong_reg = emit_const(vtype_bool(), 1);
+
+         emit_enter_state(emit_const(vint32, o->dest), strong_reg);
+      }
+
+      emit_return(VCODE_INVALID_REG);
+   }
+}
+
 static psl_node_t psl_outer_async_abort(psl_node_t p)
 {
    switch (psl_kind(p)) {
@@ -587,26 +681,35 @@ void psl_lower_directive(lower_unit_t *lu, object_t *obj)
 
    vcode_select_block(case_bb);
 
+   const int nstates = fsm->dfa ? fsm->dfa->nstates : fsm->next_id;
+
    vcode_block_t *state_bb LOCAL =
-      xmalloc_array(fsm->next_id + 1, sizeof(vcode_block_t));
+      xmalloc_array(nstates + 1, sizeof(vcode_block_t));
    vcode_reg_t *state_ids LOCAL =
-      xmalloc_array(fsm->next_id + 1, sizeof(vcode_reg_t));
+      xmalloc_array(nstates + 1, sizeof(vcode_reg_t));
 
-   for (int i = 0; i < fsm->next_id; i++) {
+   for (int i = 0; i < nstates; i++) {
       state_bb[i] = emit_block();
       state_ids[i] = emit_const(vint32, i);
    }
 
-   state_bb[fsm->next_id] = prev_bb;
-   state_ids[fsm->next_id] = emit_const(vint32, fsm->next_id);
+   state_bb[nstates] = prev_bb;
+   state_ids[nstates] = emit_const(vint32, nstates);
 
    bool strong = false;
    for (fsm_state_t *s = fsm->states; s; s = s->next) {
-      vcode_select_block(state_bb[s->id]);
-      psl_lower_state(lu, fsm, s, state_bb);
+      if (fsm->dfa == NULL) {
+         vcode_select_block(state_bb[s->id]);
+         psl_lower_state(lu, fsm, s, state_bb);
+      }
       strong |= s->strong;
    }
 
+   for (int i = 0; fsm->dfa != NULL && i < nstates; i++) {
+      vcode_select_block(state_bb[i]);
+      psl_lower_dfa_state(lu, fsm, &(fsm->dfa->states[i]));
+   }
+
    vcode_select_block(abort_bb);
 
    if (strong) {
@@ -624,14 +727,14 @@ void psl_lower_directive(lower_unit_t *lu, object_t *obj)
 
    const bool has_prev = vcode_count_ops() > 0;
 
-   emit_return(emit_const(vint32, fsm->next_id + 1));
+   emit_return(emit_const(vint32, nstates + 1));
 
    vcode_select_block(case_bb);
 
    if (has_prev)
-      emit_enter_state(emit_const(vint32, fsm->next_id), VCODE_INVALID_REG);
+      emit_enter_state(emit_const(vint32, nstates), VCODE_INVALID_REG);
 
-   emit_case(state_reg, abort_bb, state_ids, state_bb, fsm->next_id + 1);
+   emit_case(state_reg, abort_bb, state_ids, state_bb, nstates + 1);
 
    psl_fsm_free(fsm);
 }
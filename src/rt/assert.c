@@ -16,7 +16,9 @@
 //
 
 #include "util.h"
+#include "array.h"
 #include "diag.h"
+#include "hash.h"
 #include "jit/jit-exits.h"
 #include "jit/jit.h"
 #include "object.h"
@@ -26,6 +28,8 @@
 #include "rt/model.h"
 #include "rt/rt.h"
 #include "rt/structs.h"
+#include "stats.h"
+#include "thread.h"
 #include "tree.h"
 
 #include <string.h>
@@ -59,6 +63,13 @@ typedef struct _format_part {
    };
 } format_part_t;
 
+typedef struct {
+   object_t *where;
+   int64_t   count;
+} assert_site_t;
+
+typedef A(assert_site_t *) site_list_t;
+
 static const struct {
    const char *name;
    uint64_t    value;
@@ -79,6 +90,8 @@ static vhdl_severity_t  exit_severity = SEVERITY_FAILURE;
 static vhdl_severity_t  status_severity = SEVERITY_ERROR;
 static unsigned         counts[SEVERITY_FAILURE + 1];
 static unsigned         enable_mask = ~0u;
+static chash_t         *sites = NULL;
+static site_list_t      collected = AINIT;
 
 static void free_format(format_part_t *f)
 {
@@ -421,6 +434,50 @@ void x_report(const uint8_t *msg, int32_t msg_len, int8_t severity,
    emit_vhdl_diag(d, severity);
 }
 
+static void count_assert_site(object_t *where)
+{
+   chash_t *h = load_acquire(&sites);
+   if (h == NULL) {
+      chash_t *new = chash_new(64);
+      if (atomic_cas(&sites, NULL, new))
+         h = new;
+      else {
+         chash_free(new);
+         h = load_acquire(&sites);
+      }
+   }
+
+   assert_site_t *site = chash_get(h, where);
+   if (site == NULL) {
+      assert_site_t *new = xcalloc(sizeof(assert_site_t));
+      new->where = where;
+
+      if ((site = chash_cas(h, where, NULL, new)) == NULL)
+         site = new;
+      else
+         free(new);
+   }
+
+   relaxed_add(&site->count, 1);
+   stat_add(STAT_ASSERT_FAILURES, 1);
+}
+
+static void collect_site_cb(const void *key, void *value)
+{
+   APUSH(collected, (assert_site_t *)value);
+}
+
+static int site_count_cmp(const void *a, const void *b)
+{
+   const assert_site_t *sa = *(assert_site_t **)a;
+   const assert_site_t *sb = *(assert_site_t **)b;
+
+   if (sa->count != sb->count)
+      return sa->count < sb->count ? 1 : -1;
+   else
+      return 0;
+}
+
 void x_assert_fail(const uint8_t *msg, int32_t msg_len, int8_t severity,
                    int64_t hint_left, int64_t hint_right, int8_t hint_valid,
                    object_t *where)
@@ -434,6 +491,8 @@ void x_assert_fail(const uint8_t *msg, int32_t msg_len, int8_t severity,
 
    assert(severity <= SEVERITY_FAILURE);
 
+   count_assert_site(where);
+
    if (!(enable_mask & (1 << severity)))
       return;
 
@@ -534,3 +593,23 @@ int get_vhdl_assert_exit_status(void)
 
    return 0;
 }
+
+void report_vhdl_assert_sites(int limit)
+{
+   chash_t *h = load_acquire(&sites);
+   if (h == NULL)
+      return;
+
+   chash_iter(h, collect_site_cb);
+
+   qsort(collected.items, collected.count, sizeof(assert_site_t *),
+         site_count_cmp);
+
+   for (int i = 0; i < collected.count && i < limit; i++) {
+      const loc_t *loc = &(collected.items[i]->where->loc);
+      notef("assertion at %s:%d failed %"PRIi64" times", loc_file_str(loc),
+            loc->first_line, collected.items[i]->count);
+   }
+
+   ACLEAR(collected);
+}
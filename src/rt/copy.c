@@ -18,18 +18,50 @@
 #include "util.h"
 #include "copy.h"
 
+#include <assert.h>
 #include <string.h>
 
 #ifdef ARCH_X86_64
 #include <x86intrin.h>
 #endif
 
+#ifdef ARCH_ARM64
+#define HAVE_NEON
+#include <arm_neon.h>
+#endif
+
 #if defined __GNUC__ && !defined __clang__
 #pragma GCC optimize ("O2")
 #endif
 
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static size_t copy2_avx2(void *p1, void *p2, const void *src, size_t len)
+{
+   size_t pos = 0;
+   for (; pos + 31 < len; pos += 32) {
+      __m256i v2   = _mm256_loadu_si256((const __m256i *)(p2 + pos));
+      __m256i vsrc = _mm256_loadu_si256((const __m256i *)(src + pos));
+      _mm256_storeu_si256((__m256i *)(p1 + pos), v2);
+      _mm256_storeu_si256((__m256i *)(p2 + pos), vsrc);
+   }
+
+   return pos;
+}
+#endif
+
 void _copy2(void *p1, void *p2, const void *src, size_t len)
 {
+#ifdef HAVE_AVX2
+   if (len > 31 && __builtin_cpu_supports("avx2")) {
+      const size_t done = copy2_avx2(p1, p2, src, len);
+      p1 += done;
+      p2 += done;
+      src += done;
+      len -= done;
+   }
+#endif
+
 #ifdef ARCH_X86_64
    for (; len > 15; len -= 16, p1 += 16, p2 += 16, src += 16) {
       __m128i v2   = _mm_loadu_si128((const __m128i *)p2);
@@ -91,11 +123,33 @@ static inline bool cmp_bytes_sse41(const void *a, const void *b, size_t size)
 }
 #endif
 
+#if defined HAVE_AVX2 && defined HAVE_SSE41
+__attribute__((target("avx2")))
+static bool cmp_bytes_avx2(const void *a, const void *b, size_t size)
+{
+   size_t pos = 0;
+   for (; pos + 31 < size; pos += 32) {
+      __m256i left  = _mm256_loadu_si256((const __m256i *)(a + pos));
+      __m256i right = _mm256_loadu_si256((const __m256i *)(b + pos));
+      __m256i xor   = _mm256_xor_si256(left, right);
+      if (!_mm256_testz_si256(xor, xor))
+         return false;
+   }
+
+   return cmp_bytes_sse41(a + pos, b + pos, size - pos);
+}
+#endif
+
 #ifdef HAVE_SSE41
 __attribute__((target("sse4.1")))
 #endif
 bool _cmp_bytes(const void *a, const void *b, size_t size)
 {
+#if defined HAVE_AVX2 && defined HAVE_SSE41 && !ASAN_ENABLED
+   if (size > 31 && __builtin_cpu_supports("avx2"))
+      return cmp_bytes_avx2(a, b, size);
+#endif
+
 #if defined HAVE_SSE41 && !ASAN_ENABLED
    if (likely(__builtin_cpu_supports("sse4.1")))
       return cmp_bytes_sse41(a, b, size);
@@ -103,3 +157,110 @@ bool _cmp_bytes(const void *a, const void *b, size_t size)
 
    return memcmp(a, b, size) == 0;
 }
+
+#ifdef HAVE_SSE41
+__attribute__((target("sse4.1")))
+static void lookup1_sse41(const int8_t tab[16], const uint8_t *a,
+                          uint8_t *out, size_t size)
+{
+   __m128i lookup = _mm_loadu_si128((const __m128i *)tab);
+
+   for (; size > 15; size -= 16, a += 16, out += 16) {
+      __m128i in = _mm_loadu_si128((const __m128i *)a);
+      _mm_storeu_si128((__m128i *)out, _mm_shuffle_epi8(lookup, in));
+   }
+
+   for (; size > 0; size--, a++, out++)
+      *out = tab[*a];
+}
+
+__attribute__((target("sse4.1")))
+static void lookup2_sse41(const int8_t tab[16][16], int nrows,
+                          const uint8_t *a, const uint8_t *b,
+                          uint8_t *out, size_t size)
+{
+   for (; size > 15; size -= 16, a += 16, b += 16, out += 16) {
+      // Select row A[i] of the table for each lane by looking up B[i] in
+      // every row and masking out the lanes where the row does not match
+      __m128i left  = _mm_loadu_si128((const __m128i *)a);
+      __m128i right = _mm_loadu_si128((const __m128i *)b);
+      __m128i acc   = _mm_setzero_si128();
+      for (int i = 0; i < nrows; i++) {
+         __m128i row  = _mm_loadu_si128((const __m128i *)tab[i]);
+         __m128i mask = _mm_cmpeq_epi8(left, _mm_set1_epi8(i));
+         __m128i val  = _mm_shuffle_epi8(row, right);
+         acc = _mm_or_si128(acc, _mm_and_si128(mask, val));
+      }
+      _mm_storeu_si128((__m128i *)out, acc);
+   }
+
+   for (; size > 0; size--, a++, b++, out++)
+      *out = tab[*a][*b];
+}
+#endif
+
+#ifdef HAVE_NEON
+static void lookup1_neon(const int8_t tab[16], const uint8_t *a,
+                         uint8_t *out, size_t size)
+{
+   uint8x16_t lookup = vld1q_u8((const uint8_t *)tab);
+
+   for (; size > 15; size -= 16, a += 16, out += 16)
+      vst1q_u8(out, vqtbl1q_u8(lookup, vld1q_u8(a)));
+
+   for (; size > 0; size--, a++, out++)
+      *out = tab[*a];
+}
+
+static void lookup2_neon(const int8_t tab[16][16], int nrows,
+                         const uint8_t *a, const uint8_t *b,
+                         uint8_t *out, size_t size)
+{
+   for (; size > 15; size -= 16, a += 16, b += 16, out += 16) {
+      uint8x16_t left  = vld1q_u8(a);
+      uint8x16_t right = vld1q_u8(b);
+      uint8x16_t acc   = vdupq_n_u8(0);
+      for (int i = 0; i < nrows; i++) {
+         uint8x16_t row  = vld1q_u8((const uint8_t *)tab[i]);
+         uint8x16_t mask = vceqq_u8(left, vdupq_n_u8(i));
+         acc = vorrq_u8(acc, vandq_u8(mask, vqtbl1q_u8(row, right)));
+      }
+      vst1q_u8(out, acc);
+   }
+
+   for (; size > 0; size--, a++, b++, out++)
+      *out = tab[*a][*b];
+}
+#endif
+
+void table_lookup1(const int8_t tab[16], const uint8_t *a, uint8_t *out,
+                   size_t size)
+{
+#ifdef HAVE_SSE41
+   if (size > 15 && __builtin_cpu_supports("sse4.1"))
+      return lookup1_sse41(tab, a, out, size);
+#elif defined HAVE_NEON
+   if (size > 15)
+      return lookup1_neon(tab, a, out, size);
+#endif
+
+   for (size_t i = 0; i < size; i++)
+      out[i] = tab[a[i]];
+}
+
+void table_lookup2(const int8_t tab[16][16], int nrows, const uint8_t *a,
+                   const uint8_t *b, uint8_t *out, size_t size)
+{
+   assert(nrows <= 16);
+
+#ifdef HAVE_SSE41
+   if (size > 15 && __builtin_cpu_supports("sse4.1"))
+      return lookup2_sse41(tab, nrows, a, b, out, size);
+#elif defined HAVE_NEON
+   if (size > 15)
+      return lookup2_neon(tab, nrows, a, b, out, size);
+#endif
+
+   for (size_t i = 0; i < size; i++)
+      out[i] = tab[a[i]][b[i]];
+}
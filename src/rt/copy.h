@@ -45,4 +45,11 @@ static inline bool cmp_bytes(const void *a, const void *b, size_t size)
       return _cmp_bytes(a, b, size);
 }
 
+// Element-wise lookup in a memoised resolution table: out[i] is
+// tab[a[i]] or tab[a[i]][b[i]].  The output may alias either input.
+void table_lookup1(const int8_t tab[16], const uint8_t *a, uint8_t *out,
+                   size_t size);
+void table_lookup2(const int8_t tab[16][16], int nrows, const uint8_t *a,
+                   const uint8_t *b, uint8_t *out, size_t size);
+
 #endif   // _RT_COPY_H
@@ -16,6 +16,7 @@
 //
 
 #include "util.h"
+#include "array.h"
 #include "cov/cov-api.h"
 #include "cov/cov-data.h"
 #include "ident.h"
@@ -29,12 +30,31 @@
 #include <string.h>
 #include <limits.h>
 
+typedef void (*toggle_check_fn_t)(uint8_t, uint8_t, int32_t *, int32_t *);
+
 typedef struct {
-   int32_t   *counters;
-   int32_t    offset;
-   uint32_t   count;
+   int32_t           *counters;
+   int32_t            offset;
+   uint32_t           count;
+   rt_signal_t       *signal;
+   toggle_check_fn_t  check;
+   uint8_t           *snapshot;
+   bool               pending;
+   sig_event_fn_t     fn;
+   rt_watch_t        *watch;
 } rt_toggle_data_t;
 
+typedef A(rt_toggle_data_t *) toggle_list_t;
+
+typedef struct {
+   rt_model_t    *model;
+   uint64_t       window;
+   uint64_t       period;
+   toggle_list_t  toggles;
+} rt_sampler_t;
+
+static rt_sampler_t *sampler = NULL;
+
 enum std_ulogic {
    _U  = 0x0,
    _X  = 0x1,
@@ -51,8 +71,6 @@ enum std_ulogic {
 // Toggle coverage
 ///////////////////////////////////////////////////////////////////////////////
 
-typedef void (*toggle_check_fn_t)(uint8_t, uint8_t, int32_t *, int32_t *);
-
 __attribute__((always_inline))
 static inline void increment_counter(int32_t *ptr)
 {
@@ -132,14 +150,10 @@ static inline void cover_toggle_check_0_1_u_z(uint8_t old, uint8_t new,
 }
 
 __attribute__((always_inline))
-static inline void cover_toggle_generic(rt_signal_t *s, rt_toggle_data_t *td,
+static inline void cover_toggle_generic(const void *cur, const void *last,
+                                        rt_toggle_data_t *td,
                                         toggle_check_fn_t fn)
 {
-   assert(s->nexus.size == 1);
-
-   const void *cur = signal_value(s) + td->offset;
-   const void *last = signal_last_value(s) + td->offset;
-
    // Callback is optimized for performance
    // Check only group of 8 bytes that do have change of signal value
    // Optimize for assumption that most bits don't change in large signals
@@ -173,25 +187,123 @@ static inline void cover_toggle_generic(rt_signal_t *s, rt_toggle_data_t *td,
 static void cover_toggle_cb_0_1(uint64_t now, rt_signal_t *s, rt_watch_t *w,
                                 void *user)
 {
-   cover_toggle_generic(s, user, cover_toggle_check_0_1);
+   rt_toggle_data_t *td = user;
+   const void *cur = signal_value(s) + td->offset;
+   const void *last = signal_last_value(s) + td->offset;
+
+   cover_toggle_generic(cur, last, td, cover_toggle_check_0_1);
 }
 
 static void cover_toggle_cb_0_1_u(uint64_t now, rt_signal_t *s, rt_watch_t *w,
                                   void *user)
 {
-   cover_toggle_generic(s, user, cover_toggle_check_0_1_u);
+   rt_toggle_data_t *td = user;
+   const void *cur = signal_value(s) + td->offset;
+   const void *last = signal_last_value(s) + td->offset;
+
+   cover_toggle_generic(cur, last, td, cover_toggle_check_0_1_u);
 }
 
 static void cover_toggle_cb_0_1_z(uint64_t now, rt_signal_t *s, rt_watch_t *w,
                                   void *user)
 {
-   cover_toggle_generic(s, user, cover_toggle_check_0_1_z);
+   rt_toggle_data_t *td = user;
+   const void *cur = signal_value(s) + td->offset;
+   const void *last = signal_last_value(s) + td->offset;
+
+   cover_toggle_generic(cur, last, td, cover_toggle_check_0_1_z);
 }
 
 static void cover_toggle_cb_0_1_u_z(uint64_t now, rt_signal_t *s, rt_watch_t *w,
                                     void *user)
 {
-   cover_toggle_generic(s, user, cover_toggle_check_0_1_u_z);
+   rt_toggle_data_t *td = user;
+   const void *cur = signal_value(s) + td->offset;
+   const void *last = signal_last_value(s) + td->offset;
+
+   cover_toggle_generic(cur, last, td, cover_toggle_check_0_1_u_z);
+}
+
+static void cover_toggle_step_cb(rt_model_t *m, void *user)
+{
+   rt_toggle_data_t *td = user;
+   const void *cur = signal_value(td->signal) + td->offset;
+
+   // Compare against the value at the end of the previous time step so
+   // glitches in intermediate delta cycles are not counted
+   cover_toggle_generic(cur, td->snapshot, td, td->check);
+   memcpy(td->snapshot, cur, td->count);
+
+   td->pending = false;
+}
+
+static void cover_toggle_event_cb(uint64_t now, rt_signal_t *s, rt_watch_t *w,
+                                  void *user)
+{
+   rt_toggle_data_t *td = user;
+
+   if (!td->pending) {
+      model_set_phase_cb(get_model(), END_TIME_STEP, cover_toggle_step_cb, td);
+      td->pending = true;
+   }
+}
+
+static void cover_toggle_arm(rt_model_t *m, rt_toggle_data_t *td)
+{
+   assert(td->watch == NULL);
+
+   if (td->snapshot != NULL) {
+      // Do not count changes made while the watch was disarmed
+      const void *cur = signal_value(td->signal) + td->offset;
+      memcpy(td->snapshot, cur, td->count);
+   }
+
+   td->watch = watch_new(m, td->fn, td, WATCH_EVENT, 1);
+   model_set_event_cb(m, td->signal, td->offset, td->count, td->watch);
+}
+
+static void cover_sample_start_cb(rt_model_t *m, void *user);
+
+static void cover_sample_end_cb(rt_model_t *m, void *user)
+{
+   rt_sampler_t *rs = user;
+
+   for (int i = 0; i < rs->toggles.count; i++) {
+      rt_toggle_data_t *td = rs->toggles.items[i];
+      watch_free(m, td->watch);
+      td->watch = NULL;
+   }
+
+   const uint64_t now = model_now(m, NULL);
+   const uint64_t next = now - now % rs->period + rs->period;
+   model_set_timeout_cb(m, next, cover_sample_start_cb, rs);
+}
+
+static void cover_sample_start_cb(rt_model_t *m, void *user)
+{
+   rt_sampler_t *rs = user;
+
+   for (int i = 0; i < rs->toggles.count; i++)
+      cover_toggle_arm(m, rs->toggles.items[i]);
+
+   const uint64_t now = model_now(m, NULL);
+   model_set_timeout_cb(m, now + rs->window, cover_sample_end_cb, rs);
+}
+
+static void cover_add_sampled(rt_model_t *m, cover_data_t *data,
+                              rt_toggle_data_t *td)
+{
+   if (sampler == NULL || sampler->model != m) {
+      // The first window starts at time zero with the watches armed
+      sampler = xcalloc(sizeof(rt_sampler_t));
+      sampler->model  = m;
+      sampler->window = data->sample_window;
+      sampler->period = data->sample_period;
+
+      model_set_timeout_cb(m, sampler->window, cover_sample_end_cb, sampler);
+   }
+
+   APUSH(sampler->toggles, td);
 }
 
 static bool is_constant_input(rt_signal_t *s)
@@ -254,24 +366,46 @@ void x_cover_setup_toggle_cb(sig_shared_t *ss, uint32_t offset, int32_t count,
    }
 
    sig_event_fn_t fn = &cover_toggle_cb_0_1;
+   toggle_check_fn_t check = &cover_toggle_check_0_1;
 
    if ((op_mask & COVER_MASK_TOGGLE_COUNT_FROM_UNDEFINED) &&
-       (op_mask & COVER_MASK_TOGGLE_COUNT_FROM_TO_Z))
+       (op_mask & COVER_MASK_TOGGLE_COUNT_FROM_TO_Z)) {
       fn = &cover_toggle_cb_0_1_u_z;
-
-   else if (op_mask & COVER_MASK_TOGGLE_COUNT_FROM_UNDEFINED)
+      check = &cover_toggle_check_0_1_u_z;
+   }
+   else if (op_mask & COVER_MASK_TOGGLE_COUNT_FROM_UNDEFINED) {
       fn = &cover_toggle_cb_0_1_u;
-
-   else if (op_mask & COVER_MASK_TOGGLE_COUNT_FROM_TO_Z)
+      check = &cover_toggle_check_0_1_u;
+   }
+   else if (op_mask & COVER_MASK_TOGGLE_COUNT_FROM_TO_Z) {
       fn = &cover_toggle_cb_0_1_z;
+      check = &cover_toggle_check_0_1_z;
+   }
+
+   assert(s->nexus.size == 1);
 
    rt_toggle_data_t *td = xcalloc(sizeof(rt_toggle_data_t));
    td->counters = counters + tag;
    td->offset   = offset;
    td->count    = count;
 
-   rt_watch_t *w = watch_new(m, fn, td, WATCH_EVENT, 1);
-   model_set_event_cb(m, s, offset, count, w);
+   if (op_mask & COVER_MASK_TOGGLE_PER_TIME_STEP) {
+      // Events only mark the signal as changed and the toggles are
+      // counted once at the end of the time step
+      td->check    = check;
+      td->snapshot = xmalloc(count);
+      memcpy(td->snapshot, signal_value(s) + offset, count);
+
+      fn = &cover_toggle_event_cb;
+   }
+
+   td->signal = s;
+   td->fn     = fn;
+
+   cover_toggle_arm(m, td);
+
+   if (data->sample_period > 0)
+      cover_add_sampled(m, data, td);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
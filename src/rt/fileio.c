@@ -16,10 +16,12 @@
 //
 
 #include "util.h"
+#include "diag.h"
 #include "jit/jit-exits.h"
 #include "jit/jit-ffi.h"
 #include "jit/jit.h"
 #include "rt/fileio.h"
+#include "rt/mspace.h"
 #include "rt/rt.h"
 
 #include <assert.h>
@@ -76,10 +78,14 @@ typedef struct {
    file_kind_t  kind;
    file_mode_t  mode;
    uint16_t     generation;
+   const char  *map;
+   size_t       mapsz;
+   size_t       pos;
 } file_slot_t;
 
 #define HANDLE_BITS      (sizeof(file_handle_t) * 8)
 #define HANDLE_MAX_INDEX ((UINT64_C(1) << (HANDLE_BITS / 2)) - 1)
+#define WRITE_BUFSZ      (256 * 1024)
 
 static file_slot_t *handles;
 static unsigned     num_handles;
@@ -131,10 +137,13 @@ static file_handle_t handle_for(FILE *f, const char *name, file_kind_t kind,
    }
 
    file_slot_t *slot = &(handles[index]);
-   slot->file = f;
-   slot->name = xstrdup(name);
-   slot->kind = kind;
-   slot->mode = mode;
+   slot->file  = f;
+   slot->name  = xstrdup(name);
+   slot->kind  = kind;
+   slot->mode  = mode;
+   slot->map   = NULL;
+   slot->mapsz = 0;
+   slot->pos   = 0;
 
    free_hint = index + 1;
 
@@ -147,6 +156,9 @@ static bool drop_handle(file_handle_t handle)
    if (slot == NULL)
       return false;
 
+   if (slot->map != NULL)
+      unmap_file((void *)slot->map, slot->mapsz);
+
    if (slot->kind == FILE_USER)
       fclose(slot->file);
 
@@ -159,6 +171,79 @@ static bool drop_handle(file_handle_t handle)
    return true;
 }
 
+static void map_for_read(file_slot_t *slot)
+{
+   // Files opened for reading are accessed through a memory mapping
+   // which lets READ copy directly into the destination without going
+   // through the stdio buffer.  Truncating the file through another
+   // handle in this process drops the mapping but truncation by
+   // another process while the file is open is not supported and may
+   // raise SIGBUS.
+   file_info_t info;
+   if (!get_handle_info(fileno(slot->file), &info))
+      return;
+   else if (info.type != FILE_REGULAR || info.size == 0)
+      return;
+
+   slot->map   = map_file(fileno(slot->file), info.size);
+   slot->mapsz = info.size;
+   slot->pos   = 0;
+}
+
+static void map_drop(file_slot_t *slot)
+{
+   // Switch back to reading through stdio at the current position
+   unmap_file((void *)slot->map, slot->mapsz);
+
+   slot->map   = NULL;
+   slot->mapsz = 0;
+
+   if (fseeko(slot->file, slot->pos, SEEK_SET) < 0)
+      jit_msg(NULL, DIAG_FATAL, "FILE_SEEK failed: %s", strerror(errno));
+}
+
+static void map_refresh(file_slot_t *slot)
+{
+   // Called on reaching the end of the mapping in case another process
+   // or file handle has appended to the file since it was opened
+   file_info_t info;
+   if (!get_handle_info(fileno(slot->file), &info))
+      return;
+   else if (info.size == slot->mapsz)
+      return;
+   else if (info.size < slot->mapsz)
+      map_drop(slot);
+   else {
+      unmap_file((void *)slot->map, slot->mapsz);
+
+      slot->map   = map_file(fileno(slot->file), info.size);
+      slot->mapsz = info.size;
+   }
+}
+
+static void map_truncated(file_slot_t *except)
+{
+   // The file open in EXCEPT was truncated so drop any mappings of the
+   // same file through other handles before they are read past the end
+#ifndef __MINGW32__
+   struct stat st;
+   if (fstat(fileno(except->file), &st) != 0)
+      return;
+
+   for (int i = 0; i < num_handles; i++) {
+      file_slot_t *slot = &(handles[i]);
+      if (slot->file == NULL || slot->map == NULL || slot == except)
+         continue;
+
+      struct stat other;
+      if (fstat(fileno(slot->file), &other) != 0)
+         continue;
+      else if (other.st_dev == st.st_dev && other.st_ino == st.st_ino)
+         map_drop(slot);
+   }
+#endif
+}
+
 bool file_mode(file_handle_t fh, file_mode_t *mode)
 {
    file_slot_t *slot = decode_handle(fh);
@@ -235,6 +320,14 @@ void __nvc_endfile(jit_scalar_t *args)
    if (slot == NULL)
       jit_msg(NULL, DIAG_FATAL, "ENDFILE called on closed file");
 
+   if (slot->map != NULL && slot->pos >= slot->mapsz)
+      map_refresh(slot);
+
+   if (slot->map != NULL) {
+      args[0].integer = (slot->pos >= slot->mapsz);
+      return;
+   }
+
    int c = fgetc(slot->file);
    if (c == EOF)
       args[0].integer = 1;
@@ -265,7 +358,10 @@ void __nvc_rewind(jit_scalar_t *args)
    if (slot == NULL)
       jit_msg(NULL, DIAG_FATAL, "FILE_REWIND called on closed file");
 
-   rewind(slot->file);
+   if (slot->map != NULL)
+      slot->pos = 0;
+   else
+      rewind(slot->file);
 }
 
 DLLEXPORT
@@ -282,7 +378,17 @@ void __nvc_seek(jit_scalar_t *args)
    const int whence[3] = { SEEK_SET, SEEK_CUR, SEEK_END };
    assert(origin >= 0 && origin < ARRAY_LEN(whence));
 
-   if (fseeko(slot->file, offset, whence[origin]) < 0)
+   if (slot->map != NULL && origin == FILE_ORIGIN_END)
+      map_refresh(slot);
+
+   if (slot->map != NULL) {
+      const off_t base[3] = { 0, slot->pos, slot->mapsz };
+      if (base[origin] + offset < 0)
+         jit_msg(NULL, DIAG_FATAL, "FILE_SEEK failed: %s", strerror(EINVAL));
+
+      slot->pos = base[origin] + offset;
+   }
+   else if (fseeko(slot->file, offset, whence[origin]) < 0)
       jit_msg(NULL, DIAG_FATAL, "FILE_SEEK failed: %s", strerror(errno));
 }
 
@@ -322,6 +428,8 @@ void __nvc_truncate(jit_scalar_t *args)
    if (ftruncate(fileno(slot->file), asize) != 0)
       goto failed;
 
+   map_truncated(slot);
+
    if (oldpos > asize || origin == FILE_ORIGIN_END) {
       if (fseeko(slot->file, asize, SEEK_SET) != 0)
          goto failed;
@@ -373,6 +481,25 @@ void __nvc_file_position(jit_scalar_t *args)
    if (slot == NULL)
       jit_msg(NULL, DIAG_FATAL, "FILE_POSITION called on closed file");
 
+   if (slot->map != NULL && origin == FILE_ORIGIN_END)
+      map_refresh(slot);
+
+   if (slot->map != NULL) {
+      const int64_t pos = slot->pos;
+      switch (origin) {
+      case FILE_ORIGIN_BEGIN:
+         args[0].integer = pos;
+         break;
+      case FILE_ORIGIN_END:
+         args[0].integer = (int64_t)slot->mapsz - pos;
+         break;
+      case FILE_ORIGIN_CURRENT:
+         args[0].integer = 0;
+         break;
+      }
+      return;
+   }
+
    off_t off = ftello(slot->file);
    if (off < 0)
       jit_msg(NULL, DIAG_FATAL, "FILE_POSITION failed: %s", strerror(errno));
@@ -466,6 +593,19 @@ void x_file_open(int8_t *status, void **_fp, const uint8_t *name_bytes,
          }
       }
    }
+   else {
+      file_slot_t *slot = decode_handle(*handle);
+      if (mode == FILE_READ)
+         map_for_read(slot);
+      else if (mode == FILE_WRITE || mode == FILE_APPEND) {
+         if (mode == FILE_WRITE)
+            map_truncated(slot);
+
+         // Use a large buffer to batch writes to the file: the buffer
+         // is written out by FLUSH, FILE_CLOSE, or at exit
+         setvbuf(slot->file, NULL, _IOFBF, WRITE_BUFSZ);
+      }
+   }
 }
 
 void x_file_write(void **_fp, void *data, int64_t size, int64_t count)
@@ -476,6 +616,9 @@ void x_file_write(void **_fp, void *data, int64_t size, int64_t count)
    if (slot == NULL)
       jit_msg(NULL, DIAG_FATAL, "write to closed file");
 
+   if (slot->file == stdout)
+      diag_async_flush();   // Keep ordering with queued reports
+
    if (fwrite(data, size, count, slot->file) != count)
       jit_msg(NULL, DIAG_FATAL, "write to file failed");
 }
@@ -488,6 +631,25 @@ int64_t x_file_read(void **_fp, void *data, int64_t size, int64_t count)
    if (slot == NULL)
       jit_msg(NULL, DIAG_FATAL, "read from closed file");
 
+   mspace_touch(data, size * count);
+
+   if (slot->map != NULL && slot->pos + size * count > slot->mapsz)
+      map_refresh(slot);
+
+   if (slot->map != NULL) {
+      // Consume any trailing partial element in the same way as fread
+      const size_t remain = slot->pos < slot->mapsz
+         ? slot->mapsz - slot->pos : 0;
+      const size_t nbytes = MIN(remain, size * count);
+
+      if (nbytes > 0) {
+         memcpy(data, slot->map + slot->pos, nbytes);
+         slot->pos += nbytes;
+      }
+
+      return size > 0 ? nbytes / size : count;
+   }
+
    const unsigned long actual = fread(data, size, count, slot->file);
    if (actual != count && ferror(slot->file))
       jit_msg(NULL, DIAG_FATAL, "read from file failed");
@@ -495,6 +657,85 @@ int64_t x_file_read(void **_fp, void *data, int64_t size, int64_t count)
    return actual;
 }
 
+ffi_uarray_t *x_file_readline(void **_fp)
+{
+   file_handle_t *handle = (file_handle_t *)_fp;
+
+   file_slot_t *slot = decode_handle(*handle);
+   if (slot == NULL)
+      jit_msg(NULL, DIAG_FATAL, "read from closed file");
+
+   // Allocate the line header and body in a single block exactly as
+   // the code generator would for "new string(1 to N)" and grow it
+   // geometrically until the whole line fits
+   size_t capacity = 128 - sizeof(ffi_uarray_t), used = 0;
+
+   if (slot->map != NULL && slot->pos >= slot->mapsz)
+      map_refresh(slot);
+
+   if (slot->map != NULL) {
+      const char *start = slot->map + MIN(slot->pos, slot->mapsz);
+      const char *end = slot->map + slot->mapsz;
+      const char *nl = memchr(start, '\n', end - start);
+      const size_t len = (nl ?: end) - start;
+
+      ffi_uarray_t *line = jit_mspace_alloc(sizeof(ffi_uarray_t) + len);
+      char *buf = (char *)(line + 1);
+
+      for (size_t i = 0; i < len; i++) {
+         if (start[i] != '\r')
+            buf[used++] = start[i];
+      }
+
+      slot->pos += len + (nl != NULL);
+
+      line->ptr = buf;
+      line->dims[0].left = 1;
+      line->dims[0].length = used;
+
+      return line;
+   }
+
+   ffi_uarray_t *line = jit_mspace_alloc(sizeof(ffi_uarray_t) + capacity);
+   char *buf = (char *)(line + 1);
+
+#ifndef __MINGW32__
+   flockfile(slot->file);
+#define GETC getc_unlocked
+#else
+#define GETC getc
+#endif
+
+   for (int ch; (ch = GETC(slot->file)) != EOF && ch != '\n';) {
+      if (ch == '\r')
+         continue;
+      else if (used == capacity) {
+         capacity *= 2;
+         ffi_uarray_t *grown =
+            jit_mspace_alloc(sizeof(ffi_uarray_t) + capacity);
+         memcpy(grown + 1, buf, used);
+         line = grown;
+         buf = (char *)(line + 1);
+      }
+
+      buf[used++] = ch;
+   }
+
+#undef GETC
+#ifndef __MINGW32__
+   funlockfile(slot->file);
+#endif
+
+   if (ferror(slot->file))
+      jit_msg(NULL, DIAG_FATAL, "read from file failed");
+
+   line->ptr = buf;
+   line->dims[0].left = 1;
+   line->dims[0].length = used;
+
+   return line;
+}
+
 void _file_io_init(void)
 {
    // Dummy function to force linking
@@ -20,10 +20,12 @@
 #include "common.h"
 #include "cov/cov-api.h"
 #include "debug.h"
+#include "driver.h"
 #include "hash.h"
 #include "jit/jit-exits.h"
 #include "jit/jit.h"
 #include "lib.h"
+#include "mask.h"
 #include "option.h"
 #include "printf.h"
 #include "psl/psl-node.h"
@@ -33,7 +35,10 @@
 #include "rt/model.h"
 #include "rt/random.h"
 #include "rt/structs.h"
+#include "rt/wheel.h"
+#include "stats.h"
 #include "thread.h"
+#include "timeline.h"
 #include "tree.h"
 #include "type.h"
 #include "vlog/vlog-node.h"
@@ -62,6 +67,7 @@ typedef enum {
 #define MEMBLOCK_ALIGN   64
 #define MEMBLOCK_PAGE_SZ 0x800000
 #define TRIGGER_TAB_SIZE 64
+#define WATCH_BATCHES    8
 
 #if ASAN_ENABLED
 #define MEMBLOCK_REDZONE 16
@@ -69,6 +75,8 @@ typedef enum {
 #define MEMBLOCK_REDZONE 0
 #endif
 
+#define DRIVER_INDEX_THRESH 8
+
 typedef struct _memblock {
    memblock_t *chain;
    size_t      alloc;
@@ -78,12 +86,68 @@ typedef struct _memblock {
 
 STATIC_ASSERT(sizeof(memblock_t) <= MEMBLOCK_ALIGN);
 
+typedef enum {
+   MEM_SIGNAL,
+   MEM_NEXUS,
+   MEM_SOURCE,
+   MEM_WAVEFORM,
+   MEM_VALUE,
+   MEM_TRIGGER,
+   MEM_PROCESS,
+   MEM_OTHER,
+
+   MEM_NUM_KINDS
+} mem_kind_t;
+
+typedef enum {
+   INDEX_SIGNAL = 1, INDEX_ALIAS, INDEX_PROC
+} index_tag_t;
+
+typedef struct _scope_index {
+   hash_t   *objects;
+   hash_t   *children;
+   unsigned  nsignals;
+   unsigned  naliases;
+   unsigned  nprocs;
+   unsigned  nchildren;
+} scope_index_t;
+
+// Flattened design hierarchy in reset order with index ranges into
+// the global process and signal arrays
+typedef struct {
+   rt_scope_t *scope;
+   unsigned    first_proc;
+   unsigned    nprocs;
+   unsigned    first_signal;
+   unsigned    nsignals;
+} flat_scope_t;
+
 typedef struct {
-   waveform_t    *free_waveforms;
-   tlab_t        *tlab;
-   rt_wakeable_t *active_obj;
-   rt_scope_t    *active_scope;
-} __attribute__((aligned(64))) model_thread_t;
+   flat_scope_t  *scopes;
+   unsigned       nscopes;
+   rt_proc_t    **procs;
+   unsigned       nprocs;
+   rt_signal_t  **signals;
+   unsigned       nsignals;
+} flat_design_t;
+
+// Nexus ranks are small integers so pending driving and effective
+// value updates are kept in a bucket queue indexed by rank
+#define RANKQ_SIZE 256
+
+typedef struct {
+   rt_nexus_t **items;
+   unsigned     head;
+   unsigned     count;
+   unsigned     max;
+} rank_bucket_t;
+
+typedef struct {
+   nvc_lock_t    lock;
+   size_t        size;
+   uint64_t      bitmap[RANKQ_SIZE / 64];
+   rank_bucket_t buckets[RANKQ_SIZE];
+} rank_queue_t;
 
 typedef void (*defer_fn_t)(rt_model_t *, void *);
 
@@ -98,10 +162,90 @@ typedef struct {
    unsigned      max;
 } deferq_t;
 
+typedef enum {
+   SCHED_DEFER, SCHED_WAKEUP, SCHED_EVENT
+} sched_kind_t;
+
+typedef struct {
+   sched_kind_t  kind;
+   deferq_t     *queue;
+   defer_task_t  task;
+   uint64_t      when;
+} sched_task_t;
+
+typedef A(sched_task_t) sched_list_t;
+
+typedef struct {
+   rt_nexus_t    *nexus;
+   unsigned char *value;
+   bool           captured;
+} resolve_task_t;
+
+typedef A(resolve_task_t) resolve_list_t;
+
+typedef struct {
+   waveform_t     *free_waveforms;
+   int64_t         live_waveforms;
+   tlab_t         *tlab;
+   rt_wakeable_t  *active_obj;
+   rt_scope_t     *active_scope;
+   sched_list_t   *schedq;
+   resolve_task_t *capture;
+} __attribute__((aligned(64))) model_thread_t;
+
+typedef struct {
+   const defer_task_t *tasks;
+   unsigned            count;
+   sched_list_t        schedq;
+} proc_batch_t;
+
+typedef A(rt_watch_t *) watch_list_t;
+
+typedef struct {
+   sig_event_fn_t fn;
+   watch_list_t   watches;
+} watch_batch_t;
+
+struct _prof_rec {
+   rt_proc_t     *proc;
+   rt_signal_t   *signal;
+   uint64_t       time_ns;
+   uint64_t       calls;
+   uint64_t       wakeups;
+   nvc_hwcount_t  hw;
+};
+
+typedef A(prof_rec_t *) prof_list_t;
+
+typedef struct {
+   prof_list_t  procs;
+   prof_list_t  signals;
+   char        *json;
+   bool         counters;
+} rt_profile_t;
+
+typedef struct {
+   rt_proc_t *proc;
+   tree_t     decl;
+   uint64_t   samples;
+} storm_rec_t;
+
+typedef A(storm_rec_t *) storm_list_t;
+
+typedef struct {
+   unsigned      threshold;
+   hash_t       *map;
+   storm_list_t  recs;
+   uint64_t      steps;
+   unsigned      max_deltas;
+   uint64_t      max_time;
+} delta_storm_t;
+
 typedef struct _rt_model {
    tree_t             top;
    hash_t            *scopes;
    rt_scope_t        *root;
+   flat_design_t     *flat;
    mspace_t          *mspace;
    jit_t             *jit;
    rt_nexus_t        *nexuses;
@@ -115,9 +259,11 @@ typedef struct _rt_model {
    bool               force_stop;
    bool               blocking_update;
    unsigned           n_signals;
-   heap_t            *eventq_heap;
+   wheel_t           *eventq;
    ihash_t           *res_memo;
    rt_watch_t        *watches;
+   watch_batch_t      watchq[WATCH_BATCHES];
+   unsigned           n_watch_batches;
    deferq_t           procq;
    deferq_t           next_procq;
    deferq_t           driverq;
@@ -128,8 +274,8 @@ typedef struct _rt_model {
    deferq_t           next_inactiveq;
    deferq_t           nonblockq;
    deferq_t           reschedq;
-   heap_t            *driving_heap;
-   heap_t            *effective_heap;
+   rank_queue_t      *driving_queue;
+   rank_queue_t      *effective_queue;
    rt_callback_t     *phase_cbs[END_OF_SIMULATION + 1];
    cover_data_t      *cover;
    nvc_rusage_t       ready_rusage;
@@ -140,14 +286,50 @@ typedef struct _rt_model {
    bool               shuffle;
    bool               liveness;
    rt_trigger_t      *triggertab[TRIGGER_TAB_SIZE];
+   workq_t           *procwq;
+   proc_batch_t      *batches;
+   unsigned           nbatches;
+   bool               in_parallel;
+   rt_profile_t      *profile;
+   rt_profile_t      *stopped_profile;
+   delta_storm_t     *storm;
+   resolve_list_t     resolveq;
+   deferq_t           resolvetasks;
+   unsigned char     *resolvebuf;
+   size_t             resolvesz;
+   hash_t            *splitplans;
+   size_t             membytes[MEM_NUM_KINDS];
+   unsigned           memcount[MEM_NUM_KINDS];
+   uint64_t           last_flush;
 } rt_model_t;
 
+typedef struct {
+   uint32_t length;
+   uint32_t count;
+   uint32_t widths[];
+} split_plan_t;
+
+typedef struct {
+   int64_t      left;
+   int64_t      length;
+   range_kind_t dir;
+   bit_mask_t   points;
+} plan_builder_t;
+
 #define FMT_VALUES_SZ   128
 #define NEXUS_INDEX_MIN 8
+#define SCOPE_INDEX_MIN 32
 #define TRACE_SIGNALS   1
 #define WAVEFORM_CHUNK  256
 #define PENDING_MIN     4
 #define MAX_RANK        UINT8_MAX
+#define PARALLEL_MIN    64
+#define BATCH_PER_CPU   4
+#define PROFILE_TOP     20
+#define WAKEUP_PREFETCH 8
+#define FLUSH_INTERVAL  100000   // Microseconds
+
+STATIC_ASSERT(MAX_RANK < RANKQ_SIZE);
 
 #define TRACE(...) do {                                 \
       if (unlikely(__trace_on))                         \
@@ -168,8 +350,12 @@ static rt_nexus_t *clone_nexus(rt_model_t *m, rt_nexus_t *old, int offset);
 static void put_driving(rt_model_t *m, rt_nexus_t *n, const void *value);
 static void put_effective(rt_model_t *m, rt_nexus_t *n, const void *value);
 static bool run_trigger(rt_model_t *m, rt_trigger_t *t);
+static void wakeup_one(rt_model_t *m, rt_wakeable_t *obj);
+static delta_storm_t *storm_new(unsigned threshold);
+static void storm_free(delta_storm_t *ds);
+static void storm_end_step(rt_model_t *m);
+static void storm_report(delta_storm_t *ds);
 static void wakeup_all(rt_model_t *m, void **pending);
-static void reset_scope(rt_model_t *m, rt_scope_t *s);
 static void async_run_process(rt_model_t *m, void *arg);
 static void async_update_property(rt_model_t *m, void *arg);
 static void async_update_driver(rt_model_t *m, void *arg);
@@ -385,6 +571,37 @@ static inline void deferq_do(deferq_t *dq, defer_fn_t fn, void *arg)
    dq->tasks[dq->count++] = (defer_task_t){ fn, arg };
 }
 
+static inline void sched_do(rt_model_t *m, deferq_t *dq, defer_fn_t fn,
+                            void *arg)
+{
+#if RT_MULTITHREADED
+   if (unlikely(m->in_parallel)) {
+      // Buffer the task in a list owned by the current batch which is
+      // merged into the global queue at the end of the parallel region
+      const sched_task_t st = { SCHED_DEFER, dq, { fn, arg } };
+      APUSH(*model_thread(m)->schedq, st);
+      return;
+   }
+#endif
+
+   deferq_do(dq, fn, arg);
+}
+
+static inline void eventq_insert(rt_model_t *m, uint64_t when, void *e)
+{
+#if RT_MULTITHREADED
+   if (unlikely(m->in_parallel)) {
+      // The event queue is not thread safe so insertions are buffered
+      // and replayed in batch order like other scheduling operations
+      const sched_task_t st = { SCHED_EVENT, NULL, { NULL, e }, when };
+      APUSH(*model_thread(m)->schedq, st);
+      return;
+   }
+#endif
+
+   wheel_insert(m->eventq, when, e);
+}
+
 static void deferq_scan(deferq_t *dq, scan_fn_t fn, void *arg)
 {
    for (int i = 0; i < dq->count; i++)
@@ -439,27 +656,189 @@ static void deferq_run(rt_model_t *m, deferq_t *dq)
    }
 }
 
-static void *static_alloc(rt_model_t *m, size_t size)
+#if RT_MULTITHREADED
+static void parallel_run_batch(void *context, void *arg)
 {
-   const int total_bytes = ALIGN_UP(size + MEMBLOCK_REDZONE, MEMBLOCK_ALIGN);
+   rt_model_t *m = context;
+   proc_batch_t *batch = arg;
 
-   RT_LOCK(m->memlock);
+   MODEL_ENTRY(m);
 
-   memblock_t *mb = m->memblocks;
+   model_thread_t *thread = model_thread(m);
+   if (thread->tlab == NULL)
+      thread->tlab = tlab_acquire(m->mspace);
+
+   thread->schedq = &(batch->schedq);
+
+   for (int i = 0; i < batch->count; i++)
+      (*batch->tasks[i].fn)(m, batch->tasks[i].arg);
+}
+
+static void parallel_merge(rt_model_t *m, int nbatches)
+{
+   // Replay the scheduling operations buffered by each batch in batch
+   // order so the contents of the global queues are deterministic
+   // regardless of which thread ran each batch
+   for (int i = 0; i < nbatches; i++) {
+      sched_list_t *schedq = &(m->batches[i].schedq);
+
+      for (int j = 0; j < schedq->count; j++) {
+         const sched_task_t *st = &(schedq->items[j]);
+         switch (st->kind) {
+         case SCHED_DEFER:
+            deferq_do(st->queue, st->task.fn, st->task.arg);
+            break;
+         case SCHED_WAKEUP:
+            wakeup_one(m, st->task.arg);
+            break;
+         case SCHED_EVENT:
+            wheel_insert(m->eventq, st->when, st->task.arg);
+            break;
+         }
+      }
 
-   if (mb == NULL || mb->alloc + total_bytes > mb->limit) {
-      const size_t pagesz =
-         MAX(MEMBLOCK_PAGE_SZ, total_bytes + 2 * MEMBLOCK_ALIGN);
+      ATRIM(*schedq, 0);
+   }
+}
+
+static void parallel_run(rt_model_t *m, deferq_t *dq)
+{
+   assert(m->reschedq.count == 0);
 
-      mb = map_huge_pages(MEMBLOCK_ALIGN, pagesz);
-      mb->alloc = MEMBLOCK_ALIGN;
-      mb->limit = pagesz - MEMBLOCK_ALIGN;   // Allow overreading in intrinsics
+   // Only processes are evaluated in parallel: other tasks such as
+   // foreign callbacks are not thread safe and run afterwards
+   int nprocs = 0;
+   for (int i = 0; i < dq->count; i++) {
+      if (dq->tasks[i].fn == async_run_process) {
+         const defer_task_t tmp = dq->tasks[nprocs];
+         dq->tasks[nprocs++] = dq->tasks[i];
+         dq->tasks[i] = tmp;
+      }
+   }
 
-      ASAN_POISON(mb->data, pagesz - sizeof(memblock_t));
+   const int nbatches = MIN(m->nbatches, nprocs / PARALLEL_MIN + 1);
+   const int per_batch = (nprocs + nbatches - 1) / nbatches;
 
-      m->memblocks = mb;
+   for (int i = 0, first = 0; i < nbatches; i++, first += per_batch) {
+      m->batches[i].tasks = dq->tasks + first;
+      m->batches[i].count = MIN(per_batch, nprocs - first);
+      workq_do(m->procwq, parallel_run_batch, &(m->batches[i]));
    }
 
+   m->in_parallel = true;
+   workq_start(m->procwq);
+   workq_drain(m->procwq);
+   m->in_parallel = false;
+
+   parallel_merge(m, nbatches);
+
+   for (int i = nprocs; i < dq->count; i++)
+      (*dq->tasks[i].fn)(m, dq->tasks[i].arg);
+
+   dq->count = 0;
+
+   if (m->reschedq.count > 0) {
+      deferq_swap(&m->reschedq, dq);
+      deferq_run(m, dq);
+   }
+}
+#endif
+
+static void rankq_insert(rank_queue_t *q, unsigned key, rt_nexus_t *n)
+{
+   RT_LOCK(q->lock);
+
+   assert(key < RANKQ_SIZE);
+   rank_bucket_t *b = &(q->buckets[key]);
+
+   if (unlikely(b->count == b->max)) {
+      b->max = MAX(b->max * 2, 16);
+      b->items = xrealloc_array(b->items, b->max, sizeof(rt_nexus_t *));
+   }
+
+   b->items[b->count++] = n;
+   q->bitmap[key / 64] |= UINT64_C(1) << (key % 64);
+   q->size++;
+}
+
+static inline unsigned rankq_first(rank_queue_t *q)
+{
+   assert(q->size > 0);
+
+   int word = 0;
+   while (q->bitmap[word] == 0)
+      word++;
+
+   return word * 64 + __builtin_ctzll(q->bitmap[word]);
+}
+
+#if RT_MULTITHREADED
+static unsigned rankq_min_key(rank_queue_t *q)
+{
+   RT_LOCK(q->lock);
+   return rankq_first(q);
+}
+#endif
+
+static rt_nexus_t *rankq_extract_min(rank_queue_t *q)
+{
+   RT_LOCK(q->lock);
+
+   const unsigned key = rankq_first(q);
+
+   // Entries with the same rank are removed in insertion order
+   rank_bucket_t *b = &(q->buckets[key]);
+   rt_nexus_t *n = b->items[b->head++];
+
+   if (b->head == b->count) {
+      b->head = b->count = 0;
+      q->bitmap[key / 64] &= ~(UINT64_C(1) << (key % 64));
+   }
+
+   q->size--;
+   return n;
+}
+
+static inline size_t rankq_size(rank_queue_t *q)
+{
+   return q->size;
+}
+
+static void rankq_free(rank_queue_t *q)
+{
+   for (int i = 0; i < RANKQ_SIZE; i++)
+      free(q->buckets[i].items);
+
+   free(q);
+}
+
+static memblock_t *memblock_new(rt_model_t *m, size_t pagesz)
+{
+   memblock_t *mb = map_huge_pages(MEMBLOCK_ALIGN, pagesz);
+   mb->chain = m->memblocks;
+   mb->alloc = MEMBLOCK_ALIGN;
+   mb->limit = pagesz - MEMBLOCK_ALIGN;   // Allow overreading in intrinsics
+
+   ASAN_POISON(mb->data, pagesz - sizeof(memblock_t));
+
+   return (m->memblocks = mb);
+}
+
+static void *static_alloc(rt_model_t *m, size_t size, mem_kind_t kind)
+{
+   const int total_bytes = ALIGN_UP(size + MEMBLOCK_REDZONE, MEMBLOCK_ALIGN);
+
+   RT_LOCK(m->memlock);
+
+   m->membytes[kind] += total_bytes;
+   m->memcount[kind]++;
+
+   memblock_t *mb = m->memblocks;
+
+   if (mb == NULL || mb->alloc + total_bytes > mb->limit)
+      mb = memblock_new(m, MAX(MEMBLOCK_PAGE_SZ,
+                               total_bytes + 2 * MEMBLOCK_ALIGN));
+
    assert((mb->alloc & (MEMBLOCK_ALIGN - 1)) == 0);
 
    void *ptr = (void *)mb + mb->alloc;
@@ -469,16 +848,320 @@ static void *static_alloc(rt_model_t *m, size_t size)
    return ptr;
 }
 
+static rt_proc_t *proc_alloc(rt_model_t *m, size_t size)
+{
+   // Processes are allocated together so those woken by the same
+   // clock edge are likely to be close in memory
+   rt_proc_t *p = static_alloc(m, size, MEM_PROCESS);
+   memset(p, '\0', size);
+   return p;
+}
+
 static void run_callbacks(rt_model_t *m, model_phase_t phase)
 {
    rt_callback_t *list = m->phase_cbs[phase];
+   if (list == NULL)
+      return;
+
    m->phase_cbs[phase] = NULL;
 
+   static const char *names[] = {
+      "end of initialisation", "start of simulation", "start of processes",
+      "end of processes", "start of postponed", "last known delta cycle",
+      "next time step", "end time step", "next cycle", "end of simulation",
+   };
+   STATIC_ASSERT(ARRAY_LEN(names) == END_OF_SIMULATION + 1);
+
+   TIMELINE_BEGIN("callbacks", names[phase]);
+
    for (rt_callback_t *it = list, *tmp; it; it = tmp) {
       tmp = it->next;
       (*it->fn)(m, it->user);
       free(it);
    }
+
+   TIMELINE_END("callbacks");
+}
+
+static rt_profile_t *profile_new(const char *json)
+{
+   rt_profile_t *p = xcalloc(sizeof(rt_profile_t));
+   p->json = *json != '\0' ? xstrdup(json) : NULL;
+
+   nvc_hwcount_t dummy;
+   if (!opt_get_int(OPT_PROFILE_COUNTERS))
+      p->counters = false;
+   else if (!(p->counters = nvc_hwcount(&dummy)))
+      warnf("hardware performance counters are not available");
+
+   return p;
+}
+
+static void profile_free(rt_profile_t *p)
+{
+   for (int i = 0; i < p->procs.count; i++) {
+      prof_rec_t *rec = p->procs.items[i];
+      if (rec->proc->profile == rec)
+         rec->proc->profile = NULL;
+      free(rec);
+   }
+   for (int i = 0; i < p->signals.count; i++)
+      free(p->signals.items[i]);
+
+   ACLEAR(p->procs);
+   ACLEAR(p->signals);
+   free(p->json);
+   free(p);
+}
+
+static void profile_add_proc(rt_profile_t *p, rt_proc_t *proc)
+{
+   prof_rec_t *rec = xcalloc(sizeof(prof_rec_t));
+   rec->proc = proc;
+
+   proc->profile = rec;
+   APUSH(p->procs, rec);
+}
+
+static void profile_add_signal(rt_profile_t *p, rt_signal_t *s)
+{
+   prof_rec_t *rec = xcalloc(sizeof(prof_rec_t));
+   rec->signal = s;
+
+   APUSH(p->signals, rec);
+   s->profile = p->signals.count;
+}
+
+static void profile_add_counters(nvc_hwcount_t *total,
+                                 const nvc_hwcount_t *start,
+                                 const nvc_hwcount_t *end)
+{
+   relaxed_add(&total->cycles, end->cycles - start->cycles);
+   relaxed_add(&total->instructions, end->instructions - start->instructions);
+   relaxed_add(&total->branch_misses,
+               end->branch_misses - start->branch_misses);
+   relaxed_add(&total->cache_misses, end->cache_misses - start->cache_misses);
+}
+
+static inline prof_rec_t *profile_get_signal(rt_profile_t *p, rt_signal_t *s)
+{
+   // Records are created during initialisation so the list is not
+   // modified while processes run in parallel: the index may be left
+   // over from an earlier profile so check the record matches
+   if (s->profile == 0 || s->profile > p->signals.count)
+      return NULL;
+
+   prof_rec_t *rec = p->signals.items[s->profile - 1];
+   return rec->signal == s ? rec : NULL;
+}
+
+static void profile_signal_name(rt_signal_t *s, text_buf_t *tb)
+{
+   rt_scope_t *scope = s->parent;
+   while (is_signal_scope(scope))
+      scope = scope->parent;
+
+   get_path_name(scope, tb);
+   tb_append(tb, ':');
+
+   if (is_signal_scope(s->parent))
+      tb_printf(tb, "%s.", istr(s->parent->name));
+
+   tb_istr(tb, tree_ident(s->where));
+   tb_downcase(tb);
+}
+
+static int profile_rec_cmp(const void *a, const void *b)
+{
+   const prof_rec_t *ra = *(const prof_rec_t **)a;
+   const prof_rec_t *rb = *(const prof_rec_t **)b;
+
+   if (ra->time_ns != rb->time_ns)
+      return ra->time_ns < rb->time_ns ? 1 : -1;
+   else if (ra->calls != rb->calls)
+      return ra->calls < rb->calls ? 1 : -1;
+   else
+      return 0;
+}
+
+static void profile_rec_name(const prof_rec_t *rec, text_buf_t *tb)
+{
+   if (rec->proc != NULL)
+      tb_istr(tb, rec->proc->name);
+   else
+      profile_signal_name(rec->signal, tb);
+}
+
+static void profile_print_table(prof_list_t *list, const char *title,
+                                const char *what, uint64_t total_ns)
+{
+   nvc_printf("\n$bold$%s$$ (%u total)\n\n", title, list->count);
+   nvc_printf("   %10s %6s %12s %12s  %s\n",
+              "Time (us)", "%", "Calls", what, "Name");
+
+   LOCAL_TEXT_BUF tb = tb_new();
+   for (int i = 0; i < list->count && i < PROFILE_TOP; i++) {
+      const prof_rec_t *rec = list->items[i];
+      if (rec->calls == 0)
+         break;
+
+      tb_rewind(tb);
+      profile_rec_name(rec, tb);
+
+      const loc_t *loc = tree_loc(rec->proc ? rec->proc->where
+                                  : rec->signal->where);
+
+      const double pct = total_ns ? 100.0 * rec->time_ns / total_ns : 0.0;
+      nvc_printf("   %10"PRIu64" %6.2f %12"PRIu64" %12"PRIu64"  %s (%s:%d)\n",
+                 rec->time_ns / 1000, pct, rec->calls, rec->wakeups,
+                 tb_get(tb), loc_file_str(loc), loc->first_line);
+   }
+}
+
+static void profile_print_counters(prof_list_t *list)
+{
+   nvc_printf("\n$bold$Hardware counters$$\n\n");
+   nvc_printf("   %14s %14s %5s %12s %12s  %s\n", "Cycles",
+              "Instructions", "IPC", "Br. misses", "Cache misses", "Name");
+
+   LOCAL_TEXT_BUF tb = tb_new();
+   for (int i = 0; i < list->count && i < PROFILE_TOP; i++) {
+      const prof_rec_t *rec = list->items[i];
+      if (rec->calls == 0)
+         break;
+
+      tb_rewind(tb);
+      profile_rec_name(rec, tb);
+
+      const nvc_hwcount_t *hw = &(rec->hw);
+      const double ipc =
+         hw->cycles ? (double)hw->instructions / hw->cycles : 0.0;
+      nvc_printf("   %14"PRIu64" %14"PRIu64" %5.2f %12"PRIu64" %12"PRIu64
+                 "  %s\n", hw->cycles, hw->instructions, ipc,
+                 hw->branch_misses, hw->cache_misses, tb_get(tb));
+   }
+}
+
+static void profile_json_string(FILE *f, const char *str)
+{
+   fputc('"', f);
+   for (const char *p = str; *p; p++) {
+      if (*p == '"' || *p == '\\') {
+         fputc('\\', f);
+         fputc(*p, f);
+      }
+      else if ((unsigned char)*p < 0x20)
+         fprintf(f, "\\u%04x", *p);
+      else
+         fputc(*p, f);
+   }
+   fputc('"', f);
+}
+
+static void profile_json_list(FILE *f, prof_list_t *list, const char *what,
+                              bool counters)
+{
+   LOCAL_TEXT_BUF tb = tb_new();
+   for (int i = 0; i < list->count; i++) {
+      const prof_rec_t *rec = list->items[i];
+
+      tb_rewind(tb);
+      profile_rec_name(rec, tb);
+
+      const loc_t *loc = tree_loc(rec->proc ? rec->proc->where
+                                  : rec->signal->where);
+
+      fputs(i == 0 ? "\n    {" : ",\n    {", f);
+      fputs("\"name\": ", f);
+      profile_json_string(f, tb_get(tb));
+      fputs(", \"file\": ", f);
+      profile_json_string(f, loc_file_str(loc));
+      fprintf(f, ", \"line\": %d, \"time_ns\": %"PRIu64", \"calls\": %"
+              PRIu64", \"%s\": %"PRIu64, loc->first_line, rec->time_ns,
+              rec->calls, what, rec->wakeups);
+
+      if (counters) {
+         const nvc_hwcount_t *hw = &(rec->hw);
+         fprintf(f, ", \"cycles\": %"PRIu64", \"instructions\": %"PRIu64
+                 ", \"branch_misses\": %"PRIu64", \"cache_misses\": %"
+                 PRIu64, hw->cycles, hw->instructions, hw->branch_misses,
+                 hw->cache_misses);
+      }
+
+      fputc('}', f);
+   }
+}
+
+static void profile_add_scope(rt_profile_t *p, rt_scope_t *s)
+{
+   for (int i = 0; i < s->procs.count; i++)
+      profile_add_proc(p, s->procs.items[i]);
+
+   for (int i = 0; i < s->signals.count; i++)
+      profile_add_signal(p, s->signals.items[i]);
+
+   for (int i = 0; i < s->children.count; i++)
+      profile_add_scope(p, s->children.items[i]);
+}
+
+static void profile_sort(const prof_list_t *list, prof_list_t *sorted)
+{
+   // Sort a copy as the signal records are found by their position
+   // and profiling may continue after the report
+   for (int i = 0; i < list->count; i++)
+      APUSH(*sorted, list->items[i]);
+
+   qsort(sorted->items, sorted->count, sizeof(prof_rec_t *),
+         profile_rec_cmp);
+}
+
+static void profile_report(rt_profile_t *p)
+{
+   prof_list_t procs = AINIT, signals = AINIT;
+   profile_sort(&p->procs, &procs);
+   profile_sort(&p->signals, &signals);
+
+   uint64_t proc_ns = 0, signal_ns = 0;
+   for (int i = 0; i < procs.count; i++)
+      proc_ns += procs.items[i]->time_ns;
+   for (int i = 0; i < signals.count; i++)
+      signal_ns += signals.items[i]->time_ns;
+
+   profile_print_table(&procs, "Processes", "Wakeups", proc_ns);
+   profile_print_table(&signals, "Signals", "Events", signal_ns);
+
+   if (p->counters)
+      profile_print_counters(&procs);
+
+   if (p->json != NULL) {
+      FILE *f = fopen(p->json, "w");
+      if (f == NULL)
+         fatal_errno("cannot create %s", p->json);
+
+      fprintf(f, "{\n  \"processes\": [");
+      profile_json_list(f, &procs, "wakeups", p->counters);
+      fprintf(f, "\n  ],\n  \"signals\": [");
+      profile_json_list(f, &signals, "events", false);
+      fprintf(f, "\n  ]\n}\n");
+
+      fclose(f);
+   }
+
+   ACLEAR(procs);
+   ACLEAR(signals);
+}
+
+static ident_t heap_profile_site(void)
+{
+   jit_stack_trace_t *stack LOCAL = jit_stack_trace();
+
+   for (int i = 0; i < stack->count; i++) {
+      const loc_t *loc = &(stack->frames[i].loc);
+      if (!loc_invalid_p(loc))
+         return ident_sprintf("%s:%d", loc_file_str(loc), loc->first_line);
+   }
+
+   return NULL;
 }
 
 rt_model_t *model_new(jit_t *jit, cover_data_t *cover)
@@ -489,23 +1172,53 @@ rt_model_t *model_new(jit_t *jit, cover_data_t *cover)
    m->jit         = jit;
    m->nexus_tail  = &(m->nexuses);
    m->iteration   = -1;
-   m->eventq_heap = heap_new(512);
+   m->eventq      = wheel_new();
    m->res_memo    = ihash_new(128);
    m->cover       = cover;
 
-   m->driving_heap   = heap_new(64);
-   m->effective_heap = heap_new(64);
+   m->driving_queue   = xcalloc(sizeof(rank_queue_t));
+   m->effective_queue = xcalloc(sizeof(rank_queue_t));
 
    m->can_create_delta = true;
    m->next_is_delta    = true;
 
-   m->threads[thread_id()] = static_alloc(m, sizeof(model_thread_t));
+   m->threads[thread_id()] =
+      static_alloc(m, sizeof(model_thread_t), MEM_OTHER);
 
    __trace_on = opt_get_int(OPT_RT_TRACE);
 
+   const size_t interval = opt_get_size(OPT_HEAP_PROFILE);
+   if (interval > 0)
+      mspace_set_profiler(m->mspace, interval, heap_profile_site);
+
    return m;
 }
 
+void model_reserve(rt_model_t *m, size_t bytes)
+{
+   // Map a single block large enough for the expected static memory so
+   // that signals and processes in large designs are contiguous rather
+   // than spread over many smaller blocks
+   const size_t want = bytes + bytes / 4 + 2 * MEMBLOCK_ALIGN;
+   if (want <= MEMBLOCK_PAGE_SZ)
+      return;
+
+   RT_LOCK(m->memlock);
+
+   memblock_t *mb = m->memblocks;
+   if (mb == NULL || mb->limit - mb->alloc < want)
+      memblock_new(m, ALIGN_UP(want, MEMBLOCK_PAGE_SZ));
+}
+
+size_t model_static_size(rt_model_t *m)
+{
+   size_t total = 0;
+   for (int i = 0; i < MEM_NUM_KINDS; i++)
+      total += m->membytes[i];
+
+   return total;
+}
+
 rt_model_t *get_model(void)
 {
    assert(__model != NULL);
@@ -532,6 +1245,24 @@ rt_proc_t *get_active_proc(void)
    return container_of(obj, rt_proc_t, wakeable);
 }
 
+rng_stream_t *get_active_rng(void)
+{
+   // Processes draw from their own stream when they may run in parallel
+   // so the sequence each sees does not depend on the scheduling order
+   if (__model == NULL || __model->procwq == NULL)
+      return NULL;
+
+   rt_wakeable_t *obj = get_active_wakeable();
+   if (obj == NULL || obj->kind != W_PROC)
+      return NULL;
+
+   rt_proc_t *proc = container_of(obj, rt_proc_t, wakeable);
+   if (proc->rng.s[0] == 0 && proc->rng.s[1] == 0)
+      rng_stream_init(&proc->rng, istr(proc->name));
+
+   return &proc->rng;
+}
+
 rt_scope_t *get_active_scope(rt_model_t *m)
 {
    return model_thread(m)->active_scope;
@@ -542,6 +1273,17 @@ static void free_waveform(rt_model_t *m, waveform_t *w)
    model_thread_t *thread = model_thread(m);
    w->next = thread->free_waveforms;
    thread->free_waveforms = w;
+   thread->live_waveforms--;
+}
+
+static void free_waveform_list(rt_model_t *m, waveform_t *head,
+                               waveform_t *tail, int count)
+{
+   // Return a whole chain of waveforms to the free list at once
+   model_thread_t *thread = model_thread(m);
+   tail->next = thread->free_waveforms;
+   thread->free_waveforms = head;
+   thread->live_waveforms -= count;
 }
 
 static void cleanup_nexus(rt_model_t *m, rt_nexus_t *n)
@@ -550,6 +1292,15 @@ static void cleanup_nexus(rt_model_t *m, rt_nexus_t *n)
       free(n->pending);
 }
 
+static void free_index(rt_index_t *index)
+{
+   if (index != NULL) {
+      free(index->offsets);
+      free(index->nexus);
+      free(index);
+   }
+}
+
 static void cleanup_signal(rt_model_t *m, rt_signal_t *s)
 {
    rt_nexus_t *n = &(s->nexus), *tmp;
@@ -558,21 +1309,20 @@ static void cleanup_signal(rt_model_t *m, rt_signal_t *s)
       cleanup_nexus(m, n);
    }
 
-   free(s->index);
+   free_index(s->index);
 }
 
-static void cleanup_scope(rt_model_t *m, rt_scope_t *scope)
+static void cleanup_process(rt_model_t *m, rt_proc_t *p)
 {
-   for (int i = 0; i < scope->procs.count; i++) {
-      rt_proc_t *p = scope->procs.items[i];
-      mptr_free(m->mspace, &(p->privdata));
-      tlab_release(p->tlab);
-      free(p);
-   }
-   ACLEAR(scope->procs);
+   mptr_free(m->mspace, &(p->privdata));
+   tlab_release(p->tlab);
+   if (p->drivers != NULL)
+      ihash_free(p->drivers);
+}
 
-   for (int i = 0; i < scope->signals.count; i++)
-      cleanup_signal(m, scope->signals.items[i]);
+static void free_scope(rt_model_t *m, rt_scope_t *scope)
+{
+   ACLEAR(scope->procs);
    ACLEAR(scope->signals);
 
    for (int i = 0; i < scope->aliases.count; i++)
@@ -587,18 +1337,69 @@ static void cleanup_scope(rt_model_t *m, rt_scope_t *scope)
       free(p);
    }
    ACLEAR(scope->properties);
-
-   for (int i = 0; i < scope->children.count; i++)
-      cleanup_scope(m, scope->children.items[i]);
    ACLEAR(scope->children);
 
+   if (scope->index != NULL) {
+      hash_free(scope->index->objects);
+      hash_free(scope->index->children);
+      free(scope->index);
+   }
+
    mptr_free(m->mspace, &(scope->privdata));
    free(scope);
 }
 
+static void cleanup_scope(rt_model_t *m, rt_scope_t *scope)
+{
+   for (int i = 0; i < scope->procs.count; i++)
+      cleanup_process(m, scope->procs.items[i]);
+
+   for (int i = 0; i < scope->signals.count; i++)
+      cleanup_signal(m, scope->signals.items[i]);
+
+   for (int i = 0; i < scope->children.count; i++)
+      cleanup_scope(m, scope->children.items[i]);
+
+   free_scope(m, scope);
+}
+
+static void cleanup_flat(rt_model_t *m, flat_design_t *f)
+{
+   for (int i = 0; i < f->nprocs; i++)
+      cleanup_process(m, f->procs[i]);
+
+   for (int i = 0; i < f->nsignals; i++)
+      cleanup_signal(m, f->signals[i]);
+
+   // Children precede their parents so no scope outlives its parent
+   for (int i = 0; i < f->nscopes; i++)
+      free_scope(m, f->scopes[i].scope);
+
+   free(f->scopes);
+   free(f->procs);
+   free(f->signals);
+   free(f);
+}
+
 void model_free(rt_model_t *m)
 {
-   if (opt_get_int(OPT_RT_STATS)) {
+   if (m->profile != NULL)
+      profile_report(m->profile);
+
+   if (m->storm != NULL) {
+      if (m->iteration >= 0)
+         storm_end_step(m);
+      storm_report(m->storm);
+      storm_free(m->storm);
+   }
+
+   if (opt_get_int(OPT_RT_STATS) == STATS_JSON) {
+      LOCAL_TEXT_BUF tb = tb_new();
+      stat_json(tb);
+      fputs(tb_get(tb), stdout);
+      fflush(stdout);
+   }
+   else if (opt_get_int(OPT_RT_STATS)) {
       nvc_rusage_t ru;
       nvc_rusage(&ru);
 
@@ -608,15 +1409,42 @@ void model_free(rt_model_t *m)
 
       notef("setup:%ums run:%ums user:%ums sys:%ums maxrss:%ukB static:%ukB",
             m->ready_rusage.ms, ru.ms, ru.user, ru.sys, ru.rss, mem / 1024);
+
+      const size_t huge = huge_page_usage();
+      if (huge > 0)
+         notef("huge pages:%zukB", huge / 1024);
+
+      static const char *names[] = {
+         "signals", "nexuses", "sources", "waveforms", "values",
+         "triggers", "processes", "other"
+      };
+      STATIC_ASSERT(ARRAY_LEN(names) == MEM_NUM_KINDS);
+
+      LOCAL_TEXT_BUF tb = tb_new();
+      for (int i = 0; i < MEM_NUM_KINDS; i++) {
+         if (m->memcount[i] == 0)
+            continue;
+         else if (tb_len(tb) > 0)
+            tb_cat(tb, " ");
+
+         tb_printf(tb, "%s:%u/%zukB", names[i], m->memcount[i],
+                   m->membytes[i] / 1024);
+      }
+
+      notef("static memory %s", tb_get(tb));
+
+      report_vhdl_assert_sites(5);
    }
 
-   while (heap_size(m->eventq_heap) > 0) {
-      void *e = heap_extract_min(m->eventq_heap);
+   while (wheel_size(m->eventq) > 0) {
+      void *e = wheel_extract_min(m->eventq);
       if (pointer_tag(e) == EVENT_TIMEOUT)
          free(untag_pointer(e, rt_callback_t));
    }
 
-   if (m->root != NULL)
+   if (m->flat != NULL)
+      cleanup_flat(m, m->flat);
+   else if (m->root != NULL)
       cleanup_scope(m, m->root);
 
    for (int i = 0; i < MAX_THREADS; i++) {
@@ -625,6 +1453,26 @@ void model_free(rt_model_t *m)
          tlab_release(thread->tlab);
    }
 
+   if (m->procwq != NULL)
+      workq_free(m->procwq);
+
+   if (m->profile != NULL)
+      profile_free(m->profile);
+
+   if (m->stopped_profile != NULL)
+      profile_free(m->stopped_profile);
+
+   for (int i = 0; i < m->nbatches; i++)
+      ACLEAR(m->batches[i].schedq);
+   free(m->batches);
+
+   ACLEAR(m->resolveq);
+   free(m->resolvetasks.tasks);
+   free(m->resolvebuf);
+
+   if (m->splitplans != NULL)
+      hash_free(m->splitplans);
+
    free(m->procq.tasks);
    free(m->next_procq.tasks);
    free(m->postponedq.tasks);
@@ -641,6 +1489,9 @@ void model_free(rt_model_t *m)
       free(it);
    }
 
+   for (int i = 0; i < m->n_watch_batches; i++)
+      ACLEAR(m->watchq[i].watches);
+
    for (int i = 0; i < ARRAY_LEN(m->phase_cbs); i++) {
       for (rt_callback_t *it = m->phase_cbs[i], *tmp; it; it = tmp) {
          tmp = it->next;
@@ -653,9 +1504,9 @@ void model_free(rt_model_t *m)
       nvc_munmap(mb, mb->limit + MEMBLOCK_ALIGN);
    }
 
-   heap_free(m->effective_heap);
-   heap_free(m->driving_heap);
-   heap_free(m->eventq_heap);
+   rankq_free(m->effective_queue);
+   rankq_free(m->driving_queue);
+   wheel_free(m->eventq);
    hash_free(m->scopes);
    ihash_free(m->res_memo);
    ACLEAR(m->eventsigs);
@@ -667,8 +1518,74 @@ bool is_signal_scope(rt_scope_t *s)
    return s->kind == SCOPE_RECORD || s->kind == SCOPE_ARRAY;
 }
 
+static void scope_index_put(hash_t *h, tree_t where, void *value)
+{
+   // Keep the first object with a given tree to match a linear search
+   if (hash_get(h, where) == NULL)
+      hash_put(h, where, value);
+}
+
+static scope_index_t *get_scope_index(rt_scope_t *scope)
+{
+   scope_index_t *index = scope->index;
+   if (index == NULL) {
+      const int total = scope->signals.count + scope->aliases.count
+         + scope->procs.count + scope->children.count;
+      if (total < SCOPE_INDEX_MIN)
+         return NULL;
+
+      index = scope->index = xcalloc(sizeof(scope_index_t));
+      index->objects  = hash_new(total * 2);
+      index->children = hash_new(scope->children.count * 2 + 16);
+   }
+
+   // The object lists only ever grow so add any new entries since the
+   // last lookup
+   for (; index->nsignals < scope->signals.count; index->nsignals++) {
+      rt_signal_t *s = scope->signals.items[index->nsignals];
+      scope_index_put(index->objects, s->where, tag_pointer(s, INDEX_SIGNAL));
+   }
+
+   for (; index->naliases < scope->aliases.count; index->naliases++) {
+      rt_alias_t *a = scope->aliases.items[index->naliases];
+      scope_index_put(index->objects, a->where, tag_pointer(a, INDEX_ALIAS));
+   }
+
+   for (; index->nprocs < scope->procs.count; index->nprocs++) {
+      rt_proc_t *p = scope->procs.items[index->nprocs];
+      scope_index_put(index->objects, p->where, tag_pointer(p, INDEX_PROC));
+   }
+
+   for (; index->nchildren < scope->children.count; index->nchildren++) {
+      rt_scope_t *s = scope->children.items[index->nchildren];
+      scope_index_put(index->children, s->where, s);
+   }
+
+   return index;
+}
+
 rt_signal_t *find_signal(rt_scope_t *scope, tree_t decl, uint32_t *offset)
 {
+   scope_index_t *index = get_scope_index(scope);
+   if (index != NULL) {
+      void *ptr = hash_get(index->objects, decl);
+      switch (pointer_tag(ptr)) {
+      case INDEX_SIGNAL:
+         if (offset != NULL)
+            *offset = 0;
+         return untag_pointer(ptr, rt_signal_t);
+      case INDEX_ALIAS:
+         {
+            rt_alias_t *a = untag_pointer(ptr, rt_alias_t);
+            if (offset != NULL)
+               *offset = a->offset;
+            return a->signal;
+         }
+      default:
+         return NULL;
+      }
+   }
+
    for (int i = 0; i < scope->signals.count; i++) {
       if (scope->signals.items[i]->where == decl) {
          if (offset != NULL)
@@ -690,6 +1607,15 @@ rt_signal_t *find_signal(rt_scope_t *scope, tree_t decl, uint32_t *offset)
 
 rt_proc_t *find_proc(rt_scope_t *scope, tree_t proc)
 {
+   scope_index_t *index = get_scope_index(scope);
+   if (index != NULL) {
+      void *ptr = hash_get(index->objects, proc);
+      if (pointer_tag(ptr) == INDEX_PROC)
+         return untag_pointer(ptr, rt_proc_t);
+      else
+         return NULL;
+   }
+
    for (int i = 0; i < scope->procs.count; i++) {
       if (scope->procs.items[i]->where == proc)
          return scope->procs.items[i];
@@ -798,6 +1724,10 @@ rt_scope_t *root_scope(rt_model_t *m)
 
 rt_scope_t *child_scope(rt_scope_t *scope, tree_t decl)
 {
+   scope_index_t *index = get_scope_index(scope);
+   if (index != NULL)
+      return hash_get(index->children, decl);
+
    for (int i = 0; i < scope->children.count; i++) {
       rt_scope_t *s = scope->children.items[i];
       if (s->where == decl)
@@ -858,15 +1788,16 @@ static void deltaq_insert_proc(rt_model_t *m, uint64_t delta, rt_proc_t *proc)
 {
    if (delta == 0) {
       set_pending(&proc->wakeable);
-      deferq_do(&m->procq, async_run_process, proc);
+      sched_do(m, &m->procq, async_run_process, proc);
       m->next_is_delta = true;
    }
    else {
       assert(!proc->wakeable.delayed);
       proc->wakeable.delayed = true;
+      proc->timeout = m->now + delta;
 
       void *e = tag_pointer(proc, EVENT_PROCESS);
-      heap_insert(m->eventq_heap, m->now + delta, e);
+      eventq_insert(m, m->now + delta, e);
    }
 }
 
@@ -874,18 +1805,18 @@ static void deltaq_insert_driver(rt_model_t *m, uint64_t delta,
                                  rt_source_t *source)
 {
    if (delta == 0) {
-      deferq_do(&m->driverq, async_update_driver, source);
+      sched_do(m, &m->driverq, async_update_driver, source);
       m->next_is_delta = true;
    }
    else {
       void *e = tag_pointer(source, EVENT_DRIVER);
-      heap_insert(m->eventq_heap, m->now + delta, e);
+      eventq_insert(m, m->now + delta, e);
    }
 }
 
 static void deltaq_insert_pseudo_source(rt_model_t *m, rt_source_t *src)
 {
-   deferq_do(&m->driverq, async_pseudo_source, src);
+   sched_do(m, &m->driverq, async_pseudo_source, src);
    m->next_is_delta = true;
 }
 
@@ -981,10 +1912,26 @@ static void run_process(rt_model_t *m, rt_proc_t *proc)
    };
    jit_scalar_t result;
 
+   const uint64_t start_ns = m->profile ? get_timestamp_ns() : 0;
+
+   nvc_hwcount_t hw_start;
+   const bool hw = unlikely(m->profile != NULL) && m->profile->counters
+      && nvc_hwcount(&hw_start);
+
    if (!jit_call_closure(m->jit, &proc->closure, &result, state,
                          proc->tlab ?: thread->tlab))
       m->force_stop = true;
 
+   prof_rec_t *rec;
+   if (unlikely(m->profile != NULL) && (rec = proc->profile) != NULL) {
+      relaxed_add(&rec->time_ns, get_timestamp_ns() - start_ns);
+      relaxed_add(&rec->calls, 1);
+
+      nvc_hwcount_t hw_end;
+      if (hw && nvc_hwcount(&hw_end))
+         profile_add_counters(&(rec->hw), &hw_start, &hw_end);
+   }
+
    if (proc->tlab != NULL && result.pointer == NULL) {
       tlab_release(proc->tlab);
       proc->tlab = NULL;
@@ -1002,16 +1949,116 @@ static void run_process(rt_model_t *m, rt_proc_t *proc)
    thread->active_scope = NULL;
 }
 
-static void reset_scope(rt_model_t *m, rt_scope_t *s)
+static void group_properties(rt_model_t *m, rt_scope_t *s)
+{
+   // Properties in the same scope with an identical clock trigger are
+   // woken by the same events so only the first needs to be scheduled
+   for (int i = 1; i < s->properties.count; i++) {
+      rt_prop_t *p = s->properties.items[i];
+      if (p->wakeable.trigger == NULL)
+         continue;
+
+      for (int j = 0; j < i; j++) {
+         rt_prop_t *leader = s->properties.items[j];
+         if (leader->follower)
+            continue;
+         else if (leader->wakeable.trigger != p->wakeable.trigger)
+            continue;
+
+         rt_prop_t **tail = &(leader->group);
+         for (; *tail; tail = &((*tail)->group))
+            ;
+
+         TRACE("property %s shares clock with %s", istr(p->name),
+               istr(leader->name));
+
+         *tail = p;
+         p->follower = true;
+         break;
+      }
+   }
+}
+
+static void precompile_scope(rt_model_t *m, rt_scope_t *s)
+{
+   // Queue units in the reverse of the order they are reset so the
+   // background threads and the main thread work from opposite ends
+   for (int i = s->properties.count - 1; i >= 0; i--)
+      jit_precompile(m->jit, s->properties.items[i]->handle);
+
+   for (int i = s->procs.count - 1; i >= 0; i--)
+      jit_precompile(m->jit, s->procs.items[i]->closure.handle);
+
+   for (int i = s->children.count - 1; i >= 0; i--)
+      precompile_scope(m, s->children.items[i]);
+}
+
+static void count_flat(rt_scope_t *s, flat_design_t *f)
 {
    for (int i = 0; i < s->children.count; i++)
-      reset_scope(m, s->children.items[i]);
+      count_flat(s->children.items[i], f);
+
+   f->nscopes++;
+   f->nprocs += s->procs.count;
+   f->nsignals += s->signals.count;
+}
+
+static void fill_flat(rt_scope_t *s, flat_design_t *f)
+{
+   for (int i = 0; i < s->children.count; i++)
+      fill_flat(s->children.items[i], f);
+
+   flat_scope_t *fs = &(f->scopes[f->nscopes++]);
+   fs->scope        = s;
+   fs->first_proc   = f->nprocs;
+   fs->nprocs       = s->procs.count;
+   fs->first_signal = f->nsignals;
+   fs->nsignals     = s->signals.count;
 
    for (int i = 0; i < s->procs.count; i++)
-      reset_process(m, s->procs.items[i]);
+      f->procs[f->nprocs++] = s->procs.items[i];
+
+   for (int i = 0; i < s->signals.count; i++)
+      f->signals[f->nsignals++] = s->signals.items[i];
+}
 
-   for (int i = 0; i < s->properties.count; i++)
-      reset_property(m, s->properties.items[i]);
+static flat_design_t *build_flat(rt_scope_t *root)
+{
+   // Lay out the hierarchy in post-order as contiguous records so that
+   // resetting and freeing the design avoids chasing the scope tree
+   flat_design_t *f = xcalloc(sizeof(flat_design_t));
+   count_flat(root, f);
+
+   f->scopes  = xcalloc_array(f->nscopes, sizeof(flat_scope_t));
+   f->procs   = xcalloc_array(MAX(f->nprocs, 1), sizeof(rt_proc_t *));
+   f->signals = xcalloc_array(MAX(f->nsignals, 1), sizeof(rt_signal_t *));
+
+   f->nscopes = f->nprocs = f->nsignals = 0;
+   fill_flat(root, f);
+
+   return f;
+}
+
+static void reset_design(rt_model_t *m, flat_design_t *f)
+{
+   for (int i = 0; i < f->nscopes; i++) {
+      const flat_scope_t *fs = &(f->scopes[i]);
+
+      for (int j = 0; j < fs->nprocs; j++)
+         reset_process(m, f->procs[fs->first_proc + j]);
+
+      rt_scope_t *s = fs->scope;
+      for (int j = 0; j < s->properties.count; j++)
+         reset_property(m, s->properties.items[j]);
+
+      group_properties(m, s);
+   }
+}
+
+static bool is_foldable_resolution(ident_t name)
+{
+   static const char prefix[] = "IEEE.STD_LOGIC_1164.RESOLVED(";
+   return strncmp(istr(name), prefix, sizeof(prefix) - 1) == 0;
 }
 
 static res_memo_t *memo_resolution_fn(rt_model_t *m, rt_signal_t *signal,
@@ -1024,7 +2071,7 @@ static res_memo_t *memo_resolution_fn(rt_model_t *m, rt_signal_t *signal,
    if (memo != NULL)
       return memo;
 
-   memo = static_alloc(m, sizeof(res_memo_t));
+   memo = static_alloc(m, sizeof(res_memo_t), MEM_OTHER);
    memo->flags = flags;
 
    assert(closure->nargs == 1);
@@ -1069,10 +2116,44 @@ static res_memo_t *memo_resolution_fn(rt_model_t *m, rt_signal_t *signal,
 
    if (model_exit_status(m) == 0) {
       memo->flags |= R_MEMO;
+      memo->nlits = nlits;
       if (identity)
          memo->flags |= R_IDENT;
    }
 
+   // If the two value table is commutative and associative and agrees
+   // with the function for all three value cases then the result for
+   // more than two drivers can be computed by folding the table.  This
+   // cannot prove anything about four or more drivers so it is only
+   // done for the IEEE resolution function which is known to reduce
+   // pairwise.
+
+   bool fold = !!(memo->flags & R_MEMO)
+      && is_foldable_resolution(jit_get_name(m->jit, closure->handle));
+   for (int i = 0; fold && i < nlits; i++) {
+      for (int j = 0; fold && j < nlits; j++) {
+         fold = memo->tab2[i][j] == memo->tab2[j][i];
+         for (int k = 0; fold && k < nlits; k++)
+            fold = memo->tab2[memo->tab2[i][j]][k]
+               == memo->tab2[i][memo->tab2[j][k]];
+      }
+   }
+
+   for (int i = 0; fold && i < nlits; i++) {
+      for (int j = 0; fold && j < nlits; j++) {
+         for (int k = 0; fold && k < nlits; k++) {
+            int8_t args[3] = { i, j, k };
+            jit_scalar_t result;
+            fold = jit_try_call(m->jit, memo->closure.handle, &result,
+                                memo->closure.args[0], args, 3)
+               && result.integer == memo->tab2[memo->tab2[i][j]][k];
+         }
+      }
+   }
+
+   if (fold)
+      memo->flags |= R_FOLD;
+
    TRACE("memoised resolution function %pi for type %pT",
          jit_get_name(m->jit, closure->handle), tree_type(signal->where));
 
@@ -1084,6 +2165,67 @@ static res_memo_t *memo_resolution_fn(rt_model_t *m, rt_signal_t *signal,
    return memo;
 }
 
+static res_cache_t *res_cache_slot(rt_model_t *m, res_memo_t *r,
+                                   const void *key, size_t keylen, int nargs)
+{
+   // Resolution functions are pure so the result can be reused for
+   // any later call with exactly the same driving values
+   if ((r->flags & R_NOCACHE) || keylen > RES_CACHE_BYTES)
+      return NULL;
+   else if (m->in_parallel)
+      return NULL;   // Cache is not safe to update from worker threads
+
+   if (r->cache == NULL) {
+      const size_t bytes = RES_CACHE_SIZE * sizeof(res_cache_t);
+      r->cache = static_alloc(m, bytes, MEM_OTHER);
+      memset(r->cache, '\0', bytes);
+   }
+
+   uint64_t hash = nargs;
+   for (size_t i = 0; i < keylen; i += 8) {
+      uint64_t word = 0;
+      memcpy(&word, key + i, MIN(8, keylen - i));
+      hash = mix_bits_64(hash ^ word);
+   }
+
+   return &(r->cache[hash % RES_CACHE_SIZE]);
+}
+
+static const void *res_cache_get(res_memo_t *r, res_cache_t *slot,
+                                 const void *key, size_t keylen, int nargs,
+                                 size_t vallen)
+{
+   if (slot == NULL)
+      return NULL;
+   else if (slot->nargs == nargs && slot->keylen == keylen
+            && slot->vallen == vallen && memcmp(slot->key, key, keylen) == 0) {
+      r->hits++;
+      return slot->value;
+   }
+
+   // Stop caching if the driving values rarely repeat
+   if ((++r->misses % 1024) == 0 && r->hits < r->misses / 4) {
+      TRACE("disable resolution cache for %pi after %u hits",
+            jit_get_name(get_model()->jit, r->closure.handle), r->hits);
+      r->flags |= R_NOCACHE;
+   }
+
+   return NULL;
+}
+
+static void res_cache_put(res_cache_t *slot, const void *key, size_t keylen,
+                          int nargs, const void *value, size_t vallen)
+{
+   if (slot == NULL || vallen > RES_CACHE_BYTES)
+      return;
+
+   slot->nargs  = nargs;
+   slot->keylen = keylen;
+   slot->vallen = vallen;
+   memcpy(slot->key, key, keylen);
+   memcpy(slot->value, value, vallen);
+}
+
 static inline void *nexus_effective(rt_nexus_t *n)
 {
    return n->signal->shared.data + n->offset;
@@ -1117,7 +2259,7 @@ static rt_value_t alloc_value(rt_model_t *m, rt_nexus_t *n)
          n->free_value = *(void **)result.ext;
       }
       else
-         result.ext = static_alloc(m, valuesz);
+         result.ext = static_alloc(m, valuesz, MEM_VALUE);
    }
 
    return result;
@@ -1238,7 +2380,7 @@ static rt_source_t *add_source(rt_model_t *m, rt_nexus_t *n, source_kind_t kind)
       rt_source_t **p;
       for (p = &(n->sources.chain_input); *p; p = &((*p)->chain_input))
          ;
-      *p = src = static_alloc(m, sizeof(rt_source_t));
+      *p = src = static_alloc(m, sizeof(rt_source_t), MEM_SOURCE);
    }
 
    // The only interesting values of n_sources are 0, 1, and 2
@@ -1286,123 +2428,100 @@ static rt_source_t *add_source(rt_model_t *m, rt_nexus_t *n, source_kind_t kind)
    return src;
 }
 
-static inline int map_index(rt_index_t *index, unsigned offset)
-{
-   if (likely(index->how >= 0))
-      return offset >> index->how;
-   else
-      return offset / -(index->how);
-}
-
-static inline int unmap_index(rt_index_t *index, unsigned key)
-{
-   if (likely(index->how >= 0))
-      return key << index->how;
-   else
-      return key * -(index->how);
-}
-
-static inline bool index_valid(rt_index_t *index, unsigned offset)
-{
-   if (likely(index->how >= 0))
-      return (offset >> index->how) << index->how == offset;
-   else
-      return offset % -(index->how) == 0;
-}
-
 static void build_index(rt_signal_t *signal)
 {
-   const unsigned signal_w = signal->shared.size / signal->nexus.size;
+   TRACE("create index for signal %pi count=%d",
+         tree_ident(signal->where), signal->n_nexus);
+
+   rt_index_t *index = xcalloc(sizeof(rt_index_t));
+   index->count   = signal->n_nexus;
+   index->limit   = next_power_of_2(signal->n_nexus);
+   index->offsets = xmalloc_array(index->limit, sizeof(uint32_t));
+   index->nexus   = xmalloc_array(index->limit, sizeof(rt_nexus_t *));
 
-   int shift = INT_MAX, gcd = 0;
    rt_nexus_t *n = &(signal->nexus);
    for (int i = 0, offset = 0; i < signal->n_nexus;
         i++, offset += n->width, n = n->chain) {
-      if (offset > 0) {
-         const int tzc = __builtin_ctz(offset);
-         shift = MIN(shift, tzc);
-      }
-
-      // Compute greatest common divisor
-      for (int b = offset; b > 0;) {
-         int temp = b;
-         b = gcd % b;
-         gcd = temp;
-      }
+      index->offsets[i] = offset;
+      index->nexus[i] = n;
    }
 
-   const int how = gcd > 1 && gcd > (1 << shift) && gcd > 1 ? -gcd : shift;
-   const int count =
-      how < 0 ? (signal_w - how - 1) / -how : (signal_w >> shift) + 1;
-
-   TRACE("create index for signal %pi how=%d count=%d",
-         tree_ident(signal->where), how, count);
+   free_index(signal->index);
+   signal->index = index;
+}
 
-   rt_index_t *index = xcalloc_flex(sizeof(rt_index_t), count,
-                                    sizeof(rt_nexus_t *));
-   index->how = how;
+static int search_index(rt_index_t *index, unsigned offset)
+{
+   // Dense prefix where every element up to this offset has its own
+   // nexus such as for a bus driven bit by bit
+   if (offset < index->count && index->offsets[offset] == offset)
+      return offset;
 
-   n = &(signal->nexus);
-   for (int i = 0, offset = 0; i < signal->n_nexus;
-        i++, offset += n->width, n = n->chain) {
-      index->nexus[map_index(index, offset)] = n;
+   // Find the last nexus starting at or before offset
+   int low = 0, high = index->count - 1;
+   while (low < high) {
+      const int mid = (low + high + 1) / 2;
+      if (index->offsets[mid] <= offset)
+         low = mid;
+      else
+         high = mid - 1;
    }
 
-   free(signal->index);
-   signal->index = index;
+   return low;
 }
 
 static void update_index(rt_signal_t *s, rt_nexus_t *n)
 {
+   rt_index_t *index = s->index;
    const unsigned offset = n->offset / n->size;
 
-   if (!index_valid(s->index, offset)) {
-      TRACE("rebuild index for %pi offset=%d how=%d",
-            tree_ident(s->where), offset, s->index->how);
-      build_index(s);
-      assert(s->index->nexus[map_index(s->index, offset)] == n);
-   }
-   else {
-      const int elt = map_index(s->index, offset);
-      assert(s->index->nexus[elt] == NULL);
-      s->index->nexus[elt] = n;
+   if (index->count == index->limit) {
+      index->limit *= 2;
+      index->offsets = xrealloc_array(index->offsets, index->limit,
+                                      sizeof(uint32_t));
+      index->nexus = xrealloc_array(index->nexus, index->limit,
+                                    sizeof(rt_nexus_t *));
    }
+
+   const int pos = search_index(index, offset) + 1;
+   assert(index->offsets[pos - 1] < offset);
+
+   const int tail = index->count - pos;
+   memmove(index->offsets + pos + 1, index->offsets + pos,
+           tail * sizeof(uint32_t));
+   memmove(index->nexus + pos + 1, index->nexus + pos,
+           tail * sizeof(rt_nexus_t *));
+
+   index->offsets[pos] = offset;
+   index->nexus[pos] = n;
+   index->count++;
 }
 
 static rt_nexus_t *lookup_index(rt_signal_t *s, int *offset)
 {
-   if (likely(offset == 0 || s->index == NULL))
+   if (likely(*offset == 0 || s->index == NULL))
       return &(s->nexus);
-   else if (!index_valid(s->index, *offset)) {
-      TRACE("invalid index for %pi offset=%d how=%d", tree_ident(s->where),
-            *offset, s->index->how);
-      free(s->index);
-      s->index = NULL;
-      return &(s->nexus);
-   }
    else {
-      const int key = map_index(s->index, *offset);
-      for (int k = key; k >= 0; k--) {
-         rt_nexus_t *n = s->index->nexus[k];
-         if (n != NULL) {
-            *offset = unmap_index(s->index, key - k);
-            return n;
-         }
-      }
-      return &(s->nexus);
+      const int pos = search_index(s->index, *offset);
+      *offset -= s->index->offsets[pos];
+      return s->index->nexus[pos];
    }
 }
 
 static waveform_t *alloc_waveform(rt_model_t *m)
 {
    model_thread_t *thread = model_thread(m);
+   thread->live_waveforms++;
 
    if (thread->free_waveforms == NULL) {
       // Ensure waveforms are always within one cache line
       STATIC_ASSERT(sizeof(waveform_t) <= 32);
-      char *mem = static_alloc(m, WAVEFORM_CHUNK * 32);
-      for (int i = 1; i < WAVEFORM_CHUNK; i++)
-         free_waveform(m, (waveform_t *)(mem + i*32));
+      char *mem = static_alloc(m, WAVEFORM_CHUNK * 32, MEM_WAVEFORM);
+      for (int i = 1; i < WAVEFORM_CHUNK; i++) {
+         waveform_t *w = (waveform_t *)(mem + i*32);
+         w->next = thread->free_waveforms;
+         thread->free_waveforms = w;
+      }
 
       return (waveform_t *)mem;
    }
@@ -1487,7 +2606,7 @@ static void clone_source(rt_model_t *m, rt_nexus_t *nexus,
          if ((nexus->flags & NET_F_FAST_DRIVER) && old->fastqueued) {
             rt_nexus_t *n0 = &(nexus->signal->nexus);
             if (!n0->sources.sigqueued)
-               deferq_do(&m->driverq, async_fast_driver, new);
+               sched_do(m, &m->driverq, async_fast_driver, new);
             new->fastqueued = 1;
          }
 
@@ -1536,7 +2655,7 @@ static rt_nexus_t *clone_nexus(rt_model_t *m, rt_nexus_t *old, int offset)
    if (signal->n_nexus == 2 && (old->flags & NET_F_FAST_DRIVER))
       signal->shared.flags |= NET_F_FAST_DRIVER;
 
-   rt_nexus_t *new = static_alloc(m, sizeof(rt_nexus_t));
+   rt_nexus_t *new = static_alloc(m, sizeof(rt_nexus_t), MEM_NEXUS);
    new->width        = old->width - offset;
    new->size         = old->size;
    new->signal       = signal;
@@ -1603,7 +2722,7 @@ static rt_nexus_t *clone_nexus(rt_model_t *m, rt_nexus_t *old, int offset)
 
       case SOURCE_ACTIVE:
          {
-            rt_source_t *src = static_alloc(m, sizeof(rt_source_t));
+            rt_source_t *src = static_alloc(m, sizeof(rt_source_t), MEM_SOURCE);
             src->tag          = SOURCE_ACTIVE;
             src->chain_output = new->outputs;
             src->u.wakeable   = old_o->u.wakeable;
@@ -1679,12 +2798,16 @@ static void setup_signal(rt_model_t *m, rt_signal_t *s, tree_t where,
    s->n_nexus = 1;
    s->offset  = offset;
    s->parent  = parent;
+   s->profile = 0;
 
    s->shared.flags = flags;
    s->shared.size  = count * size;
 
    APUSH(parent->signals, s);
 
+   if (m->profile != NULL)
+      profile_add_signal(m->profile, s);
+
    s->nexus.width        = count;
    s->nexus.size         = size;
    s->nexus.n_sources    = 0;
@@ -1702,6 +2825,203 @@ static void setup_signal(rt_model_t *m, rt_signal_t *s, tree_t where,
    m->n_signals++;
 }
 
+static void apply_split_plan(rt_model_t *m, rt_signal_t *s,
+                             const split_plan_t *plan)
+{
+   // The signal has no sources or outputs yet so the nexuses can be
+   // carved out directly without the cost of clone_nexus
+
+   rt_nexus_t *n = &(s->nexus);
+   assert(n->width == plan->length);
+   assert(n->chain == NULL);
+
+   for (int i = 0; i < plan->count - 1; i++) {
+      rt_nexus_t *new = static_alloc(m, sizeof(rt_nexus_t), MEM_NEXUS);
+      *new = *n;
+      new->width  = n->width - plan->widths[i];
+      new->offset = n->offset + plan->widths[i] * n->size;
+
+      n->width = plan->widths[i];
+      n->chain = new;
+      n = new;
+   }
+
+   assert(n->width == plan->widths[plan->count - 1]);
+
+   m->nexus_tail = &(n->chain);
+   s->n_nexus = plan->count;
+
+   if (s->nexus.flags & NET_F_FAST_DRIVER)
+      s->shared.flags |= NET_F_FAST_DRIVER;
+
+   if (s->n_nexus >= NEXUS_INDEX_MIN)
+      build_index(s);
+}
+
+static void plan_split_prefix(hash_t *builders, tree_t prefix)
+{
+   const tree_kind_t kind = tree_kind(prefix);
+   if (kind != T_ARRAY_REF && kind != T_ARRAY_SLICE)
+      return;
+
+   tree_t value = tree_value(prefix);
+   if (tree_kind(value) != T_REF || !tree_has_ref(value))
+      return;
+
+   plan_builder_t *pb = hash_get(builders, tree_ref(value));
+   if (pb == NULL)
+      return;
+
+   int64_t low, high;
+   if (kind == T_ARRAY_REF) {
+      if (tree_params(prefix) != 1)
+         return;
+      else if (!folded_int(tree_value(tree_param(prefix, 0)), &low))
+         return;
+
+      high = low;
+   }
+   else if (!folded_bounds(tree_range(prefix, 0), &low, &high) || high < low)
+      return;
+
+   int64_t first, last;
+   if (pb->dir == RANGE_TO)
+      first = low - pb->left, last = high - pb->left;
+   else
+      first = pb->left - high, last = pb->left - low;
+
+   if (first < 0 || last >= pb->length)
+      return;
+
+   if (first > 0)
+      mask_set(&pb->points, first);
+   if (last + 1 < pb->length)
+      mask_set(&pb->points, last + 1);
+}
+
+static void plan_add_signal(hash_t *builders, tree_t decl)
+{
+   type_t type = tree_type(decl);
+   if (!type_is_array(type) || dimension_of(type) != 1)
+      return;
+   else if (!type_is_scalar(type_elem(type)))
+      return;
+
+   tree_t r = range_of(type, 0);
+
+   int64_t length, left;
+   if (!folded_length(r, &length) || length < 2 || length > INT32_MAX)
+      return;
+   else if (!folded_int(tree_left(r), &left))
+      return;
+
+   const range_kind_t dir = tree_subkind(r);
+   if (dir != RANGE_TO && dir != RANGE_DOWNTO)
+      return;
+
+   plan_builder_t *pb = xcalloc(sizeof(plan_builder_t));
+   pb->left   = left;
+   pb->length = length;
+   pb->dir    = dir;
+   mask_init(&pb->points, length);
+
+   hash_put(builders, decl, pb);
+}
+
+void model_plan_splits(rt_model_t *m, tree_t block)
+{
+   // Signals which are sliced in several places are otherwise split
+   // lazily as each driver and port map is added during reset which
+   // often has to clone the nexuses on the other side of port maps too
+
+   hash_t *builders = hash_new(64);
+
+   const int nports = tree_ports(block);
+   for (int i = 0; i < nports; i++) {
+      tree_t p = tree_port(block, i);
+      if (tree_class(p) == C_SIGNAL)
+         plan_add_signal(builders, p);
+   }
+
+   const int ndecls = tree_decls(block);
+   for (int i = 0; i < ndecls; i++) {
+      tree_t d = tree_decl(block, i);
+      if (tree_kind(d) == T_SIGNAL_DECL)
+         plan_add_signal(builders, d);
+   }
+
+   if (hash_members(builders) == 0) {
+      hash_free(builders);
+      return;
+   }
+
+   driver_set_t *ds = find_drivers(block);
+
+   const void *key;
+   void *value;
+   for (hash_iter_t it = HASH_BEGIN; hash_iter(builders, &it, &key, &value); ) {
+      for (driver_info_t *di = get_drivers(ds, (tree_t)key);
+           di; di = di->chain_decl)
+         plan_split_prefix(builders, di->prefix);
+   }
+
+   free_drivers(ds);
+
+   const int nstmts = tree_stmts(block);
+   for (int i = 0; i < nstmts; i++) {
+      tree_t s = tree_stmt(block, i);
+      if (tree_kind(s) != T_INSTANCE)
+         continue;
+
+      // Inputs are not included in the driver set
+      const int nparams = tree_params(s);
+      for (int j = 0; j < nparams; j++) {
+         tree_t actual = tree_value(tree_param(s, j));
+         switch (tree_kind(actual)) {
+         case T_TYPE_CONV:
+         case T_CONV_FUNC:
+            actual = tree_value(actual);
+            break;
+         default:
+            break;
+         }
+
+         if (tree_kind(actual) == T_ARRAY_REF
+             || tree_kind(actual) == T_ARRAY_SLICE)
+            plan_split_prefix(builders, longest_static_prefix(actual));
+      }
+   }
+
+   for (hash_iter_t it = HASH_BEGIN; hash_iter(builders, &it, &key, &value); ) {
+      plan_builder_t *pb = value;
+
+      const int count = mask_popcount(&pb->points) + 1;
+      if (count > 1) {
+         split_plan_t *plan =
+            static_alloc(m, sizeof(split_plan_t) + count * sizeof(uint32_t),
+                         MEM_OTHER);
+         plan->length = pb->length;
+         plan->count  = count;
+
+         int pos = 0, prev = 0;
+         for (size_t bit = -1; mask_iter(&pb->points, &bit); prev = bit)
+            plan->widths[pos++] = bit - prev;
+         plan->widths[pos++] = pb->length - prev;
+         assert(pos == count);
+
+         if (m->splitplans == NULL)
+            m->splitplans = hash_new(128);
+
+         hash_put(m->splitplans, key, plan);
+      }
+
+      mask_free(&pb->points);
+      free(pb);
+   }
+
+   hash_free(builders);
+}
+
 static void setup_process(rt_proc_t *p, const char *path)
 {
    switch (tree_kind(p->where)) {
@@ -1817,16 +3137,14 @@ static void call_resolution(rt_model_t *m, rt_nexus_t *n, res_memo_t *r,
       void *resolved = tlab_alloc(thread->tlab, n->width * n->size);
       char *p0 = source_value(n, s0);
 
-      for (int j = 0; j < n->width; j++) {
-         const int index = ((uint8_t *)p0)[j];
-         ((int8_t *)resolved)[j] = r->tab1[index];
-      }
+      table_lookup1(r->tab1, (uint8_t *)p0, resolved, n->width);
 
       put_driving(m, n, resolved);
       tlab_trim(thread->tlab, mark);
    }
-   else if ((r->flags & R_MEMO) && nonnull == 2) {
-      // Resolution function has been memoised so do a table lookup
+   else if ((r->flags & R_MEMO) && (nonnull == 2 || (r->flags & R_FOLD))) {
+      // Resolution function has been memoised so do a table lookup,
+      // folding over the remaining sources if there are more than two
 
       model_thread_t *thread = model_thread(m);
       assert(thread->tlab != NULL);
@@ -1835,14 +3153,17 @@ static void call_resolution(rt_model_t *m, rt_nexus_t *n, res_memo_t *r,
 
       void *resolved = tlab_alloc(thread->tlab, n->width * n->size);
 
-      char *p0 = source_value(n, s0), *p1 = NULL;
-      for (rt_source_t *s1 = s0->chain_input;
-           s1 && (p1 = source_value(n, s1)) == NULL;
-           s1 = s1->chain_input)
-         ;
+      const void *acc = source_value(n, s0);
+      for (rt_source_t *s = s0->chain_input; s; s = s->chain_input) {
+         const void *p = source_value(n, s);
+         if (p == NULL)
+            continue;
 
-      for (int j = 0; j < n->width; j++)
-         ((int8_t *)resolved)[j] = r->tab2[(int)p0[j]][(int)p1[j]];
+         table_lookup2(r->tab2, r->nlits, acc, p, resolved, n->width);
+         acc = resolved;
+      }
+
+      assert(acc == resolved);
 
       put_driving(m, n, resolved);
       tlab_trim(thread->tlab, mark);
@@ -1864,14 +3185,26 @@ static void call_resolution(rt_model_t *m, rt_nexus_t *n, res_memo_t *r,
 
       const uint32_t mark = tlab_mark(thread->tlab);
 
-      uint8_t *inputs = tlab_alloc(thread->tlab, nonnull * scope->size);
+      const size_t keylen = nonnull * scope->size;
+      uint8_t *inputs = tlab_alloc(thread->tlab, keylen);
       copy_sub_signal_sources(scope, inputs, scope->size);
 
+      // Each nexus of the composite signal calls the function with the
+      // same inputs so the whole result is cached for the others
+      const ptrdiff_t resoff = n->signal->offset + n->offset - rscope->offset;
+      res_cache_t *slot = res_cache_slot(m, r, inputs, keylen, nonnull);
+      const uint8_t *cached =
+         res_cache_get(r, slot, inputs, keylen, nonnull, rscope->size);
+
       jit_scalar_t result;
-      if (jit_try_call(m->jit, r->closure.handle, &result,
-                       r->closure.args[0], inputs, nonnull))
-         put_driving(m, n, result.pointer + n->signal->offset
-                     + n->offset - rscope->offset);
+      if (cached != NULL)
+         put_driving(m, n, cached + resoff);
+      else if (jit_try_call(m->jit, r->closure.handle, &result,
+                            r->closure.args[0], inputs, nonnull)) {
+         res_cache_put(slot, inputs, keylen, nonnull, result.pointer,
+                       rscope->size);
+         put_driving(m, n, result.pointer + resoff);
+      }
       else
          m->force_stop = true;
 
@@ -1896,11 +3229,24 @@ static void call_resolution(rt_model_t *m, rt_nexus_t *n, res_memo_t *r,
             }                                                           \
             assert(o == nonnull);                                       \
             type *p = (type *)resolved;                                 \
+            res_cache_t *slot =                                         \
+               res_cache_slot(m, r, vals, sizeof(vals), nonnull);       \
+            const void *cached = res_cache_get(r, slot, vals,           \
+                                               sizeof(vals), nonnull,   \
+                                               sizeof(type));           \
             jit_scalar_t result;                                        \
-            if (!jit_try_call(m->jit, r->closure.handle, &result,       \
-                              r->closure.args[0], vals, nonnull))       \
+            if (cached != NULL)                                         \
+               memcpy(&(p[j]), cached, sizeof(type));                   \
+            else if (jit_try_call(m->jit, r->closure.handle, &result,   \
+                                  r->closure.args[0], vals, nonnull)) { \
+               p[j] = result.integer;                                   \
+               res_cache_put(slot, vals, sizeof(vals), nonnull,         \
+                             &(p[j]), sizeof(type));                    \
+            }                                                           \
+            else {                                                      \
                m->force_stop = true;                                    \
-            p[j] = result.integer;                                      \
+               p[j] = result.integer;                                   \
+            }                                                           \
          } while (0)
 
          FOR_ALL_SIZES(n->size, CALL_RESOLUTION_FN);
@@ -2247,7 +3593,7 @@ static void create_processes(rt_model_t *m, rt_scope_t *s)
             ident_t name = tree_ident(t);
             ident_t sym = ident_prefix(sym_prefix, name, '.');
 
-            rt_proc_t *p = xcalloc(sizeof(rt_proc_t));
+            rt_proc_t *p = proc_alloc(m, sizeof(rt_proc_t));
             p->where     = t;
             p->name      = ident_prefix(path, ident_downcase(name), ':');
             p->scope     = s;
@@ -2263,6 +3609,9 @@ static void create_processes(rt_model_t *m, rt_scope_t *s)
             p->wakeable.postponed = !!(tree_flags(t) & TREE_F_POSTPONED);
 
             APUSH(s->procs, p);
+
+            if (m->profile != NULL)
+               profile_add_proc(m->profile, p);
          }
          break;
 
@@ -2306,15 +3655,41 @@ void model_reset(rt_model_t *m)
    m->stop_delta = opt_get_int(OPT_STOP_DELTA);
    m->shuffle    = opt_get_int(OPT_SHUFFLE_PROCS);
 
+   const char *profile = opt_get_str(OPT_RT_PROFILE);
+   if (profile != NULL && m->profile == NULL)
+      m->profile = profile_new(profile);
+
+   const int storm = opt_get_int(OPT_DELTA_REPORT);
+   if (storm > 0 && m->storm == NULL)
+      m->storm = storm_new(storm);
+
+   const int nthreads = opt_get_int(OPT_RT_THREADS);
+#if RT_MULTITHREADED
+   if (nthreads > 1 && m->procwq == NULL) {
+      m->procwq   = workq_new(m);
+      m->nbatches = nthreads * BATCH_PER_CPU;
+      m->batches  = xcalloc_array(m->nbatches, sizeof(proc_batch_t));
+   }
+#else
+   if (nthreads > 1)
+      warnf("parallel process evaluation is not supported by this build "
+            "of %s, configure with $bold$--enable-parallel-sim$$ to "
+            "enable", PACKAGE);
+#endif
+
    __trace_on = opt_get_int(OPT_RT_TRACE);
 
    create_processes(m, m->root);
+   precompile_scope(m, m->root);
 
    nvc_rusage(&m->ready_rusage);
 
    // Initialisation is described in LRM 93 section 12.6.4
 
-   reset_scope(m, m->root);
+   if (m->flat == NULL)
+      m->flat = build_flat(m->root);
+
+   reset_design(m, m->flat);
 
    if (m->force_stop)
       return;   // Error in intialisation
@@ -2345,22 +3720,22 @@ void model_reset(rt_model_t *m)
       }
 
       if (n->rank > 0 || n->n_sources > 1)
-         heap_insert(m->driving_heap, n->rank, n);
+         rankq_insert(m->driving_queue, n->rank, n);
       else {
          calculate_initial_value(m, n);
          check_undriven_std_logic(n);
       }
    }
 
-   while (heap_size(m->driving_heap) > 0) {
-      rt_nexus_t *n = heap_extract_min(m->driving_heap);
+   while (rankq_size(m->driving_queue) > 0) {
+      rt_nexus_t *n = rankq_extract_min(m->driving_queue);
       calculate_initial_value(m, n);
       check_undriven_std_logic(n);
    }
 
    // Update effective values after all initial driving values calculated
-   while (heap_size(m->effective_heap) > 0) {
-      rt_nexus_t *n = heap_extract_min(m->effective_heap);
+   while (rankq_size(m->effective_queue) > 0) {
+      rt_nexus_t *n = rankq_extract_min(m->effective_queue);
       n->flags &= ~NET_F_PENDING;
 
       calculate_effective_value(m, n);
@@ -2375,16 +3750,13 @@ void model_reset(rt_model_t *m)
    run_callbacks(m, END_OF_INITIALISATION);
 }
 
-static void update_property(rt_model_t *m, rt_prop_t *prop)
+static void step_property(rt_model_t *m, rt_prop_t *prop)
 {
    TRACE("update property %pi state %s", prop->name,
          trace_states(&prop->state));
 
    rt_wakeable_t *obj = &(prop->wakeable);
 
-   if (obj->trigger != NULL && !run_trigger(m, obj->trigger))
-      return;   // Filtered
-
    model_thread_t *thread = model_thread(m);
    assert(thread->tlab != NULL);
 
@@ -2422,6 +3794,17 @@ static void update_property(rt_model_t *m, rt_prop_t *prop)
    m->liveness |= prop->strong;
 }
 
+static void update_property(rt_model_t *m, rt_prop_t *prop)
+{
+   rt_wakeable_t *obj = &(prop->wakeable);
+
+   if (obj->trigger != NULL && !run_trigger(m, obj->trigger))
+      return;   // Filtered
+
+   for (rt_prop_t *p = prop; p != NULL; p = p->group)
+      step_property(m, p);
+}
+
 static void sched_event(rt_model_t *m, void **pending, rt_wakeable_t *obj)
 {
    if (*pending == NULL)
@@ -2481,10 +3864,26 @@ static void clear_event(rt_model_t *m, void **pending, rt_wakeable_t *obj)
 
 static rt_source_t *find_driver(rt_nexus_t *nexus, rt_proc_t *proc)
 {
+   // Sources are never removed from a nexus so the driver for a busy
+   // nexus can be cached in the process to avoid walking a long chain
+   const bool use_index = nexus->n_sources >= DRIVER_INDEX_THRESH;
+   if (use_index && proc->drivers != NULL) {
+      rt_source_t *d = ihash_get(proc->drivers, (uintptr_t)nexus);
+      if (d != NULL)
+         return d;
+   }
+
    // Try to find this process in the list of existing drivers
    for (rt_source_t *d = &(nexus->sources); d; d = d->chain_input) {
-      if (d->tag == SOURCE_DRIVER && d->u.driver.proc == proc)
+      if (d->tag == SOURCE_DRIVER && d->u.driver.proc == proc) {
+         if (use_index) {
+            if (proc->drivers == NULL)
+               proc->drivers = ihash_new(16);
+            ihash_put(proc->drivers, (uintptr_t)nexus, d);
+         }
+
          return d;
+      }
    }
 
    return NULL;
@@ -2521,11 +3920,18 @@ static inline bool insert_transaction(rt_model_t *m, rt_nexus_t *nexus,
    // overhead of doing so is probably higher than the cost of waking
    // up for the empty event
    bool already_scheduled = false;
-   for (waveform_t *next; it != NULL; it = next) {
-      next = it->next;
-      already_scheduled |= (it->when == when);
-      free_value(nexus, it->value);
-      free_waveform(m, it);
+   if (it != NULL) {
+      waveform_t *tail = it;
+      int count = 1;
+      for (;; tail = tail->next, count++) {
+         already_scheduled |= (tail->when == when);
+         free_value(nexus, tail->value);
+
+         if (tail->next == NULL)
+            break;
+      }
+
+      free_waveform_list(m, it, tail, count);
    }
 
    return already_scheduled;
@@ -2569,13 +3975,13 @@ static void sched_driver(rt_model_t *m, rt_nexus_t *n, uint64_t after,
          return;
       }
       else if (signal->shared.flags & NET_F_FAST_DRIVER) {
-         deferq_do(&m->driverq, async_fast_all_drivers, signal);
+         sched_do(m, &m->driverq, async_fast_all_drivers, signal);
          m->next_is_delta = true;
          d0->sigqueued = 1;
          d->fastqueued = 1;
       }
       else {
-         deferq_do(&m->driverq, async_fast_driver, d);
+         sched_do(m, &m->driverq, async_fast_driver, d);
          m->next_is_delta = true;
          d->fastqueued = 1;
       }
@@ -2647,6 +4053,55 @@ static void async_watch_callback(rt_model_t *m, void *arg)
       (*w->fn)(m->now, w->signals[0], w, w->user_data);
 }
 
+static bool watchq_do(rt_model_t *m, rt_watch_t *w)
+{
+   // Group pending callbacks by their consumer so that all the value
+   // change callbacks for waves, coverage, etc. run together
+   watch_batch_t *b = NULL;
+   for (int i = 0; i < m->n_watch_batches; i++) {
+      if (m->watchq[i].fn == w->fn) {
+         b = &(m->watchq[i]);
+         break;
+      }
+   }
+
+   if (b == NULL) {
+      if (m->n_watch_batches == WATCH_BATCHES)
+         return false;
+
+      b = &(m->watchq[m->n_watch_batches++]);
+      b->fn = w->fn;
+   }
+
+   APUSH(b->watches, w);
+   set_pending(&(w->wakeable));
+
+   m->next_is_delta |= m->blocking_update;
+   return true;
+}
+
+static void run_watch_batches(rt_model_t *m)
+{
+   for (int i = 0; i < m->n_watch_batches; i++) {
+      watch_batch_t *b = &(m->watchq[i]);
+      const sig_event_fn_t fn = b->fn;
+
+      // Callbacks may wake up other watches so the list can grow
+      for (int j = 0; j < b->watches.count; j++) {
+         rt_watch_t *w = b->watches.items[j];
+         assert(w->wakeable.pending);
+         w->wakeable.pending = false;
+
+         if (w->wakeable.zombie)
+            free(w);
+         else
+            (*fn)(m->now, w->signals[0], w, w->user_data);
+      }
+
+      ATRIM(b->watches, 0);
+   }
+}
+
 static void async_timeout_callback(rt_model_t *m, void *arg)
 {
    rt_callback_t *cb = arg;
@@ -2674,12 +4129,28 @@ static void async_update_property(rt_model_t *m, void *arg)
    update_property(m, prop);
 }
 
-static bool heap_delete_proc_cb(uint64_t key, void *value, void *search)
+static bool is_stale_event(void *e, uint64_t when)
 {
-   if (pointer_tag(value) != EVENT_PROCESS)
+   // A process woken before its timeout expired leaves its entry in
+   // the event queue which is discarded here rather than searching
+   // the whole queue to delete it
+   if (pointer_tag(e) != EVENT_PROCESS)
       return false;
 
-   return untag_pointer(value, rt_proc_t) == search;
+   rt_proc_t *proc = untag_pointer(e, rt_proc_t);
+   return !proc->wakeable.delayed || proc->timeout != when;
+}
+
+static void drop_stale_events(rt_model_t *m)
+{
+   while (wheel_size(m->eventq) > 0) {
+      void *e = wheel_min(m->eventq);
+      if (!is_stale_event(e, wheel_min_key(m->eventq)))
+         break;
+
+      wheel_extract_min(m->eventq);
+      stat_add(STAT_STALE_TIMEOUTS, 1);
+   }
 }
 
 static bool run_trigger(rt_model_t *m, rt_trigger_t *t)
@@ -2710,6 +4181,16 @@ static bool run_trigger(rt_model_t *m, rt_trigger_t *t)
       }
       break;
 
+   case AND_TRIGGER:
+      {
+         rt_trigger_t *left = t->args[0].pointer;
+         rt_trigger_t *right = t->args[1].pointer;
+         t->result.integer = run_trigger(m, left) && run_trigger(m, right);
+
+         TRACE("and trigger %p ==> %"PRIi64, t, t->result.integer);
+      }
+      break;
+
    case CMP_TRIGGER:
       {
          rt_signal_t *s = t->args[0].pointer;
@@ -2750,6 +4231,37 @@ static bool run_trigger(rt_model_t *m, rt_trigger_t *t)
                offset, t->result.integer);
       }
       break;
+
+   case EDGE_TRIGGER:
+      {
+         rt_signal_t *s = t->args[0].pointer;
+         uint32_t offset = t->args[1].integer;
+         int32_t edge = t->args[2].integer;
+
+         t->result.integer = 0;
+
+         rt_nexus_t *n = split_nexus(m, s, offset, 1);
+         if (n->last_event == m->now && n->event_delta == m->iteration) {
+            // Same as IEEE.STD_LOGIC_1164.TO_X01 with 'X' mapped to 2
+            static const uint8_t x01[9] = { 2, 2, 0, 1, 2, 2, 0, 1, 2 };
+
+            const uint8_t *value = nexus_effective(n);
+            const uint8_t *last = nexus_last_value(n);
+            const uint8_t want = (edge & EDGE_RISING) ? 1 : 0;
+
+            if (edge & EDGE_X01) {
+               assert(*value < ARRAY_LEN(x01) && *last < ARRAY_LEN(x01));
+               t->result.integer =
+                  x01[*value] == want && x01[*last] == (want ^ 1);
+            }
+            else
+               t->result.integer = (*value == want);
+         }
+
+         TRACE("edge trigger %pi+%d ==> %"PRIi64, tree_ident(s->where),
+               offset, t->result.integer);
+      }
+      break;
    }
 
    t->epoch = m->trigger_epoch;
@@ -2761,11 +4273,11 @@ static void procq_do(rt_model_t *m, rt_wakeable_t *obj, defer_fn_t fn,
                      void *arg)
 {
    if (obj->postponed)
-      deferq_do(&m->postponedq, fn, arg);
+      sched_do(m, &m->postponedq, fn, arg);
    else if (obj->reschedule)
-      deferq_do(&m->reschedq, fn, arg);
+      sched_do(m, &m->reschedq, fn, arg);
    else {
-      deferq_do(&m->procq, fn, arg);
+      sched_do(m, &m->procq, fn, arg);
       m->next_is_delta |= m->blocking_update;
    }
 
@@ -2774,6 +4286,16 @@ static void procq_do(rt_model_t *m, rt_wakeable_t *obj, defer_fn_t fn,
 
 static void wakeup_one(rt_model_t *m, rt_wakeable_t *obj)
 {
+#if RT_MULTITHREADED
+   if (unlikely(m->in_parallel)) {
+      // Wake up after the parallel region as several threads may
+      // otherwise try to schedule the same object
+      const sched_task_t st = { SCHED_WAKEUP, NULL, { NULL, obj } };
+      APUSH(*model_thread(m)->schedq, st);
+      return;
+   }
+#endif
+
    if (obj->pending)
       return;   // Already scheduled
 
@@ -2784,10 +4306,16 @@ static void wakeup_one(rt_model_t *m, rt_wakeable_t *obj)
          TRACE("%s %sprocess %s", obj->reschedule ? "reschedule" : "wakeup",
                obj->postponed ? "postponed " : "", istr(proc->name));
 
+         stat_add(STAT_WAKEUPS, 1);
+
+         prof_rec_t *rec;
+         if (unlikely(m->profile != NULL) && (rec = proc->profile) != NULL)
+            relaxed_add(&rec->wakeups, 1);
+
          if (proc->wakeable.delayed) {
             // This process was already scheduled to run at a later
-            // time so we need to delete it from the simulation queue
-            heap_delete(m->eventq_heap, heap_delete_proc_cb, proc);
+            // time: its queue entry becomes stale and is dropped when
+            // it reaches the front of the queue
             proc->wakeable.delayed = false;
          }
 
@@ -2798,6 +4326,9 @@ static void wakeup_one(rt_model_t *m, rt_wakeable_t *obj)
    case W_PROPERTY:
       {
          rt_prop_t *prop = container_of(obj, rt_prop_t, wakeable);
+         if (prop->follower)
+            break;   // Updated along with the first property on its clock
+
          TRACE("wakeup property %s", istr(prop->name));
          procq_do(m, obj, async_update_property, prop);
       }
@@ -2810,6 +4341,10 @@ static void wakeup_one(rt_model_t *m, rt_wakeable_t *obj)
                obj->postponed ? "postponed " : "", w, debug_symbol_name(w->fn));
 
          assert(!w->wakeable.zombie);
+
+         if (!obj->postponed && watchq_do(m, w))
+            break;
+
          procq_do(m, obj, async_watch_callback, w);
       }
       break;
@@ -2848,7 +4383,15 @@ static void wakeup_all(rt_model_t *m, void **pending)
    }
    else if (*pending != NULL) {
       rt_pending_t *p = untag_pointer(*pending, rt_pending_t);
-      for (int i = 0; i < p->count; i++) {
+
+      // A clock may have many thousands of processes waiting on it
+      // which are scattered across memory: prefetch the wakeables a
+      // few iterations ahead so the cache misses overlap
+      const int count = p->count;
+      for (int i = 0; i < count; i++) {
+         if (i + WAKEUP_PREFETCH < count)
+            prefetch_read(p->wake[i + WAKEUP_PREFETCH]);
+
          if (p->wake[i] != NULL)
             wakeup_one(m, p->wake[i]);
       }
@@ -2860,6 +4403,13 @@ static void notify_event(rt_model_t *m, rt_nexus_t *n)
    n->last_event = m->now;
    n->event_delta = m->iteration;
 
+   stat_add(STAT_EVENTS, 1);
+
+   prof_rec_t *rec;
+   if (unlikely(m->profile != NULL)
+       && (rec = profile_get_signal(m->profile, n->signal)) != NULL)
+      relaxed_add(&rec->wakeups, 1);
+
    if (n->flags & NET_F_CACHE_EVENT)
       n->signal->shared.flags |= SIG_F_EVENT_FLAG;
 
@@ -2889,7 +4439,7 @@ static void enqueue_effective(rt_model_t *m, rt_nexus_t *n)
       return;
 
    n->flags |= NET_F_PENDING;
-   heap_insert(m->effective_heap, MAX_RANK - n->rank, n);
+   rankq_insert(m->effective_queue, MAX_RANK - n->rank, n);
 }
 
 static void update_effective(rt_model_t *m, rt_nexus_t *n)
@@ -2911,6 +4461,20 @@ static void update_effective(rt_model_t *m, rt_nexus_t *n)
 
 static void put_driving(rt_model_t *m, rt_nexus_t *n, const void *value)
 {
+#if RT_MULTITHREADED
+   if (unlikely(m->in_parallel)) {
+      // Driving values are computed in parallel for all nexuses of the
+      // same rank and then applied in order on the main thread
+      resolve_task_t *rt = model_thread(m)->capture;
+      if (rt != NULL) {
+         assert(rt->nexus == n);
+         memcpy(rt->value, value, n->size * n->width);
+         rt->captured = true;
+         return;
+      }
+   }
+#endif
+
    if (n->flags & NET_F_EFFECTIVE) {
       TRACE("update %s driving value %s", trace_nexus(n), fmt_nexus(n, value));
 
@@ -2919,7 +4483,7 @@ static void put_driving(rt_model_t *m, rt_nexus_t *n, const void *value)
       assert(!(n->flags & NET_F_PENDING));
       n->flags |= NET_F_PENDING;
       n->flags &= ~NET_F_HAS_INITIAL;
-      heap_insert(m->effective_heap, MAX_RANK - n->rank, n);
+      rankq_insert(m->effective_queue, MAX_RANK - n->rank, n);
    }
    else
       put_effective(m, n, value);
@@ -2930,50 +4494,148 @@ static void defer_driving_update(rt_model_t *m, rt_nexus_t *n)
    if (n->flags & NET_F_PENDING)
       return;
 
-   TRACE("defer %s driving value update", trace_nexus(n));
-   heap_insert(m->driving_heap, n->rank, n);
-   n->flags |= NET_F_PENDING;
-}
+   TRACE("defer %s driving value update", trace_nexus(n));
+   rankq_insert(m->driving_queue, n->rank, n);
+   n->flags |= NET_F_PENDING;
+}
+
+static void update_driving(rt_model_t *m, rt_nexus_t *n, bool safe);
+
+static void begin_driving_update(rt_model_t *m, rt_nexus_t *n)
+{
+   n->active_delta = m->iteration;
+   n->flags &= ~NET_F_PENDING;
+
+   // TODO: add an event epoch or similar
+   n->event_delta = DELTA_CYCLE_MAX;
+}
+
+static void end_driving_update(rt_model_t *m, rt_nexus_t *n)
+{
+   // Update output ports if the effective value must be calculated
+   // separately or there was an event on this signal
+   const bool update_output_ports = !!(n->flags & NET_F_EFFECTIVE)
+      || (n->event_delta == m->iteration && n->last_event == m->now);
+
+   for (rt_source_t *o = n->outputs; o; o = o->chain_output) {
+      switch (o->tag) {
+      case SOURCE_PORT:
+         if (update_output_ports)
+            update_driving(m, o->u.port.output, false);
+         break;
+      case SOURCE_ACTIVE:
+         wakeup_one(m, o->u.wakeable);
+         break;
+      default:
+         should_not_reach_here();
+      }
+   }
+}
+
+static void update_driving(rt_model_t *m, rt_nexus_t *n, bool safe)
+{
+   if (n->n_sources == 1 || safe) {
+      begin_driving_update(m, n);
+
+      if (unlikely(m->profile != NULL)) {
+         const uint64_t start_ns = get_timestamp_ns();
+         calculate_driving_value(m, n);
+
+         prof_rec_t *rec = profile_get_signal(m->profile, n->signal);
+         if (rec != NULL) {
+            relaxed_add(&rec->time_ns, get_timestamp_ns() - start_ns);
+            relaxed_add(&rec->calls, 1);
+         }
+      }
+      else
+         calculate_driving_value(m, n);
+
+      end_driving_update(m, n);
+   }
+   else
+      defer_driving_update(m, n);
+}
+
+#if RT_MULTITHREADED
+static void async_resolve_driving(rt_model_t *m, void *arg)
+{
+   resolve_task_t *rt = arg;
+
+   model_thread_t *thread = model_thread(m);
+   thread->capture = rt;
+   calculate_driving_value(m, rt->nexus);
+   thread->capture = NULL;
+}
+
+static void parallel_update_driving(rt_model_t *m)
+{
+   // Nexuses with the same rank cannot depend on each other's driving
+   // values so resolve them all at once across the worker threads
+   const uint64_t rank = rankq_min_key(m->driving_queue);
+
+   size_t bytes = 0;
+   ATRIM(m->resolveq, 0);
+   while (rankq_size(m->driving_queue) > 0
+          && rankq_min_key(m->driving_queue) == rank) {
+      rt_nexus_t *n = rankq_extract_min(m->driving_queue);
+      const resolve_task_t rt = { n, (void *)bytes, false };
+      APUSH(m->resolveq, rt);
+      bytes += ALIGN_UP(n->size * n->width, sizeof(uint64_t));
+   }
+
+   const int count = m->resolveq.count;
+
+   if (count < PARALLEL_MIN) {
+      for (int i = 0; i < count; i++)
+         update_driving(m, m->resolveq.items[i].nexus, true);
+      return;
+   }
+
+   if (bytes > m->resolvesz) {
+      m->resolvesz = MAX(bytes, m->resolvesz * 2);
+      m->resolvebuf = xrealloc(m->resolvebuf, m->resolvesz);
+   }
 
-static void update_driving(rt_model_t *m, rt_nexus_t *n, bool safe)
-{
-   if (n->n_sources == 1 || safe) {
-      n->active_delta = m->iteration;
-      n->flags &= ~NET_F_PENDING;
+   m->resolvetasks.count = 0;
+   for (int i = 0; i < count; i++) {
+      resolve_task_t *rt = &(m->resolveq.items[i]);
+      rt->value = m->resolvebuf + (uintptr_t)rt->value;
+      deferq_do(&m->resolvetasks, async_resolve_driving, rt);
+   }
 
-      // TODO: add an event epoch or similar
-      n->event_delta = DELTA_CYCLE_MAX;
+   const int nbatches = MIN(m->nbatches, count / PARALLEL_MIN + 1);
+   const int per_batch = (count + nbatches - 1) / nbatches;
 
-      calculate_driving_value(m, n);
+   for (int i = 0, first = 0; i < nbatches; i++, first += per_batch) {
+      m->batches[i].tasks = m->resolvetasks.tasks + first;
+      m->batches[i].count = MIN(per_batch, count - first);
+      workq_do(m->procwq, parallel_run_batch, &(m->batches[i]));
+   }
 
-      // Update output ports if the effective value must be calculated
-      // separately or there was an event on this signal
-      const bool update_output_ports = !!(n->flags & NET_F_EFFECTIVE)
-         || (n->event_delta == m->iteration && n->last_event == m->now);
+   m->in_parallel = true;
+   workq_start(m->procwq);
+   workq_drain(m->procwq);
+   m->in_parallel = false;
 
-      for (rt_source_t *o = n->outputs; o; o = o->chain_output) {
-         switch (o->tag) {
-         case SOURCE_PORT:
-            if (update_output_ports)
-               update_driving(m, o->u.port.output, false);
-            break;
-         case SOURCE_ACTIVE:
-            wakeup_one(m, o->u.wakeable);
-            break;
-         default:
-            should_not_reach_here();
-         }
-      }
+   parallel_merge(m, nbatches);
+
+   for (int i = 0; i < count; i++) {
+      const resolve_task_t *rt = &(m->resolveq.items[i]);
+      begin_driving_update(m, rt->nexus);
+      if (rt->captured)
+         put_driving(m, rt->nexus, rt->value);
+      end_driving_update(m, rt->nexus);
    }
-   else
-      defer_driving_update(m, n);
 }
+#endif
 
 static void update_driver(rt_model_t *m, rt_nexus_t *n, rt_source_t *source)
 {
    waveform_t *w_now  = &(source->u.driver.waveforms);
    waveform_t *w_next = w_now->next;
 
+   stat_add(STAT_TRANSACTIONS, 1);
+
    if (likely(w_next != NULL && w_next->when == m->now)) {
       free_value(n, w_now->value);
       *w_now = *w_next;
@@ -3060,6 +4722,93 @@ static void async_pseudo_source(rt_model_t *m, void *arg)
    src->pseudoqueued = 0;
 }
 
+static void nonblock_run(rt_model_t *m)
+{
+   deferq_t *dq = &m->nonblockq;
+
+   // The queue only contains deposits which already hold the final
+   // value written to each nexus in this region so they can be applied
+   // in a single pass without the indirect call through deferq_run
+   const defer_task_t *tasks = dq->tasks;
+   const int count = dq->count;
+   for (int i = 0; i < count; i++) {
+      assert(tasks[i].fn == async_pseudo_source);
+
+      if (i + 1 < count)
+         prefetch_read(tasks[i + 1].arg);
+
+      rt_source_t *src = tasks[i].arg;
+      assert(src->pseudoqueued);
+
+      update_driving(m, src->u.pseudo.nexus, false);
+      src->pseudoqueued = 0;
+   }
+
+   assert(dq->tasks == tasks);
+   assert(dq->count == count);
+
+   dq->count = 0;
+
+   if (m->reschedq.count > 0) {
+      deferq_swap(&m->reschedq, dq);
+      deferq_run(m, dq);
+   }
+}
+
+static void put_driver(rt_model_t *m, rt_nexus_t *n, rt_source_t *d,
+                       const void *value)
+{
+   // Delete any pending transactions
+   for (waveform_t *it = d->u.driver.waveforms.next, *tmp = it;
+        it != NULL; it = tmp) {
+      tmp = it->next;
+      free_value(n, it->value);
+      free_waveform(m, it);
+   }
+   d->u.driver.waveforms.next = NULL;
+
+   copy_value_ptr(n, &d->u.driver.waveforms.value, value);
+
+   d->u.driver.waveforms.when = m->now;
+
+   calculate_driving_value(m, n);
+
+   for (rt_source_t *o = n->outputs; o; o = o->chain_output) {
+      switch (o->tag) {
+      case SOURCE_PORT:
+         defer_driving_update(m, o->u.port.output);
+         m->next_is_delta = true;
+         break;
+      case SOURCE_ACTIVE:
+         wakeup_one(m, o->u.wakeable);
+         break;
+      default:
+         should_not_reach_here();
+      }
+   }
+}
+
+static void async_implicit_transfer(rt_model_t *m, rt_transfer_t *t)
+{
+   rt_nexus_t *n = t->target;
+   assert(n->width == 1 && n->size == 1);
+
+   rt_source_t *d = find_driver(n, t->proc);
+   assert(d != NULL);
+
+   if (t->kind == TRANSFER_TRANSACTION) {
+      const uint8_t toggle = !*(uint8_t *)nexus_effective(n);
+      put_driver(m, n, d, &toggle);
+   }
+   else {
+      // Goes false immediately and back to true after the time
+      // parameter unless there is another event in the meantime
+      const uint8_t false_value = 0, true_value = 1;
+      put_driver(m, n, d, &false_value);
+      sched_driver(m, n, t->after, t->reject, &true_value, t->proc);
+   }
+}
+
 static void async_transfer_signal(rt_model_t *m, void *arg)
 {
    rt_transfer_t *t = arg;
@@ -3067,8 +4816,33 @@ static void async_transfer_signal(rt_model_t *m, void *arg)
    assert(t->wakeable.pending);
    t->wakeable.pending = false;
 
+   if (t->kind >= TRANSFER_STABLE) {
+      async_implicit_transfer(m, t);
+      return;
+   }
+
    rt_nexus_t *n = t->target;
    char *vptr = nexus_effective(t->source);
+
+   if (t->kind != TRANSFER_COPY) {
+      // Inverted scalar such as a clock generator
+      static const uint8_t not_ulogic[9] = { 0, 1, 3, 2, 1, 1, 3, 2, 1 };
+
+      assert(t->count == 1 && n->size == 1);
+      const uint8_t in = *(uint8_t *)vptr;
+
+      uint8_t out;
+      if (t->kind == TRANSFER_NOT)
+         out = !in;
+      else {
+         assert(in < ARRAY_LEN(not_ulogic));
+         out = not_ulogic[in];
+      }
+
+      sched_driver(m, n, t->after, t->reject, &out, t->proc);
+      return;
+   }
+
    for (int count = t->count; count > 0; n = n->chain) {
       count -= n->width;
       assert(count >= 0);
@@ -3089,18 +4863,38 @@ static void async_run_trigger(rt_model_t *m, void *arg)
       wakeup_all(m, &(t->pending));
 }
 
-static void iteration_limit_proc_cb(void *fn, void *arg, void *extra)
+static rt_proc_t *deferred_proc(void *fn, void *arg)
 {
-   diag_t *d = extra;
-   rt_proc_t *proc = NULL;
-
    if (fn == async_run_process)
-      proc = arg;
+      return arg;
    else if (fn == async_transfer_signal) {
       rt_transfer_t *t = arg;
-      proc = t->proc;
+      return t->proc;
+   }
+   else
+      return NULL;
+}
+
+static tree_t deferred_driver(void *fn, void *arg)
+{
+   if (fn == async_update_driver || fn == async_fast_driver) {
+      rt_source_t *src = arg;
+      if (src->tag == SOURCE_DRIVER)
+         return src->u.driver.nexus->signal->where;
+   }
+   else if (fn == async_fast_all_drivers) {
+      rt_signal_t *s = arg;
+      return s->where;
    }
 
+   return NULL;
+}
+
+static void iteration_limit_proc_cb(void *fn, void *arg, void *extra)
+{
+   diag_t *d = extra;
+
+   rt_proc_t *proc = deferred_proc(fn, arg);
    if (proc == NULL)
       return;
 
@@ -3111,18 +4905,8 @@ static void iteration_limit_proc_cb(void *fn, void *arg, void *extra)
 static void iteration_limit_driver_cb(void *fn, void *arg, void *extra)
 {
    diag_t *d = extra;
-   tree_t decl = NULL;
-
-   if (fn == async_update_driver || fn == async_fast_driver) {
-      rt_source_t *src = arg;
-      if (src->tag == SOURCE_DRIVER)
-         decl = src->u.driver.nexus->signal->where;
-   }
-   else if (fn == async_fast_all_drivers) {
-      rt_signal_t *s = arg;
-      decl = s->where;
-   }
 
+   tree_t decl = deferred_driver(fn, arg);
    if (decl == NULL)
       return;
 
@@ -3131,6 +4915,123 @@ static void iteration_limit_driver_cb(void *fn, void *arg, void *extra)
              istr(tree_ident(decl)));
 }
 
+static delta_storm_t *storm_new(unsigned threshold)
+{
+   delta_storm_t *ds = xcalloc(sizeof(delta_storm_t));
+   ds->threshold = threshold;
+   ds->map       = hash_new(128);
+
+   return ds;
+}
+
+static void storm_free(delta_storm_t *ds)
+{
+   for (int i = 0; i < ds->recs.count; i++)
+      free(ds->recs.items[i]);
+   ACLEAR(ds->recs);
+
+   hash_free(ds->map);
+   free(ds);
+}
+
+static void storm_count(delta_storm_t *ds, rt_proc_t *proc, tree_t decl)
+{
+   const void *key = proc ?: (void *)decl;
+
+   storm_rec_t *rec = hash_get(ds->map, key);
+   if (rec == NULL) {
+      rec = xcalloc(sizeof(storm_rec_t));
+      rec->proc = proc;
+      rec->decl = decl;
+
+      hash_put(ds->map, key, rec);
+      APUSH(ds->recs, rec);
+   }
+
+   rec->samples++;
+}
+
+static void storm_proc_cb(void *fn, void *arg, void *extra)
+{
+   rt_proc_t *proc = deferred_proc(fn, arg);
+   if (proc != NULL)
+      storm_count(extra, proc, NULL);
+}
+
+static void storm_driver_cb(void *fn, void *arg, void *extra)
+{
+   tree_t decl = deferred_driver(fn, arg);
+   if (decl != NULL)
+      storm_count(extra, NULL, decl);
+}
+
+static void storm_sample(rt_model_t *m)
+{
+   // Only called for delta cycles past the threshold so the cost is
+   // negligible for designs without long delta chains
+   delta_storm_t *ds = m->storm;
+
+   if (m->iteration == ds->threshold)
+      ds->steps++;
+
+   deferq_scan(&m->procq, storm_proc_cb, ds);
+   deferq_scan(&m->driverq, storm_driver_cb, ds);
+}
+
+static void storm_end_step(rt_model_t *m)
+{
+   delta_storm_t *ds = m->storm;
+
+   if (m->iteration > ds->max_deltas) {
+      ds->max_deltas = m->iteration;
+      ds->max_time   = m->now;
+   }
+}
+
+static int storm_rec_cmp(const void *a, const void *b)
+{
+   const storm_rec_t *ra = *(const storm_rec_t **)a;
+   const storm_rec_t *rb = *(const storm_rec_t **)b;
+
+   if (ra->samples != rb->samples)
+      return ra->samples < rb->samples ? 1 : -1;
+   else
+      return 0;
+}
+
+static void storm_report(delta_storm_t *ds)
+{
+   if (ds->steps == 0)
+      return;
+
+   qsort(ds->recs.items, ds->recs.count, sizeof(storm_rec_t *),
+         storm_rec_cmp);
+
+   char tmbuf[64];
+   fmt_time_r(tmbuf, sizeof(tmbuf), ds->max_time, " ");
+
+   diag_t *d = diag_new(DIAG_NOTE, NULL);
+   diag_printf(d, "%"PRIu64" time step%s had more than %u delta cycles; "
+               "the longest was %u delta cycles at %s", ds->steps,
+               ds->steps > 1 ? "s" : "", ds->threshold, ds->max_deltas,
+               tmbuf);
+
+   for (int i = 0; i < ds->recs.count && i < PROFILE_TOP; i++) {
+      const storm_rec_t *rec = ds->recs.items[i];
+      if (rec->proc != NULL)
+         diag_hint(d, tree_loc(rec->proc->where), "process %s was active "
+                   "in %"PRIu64" delta cycles", istr(rec->proc->name),
+                   rec->samples);
+      else
+         diag_hint(d, tree_loc(rec->decl), "driver for %s %s was active "
+                   "in %"PRIu64" delta cycles",
+                   tree_kind(rec->decl) == T_PORT_DECL ? "port" : "signal",
+                   istr(tree_ident(rec->decl)), rec->samples);
+   }
+
+   diag_emit(d);
+}
+
 static void reached_iteration_limit(rt_model_t *m)
 {
    diag_t *d = diag_new(DIAG_FATAL, NULL);
@@ -3171,13 +5072,34 @@ static void model_cycle(rt_model_t *m)
    const bool is_delta_cycle = m->next_is_delta;
    m->next_is_delta = false;
 
-   if (is_delta_cycle)
+   if (is_delta_cycle) {
       m->iteration = m->iteration + 1;
+      stat_add(STAT_DELTA_CYCLES, 1);
+   }
    else {
-      m->now = heap_min_key(m->eventq_heap);
+      if (m->iteration >= 0)
+         stat_sample(STAT_DELTAS_PER_STEP, m->iteration);
+
+      if (m->storm != NULL && m->iteration >= 0)
+         storm_end_step(m);
+
+      drop_stale_events(m);
+
+      m->now = wheel_min_key(m->eventq);
       m->iteration = 0;
+      stat_add(STAT_TIME_STEPS, 1);
+
+      // Reports written to a pipe or file are left in the stdio buffer
+      // by diag_emit so flush them periodically to keep logs current
+      const uint64_t ts = get_timestamp_us();
+      if (ts - m->last_flush > FLUSH_INTERVAL) {
+         fflush(stdout);
+         m->last_flush = ts;
+      }
    }
 
+   TIMELINE_BEGIN(is_delta_cycle ? "delta cycle" : "time step", NULL);
+
    m->blocking_update = false;
 
    TRACE("begin cycle");
@@ -3194,14 +5116,17 @@ static void model_cycle(rt_model_t *m)
 
    if (!is_delta_cycle) {
       for (;;) {
-         void *e = heap_extract_min(m->eventq_heap);
+         void *e = wheel_extract_min(m->eventq);
          switch (pointer_tag(e)) {
          case EVENT_PROCESS:
             {
                rt_proc_t *proc = untag_pointer(e, rt_proc_t);
-               assert(proc->wakeable.delayed);
-               proc->wakeable.delayed = false;
-               procq_do(m, &proc->wakeable, async_run_process, proc);
+               if (is_stale_event(e, m->now))
+                  stat_add(STAT_STALE_TIMEOUTS, 1);
+               else {
+                  proc->wakeable.delayed = false;
+                  procq_do(m, &proc->wakeable, async_run_process, proc);
+               }
             }
             break;
          case EVENT_DRIVER:
@@ -3224,9 +5149,9 @@ static void model_cycle(rt_model_t *m)
             break;
          }
 
-         if (heap_size(m->eventq_heap) == 0)
+         if (wheel_size(m->eventq) == 0)
             break;
-         else if (heap_min_key(m->eventq_heap) > m->now)
+         else if (wheel_min_key(m->eventq) > m->now)
             break;
       }
    }
@@ -3239,14 +5164,22 @@ static void model_cycle(rt_model_t *m)
          (*m->reschedq.tasks[i].fn)(m, m->reschedq.tasks[i].arg);
       m->reschedq.count = 0;
 
-      while (heap_size(m->driving_heap) > 0) {
-         rt_nexus_t *n = heap_extract_min(m->driving_heap);
+      while (rankq_size(m->driving_queue) > 0) {
+#if RT_MULTITHREADED
+         if (m->procwq != NULL && m->profile == NULL
+             && rankq_size(m->driving_queue) >= PARALLEL_MIN) {
+            parallel_update_driving(m);
+            continue;
+         }
+#endif
+         rt_nexus_t *n = rankq_extract_min(m->driving_queue);
          update_driving(m, n, true);
       }
 
-      while (heap_size(m->effective_heap) > 0) {
-         rt_nexus_t *n = heap_extract_min(m->effective_heap);
-         update_effective(m, n);
+      while (rankq_size(m->effective_queue) > 0) {
+         rt_nexus_t *n = rankq_extract_min(m->effective_queue);
+         if (n->flags & NET_F_PENDING)
+            update_effective(m, n);   // Otherwise cancelled by deposit
       }
    } while (m->reschedq.count > 0);
 
@@ -3271,7 +5204,14 @@ static void model_cycle(rt_model_t *m)
 
    // Run all non-postponed processes and event callbacks
    deferq_swap(&m->next_procq, &m->procq);
-   deferq_run(m, &m->next_procq);
+#if RT_MULTITHREADED
+   if (m->procwq != NULL && m->next_procq.count >= PARALLEL_MIN)
+      parallel_run(m, &m->next_procq);
+   else
+#endif
+      deferq_run(m, &m->next_procq);
+
+   run_watch_batches(m);
 
    run_callbacks(m, END_OF_PROCESSES);
 
@@ -3291,7 +5231,7 @@ static void model_cycle(rt_model_t *m)
 
    if (m->nonblockq.count > 0) {
       TRACE("begin non-blocking assignment region");
-      deferq_run(m, &m->nonblockq);
+      nonblock_run(m);
    }
 
  next_delta:
@@ -3308,8 +5248,15 @@ static void model_cycle(rt_model_t *m)
 
       m->can_create_delta = true;
    }
+
+   TIMELINE_END(is_delta_cycle ? "delta cycle" : "time step");
+
+   if (!m->next_is_delta)
+      return;
    else if (m->stop_delta > 0 && m->iteration == m->stop_delta)
       reached_iteration_limit(m);
+   else if (m->storm != NULL && m->iteration >= m->storm->threshold)
+      storm_sample(m);
 }
 
 static bool should_stop_now(rt_model_t *m, uint64_t stop_time)
@@ -3322,10 +5269,13 @@ static bool should_stop_now(rt_model_t *m, uint64_t stop_time)
    }
    else if (m->next_is_delta)
       return false;
-   else if (heap_size(m->eventq_heap) == 0)
+
+   drop_stale_events(m);
+
+   if (wheel_size(m->eventq) == 0)
       return true;
    else
-      return heap_min_key(m->eventq_heap) > stop_time;
+      return wheel_min_key(m->eventq) > stop_time;
 }
 
 static void check_liveness_properties(rt_model_t *m, rt_scope_t *s)
@@ -3461,11 +5411,6 @@ void release_signal(rt_model_t *m, rt_signal_t *s, int offset, size_t count)
    }
 }
 
-static bool heap_delete_ptr_cb(uint64_t key, void *value, void *ctx)
-{
-   return value == ctx;
-}
-
 void deposit_signal(rt_model_t *m, rt_signal_t *s, const void *values,
                     int offset, size_t count)
 {
@@ -3500,11 +5445,9 @@ void deposit_signal(rt_model_t *m, rt_signal_t *s, const void *values,
          wakeup_all(m, &(n->pending));
       }
 
-      if (n->flags & NET_F_PENDING) {
-         // Cancel any deferred effective value update
-         heap_delete(m->effective_heap, heap_delete_ptr_cb, n);
-         n->flags &= ~NET_F_PENDING;
-      }
+      // Cancel any deferred effective value update: the stale queue
+      // entry is skipped when extracted
+      n->flags &= ~NET_F_PENDING;
 
       vptr += valuesz;
    }
@@ -3534,13 +5477,13 @@ void sched_deposit(rt_model_t *m, rt_signal_t *s, const void *values,
       if (!src->pseudoqueued) {
          if (after == 0) {
             if (nonblock)
-               deferq_do(&m->nonblockq, async_pseudo_source, src);
+               sched_do(m, &m->nonblockq, async_pseudo_source, src);
             else
                deltaq_insert_pseudo_source(m, src);
          }
          else if (after > 0) {
             void *e = tag_pointer(src, EVENT_PSEUDO);
-            heap_insert(m->eventq_heap, m->now + after, e);
+            eventq_insert(m, m->now + after, e);
          }
 
          src->pseudoqueued = 1;  // TODO: should be after == 0 branch
@@ -3565,10 +5508,12 @@ int64_t model_now(rt_model_t *m, unsigned *deltas)
 
 int64_t model_next_time(rt_model_t *m)
 {
-   if (heap_size(m->eventq_heap) == 0)
+   drop_stale_events(m);
+
+   if (wheel_size(m->eventq) == 0)
       return TIME_HIGH;
    else
-      return heap_min_key(m->eventq_heap);
+      return wheel_min_key(m->eventq);
 }
 
 void model_stop(rt_model_t *m)
@@ -3576,6 +5521,57 @@ void model_stop(rt_model_t *m)
    relaxed_store(&m->force_stop, true);
 }
 
+void model_profile_start(rt_model_t *m)
+{
+   if (m->profile != NULL)
+      profile_free(m->profile);
+
+   if (m->stopped_profile != NULL) {
+      profile_free(m->stopped_profile);
+      m->stopped_profile = NULL;
+   }
+
+   m->profile = profile_new("");
+
+   if (m->root != NULL)
+      profile_add_scope(m->profile, m->root);
+}
+
+bool model_profile_stop(rt_model_t *m)
+{
+   if (m->profile == NULL)
+      return false;
+
+   if (m->stopped_profile != NULL)
+      profile_free(m->stopped_profile);
+
+   m->stopped_profile = m->profile;
+   m->profile = NULL;
+   return true;
+}
+
+bool model_profile_report(rt_model_t *m)
+{
+   rt_profile_t *p = m->profile ?: m->stopped_profile;
+   if (p == NULL)
+      return false;
+
+   profile_report(p);
+   return true;
+}
+
+void model_get_stats(rt_model_t *m, model_stats_t *stats)
+{
+   stats->now         = model_now(m, &stats->deltas);
+   stats->event_queue = wheel_size(m->eventq);
+   stats->waveforms   = 0;
+
+   for (int i = 0; i < MAX_THREADS; i++) {
+      if (m->threads[i] != NULL)
+         stats->waveforms += m->threads[i]->live_waveforms;
+   }
+}
+
 void model_set_phase_cb(rt_model_t *m, model_phase_t phase, rt_event_fn_t fn,
                         void *user)
 {
@@ -3602,7 +5598,7 @@ void model_set_timeout_cb(rt_model_t *m, uint64_t when, rt_event_fn_t fn,
    assert(when > m->now);   // TODO: delta timeouts?
 
    void *e = tag_pointer(cb, EVENT_TIMEOUT);
-   heap_insert(m->eventq_heap, when, e);
+   wheel_insert(m->eventq, when, e);
 }
 
 rt_watch_t *watch_new(rt_model_t *m, sig_event_fn_t fn, void *user,
@@ -3767,6 +5763,7 @@ static void arm_trigger(rt_model_t *m, rt_trigger_t *t, rt_wakeable_t *obj)
 {
    switch (t->kind) {
    case CMP_TRIGGER:
+   case EDGE_TRIGGER:
       {
          assert(t->nargs == 3);
          rt_signal_t *s = t->args[0].pointer;
@@ -3806,6 +5803,7 @@ static void arm_trigger(rt_model_t *m, rt_trigger_t *t, rt_wakeable_t *obj)
       }
       break;
    case OR_TRIGGER:
+   case AND_TRIGGER:
       {
          assert(t->nargs == 2);
          arm_trigger(m, t->args[0].pointer, obj);
@@ -3835,7 +5833,7 @@ static rt_trigger_t *new_trigger(rt_model_t *m, trigger_kind_t kind,
 
    const size_t argsz = nargs * sizeof(jit_scalar_t);
 
-   rt_trigger_t *t = static_alloc(m, sizeof(rt_trigger_t) + argsz);
+   rt_trigger_t *t = static_alloc(m, sizeof(rt_trigger_t) + argsz, MEM_TRIGGER);
    memset(t, '\0', sizeof(rt_trigger_t));
    t->wakeable.kind = W_TRIGGER;
    t->handle = handle;
@@ -3950,9 +5948,15 @@ sig_shared_t *x_init_signal(int64_t count, uint32_t size, jit_scalar_t value,
               istr(tree_ident(where)), count, INT32_MAX);
 
    const size_t datasz = MAX(3 * count * size, 8);
-   rt_signal_t *s = static_alloc(m, sizeof(rt_signal_t) + datasz);
+   rt_signal_t *s = static_alloc(m, sizeof(rt_signal_t) + datasz, MEM_SIGNAL);
    setup_signal(m, s, where, count, size, flags, offset);
 
+   if (m->splitplans != NULL && offset == 0) {
+      const split_plan_t *plan = hash_get(m->splitplans, where);
+      if (plan != NULL && plan->length == count)
+         apply_split_plan(m, s, plan);
+   }
+
    // The driving value area is also used to save the default value
    void *driving = s->shared.data + 2*s->shared.size;
 
@@ -4023,7 +6027,7 @@ void x_sched_inactive(void)
    TRACE("schedule process %s in inactive region", istr(proc->name));
 
    set_pending(&proc->wakeable);
-   deferq_do(&m->inactiveq, async_run_process, proc);
+   sched_do(m, &m->inactiveq, async_run_process, proc);
    m->next_is_delta = true;
 }
 
@@ -4080,7 +6084,8 @@ void x_sched_waveform(sig_shared_t *ss, uint32_t offset, void *values,
 
 void x_transfer_signal(sig_shared_t *target_ss, uint32_t toffset,
                        sig_shared_t *source_ss, uint32_t soffset,
-                       int32_t count, int64_t after, int64_t reject)
+                       int32_t count, int64_t after, int64_t reject,
+                       int32_t kind)
 {
    rt_signal_t *target = container_of(target_ss, rt_signal_t, shared);
    rt_signal_t *source = container_of(source_ss, rt_signal_t, shared);
@@ -4097,25 +6102,45 @@ void x_transfer_signal(sig_shared_t *target_ss, uint32_t toffset,
 
    rt_model_t *m = get_model();
 
-   rt_transfer_t *t = static_alloc(m, sizeof(rt_transfer_t));
+   // The implicit signals S'STABLE, S'QUIET, and S'TRANSACTION have a
+   // single BOOLEAN or BIT target regardless of the width of S
+   const bool implicit = (kind >= TRANSFER_STABLE);
+
+   // S'STABLE and S'QUIET only update after the first event or
+   // transaction on S
+   const bool edge = (kind == TRANSFER_STABLE || kind == TRANSFER_QUIET);
+
+   rt_transfer_t *t = static_alloc(m, sizeof(rt_transfer_t), MEM_OTHER);
    t->proc   = proc;
-   t->target = split_nexus(m, target, toffset, count);
+   t->target = split_nexus(m, target, toffset, implicit ? 1 : count);
    t->source = split_nexus(m, source, soffset, count);
    t->count  = count;
    t->after  = after;
    t->reject = reject;
+   t->kind   = kind;
 
-   t->wakeable.kind      = W_TRANSFER;
-   t->wakeable.postponed = false;
-   t->wakeable.pending   = false;
-   t->wakeable.delayed   = false;
+   t->wakeable.kind       = W_TRANSFER;
+   t->wakeable.postponed  = false;
+   t->wakeable.pending    = false;
+   t->wakeable.delayed    = false;
+   t->wakeable.reschedule = implicit;
 
    for (rt_nexus_t *n = t->source; count > 0; n = n->chain) {
-      sched_event(m, &(n->pending), &(t->wakeable));
+      if (kind == TRANSFER_QUIET || kind == TRANSFER_TRANSACTION) {
+         rt_source_t *src = static_alloc(m, sizeof(rt_source_t), MEM_SOURCE);
+         src->tag          = SOURCE_ACTIVE;
+         src->chain_output = n->outputs;
+         src->u.wakeable   = &(t->wakeable);
+
+         n->flags |= NET_F_EFFECTIVE;
+         n->outputs = src;
+      }
+      else
+         sched_event(m, &(n->pending), &(t->wakeable));
 
-      if (!t->wakeable.pending) {
+      if (!t->wakeable.pending && !edge) {
          // Schedule initial update immediately
-         deferq_do(&m->procq, async_transfer_signal, t);
+         sched_do(m, &m->procq, async_transfer_signal, t);
          t->wakeable.pending = true;
       }
 
@@ -4229,7 +6254,7 @@ void x_sched_active(sig_shared_t *ss, uint32_t offset, int32_t count)
    rt_nexus_t *n = split_nexus(m, s, offset, count);
    for (; count > 0; n = n->chain) {
       // TODO: it would be better to use a separate pending list for this
-      rt_source_t *src = static_alloc(m, sizeof(rt_source_t));
+      rt_source_t *src = static_alloc(m, sizeof(rt_source_t), MEM_SOURCE);
       src->tag          = SOURCE_ACTIVE;
       src->chain_output = n->outputs;
       src->u.wakeable   = obj;
@@ -4634,34 +6659,7 @@ void x_put_driver(sig_shared_t *ss, uint32_t offset, int32_t count,
       rt_source_t *d = find_driver(n, proc);
       assert(d != NULL);
 
-      // Delete any pending transactions
-      for (waveform_t *it = d->u.driver.waveforms.next, *tmp = it;
-           it != NULL; it = tmp) {
-         tmp = it->next;
-         free_value(n, it->value);
-         free_waveform(m, it);
-      }
-      d->u.driver.waveforms.next = NULL;
-
-      copy_value_ptr(n, &d->u.driver.waveforms.value, vptr);
-
-      d->u.driver.waveforms.when = m->now;
-
-      calculate_driving_value(m, n);
-
-      for (rt_source_t *o = n->outputs; o; o = o->chain_output) {
-         switch (o->tag) {
-         case SOURCE_PORT:
-            defer_driving_update(m, o->u.port.output);
-            m->next_is_delta = true;
-            break;
-         case SOURCE_ACTIVE:
-            wakeup_one(m, o->u.wakeable);
-            break;
-         default:
-            should_not_reach_here();
-         }
-      }
+      put_driver(m, n, d, vptr);
 
       vptr += n->size * n->width;
    }
@@ -4701,8 +6699,8 @@ void x_process_init(const ffi_closure_t *closure, tree_t where)
    LOCAL_TEXT_BUF tb = tb_new();
    get_path_name(s, tb);
 
-   rt_proc_t *p = xcalloc_flex(sizeof(rt_proc_t), closure->nargs - 1,
-                               sizeof(jit_scalar_t));
+   rt_proc_t *p = proc_alloc(m, sizeof(rt_proc_t)
+                             + (closure->nargs - 1) * sizeof(jit_scalar_t));
 
    p->where    = where;
    p->scope    = s;
@@ -4751,6 +6749,23 @@ rt_trigger_t *x_or_trigger(rt_trigger_t *left, rt_trigger_t *right)
    return new_trigger(m, OR_TRIGGER, hash, JIT_HANDLE_INVALID, 2, args);
 }
 
+rt_trigger_t *x_and_trigger(rt_trigger_t *left, rt_trigger_t *right)
+{
+   rt_model_t *m = get_model();
+
+   uint64_t hash = mix_bits_64(left) ^ (mix_bits_64(right) << 1);
+
+   TRACE("and trigger %p %p hash=%"PRIx64, left, right, hash);
+
+   // Keep the operand order so the cheaper left side is tested first
+   const jit_scalar_t args[] = {
+      { .pointer = left },
+      { .pointer = right }
+   };
+
+   return new_trigger(m, AND_TRIGGER, hash, JIT_HANDLE_INVALID, 2, args);
+}
+
 void *x_cmp_trigger(sig_shared_t *ss, uint32_t offset, int64_t right)
 {
    rt_model_t *m = get_model();
@@ -4789,6 +6804,27 @@ void *x_level_trigger(sig_shared_t *ss, uint32_t offset, int32_t count)
    return new_trigger(m, LEVEL_TRIGGER, hash, JIT_HANDLE_INVALID, 3, args);
 }
 
+void *x_edge_trigger(sig_shared_t *ss, uint32_t offset, int32_t edge)
+{
+   rt_model_t *m = get_model();
+   rt_signal_t *s = container_of(ss, rt_signal_t, shared);
+
+   uint64_t hash = mix_bits_64(s) ^ mix_bits_32(offset) ^ mix_bits_32(edge);
+
+   TRACE("edge trigger %s+%d edge=%d hash=%"PRIx64,
+         istr(tree_ident(s->where)), offset, edge, hash);
+
+   assert(s->nexus.size == 1);
+
+   const jit_scalar_t args[] = {
+      { .pointer = s },
+      { .integer = offset },
+      { .integer = edge }
+   };
+
+   return new_trigger(m, EDGE_TRIGGER, hash, JIT_HANDLE_INVALID, 3, args);
+}
+
 void x_add_trigger(void *ptr)
 {
    TRACE("add trigger %p", ptr);
@@ -20,6 +20,7 @@
 
 #include "prim.h"
 #include "rt/rt.h"
+#include "rt/random.h"
 
 typedef enum {
    WATCH_EVENT,
@@ -39,9 +40,18 @@ typedef enum {
    END_OF_SIMULATION,
 } model_phase_t;
 
+typedef struct {
+   int64_t  now;
+   unsigned deltas;
+   size_t   event_queue;
+   int64_t  waveforms;
+} model_stats_t;
+
 rt_model_t *model_new(jit_t *jit, cover_data_t *cover);
 void model_free(rt_model_t *m);
 void model_reset(rt_model_t *m);
+void model_reserve(rt_model_t *m, size_t bytes);
+size_t model_static_size(rt_model_t *m);
 void model_run(rt_model_t *m, uint64_t stop_time);
 bool model_step(rt_model_t *m);
 bool model_can_create_delta(rt_model_t *m);
@@ -50,6 +60,11 @@ int64_t model_next_time(rt_model_t *m);
 void model_stop(rt_model_t *m);
 void model_interrupt(rt_model_t *m);
 int model_exit_status(rt_model_t *m);
+void model_get_stats(rt_model_t *m, model_stats_t *stats);
+
+void model_profile_start(rt_model_t *m);
+bool model_profile_stop(rt_model_t *m);
+bool model_profile_report(rt_model_t *m);
 
 rt_watch_t *watch_new(rt_model_t *m, sig_event_fn_t fn, void *user,
                       watch_kind_t kind, unsigned slots);
@@ -67,6 +82,7 @@ void call_with_model(rt_model_t *m, void (*cb)(void *), void *arg);
 rt_model_t *get_model(void);
 rt_model_t *get_model_or_null(void);
 rt_proc_t *get_active_proc(void);
+rng_stream_t *get_active_rng(void);
 rt_scope_t *get_active_scope(rt_model_t *m);
 cover_data_t *get_coverage(rt_model_t *m);
 
@@ -78,6 +94,7 @@ rt_signal_t *find_signal(rt_scope_t *scope, tree_t decl, uint32_t *offset);
 rt_proc_t *find_proc(rt_scope_t *scope, tree_t proc);
 bool is_signal_scope(rt_scope_t *scope);
 rt_scope_t *create_scope(rt_model_t *m, tree_t block, rt_scope_t *parent);
+void model_plan_splits(rt_model_t *m, tree_t block);
 
 void get_instance_name(rt_scope_t *s, text_buf_t *tb);
 void get_path_name(rt_scope_t *s, text_buf_t *tb);
@@ -19,10 +19,15 @@
 #include "array.h"
 #include "cpustate.h"
 #include "diag.h"
+#include "hash.h"
+#include "ident.h"
 #include "mask.h"
 #include "option.h"
+#include "printf.h"
 #include "rt/mspace.h"
+#include "stats.h"
 #include "thread.h"
+#include "timeline.h"
 
 #include <assert.h>
 #include <stdlib.h>
@@ -30,6 +35,19 @@
 #include <string.h>
 #include <inttypes.h>
 
+#if !defined __MINGW32__ && !ASAN_ENABLED
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#define PAGE_WRITE_BARRIER 1
+#define SPARSE_LARGE_OBJECTS 1
+#endif
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
 #define LINE_SIZE  32
 #define LINE_WORDS (LINE_SIZE / sizeof(intptr_t))
 #define MAX_HEAP   (UINT64_C(0x100000000) * LINE_SIZE)
@@ -40,6 +58,19 @@
 
 STATIC_ASSERT(OVERRUN_MARGIN % LINE_SIZE == 0);
 
+#define MARK_STACK_SIZE    4096   // Per-thread fixed size mark stack
+#define SHARED_STACK_SIZE  16384
+#define PARALLEL_MARK_MIN  256    // Minimum root objects for parallel mark
+#define MARK_SPLIT_LINES   64     // Scan large objects in chunks
+#define PAUSE_BUCKETS      16
+#define MAX_MINOR_GC       16     // Minor collections between full ones
+#define PROFILE_TOP        20
+#define PROFILE_GC_TOP     5
+#define LARGE_SCAN_PAGES   512    // Page map entries read at once
+#define HEAP_SEGMENT_SIZE  (4 * 1024 * 1024)   // Initial size and growth step
+#define HEAP_FREE_TARGET   50     // Grow if GC leaves less than this % free
+#define MPTR_CHUNK_SIZE    256    // Root slots allocated together
+
 typedef A(uint64_t) work_list_t;
 typedef struct _linked_tlab linked_tlab_t;
 
@@ -58,15 +89,69 @@ struct _mptr {
 #endif
 };
 
+typedef struct _mptr_chunk mptr_chunk_t;
+
+struct _mptr_chunk {
+   mptr_chunk_t  *next;
+   struct _mptr   items[MPTR_CHUNK_SIZE];
+};
+
+typedef struct {
+   char   *ptr;
+   size_t  size;
+   size_t  mapsz;
+   bool    marked;
+} large_object_t;
+
 typedef struct {
    bit_mask_t        markmask;
    work_list_t       worklist;
+   work_list_t       largelist;
+   const bit_mask_t *oldmask;
    struct cpu_state  cpu[MAX_THREADS];
 #if ASAN_ENABLED
    void             *fake_stack[MAX_THREADS];
 #endif
 } gc_state_t;
 
+typedef struct {
+   mspace_t   *mspace;
+   bit_mask_t *markmask;
+   uint64_t   *stacks;
+   uint64_t   *shared;
+   unsigned    nshared;
+   unsigned    maxshared;
+   int         lock;
+   int         nthreads;
+   int         nextslot;
+   int         idle;
+   bool        overflow;
+} gc_parallel_t;
+
+typedef struct {
+   ident_t  site;
+   uint64_t live;
+   uint64_t total;
+} heap_site_t;
+
+typedef struct {
+   void     *ptr;
+   uint64_t  weight;
+   unsigned  site;
+} heap_sample_t;
+
+typedef struct {
+   int64_t           countdown;
+   size_t            interval;
+   mspace_site_fn_t  site_fn;
+   hash_t           *index;
+   A(heap_site_t)    sites;
+   A(heap_sample_t)  samples;
+   uint64_t          live;
+   uint64_t          peak;
+   unsigned          num_gc;
+} heap_profile_t;
+
 typedef struct _free_list free_list_t;
 
 struct _free_list {
@@ -79,10 +164,12 @@ struct _mspace {
    nvc_lock_t       lock;
    size_t           maxsize;
    size_t           maxlines;
+   size_t           activelines;
    char            *space;
    bit_mask_t       headmask;
    mptr_t           roots;
    mptr_t           free_mptrs;
+   mptr_chunk_t    *mptr_chunks;
    mspace_oom_fn_t  oomfn;
    free_list_t     *free_list;
    uint64_t         create_us;
@@ -90,6 +177,26 @@ struct _mspace {
    linked_tlab_t   *free_tlabs;
    unsigned         total_gc;
    unsigned         num_cycles;
+   unsigned         max_pause;
+   unsigned         pauses[PAUSE_BUCKETS];
+   size_t           peak_live;
+   size_t           last_live;
+   bool             parallel;
+   bool             lazy_sweep;
+   bit_mask_t       livemask;
+   size_t           sweepline;
+   bool             generational;
+   bool             need_major;
+   size_t           pagesize;
+   bit_mask_t       oldmask;
+   bit_mask_t       dirtymask;
+   unsigned         num_minor;
+   heap_profile_t  *profile;
+   A(large_object_t) large;
+   char            *large_lo;
+   char            *large_hi;
+   size_t           large_live;
+   size_t           large_new;
 #ifdef DEBUG
    bool             stress;
 #endif
@@ -97,8 +204,119 @@ struct _mspace {
 
 static intptr_t *stack_limit[MAX_THREADS];
 
+#ifdef PAGE_WRITE_BARRIER
+static mspace_t         *barrier_mspace = NULL;
+static struct sigaction  old_segv_action;
+static struct sigaction  old_bus_action;
+#endif
+
 static void mspace_gc(mspace_t *m);
 static bool is_mspace_ptr(mspace_t *m, char *p);
+static bool mspace_sweep_some(mspace_t *m, size_t asize);
+static bool mspace_grow(mspace_t *m, size_t minlines);
+static void mspace_enable_barrier(mspace_t *m);
+static void mspace_profile_print(mspace_t *m, const char *title, int max);
+
+#ifdef PAGE_WRITE_BARRIER
+static void mspace_write_fault(int sig, siginfo_t *info, void *context)
+{
+   mspace_t *m = atomic_load(&barrier_mspace);
+   char *addr = info->si_addr;
+
+   if (m != NULL && is_mspace_ptr(m, addr)) {
+      // First write to a page since the last collection: record it as
+      // possibly containing pointers from old to new objects
+      const size_t page = (addr - m->space) / m->pagesize;
+      uint64_t *word = m->dirtymask.size > 64
+         ? &(m->dirtymask.ptr[page / 64]) : &(m->dirtymask.bits);
+      __atomic_fetch_or(word, UINT64_C(1) << (page % 64), __ATOMIC_RELAXED);
+
+      char *base = m->space + page * m->pagesize;
+      if (mprotect(base, m->pagesize, PROT_READ | PROT_WRITE) == 0)
+         return;
+
+      // Splitting the mapping may fail if there are too many distinct
+      // regions so unprotect the whole heap and treat all pages as
+      // written instead
+      if (mprotect(m->space, m->maxsize, PROT_READ | PROT_WRITE) == 0) {
+         if (m->dirtymask.size > 64) {
+            for (size_t i = 0; i < (m->dirtymask.size + 63) / 64; i++)
+               atomic_store(&(m->dirtymask.ptr[i]), ~UINT64_C(0));
+         }
+         else
+            atomic_store(&(m->dirtymask.bits), ~UINT64_C(0));
+         return;
+      }
+   }
+
+   const struct sigaction *old =
+      sig == SIGBUS ? &old_bus_action : &old_segv_action;
+
+   if (old->sa_flags & SA_SIGINFO)
+      (*old->sa_sigaction)(sig, info, context);
+   else if (old->sa_handler == SIG_DFL || old->sa_handler == SIG_IGN)
+      sigaction(sig, old, NULL);   // Fault again with default action
+   else
+      (*old->sa_handler)(sig);
+}
+
+static void mspace_install_fault_handler(void)
+{
+   struct sigaction sa = {
+      .sa_sigaction = mspace_write_fault,
+      .sa_flags = SA_RESTART | SA_SIGINFO
+   };
+   sigfillset(&sa.sa_mask);
+
+   sigaction(SIGSEGV, &sa, &old_segv_action);
+   sigaction(SIGBUS, &sa, &old_bus_action);
+}
+
+static void mspace_protect(mspace_t *m)
+{
+   mask_clearall(&(m->dirtymask));
+
+   if (mprotect(m->space, m->maxsize, PROT_READ) != 0)
+      fatal_errno("mprotect");
+}
+#endif
+
+static void mspace_enable_barrier(mspace_t *m)
+{
+#ifdef PAGE_WRITE_BARRIER
+   m->pagesize = sysconf(_SC_PAGESIZE);
+
+   if ((uintptr_t)m->space % m->pagesize != 0)
+      return;
+   else if (!atomic_cas(&barrier_mspace, NULL, m))
+      return;   // Only one heap at a time can use the write barrier
+
+   INIT_ONCE(mspace_install_fault_handler());
+
+   mask_init(&(m->oldmask), m->maxlines);
+   mask_init(&(m->dirtymask), (m->maxsize + m->pagesize - 1) / m->pagesize);
+
+   m->generational = true;
+   m->need_major = true;
+#endif
+}
+
+void mspace_touch(void *ptr, size_t size)
+{
+#ifdef PAGE_WRITE_BARRIER
+   // System calls fail with EFAULT rather than raising a signal when
+   // writing to a protected page so fault them in first
+   mspace_t *m = atomic_load(&barrier_mspace);
+   if (m == NULL || size == 0)
+      return;
+
+   char *start = MAX((char *)ptr, m->space);
+   char *end = MIN((char *)ptr + size, m->space + m->maxsize);
+   for (char *p = start; p < end;
+        p = m->space + ALIGN_UP(p - m->space + 1, m->pagesize))
+      __atomic_fetch_add(p, 0, __ATOMIC_RELAXED);
+#endif
+}
 
 mspace_t *mspace_new(size_t size)
 {
@@ -112,6 +330,9 @@ mspace_t *mspace_new(size_t size)
 
    DEBUG_ONLY(m->stress = opt_get_int(OPT_GC_STRESS));
 
+   m->parallel   = opt_get_int(OPT_GC_PARALLEL);
+   m->lazy_sweep = opt_get_int(OPT_GC_LAZY_SWEEP);
+
    m->space = map_huge_pages(LINE_SIZE, m->maxsize);
 
    ASAN_POISON(m->space, m->maxsize);
@@ -119,12 +340,21 @@ mspace_t *mspace_new(size_t size)
    mask_init(&(m->headmask), m->maxlines);
    mask_setall(&(m->headmask));
 
+   // The whole heap is reserved up front but only the first segment is
+   // used for allocation until collections stop freeing enough space
+   const size_t seglines = HEAP_SEGMENT_SIZE / LINE_SIZE;
+   m->activelines = MIN(m->maxlines, seglines);
+
    free_list_t *f = xmalloc(sizeof(free_list_t));
    f->next = NULL;
    f->ptr  = m->space;
-   f->size = m->maxsize - OVERRUN_MARGIN;
+   f->size = m->activelines * LINE_SIZE;
 
    m->free_list = f;
+   m->sweepline = m->activelines;
+
+   if (opt_get_int(OPT_GC_GENERATIONAL))
+      mspace_enable_barrier(m);
 
    m->create_us = get_timestamp_us();
    return m;
@@ -153,6 +383,19 @@ void mspace_destroy(mspace_t *m)
       const double gc_frac = m->total_gc / (double)(destroy_us - m->create_us);
       debugf("GC: %d collection cycles; %d us total; %.1f%% of overall "
              "run time", m->num_cycles, m->total_gc, gc_frac * 100.0);
+      debugf("GC: peak live heap %zu/%zu bytes; longest pause %u us",
+             m->peak_live, m->maxsize, m->max_pause);
+
+      for (int i = 0; i < PAUSE_BUCKETS; i++) {
+         if (m->pauses[i] == 0)
+            continue;
+         else if (i == 0)
+            debugf("GC:   %7s < %-7d us: %u", "", 32, m->pauses[i]);
+         else if (i == PAUSE_BUCKETS - 1)
+            debugf("GC:   %7d <= %-7s us: %u", 16 << i, "", m->pauses[i]);
+         else
+            debugf("GC:   %7d - %-7d us: %u", 16 << i, 32 << i, m->pauses[i]);
+      }
    }
 
    for (free_list_t *it = m->free_list, *tmp; it; it = tmp) {
@@ -160,11 +403,32 @@ void mspace_destroy(mspace_t *m)
       free(it);
    }
 
-   for (mptr_t p = m->free_mptrs, tmp; p; p = tmp) {
-      tmp = p->next;
-      free(p);
+   if (m->profile != NULL) {
+      mspace_profile_print(m, "Heap profile at exit", PROFILE_TOP);
+      hash_free(m->profile->index);
+      ACLEAR(m->profile->sites);
+      ACLEAR(m->profile->samples);
+      free(m->profile);
+   }
+
+   for (mptr_chunk_t *c = m->mptr_chunks, *tmp; c; c = tmp) {
+      tmp = c->next;
+      free(c);
    }
 
+   mask_free(&(m->livemask));
+
+   for (int i = 0; i < m->large.count; i++)
+      nvc_munmap(m->large.items[i].ptr, m->large.items[i].mapsz);
+   ACLEAR(m->large);
+
+#ifdef PAGE_WRITE_BARRIER
+   if (m->generational) {
+      atomic_store(&barrier_mspace, NULL);
+      mask_free(&(m->oldmask));
+      mask_free(&(m->dirtymask));
+   }
+#endif
    mask_free(&(m->headmask));
    nvc_munmap(m->space, m->maxsize);
    free(m);
@@ -185,6 +449,7 @@ static void *mspace_try_alloc(mspace_t *m, size_t size)
 
    SCOPED_LOCK(m->lock);
 
+ retry:
    for (free_list_t **it = &(m->free_list); *it; it = &((*it)->next)) {
       assert((*it)->size % LINE_SIZE == 0);
       if ((*it)->size >= asize) {
@@ -218,9 +483,298 @@ static void *mspace_try_alloc(mspace_t *m, size_t size)
       }
    }
 
+   if (mspace_sweep_some(m, asize))
+      goto retry;
+
    return NULL;
 }
 
+static void *mspace_alloc_large(mspace_t *m, size_t size)
+{
+   // Large objects are mapped separately so that they do not count
+   // against the heap size and only pages which are written become
+   // resident: this allows huge memory models that are sparsely
+   // accessed
+#ifdef SPARSE_LARGE_OBJECTS
+   const size_t mapsz =
+      ALIGN_UP(size + OVERRUN_MARGIN, sysconf(_SC_PAGESIZE));
+   char *ptr = mmap(NULL, mapsz, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANON | MAP_NORESERVE, -1, 0);
+   if (ptr == MAP_FAILED)
+      return NULL;
+#else
+   const size_t mapsz = ALIGN_UP(size + OVERRUN_MARGIN, LINE_SIZE);
+   char *ptr = nvc_memalign(LINE_SIZE, mapsz);
+#endif
+
+   SCOPED_LOCK(m->lock);
+
+   large_object_t lo = {
+      .ptr   = ptr,
+      .size  = size,
+      .mapsz = mapsz,
+   };
+   APUSH(m->large, lo);
+
+   m->large_new += size;
+
+   if (m->large.count == 1 || ptr < m->large_lo)
+      m->large_lo = ptr;
+   if (m->large.count == 1 || ptr + mapsz > m->large_hi)
+      m->large_hi = ptr + mapsz;
+
+   return ptr;
+}
+
+static int mspace_find_large(mspace_t *m, char *p)
+{
+   if (p < m->large_lo || p >= m->large_hi)
+      return -1;
+
+   for (int i = 0; i < m->large.count; i++) {
+      // Pointer to one element past the end is also valid
+      const large_object_t *lo = &(m->large.items[i]);
+      if (p >= lo->ptr && p <= lo->ptr + lo->size)
+         return i;
+   }
+
+   return -1;
+}
+
+void mspace_bzero(mspace_t *m, void *ptr, size_t size)
+{
+#ifdef SPARSE_LARGE_OBJECTS
+   if (size >= LARGE_OBJECT_SIZE) {
+      int index;
+      {
+         SCOPED_LOCK(m->lock);
+         index = mspace_find_large(m, ptr);
+      }
+
+      if (index != -1) {
+         // Replace whole pages with a fresh mapping rather than writing
+         // zeros which would make every page resident
+         const size_t pagesize = sysconf(_SC_PAGESIZE);
+         char *start = ALIGN_UP((char *)ptr, pagesize);
+         char *end = (char *)ptr + size - ((uintptr_t)ptr + size) % pagesize;
+
+         if (start < end && mmap(start, end - start, PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_ANON | MAP_FIXED
+                                 | MAP_NORESERVE, -1, 0) != MAP_FAILED) {
+            memset(ptr, '\0', start - (char *)ptr);
+            memset(end, '\0', (char *)ptr + size - end);
+            return;
+         }
+      }
+   }
+#endif
+
+   memset(ptr, '\0', size);
+}
+
+static bool mspace_sweep_some(mspace_t *m, size_t asize)
+{
+   // Add free lines left over from the last collection to the free
+   // list until a fragment large enough for ASIZE bytes is found
+   assert_lock_held(&(m->lock));
+
+   free_list_t **tail = &(m->free_list);
+   while (*tail != NULL)
+      tail = &((*tail)->next);
+
+   while (m->sweepline < m->activelines) {
+      const size_t line = m->sweepline;
+      const size_t clear = MIN(mask_count_clear(&(m->livemask), line),
+                               m->activelines - line);
+      if (clear == 0) {
+         m->sweepline++;
+         continue;
+      }
+
+      free_list_t *f = xmalloc(sizeof(free_list_t));
+      f->next = NULL;
+      f->ptr  = m->space + line * LINE_SIZE;
+      f->size = clear * LINE_SIZE;
+
+      *tail = f;
+      tail = &(f->next);
+
+      mask_set_range(&(m->headmask), line, clear);
+
+      m->sweepline += clear;
+
+      if (f->size >= asize)
+         return true;
+   }
+
+   return false;
+}
+
+static bool mspace_grow(mspace_t *m, size_t minlines)
+{
+   // Extend the part of the reserved heap used for allocation by at
+   // least one segment and at least MINLINES lines
+   assert_lock_held(&(m->lock));
+
+   if (m->activelines == m->maxlines)
+      return false;
+
+   const size_t seglines = HEAP_SEGMENT_SIZE / LINE_SIZE;
+   const size_t target = m->activelines + MAX(seglines, minlines);
+   const size_t newlines = MIN(m->maxlines, ALIGN_UP(target, seglines));
+
+   // When sweeping lazily the lines past the old limit are clear in
+   // the live mask so the sweeper will add them to the free list on
+   // demand, otherwise they must be added here
+   if (!m->lazy_sweep || m->generational || m->livemask.size == 0) {
+      assert(m->sweepline == m->activelines);
+
+      free_list_t **tail = &(m->free_list);
+      while (*tail != NULL)
+         tail = &((*tail)->next);
+
+      free_list_t *f = xmalloc(sizeof(free_list_t));
+      f->next = NULL;
+      f->ptr  = m->space + m->activelines * LINE_SIZE;
+      f->size = (newlines - m->activelines) * LINE_SIZE;
+
+      *tail = f;
+      m->sweepline = newlines;
+   }
+
+   if (opt_get_verbose(OPT_GC_VERBOSE, NULL))
+      debugf("GC: grow heap from %zu to %zu bytes", m->activelines * LINE_SIZE,
+             newlines * LINE_SIZE);
+
+   m->activelines = newlines;
+   return true;
+}
+
+__attribute__((noinline))
+static void mspace_profile_sample(mspace_t *m, void *ptr, size_t size)
+{
+   heap_profile_t *p = m->profile;
+
+   // Sample the allocation that crosses each multiple of the interval
+   // so the weights give an unbiased estimate of the bytes allocated
+   if (__atomic_sub_fetch(&(p->countdown), size, __ATOMIC_RELAXED) > 0)
+      return;
+
+   // May walk the JIT stack so must be called without holding the lock
+   ident_t site = (*p->site_fn)() ?: ident_new("(unknown)");
+
+   SCOPED_LOCK(m->lock);
+
+   const int64_t countdown = relaxed_load(&(p->countdown));
+   if (countdown > 0)
+      return;   // Another thread took this sample
+
+   const uint64_t nsamples = -countdown / p->interval + 1;
+   const uint64_t weight = nsamples * p->interval;
+   __atomic_add_fetch(&(p->countdown), weight, __ATOMIC_RELAXED);
+
+   unsigned index = (uintptr_t)hash_get(p->index, site);
+   if (index == 0) {
+      APUSH(p->sites, ((heap_site_t){ .site = site }));
+      hash_put(p->index, site, (void *)(uintptr_t)p->sites.count);
+      index = p->sites.count;
+   }
+
+   heap_site_t *hs = &(p->sites.items[index - 1]);
+   hs->live += weight;
+   hs->total += weight;
+
+   APUSH(p->samples, ((heap_sample_t){ ptr, weight, index - 1 }));
+
+   p->live += weight;
+}
+
+static void mspace_profile_gc(mspace_t *m, bit_mask_t *live)
+{
+   heap_profile_t *p = m->profile;
+
+   int wptr = 0;
+   for (int i = 0; i < p->samples.count; i++) {
+      const heap_sample_t s = p->samples.items[i];
+      const size_t line = ((char *)s.ptr - m->space) / LINE_SIZE;
+      if (mask_test(live, line))
+         p->samples.items[wptr++] = s;
+      else {
+         p->sites.items[s.site].live -= s.weight;
+         p->live -= s.weight;
+      }
+   }
+   ATRIM(p->samples, wptr);
+
+   p->num_gc++;
+
+   // Only report when the live heap reaches a new high to avoid
+   // flooding the output during long simulations
+   if (p->live > p->peak) {
+      p->peak = p->live;
+
+      char *title LOCAL = xasprintf("Heap profile after GC %u", p->num_gc);
+      mspace_profile_print(m, title, PROFILE_GC_TOP);
+   }
+}
+
+static int heap_site_cmp(const void *a, const void *b)
+{
+   const heap_site_t *sa = *(const heap_site_t **)a;
+   const heap_site_t *sb = *(const heap_site_t **)b;
+
+   if (sa->live != sb->live)
+      return sa->live < sb->live ? 1 : -1;
+   else if (sa->total != sb->total)
+      return sa->total < sb->total ? 1 : -1;
+   else
+      return 0;
+}
+
+static void mspace_profile_print(mspace_t *m, const char *title, int max)
+{
+   heap_profile_t *p = m->profile;
+
+   const heap_site_t **sorted =
+      xmalloc_array(p->sites.count, sizeof(heap_site_t *));
+   for (int i = 0; i < p->sites.count; i++)
+      sorted[i] = &(p->sites.items[i]);
+
+   qsort(sorted, p->sites.count, sizeof(heap_site_t *), heap_site_cmp);
+
+   nvc_printf("\n$bold$%s$$ (%"PRIu64" bytes live, sampled every %zu "
+              "bytes)\n\n", title, p->live, p->interval);
+   nvc_printf("   %12s %12s  %s\n", "Live (B)", "Total (B)", "Site");
+
+   for (int i = 0; i < p->sites.count && i < max; i++)
+      nvc_printf("   %12"PRIu64" %12"PRIu64"  %s\n", sorted[i]->live,
+                 sorted[i]->total, istr(sorted[i]->site));
+
+   free(sorted);
+}
+
+static bool mspace_try_grow(mspace_t *m, size_t size)
+{
+   // There may be enough free space after a collection but no fragment
+   // large enough for SIZE bytes
+   SCOPED_LOCK(m->lock);
+   return mspace_grow(m, (size + LINE_SIZE) / LINE_SIZE);
+}
+
+static bool mspace_large_pressure(mspace_t *m)
+{
+   // Large objects are only freed by a full collection which would
+   // otherwise not happen until the small object heap fills up
+   SCOPED_LOCK(m->lock);
+
+   const size_t limit = MAX(m->activelines * LINE_SIZE, m->large_live);
+   if (m->large_new < limit)
+      return false;
+
+   m->need_major = true;
+   return true;
+}
+
 void *mspace_alloc(mspace_t *m, size_t size)
 {
    if (size == 0)
@@ -233,14 +787,31 @@ void *mspace_alloc(mspace_t *m, size_t size)
       mspace_gc(m);
 #endif
 
-   int retry = 1;
-   do {
+   if (size >= LARGE_OBJECT_SIZE) {
+      if (mspace_large_pressure(m))
+         mspace_gc(m);
+
+      void *ptr = mspace_alloc_large(m, size);
+      if (ptr != NULL) {
+         stat_add(STAT_HEAP_BYTES, size);
+         return ptr;
+      }
+   }
+
+   for (int attempt = 0;; attempt++) {
       void *ptr = mspace_try_alloc(m, size);
-      if (ptr != NULL)
+      if (ptr != NULL) {
+         stat_add(STAT_HEAP_BYTES, size);
+         if (unlikely(m->profile != NULL))
+            mspace_profile_sample(m, ptr, size);
          return ptr;
+      }
 
-      mspace_gc(m);
-   } while (retry--);
+      if (attempt < 2)
+         mspace_gc(m);
+      else if (!mspace_try_grow(m, size))
+         break;
+   }
 
    if (m->oomfn) {
       (*m->oomfn)(m, size);
@@ -265,17 +836,42 @@ void mspace_set_oom_handler(mspace_t *m, mspace_oom_fn_t fn)
    m->oomfn = fn;
 }
 
+void mspace_set_profiler(mspace_t *m, size_t interval, mspace_site_fn_t fn)
+{
+   assert(interval > 0);
+
+   if (m->profile != NULL)
+      return;   // Shared between models by the JIT
+
+   heap_profile_t *p = xcalloc(sizeof(heap_profile_t));
+   p->interval  = interval;
+   p->countdown = interval;
+   p->site_fn   = fn;
+   p->index     = hash_new(64);
+
+   m->profile = p;
+}
+
 mptr_t mptr_new(mspace_t *m, const char *name)
 {
    SCOPED_LOCK(m->lock);
 
-   mptr_t ptr;
-   if (m->free_mptrs != NULL) {
-      ptr = m->free_mptrs;
-      m->free_mptrs = ptr->next;
+   if (m->free_mptrs == NULL) {
+      // Allocate root slots in chunks so those created together, such
+      // as the state pointers for all the processes in a design, are
+      // adjacent in memory rather than scattered across the C heap
+      mptr_chunk_t *c = xmalloc(sizeof(mptr_chunk_t));
+      c->next = m->mptr_chunks;
+      m->mptr_chunks = c;
+
+      for (int i = MPTR_CHUNK_SIZE - 1; i >= 0; i--) {
+         c->items[i].next = m->free_mptrs;
+         m->free_mptrs = &(c->items[i]);
+      }
    }
-   else
-      ptr = xmalloc(sizeof(struct _mptr));
+
+   mptr_t ptr = m->free_mptrs;
+   m->free_mptrs = ptr->next;
 
    if (m->roots != NULL) {
       assert(m->roots->prev == NULL);
@@ -418,26 +1014,374 @@ static inline bool is_mspace_ptr(mspace_t *m, char *p)
    return p >= m->space && p < m->space + m->maxsize;
 }
 
+__attribute__((always_inline))
+static inline bool mspace_find_object(mspace_t *m, intptr_t p, uint64_t *enc)
+{
+   if (!is_mspace_ptr(m, (char *)p))
+      return false;
+
+   ptrdiff_t line = ((char *)p - m->space) / LINE_SIZE;
+   assert(line < UINT32_MAX);   // Enforced by MAX_HEAP
+
+   if (line >= m->activelines)
+      return false;   // Reserved but not yet used for allocation
+
+   // Scan backwards to the start of the object
+   line = mask_scan_backwards(&(m->headmask), line);
+   assert(line != -1);
+
+   size_t objlen = 1;
+   if (line + 1 < m->maxlines)
+      objlen += mask_count_clear(&(m->headmask), line + 1);
+   assert(objlen < UINT32_MAX);
+
+   *enc = ((uint64_t)line << 32) | objlen;
+   return true;
+}
+
+static void mspace_mark_large(mspace_t *m, intptr_t p, gc_state_t *state)
+{
+   const int index = mspace_find_large(m, (char *)p);
+   if (index == -1 || m->large.items[index].marked)
+      return;
+
+   m->large.items[index].marked = true;
+   APUSH(state->largelist, index);
+}
+
 static void mspace_mark_root(mspace_t *m, intptr_t p, gc_state_t *state)
 {
-   if (is_mspace_ptr(m, (char *)p)) {
-      ptrdiff_t line = ((char *)p - m->space) / LINE_SIZE;
-      assert(line < UINT32_MAX);   // Enforced by MAX_HEAP
+   uint64_t enc;
+   if (!mspace_find_object(m, p, &enc)) {
+      if (unlikely(m->large.count > 0))
+         mspace_mark_large(m, p, state);
+      return;
+   }
+
+   const uint32_t line = enc >> 32;
+   const uint32_t objlen = enc & 0xffffffff;
+
+   if (mask_test(&(state->markmask), line))
+      return;
+   else if (state->oldmask != NULL && mask_test(state->oldmask, line))
+      return;   // Assumed live during a minor collection
+
+   mask_set_range(&(state->markmask), line, objlen);
+   APUSH(state->worklist, enc);
+}
+
+__attribute__((no_sanitize_address))
+static void mspace_scan_object(mspace_t *m, uint64_t enc, gc_state_t *state)
+{
+   const uint32_t line = enc >> 32;
+   const uint32_t objlen = enc & 0xffffffff;
+
+   for (size_t i = 0; i < objlen; i++) {
+      const ptrdiff_t off = (uintptr_t)(line + i) * LINE_SIZE;
+      intptr_t *words = (intptr_t *)(m->space + off);
+      for (int j = 0; j < LINE_WORDS; j++)
+         mspace_mark_root(m, words[j], state);
+   }
+}
+
+__attribute__((no_sanitize_address))
+static void mspace_scan_words(mspace_t *m, char *base, size_t size,
+                              gc_state_t *state)
+{
+   intptr_t *words = (intptr_t *)base;
+   for (size_t i = 0; i < size / sizeof(intptr_t); i++)
+      mspace_mark_root(m, words[i], state);
+}
+
+static void mspace_scan_large(mspace_t *m, int index, gc_state_t *state)
+{
+   const large_object_t lo = m->large.items[index];
+
+#if defined SPARSE_LARGE_OBJECTS && defined __linux__
+   // Pages that were never touched must be zero so use the page map to
+   // skip them rather than faulting in the whole object
+   static int pagemap_fd = -2;
+   if (pagemap_fd == -2)
+      pagemap_fd = open("/proc/self/pagemap", O_RDONLY | O_CLOEXEC);
+
+   if (pagemap_fd >= 0) {
+      const size_t pagesize = sysconf(_SC_PAGESIZE);
+      const size_t npages = (lo.size + pagesize - 1) / pagesize;
+      const off_t first = (uintptr_t)lo.ptr / pagesize;
+
+      uint64_t entries[LARGE_SCAN_PAGES];
+      for (size_t page = 0; page < npages; page += LARGE_SCAN_PAGES) {
+         const size_t count = MIN(npages - page, LARGE_SCAN_PAGES);
+         const size_t nbytes = count * sizeof(uint64_t);
+         const off_t where = (first + page) * sizeof(uint64_t);
+         if (pread(pagemap_fd, entries, nbytes, where) != nbytes) {
+            // Assume all the pages may be present
+            memset(entries, 0xff, nbytes);
+         }
+
+         for (size_t i = 0; i < count; i++) {
+            // Bit 63 is set if the page is present and 62 if swapped
+            if (!(entries[i] >> 62))
+               continue;
+
+            const size_t off = (page + i) * pagesize;
+            mspace_scan_words(m, lo.ptr + off, MIN(pagesize, lo.size - off),
+                              state);
+         }
+      }
+
+      return;
+   }
+#endif
 
-      // Scan backwards to the start of the object
-      line = mask_scan_backwards(&(m->headmask), line);
-      assert(line != -1);
+   mspace_scan_words(m, lo.ptr, lo.size, state);
+}
+
+static void mspace_sweep_large(mspace_t *m, bool minor)
+{
+   int wptr = 0;
+   for (int i = 0; i < m->large.count; i++) {
+      large_object_t *lo = &(m->large.items[i]);
+      if (lo->marked || minor) {
+         lo->marked = false;
+         m->large.items[wptr++] = *lo;
+      }
+      else
+         nvc_munmap(lo->ptr, lo->mapsz);
+   }
+   ATRIM(m->large, wptr);
 
-      size_t objlen = 1;
-      if (line + 1 < m->maxlines)
-         objlen += mask_count_clear(&(m->headmask), line + 1);
-      assert(objlen < UINT32_MAX);
+   if (!minor) {
+      m->large_live = 0;
+      m->large_new = 0;
+   }
 
-      if (!mask_test(&(state->markmask), line)) {
-         mask_set_range(&(state->markmask), line, objlen);
+   m->large_lo = m->large_hi = NULL;
+   for (int i = 0; i < m->large.count; i++) {
+      const large_object_t *lo = &(m->large.items[i]);
+      if (!minor)
+         m->large_live += lo->size;
+      if (i == 0 || lo->ptr < m->large_lo)
+         m->large_lo = lo->ptr;
+      if (i == 0 || lo->ptr + lo->mapsz > m->large_hi)
+         m->large_hi = lo->ptr + lo->mapsz;
+   }
+}
 
-         uint64_t enc = ((uint64_t)line << 32) | objlen;
-         APUSH(state->worklist, enc);
+#ifdef PAGE_WRITE_BARRIER
+__attribute__((no_sanitize_address))
+static void mspace_scan_dirty(mspace_t *m, gc_state_t *state)
+{
+   // Old objects on pages written since the last collection may now
+   // point to newer objects
+   const size_t page_lines = m->pagesize / LINE_SIZE;
+   for (size_t page = -1; mask_iter(&(m->dirtymask), &page);) {
+      const size_t first = page * page_lines;
+      const size_t last = MIN(first + page_lines, m->maxlines);
+      for (size_t line = first; line < last; line++) {
+         if (!mask_test(&(m->oldmask), line))
+            continue;
+
+         intptr_t *words = (intptr_t *)(m->space + line * LINE_SIZE);
+         for (int j = 0; j < LINE_WORDS; j++)
+            mspace_mark_root(m, words[j], state);
+      }
+   }
+}
+#endif
+
+static bool mspace_claim_object(bit_mask_t *mask, uint64_t enc)
+{
+   const size_t line = enc >> 32;
+   const size_t end = line + (enc & 0xffffffff);
+
+   assert(mask->size > 64);
+   uint64_t *words = mask->ptr;
+
+   // Only the thread which sets the bit for the first line of the
+   // object scans it
+   const uint64_t bit = UINT64_C(1) << (line % 64);
+   if (__atomic_fetch_or(&(words[line / 64]), bit, __ATOMIC_RELAXED) & bit)
+      return false;
+
+   for (size_t i = line + 1; i < end;) {
+      const int shift = i % 64, nbits = MIN(64 - shift, end - i);
+      const uint64_t ones = nbits == 64 ? ~UINT64_C(0)
+         : ((UINT64_C(1) << nbits) - 1);
+      __atomic_fetch_or(&(words[i / 64]), ones << shift, __ATOMIC_RELAXED);
+      i += nbits;
+   }
+
+   return true;
+}
+
+static void mspace_lock_shared(gc_parallel_t *gp)
+{
+   while (atomic_xchg(&(gp->lock), 1))
+      spin_wait();
+}
+
+static void mspace_unlock_shared(gc_parallel_t *gp)
+{
+   atomic_store(&(gp->lock), 0);
+}
+
+static unsigned mspace_push_shared(gc_parallel_t *gp, const uint64_t *items,
+                                   unsigned count)
+{
+   mspace_lock_shared(gp);
+
+   const unsigned npush = MIN(count, gp->maxshared - gp->nshared);
+   memcpy(gp->shared + gp->nshared, items, npush * sizeof(uint64_t));
+   atomic_store(&(gp->nshared), gp->nshared + npush);
+
+   mspace_unlock_shared(gp);
+   return npush;
+}
+
+static unsigned mspace_pop_shared(gc_parallel_t *gp, uint64_t *items,
+                                  unsigned max)
+{
+   if (relaxed_load(&(gp->nshared)) == 0)
+      return 0;
+
+   mspace_lock_shared(gp);
+
+   // Take a share of the remaining work proportional to the number
+   // of threads so that it is spread out evenly
+   const unsigned avail = gp->nshared;
+   if (avail == 0) {
+      mspace_unlock_shared(gp);
+      return 0;
+   }
+
+   const unsigned npop = MIN(max, MAX(1, avail / gp->nthreads));
+   memcpy(items, gp->shared + avail - npop, npop * sizeof(uint64_t));
+   atomic_store(&(gp->nshared), avail - npop);
+
+   mspace_unlock_shared(gp);
+   return npop;
+}
+
+__attribute__((no_sanitize_address))
+static void mspace_mark_parallel_cb(void *arg)
+{
+   // Called from a signal handler on suspended threads so must not
+   // allocate memory or take any locks
+
+   gc_parallel_t *gp = arg;
+   mspace_t *m = gp->mspace;
+
+   const int slot = atomic_fetch_add(&(gp->nextslot), 1);
+   if (slot >= gp->nthreads)
+      return;   // More suspended threads than available CPUs
+
+   uint64_t *stack = gp->stacks + slot * MARK_STACK_SIZE;
+   unsigned count = 0;
+
+   for (;;) {
+      while (count > 0) {
+         const uint64_t enc = stack[--count];
+         const uintptr_t line = enc >> 32;
+         uint32_t objlen = enc & 0xffffffff;
+
+         if (objlen > MARK_SPLIT_LINES) {
+            // Push the tail of a large object back on to the stack to
+            // bound the number of entries added here
+            const uint64_t line2 = line + MARK_SPLIT_LINES;
+            stack[count++] = (line2 << 32) | (objlen - MARK_SPLIT_LINES);
+            objlen = MARK_SPLIT_LINES;
+         }
+
+         intptr_t *words = (intptr_t *)(m->space + line * LINE_SIZE);
+         for (size_t i = 0; i < objlen * LINE_WORDS; i++) {
+            uint64_t child;
+            if (!mspace_find_object(m, words[i], &child))
+               continue;
+            else if (!mspace_claim_object(gp->markmask, child))
+               continue;
+
+            if (count == MARK_STACK_SIZE) {
+               // Move the oldest half of the stack to the shared list
+               const unsigned half = MARK_STACK_SIZE / 2;
+               const unsigned npush = mspace_push_shared(gp, stack, half);
+               if (npush == 0) {
+                  // The object is marked but its children have not been
+                  // scanned: this is detected and fixed up afterwards
+                  atomic_store(&(gp->overflow), true);
+                  continue;
+               }
+
+               memmove(stack, stack + npush,
+                       (count - npush) * sizeof(uint64_t));
+               count -= npush;
+            }
+
+            stack[count++] = child;
+         }
+
+         if (count > 1 && relaxed_load(&(gp->idle)) > 0
+             && relaxed_load(&(gp->nshared)) == 0) {
+            // Other threads are starved of work
+            const unsigned npush = mspace_push_shared(gp, stack, count / 2);
+            memmove(stack, stack + npush, (count - npush) * sizeof(uint64_t));
+            count -= npush;
+         }
+      }
+
+      if ((count = mspace_pop_shared(gp, stack, MARK_STACK_SIZE / 2)) > 0)
+         continue;
+
+      atomic_add(&(gp->idle), 1);
+
+      for (;;) {
+         if (relaxed_load(&(gp->nshared)) > 0) {
+            atomic_add(&(gp->idle), -1);
+            break;
+         }
+         else if (atomic_load(&(gp->idle)) == gp->nthreads)
+            return;
+         else
+            spin_wait();
+      }
+   }
+}
+
+static void mspace_mark_parallel(mspace_t *m, gc_state_t *state, int nhelpers)
+{
+   gc_parallel_t gp = {
+      .mspace    = m,
+      .markmask  = &(state->markmask),
+      .nthreads  = MIN(nhelpers + 1, nvc_nprocs()),
+      .maxshared = MAX(SHARED_STACK_SIZE, state->worklist.count),
+   };
+
+   gp.stacks = xmalloc_array(gp.nthreads * MARK_STACK_SIZE, sizeof(uint64_t));
+   gp.shared = xmalloc_array(gp.maxshared, sizeof(uint64_t));
+
+   memcpy(gp.shared, state->worklist.items,
+          state->worklist.count * sizeof(uint64_t));
+   gp.nshared = state->worklist.count;
+   state->worklist.count = 0;
+
+   stop_world_assist(mspace_mark_parallel_cb, &gp);
+
+   assert(gp.nextslot == nhelpers + 1);
+   assert(gp.nshared == 0);
+
+   free(gp.stacks);
+   free(gp.shared);
+
+   if (gp.overflow) {
+      // Some objects were marked without scanning their children so
+      // rescan every marked object in the heap
+      for (size_t line = -1; mask_iter(&(state->markmask), &line);) {
+         if (mask_test(&(m->headmask), line)) {
+            uint64_t enc;
+            if (mspace_find_object(m, (intptr_t)(m->space + line * LINE_SIZE),
+                                   &enc))
+               mspace_scan_object(m, enc, state);
+         }
       }
    }
 }
@@ -466,11 +1410,19 @@ static void mspace_gc(mspace_t *m)
    return;   // Cannot reliably suspend threads with tsan
 #endif
 
+   TIMELINE_BEGIN("gc", NULL);
+
    gc_state_t state = {};
    mask_init(&(state.markmask), m->maxlines);
 
    SCOPED_LOCK(m->lock);
 
+   // A minor collection only marks objects allocated since the last
+   // collection and treats older objects as live
+   const bool minor = m->generational && !m->need_major;
+   if (minor)
+      state.oldmask = &(m->oldmask);
+
    stop_world(mspace_suspend_cb, &state);
 
    for (int i = 0; i < MAX_THREADS; i++) {
@@ -515,21 +1467,43 @@ static void mspace_gc(mspace_t *m)
          mspace_mark_root(m, *(intptr_t *)p, &state);
    }
 
-   while (state.worklist.count > 0) {
-      const uint64_t enc = APOP(state.worklist);
-      const uint32_t line = enc >> 32;
-      const uint32_t objlen = enc & 0xffffffff;
+#ifdef PAGE_WRITE_BARRIER
+   if (minor)
+      mspace_scan_dirty(m, &state);
+#endif
 
-      for (size_t i = 0; i < objlen; i++) {
-         const ptrdiff_t off = (uintptr_t)(line + i) * LINE_SIZE;
-         intptr_t *words = (intptr_t *)(m->space + off);
-         for (int j = 0; j < LINE_WORDS; j++)
-            mspace_mark_root(m, words[j], &state);
+   if (minor) {
+      // Writes to large objects are not tracked so treat them all as
+      // roots during a minor collection
+      for (int i = 0; i < m->large.count; i++) {
+         m->large.items[i].marked = true;
+         APUSH(state.largelist, i);
       }
    }
 
+   // The parallel marker does not know about large objects
+   if (!minor && m->parallel && m->maxlines > 64 && m->large.count == 0
+       && state.worklist.count >= PARALLEL_MARK_MIN) {
+      const int nhelpers = stop_world_helpers();
+      if (nhelpers > 0 && nvc_nprocs() > 1)
+         mspace_mark_parallel(m, &state, nhelpers);
+   }
+
+   do {
+      while (state.worklist.count > 0) {
+         const uint64_t enc = APOP(state.worklist);
+         mspace_scan_object(m, enc, &state);
+      }
+
+      while (state.largelist.count > 0)
+         mspace_scan_large(m, APOP(state.largelist), &state);
+   } while (state.worklist.count > 0);
+
+   if (m->large.count > 0)
+      mspace_sweep_large(m, minor);
+
 #if ASAN_ENABLED
-   for (int i = 0; i < m->maxlines; i++) {
+   for (int i = 0; i < m->activelines; i++) {
       if (!mask_test(&(state.markmask), i))
          ASAN_POISON(m->space + i * LINE_SIZE, LINE_SIZE);
    }
@@ -542,45 +1516,127 @@ static void mspace_gc(mspace_t *m)
    m->free_list = NULL;
 
    int freefrags = 0, freelines = 0;
-   free_list_t **tail = &(m->free_list);
-   for (size_t line = 0; line < m->maxlines;) {
-      const size_t clear = mask_count_clear(&(state.markmask), line);
-      if (clear == 0)
-         line++;
-      else {
-         free_list_t *f = xmalloc(sizeof(free_list_t));
-         f->next = NULL;
-         f->ptr  = m->space + line * LINE_SIZE;
-         f->size = clear * LINE_SIZE;
+   bit_mask_t *live = &(state.markmask);
+   if (m->generational) {
+      if (minor)
+         mask_union(&(m->oldmask), &(state.markmask));
+      else
+         mask_copy(&(m->oldmask), &(state.markmask));
+
+      live = &(m->oldmask);
+   }
 
-         *tail = f;
-         tail = &(f->next);
+   if (m->lazy_sweep && !m->generational) {
+      // Free lines are added to the free list on demand by
+      // mspace_try_alloc after the world is restarted
+      mask_free(&(m->livemask));
+      m->livemask = state.markmask;
+      m->sweepline = 0;
+   }
+   else {
+      free_list_t **tail = &(m->free_list);
+      for (size_t line = 0; line < m->activelines;) {
+         const size_t clear =
+            MIN(mask_count_clear(live, line), m->activelines - line);
+         if (clear == 0)
+            line++;
+         else {
+            free_list_t *f = xmalloc(sizeof(free_list_t));
+            f->next = NULL;
+            f->ptr  = m->space + line * LINE_SIZE;
+            f->size = clear * LINE_SIZE;
 
-         mask_set_range(&(m->headmask), line, clear);
+            *tail = f;
+            tail = &(f->next);
 
-         freefrags++;
-         freelines += clear;
+            mask_set_range(&(m->headmask), line, clear);
 
-         line += clear;
+            freefrags++;
+            freelines += clear;
+
+            line += clear;
+         }
       }
    }
 
+#ifdef PAGE_WRITE_BARRIER
+   if (m->generational) {
+      // Collect the whole heap next time if this did not free enough
+      // space or there have been many minor collections in a row
+      if (minor) {
+         m->num_minor++;
+         m->need_major = m->num_minor >= MAX_MINOR_GC
+            || freelines < m->activelines / 4;
+      }
+      else {
+         m->num_minor = 0;
+         m->need_major = false;
+      }
+
+      mspace_protect(m);
+   }
+#endif
+
    start_world();
 
-   if (opt_get_verbose(OPT_GC_VERBOSE, NULL)) {
-      const int ticks = get_timestamp_us() - start_ticks;
-      debugf("GC: allocated %zd/%zu; fragmentation %.2g%% [%d us]",
-             mask_popcount(&(state.markmask)) * LINE_SIZE, m->maxsize,
-             ((double)(freefrags - 1) / (double)freelines) * 100.0, ticks);
+   TIMELINE_END("gc");
+
+   const int ticks = get_timestamp_us() - start_ticks;
+
+   stat_add(STAT_GC_CYCLES, 1);
+   stat_add(STAT_GC_US, ticks);
+   stat_sample(STAT_GC_PAUSE_US, ticks);
 
+   if (m->lazy_sweep && !m->generational)
+      live = &(m->livemask);
+
+   const size_t live_bytes = mask_popcount(live) * LINE_SIZE;
+   relaxed_store(&(m->last_live), live_bytes);
+
+   if (opt_get_verbose(OPT_GC_VERBOSE, NULL)) {
+      if (m->lazy_sweep && !m->generational)
+         debugf("GC: allocated %zd/%zu; lazy sweep [%d us]",
+                live_bytes, m->activelines * LINE_SIZE, ticks);
+      else
+         debugf("GC: allocated %zd/%zu; fragmentation %.2g%%%s [%d us]",
+                live_bytes, m->activelines * LINE_SIZE,
+                ((double)(freefrags - 1) / (double)freelines) * 100.0,
+                minor ? "; minor" : "", ticks);
+
+      const int bucket = ticks < 32 ? 0 : 63 - __builtin_clzll(ticks) - 4;
+      m->pauses[MIN(bucket, PAUSE_BUCKETS - 1)]++;
+
+      m->max_pause = MAX(m->max_pause, ticks);
+      m->peak_live = MAX(m->peak_live, live_bytes);
       m->total_gc += ticks;
       m->num_cycles++;
    }
 
-   mask_free(&(state.markmask));
+   if (!minor) {
+      // Grow the heap when a collection frees less than the target
+      // fraction so the next one is not triggered almost immediately
+      const size_t livelines = live_bytes / LINE_SIZE;
+      const size_t wantlines = livelines * 100 / (100 - HEAP_FREE_TARGET);
+      if (wantlines > m->activelines)
+         mspace_grow(m, wantlines - m->activelines);
+   }
+
+   if (m->profile != NULL)
+      mspace_profile_gc(m, live);
+
+   if (!m->lazy_sweep || m->generational)
+      mask_free(&(state.markmask));
 
    assert(state.worklist.count == 0);
    ACLEAR(state.worklist);
+   ACLEAR(state.largelist);
+}
+
+void mspace_get_usage(mspace_t *m, size_t *live, size_t *maxsize)
+{
+   // Live bytes are only known precisely after a collection
+   *live = relaxed_load(&(m->last_live));
+   *maxsize = m->maxsize;
 }
 
 void *mspace_find(mspace_t *m, void *ptr, size_t *size)
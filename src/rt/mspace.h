@@ -26,9 +26,13 @@ typedef struct _mptr *mptr_t;
 typedef void *UNSAFE_MPTR;
 
 typedef void (*mspace_oom_fn_t)(mspace_t *, size_t);
+typedef ident_t (*mspace_site_fn_t)(void);
 
 #define TLAB_SIZE (64 * 1024)
 
+// Objects at least this size are mapped outside the heap
+#define LARGE_OBJECT_SIZE (16 * 1024 * 1024)
+
 // The code generator knows the layout of this struct
 typedef struct _tlab {
    mspace_t *mspace;
@@ -55,7 +59,11 @@ void *mspace_alloc(mspace_t *m, size_t size);
 void *mspace_alloc_array(mspace_t *m, int nelems, size_t size);
 void *mspace_alloc_flex(mspace_t *m, size_t fixed, int nelems, size_t size);
 void mspace_set_oom_handler(mspace_t *m, mspace_oom_fn_t fn);
+void mspace_set_profiler(mspace_t *m, size_t interval, mspace_site_fn_t fn);
+void mspace_get_usage(mspace_t *m, size_t *live, size_t *maxsize);
 void *mspace_find(mspace_t *m, void *ptr, size_t *size);
+void mspace_touch(void *ptr, size_t size);
+void mspace_bzero(mspace_t *m, void *ptr, size_t size);
 
 tlab_t *tlab_acquire(mspace_t *m);
 void tlab_release(tlab_t *t);
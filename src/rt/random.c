@@ -18,6 +18,8 @@
 #include "util.h"
 #include "jit/jit.h"
 #include "option.h"
+#include "rt/model.h"
+#include "rt/random.h"
 #include "thread.h"
 
 #include <assert.h>
@@ -77,6 +79,12 @@ static uint32_t mt19937_next(void)
    return y;
 }
 
+void reset_random(void)
+{
+   SCOPED_LOCK(lock);
+   mti = MT_N + 1;   // Reinitialise from OPT_RANDOM_SEED on next use
+}
+
 uint32_t get_random(void)
 {
    SCOPED_LOCK(lock);
@@ -87,8 +95,51 @@ uint32_t get_random(void)
    return mt19937_next();
 }
 
+static uint64_t splitmix64(uint64_t *x)
+{
+   uint64_t z = (*x += UINT64_C(0x9e3779b97f4a7c15));
+   z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+   z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+   return z ^ (z >> 31);
+}
+
+void rng_stream_init(rng_stream_t *rng, const char *name)
+{
+   // Seed from the hierarchical name so each stream is reproducible
+   // regardless of which thread or in what order it first runs
+   uint64_t x = UINT64_C(0xcbf29ce484222325);
+   for (const char *p = name; *p; p++)
+      x = (x ^ (unsigned char)*p) * UINT64_C(0x100000001b3);
+
+   x ^= (uint64_t)opt_get_int(OPT_RANDOM_SEED) << 32;
+
+   rng->s[0] = splitmix64(&x);
+   rng->s[1] = splitmix64(&x);
+
+   if (rng->s[0] == 0 && rng->s[1] == 0)
+      rng->s[1] = 1;   // All-zero state is a fixed point
+}
+
+uint32_t rng_stream_next(rng_stream_t *rng)
+{
+   // xoroshiro128++ by David Blackman and Sebastiano Vigna
+   const uint64_t s0 = rng->s[0];
+   uint64_t s1 = rng->s[1];
+   const uint64_t result = ((s0 + s1) << 17 | (s0 + s1) >> 47) + s0;
+
+   s1 ^= s0;
+   rng->s[0] = (s0 << 49 | s0 >> 15) ^ s1 ^ (s1 << 21);
+   rng->s[1] = s1 << 28 | s1 >> 36;
+
+   return result >> 32;
+}
+
 DLLEXPORT
 void _nvc_random_get_next(jit_scalar_t *args)
 {
-   args[0].integer = get_random();
+   rng_stream_t *rng = get_active_rng();
+   if (rng != NULL)
+      args[0].integer = rng_stream_next(rng);
+   else
+      args[0].integer = get_random();
 }
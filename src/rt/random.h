@@ -20,6 +20,13 @@
 
 #include "prim.h"
 
+typedef struct {
+   uint64_t s[2];
+} rng_stream_t;
+
 uint32_t get_random(void);
+void reset_random(void);
+void rng_stream_init(rng_stream_t *rng, const char *name);
+uint32_t rng_stream_next(rng_stream_t *rng);
 
 #endif  // _RT_RANDOM_H
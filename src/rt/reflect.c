@@ -387,6 +387,8 @@ typedef struct _subtype_mirror {
 
 static subtype_mirror *get_subtype_mirror(void *context, type_t type,
                                           const jit_scalar_t *bounds);
+static value_mirror *get_value_mirror(void *context, jit_scalar_t value,
+                                      type_t type, const jit_scalar_t *bounds);
 
 static void *zero_alloc(size_t size)
 {
@@ -486,17 +488,53 @@ static jit_scalar_t *get_null_array(type_t type)
    return bounds;
 }
 
-static value_mirror *get_value_mirror(void *context, jit_scalar_t value,
-                                      type_t type, const jit_scalar_t *bounds)
+static size_t value_mirror_size(type_t type)
+{
+   // Scalar value mirrors are allocated in the same block as their
+   // owning value mirror
+   if (type_is_integer(type))
+      return sizeof(value_mirror) + sizeof(integer_value_mirror);
+   else if (type_is_enum(type))
+      return sizeof(value_mirror) + sizeof(enumeration_value_mirror);
+   else if (type_is_real(type))
+      return sizeof(value_mirror) + sizeof(floating_value_mirror);
+   else if (type_is_physical(type))
+      return sizeof(value_mirror) + sizeof(physical_value_mirror);
+   else
+      return sizeof(value_mirror);
+}
+
+static value_mirror *get_literal_mirror(subtype_mirror *sm, int64_t pos)
 {
-   value_mirror *vm = zero_alloc(sizeof(value_mirror));
+   // Value mirrors are immutable so an enumeration value can share the
+   // mirror of the corresponding literal in the subtype
+   if (sm->pt.f_class != CLASS_ENUMERATION)
+      return NULL;
+
+   ffi_uarray_t *literals = sm->pt.f_enumeration->pt.f_literals;
+   if (literals == NULL || pos < 0 || pos >= literals->dims[0].length)
+      return NULL;
+
+   enumeration_value_mirror *evm =
+      ((enumeration_value_mirror **)literals->ptr)[pos];
+   if (evm == NULL || evm->pt.f_owner->pt.f_subtype != sm)
+      return NULL;
+
+   return evm->pt.f_owner;
+}
+
+static value_mirror *init_value_mirror(void *context, void *mem,
+                                       jit_scalar_t value, type_t type,
+                                       subtype_mirror *sm)
+{
+   value_mirror *vm = mem;
 
    vm->access = &(vm->pt);
    vm->pt.context = context;
-   vm->pt.f_subtype = get_subtype_mirror(context, type, bounds);
+   vm->pt.f_subtype = sm;
 
    if (type_is_integer(type)) {
-      integer_value_mirror *ivm = zero_alloc(sizeof(integer_value_mirror));
+      integer_value_mirror *ivm = (void *)(vm + 1);
       ivm->access = &(ivm->pt);
 
       ivm->pt.context = context;
@@ -508,8 +546,7 @@ static value_mirror *get_value_mirror(void *context, jit_scalar_t value,
       vm->pt.f_integer = ivm;
    }
    else if (type_is_enum(type)) {
-      enumeration_value_mirror *evm =
-         zero_alloc(sizeof(enumeration_value_mirror));
+      enumeration_value_mirror *evm = (void *)(vm + 1);
       evm->access = &(evm->pt);
 
       evm->pt.context = context;
@@ -517,19 +554,26 @@ static value_mirror *get_value_mirror(void *context, jit_scalar_t value,
       evm->pt.f_owner = vm;
       evm->pt.f_subtype = vm->pt.f_subtype->pt.f_enumeration;
 
-      LOCAL_TEXT_BUF tb = tb_new();
+      // Reuse the image string from the literal of the base type
       type_t base = type_base_recur(type);
-      tb_istr(tb, tree_ident(type_enum_literal(base, value.integer)));
-      if (tb_get(tb)[0] != '\'')
-         tb_downcase(tb);
+      subtype_mirror *bsm = get_subtype_mirror(context, base, NULL);
+      value_mirror *lit = get_literal_mirror(bsm, value.integer);
+      if (lit != NULL)
+         evm->pt.f_image = lit->pt.f_enumeration->pt.f_image;
+      else {
+         LOCAL_TEXT_BUF tb = tb_new();
+         tb_istr(tb, tree_ident(type_enum_literal(base, value.integer)));
+         if (tb_get(tb)[0] != '\'')
+            tb_downcase(tb);
 
-      evm->pt.f_image = get_string(tb_get(tb));
+         evm->pt.f_image = get_string(tb_get(tb));
+      }
 
       vm->pt.f_class = CLASS_ENUMERATION;
       vm->pt.f_enumeration = evm;
    }
    else if (type_is_real(type)) {
-      floating_value_mirror *fvm = zero_alloc(sizeof(floating_value_mirror));
+      floating_value_mirror *fvm = (void *)(vm + 1);
       fvm->access = &(fvm->pt);
 
       fvm->pt.context = context;
@@ -564,9 +608,30 @@ static value_mirror *get_value_mirror(void *context, jit_scalar_t value,
       const int ebytes = type_byte_width(elem);
 
       value_mirror **elems = avm->pt.f_elements->ptr;
-      for (int i = 0; i < total; i++) {
-         jit_scalar_t elt = load_scalar(value.pointer, i, ebytes);
-         elems[i] = get_value_mirror(context, elt, elem, NULL);
+      if (type_is_scalar(elem)) {
+         // Look up the element subtype once and allocate the mirrors
+         // for all elements that cannot be shared in a single block
+         subtype_mirror *esm = get_subtype_mirror(context, elem, NULL);
+         const size_t esize = value_mirror_size(elem);
+
+         void *block = NULL;
+         for (int i = 0, nblock = 0; i < total; i++) {
+            jit_scalar_t elt = load_scalar(value.pointer, i, ebytes);
+            if (type_is_enum(elem)
+                && (elems[i] = get_literal_mirror(esm, elt.integer)))
+               continue;
+            else if (block == NULL)
+               block = zero_alloc((total - i) * esize);
+
+            void *mem = block + (nblock++) * esize;
+            elems[i] = init_value_mirror(context, mem, elt, elem, esm);
+         }
+      }
+      else {
+         for (int i = 0; i < total; i++) {
+            jit_scalar_t elt = load_scalar(value.pointer, i, ebytes);
+            elems[i] = get_value_mirror(context, elt, elem, NULL);
+         }
       }
 
       vm->pt.f_class = CLASS_ARRAY;
@@ -667,7 +732,7 @@ static value_mirror *get_value_mirror(void *context, jit_scalar_t value,
       vm->pt.f_access = avm;
    }
    else if (type_is_physical(type)) {
-      physical_value_mirror *pvm = zero_alloc(sizeof(physical_value_mirror));
+      physical_value_mirror *pvm = (void *)(vm + 1);
       pvm->access = &(pvm->pt);
 
       pvm->pt.context = context;
@@ -696,6 +761,21 @@ static value_mirror *get_value_mirror(void *context, jit_scalar_t value,
    return vm;
 }
 
+static value_mirror *get_value_mirror(void *context, jit_scalar_t value,
+                                      type_t type, const jit_scalar_t *bounds)
+{
+   subtype_mirror *sm = get_subtype_mirror(context, type, bounds);
+
+   if (type_is_enum(type)) {
+      value_mirror *lit = get_literal_mirror(sm, value.integer);
+      if (lit != NULL)
+         return lit;
+   }
+
+   void *mem = zero_alloc(value_mirror_size(type));
+   return init_value_mirror(context, mem, value, type, sm);
+}
+
 static integer_value_mirror *get_integer_mirror(void *context, type_t type,
                                                 int64_t value)
 {
@@ -752,39 +832,73 @@ static bool safe_to_cache(type_t type)
       return true;
 }
 
-static subtype_mirror *get_subtype_mirror(void *context, type_t type,
-                                          const jit_scalar_t *bounds)
+static cache_elem_t *cache_probe(cache_elem_t *table, size_t size,
+                                 type_t type)
 {
-   internal_cache_pt *cache = get_cache(context);
+   assert(is_power_of_2(size));
 
-   for (int i = 0; i < cache->f_num_subtypes; i++) {
-      cache_elem_t *e = &(cache->f_subtype_cache[i]);
-      if (e->f_type == type)
-         return e->f_mirror;
+   for (size_t slot = mix_bits_64(type) & (size - 1);;
+        slot = (slot + 1) & (size - 1)) {
+      if (table[slot].f_type == type || table[slot].f_type == NULL)
+         return &(table[slot]);
    }
+}
 
-   subtype_mirror *sm = zero_alloc(sizeof(subtype_mirror));
-   sm->access = &(sm->pt);
-   sm->pt.context = context;
-
-   if (safe_to_cache(type)) {
-      if (cache->f_num_subtypes == cache->f_max_subtypes) {
-         const size_t new_max = MAX(cache->f_max_subtypes * 2, 128);
-         cache_elem_t *tmp = zero_alloc(new_max * sizeof(cache_elem_t));
+static subtype_mirror *cache_lookup(internal_cache_pt *cache, type_t type)
+{
+   if (cache->f_subtype_cache == NULL)
+      return NULL;
 
-         if (cache->f_subtype_cache != NULL)
-            memcpy(tmp, cache->f_subtype_cache,
-                   cache->f_max_subtypes * sizeof(cache_elem_t));
+   cache_elem_t *e =
+      cache_probe(cache->f_subtype_cache, cache->f_max_subtypes, type);
+   return e->f_mirror;
+}
 
-         cache->f_subtype_cache = tmp;
-         cache->f_max_subtypes = new_max;
+static void cache_insert(internal_cache_pt *cache, type_t type,
+                         subtype_mirror *sm)
+{
+   // The cache array lives in the reflection package so that it is
+   // visible to the garbage collector and is used as an open addressing
+   // hash table kept at most half full
+   if (cache->f_num_subtypes * 2 >= cache->f_max_subtypes) {
+      const size_t new_max = MAX(cache->f_max_subtypes * 2, 128);
+      cache_elem_t *tmp = zero_alloc(new_max * sizeof(cache_elem_t));
+
+      for (int i = 0; i < cache->f_max_subtypes; i++) {
+         cache_elem_t *old = &(cache->f_subtype_cache[i]);
+         if (old->f_type != NULL)
+            *cache_probe(tmp, new_max, old->f_type) = *old;
       }
 
-      cache_elem_t *e = &(cache->f_subtype_cache[cache->f_num_subtypes++]);
-      e->f_type = type;
-      e->f_mirror = sm;
+      cache->f_subtype_cache = tmp;
+      cache->f_max_subtypes = new_max;
    }
 
+   cache_elem_t *e =
+      cache_probe(cache->f_subtype_cache, cache->f_max_subtypes, type);
+   assert(e->f_type == NULL);
+
+   e->f_type = type;
+   e->f_mirror = sm;
+   cache->f_num_subtypes++;
+}
+
+static subtype_mirror *get_subtype_mirror(void *context, type_t type,
+                                          const jit_scalar_t *bounds)
+{
+   internal_cache_pt *cache = get_cache(context);
+
+   subtype_mirror *sm = cache_lookup(cache, type);
+   if (sm != NULL)
+      return sm;
+
+   sm = zero_alloc(sizeof(subtype_mirror));
+   sm->access = &(sm->pt);
+   sm->pt.context = context;
+
+   if (safe_to_cache(type))
+      cache_insert(cache, type, sm);
+
    const char *simple = strrchr(istr(type_ident(type)), '.') + 1;
    sm->pt.f_name = get_string(simple);
 
@@ -836,6 +950,11 @@ static subtype_mirror *get_subtype_mirror(void *context, type_t type,
       esm->pt.context = context;
       esm->pt.f_owner = sm;
 
+      // Set these before creating the literals which may refer back to
+      // this subtype mirror through the cache
+      sm->pt.f_class = CLASS_ENUMERATION;
+      sm->pt.f_enumeration = esm;
+
       type_t base = type_base_recur(type);
       const int nlits = type_enum_literals(base);
 
@@ -850,9 +969,6 @@ static subtype_mirror *get_subtype_mirror(void *context, type_t type,
       enumeration_value_mirror **lits = esm->pt.f_literals->ptr;
       for (int i = 0; i < nlits; i++)
          lits[i] = get_enumeration_mirror(context, base, i);
-
-      sm->pt.f_class = CLASS_ENUMERATION;
-      sm->pt.f_enumeration = esm;
    }
    else if (type_is_real(type)) {
       floating_subtype_mirror *fsm =
@@ -23,7 +23,9 @@
 #include <stdint.h>
 
 #define RT_ALIGN_MASK    0x7
+#ifndef RT_MULTITHREADED
 #define RT_MULTITHREADED 0
+#endif
 
 #define TIME_HIGH INT64_MAX  // Value of TIME'HIGH
 
@@ -43,8 +45,25 @@ typedef enum {
    R_MEMO      = (1 << 0),
    R_IDENT     = (1 << 1),
    R_COMPOSITE = (1 << 2),
+   R_FOLD      = (1 << 3),
+   R_NOCACHE   = (1 << 4),
 } res_flags_t;
 
+typedef enum {
+   TRANSFER_COPY,
+   TRANSFER_NOT,          // Predefined NOT for BIT and BOOLEAN
+   TRANSFER_NOT_ULOGIC,   // IEEE.STD_LOGIC_1164."not" for STD_ULOGIC
+   TRANSFER_STABLE,       // Implicit S'STABLE(T)
+   TRANSFER_QUIET,        // Implicit S'QUIET(T)
+   TRANSFER_TRANSACTION,  // Implicit S'TRANSACTION
+} transfer_kind_t;
+
+typedef enum {
+   EDGE_FALLING = 0,
+   EDGE_RISING  = (1 << 0),
+   EDGE_X01     = (1 << 1),   // Compare STD_ULOGIC values with TO_X01
+} edge_flags_t;
+
 #define NET_F_FORCED       (1 << 0)
 #define NET_F_INOUT        (1 << 1)
 #define NET_F_CACHE_EVENT  (1 << 2)
@@ -24,6 +24,7 @@
 #include "jit/jit.h"
 #include "jit/jit-ffi.h"
 #include "rt/mspace.h"
+#include "rt/random.h"
 #include "rt/rt.h"
 #include "thread.h"
 
@@ -35,12 +36,16 @@ typedef A(rt_signal_t *) signal_list_t;
 typedef A(rt_proc_t *) proc_list_t;
 typedef A(rt_alias_t *) alias_list_t;
 
+typedef struct _scope_index scope_index_t;
+typedef struct _prof_rec prof_rec_t;
+
 typedef enum {
    W_PROC, W_WATCH, W_PROPERTY, W_TRANSFER, W_TRIGGER,
 } wakeable_kind_t;
 
 typedef enum {
-   FUNC_TRIGGER, OR_TRIGGER, CMP_TRIGGER, LEVEL_TRIGGER
+   FUNC_TRIGGER, OR_TRIGGER, CMP_TRIGGER, LEVEL_TRIGGER, AND_TRIGGER,
+   EDGE_TRIGGER
 } trigger_kind_t;
 
 typedef struct {
@@ -72,6 +77,10 @@ typedef struct _rt_proc {
    tlab_t        *tlab;
    rt_scope_t    *scope;
    mptr_t         privdata;
+   ihash_t       *drivers;
+   rng_stream_t   rng;
+   uint64_t       timeout;   // Expiry time when delayed
+   prof_rec_t    *profile;   // Set when profiling
    ffi_closure_t  closure;   // Has a flexible member
 } rt_proc_t;
 
@@ -86,7 +95,9 @@ typedef struct _rt_prop {
    bit_mask_t     state;
    bit_mask_t     newstate;
    mptr_t         privdata;
+   struct _rt_prop *group;
    bool           strong;
+   bool           follower;
 } rt_prop_t;
 
 typedef union {
@@ -154,13 +165,31 @@ typedef struct _rt_source {
 
 STATIC_ASSERT(sizeof(rt_source_t) <= 64);
 
+#define RES_CACHE_SIZE  64
+#define RES_CACHE_BYTES 64
+
+typedef struct {
+   uint16_t nargs;
+   uint8_t  keylen;
+   uint8_t  vallen;
+   uint8_t  key[RES_CACHE_BYTES];
+   uint8_t  value[RES_CACHE_BYTES];
+} res_cache_t;
+
 typedef struct {
-   ffi_closure_t closure;
-   res_flags_t   flags;
-   int8_t        tab2[16][16];
-   int8_t        tab1[16];
+   ffi_closure_t  closure;
+   res_flags_t    flags;
+   int32_t        nlits;
+   int8_t         tab2[16][16];
+   int8_t         tab1[16];
+   res_cache_t   *cache;
+   uint32_t       hits;
+   uint32_t       misses;
 } res_memo_t;
 
+// The fields up to and including free_value are touched on every
+// event and must share the first cache line; the embedded source used
+// by the common single driver case occupies the second line
 typedef struct _rt_nexus {
    rt_nexus_t    *chain;
    rt_signal_t   *signal;
@@ -180,6 +209,9 @@ typedef struct _rt_nexus {
 } rt_nexus_t;
 
 STATIC_ASSERT(sizeof(rt_nexus_t) <= 128);
+STATIC_ASSERT(offsetof(rt_nexus_t, sources) == 64);
+STATIC_ASSERT(offsetof(rt_driver_t, waveforms) + sizeof(waveform_t)
+              + offsetof(rt_source_t, u) <= 64);
 
 // The code generator knows the layout of this struct
 typedef struct _sig_shared {
@@ -188,9 +220,12 @@ typedef struct _sig_shared {
    uint8_t     data[];
 } sig_shared_t;
 
+// Sorted element offset of the start of each nexus in a signal
 typedef struct {
-   int         how;
-   rt_nexus_t *nexus[];
+   unsigned     count;
+   unsigned     limit;
+   uint32_t    *offsets;
+   rt_nexus_t **nexus;
 } rt_index_t;
 
 typedef struct _rt_signal {
@@ -201,6 +236,7 @@ typedef struct _rt_signal {
    nvc_lock_t    lock;
    uint32_t      offset;
    uint32_t      n_nexus;
+   uint32_t      profile;   // Index of profile record plus one
    rt_nexus_t    nexus;
    sig_shared_t  shared;
 } rt_signal_t;
@@ -208,13 +244,14 @@ typedef struct _rt_signal {
 STATIC_ASSERT(sizeof(rt_signal_t) + 8 <= 192);
 
 typedef struct {
-   rt_wakeable_t  wakeable;
-   rt_proc_t     *proc;
-   rt_nexus_t    *target;
-   rt_nexus_t    *source;
-   int64_t        after;
-   int64_t        reject;
-   unsigned       count;
+   rt_wakeable_t    wakeable;
+   rt_proc_t       *proc;
+   rt_nexus_t      *target;
+   rt_nexus_t      *source;
+   int64_t          after;
+   int64_t          reject;
+   unsigned         count;
+   transfer_kind_t  kind;
 } rt_transfer_t;
 
 typedef struct _rt_alias {
@@ -241,6 +278,7 @@ typedef struct _rt_scope {
    mptr_t           privdata;
    rt_scope_t      *parent;
    scope_list_t     children;
+   scope_index_t   *index;    // Built lazily for large scopes
 } rt_scope_t;
 
 typedef struct _rt_watch {
@@ -0,0 +1,243 @@
+//
+//  Copyright (C) 2026  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "array.h"
+#include "rt/vcd.h"
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Writes VCD directly in the same format as converting an FST file
+// with the VCD extensions enabled, but without the attribute records
+
+#define VCD_BUFFER_SIZE (1 << 20)
+#define VCD_ID_MAX      8
+
+typedef struct {
+   uint32_t len;
+   bool     real;
+   uint8_t  idlen;
+   char     id[VCD_ID_MAX];
+} vcd_var_t;
+
+typedef A(vcd_var_t) var_array_t;
+
+typedef enum {
+   VCD_DEFINITIONS, VCD_DUMPVARS, VCD_CHANGES
+} vcd_state_t;
+
+typedef struct _vcd_writer {
+   FILE        *file;
+   char        *buffer;
+   var_array_t  vars;
+   vcd_state_t  state;
+   uint64_t     last_time;
+   char        *escbuf;
+   size_t       escsize;
+} vcd_writer_t;
+
+static const char *scope_types[] = {
+   "module", "task", "function", "begin", "fork", "generate", "struct",
+   "union", "class", "interface", "package", "program",
+   "vhdl_architecture", "vhdl_procedure", "vhdl_function", "vhdl_record",
+   "vhdl_process", "vhdl_block", "vhdl_for_generate", "vhdl_if_generate",
+   "vhdl_generate", "vhdl_package"
+};
+
+static const char *var_types[] = {
+   "event", "integer", "parameter", "real", "real_parameter", "reg",
+   "supply0", "supply1", "time", "tri", "triand", "trior", "trireg", "tri0",
+   "tri1", "wand", "wire", "wor", "port", "sparray", "realtime", "string",
+   "bit", "logic", "int", "shortint", "longint", "byte", "enum", "shortreal"
+};
+
+static int vcd_encode_id(char *buf, unsigned value)
+{
+   // Same identifier encoding as the FST reader uses for VCD output
+   int len = 0;
+   while (value) {
+      value--;
+      buf[len++] = '!' + value % 94;
+      value /= 94;
+   }
+
+   return len;
+}
+
+vcd_writer_t *vcd_writer_new(const char *file, const char *version)
+{
+   FILE *f = fopen(file, "wb");
+   if (f == NULL)
+      fatal_errno("%s", file);
+
+   vcd_writer_t *vw = xcalloc(sizeof(vcd_writer_t));
+   vw->file      = f;
+   vw->buffer    = xmalloc(VCD_BUFFER_SIZE);
+   vw->last_time = UINT64_MAX;
+
+   setvbuf(f, vw->buffer, _IOFBF, VCD_BUFFER_SIZE);
+
+   const time_t now = time(NULL);
+   char date[32];
+   strftime(date, sizeof(date), "%a %b %e %H:%M:%S %Y", localtime(&now));
+
+   fprintf(f, "$date\n\t%s\n$end\n", date);
+   fprintf(f, "$version\n\t%s\n$end\n", version);
+   fprintf(f, "$timescale\n\t1fs\n$end\n");
+
+   return vw;
+}
+
+void vcd_writer_close(vcd_writer_t *vw, uint64_t now)
+{
+   vcd_emit_time_change(vw, now);
+
+   if (vw->state == VCD_DUMPVARS)
+      fputs("$end\n", vw->file);
+
+   if (fclose(vw->file) != 0)
+      fatal_errno("fclose");
+
+   ACLEAR(vw->vars);
+   free(vw->buffer);
+   free(vw->escbuf);
+   free(vw);
+}
+
+void vcd_set_scope(vcd_writer_t *vw, enum fstScopeType st, const char *name)
+{
+   assert(vw->state == VCD_DEFINITIONS);
+
+   if (st < FST_ST_MIN || st > FST_ST_MAX)
+      st = FST_ST_VCD_MODULE;
+
+   fprintf(vw->file, "$scope %s %s $end\n", scope_types[st], name);
+}
+
+void vcd_set_upscope(vcd_writer_t *vw)
+{
+   assert(vw->state == VCD_DEFINITIONS);
+
+   fputs("$upscope $end\n", vw->file);
+}
+
+fstHandle vcd_create_var(vcd_writer_t *vw, enum fstVarType vt, uint32_t len,
+                         const char *name, fstHandle alias)
+{
+   assert(vw->state == VCD_DEFINITIONS);
+   assert(vt >= FST_VT_MIN && vt <= FST_VT_MAX);
+
+   const bool real = vt == FST_VT_VCD_REAL || vt == FST_VT_VCD_REAL_PARAMETER
+      || vt == FST_VT_VCD_REALTIME || vt == FST_VT_SV_SHORTREAL;
+
+   if (real)
+      len = (vt == FST_VT_SV_SHORTREAL) ? 32 : 64;
+   else if (vt == FST_VT_GEN_STRING)
+      len = 0;
+
+   fstHandle h = alias;
+   if (alias == 0 || alias > vw->vars.count) {
+      vcd_var_t var = { .len = len, .real = real };
+      var.idlen = vcd_encode_id(var.id, vw->vars.count + 1);
+      APUSH(vw->vars, var);
+
+      h = vw->vars.count;
+   }
+
+   const vcd_var_t *var = &(vw->vars.items[h - 1]);
+   fprintf(vw->file, "$var %s %"PRIu32" %.*s %s $end\n", var_types[vt],
+           len, var->idlen, var->id, name);
+
+   return h;
+}
+
+void vcd_emit_time_change(vcd_writer_t *vw, uint64_t now)
+{
+   if (now == vw->last_time)
+      return;
+
+   switch (vw->state) {
+   case VCD_DEFINITIONS:
+      fprintf(vw->file, "$enddefinitions $end\n#%"PRIu64"\n$dumpvars\n", now);
+      vw->state = VCD_DUMPVARS;
+      break;
+   case VCD_DUMPVARS:
+      fprintf(vw->file, "$end\n#%"PRIu64"\n", now);
+      vw->state = VCD_CHANGES;
+      break;
+   case VCD_CHANGES:
+      fprintf(vw->file, "#%"PRIu64"\n", now);
+      break;
+   }
+
+   vw->last_time = now;
+}
+
+void vcd_emit_value_change(vcd_writer_t *vw, fstHandle h, const void *val)
+{
+   assert(h > 0 && h <= vw->vars.count);
+   assert(vw->state != VCD_DEFINITIONS);
+
+   const vcd_var_t *var = &(vw->vars.items[h - 1]);
+
+   char buf[64];
+   if (var->real) {
+      double d;
+      memcpy(&d, val, sizeof(double));
+      checked_sprintf(buf, sizeof(buf), "r%.16g ", d);
+      fputs(buf, vw->file);
+   }
+   else if (var->len == 1)
+      fputc(*(const char *)val, vw->file);
+   else {
+      fputc('b', vw->file);
+      fwrite(val, var->len, 1, vw->file);
+      fputc(' ', vw->file);
+   }
+
+   fwrite(var->id, var->idlen, 1, vw->file);
+   fputc('\n', vw->file);
+}
+
+void vcd_emit_variable_length_value_change(vcd_writer_t *vw, fstHandle h,
+                                           const void *val, uint32_t len)
+{
+   assert(h > 0 && h <= vw->vars.count);
+   assert(vw->state != VCD_DEFINITIONS);
+
+   const vcd_var_t *var = &(vw->vars.items[h - 1]);
+
+   // Non-printable characters are escaped in the same way as FST
+   const size_t need = len * 4 + 1;
+   if (need > vw->escsize) {
+      vw->escsize = MAX(need, 256);
+      vw->escbuf  = xrealloc(vw->escbuf, vw->escsize);
+   }
+
+   const int esclen = fstUtilityBinToEsc((unsigned char *)vw->escbuf, val, len);
+
+   fputc('s', vw->file);
+   fwrite(vw->escbuf, esclen, 1, vw->file);
+   fputc(' ', vw->file);
+   fwrite(var->id, var->idlen, 1, vw->file);
+   fputc('\n', vw->file);
+}
@@ -0,0 +1,38 @@
+//
+//  Copyright (C) 2026  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _RT_VCD_H
+#define _RT_VCD_H
+
+#include "fstapi.h"
+
+#include <stdint.h>
+
+typedef struct _vcd_writer vcd_writer_t;
+
+vcd_writer_t *vcd_writer_new(const char *file, const char *version);
+void vcd_writer_close(vcd_writer_t *vw, uint64_t now);
+void vcd_set_scope(vcd_writer_t *vw, enum fstScopeType st, const char *name);
+void vcd_set_upscope(vcd_writer_t *vw);
+fstHandle vcd_create_var(vcd_writer_t *vw, enum fstVarType vt, uint32_t len,
+                         const char *name, fstHandle alias);
+void vcd_emit_time_change(vcd_writer_t *vw, uint64_t now);
+void vcd_emit_value_change(vcd_writer_t *vw, fstHandle h, const void *val);
+void vcd_emit_variable_length_value_change(vcd_writer_t *vw, fstHandle h,
+                                           const void *val, uint32_t len);
+
+#endif   // _RT_VCD_H
@@ -26,8 +26,10 @@
 #include "rt/model.h"
 #include "rt/rt.h"
 #include "rt/structs.h"
+#include "rt/vcd.h"
 #include "rt/wave.h"
 #include "printf.h"
+#include "thread.h"
 #include "tree.h"
 #include "type.h"
 #include "vlog/vlog-node.h"
@@ -38,12 +40,10 @@
 #include <limits.h>
 #include <string.h>
 
-#if !defined __CYGWIN__ && !defined __MINGW32__
-#include <libgen.h>
-#endif
-
 #define USE_FST_ENUMS 0
 
+#define FST_EXPAND_CHUNK 256
+
 typedef struct {
    char  *text;
    size_t len;
@@ -53,7 +53,7 @@ typedef A(glob_t) glob_array_t;
 
 typedef struct _fst_data fst_data_t;
 
-typedef void (*fst_fmt_fn_t)(rt_watch_t *, fst_data_t *);
+typedef void (*fst_fmt_fn_t)(fst_data_t *, const void *);
 
 typedef struct {
    int64_t  mult;
@@ -87,6 +87,7 @@ typedef struct _fst_data {
    rt_signal_t   *signal;
    unsigned       size;
    unsigned       count;
+   uint64_t      *packed;
    fstHandle      handle[];
 } fst_data_t;
 
@@ -106,18 +107,36 @@ typedef struct {
    bool        end_of_record;
 } gtkw_writer_t;
 
+typedef struct {
+   uint64_t    time;
+   fst_data_t *data;
+   uint32_t    size;
+} wave_record_t;
+
+typedef struct {
+   uint8_t      *buf;
+   size_t        capacity;
+   uint64_t      head;
+   uint64_t      tail;
+   bool          stop;
+   int           sleeping;
+   nvc_thread_t *thread;
+} wave_ring_t;
+
 typedef struct _wave_dumper {
    tree_t         top;
    void          *fst_ctx;
    rt_model_t    *model;
    gtkw_writer_t *gtkw;
-   FILE          *vcdfile;
-   char          *tmpfst;
+   vcd_writer_t  *vcd;
    uint64_t       last_time;
    jit_t         *jit;
    hash_t        *typecache;
    fst_type_t    *datatypes[DT_STRING + 1];
    data_array_t   dumped;
+   wave_ring_t   *ring;
+   uint64_t       start;
+   uint64_t       stop;
 } wave_dumper_t;
 
 static glob_array_t incl;
@@ -125,7 +144,9 @@ static glob_array_t excl;
 
 static void fst_process_signal(wave_dumper_t *wd, rt_scope_t *scope, tree_t d,
                                type_t type, text_buf_t *tb);
-static bool wave_should_dump(rt_scope_t *scope, ident_t id);
+static bool wave_should_dump(text_buf_t *path, ident_t id, bool excluded);
+static bool wave_exclude_scope(rt_scope_t *scope, text_buf_t *path);
+static void wave_ring_stop(wave_dumper_t *wd);
 
 static bool should_dump_array(tree_t where, unsigned length)
 {
@@ -145,44 +166,89 @@ static bool should_dump_array(tree_t where, unsigned length)
    return false;
 }
 
-static void fst_close(rt_model_t *m, void *arg)
+static void wave_emit_time_change(wave_dumper_t *wd, uint64_t now)
 {
-   wave_dumper_t *wd = arg;
+   if (wd->vcd != NULL)
+      vcd_emit_time_change(wd->vcd, now);
+   else
+      fstWriterEmitTimeChange(wd->fst_ctx, now);
+}
+
+static void wave_emit_value_change(wave_dumper_t *wd, fstHandle h,
+                                   const void *val)
+{
+   if (wd->vcd != NULL)
+      vcd_emit_value_change(wd->vcd, h, val);
+   else
+      fstWriterEmitValueChange(wd->fst_ctx, h, val);
+}
 
-   fstWriterEmitTimeChange(wd->fst_ctx, model_now(m, NULL));
-   fstWriterClose(wd->fst_ctx);
+static void wave_emit_variable_length_value_change(wave_dumper_t *wd,
+                                                   fstHandle h,
+                                                   const void *val,
+                                                   uint32_t len)
+{
+   if (wd->vcd != NULL)
+      vcd_emit_variable_length_value_change(wd->vcd, h, val, len);
+   else
+      fstWriterEmitVariableLengthValueChange(wd->fst_ctx, h, val, len);
+}
 
-   if (wd->vcdfile) {
-      void *xc = fstReaderOpen(wd->tmpfst);
-      if (xc == NULL)
-         fatal("fstReaderOpen failed for temporary FST file");
+static void wave_set_scope(wave_dumper_t *wd, enum fstScopeType st,
+                           const char *name)
+{
+   if (wd->vcd != NULL)
+      vcd_set_scope(wd->vcd, st, name);
+   else
+      fstWriterSetScope(wd->fst_ctx, st, name, "");
+}
 
-      fstReaderSetVcdExtensions(xc, 1);
-      if (!fstReaderProcessHier(xc, wd->vcdfile))
-         fatal("fstReaderProcessHier failed");
+static void wave_set_upscope(wave_dumper_t *wd)
+{
+   if (wd->vcd != NULL)
+      vcd_set_upscope(wd->vcd);
+   else
+      wave_set_upscope(wd);
+}
 
-      fstReaderSetFacProcessMaskAll(xc);
-      fstReaderIterBlocks(xc, NULL, NULL, wd->vcdfile);
+static void wave_set_attr_end(wave_dumper_t *wd)
+{
+   if (wd->fst_ctx != NULL)
+      wave_set_attr_end(wd);
+}
 
-      fstReaderClose(xc);
-      fclose(wd->vcdfile);
-      wd->vcdfile = NULL;
+static fstHandle wave_create_var(wave_dumper_t *wd, enum fstVarType vt,
+                                 enum fstVarDir vd, uint32_t len,
+                                 const char *name, fstHandle alias,
+                                 const char *type,
+                                 enum fstSupplementalVarType svt,
+                                 enum fstSupplementalDataType sdt)
+{
+   if (wd->vcd != NULL)
+      return vcd_create_var(wd->vcd, vt, len, name, alias);
+   else
+      return fstWriterCreateVar2(wd->fst_ctx, vt, vd, len, name, alias,
+                                 type, svt, sdt);
+}
 
-      if (unlink(wd->tmpfst) != 0)
-         fatal_errno("unlink: %s", wd->tmpfst);
+static void fst_close(rt_model_t *m, void *arg)
+{
+   wave_dumper_t *wd = arg;
 
-#if !defined __CYGWIN__ && !defined __MINGW32__
-      char *tmpdir = dirname(wd->tmpfst);
-      if (rmdir(tmpdir) != 0)
-         fatal_errno("unlink: %s", tmpdir);
-#endif
+   if (wd->ring != NULL)
+      wave_ring_stop(wd);
 
-      free(wd->tmpfst);
-      wd->tmpfst = NULL;
+   if (wd->vcd != NULL) {
+      vcd_writer_close(wd->vcd, model_now(m, NULL));
+      wd->vcd = NULL;
+   }
+   else {
+      fstWriterEmitTimeChange(wd->fst_ctx, model_now(m, NULL));
+      fstWriterClose(wd->fst_ctx);
+      wd->fst_ctx = NULL;
    }
 
-   wd->fst_ctx = NULL;
-   wd->model   = NULL;
+   wd->model = NULL;
 }
 
 static inline void fst_write_binary(uint64_t val, size_t size, char *buf)
@@ -192,29 +258,73 @@ static inline void fst_write_binary(uint64_t val, size_t size, char *buf)
    buf[size] = '\0';
 }
 
-static void fst_fmt_int(rt_watch_t *w, fst_data_t *data)
+static void fst_expand(fst_data_t *data, const void *value, uint64_t *buf,
+                       int first, int count)
+{
+#define FST_EXPAND_U64(type) do {                                       \
+      const type *sp = (const type *)value + first;                     \
+      for (int i = 0; i < count; i++)                                   \
+         buf[i] = sp[i];                                                \
+   } while (0)
+
+   FOR_ALL_SIZES(signal_size(data->signal), FST_EXPAND_U64);
+}
+
+static bool fst_init_cache(fst_data_t *data)
+{
+   // Arrays are dumped as one variable per element so remember the last
+   // value of each element to avoid emitting unchanged elements
+   if (data->count > 1 && data->packed == NULL) {
+      data->packed = xmalloc_array(data->count, sizeof(uint64_t));
+      return true;
+   }
+
+   return false;
+}
+
+static bool fst_element_changed(fst_data_t *data, bool first, int i,
+                                uint64_t val)
+{
+   if (data->packed == NULL)
+      return true;
+   else if (!first && data->packed[i] == val)
+      return false;
+
+   data->packed[i] = val;
+   return true;
+}
+
+static void fst_fmt_int(fst_data_t *data, const void *value)
 {
-   uint64_t val[data->count];
-   signal_expand(data->signal, val, data->count);
+   const bool first = fst_init_cache(data);
 
-   for (int i = 0; i < data->count; i++) {
-      char buf[data->type->size + 1];
-      fst_write_binary(val[i], data->type->size, buf);
+   uint64_t val[FST_EXPAND_CHUNK];
+   for (int base = 0; base < data->count; base += FST_EXPAND_CHUNK) {
+      const int count = MIN(data->count - base, FST_EXPAND_CHUNK);
+      fst_expand(data, value, val, base, count);
 
-      fstWriterEmitValueChange(data->dumper->fst_ctx, data->handle[i], buf);
+      for (int i = 0; i < count; i++) {
+         if (!fst_element_changed(data, first, base + i, val[i]))
+            continue;
+
+         char buf[data->type->size + 1];
+         fst_write_binary(val[i], data->type->size, buf);
+
+         wave_emit_value_change(data->dumper,
+                                  data->handle[base + i], buf);
+      }
    }
 }
 
-static void fst_fmt_real(rt_watch_t *w, fst_data_t *data)
+static void fst_fmt_real(fst_data_t *data, const void *value)
 {
-   const void *buf = signal_value(data->signal);
-   fstWriterEmitValueChange(data->dumper->fst_ctx, data->handle[0], buf);
+   wave_emit_value_change(data->dumper, data->handle[0], value);
 }
 
-static void fst_fmt_physical(rt_watch_t *w, fst_data_t *data)
+static void fst_fmt_physical(fst_data_t *data, const void *value)
 {
    uint64_t val;
-   signal_expand(data->signal, &val, 1);
+   fst_expand(data, value, &val, 0, 1);
 
    fst_unit_t *unit = data->type->u.units;
    while ((val % unit->mult) != 0)
@@ -224,68 +334,296 @@ static void fst_fmt_physical(rt_watch_t *w, fst_data_t *data)
    checked_sprintf(buf, sizeof(buf), "%"PRIi64" %s",
                    val / unit->mult, unit->name);
 
-   fstWriterEmitVariableLengthValueChange(
-      data->dumper->fst_ctx, data->handle[0], buf, strlen(buf));
+   wave_emit_variable_length_value_change(
+      data->dumper, data->handle[0], buf, strlen(buf));
 }
 
-static void fst_fmt_chars(rt_watch_t *w, fst_data_t *data)
+static bool fst_pack_element(uint64_t *packed, const uint8_t *p, int size)
 {
-   const uint8_t *p = signal_value(data->signal);
+   // Pack an element with four bits per value which is sufficient for
+   // std_logic and returns true if it changed since the last dump
+   bool changed = false;
+   for (int i = 0; i < size; i += 16, packed++) {
+      uint64_t word = 0;
+      for (int j = 0; j < 16 && i + j < size; j++) {
+         assert(p[i + j] < 16);
+         word |= (uint64_t)p[i + j] << (j * 4);
+      }
+
+      changed |= (*packed != word);
+      *packed = word;
+   }
+
+   return changed;
+}
+
+static void fst_fmt_chars(fst_data_t *data, const void *value)
+{
+   const uint8_t *p = value;
+
+   // Arrays of vectors are dumped as one variable per element so avoid
+   // emitting value changes for elements which are unchanged
+   const int nwords = (data->size + 15) / 16;
+   if (data->count > 1 && data->type->u.map != NULL && data->packed == NULL) {
+      data->packed = xmalloc_array(data->count * nwords, sizeof(uint64_t));
+      memset(data->packed, 0xff, data->count * nwords * sizeof(uint64_t));
+   }
+
    for (int i = 0; i < data->count; i++, p += data->size) {
-      if (likely(data->type->u.map != NULL)) {
+      if (data->packed != NULL
+          && !fst_pack_element(data->packed + i * nwords, p, data->size))
+         continue;
+      else if (likely(data->type->u.map != NULL)) {
          char buf[data->size];
          for (int j = 0; j < data->size; j++)
             buf[j] = data->type->u.map[p[j]];
-         fstWriterEmitValueChange(data->dumper->fst_ctx, data->handle[i], buf);
+         wave_emit_value_change(data->dumper, data->handle[i], buf);
       }
       else
-         fstWriterEmitVariableLengthValueChange(
-            data->dumper->fst_ctx, data->handle[i], p, data->size);
+         wave_emit_variable_length_value_change(
+            data->dumper, data->handle[i], p, data->size);
    }
 }
 
 #if !USE_FST_ENUMS
-static void fst_fmt_enum(rt_watch_t *w, fst_data_t *data)
+static void fst_fmt_enum(fst_data_t *data, const void *value)
 {
-   uint64_t val[data->count];
-   signal_expand(data->signal, val, data->count);
+   const bool first = fst_init_cache(data);
+   const fst_enum_t *e = &(data->type->u.literals);
+
+   uint64_t val[FST_EXPAND_CHUNK];
+   for (int base = 0; base < data->count; base += FST_EXPAND_CHUNK) {
+      const int count = MIN(data->count - base, FST_EXPAND_CHUNK);
+      fst_expand(data, value, val, base, count);
 
-   for (int i = 0; i < data->count; i++) {
-      fst_enum_t *e = &(data->type->u.literals);
-      assert(val[i] < e->count);
+      for (int i = 0; i < count; i++) {
+         assert(val[i] < e->count);
 
-      const char *literal = e->strings + val[i] * e->size;
-      fstWriterEmitVariableLengthValueChange(data->dumper->fst_ctx,
-                                             data->handle[i],
-                                             literal,
-                                             strnlen(literal, e->size));
+         if (!fst_element_changed(data, first, base + i, val[i]))
+            continue;
+
+         const char *literal = e->strings + val[i] * e->size;
+         wave_emit_variable_length_value_change(data->dumper,
+                                                data->handle[base + i],
+                                                literal,
+                                                strnlen(literal, e->size));
+      }
    }
 }
 #endif
 
-static void fst_fmt_verilog(rt_watch_t *w, fst_data_t *data)
+static void fst_fmt_verilog(fst_data_t *data, const void *value)
 {
-   const uint8_t *p = signal_value(data->signal);
+   const uint8_t *p = value;
    for (int i = 0; i < data->count; i++, p += data->size) {
       char buf[data->size];
       for (int j = 0; j < data->size; j++)
          buf[j] = data->type->u.map[p[j] & 3];
-      fstWriterEmitValueChange(data->dumper->fst_ctx, data->handle[i], buf);
+      wave_emit_value_change(data->dumper, data->handle[i], buf);
+   }
+}
+
+static void fst_emit(fst_data_t *data, uint64_t now, const void *value)
+{
+   if (now != data->dumper->last_time) {
+      wave_emit_time_change(data->dumper, now);
+      data->dumper->last_time = now;
+   }
+
+   (*data->type->fn)(data, value);
+}
+
+static void wave_ring_backoff(int *spins)
+{
+   if (++(*spins) < 64)
+      spin_wait();
+   else
+      thread_sleep(10);
+}
+
+static void wave_ring_notify(wave_ring_t *r)
+{
+   // Wake the writer thread if it is blocked waiting for new records
+   full_barrier();
+   if (relaxed_load(&r->sleeping)) {
+      store_release(&r->sleeping, 0);
+      thread_wake(&r->sleeping);
    }
 }
 
+static void *wave_writer_thread(void *arg)
+{
+   wave_dumper_t *wd = arg;
+   wave_ring_t *r = wd->ring;
+
+   uint64_t tail = r->tail;
+   for (int spins = 0;;) {
+      const uint64_t head = load_acquire(&r->head);
+      if (head == tail) {
+         if (load_acquire(&r->stop) && load_acquire(&r->head) == tail)
+            break;
+         else if (++spins < 64) {
+            spin_wait();
+            continue;
+         }
+
+         // Block rather than poll until the simulation publishes more
+         // records or the dumper is stopped
+         store_release(&r->sleeping, 1);
+         full_barrier();
+         if (load_acquire(&r->head) == tail && !load_acquire(&r->stop))
+            thread_wait(&r->sleeping, 1);
+         store_release(&r->sleeping, 0);
+
+         spins = 0;
+         continue;
+      }
+
+      for (spins = 0; tail != head; ) {
+         const size_t off = tail % r->capacity;
+         const wave_record_t *rec = (wave_record_t *)(r->buf + off);
+
+         if (r->capacity - off < sizeof(wave_record_t) || rec->data == NULL)
+            tail += r->capacity - off;   // Padding at the end of the buffer
+         else {
+            fst_emit(rec->data, rec->time, rec + 1);
+            tail += ALIGN_UP(sizeof(wave_record_t) + rec->size, 8);
+         }
+
+         store_release(&r->tail, tail);
+      }
+   }
+
+   return NULL;
+}
+
+static wave_ring_t *wave_ring_new(size_t capacity)
+{
+   wave_ring_t *r = xcalloc(sizeof(wave_ring_t));
+   r->capacity = ALIGN_UP(capacity, 8);
+   r->buf      = xmalloc(r->capacity);
+
+   return r;
+}
+
+static void wave_ring_stop(wave_dumper_t *wd)
+{
+   wave_ring_t *r = wd->ring;
+   if (r->thread == NULL)
+      return;
+
+   store_release(&r->stop, true);
+   wave_ring_notify(r);
+   thread_join(r->thread);
+   r->thread = NULL;
+
+   assert(r->head == r->tail);
+}
+
+static void wave_ring_free(wave_ring_t *r)
+{
+   assert(r->thread == NULL);
+
+   free(r->buf);
+   free(r);
+}
+
+static void wave_ring_push(wave_dumper_t *wd, uint64_t now, fst_data_t *data)
+{
+   wave_ring_t *r = wd->ring;
+
+   const size_t size = signal_width(data->signal) * signal_size(data->signal);
+   const size_t need = ALIGN_UP(sizeof(wave_record_t) + size, 8);
+
+   if (need > r->capacity) {
+      // Too large to ever fit in the buffer: wait for the writer thread
+      // to become idle and then format the value directly
+      for (int spins = 0; load_acquire(&r->tail) != r->head; )
+         wave_ring_backoff(&spins);
+
+      fst_emit(data, now, signal_value(data->signal));
+      return;
+   }
+
+   uint64_t head = r->head;
+
+   // Apply back-pressure to the simulation when the writer thread falls
+   // behind and the buffer reaches its memory budget
+   const size_t off = head % r->capacity;
+   if (r->capacity - off < need) {
+      // Records never wrap around so pad to the start of the buffer
+      for (int spins = 0; head - load_acquire(&r->tail) > off; )
+         wave_ring_backoff(&spins);
+
+      if (r->capacity - off >= sizeof(wave_record_t))
+         ((wave_record_t *)(r->buf + off))->data = NULL;
+
+      head += r->capacity - off;
+      store_release(&r->head, head);
+      wave_ring_notify(r);
+   }
+
+   const uint64_t end = head + need;
+   for (int spins = 0; end - load_acquire(&r->tail) > r->capacity; )
+      wave_ring_backoff(&spins);
+
+   wave_record_t *rec = (wave_record_t *)(r->buf + head % r->capacity);
+   rec->time = now;
+   rec->data = data;
+   rec->size = size;
+   memcpy(rec + 1, signal_value(data->signal), size);
+
+   store_release(&r->head, end);
+   wave_ring_notify(r);
+}
+
 static void fst_event_cb(uint64_t now, rt_signal_t *s, rt_watch_t *w,
                          void *user)
 {
    fst_data_t *data = user;
 
-   if (now != data->dumper->last_time) {
-      fstWriterEmitTimeChange(data->dumper->fst_ctx, now);
-      data->dumper->last_time = now;
+   if (data->dumper->ring != NULL && data->dumper->ring->thread != NULL)
+      wave_ring_push(data->dumper, now, data);
+   else
+      fst_emit(data, now, signal_value(data->signal));
+}
+
+static void fst_watch_data(wave_dumper_t *wd, fst_data_t *data)
+{
+   assert(data->watch == NULL);
+   data->watch = watch_new(wd->model, fst_event_cb, data, WATCH_POSTPONED, 1);
+
+   const int width = signal_width(data->signal);
+   model_set_event_cb(wd->model, data->signal, 0, width, data->watch);
+}
+
+static void fst_add_data(wave_dumper_t *wd, fst_data_t *data)
+{
+   fst_watch_data(wd, data);
+   APUSH(wd->dumped, data);
+}
+
+static void wave_start_cb(rt_model_t *m, void *arg)
+{
+   wave_dumper_t *wd = arg;
+   const uint64_t now = model_now(m, NULL);
+
+   for (int i = 0; i < wd->dumped.count; i++) {
+      fst_data_t *data = wd->dumped.items[i];
+      fst_watch_data(wd, data);
+      fst_event_cb(now, data->signal, data->watch, data);
    }
+}
+
+static void wave_stop_cb(rt_model_t *m, void *arg)
+{
+   wave_dumper_t *wd = arg;
 
-   if (likely(data != NULL))
-      (*data->type->fn)(w, data);
+   for (int i = 0; i < wd->dumped.count; i++) {
+      fst_data_t *data = wd->dumped.items[i];
+      watch_free(m, data->watch);
+      data->watch = NULL;
+   }
 }
 
 static fst_unit_t *fst_make_unit_map(type_t type)
@@ -582,11 +920,11 @@ static fstHandle fst_create_handle(wave_dumper_t *wd, fst_data_t *data,
                                    const char *name, enum fstVarDir dir,
                                    type_t type, fstHandle alias)
 {
-   if (data->type->vartype == FST_VT_SV_ENUM)
+   if (data->type->vartype == FST_VT_SV_ENUM && wd->fst_ctx != NULL)
       fstWriterEmitEnumTableRef(wd->fst_ctx, data->type->u.enumh);
 
-   return fstWriterCreateVar2(
-      wd->fst_ctx,
+   return wave_create_var(
+      wd,
       data->type->vartype,
       dir,
       data->size,
@@ -704,7 +1042,7 @@ static void fst_create_array_var(wave_dumper_t *wd, tree_t d, rt_signal_t *s,
                         vd, type, tb);
       assert(pos == length);
 
-      fstWriterSetAttrEnd(wd->fst_ctx);
+      wave_set_attr_end(wd);
    }
    else {
       data = xcalloc_flex(sizeof(fst_data_t), length, sizeof(fstHandle));
@@ -725,7 +1063,7 @@ static void fst_create_array_var(wave_dumper_t *wd, tree_t d, rt_signal_t *s,
          data->handle[i] = fst_create_handle(wd, data, tb_get(tb), vd, elem, 0);
       }
 
-      fstWriterSetAttrEnd(wd->fst_ctx);
+      wave_set_attr_end(wd);
    }
 
    assert(find_watch(&(s->nexus), fst_event_cb) == NULL);
@@ -733,12 +1071,8 @@ static void fst_create_array_var(wave_dumper_t *wd, tree_t d, rt_signal_t *s,
    data->decl   = d;
    data->signal = s;
    data->dumper = wd;
-   data->watch  = watch_new(wd->model, fst_event_cb, data, WATCH_POSTPONED, 1);
 
-   const int width = signal_width(data->signal);
-   model_set_event_cb(wd->model, data->signal, 0, width, data->watch);
-
-   APUSH(wd->dumped, data);
+   fst_add_data(wd, data);
 }
 
 static void fst_create_scalar_var(wave_dumper_t *wd, tree_t d, rt_signal_t *s,
@@ -775,12 +1109,8 @@ static void fst_create_scalar_var(wave_dumper_t *wd, tree_t d, rt_signal_t *s,
 
    data->decl   = d;
    data->signal = s;
-   data->watch  = watch_new(wd->model, fst_event_cb, data, WATCH_POSTPONED, 1);
-
-   const int width = signal_width(data->signal);
-   model_set_event_cb(wd->model, data->signal, 0, width, data->watch);
 
-   APUSH(wd->dumped, data);
+   fst_add_data(wd, data);
 
    if (wd->gtkw != NULL)
       fprintf(wd->gtkw->file, "%s.%s\n", tb_get(wd->gtkw->hier), tb_get(tb));
@@ -843,7 +1173,7 @@ static void fst_create_record_var(wave_dumper_t *wd, tree_t d,
    tb_cat(tb, suffix);
    tb_downcase(tb);
 
-   fstWriterSetScope(wd->fst_ctx, FST_ST_VHDL_RECORD, tb_get(tb), NULL);
+   wave_set_scope(wd, FST_ST_VHDL_RECORD, tb_get(tb));
 
    size_t hlen = 0;
    if (wd->gtkw != NULL) {
@@ -859,7 +1189,7 @@ static void fst_create_record_var(wave_dumper_t *wd, tree_t d,
       fst_process_signal(wd, scope, f, tree_type(cons ?: f), tb);
    }
 
-   fstWriterSetUpscope(wd->fst_ctx);
+   wave_set_upscope(wd);
 
    if (wd->gtkw != NULL) {
       tb_trim(wd->gtkw->hier, hlen);
@@ -1057,8 +1387,8 @@ static void fst_process_verilog(wave_dumper_t *wd, rt_scope_t *scope,
 
    enum fstVarDir dir = FST_VD_IMPLICIT;
 
-   data->handle[0] = fstWriterCreateVar2(
-      wd->fst_ctx,
+   data->handle[0] = wave_create_var(
+      wd,
       data->type->vartype,
       dir,
       data->size,
@@ -1072,12 +1402,8 @@ static void fst_process_verilog(wave_dumper_t *wd, rt_scope_t *scope,
 
    data->decl   = wrap;
    data->signal = s;
-   data->watch  = watch_new(wd->model, fst_event_cb, data, WATCH_POSTPONED, 1);
 
-   const int width = signal_width(data->signal);
-   model_set_event_cb(wd->model, data->signal, 0, width, data->watch);
-
-   APUSH(wd->dumped, data);
+   fst_add_data(wd, data);
 
    gtkw_end_of_signal(wd->gtkw, tb_get(tb));
 }
@@ -1102,14 +1428,16 @@ static void fst_enter_scope(wave_dumper_t *wd, tree_t unit, rt_scope_t *scope,
    }
 
    const loc_t *loc = tree_loc(unit);
-   fstWriterSetSourceStem(wd->fst_ctx, loc_file_str(loc), loc->first_line, 1);
+   if (wd->fst_ctx != NULL)
+      fstWriterSetSourceStem(wd->fst_ctx, loc_file_str(loc),
+                             loc->first_line, 1);
 
    tb_rewind(tb);
    tb_istr(tb, tree_ident(scope->where));
    tb_downcase(tb);
 
    // TODO: store the component name in T_HIER somehow?
-   fstWriterSetScope(wd->fst_ctx, st, tb_get(tb), "");
+   wave_set_scope(wd, st, tb_get(tb));
 
    if (wd->gtkw != NULL) {
       if (scope->kind == SCOPE_INSTANCE && tb_len(wd->gtkw->hier) > 0)
@@ -1124,7 +1452,7 @@ static void fst_enter_scope(wave_dumper_t *wd, tree_t unit, rt_scope_t *scope,
 
 static void fst_leave_scope(wave_dumper_t *wd)
 {
-   fstWriterSetUpscope(wd->fst_ctx);
+   wave_set_upscope(wd);
 
    if (wd->gtkw != NULL) {
       const char *h = tb_get(wd->gtkw->hier);
@@ -1134,7 +1462,7 @@ static void fst_leave_scope(wave_dumper_t *wd)
    }
 }
 
-static void fst_walk_design(wave_dumper_t *wd, tree_t block)
+static void fst_walk_design(wave_dumper_t *wd, tree_t block, bool excluded)
 {
    tree_t h = tree_decl(block, 0);
    assert(tree_kind(h) == T_HIER);
@@ -1155,10 +1483,14 @@ static void fst_walk_design(wave_dumper_t *wd, tree_t block)
       scope = find_scope(wd->model, block);
    }
 
+   LOCAL_TEXT_BUF path = tb_new();
+   if (!excluded)
+      excluded = wave_exclude_scope(scope, path);
+
    const int nports = tree_ports(block);
    for (int i = 0; i < nports; i++) {
       tree_t p = tree_port(block, i);
-      if (wave_should_dump(scope, tree_ident(p)))
+      if (wave_should_dump(path, tree_ident(p), excluded))
          fst_process_signal(wd, scope, p, tree_type(p), tb);
    }
 
@@ -1167,7 +1499,7 @@ static void fst_walk_design(wave_dumper_t *wd, tree_t block)
       tree_t d = tree_decl(block, i);
       switch (tree_kind(d)) {
       case T_SIGNAL_DECL:
-         if (wave_should_dump(scope, tree_ident(d)))
+         if (wave_should_dump(path, tree_ident(d), excluded))
             fst_process_signal(wd, scope, d, tree_type(d), tb);
          break;
       case T_VERILOG:
@@ -1176,7 +1508,7 @@ static void fst_walk_design(wave_dumper_t *wd, tree_t block)
             const vlog_kind_t kind = vlog_kind(v);
             if (kind != V_NET_DECL && kind != V_VAR_DECL)
                continue;
-            else if (wave_should_dump(scope, vlog_ident(v)))
+            else if (wave_should_dump(path, vlog_ident(v), excluded))
                fst_process_verilog(wd, scope, d, v, tb);
          }
          break;
@@ -1190,7 +1522,7 @@ static void fst_walk_design(wave_dumper_t *wd, tree_t block)
       tree_t s = tree_stmt(block, i);
       switch (tree_kind(s)) {
       case T_BLOCK:
-         fst_walk_design(wd, s);
+         fst_walk_design(wd, s, excluded);
          break;
       case T_PROCESS:
       case T_VERILOG:
@@ -1241,7 +1573,7 @@ void wave_dumper_restart(wave_dumper_t *wd, rt_model_t *m, jit_t *jit)
    wd->model     = m;
    wd->jit       = jit;
 
-   fst_walk_design(wd, tree_stmt(wd->top, 0));
+   fst_walk_design(wd, tree_stmt(wd->top, 0), false);
    fst_walk_packages(wd);
 
    if (wd->gtkw != NULL) {
@@ -1253,9 +1585,31 @@ void wave_dumper_restart(wave_dumper_t *wd, rt_model_t *m, jit_t *jit)
 
    // Emitting the initial values must happen after all FST variables
    // are created to avoid expensive mmap/munmap calls
-   for (int i = 0; i < wd->dumped.count; i++) {
-      fst_data_t *data = wd->dumped.items[i];
-      fst_event_cb(0, data->signal, data->watch, data);
+   if (wd->start == 0) {
+      for (int i = 0; i < wd->dumped.count; i++) {
+         fst_data_t *data = wd->dumped.items[i];
+         fst_event_cb(0, data->signal, data->watch, data);
+      }
+   }
+   else {
+      // The watches are needed to find aliases while walking the design
+      // but are not armed until the start of the dump window
+      wave_stop_cb(m, wd);
+      model_set_timeout_cb(m, wd->start, wave_start_cb, wd);
+   }
+
+   if (wd->stop != TIME_HIGH)
+      model_set_timeout_cb(m, wd->stop, wave_stop_cb, wd);
+
+   // Value changes are formatted and compressed by a background thread
+   // once the hierarchy has been written
+   const size_t budget = opt_get_size(OPT_WAVE_BUFFER);
+   if (budget > 0 && wd->dumped.count > 0) {
+      if (wd->ring == NULL)
+         wd->ring = wave_ring_new(budget);
+
+      wd->ring->stop   = false;
+      wd->ring->thread = thread_create(wave_writer_thread, wd, "wave writer");
    }
 
    model_set_phase_cb(m, END_OF_SIMULATION, fst_close, wd);
@@ -1268,41 +1622,23 @@ wave_dumper_t *wave_dumper_new(const char *file, const char *gtkw_file,
    wd->top       = top;
    wd->last_time = UINT64_MAX;
    wd->typecache = hash_new(128);
+   wd->stop      = TIME_HIGH;
 
-   if (format == WAVE_FORMAT_VCD) {
-#if defined __CYGWIN__ || defined __MINGW32__
-      const char *tmpdir = ".";
-#else
-      char tmpdir[PATH_MAX] = "/tmp/vcdXXXXXX";
-      checked_sprintf(tmpdir, PATH_MAX, "%s/vcdXXXXXX",
-                      getenv("TMPDIR") ?: "/tmp");
-      if (mkdtemp(tmpdir) == NULL)
-         fatal_errno("mkdtemp");
-#endif
-
-      wd->vcdfile = fopen(file, "wb");
-      if (wd->vcdfile == NULL)
-         fatal_errno("%s", file);
-
-      wd->tmpfst  = xasprintf("%s" DIR_SEP "temp.fst", tmpdir);
-      wd->fst_ctx = fstWriterCreate(wd->tmpfst, 1);
-   }
+   if (format == WAVE_FORMAT_VCD)
+      wd->vcd = vcd_writer_new(file, PACKAGE_STRING);
    else {
-      wd->vcdfile = NULL;
-      wd->tmpfst  = NULL;
       wd->fst_ctx = fstWriterCreate(file, 1);
+      if (wd->fst_ctx == NULL)
+         fatal("fstWriterCreate failed");
+
+      fstWriterSetFileType(wd->fst_ctx, FST_FT_VHDL);
+      fstWriterSetTimescale(wd->fst_ctx, -15);
+      fstWriterSetVersion(wd->fst_ctx, PACKAGE_STRING);
+      fstWriterSetPackType(wd->fst_ctx, 0);
+      fstWriterSetRepackOnClose(wd->fst_ctx, 1);
+      fstWriterSetParallelMode(wd->fst_ctx, 0);
    }
 
-   if (wd->fst_ctx == NULL)
-      fatal("fstWriterCreate failed");
-
-   fstWriterSetFileType(wd->fst_ctx, FST_FT_VHDL);
-   fstWriterSetTimescale(wd->fst_ctx, -15);
-   fstWriterSetVersion(wd->fst_ctx, PACKAGE_STRING);
-   fstWriterSetPackType(wd->fst_ctx, 0);
-   fstWriterSetRepackOnClose(wd->fst_ctx, 1);
-   fstWriterSetParallelMode(wd->fst_ctx, 0);
-
    if (gtkw_file != NULL) {
       wd->gtkw = xcalloc(sizeof(gtkw_writer_t));
       if ((wd->gtkw->file = fopen(gtkw_file, "w")) == NULL)
@@ -1317,14 +1653,29 @@ wave_dumper_t *wave_dumper_new(const char *file, const char *gtkw_file,
 
 void wave_dumper_free(wave_dumper_t *wd)
 {
-   for (int i = 0; i < wd->dumped.count; i++)
+   for (int i = 0; i < wd->dumped.count; i++) {
+      free(wd->dumped.items[i]->packed);
       free(wd->dumped.items[i]);
+   }
    ACLEAR(wd->dumped);
 
+   if (wd->ring != NULL) {
+      wave_ring_stop(wd);
+      wave_ring_free(wd->ring);
+   }
+
    hash_free(wd->typecache);
    free(wd);
 }
 
+void wave_dumper_set_window(wave_dumper_t *wd, uint64_t start, uint64_t stop)
+{
+   assert(start < stop);
+
+   wd->start = start;
+   wd->stop  = stop;
+}
+
 void wave_include_glob(const char *glob)
 {
    APUSH(incl, ((glob_t){ .text = strdup(glob), .len = strlen(glob) }));
@@ -1375,28 +1726,61 @@ void wave_include_file(const char *base)
    wave_process_file(exclf, false);
 }
 
-static bool wave_should_dump(rt_scope_t *scope, ident_t id)
+static bool wave_glob_walk(const char *str, const char *g, bool prefix)
 {
-   if (excl.count == 0 && incl.count == 0)
-      return true;
+   if (prefix && g[0] == '*' && g[1] == '\0')
+      return true;   // Matches anything following the prefix
+   else if (*str == '\0')
+      return *g == '\0' && !prefix;
+   else if (*g == '\0')
+      return false;
+   else if (*g == '*')
+      return wave_glob_walk(str + 1, g, prefix)
+         || wave_glob_walk(str + 1, g + 1, prefix);
+   else if (*str == *g)
+      return wave_glob_walk(str + 1, g + 1, prefix);
+   else
+      return false;
+}
 
-   LOCAL_TEXT_BUF tb = tb_new();
-   get_path_name(scope, tb);
-   tb_append(tb, ':');
-   tb_istr(tb, id);
-   tb_downcase(tb);
+static bool wave_exclude_scope(rt_scope_t *scope, text_buf_t *path)
+{
+   if (excl.count == 0 && incl.count == 0)
+      return false;
 
-   ident_t name = ident_new(tb_get(tb));
+   get_path_name(scope, path);
+   tb_append(path, ':');
+   tb_downcase(path);
 
+   // All signals in the scope and its children are excluded if an
+   // exclude pattern ending in a wildcard matches a prefix of the path
    for (int i = 0; i < excl.count; i++) {
-      if (ident_glob(name, excl.items[i].text, excl.items[i].len))
-         return false;
-   }
-
-   for (int i = 0; i < incl.count; i++) {
-      if (ident_glob(name, incl.items[i].text, incl.items[i].len))
+      if (wave_glob_walk(tb_get(path), excl.items[i].text, true))
          return true;
    }
 
-   return (incl.count == 0);
+   return false;
+}
+
+static bool wave_should_dump(text_buf_t *path, ident_t id, bool excluded)
+{
+   if (excluded)
+      return false;
+   else if (excl.count == 0 && incl.count == 0)
+      return true;
+
+   const size_t len = tb_len(path);
+   tb_istr(path, id);
+   tb_downcase(path);
+
+   bool dump = (incl.count == 0);
+
+   for (int i = 0; i < incl.count && !dump; i++)
+      dump = wave_glob_walk(tb_get(path), incl.items[i].text, false);
+
+   for (int i = 0; i < excl.count && dump; i++)
+      dump = !wave_glob_walk(tb_get(path), excl.items[i].text, false);
+
+   tb_trim(path, len);
+   return dump;
 }
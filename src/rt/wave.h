@@ -29,6 +29,13 @@ wave_dumper_t *wave_dumper_new(const char *file, const char *gtkw_file,
                                tree_t top, wave_format_t format);
 void wave_dumper_free(wave_dumper_t *wd);
 void wave_dumper_restart(wave_dumper_t *wd, rt_model_t *m, jit_t *jit);
+void wave_dumper_set_window(wave_dumper_t *wd, uint64_t start, uint64_t stop);
+
+typedef struct _wave_server wave_server_t;
+
+wave_server_t *wave_server_new(unsigned port);
+void wave_server_free(wave_server_t *ws);
+void wave_server_restart(wave_server_t *ws, rt_model_t *m);
 
 void wave_include_glob(const char *glob);
 void wave_exclude_glob(const char *glob);
@@ -0,0 +1,619 @@
+//
+//  Copyright (C) 2026  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "array.h"
+#include "hash.h"
+#include "ident.h"
+#include "rt/model.h"
+#include "rt/rt.h"
+#include "rt/structs.h"
+#include "rt/wave.h"
+#include "tree.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef __MINGW32__
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// Streams value changes to waveform viewers connected over TCP while
+// the simulation is running.  Every message in both directions is a
+// one byte opcode followed by a 32-bit payload length and then the
+// payload.  All integers are little-endian.
+//
+// Requests from the client:
+//
+//   WS_LIST         scope:u32
+//   WS_SUBSCRIBE    signal:u32
+//   WS_UNSUBSCRIBE  signal:u32
+//
+// Messages from the server:
+//
+//   WS_SCOPE   scope:u32 count:u32 { kind:u8 id:u32 [size:u8 width:u32]
+//              length:u16 name }*
+//   WS_TIME    now:u64
+//   WS_CHANGE  signal:u32 value
+//   WS_ERROR   message
+//   WS_END     now:u64
+//
+// Scope zero is the root of the design and the identifiers of child
+// scopes and signals are returned by WS_LIST.  Child entries have kind
+// zero for a scope and one for a signal.  A WS_CHANGE message with the
+// current value is sent immediately after subscribing and thereafter
+// whenever the signal changes, preceded by WS_TIME if the simulation
+// time has advanced.  Time is in femtoseconds.
+//
+// A signal only has a watch while at least one client is subscribed to
+// it so signals that nobody is looking at cost nothing.
+
+#ifndef __MINGW32__
+
+#define WS_HEADER_SIZE    5
+#define WS_MAX_CLIENTS    64
+#define WS_POLL_INTERVAL  1000       // Microseconds
+#define WS_FLUSH_SIZE     (1 << 20)
+#define WS_MAX_BUFFERED   (64 << 20)
+#define WS_MAX_REQUEST    4096       // Largest request payload accepted
+
+typedef enum {
+   WS_LIST        = 0x01,
+   WS_SUBSCRIBE   = 0x02,
+   WS_UNSUBSCRIBE = 0x03,
+   WS_SCOPE       = 0x81,
+   WS_TIME        = 0x82,
+   WS_CHANGE      = 0x83,
+   WS_ERROR       = 0x84,
+   WS_END         = 0x85,
+} ws_opcode_t;
+
+typedef struct {
+   uint8_t *data;
+   size_t   len;
+   size_t   limit;
+} ws_buf_t;
+
+typedef struct {
+   int      fd;
+   uint64_t last_time;
+   ws_buf_t out;
+   ws_buf_t in;
+} ws_client_t;
+
+typedef struct {
+   wave_server_t *server;
+   rt_signal_t   *signal;
+   rt_watch_t    *watch;
+   uint64_t       subscribers;
+   uint32_t       id;
+} ws_signal_t;
+
+typedef A(ws_signal_t *) ws_signal_list_t;
+
+typedef struct _wave_server {
+   rt_model_t       *model;
+   int               listenfd;
+   unsigned          port;
+   ws_client_t      *clients[WS_MAX_CLIENTS];
+   ws_signal_list_t  signals;
+   scope_list_t      scopes;
+   hash_t           *signalmap;
+   hash_t           *scopemap;
+   uint64_t          last_poll;
+} wave_server_t;
+
+static void ws_reserve(ws_buf_t *b, size_t more)
+{
+   if (b->len + more > b->limit) {
+      b->limit = MAX(b->limit * 2, MAX(b->len + more, 4096));
+      b->data = xrealloc(b->data, b->limit);
+   }
+}
+
+static inline void ws_put_raw(ws_buf_t *b, const void *data, size_t len)
+{
+   ws_reserve(b, len);
+   memcpy(b->data + b->len, data, len);
+   b->len += len;
+}
+
+static inline void ws_put_u8(ws_buf_t *b, uint8_t value)
+{
+   ws_reserve(b, 1);
+   b->data[b->len++] = value;
+}
+
+static void ws_put_le(ws_buf_t *b, uint64_t value, int bytes)
+{
+   ws_reserve(b, bytes);
+   for (int i = 0; i < bytes; i++, value >>= 8)
+      b->data[b->len++] = value & 0xff;
+}
+
+static uint64_t ws_get_le(const uint8_t *p, int bytes)
+{
+   uint64_t value = 0;
+   for (int i = bytes - 1; i >= 0; i--)
+      value = (value << 8) | p[i];
+   return value;
+}
+
+static size_t ws_begin(ws_buf_t *b, ws_opcode_t op)
+{
+   const size_t start = b->len;
+   ws_put_u8(b, op);
+   ws_put_le(b, 0, 4);
+   return start;
+}
+
+static void ws_end(ws_buf_t *b, size_t start)
+{
+   const uint32_t len = b->len - start - WS_HEADER_SIZE;
+   for (int i = 0; i < 4; i++)
+      b->data[start + 1 + i] = (len >> (i * 8)) & 0xff;
+}
+
+static void ws_error(ws_client_t *c, const char *fmt, ...)
+{
+   va_list ap;
+   va_start(ap, fmt);
+   char *msg LOCAL = xvasprintf(fmt, ap);
+   va_end(ap);
+
+   const size_t start = ws_begin(&c->out, WS_ERROR);
+   ws_put_raw(&c->out, msg, strlen(msg));
+   ws_end(&c->out, start);
+}
+
+static uint32_t ws_scope_id(wave_server_t *ws, rt_scope_t *scope)
+{
+   void *id = hash_get(ws->scopemap, scope);
+   if (id != NULL)
+      return (uintptr_t)id - 1;
+
+   const uint32_t next = ws->scopes.count;
+   APUSH(ws->scopes, scope);
+   hash_put(ws->scopemap, scope, (void *)(uintptr_t)(next + 1));
+   return next;
+}
+
+static ws_signal_t *ws_signal_for(wave_server_t *ws, rt_signal_t *s)
+{
+   ws_signal_t *wsig = hash_get(ws->signalmap, s);
+   if (wsig == NULL) {
+      wsig = xcalloc(sizeof(ws_signal_t));
+      wsig->server = ws;
+      wsig->signal = s;
+      wsig->id     = ws->signals.count;
+
+      APUSH(ws->signals, wsig);
+      hash_put(ws->signalmap, s, wsig);
+   }
+
+   return wsig;
+}
+
+static const char *ws_scope_name(rt_scope_t *scope)
+{
+   if (scope->kind == SCOPE_PACKAGE)
+      return istr(scope->name);
+   else
+      return istr(tree_ident(scope->where));
+}
+
+static void ws_put_name(ws_buf_t *b, const char *name)
+{
+   const size_t len = MIN(strlen(name), UINT16_MAX);
+   ws_put_le(b, len, 2);
+   ws_put_raw(b, name, len);
+}
+
+static void ws_send_change(ws_client_t *c, ws_signal_t *wsig, uint64_t now)
+{
+   if (now != c->last_time) {
+      const size_t start = ws_begin(&c->out, WS_TIME);
+      ws_put_le(&c->out, now, 8);
+      ws_end(&c->out, start);
+
+      c->last_time = now;
+   }
+
+   const size_t start = ws_begin(&c->out, WS_CHANGE);
+   ws_put_le(&c->out, wsig->id, 4);
+   ws_put_raw(&c->out, signal_value(wsig->signal), wsig->signal->shared.size);
+   ws_end(&c->out, start);
+}
+
+static void ws_event_cb(uint64_t now, rt_signal_t *s, rt_watch_t *w,
+                        void *user)
+{
+   ws_signal_t *wsig = user;
+   wave_server_t *ws = wsig->server;
+
+   for (uint64_t mask = wsig->subscribers; mask != 0; mask &= mask - 1)
+      ws_send_change(ws->clients[__builtin_ctzll(mask)], wsig, now);
+}
+
+static void ws_list(wave_server_t *ws, ws_client_t *c, uint32_t id)
+{
+   if (id >= ws->scopes.count) {
+      ws_error(c, "invalid scope %u", id);
+      return;
+   }
+
+   rt_scope_t *scope = ws->scopes.items[id];
+
+   const size_t start = ws_begin(&c->out, WS_SCOPE);
+   ws_put_le(&c->out, id, 4);
+   ws_put_le(&c->out, scope->children.count + scope->signals.count, 4);
+
+   for (int i = 0; i < scope->children.count; i++) {
+      rt_scope_t *child = scope->children.items[i];
+      ws_put_u8(&c->out, 0);
+      ws_put_le(&c->out, ws_scope_id(ws, child), 4);
+      ws_put_name(&c->out, ws_scope_name(child));
+   }
+
+   for (int i = 0; i < scope->signals.count; i++) {
+      rt_signal_t *s = scope->signals.items[i];
+      ws_put_u8(&c->out, 1);
+      ws_put_le(&c->out, ws_signal_for(ws, s)->id, 4);
+      ws_put_u8(&c->out, signal_size(s));
+      ws_put_le(&c->out, signal_width(s), 4);
+      ws_put_name(&c->out, istr(tree_ident(s->where)));
+   }
+
+   ws_end(&c->out, start);
+}
+
+static void ws_subscribe(wave_server_t *ws, int index, uint32_t id)
+{
+   ws_client_t *c = ws->clients[index];
+
+   if (id >= ws->signals.count) {
+      ws_error(c, "invalid signal %u", id);
+      return;
+   }
+
+   ws_signal_t *wsig = ws->signals.items[id];
+   if (wsig->watch == NULL) {
+      rt_signal_t *s = wsig->signal;
+      wsig->watch = watch_new(ws->model, ws_event_cb, wsig,
+                              WATCH_POSTPONED, 1);
+      model_set_event_cb(ws->model, s, 0, signal_width(s), wsig->watch);
+   }
+
+   wsig->subscribers |= UINT64_C(1) << index;
+
+   ws_send_change(c, wsig, model_now(ws->model, NULL));
+}
+
+static void ws_unsubscribe(wave_server_t *ws, int index, uint32_t id)
+{
+   if (id >= ws->signals.count) {
+      ws_error(ws->clients[index], "invalid signal %u", id);
+      return;
+   }
+
+   ws_signal_t *wsig = ws->signals.items[id];
+   wsig->subscribers &= ~(UINT64_C(1) << index);
+
+   if (wsig->subscribers == 0 && wsig->watch != NULL) {
+      watch_free(ws->model, wsig->watch);
+      wsig->watch = NULL;
+   }
+}
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static void ws_close_client(wave_server_t *ws, int index)
+{
+   ws_client_t *c = ws->clients[index];
+
+   for (int i = 0; i < ws->signals.count; i++) {
+      if (ws->signals.items[i]->subscribers & (UINT64_C(1) << index))
+         ws_unsubscribe(ws, index, i);
+   }
+
+   close(c->fd);
+   free(c->out.data);
+   free(c->in.data);
+   free(c);
+
+   ws->clients[index] = NULL;
+}
+
+static bool ws_flush(ws_client_t *c, bool block)
+{
+   size_t sent = 0;
+   while (sent < c->out.len) {
+      ssize_t n = send(c->fd, c->out.data + sent, c->out.len - sent,
+                       MSG_NOSIGNAL);
+      if (n > 0)
+         sent += n;
+      else if (n < 0 && errno == EINTR)
+         continue;
+      else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+         // Stall the simulation rather than buffer without limit when a
+         // client cannot keep up
+         if (!block && c->out.len - sent < WS_MAX_BUFFERED)
+            break;
+
+         struct pollfd pfd = { .fd = c->fd, .events = POLLOUT };
+         if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+            return false;
+      }
+      else
+         return false;
+   }
+
+   memmove(c->out.data, c->out.data + sent, c->out.len - sent);
+   c->out.len -= sent;
+   return true;
+}
+
+static bool ws_process_input(wave_server_t *ws, int index)
+{
+   ws_client_t *c = ws->clients[index];
+
+   size_t pos = 0;
+   while (c->in.len - pos >= WS_HEADER_SIZE) {
+      const uint8_t *p = c->in.data + pos;
+      const uint32_t len = ws_get_le(p + 1, 4);
+      if (len > WS_MAX_REQUEST) {
+         // All valid requests are tiny so do not let a misbehaving
+         // client make the server buffer an arbitrary amount of data
+         ws_error(c, "request length %u exceeds limit of %d bytes",
+                  len, WS_MAX_REQUEST);
+         ws_flush(c, false);
+         return false;
+      }
+      else if (c->in.len - pos < WS_HEADER_SIZE + len)
+         break;
+
+      const uint8_t *payload = p + WS_HEADER_SIZE;
+      const uint32_t id = len >= 4 ? ws_get_le(payload, 4) : UINT32_MAX;
+
+      switch (p[0]) {
+      case WS_LIST:
+         ws_list(ws, c, id);
+         break;
+      case WS_SUBSCRIBE:
+         ws_subscribe(ws, index, id);
+         break;
+      case WS_UNSUBSCRIBE:
+         ws_unsubscribe(ws, index, id);
+         break;
+      default:
+         ws_error(c, "invalid request %02x", p[0]);
+         break;
+      }
+
+      pos += WS_HEADER_SIZE + len;
+   }
+
+   memmove(c->in.data, c->in.data + pos, c->in.len - pos);
+   c->in.len -= pos;
+   return true;
+}
+
+static bool ws_read(wave_server_t *ws, int index)
+{
+   ws_client_t *c = ws->clients[index];
+
+   for (;;) {
+      ws_reserve(&c->in, 4096);
+
+      ssize_t n = recv(c->fd, c->in.data + c->in.len,
+                       c->in.limit - c->in.len, 0);
+      if (n > 0) {
+         // Handle complete requests as they arrive so the input buffer
+         // never holds more than one partial request
+         c->in.len += n;
+         if (!ws_process_input(ws, index))
+            return false;
+      }
+      else if (n < 0 && errno == EINTR)
+         continue;
+      else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+         return true;
+      else
+         return false;   // Closed by peer or error
+   }
+}
+
+static void ws_accept(wave_server_t *ws)
+{
+   for (;;) {
+      int fd = accept(ws->listenfd, NULL, NULL);
+      if (fd < 0)
+         return;
+
+      int index = 0;
+      for (; index < WS_MAX_CLIENTS && ws->clients[index]; index++);
+
+      if (index == WS_MAX_CLIENTS) {
+         warnf("rejecting waveform viewer connection: too many clients");
+         close(fd);
+         continue;
+      }
+
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+      const int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+      setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+
+      ws_client_t *c = xcalloc(sizeof(ws_client_t));
+      c->fd        = fd;
+      c->last_time = UINT64_MAX;
+
+      ws->clients[index] = c;
+   }
+}
+
+static void ws_poll(wave_server_t *ws)
+{
+   ws_accept(ws);
+
+   for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+      ws_client_t *c = ws->clients[i];
+      if (c == NULL)
+         continue;
+      else if (!ws_read(ws, i) || !ws_flush(c, false))
+         ws_close_client(ws, i);
+   }
+
+   ws->last_poll = get_timestamp_us();
+}
+
+static void ws_end_time_step_cb(rt_model_t *m, void *arg)
+{
+   wave_server_t *ws = arg;
+
+   // Batch network traffic over several time steps unless a large
+   // amount of data is waiting to be sent
+   bool full = false;
+   for (int i = 0; i < WS_MAX_CLIENTS && !full; i++)
+      full = ws->clients[i] != NULL && ws->clients[i]->out.len > WS_FLUSH_SIZE;
+
+   if (full || get_timestamp_us() - ws->last_poll >= WS_POLL_INTERVAL)
+      ws_poll(ws);
+
+   // Phase callbacks only fire once
+   model_set_phase_cb(m, END_TIME_STEP, ws_end_time_step_cb, ws);
+}
+
+static void ws_end_of_sim_cb(rt_model_t *m, void *arg)
+{
+   wave_server_t *ws = arg;
+
+   const uint64_t now = model_now(m, NULL);
+
+   for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+      ws_client_t *c = ws->clients[i];
+      if (c == NULL)
+         continue;
+
+      const size_t start = ws_begin(&c->out, WS_END);
+      ws_put_le(&c->out, now, 8);
+      ws_end(&c->out, start);
+
+      ws_flush(c, true);
+      ws_close_client(ws, i);
+   }
+}
+
+wave_server_t *wave_server_new(unsigned port)
+{
+   if (port == 0 || port > UINT16_MAX)
+      fatal("invalid waveform server port %u", port);
+
+   int fd = socket(AF_INET, SOCK_STREAM, 0);
+   if (fd < 0)
+      fatal_errno("socket");
+
+   const int one = 1;
+   setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+   // Only listen on the loopback interface: remote viewers should
+   // connect through a tunnel as the protocol is not authenticated
+   struct sockaddr_in addr = {
+      .sin_family      = AF_INET,
+      .sin_port        = htons(port),
+      .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+   };
+
+   if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+      fatal_errno("cannot bind to port %u", port);
+
+   if (listen(fd, WS_MAX_CLIENTS) < 0)
+      fatal_errno("listen");
+
+   fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+   wave_server_t *ws = xcalloc(sizeof(wave_server_t));
+   ws->listenfd  = fd;
+   ws->port      = port;
+   ws->signalmap = hash_new(256);
+   ws->scopemap  = hash_new(64);
+
+   notef("waveform server listening on port %u", port);
+
+   return ws;
+}
+
+void wave_server_free(wave_server_t *ws)
+{
+   for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+      if (ws->clients[i] != NULL)
+         ws_close_client(ws, i);
+   }
+
+   for (int i = 0; i < ws->signals.count; i++)
+      free(ws->signals.items[i]);
+
+   close(ws->listenfd);
+
+   ACLEAR(ws->signals);
+   ACLEAR(ws->scopes);
+   hash_free(ws->signalmap);
+   hash_free(ws->scopemap);
+   free(ws);
+}
+
+void wave_server_restart(wave_server_t *ws, rt_model_t *m)
+{
+   assert(ws->model == NULL);
+
+   ws->model = m;
+
+   ws_scope_id(ws, root_scope(m));
+
+   model_set_phase_cb(m, END_TIME_STEP, ws_end_time_step_cb, ws);
+   model_set_phase_cb(m, END_OF_SIMULATION, ws_end_of_sim_cb, ws);
+}
+
+#else   // __MINGW32__
+
+wave_server_t *wave_server_new(unsigned port)
+{
+   fatal("the waveform server is not supported on this platform");
+}
+
+void wave_server_free(wave_server_t *ws)
+{
+}
+
+void wave_server_restart(wave_server_t *ws, rt_model_t *m)
+{
+}
+
+#endif  // __MINGW32__
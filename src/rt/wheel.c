@@ -0,0 +1,307 @@
+//
+//  Copyright (C) 2026  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "rt/heap.h"
+#include "rt/rt.h"
+#include "rt/wheel.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Hierarchical timing wheel: an event is placed at the level given by
+// the most significant group of bits where its key differs from the
+// base time so insertion is O(1).  Events further than WHEEL_SPAN bits
+// in the future are stored in a binary heap.
+
+#define WHEEL_BITS   6
+#define WHEEL_SLOTS  (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 6
+#define WHEEL_SPAN   (WHEEL_BITS * WHEEL_LEVELS)
+
+typedef struct {
+   uint64_t  key;
+   void     *user;
+} wheel_entry_t;
+
+typedef struct {
+   wheel_entry_t *entries;
+   unsigned       head;
+   unsigned       count;
+   unsigned       max;
+} wheel_slot_t;
+
+typedef struct {
+   uint64_t     bitmap;
+   wheel_slot_t slots[WHEEL_SLOTS];
+} wheel_level_t;
+
+struct _wheel {
+   uint64_t       base;
+   size_t         size;
+   heap_t        *far;
+   nvc_lock_t     lock;
+   wheel_level_t  levels[WHEEL_LEVELS];
+};
+
+static inline int wheel_level(wheel_t *w, uint64_t key)
+{
+   const uint64_t diff = key ^ w->base;
+   if (diff == 0)
+      return 0;
+   else
+      return (63 - __builtin_clzll(diff)) / WHEEL_BITS;
+}
+
+static void wheel_place(wheel_t *w, int level, uint64_t key, void *user)
+{
+   wheel_level_t *l = &(w->levels[level]);
+   const int index = (key >> (level * WHEEL_BITS)) & (WHEEL_SLOTS - 1);
+   wheel_slot_t *s = &(l->slots[index]);
+
+   if (unlikely(s->count == s->max)) {
+      s->max = MAX(s->max * 2, 16);
+      s->entries = xrealloc_array(s->entries, s->max, sizeof(wheel_entry_t));
+   }
+
+   s->entries[s->count++] = (wheel_entry_t){ key, user };
+   l->bitmap |= UINT64_C(1) << index;
+}
+
+static void wheel_remove(wheel_level_t *l, int index, unsigned pos)
+{
+   wheel_slot_t *s = &(l->slots[index]);
+   assert(pos >= s->head && pos < s->count);
+
+   memmove(s->entries + pos, s->entries + pos + 1,
+           (s->count - pos - 1) * sizeof(wheel_entry_t));
+
+   if (--(s->count) == s->head) {
+      s->head = s->count = 0;
+      l->bitmap &= ~(UINT64_C(1) << index);
+   }
+}
+
+static void wheel_cascade(wheel_t *w)
+{
+   // Advance the base time to the earliest non-empty slot and move
+   // its events down to lower levels until level zero is populated
+   while (w->levels[0].bitmap == 0) {
+      int level = 1;
+      while (w->levels[level].bitmap == 0)
+         level++;
+
+      assert(level < WHEEL_LEVELS);
+
+      wheel_level_t *l = &(w->levels[level]);
+      const int index = __builtin_ctzll(l->bitmap);
+      const int shift = level * WHEEL_BITS;
+      const uint64_t mask = (UINT64_C(1) << (shift + WHEEL_BITS)) - 1;
+
+      w->base = (w->base & ~mask) | ((uint64_t)index << shift);
+
+      wheel_slot_t *s = &(l->slots[index]);
+      for (unsigned i = s->head; i < s->count; i++) {
+         const int newlevel = wheel_level(w, s->entries[i].key);
+         assert(newlevel < level);
+         wheel_place(w, newlevel, s->entries[i].key, s->entries[i].user);
+      }
+
+      s->head = s->count = 0;
+      l->bitmap &= ~(UINT64_C(1) << index);
+   }
+}
+
+static uint64_t wheel_near_min_key(wheel_t *w)
+{
+   assert(w->size > 0);
+
+   int level = 0;
+   while (w->levels[level].bitmap == 0)
+      level++;
+
+   assert(level < WHEEL_LEVELS);
+
+   const wheel_level_t *l = &(w->levels[level]);
+   const wheel_slot_t *s = &(l->slots[__builtin_ctzll(l->bitmap)]);
+
+   if (level == 0)
+      return s->entries[s->head].key;   // All keys in slot are equal
+
+   uint64_t min = UINT64_MAX;
+   for (unsigned i = s->head; i < s->count; i++)
+      min = MIN(min, s->entries[i].key);
+
+   return min;
+}
+
+static inline bool wheel_take_far(wheel_t *w)
+{
+   if (heap_size(w->far) == 0)
+      return false;
+   else if (w->size == 0)
+      return true;
+   else
+      return heap_min_key(w->far) < wheel_near_min_key(w);
+}
+
+static void wheel_rebase(wheel_t *w, uint64_t key)
+{
+   // Move the base time forward to an event taken from the far heap so
+   // later events are inserted into the wheel again and then pull in
+   // any far events which are now close enough
+   assert(w->size == 0);
+   w->base = key;
+
+   while (heap_size(w->far) > 0) {
+      const uint64_t next = heap_min_key(w->far);
+      if (next < w->base || wheel_level(w, next) >= WHEEL_LEVELS)
+         break;
+
+      wheel_place(w, wheel_level(w, next), next, heap_extract_min(w->far));
+      w->size++;
+   }
+}
+
+wheel_t *wheel_new(void)
+{
+   wheel_t *w = xcalloc(sizeof(wheel_t));
+   w->far = heap_new(64);
+   return w;
+}
+
+void wheel_free(wheel_t *w)
+{
+   for (int i = 0; i < WHEEL_LEVELS; i++) {
+      for (int j = 0; j < WHEEL_SLOTS; j++)
+         free(w->levels[i].slots[j].entries);
+   }
+
+   heap_free(w->far);
+   free(w);
+}
+
+void wheel_insert(wheel_t *w, uint64_t key, void *user)
+{
+   RT_LOCK(w->lock);
+
+   const int level = key < w->base ? WHEEL_LEVELS : wheel_level(w, key);
+   if (level >= WHEEL_LEVELS)
+      heap_insert(w->far, key, user);   // Far future
+   else {
+      wheel_place(w, level, key, user);
+      w->size++;
+   }
+}
+
+void *wheel_extract_min(wheel_t *w)
+{
+   RT_LOCK(w->lock);
+
+   if (wheel_take_far(w)) {
+      const uint64_t key = heap_min_key(w->far);
+      void *user = heap_extract_min(w->far);
+
+      if (w->size == 0)
+         wheel_rebase(w, key);
+
+      return user;
+   }
+
+   wheel_cascade(w);
+
+   wheel_level_t *l = &(w->levels[0]);
+   const int index = __builtin_ctzll(l->bitmap);
+   wheel_slot_t *s = &(l->slots[index]);
+
+   void *user = s->entries[s->head++].user;
+   w->size--;
+
+   if (s->head == s->count) {
+      s->head = s->count = 0;
+      l->bitmap &= ~(UINT64_C(1) << index);
+   }
+
+   return user;
+}
+
+void *wheel_min(wheel_t *w)
+{
+   RT_LOCK(w->lock);
+
+   if (wheel_take_far(w))
+      return heap_min(w->far);
+
+   wheel_cascade(w);
+
+   const wheel_level_t *l = &(w->levels[0]);
+   const wheel_slot_t *s = &(l->slots[__builtin_ctzll(l->bitmap)]);
+   return s->entries[s->head].user;
+}
+
+uint64_t wheel_min_key(wheel_t *w)
+{
+   RT_LOCK(w->lock);
+
+   if (wheel_take_far(w))
+      return heap_min_key(w->far);
+   else
+      return wheel_near_min_key(w);
+}
+
+size_t wheel_size(wheel_t *w)
+{
+   return atomic_load(&w->size) + heap_size(w->far);
+}
+
+void wheel_walk(wheel_t *w, heap_walk_fn_t fn, void *context)
+{
+   RT_LOCK(w->lock);
+
+   for (int i = 0; i < WHEEL_LEVELS; i++) {
+      for (int j = 0; j < WHEEL_SLOTS; j++) {
+         const wheel_slot_t *s = &(w->levels[i].slots[j]);
+         for (unsigned k = s->head; k < s->count; k++)
+            (*fn)(s->entries[k].key, s->entries[k].user, context);
+      }
+   }
+
+   heap_walk(w->far, fn, context);
+}
+
+bool wheel_delete(wheel_t *w, heap_delete_fn_t fn, void *context)
+{
+   RT_LOCK(w->lock);
+
+   for (int i = 0; i < WHEEL_LEVELS; i++) {
+      wheel_level_t *l = &(w->levels[i]);
+      for (uint64_t bits = l->bitmap; bits != 0; bits &= bits - 1) {
+         const int index = __builtin_ctzll(bits);
+         const wheel_slot_t *s = &(l->slots[index]);
+         for (unsigned k = s->head; k < s->count; k++) {
+            if ((*fn)(s->entries[k].key, s->entries[k].user, context)) {
+               wheel_remove(l, index, k);
+               w->size--;
+               return true;
+            }
+         }
+      }
+   }
+
+   return heap_delete(w->far, fn, context);
+}
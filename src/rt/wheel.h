@@ -0,0 +1,39 @@
+//
+//  Copyright (C) 2026  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _RT_WHEEL_H
+#define _RT_WHEEL_H
+
+#include "rt/heap.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct _wheel wheel_t;
+
+wheel_t *wheel_new(void);
+void wheel_free(wheel_t *w);
+void wheel_insert(wheel_t *w, uint64_t key, void *user);
+void *wheel_extract_min(wheel_t *w);
+void *wheel_min(wheel_t *w);
+uint64_t wheel_min_key(wheel_t *w);
+size_t wheel_size(wheel_t *w);
+void wheel_walk(wheel_t *w, heap_walk_fn_t fn, void *context);
+bool wheel_delete(wheel_t *w, heap_delete_fn_t fn, void *context);
+
+#endif   // _RT_WHEEL_H
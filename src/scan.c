@@ -154,7 +154,7 @@ void input_from_file(const char *file)
       char *buf = xmalloc(bufsz);
       int nbytes;
       do {
-         if (bufsz - 1 - input_buf.file_sz == 0)
+         if (bufsz - 1 - total == 0)
             buf = xrealloc(buf, bufsz *= 2);
 
          nbytes = read(fd, buf + total, bufsz - 1 - total);
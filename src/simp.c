@@ -707,35 +707,6 @@ static void simp_synth_check_cb(tree_t expr, void *ctx)
    tree_add_trigger(proc, expr);   // Suppress further warnings
 }
 
-static void simp_clock_edge_cb(tree_t t, void *ctx)
-{
-   bool *clocked = ctx;
-
-   // Simple heuristic to detect clock expressions
-   switch (tree_kind(t)) {
-   case T_ATTR_REF:
-      if (tree_subkind(t) == ATTR_EVENT)
-         *clocked = true;
-      break;
-
-   case T_FCALL:
-      {
-         switch (is_well_known(tree_ident2(tree_ref(t)))) {
-         case W_IEEE_1164_RISING_EDGE:
-         case W_IEEE_1164_FALLING_EDGE:
-            *clocked = true;
-            break;
-         default:
-            break;
-         }
-      }
-      break;
-
-   default:
-      break;
-   }
-}
-
 static void simp_synth_sensitivity(tree_t proc)
 {
    const int nstmts = tree_stmts(proc);
@@ -749,10 +720,7 @@ static void simp_synth_sensitivity(tree_t proc)
             if (tree_has_value(c)) {
                tree_t value = tree_value(c);
 
-               bool clocked = false;
-               tree_visit(value, simp_clock_edge_cb, &clocked);
-
-               if (clocked)
+               if (has_clock_edge(value))
                   build_wait(value, simp_synth_check_cb, proc);
                else
                   build_wait(c, simp_synth_check_cb, proc);
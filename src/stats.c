@@ -0,0 +1,107 @@
+//
+//  Copyright (C) 2026  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "stats.h"
+#include "thread.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+typedef struct _linked_shard linked_shard_t;
+
+typedef struct _linked_shard {
+   stat_shard_t    shard;
+   linked_shard_t *next;
+} __attribute__((aligned(64))) linked_shard_t;
+
+static const char *counter_names[] = {
+   "time_steps", "delta_cycles", "wakeups", "transactions", "events",
+   "gc_cycles", "gc_us", "heap_bytes", "tier_ups", "code_bytes", "locks",
+   "lock_contended", "lock_wait_ns", "chash_retries", "chash_resize_waits",
+   "assert_failures", "stale_timeouts",
+};
+STATIC_ASSERT(ARRAY_LEN(counter_names) == STAT_NUM_COUNTERS);
+
+static const char *histogram_names[] = {
+   "deltas_per_step", "gc_pause_us", "cgen_latency_us",
+};
+STATIC_ASSERT(ARRAY_LEN(histogram_names) == STAT_NUM_HISTOGRAMS);
+
+__thread stat_shard_t *stat_my_shard = NULL;
+
+static linked_shard_t *all_shards = NULL;
+
+stat_shard_t *stat_new_shard(void)
+{
+   // Shards are never freed so counts from threads that have exited
+   // are still included in later snapshots
+   linked_shard_t *ls = xcalloc(sizeof(linked_shard_t));
+
+   linked_shard_t *head = relaxed_load(&all_shards);
+   do {
+      ls->next = head;
+   } while (!__atomic_cas(&all_shards, &head, ls));
+
+   return (stat_my_shard = &(ls->shard));
+}
+
+void stat_snapshot(stat_shard_t *total)
+{
+   memset(total, '\0', sizeof(stat_shard_t));
+
+   for (linked_shard_t *it = load_acquire(&all_shards); it; it = it->next) {
+      for (int i = 0; i < STAT_NUM_COUNTERS; i++)
+         total->counters[i] += relaxed_load(&(it->shard.counters[i]));
+
+      for (int i = 0; i < STAT_NUM_HISTOGRAMS; i++) {
+         for (int j = 0; j < STAT_BUCKETS; j++)
+            total->buckets[i][j] += relaxed_load(&(it->shard.buckets[i][j]));
+      }
+   }
+}
+
+void stat_json(text_buf_t *tb)
+{
+   stat_shard_t total;
+   stat_snapshot(&total);
+
+   tb_cat(tb, "{\n  \"counters\": {");
+
+   for (int i = 0; i < STAT_NUM_COUNTERS; i++)
+      tb_printf(tb, "%s\n    \"%s\": %"PRIu64, i > 0 ? "," : "",
+                counter_names[i], total.counters[i]);
+
+   tb_cat(tb, "\n  },\n  \"histograms\": {");
+
+   for (int i = 0; i < STAT_NUM_HISTOGRAMS; i++) {
+      // Omit trailing empty buckets
+      int last = STAT_BUCKETS - 1;
+      while (last >= 0 && total.buckets[i][last] == 0)
+         last--;
+
+      tb_printf(tb, "%s\n    \"%s\": [", i > 0 ? "," : "",
+                histogram_names[i]);
+
+      for (int j = 0; j <= last; j++)
+         tb_printf(tb, "%s%"PRIu64, j > 0 ? ", " : "", total.buckets[i][j]);
+
+      tb_cat(tb, "]");
+   }
+
+   tb_cat(tb, "\n  }\n}\n");
+}
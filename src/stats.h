@@ -0,0 +1,96 @@
+//
+//  Copyright (C) 2026  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _STATS_H
+#define _STATS_H
+
+#include "prim.h"
+#include "thread.h"
+
+#include <stdint.h>
+
+typedef enum {
+   STAT_TIME_STEPS,
+   STAT_DELTA_CYCLES,
+   STAT_WAKEUPS,
+   STAT_TRANSACTIONS,
+   STAT_EVENTS,
+   STAT_GC_CYCLES,
+   STAT_GC_US,
+   STAT_HEAP_BYTES,
+   STAT_TIER_UPS,
+   STAT_CODE_BYTES,
+   STAT_LOCKS,
+   STAT_LOCK_CONTENDED,
+   STAT_LOCK_WAIT_NS,
+   STAT_CHASH_RETRIES,
+   STAT_CHASH_RESIZE_WAITS,
+   STAT_ASSERT_FAILURES,
+   STAT_STALE_TIMEOUTS,
+
+   STAT_NUM_COUNTERS
+} stat_counter_t;
+
+typedef enum {
+   STAT_DELTAS_PER_STEP,
+   STAT_GC_PAUSE_US,
+   STAT_CGEN_LATENCY_US,
+
+   STAT_NUM_HISTOGRAMS
+} stat_histogram_t;
+
+// Bucket zero counts samples of zero and bucket N counts samples in the
+// range [2^(N-1), 2^N) with the last bucket also counting larger values
+#define STAT_BUCKETS 32
+
+typedef struct {
+   uint64_t counters[STAT_NUM_COUNTERS];
+   uint64_t buckets[STAT_NUM_HISTOGRAMS][STAT_BUCKETS];
+} stat_shard_t;
+
+stat_shard_t *stat_new_shard(void);
+void stat_snapshot(stat_shard_t *total);
+void stat_json(text_buf_t *tb);
+
+extern __thread stat_shard_t *stat_my_shard;
+
+static inline stat_shard_t *stat_shard(void)
+{
+   if (__builtin_expect(stat_my_shard == NULL, 0))
+      return stat_new_shard();
+   else
+      return stat_my_shard;
+}
+
+// Each shard is only written by its owning thread so the update does
+// not need to be atomic but is still visible to snapshots taken from
+// other threads
+#define stat_shard_add(p, n) relaxed_store((p), relaxed_load(p) + (n))
+
+static inline void stat_add(stat_counter_t which, uint64_t n)
+{
+   stat_shard_add(&(stat_shard()->counters[which]), n);
+}
+
+static inline void stat_sample(stat_histogram_t which, uint64_t value)
+{
+   const int bucket = value == 0 ? 0 : 64 - __builtin_clzll(value);
+   uint64_t *b = stat_shard()->buckets[which];
+   stat_shard_add(&(b[MIN(bucket, STAT_BUCKETS - 1)]), 1);
+}
+
+#endif  // _STATS_H
@@ -19,10 +19,13 @@
 #include "common.h"
 #include "diag.h"
 #include "hash.h"
+#include "jit/jit.h"
 #include "printf.h"
 #include "rt/assert.h"
 #include "rt/model.h"
+#include "rt/mspace.h"
 #include "rt/structs.h"
+#include "stats.h"
 #include "tcl/tcl-priv.h"
 #include "tcl/tcl-shell.h"
 #include "tcl/tcl-structs.h"
@@ -162,9 +165,111 @@ const char *next_option(int *pos, int objc, Tcl_Obj *const objv[])
    return opt;
 }
 
+static void init_signal(tcl_shell_t *sh, shell_signal_t *ss,
+                        rt_signal_t *s, tree_t where, text_buf_t *path)
+{
+   const int base = tb_len(path);
+
+   ss->signal = s;
+   ss->obj.kind = SHELL_SIGNAL;
+   ss->obj.name = ident_downcase(tree_ident(where));
+   ss->owner = sh;
+
+   tb_istr(path, ss->obj.name);
+   ss->obj.path = ident_new(tb_get(path));
+   tb_trim(path, base);
+
+   hash_put(sh->namemap, ss->obj.path, &(ss->obj));
+}
+
+static void expand_region(tcl_shell_t *sh, shell_region_t *r)
+{
+   if (r->expanded)
+      return;
+
+   rt_scope_t *scope = r->scope;
+
+   LOCAL_TEXT_BUF path = tb_new();
+   tb_istr(path, r->obj.path);
+   const int base = tb_len(path);
+
+   r->nsignals = scope->signals.count + scope->aliases.count;
+   r->signals = xcalloc_array(r->nsignals, sizeof(shell_signal_t));
+
+   shell_signal_t *ss = r->signals;
+   for (int i = 0; i < scope->signals.count; i++) {
+      rt_signal_t *s = scope->signals.items[i];
+      init_signal(sh, ss++, s, s->where, path);
+   }
+
+   for (int i = 0; i < scope->aliases.count; i++) {
+      rt_alias_t *a = scope->aliases.items[i];
+      init_signal(sh, ss++, a->signal, a->where, path);
+   }
+
+   r->nchildren = scope->children.count;
+   r->children = xcalloc_array(r->nchildren, sizeof(shell_region_t));
+
+   for (int i = 0; i < scope->children.count; i++) {
+      shell_region_t *c = &(r->children[i]);
+      c->scope = scope->children.items[i];
+      c->obj.kind = SHELL_REGION;
+      c->obj.name = ident_downcase(tree_ident(c->scope->where));
+
+      tb_istr(path, c->obj.name);
+      tb_append(path, '/');
+      c->obj.path = ident_new(tb_get(path));
+      tb_trim(path, base);
+
+      hash_put(sh->namemap, c->obj.path, &(c->obj));
+   }
+
+   r->expanded = true;
+}
+
+static void free_region(shell_region_t *r)
+{
+   for (int i = 0; i < r->nchildren; i++)
+      free_region(&(r->children[i]));
+
+   free(r->signals);
+   free(r->children);
+}
+
+static shell_object_t *find_object(tcl_shell_t *sh, ident_t path)
+{
+   shell_object_t *obj = hash_get(sh->namemap, path);
+   if (obj != NULL)
+      return obj;
+
+   const char *str = istr(path);
+   const size_t len = ident_len(path);
+   if (str[0] != '/')
+      return NULL;
+
+   // Expand each enclosing region along the path in turn
+   shell_region_t *r = sh->top_region;
+   for (;;) {
+      expand_region(sh, r);
+
+      const size_t base = ident_len(r->obj.path);
+      const char *slash = memchr(str + base, '/', len - base);
+      if (slash == NULL || slash == str + len - 1)
+         return hash_get(sh->namemap, path);
+
+      ident_t prefix = ident_new_n(str, slash - str + 1);
+      if ((obj = hash_get(sh->namemap, prefix)) == NULL)
+         return NULL;
+      else if (obj->kind != SHELL_REGION)
+         return NULL;
+
+      r = container_of(obj, shell_region_t, obj);
+   }
+}
+
 static shell_object_t *get_object(tcl_shell_t *sh, const char *name)
 {
-   shell_object_t *obj = hash_get(sh->namemap, ident_new(name));
+   shell_object_t *obj = find_object(sh, ident_new(name));
    if (obj == NULL)
       tcl_error(sh, "cannot find name '%s'", name);
 
@@ -256,6 +361,32 @@ static const char find_help[] =
    "  find signals /uut/x*\tAll signals in instance UUT that start with X\n"
    "  find regions -r *\tList all regions in the design\n";
 
+static void find_in_region(tcl_shell_t *sh, shell_region_t *r,
+                           const char *glob, size_t litlen, bool signals,
+                           Tcl_Obj *result)
+{
+   // Skip the whole subtree if the region path does not agree with the
+   // literal prefix of the pattern before the first wildcard
+   const char *path = istr(r->obj.path);
+   if (strncmp(path, glob, MIN(ident_len(r->obj.path), litlen)) != 0)
+      return;
+
+   if (!signals && ident_glob(r->obj.path, glob, -1))
+      Tcl_ListObjAppendElement(sh->interp, result,
+                               tcl_ident_string(r->obj.path));
+
+   expand_region(sh, r);
+
+   for (int i = 0; signals && i < r->nsignals; i++) {
+      if (ident_glob(r->signals[i].obj.path, glob, -1))
+         Tcl_ListObjAppendElement(sh->interp, result,
+                                  tcl_ident_string(r->signals[i].obj.path));
+   }
+
+   for (int i = 0; i < r->nchildren; i++)
+      find_in_region(sh, &(r->children[i]), glob, litlen, signals, result);
+}
+
 static int shell_cmd_find(ClientData cd, Tcl_Interp *interp,
                           int objc, Tcl_Obj *const objv[])
 {
@@ -282,35 +413,14 @@ static int shell_cmd_find(ClientData cd, Tcl_Interp *interp,
          goto usage;
    }
 
+   if (pos != objc - 1)
+      goto usage;
+
    const char *glob = Tcl_GetString(objv[pos]);
    Tcl_Obj *result = Tcl_NewListObj(0, NULL);
 
-   switch (what) {
-   case SIGNALS:
-      {
-         for (int i = 0; i < sh->nsignals; i++) {
-            if (!ident_glob(sh->signals[i].obj.path, glob, -1))
-               continue;
-
-            Tcl_Obj *obj = tcl_ident_string(sh->signals[i].obj.path);
-            Tcl_ListObjAppendElement(interp, result, obj);
-         }
-      }
-      break;
-
-   case REGIONS:
-      {
-         for (int i = 0; i < sh->nregions; i++) {
-            if (!ident_glob(sh->regions[i].obj.path, glob, -1))
-               continue;
-
-            Tcl_Obj *obj = tcl_ident_string(sh->regions[i].obj.path);
-            Tcl_ListObjAppendElement(interp, result, obj);
-         }
-         break;
-      }
-      break;
-   }
+   find_in_region(sh, sh->top_region, glob, strcspn(glob, "*"),
+                  what == SIGNALS, result);
 
    Tcl_SetObjResult(interp, result);
    return TCL_OK;
@@ -330,10 +440,13 @@ static const char examine_help[] =
    "Options:\n"
    "  -radix <type>\tFormat as hexadecimal, decimal, or binary.\n"
    "  -<radix>\tAlias of \"-radix <radix>\".\n"
+   "  -offset <n>\tSkip the first N elements of array signals.\n"
+   "  -count <n>\tDisplay at most N elements of array signals.\n"
    "\n"
    "Examples:\n"
    "  examine /uut/foo\n"
-   "  exa -hex sig\n";
+   "  exa -hex sig\n"
+   "  exa -offset 1024 -count 64 /uut/mem\n";
 
 static bool parse_radix(const char *str, print_flags_t *flags)
 {
@@ -362,6 +475,7 @@ static int shell_cmd_examine(ClientData cd, Tcl_Interp *interp,
       return TCL_ERROR;
 
    print_flags_t flags = 0;
+   Tcl_WideInt offset = 0, limit = -1;
    int pos = 1;
    for (const char *opt; (opt = next_option(&pos, objc, objv)); ) {
       if (parse_radix(opt + 1, &flags))
@@ -371,6 +485,16 @@ static int shell_cmd_examine(ClientData cd, Tcl_Interp *interp,
          if (!parse_radix(arg, &flags))
             goto usage;
       }
+      else if (strcmp(opt, "-offset") == 0 && pos + 1 < objc) {
+         if (Tcl_GetWideIntFromObj(interp, objv[pos++], &offset) != TCL_OK
+             || offset < 0)
+            return tcl_error(sh, "invalid offset");
+      }
+      else if (strcmp(opt, "-count") == 0 && pos + 1 < objc) {
+         if (Tcl_GetWideIntFromObj(interp, objv[pos++], &limit) != TCL_OK
+             || limit < 0)
+            return tcl_error(sh, "invalid count");
+      }
       else
          goto usage;
    }
@@ -393,7 +517,25 @@ static int shell_cmd_examine(ClientData cd, Tcl_Interp *interp,
       if (!shell_get_printer(sh, ss))
          return TCL_ERROR;
 
-      const char *str = print_signal(ss->printer, ss->signal, flags);
+      const char *str;
+      if (offset > 0 || limit >= 0) {
+         // Only print the requested window of large arrays rather than
+         // formatting the whole value
+         if (!type_is_array(tree_type(ss->signal->where)))
+            return tcl_error(sh, "'%s' is not an array signal", name);
+
+         const size_t size = ss->signal->shared.size;
+         const size_t first = MIN(offset, size);
+         size_t count = size - first;
+         if (limit >= 0)
+            count = MIN(count, limit);
+
+         const uint8_t *data = ss->signal->shared.data + first;
+         str = print_raw(ss->printer, data, count, flags);
+      }
+      else
+         str = print_signal(ss->printer, ss->signal, flags);
+
       result[i] = Tcl_NewStringObj(str, -1);
    }
 
@@ -499,39 +641,9 @@ static const char force_help[] =
    "  force /uut/foo '1'\n"
    "  force /bitvec \"10011\"\n";
 
-static int shell_cmd_force(ClientData cd, Tcl_Interp *interp,
-                           int objc, Tcl_Obj *const objv[])
+static int shell_put_value(tcl_shell_t *sh, const char *signame,
+                           const char *valstr, bool force)
 {
-   tcl_shell_t *sh = cd;
-
-   if (!shell_has_model(sh))
-      return TCL_ERROR;
-   else if (objc != 3 && objc != 1)
-      return syntax_error(sh, objv);
-
-   if (objc == 1) {
-      for (int i = 0; i < sh->nsignals; i++) {
-         shell_signal_t *ss = &(sh->signals[i]);
-         if (!(ss->signal->nexus.flags & NET_F_FORCED))
-            continue;
-
-         if (!shell_get_printer(sh, ss))
-            return TCL_ERROR;
-
-         const size_t nbytes = ss->signal->shared.size;
-         uint8_t *value LOCAL = xmalloc(nbytes);
-         get_forcing_value(ss->signal, value);
-
-         shell_printf(sh, "force %s %s\n", istr(ss->obj.path),
-                      print_raw(ss->printer, value, nbytes, 0));
-      }
-
-      return TCL_OK;
-   }
-
-   const char *signame = Tcl_GetString(objv[1]);
-   const char *valstr = Tcl_GetString(objv[2]);
-
    shell_signal_t *ss = get_signal(sh, signame);
    if (ss == NULL)
       return TCL_ERROR;
@@ -543,8 +655,12 @@ static int shell_cmd_force(ClientData cd, Tcl_Interp *interp,
       return tcl_error(sh, "value '%s' is not valid for type %s",
                        valstr, type_pp(type));
 
-   if (type_is_scalar(type))
-      force_signal(sh->model, ss->signal, &value.integer, 0, 1);
+   const void *data;
+   int count;
+   if (type_is_scalar(type)) {
+      data = &value.integer;
+      count = 1;
+   }
    else if (type_is_character_array(type)) {
       const int width = signal_width(ss->signal);
       if (value.enums->count != width) {
@@ -554,15 +670,101 @@ static int shell_cmd_force(ClientData cd, Tcl_Interp *interp,
          return TCL_ERROR;
       }
 
-      force_signal(sh->model, ss->signal, value.enums->values, 0, width);
-      free(value.enums);
+      data = value.enums->values;
+      count = width;
    }
    else
-      return tcl_error(sh, "cannot force signals of type %s", type_pp(type));
+      return tcl_error(sh, "cannot %s signals of type %s",
+                       force ? "force" : "deposit", type_pp(type));
+
+   if (force)
+      force_signal(sh->model, ss->signal, data, 0, count);
+   else
+      sched_deposit(sh->model, ss->signal, data, 0, count, 0, false);
+
+   if (!type_is_scalar(type))
+      free(value.enums);
 
    return TCL_OK;
 }
 
+static bool print_forced(tcl_shell_t *sh, rt_signal_t *s, tree_t where,
+                         text_buf_t *path)
+{
+   if (!(s->nexus.flags & NET_F_FORCED))
+      return true;
+
+   const int base = tb_len(path);
+   tb_istr(path, ident_downcase(tree_ident(where)));
+   shell_signal_t *ss = get_signal(sh, tb_get(path));
+   tb_trim(path, base);
+
+   if (ss == NULL || !shell_get_printer(sh, ss))
+      return false;
+
+   const size_t nbytes = s->shared.size;
+   uint8_t *value LOCAL = xmalloc(nbytes);
+   get_forcing_value(s, value);
+
+   shell_printf(sh, "force %s %s\n", istr(ss->obj.path),
+                print_raw(ss->printer, value, nbytes, 0));
+   return true;
+}
+
+static bool list_forced(tcl_shell_t *sh, rt_scope_t *scope, text_buf_t *path)
+{
+   // Walk the model scopes directly so listing forces does not create
+   // shell objects for the whole design
+   for (int i = 0; i < scope->signals.count; i++) {
+      rt_signal_t *s = scope->signals.items[i];
+      if (!print_forced(sh, s, s->where, path))
+         return false;
+   }
+
+   for (int i = 0; i < scope->aliases.count; i++) {
+      rt_alias_t *a = scope->aliases.items[i];
+      if (!print_forced(sh, a->signal, a->where, path))
+         return false;
+   }
+
+   const int base = tb_len(path);
+   for (int i = 0; i < scope->children.count; i++) {
+      rt_scope_t *child = scope->children.items[i];
+      tb_istr(path, ident_downcase(tree_ident(child->where)));
+      tb_append(path, '/');
+
+      const bool ok = list_forced(sh, child, path);
+      tb_trim(path, base);
+
+      if (!ok)
+         return false;
+   }
+
+   return true;
+}
+
+static int shell_cmd_force(ClientData cd, Tcl_Interp *interp,
+                           int objc, Tcl_Obj *const objv[])
+{
+   tcl_shell_t *sh = cd;
+
+   if (!shell_has_model(sh))
+      return TCL_ERROR;
+   else if (objc != 3 && objc != 1)
+      return syntax_error(sh, objv);
+
+   if (objc == 1) {
+      LOCAL_TEXT_BUF path = tb_new();
+      tb_cat(path, "/");
+      return list_forced(sh, sh->root, path) ? TCL_OK : TCL_ERROR;
+   }
+
+   const char *signame = Tcl_GetString(objv[1]);
+   const char *valstr = Tcl_GetString(objv[2]);
+
+   return shell_put_value(sh, signame, valstr, true);
+}
+
 static const char noforce_help[] =
    "Stop forcing the value of signals\n"
    "\n"
@@ -575,6 +777,24 @@ static const char noforce_help[] =
    "Examples:\n"
    "  noforce /uut/foo /baz\n";
 
+static void release_all(tcl_shell_t *sh, rt_scope_t *scope)
+{
+   for (int i = 0; i < scope->signals.count; i++) {
+      rt_signal_t *s = scope->signals.items[i];
+      if (s->nexus.flags & NET_F_FORCED)
+         release_signal(sh->model, s, 0, signal_width(s));
+   }
+
+   for (int i = 0; i < scope->aliases.count; i++) {
+      rt_signal_t *s = scope->aliases.items[i]->signal;
+      if (s->nexus.flags & NET_F_FORCED)
+         release_signal(sh->model, s, 0, signal_width(s));
+   }
+
+   for (int i = 0; i < scope->children.count; i++)
+      release_all(sh, scope->children.items[i]);
+}
+
 static int shell_cmd_noforce(ClientData cd, Tcl_Interp *interp,
                              int objc, Tcl_Obj *const objv[])
 {
@@ -587,14 +807,8 @@ static int shell_cmd_noforce(ClientData cd, Tcl_Interp *interp,
 
    for (int i = 1; i < objc; i++) {
       const char *signame = Tcl_GetString(objv[i]);
-      if (strcmp(signame, "*") == 0) {
-         for (int i = 0; i < sh->nsignals; i++) {
-            shell_signal_t *ss = &(sh->signals[i]);
-            if (ss->signal->nexus.flags & NET_F_FORCED)
-               release_signal(sh->model, ss->signal, 0,
-                              signal_width(ss->signal));
-         }
-      }
+      if (strcmp(signame, "*") == 0)
+         release_all(sh, sh->root);
       else {
          shell_signal_t *ss = get_signal(sh, signame);
          if (ss == NULL)
@@ -610,6 +824,122 @@ static int shell_cmd_noforce(ClientData cd, Tcl_Interp *interp,
    return TCL_OK;
 }
 
+static const char deposit_help[] =
+   "Deposit a value on a signal\n"
+   "\n"
+   "Syntax:\n"
+   "  deposit <signal> <value>\n"
+   "  deposit -file <file> <signal>\n"
+   "\n"
+   "Sets the value of a signal until it is next updated by one of its "
+   "drivers. The value has the same format as for $bold$force$$. With "
+   "$bold$-file$$ the elements of an array signal such as a memory are "
+   "loaded from a file containing one bit string literal per element "
+   "separated by whitespace, where // starts a comment. Elements not "
+   "listed in the file keep their current value. The whole image is "
+   "deposited with a single update.\n"
+   "\n"
+   "Examples:\n"
+   "  deposit /uut/foo '1'\n"
+   "  deposit -file ram.txt /uut/mem\n";
+
+static int shell_deposit_file(tcl_shell_t *sh, const char *fname,
+                              const char *signame)
+{
+   shell_signal_t *ss = get_signal(sh, signame);
+   if (ss == NULL)
+      return TCL_ERROR;
+
+   type_t type = tree_type(ss->signal->where), elem = NULL;
+   if (type_is_array(type))
+      elem = type_elem(type);
+
+   int64_t elemwidth;
+   if (elem == NULL || !type_is_character_array(elem)
+       || type_is_unconstrained(elem)
+       || !folded_length(range_of(elem, 0), &elemwidth)
+       || ss->signal->nexus.size != 1)
+      return tcl_error(sh, "cannot load signal %s of type %s from a file",
+                       signame, type_pp(type));
+
+   FILE *f = fopen(fname, "r");
+   if (f == NULL)
+      return tcl_error(sh, "cannot open %s: %s", fname, last_os_error());
+
+   const int width = signal_width(ss->signal);
+   uint8_t *buf LOCAL = xmalloc(width);
+
+   int count = 0, lineno = 0, status = TCL_OK;
+   char *line LOCAL = NULL;
+   size_t linesz = 0;
+   while (status == TCL_OK && getline(&line, &linesz, f) != -1) {
+      lineno++;
+
+      char *comment = strstr(line, "//");
+      if (comment != NULL)
+         *comment = '\0';
+
+      for (char *tok = strtok(line, " \t\r\n"); tok != NULL;
+           tok = strtok(NULL, " \t\r\n")) {
+         parsed_value_t value;
+         if (count + elemwidth > width) {
+            status = tcl_error(sh, "%s:%d: too many elements for signal %s",
+                               fname, lineno, signame);
+            break;
+         }
+         else if (!parse_value(elem, tok, &value)) {
+            status = tcl_error(sh, "%s:%d: value '%s' is not valid for "
+                               "type %s", fname, lineno, tok, type_pp(elem));
+            break;
+         }
+         else if (value.enums->count != elemwidth) {
+            status = tcl_error(sh, "%s:%d: expected %"PRIi64" bits but "
+                               "have %d", fname, lineno, elemwidth,
+                               value.enums->count);
+            free(value.enums);
+            break;
+         }
+
+         memcpy(buf + count, value.enums->values, elemwidth);
+         count += elemwidth;
+         free(value.enums);
+      }
+   }
+
+   fclose(f);
+
+   if (status == TCL_OK && count > 0)
+      sched_deposit(sh->model, ss->signal, buf, 0, count, 0, false);
+
+   return status;
+}
+
+static int shell_cmd_deposit(ClientData cd, Tcl_Interp *interp,
+                             int objc, Tcl_Obj *const objv[])
+{
+   tcl_shell_t *sh = cd;
+
+   if (!shell_has_model(sh))
+      return TCL_ERROR;
+
+   const char *fname = NULL;
+   int pos = 1;
+   for (const char *opt; (opt = next_option(&pos, objc, objv)); ) {
+      if (strcmp(opt, "-file") == 0 && pos < objc)
+         fname = Tcl_GetString(objv[pos++]);
+      else
+         return syntax_error(sh, objv);
+   }
+
+   if (fname != NULL && pos + 1 == objc)
+      return shell_deposit_file(sh, fname, Tcl_GetString(objv[pos]));
+   else if (fname == NULL && pos + 2 == objc)
+      return shell_put_value(sh, Tcl_GetString(objv[pos]),
+                             Tcl_GetString(objv[pos + 1]), false);
+   else
+      return syntax_error(sh, objv);
+}
+
 static const char exit_help[] =
    "Exit the simulator and return a status code\n"
    "\n"
@@ -717,6 +1047,114 @@ static int shell_cmd_echo(ClientData cd, Tcl_Interp *interp,
    return TCL_OK;
 }
 
+static const char stats_help[] =
+   "Return simulation statistics as a JSON object\n"
+   "\n"
+   "Syntax:\n"
+   "  stats\n"
+   "  stats runtime\n"
+   "\n"
+   "The result contains counters such as the number of time steps, delta\n"
+   "cycles, and process wakeups since the simulator started, and\n"
+   "histograms such as the number of delta cycles in each time step.\n"
+   "\n"
+   "With the runtime argument the result is instead a dictionary\n"
+   "describing the current state of the simulation: the event queue\n"
+   "size, number of pending waveforms, heap usage, and the number of\n"
+   "functions in each JIT tier.\n";
+
+static int shell_stats_runtime(tcl_shell_t *sh)
+{
+   if (!shell_has_model(sh))
+      return TCL_ERROR;
+
+   model_stats_t ms;
+   model_get_stats(sh->model, &ms);
+
+   size_t heap_live, heap_max;
+   mspace_get_usage(jit_get_mspace(sh->jit), &heap_live, &heap_max);
+
+   jit_tier_stats_t js;
+   jit_get_tier_stats(sh->jit, &js);
+
+   Tcl_Obj *d = Tcl_NewDictObj();
+   tcl_dict_put(sh, d, "now", Tcl_NewWideIntObj(ms.now));
+   tcl_dict_put(sh, d, "deltas", Tcl_NewIntObj(ms.deltas));
+   tcl_dict_put(sh, d, "events", Tcl_NewWideIntObj(ms.event_queue));
+   tcl_dict_put(sh, d, "waveforms", Tcl_NewWideIntObj(ms.waveforms));
+   tcl_dict_put(sh, d, "heap_live", Tcl_NewWideIntObj(heap_live));
+   tcl_dict_put(sh, d, "heap_size", Tcl_NewWideIntObj(heap_max));
+   tcl_dict_put(sh, d, "jit_functions", Tcl_NewIntObj(js.functions));
+   tcl_dict_put(sh, d, "jit_interpreted", Tcl_NewIntObj(js.interpreted));
+   tcl_dict_put(sh, d, "jit_compiled", Tcl_NewIntObj(js.compiled));
+   tcl_dict_put(sh, d, "jit_pending", Tcl_NewIntObj(js.pending));
+
+   Tcl_SetObjResult(sh->interp, d);
+   return TCL_OK;
+}
+
+static int shell_cmd_stats(ClientData cd, Tcl_Interp *interp,
+                           int objc, Tcl_Obj *const objv[])
+{
+   tcl_shell_t *sh = cd;
+
+   if (objc == 2 && strcmp(Tcl_GetString(objv[1]), "runtime") == 0)
+      return shell_stats_runtime(sh);
+   else if (objc != 1)
+      return syntax_error(sh, objv);
+
+   LOCAL_TEXT_BUF tb = tb_new();
+   stat_json(tb);
+
+   Tcl_SetObjResult(interp, Tcl_NewStringObj(tb_get(tb), tb_len(tb)));
+   return TCL_OK;
+}
+
+static const char profile_help[] =
+   "Collect a profile of process and signal activity\n"
+   "\n"
+   "Syntax:\n"
+   "  profile start\n"
+   "  profile stop\n"
+   "  profile report\n"
+   "\n"
+   "The start subcommand discards any existing profile and begins\n"
+   "recording the time spent in each process and the number of wakeups\n"
+   "for each process and signal.  Recording continues over subsequent\n"
+   "run commands until profile stop.  The report subcommand prints a\n"
+   "summary of the current or most recently stopped profile.\n"
+   "\n"
+   "Examples:\n"
+   "  profile start; run 1 ms; profile report\n";
+
+static int shell_cmd_profile(ClientData cd, Tcl_Interp *interp,
+                             int objc, Tcl_Obj *const objv[])
+{
+   tcl_shell_t *sh = cd;
+
+   if (!shell_has_model(sh))
+      return TCL_ERROR;
+   else if (objc != 2)
+      return syntax_error(sh, objv);
+
+   const char *what = Tcl_GetString(objv[1]);
+   if (strcmp(what, "start") == 0)
+      model_profile_start(sh->model);
+   else if (strcmp(what, "stop") == 0) {
+      if (!model_profile_stop(sh->model))
+         return tcl_error(sh, "profiling is not active");
+   }
+   else if (strcmp(what, "report") == 0) {
+      if (!model_profile_report(sh->model))
+         return tcl_error(sh, "no profile has been collected, use "
+                          "$bold$profile start$$ first");
+   }
+   else
+      return syntax_error(sh, objv);
+
+   return TCL_OK;
+}
+
 static char *shell_list_generator(const char *script, const char *text,
                                   int state, int prefix)
 {
@@ -899,8 +1337,11 @@ tcl_shell_t *shell_new(tree_t top, jit_t *jit, rt_model_t *m)
    shell_add_cmd(sh, "exa", shell_cmd_examine, examine_help);
    shell_add_cmd(sh, "force", shell_cmd_force, force_help);
    shell_add_cmd(sh, "noforce", shell_cmd_noforce, noforce_help);
+   shell_add_cmd(sh, "deposit", shell_cmd_deposit, deposit_help);
    shell_add_cmd(sh, "echo", shell_cmd_echo, echo_help);
    shell_add_cmd(sh, "describe", shell_cmd_describe, describe_help);
+   shell_add_cmd(sh, "stats", shell_cmd_stats, stats_help);
+   shell_add_cmd(sh, "profile", shell_cmd_profile, profile_help);
 
    shell_add_vhpi_cmds(sh);
 
@@ -911,12 +1352,17 @@ tcl_shell_t *shell_new(tree_t top, jit_t *jit, rt_model_t *m)
 
 void shell_free(tcl_shell_t *sh)
 {
-   hash_free(sh->namemap);
+   if (sh->top_region != NULL) {
+      free_region(sh->top_region);
+      free(sh->top_region);
+   }
+
+   if (sh->namemap != NULL)
+      hash_free(sh->namemap);
+
    printer_free(sh->printer);
    Tcl_DeleteInterp(sh->interp);
 
-   free(sh->signals);
-   free(sh->regions);
    free(sh->datadir);
    free(sh->prompt);
    free(sh->cmds);
@@ -949,92 +1395,31 @@ bool shell_eval(tcl_shell_t *sh, const char *script, const char **result)
    }
 }
 
-static void count_objects(rt_scope_t *scope, unsigned *nsignals,
-                          unsigned *nregions)
-{
-   *nsignals += scope->signals.count + scope->aliases.count;
-   *nregions += 1;
-
-   for (int i = 0; i < scope->children.count;i ++)
-      count_objects(scope->children.items[i], nsignals, nregions);
-}
-
-static void recurse_objects(tcl_shell_t *sh, rt_scope_t *scope,
-                            text_buf_t *path, shell_signal_t **sptr,
-                            shell_region_t **rptr)
+void shell_reset(tcl_shell_t *sh)
 {
-   const int base = tb_len(path);
-
-   shell_region_t *r = (*rptr)++;
-   r->scope = scope;
-   r->obj.kind = SHELL_REGION;
-   r->obj.name = ident_downcase(tree_ident(scope->where));
-   r->obj.path = ident_new(tb_get(path));
-
-   hash_put(sh->namemap, r->obj.path, &(r->obj));
-
-   for (int i = 0; i < scope->signals.count; i++) {
-      shell_signal_t *ss = (*sptr)++;
-      ss->signal = scope->signals.items[i];
-      ss->obj.kind = SHELL_SIGNAL;
-      ss->obj.name = ident_downcase(tree_ident(ss->signal->where));
-      ss->owner = sh;
-
-      tb_istr(path, ss->obj.name);
-      ss->obj.path = ident_new(tb_get(path));
-      tb_trim(path, base);
-
-      hash_put(sh->namemap, ss->obj.path, &(ss->obj));
-   }
-
-   for (int i = 0; i < scope->aliases.count; i++) {
-      rt_alias_t *a = scope->aliases.items[i];
-
-      shell_signal_t *ss = (*sptr)++;
-      ss->signal = a->signal;
-      ss->obj.kind = SHELL_SIGNAL;
-      ss->obj.name = ident_downcase(tree_ident(a->where));
-      ss->owner = sh;
+   model_reset(sh->model);
 
-      tb_istr(path, ss->obj.name);
-      ss->obj.path = ident_new(tb_get(path));
-      tb_trim(path, base);
+   if ((sh->root = find_scope(sh->model, tree_stmt(sh->top, 0))) == NULL)
+      fatal_trace("cannot find root scope");
 
-      hash_put(sh->namemap, ss->obj.path, &(ss->obj));
+   if (sh->top_region != NULL) {
+      free_region(sh->top_region);
+      free(sh->top_region);
    }
 
-   for (int i = 0; i < scope->children.count; i++) {
-      rt_scope_t *child = scope->children.items[i];
-      ident_t name = ident_downcase(tree_ident(child->where));
-      tb_istr(path, name);
-      tb_append(path, '/');
-      recurse_objects(sh, child, path, sptr, rptr);
-      tb_trim(path, base);
-   }
-}
+   if (sh->namemap != NULL)
+      hash_free(sh->namemap);
 
-void shell_reset(tcl_shell_t *sh)
-{
-   model_reset(sh->model);
+   // Shell objects are created lazily as regions are expanded
+   sh->namemap = hash_new(128);
 
-   if ((sh->root = find_scope(sh->model, tree_stmt(sh->top, 0))) == NULL)
-      fatal_trace("cannot find root scope");
+   shell_region_t *r = sh->top_region = xcalloc(sizeof(shell_region_t));
+   r->scope = sh->root;
+   r->obj.kind = SHELL_REGION;
+   r->obj.name = ident_downcase(tree_ident(sh->root->where));
+   r->obj.path = ident_new("/");
 
-   sh->nsignals = sh->nregions = 0;
-   count_objects(sh->root, &sh->nsignals, &sh->nregions);
-
-   sh->signals = xcalloc_array(sh->nsignals, sizeof(shell_signal_t));
-   sh->regions = xcalloc_array(sh->nregions, sizeof(shell_region_t));
-   sh->namemap = hash_new(1 + sh->nsignals * 2);
-
-   text_buf_t *path = tb_new();
-   shell_signal_t *sptr = sh->signals;
-   shell_region_t *rptr = sh->regions;
-   tb_cat(path, "/");
-   recurse_objects(sh, sh->root, path, &sptr, &rptr);
-   assert(sptr == sh->signals + sh->nsignals);
-   assert(rptr == sh->regions + sh->nregions);
-   tb_free(path);
+   hash_put(sh->namemap, r->obj.path, &(r->obj));
 
    shell_update_now(sh);
 }
@@ -47,9 +47,18 @@ typedef struct {
    tcl_shell_t    *owner;
 } shell_signal_t;
 
-typedef struct {
+typedef struct _shell_region shell_region_t;
+
+// Signals and child regions are only created when a region is first
+// expanded by a name lookup or search
+typedef struct _shell_region {
    shell_object_t  obj;
    rt_scope_t     *scope;
+   shell_signal_t *signals;
+   unsigned        nsignals;
+   shell_region_t *children;
+   unsigned        nchildren;
+   bool            expanded;
 } shell_region_t;
 
 typedef char *(*get_line_fn_t)(tcl_shell_t *);
@@ -63,10 +72,7 @@ typedef struct _tcl_shell {
    rt_model_t      *model;
    tree_t           top;
    rt_scope_t      *root;
-   shell_signal_t  *signals;
-   unsigned         nsignals;
-   shell_region_t  *regions;
-   unsigned         nregions;
+   shell_region_t  *top_region;
    hash_t          *namemap;
    jit_t           *jit;
    int64_t          now_var;
@@ -18,7 +18,9 @@
 #include "util.h"
 #include "array.h"
 #include "cpustate.h"
+#include "debug.h"
 #include "rt/mspace.h"
+#include "stats.h"
 #include "thread.h"
 
 #include <assert.h>
@@ -44,6 +46,8 @@
 #if defined __MINGW32__
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#elif defined __linux__
+#include <sched.h>
 #elif defined __APPLE__
 #define task_t __task_t
 #include <mach/thread_act.h>
@@ -52,6 +56,8 @@
 #endif
 
 #define LOCK_SPINS      64
+#define LOCK_SITES      256
+#define LOCK_SITES_TOP  20
 #define YIELD_SPINS     32
 #define MIN_TAKE        8
 #define PARKING_BAYS    64
@@ -64,6 +70,10 @@
 #define SIGRESUME     (SIGRTMIN + 1)
 #endif
 
+#if defined POSIX_SUSPEND && !ASAN_ENABLED
+#define IDLE_SAFEPOINT 1   // Sleeping workers need not be signalled
+#endif
+
 typedef struct {
    int64_t locks;
    int64_t spins;
@@ -75,6 +85,13 @@ typedef struct {
 
 STATIC_ASSERT(sizeof(lock_stats_t) == 64)
 
+typedef struct {
+   nvc_lock_t *lock;
+   void       *caller;
+   uint64_t    contended;
+   uint64_t    wait_ns;
+} lock_site_t;
+
 #ifdef DEBUG
 #define LOCK_EVENT(what, n) do {                  \
       if (likely(my_thread != NULL))              \
@@ -235,6 +252,10 @@ struct _nvc_thread {
 #ifdef __APPLE__
    thread_port_t   port;
 #endif
+#ifdef POSIX_SUSPEND
+   bool             idle;      // Protected by wakelock
+   struct cpu_state idlecpu;
+#endif
 };
 
 typedef struct {
@@ -262,10 +283,17 @@ static parking_bay_t parking_bays[PARKING_BAYS] = {
 
 static nvc_thread_t    *threads[MAX_THREADS];
 static unsigned         max_workers = 0;
+static int              max_background = 1;
+static int              background_running __attribute__((aligned(64))) = 0;
+#ifdef __linux__
+static bool             pin_workers = false;
+static cpu_set_t        worker_cpus;
+#endif
 static int              running_threads = 0;
 static unsigned         max_thread_id = 0;
 static bool             should_stop = false;
 static globalq_t        globalq __attribute__((aligned(64)));
+static globalq_t        backgroundq __attribute__((aligned(64)));
 static int              async_pending __attribute__((aligned(64))) = 0;
 static nvc_lock_t       stop_lock = 0;
 static stop_world_fn_t  stop_callback = NULL;
@@ -280,7 +308,9 @@ static pthread_mutex_t    wakelock = PTHREAD_ADAPTIVE_MUTEX_INITIALIZER_NP;
 #endif
 
 #ifdef POSIX_SUSPEND
-static sem_t stop_sem;
+static sem_t            stop_sem;
+static stop_assist_fn_t assist_fn = NULL;
+static void            *assist_arg = NULL;
 #endif
 
 #ifdef DEBUG
@@ -288,6 +318,11 @@ static lock_stats_t  lock_stats[MAX_THREADS];
 static workq_stats_t workq_stats[MAX_THREADS];
 #endif
 
+static bool        lock_profile = false;
+static int         lock_sites_lock = 0;
+static lock_site_t lock_sites[LOCK_SITES];
+static unsigned    lock_sites_lost = 0;
+
 static __thread nvc_thread_t *my_thread = NULL;
 
 static parking_bay_t *parking_bay_for(void *cookie);
@@ -330,6 +365,64 @@ static void print_lock_stats(void)
 }
 #endif
 
+static int lock_site_cmp(const void *a, const void *b)
+{
+   const lock_site_t *la = a, *lb = b;
+   return la->wait_ns < lb->wait_ns ? 1 : (la->wait_ns > lb->wait_ns ? -1 : 0);
+}
+
+static void print_lock_profile(void)
+{
+   stat_shard_t total;
+   stat_snapshot(&total);
+
+   const uint64_t locks = total.counters[STAT_LOCKS];
+   const uint64_t contended = total.counters[STAT_LOCK_CONTENDED];
+
+   printf("\nLock contention: %"PRIu64" of %"PRIu64" acquisitions "
+          "contended (%.2f%%); %"PRIu64" us waiting\n", contended, locks,
+          locks ? 100.0 * contended / locks : 0.0,
+          total.counters[STAT_LOCK_WAIT_NS] / 1000);
+   printf("Concurrent hash: %"PRIu64" retries; %"PRIu64" resize waits\n",
+          total.counters[STAT_CHASH_RETRIES],
+          total.counters[STAT_CHASH_RESIZE_WAITS]);
+
+   while (!atomic_cas(&lock_sites_lock, 0, 1))
+      spin_wait();
+
+   lock_site_t *sorted LOCAL = xmalloc_array(LOCK_SITES, sizeof(lock_site_t));
+   int count = 0;
+   for (int i = 0; i < LOCK_SITES; i++) {
+      if (lock_sites[i].lock != NULL)
+         sorted[count++] = lock_sites[i];
+   }
+
+   store_release(&lock_sites_lock, 0);
+
+   if (count == 0)
+      return;
+
+   qsort(sorted, count, sizeof(lock_site_t), lock_site_cmp);
+
+   printf("\n   %12s %12s  %-18s  %s\n", "Contended", "Wait (us)", "Lock",
+          "Call site");
+
+   for (int i = 0; i < count && i < LOCK_SITES_TOP; i++) {
+      printf("   %12"PRIu64" %12"PRIu64"  %-18p  ", sorted[i].contended,
+             sorted[i].wait_ns / 1000, sorted[i].lock);
+
+      const char *sym = debug_symbol_name(sorted[i].caller);
+      if (sym != NULL)
+         printf("%s\n", sym);
+      else
+         printf("%p\n", sorted[i].caller);
+   }
+
+   if (lock_sites_lost > 0)
+      printf("   (%u contended acquisitions not attributed to a site)\n",
+             lock_sites_lost);
+}
+
 #ifdef __MINGW32__
 static inline void platform_mutex_lock(LPCRITICAL_SECTION lpcs)
 {
@@ -524,11 +617,31 @@ void thread_init(void)
 
    assert(max_workers > 0);
 
+   // Leave some workers free for simulation tasks when there is a burst
+   // of background work such as JIT compilation
+   const char *bg_env = getenv("NVC_BACKGROUND_THREADS");
+   if (bg_env != NULL)
+      max_background = MAX(1, MIN(atoi(bg_env), max_workers));
+   else
+      max_background = MAX(1, max_workers / 2);
+
+#ifdef __linux__
+   // Pinning worker threads keeps the memory they first touch, such as
+   // their thread-local allocation buffers, on the local NUMA node
+   if (getenv("NVC_PIN_THREADS") != NULL)
+      pin_workers = sched_getaffinity(0, sizeof(cpu_set_t), &worker_cpus) == 0;
+#endif
+
 #ifdef DEBUG
    if (getenv("NVC_THREAD_VERBOSE") != NULL)
       atexit(print_lock_stats);
 #endif
 
+   if (getenv("NVC_LOCK_PROFILE") != NULL) {
+      lock_profile = true;
+      atexit(print_lock_profile);
+   }
+
    atexit(join_worker_threads);
 
 #ifdef POSIX_SUSPEND
@@ -698,6 +811,39 @@ static void thread_unpark(void *cookie, unpark_fn_t fn)
    platform_cond_broadcast(&(bay->cond));
 }
 
+static void wait_unpark_cb(parking_bay_t *bay, void *cookie)
+{
+   // Acquiring the park mutex is enough to synchronise with waiters
+}
+
+void thread_wait(int *word, int value)
+{
+   // Block the calling thread while *WORD is equal to VALUE: the value
+   // is checked again with the park mutex held so a concurrent
+   // thread_wake either happens before the check or after this thread
+   // is waiting
+   while (load_acquire(word) == value) {
+      parking_bay_t *bay = parking_bay_for(word);
+
+      platform_mutex_lock(&(bay->mutex));
+      {
+         if (relaxed_load(word) == value) {
+            bay->parked++;
+            platform_cond_wait(&(bay->cond), &(bay->mutex));
+            assert(bay->parked > 0);
+            bay->parked--;
+         }
+      }
+      platform_mutex_unlock(&(bay->mutex));
+   }
+}
+
+void thread_wake(int *word)
+{
+   // Wake all threads blocked in thread_wait on WORD after changing it
+   thread_unpark(word, wait_unpark_cb);
+}
+
 void spin_wait(void)
 {
 #if defined ARCH_X86_64
@@ -709,6 +855,43 @@ void spin_wait(void)
 #endif
 }
 
+__attribute__((noinline))
+static void lock_profile_wait(nvc_lock_t *lock, void *caller,
+                              uint64_t start_ns)
+{
+   const uint64_t wait_ns = get_timestamp_ns() - start_ns;
+
+   stat_add(STAT_LOCK_CONTENDED, 1);
+   stat_add(STAT_LOCK_WAIT_NS, wait_ns);
+
+   // Cannot use nvc_lock here so protect the table with a spin lock
+   // which is only ever taken on the contended path
+   while (!atomic_cas(&lock_sites_lock, 0, 1))
+      spin_wait();
+
+   const uintptr_t hash = mix_bits_64((uintptr_t)lock ^ (uintptr_t)caller);
+
+   for (int i = 0, n = hash % LOCK_SITES; i < LOCK_SITES;
+        i++, n = (n + 1) % LOCK_SITES) {
+      lock_site_t *s = &(lock_sites[n]);
+      if (s->lock == NULL) {
+         s->lock = lock;
+         s->caller = caller;
+      }
+      else if (s->lock != lock || s->caller != caller)
+         continue;
+
+      s->contended++;
+      s->wait_ns += wait_ns;
+      goto done;
+   }
+
+   lock_sites_lost++;
+
+ done:
+   store_release(&lock_sites_lock, 0);
+}
+
 static bool lock_park_cb(parking_bay_t *bay, void *cookie)
 {
    nvc_lock_t *lock = cookie;
@@ -733,12 +916,17 @@ void nvc_lock(nvc_lock_t *lock)
    LOCK_EVENT(locks, 1);
    TSAN_PRE_LOCK(lock);
 
+   if (unlikely(lock_profile))
+      stat_add(STAT_LOCKS, 1);
+
    int8_t state = 0;
    if (likely(__atomic_cas(lock, &state, state | IS_LOCKED)))
       goto locked;  // Fast path: acquired the lock without contention
 
    LOCK_EVENT(contended, 1);
 
+   const uint64_t start_ns = lock_profile ? get_timestamp_ns() : 0;
+
    for (;;) {
       LOCK_EVENT(retries, 1);
 
@@ -771,9 +959,12 @@ void nvc_lock(nvc_lock_t *lock)
       // If we get here then we've seen the lock in an unowned state:
       // attempt to grab it with a CAS
       if (__atomic_cas(lock, &state, state | IS_LOCKED))
-         goto locked;
+         break;
    }
 
+   if (unlikely(lock_profile))
+      lock_profile_wait(lock, __builtin_return_address(0), start_ns);
+
  locked:
    TSAN_POST_LOCK(lock);
 }
@@ -946,6 +1137,38 @@ static bool globalq_poll(globalq_t *gq, threadq_t *tq)
       return false;
 }
 
+static bool backgroundq_poll(globalq_t *gq, bool limit)
+{
+   // Background tasks are taken one at a time and never placed on the
+   // thread's deque so they cannot be stolen past the concurrency limit
+   if (globalq_unlocked_empty(gq))
+      return false;
+
+   if (atomic_add(&background_running, 1) > max_background && limit) {
+      atomic_add(&background_running, -1);
+      return false;
+   }
+
+   task_t task;
+   bool found = false;
+   {
+      SCOPED_LOCK(gq->lock);
+
+      if (gq->wptr != gq->rptr) {
+         task = gq->tasks[gq->rptr++];
+         found = true;
+      }
+   }
+
+   if (found) {
+      execute_task(&task);
+      WORKQ_EVENT(comp, 1);
+   }
+
+   atomic_add(&background_running, -1);
+   return found;
+}
+
 workq_t *workq_new(void *context)
 {
    if (my_thread->kind != MAIN_THREAD)
@@ -1097,20 +1320,63 @@ static void progressive_backoff(void)
    }
 }
 
+#ifdef __linux__
+static void pin_worker_thread(void)
+{
+   // Assign workers to the allowed CPUs in order skipping the first
+   // which is usually where the main thread runs
+   const int ncpus = CPU_COUNT(&worker_cpus);
+   if (ncpus < 2)
+      return;
+
+   const int nth = my_thread->id % ncpus;
+   for (int cpu = 0, pos = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (!CPU_ISSET(cpu, &worker_cpus))
+         continue;
+      else if (pos++ == nth) {
+         cpu_set_t set;
+         CPU_ZERO(&set);
+         CPU_SET(cpu, &set);
+
+         // Failure is harmless as the thread just floats as before
+         (void)sched_setaffinity(0, sizeof(cpu_set_t), &set);
+         return;
+      }
+   }
+}
+#endif
+
 static void *worker_thread(void *arg)
 {
    mspace_stack_limit(MSPACE_CURRENT_FRAME);
 
+#ifdef __linux__
+   if (pin_workers)
+      pin_worker_thread();
+#endif
+
    do {
-      if (globalq_poll(&globalq, &(my_thread->queue)) || steal_task())
+      // Simulation tasks have strict priority over background tasks
+      if (globalq_poll(&globalq, &(my_thread->queue)) || steal_task()
+          || backgroundq_poll(&backgroundq, true))
          my_thread->spins = 0;  // Did work
       else if (my_thread->spins++ < 2)
          spin_wait();
       else {
          platform_mutex_lock(&wakelock);
          {
-            if (!relaxed_load(&should_stop))
+            if (!relaxed_load(&should_stop)) {
+#ifdef IDLE_SAFEPOINT
+               // A sleeping worker is at a safepoint: stop_world uses
+               // the registers saved here rather than signalling it
+               capture_registers(&(my_thread->idlecpu));
+               my_thread->idle = true;
+#endif
                platform_cond_wait(&wake_workers, &wakelock);
+#ifdef IDLE_SAFEPOINT
+               my_thread->idle = false;
+#endif
+            }
          }
          platform_mutex_unlock(&wakelock);
       }
@@ -1246,15 +1512,15 @@ void async_do(task_fn_t fn, void *context, void *arg)
       task_t tasks[1] = {
          { fn, context, arg, NULL }
       };
-      SCOPED_LOCK(globalq.lock);
-      globalq_put(&globalq, tasks, 1);
+      SCOPED_LOCK(backgroundq.lock);
+      globalq_put(&backgroundq, tasks, 1);
    }
 }
 
 void async_barrier(void)
 {
    while (atomic_load(&async_pending) > 0) {
-      if (!globalq_poll(&globalq, &(my_thread->queue)))
+      if (!backgroundq_poll(&backgroundq, false))
          progressive_backoff();
    }
 }
@@ -1294,7 +1560,19 @@ static void suspend_handler(int sig, siginfo_t *info, void *context)
    unmask_fatal_signals(&mask);
    sigdelset(&mask, SIGRESUME);
 
-   sigsuspend(&mask);
+   for (;;) {
+      sigsuspend(&mask);
+
+      // The thread that stopped the world may ask suspended threads to
+      // help with some work before it finally resumes them
+      stop_assist_fn_t fn = atomic_load(&assist_fn);
+      if (fn == NULL)
+         break;
+
+      (*fn)(atomic_load(&assist_arg));
+
+      sem_post(&stop_sem);
+   }
 
    sem_post(&stop_sem);
 
@@ -1377,12 +1655,20 @@ void stop_world(stop_world_fn_t callback, void *arg)
 #else
    assert(sem_trywait(&stop_sem) == -1 && errno == EAGAIN);
 
+   // Sleeping workers cannot return from the condition variable wait
+   // until start_world releases the lock
+   platform_mutex_lock(&wakelock);
+
    int signalled = 0;
    const int maxthread = relaxed_load(&max_thread_id);
    for (int i = 0; i <= maxthread; i++) {
       nvc_thread_t *thread = atomic_load(&threads[i]);
       if (thread == NULL || thread == my_thread)
          continue;
+      else if (thread->idle) {
+         (*callback)(thread->id, &(thread->idlecpu), arg);
+         continue;
+      }
 
       PTHREAD_CHECK(pthread_kill, thread->handle, SIGSUSPEND);
       signalled++;
@@ -1408,6 +1694,68 @@ void stop_world(stop_world_fn_t callback, void *arg)
    (*callback)(my_thread->id, &cpu, arg);
 }
 
+int stop_world_helpers(void)
+{
+   assert_lock_held(&stop_lock);
+
+#ifdef POSIX_SUSPEND
+   int count = 0;
+   const int maxthread = relaxed_load(&max_thread_id);
+   for (int i = 0; i <= maxthread; i++) {
+      nvc_thread_t *thread = atomic_load(&threads[i]);
+      if (thread != NULL && thread != my_thread && !thread->idle)
+         count++;
+   }
+
+   return count;
+#else
+   return 0;   // Cannot run code on suspended threads
+#endif
+}
+
+// Run FN on the calling thread and concurrently on every thread suspended
+// by stop_world.  FN is called from a signal handler on the suspended
+// threads so must not allocate memory or take locks.
+void stop_world_assist(stop_assist_fn_t fn, void *arg)
+{
+   assert_lock_held(&stop_lock);
+
+#ifdef POSIX_SUSPEND
+   atomic_store(&assist_arg, arg);
+   atomic_store(&assist_fn, fn);
+
+   int signalled = 0;
+   const int maxthread = relaxed_load(&max_thread_id);
+   for (int i = 0; i <= maxthread; i++) {
+      nvc_thread_t *thread = atomic_load(&threads[i]);
+      if (thread == NULL || thread == my_thread || thread->idle)
+         continue;
+
+      PTHREAD_CHECK(pthread_kill, thread->handle, SIGRESUME);
+      signalled++;
+   }
+
+   (*fn)(arg);
+
+   struct timespec ts;
+   if (clock_gettime(CLOCK_REALTIME, &ts) != 0)
+      fatal_errno("clock_gettime");
+
+   ts.tv_sec += SUSPEND_TIMEOUT;
+
+   for (; signalled > 0; signalled--) {
+      if (sem_timedwait(&stop_sem, &ts) != 0)
+         fatal_trace("timeout waiting for %d threads to assist", signalled);
+   }
+
+   assert(sem_trywait(&stop_sem) == -1 && errno == EAGAIN);
+
+   atomic_store(&assist_fn, NULL);
+#else
+   (*fn)(arg);
+#endif
+}
+
 void start_world(void)
 {
    assert_lock_held(&stop_lock);
@@ -1443,7 +1791,7 @@ void start_world(void)
    int signalled = 0;
    for (int i = 0; i <= maxthread; i++) {
       nvc_thread_t *thread = atomic_load(&threads[i]);
-      if (thread == NULL || thread == my_thread)
+      if (thread == NULL || thread == my_thread || thread->idle)
          continue;
 
       PTHREAD_CHECK(pthread_kill, thread->handle, SIGRESUME);
@@ -1462,6 +1810,8 @@ void start_world(void)
    }
 
    assert(sem_trywait(&stop_sem) == -1 && errno == EAGAIN);
+
+   platform_mutex_unlock(&wakelock);
 #endif
 
    nvc_unlock(&stop_lock);
@@ -70,6 +70,9 @@ nvc_thread_t *get_thread(int id);
 
 void spin_wait(void);
 
+void thread_wait(int *word, int value);
+void thread_wake(int *word);
+
 typedef int8_t nvc_lock_t;
 
 void nvc_lock(nvc_lock_t *lock);
@@ -111,6 +114,11 @@ typedef void (*stop_world_fn_t)(int, struct cpu_state *, void *);
 void stop_world(stop_world_fn_t callback, void *arg);
 void start_world(void);
 
+typedef void (*stop_assist_fn_t)(void *);
+
+int stop_world_helpers(void);
+void stop_world_assist(stop_assist_fn_t fn, void *arg);
+
 typedef enum { WX_WRITE, WX_EXECUTE } wx_mode_t;
 void thread_wx_mode(wx_mode_t mode);
 
@@ -0,0 +1,177 @@
+//
+//  Copyright (C) 2026  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "thread.h"
+#include "timeline.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define CHUNK_EVENTS 4096
+
+typedef struct {
+   uint64_t    ts_ns;
+   const char *name;
+   const char *detail;
+   char        phase;
+} tl_event_t;
+
+typedef struct _tl_chunk tl_chunk_t;
+
+typedef struct _tl_chunk {
+   tl_chunk_t *next;
+   unsigned    count;
+   tl_event_t  events[CHUNK_EVENTS];
+} tl_chunk_t;
+
+typedef struct _tl_buffer tl_buffer_t;
+
+typedef struct _tl_buffer {
+   tl_buffer_t *next;
+   int          tid;
+   tl_chunk_t  *tail;
+   tl_chunk_t   head;
+} tl_buffer_t;
+
+bool timeline_enabled = false;
+
+static char        *timeline_file = NULL;
+static uint64_t     timeline_start = 0;
+static tl_buffer_t *all_buffers = NULL;
+
+static __thread tl_buffer_t *my_buffer = NULL;
+
+static tl_buffer_t *timeline_new_buffer(void)
+{
+   // Each thread only appends to its own buffer and the buffers are
+   // never freed so recording an event does not need any locks
+   tl_buffer_t *b = xcalloc(sizeof(tl_buffer_t));
+   b->tid  = thread_attached() ? thread_id() : MAX_THREADS;
+   b->tail = &(b->head);
+
+   tl_buffer_t *head = relaxed_load(&all_buffers);
+   do {
+      b->next = head;
+   } while (!__atomic_cas(&all_buffers, &head, b));
+
+   return (my_buffer = b);
+}
+
+static void timeline_append(char phase, const char *name, const char *detail)
+{
+   tl_buffer_t *b = my_buffer ?: timeline_new_buffer();
+
+   tl_chunk_t *c = b->tail;
+   if (c->count == CHUNK_EVENTS) {
+      tl_chunk_t *new = xmalloc(sizeof(tl_chunk_t));
+      new->next  = NULL;
+      new->count = 0;
+
+      store_release(&(c->next), new);
+      b->tail = c = new;
+   }
+
+   tl_event_t *e = &(c->events[c->count]);
+   e->ts_ns  = get_timestamp_ns();
+   e->name   = name;
+   e->detail = detail;
+   e->phase  = phase;
+
+   store_release(&(c->count), c->count + 1);
+}
+
+void timeline_begin(const char *name, const char *detail)
+{
+   timeline_append('B', name, detail);
+}
+
+void timeline_end(const char *name)
+{
+   timeline_append('E', name, NULL);
+}
+
+static void timeline_json_string(FILE *f, const char *str)
+{
+   fputc('"', f);
+   for (const char *p = str; *p; p++) {
+      if (*p == '"' || *p == '\\')
+         fprintf(f, "\\%c", *p);
+      else if ((unsigned char)*p < 0x20)
+         fprintf(f, "\\u%04x", *p);
+      else
+         fputc(*p, f);
+   }
+   fputc('"', f);
+}
+
+static void timeline_write(void)
+{
+   FILE *f = fopen(timeline_file, "w");
+   if (f == NULL) {
+      warnf("cannot create %s: %s", timeline_file, last_os_error());
+      return;
+   }
+
+   const int pid = getpid();
+
+   fputs("{\"traceEvents\": [", f);
+
+   bool first = true;
+   for (tl_buffer_t *b = load_acquire(&all_buffers); b; b = b->next) {
+      for (tl_chunk_t *c = &(b->head); c; c = load_acquire(&(c->next))) {
+         const unsigned count = load_acquire(&(c->count));
+         for (unsigned i = 0; i < count; i++) {
+            const tl_event_t *e = &(c->events[i]);
+            const uint64_t ts_ns = e->ts_ns - timeline_start;
+
+            fputs(first ? "\n  {\"name\": " : ",\n  {\"name\": ", f);
+            timeline_json_string(f, e->name);
+            fprintf(f, ", \"ph\": \"%c\", \"ts\": %"PRIu64".%03u, "
+                    "\"pid\": %d, \"tid\": %d", e->phase, ts_ns / 1000,
+                    (unsigned)(ts_ns % 1000), pid, b->tid);
+
+            if (e->detail != NULL) {
+               fputs(", \"args\": {\"detail\": ", f);
+               timeline_json_string(f, e->detail);
+               fputc('}', f);
+            }
+
+            fputc('}', f);
+            first = false;
+         }
+      }
+   }
+
+   fputs("\n]}\n", f);
+   fclose(f);
+}
+
+void timeline_open(const char *file)
+{
+   if (timeline_enabled)
+      return;
+
+   timeline_file  = xstrdup(file);
+   timeline_start = get_timestamp_ns();
+
+   store_release(&timeline_enabled, true);
+
+   atexit(timeline_write);
+}
@@ -0,0 +1,43 @@
+//
+//  Copyright (C) 2026  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _TIMELINE_H
+#define _TIMELINE_H
+
+#include "prim.h"
+
+#include <stdbool.h>
+
+// Names and details must be string constants or interned strings
+// which remain valid until the timeline is written at exit
+void timeline_open(const char *file);
+void timeline_begin(const char *name, const char *detail);
+void timeline_end(const char *name);
+
+extern bool timeline_enabled;
+
+#define TIMELINE_BEGIN(name, detail) do {               \
+      if (unlikely(timeline_enabled))                   \
+         timeline_begin((name), (detail));              \
+   } while (0)
+
+#define TIMELINE_END(name) do {                         \
+      if (unlikely(timeline_enabled))                   \
+         timeline_end((name));                          \
+   } while (0)
+
+#endif  // _TIMELINE_H
@@ -549,7 +549,7 @@ static inline void tree_copy_array(tree_t t, tree_t from, imask_t mask)
    obj_array_copy(&(dst->obj_array), src->obj_array);
 
    for (int i = 0; i < src->obj_array->count; i++)
-      object_write_barrier(&(t->object), src->obj_array->items[i]);
+      object_write_barrier(&(t->object), obj_array_nth(src->obj_array, i));
 }
 
 tree_t tree_new(tree_kind_t kind)
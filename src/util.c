@@ -82,6 +82,11 @@
 #include <sys/prctl.h>
 #endif
 
+#ifdef HAVE_LINUX_PERF_EVENT_H
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
 #ifdef __CYGWIN__
 #include <process.h>
 #endif
@@ -1154,7 +1159,11 @@ void *map_huge_pages(size_t align, size_t sz)
       const size_t mapsz = ALIGN_UP(sz, HUGE_PAGE_SIZE);
       void *mem = nvc_memalign(MAX(HUGE_PAGE_SIZE, align), mapsz);
 
-      if (madvise(mem, mapsz, MADV_HUGEPAGE) < 0)
+      // Fall back to regular pages silently if the kernel was built
+      // without transparent huge page support
+      static int warned = 0;
+      if (madvise(mem, mapsz, MADV_HUGEPAGE) < 0 && errno != EINVAL
+          && atomic_cas(&warned, 0, 1))
          warnf("madvise: MADV_HUGEPAGE: %s", last_os_error());
 
       return mem;
@@ -1164,6 +1173,27 @@ void *map_huge_pages(size_t align, size_t sz)
    return nvc_memalign(align, sz);
 }
 
+size_t huge_page_usage(void)
+{
+#ifdef __linux__
+   FILE *f = fopen("/proc/self/smaps_rollup", "r");
+   if (f == NULL)
+      return 0;
+
+   size_t kb = 0;
+   char line[256];
+   while (fgets(line, sizeof(line), f)) {
+      if (sscanf(line, "AnonHugePages: %zu kB", &kb) == 1)
+         break;
+   }
+
+   fclose(f);
+   return kb * 1024;
+#else
+   return 0;
+#endif
+}
+
 void *map_jit_pages(size_t align, size_t sz)
 {
 #ifdef __APPLE__
@@ -1476,6 +1506,83 @@ void nvc_rusage(nvc_rusage_t *ru)
    last_ts = ts;
 }
 
+#ifdef HAVE_LINUX_PERF_EVENT_H
+static int open_hw_counters(void)
+{
+   static const uint64_t config[] = {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_BRANCH_MISSES,
+      PERF_COUNT_HW_CACHE_MISSES,
+   };
+
+   int fds[ARRAY_LEN(config)];
+   for (int i = 0; i < ARRAY_LEN(config); i++) {
+      struct perf_event_attr attr = {
+         .type           = PERF_TYPE_HARDWARE,
+         .size           = sizeof(struct perf_event_attr),
+         .config         = config[i],
+         .disabled       = (i == 0),
+         .exclude_kernel = 1,
+         .exclude_hv     = 1,
+         .read_format    = PERF_FORMAT_GROUP,
+      };
+
+      // Count only the calling thread on any CPU
+      const int group = i == 0 ? -1 : fds[0];
+      fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, group,
+                       PERF_FLAG_FD_CLOEXEC);
+      if (fds[i] < 0) {
+         for (int j = 0; j < i; j++)
+            close(fds[j]);
+         return -1;
+      }
+   }
+
+   if (ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) < 0) {
+      for (int i = 0; i < ARRAY_LEN(fds); i++)
+         close(fds[i]);
+      return -1;
+   }
+
+   return fds[0];
+}
+#endif
+
+bool nvc_hwcount(nvc_hwcount_t *hc)
+{
+#ifdef HAVE_LINUX_PERF_EVENT_H
+   // The counters are opened on first use in each thread and are never
+   // closed so later reads only cost a single system call
+   static __thread bool opened = false;
+   static __thread int group_fd = -1;
+
+   if (!opened) {
+      group_fd = open_hw_counters();
+      opened = true;
+   }
+
+   if (group_fd == -1)
+      return false;
+
+   struct {
+      uint64_t nr;
+      uint64_t values[4];
+   } buf;
+
+   if (read(group_fd, &buf, sizeof(buf)) != sizeof(buf) || buf.nr != 4)
+      return false;
+
+   hc->cycles        = buf.values[0];
+   hc->instructions  = buf.values[1];
+   hc->branch_misses = buf.values[2];
+   hc->cache_misses  = buf.values[3];
+   return true;
+#else
+   return false;
+#endif
+}
+
 #ifdef __MINGW32__
 static uint64_t file_time_to_nanos(LPFILETIME ft)
 {
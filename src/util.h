@@ -291,6 +291,7 @@ void nvc_munmap(void *ptr, size_t length);
 void nvc_memprotect(void *ptr, size_t length, mem_access_t prot);
 void nvc_decommit(void *ptr, size_t length);
 void *map_huge_pages(size_t align, size_t sz);
+size_t huge_page_usage(void);
 void *map_jit_pages(size_t align, size_t sz);
 
 void run_program(const char *const *args);
@@ -351,6 +352,15 @@ typedef struct {
 
 void nvc_rusage(nvc_rusage_t *ru);
 
+typedef struct {
+   uint64_t cycles;
+   uint64_t instructions;
+   uint64_t branch_misses;
+   uint64_t cache_misses;
+} nvc_hwcount_t;
+
+bool nvc_hwcount(nvc_hwcount_t *hc);
+
 typedef uint64_t timestamp_t;   // Nanoseconds
 
 uint64_t get_timestamp_ns(void);
@@ -422,8 +432,10 @@ void pool_stats(mem_pool_t *mp, size_t *alloc, size_t *npages);
       if (!load_acquire(&__done)) {             \
          static nvc_lock_t __lock;              \
          SCOPED_LOCK(__lock);                   \
-         body;                                  \
-         store_release(&__done, 1);             \
+         if (!__done) {                         \
+            body;                               \
+            store_release(&__done, 1);          \
+         }                                      \
       }                                         \
    } while (0)
 
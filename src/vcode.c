@@ -37,6 +37,10 @@ DECLARE_AND_DEFINE_ARRAY(vcode_reg);
 DECLARE_AND_DEFINE_ARRAY(vcode_block);
 DECLARE_AND_DEFINE_ARRAY(vcode_type);
 
+// Switch from a linear search to a hash table when looking for an
+// existing constant or stamp once there are this many candidates
+#define INDEX_THRESH 64
+
 #define OP_HAS_TYPE(x)                                                  \
    (x == VCODE_OP_ALLOC || x == VCODE_OP_COPY                           \
     || x == VCODE_OP_CONST || x == VCODE_OP_CAST                        \
@@ -107,8 +111,9 @@ typedef struct {
 DECLARE_AND_DEFINE_ARRAY(op);
 
 typedef struct {
-   op_array_t ops;
-   loc_t      last_loc;
+   op_array_t  ops;
+   loc_t       last_loc;
+   ihash_t    *consts;
 } block_t;
 
 typedef struct {
@@ -195,6 +200,7 @@ struct _vcode_unit {
    reg_array_t    regs;
    vtype_array_t  types;
    vstamp_array_t stamps;
+   ihash_t       *stamp_index;
    var_array_t    vars;
    param_array_t  params;
    unsigned       depth;
@@ -600,6 +606,9 @@ void vcode_unit_unref(vcode_unit_t unit)
          free(o->args.items);
       }
       free(b->ops.items);
+
+      if (b->consts != NULL)
+         ihash_free(b->consts);
    }
    free(unit->blocks.items);
 
@@ -611,6 +620,9 @@ void vcode_unit_unref(vcode_unit_t unit)
    free(unit->types.items);
 
    free(unit->stamps.items);
+
+   if (unit->stamp_index != NULL)
+      ihash_free(unit->stamp_index);
    free(unit->regs.items);
    free(unit->vars.items);
    free(unit->params.items);
@@ -773,6 +785,9 @@ void vcode_opt(void)
             case VCODE_OP_FUNCTION_TRIGGER:
             case VCODE_OP_CMP_TRIGGER:
             case VCODE_OP_OR_TRIGGER:
+            case VCODE_OP_AND_TRIGGER:
+            case VCODE_OP_LEVEL_TRIGGER:
+            case VCODE_OP_EDGE_TRIGGER:
                if (uses[o->result] == -1) {
                   vcode_dump_with_mark(j, NULL, NULL);
                   fatal_trace("definition of r%d does not dominate all uses",
@@ -823,6 +838,12 @@ void vcode_opt(void)
 
       assert(copied <= b->ops.count);
       b->ops.count = copied;
+
+      if (b->consts != NULL) {
+         // Operation indexes are no longer valid
+         ihash_free(b->consts);
+         b->consts = NULL;
+      }
    }
 }
 
@@ -1050,7 +1071,8 @@ const char *vcode_op_string(vcode_op_t op)
       "or trigger", "cmp trigger", "instance name",
       "bind external", "array scope", "record scope",
       "dir check", "sched process", "table ref", "get counters", "put driver",
-      "deposit signal", "sched active",
+      "deposit signal", "sched active", "level trigger", "and trigger",
+      "edge trigger",
    };
    if ((unsigned)op >= ARRAY_LEN(strs))
       return "???";
@@ -1457,6 +1479,8 @@ void vcode_dump_with_mark(int mark_op, vcode_dump_fn_t callback, void *arg)
                vcode_dump_reg(op->args.items[3]);
                printf(" after ");
                vcode_dump_reg(op->args.items[4]);
+               printf(" kind ");
+               vcode_dump_reg(op->args.items[5]);
             }
             break;
 
@@ -2000,8 +2024,10 @@ void vcode_dump_with_mark(int mark_op, vcode_dump_fn_t callback, void *arg)
             {
                printf("%s on ", vcode_op_string(op->kind));
                vcode_dump_reg(op->args.items[0]);
-               printf(" count ");
-               vcode_dump_reg(op->args.items[1]);
+               if (op->args.count > 1) {
+                  printf(" count ");
+                  vcode_dump_reg(op->args.items[1]);
+               }
             }
             break;
 
@@ -2376,6 +2402,7 @@ void vcode_dump_with_mark(int mark_op, vcode_dump_fn_t callback, void *arg)
             break;
 
          case VCODE_OP_OR_TRIGGER:
+         case VCODE_OP_AND_TRIGGER:
          case VCODE_OP_CMP_TRIGGER:
             {
                col += vcode_dump_reg(op->result);
@@ -2383,6 +2410,8 @@ void vcode_dump_with_mark(int mark_op, vcode_dump_fn_t callback, void *arg)
                col += vcode_dump_reg(op->args.items[0]);
                if (op->kind == VCODE_OP_OR_TRIGGER)
                   col += printf(" || ");
+               else if (op->kind == VCODE_OP_AND_TRIGGER)
+                  col += printf(" && ");
                else
                   col += printf(" == ");
                col += vcode_dump_reg(op->args.items[1]);
@@ -2390,6 +2419,28 @@ void vcode_dump_with_mark(int mark_op, vcode_dump_fn_t callback, void *arg)
             }
             break;
 
+         case VCODE_OP_LEVEL_TRIGGER:
+            {
+               col += vcode_dump_reg(op->result);
+               col += nvc_printf(" := %s ", vcode_op_string(op->kind));
+               col += vcode_dump_reg(op->args.items[0]);
+               col += printf(" count ");
+               col += vcode_dump_reg(op->args.items[1]);
+               vcode_dump_result_type(col, op);
+            }
+            break;
+
+         case VCODE_OP_EDGE_TRIGGER:
+            {
+               col += vcode_dump_reg(op->result);
+               col += nvc_printf(" := %s ", vcode_op_string(op->kind));
+               col += vcode_dump_reg(op->args.items[0]);
+               col += printf(" edge ");
+               col += vcode_dump_reg(op->args.items[1]);
+               vcode_dump_result_type(col, op);
+            }
+            break;
+
          case VCODE_OP_ADD_TRIGGER:
             {
                printf("%s ", vcode_op_string(op->kind));
@@ -2998,20 +3049,52 @@ static bool vtype_clamp_to_repr(vtype_repr_t repr, int64_t *low, int64_t *high)
    }
 }
 
+static uint64_t vstamp_index_key(const vstamp_t *s)
+{
+   // The real bounds are hashed by their bit pattern to match memcmp
+   return mix_bits_64(s->u.intg.low ^ mix_bits_64(s->u.intg.high)) ^ s->kind;
+}
+
 static vcode_stamp_t vstamp_new(const vstamp_t *s)
 {
    assert(active_unit != NULL);
 
-   for (int i = 0; i < active_unit->stamps.count; i++) {
-      vstamp_t *cmp = &(active_unit->stamps.items[i]);
-      if (cmp->kind == s->kind && memcmp(&cmp->u, &s->u, sizeof(s->u)) == 0)
-         return MAKE_HANDLE(active_unit->depth, i);
+   ihash_t *index = active_unit->stamp_index;
+   if (index == NULL && active_unit->stamps.count >= INDEX_THRESH) {
+      index = active_unit->stamp_index = ihash_new(256);
+
+      for (int i = 0; i < active_unit->stamps.count; i++) {
+         const vstamp_t *it = &(active_unit->stamps.items[i]);
+         ihash_put(index, vstamp_index_key(it), (void *)(uintptr_t)(i + 1));
+      }
+   }
+
+   if (index != NULL) {
+      const uintptr_t pos = (uintptr_t)ihash_get(index, vstamp_index_key(s));
+      if (pos != 0) {
+         const vstamp_t *cmp = &(active_unit->stamps.items[pos - 1]);
+         if (cmp->kind == s->kind
+             && memcmp(&cmp->u, &s->u, sizeof(s->u)) == 0)
+            return MAKE_HANDLE(active_unit->depth, pos - 1);
+      }
+   }
+   else {
+      for (int i = 0; i < active_unit->stamps.count; i++) {
+         vstamp_t *cmp = &(active_unit->stamps.items[i]);
+         if (cmp->kind == s->kind
+             && memcmp(&cmp->u, &s->u, sizeof(s->u)) == 0)
+            return MAKE_HANDLE(active_unit->depth, i);
+      }
    }
 
    vstamp_t *new = vstamp_array_alloc(&(active_unit->stamps));
    *new = *s;
 
-   return MAKE_HANDLE(active_unit->depth, active_unit->stamps.count - 1);
+   const int count = active_unit->stamps.count;
+   if (index != NULL)
+      ihash_put(index, vstamp_index_key(s), (void *)(uintptr_t)count);
+
+   return MAKE_HANDLE(active_unit->depth, count - 1);
 }
 
 vcode_stamp_t vstamp_int(int64_t low, int64_t high)
@@ -3531,12 +3614,64 @@ vcode_reg_t emit_alloc(vcode_type_t type, vcode_stamp_t stamp,
    return (op->result = vcode_add_reg(vtype_pointer(type), stamp));
 }
 
+static uint64_t const_index_key(vcode_type_t type, int64_t value)
+{
+   // Must be consistent with vtype_eq as equal types from different
+   // contexts can have different handles
+   const vtype_t *vt = vcode_type_data(type);
+   uint64_t key = mix_bits_64(value) ^ vt->kind;
+   if (vt->kind == VCODE_TYPE_INT)
+      key ^= mix_bits_64(vt->low ^ mix_bits_64(vt->high));
+
+   return key;
+}
+
+static bool const_index_lookup(block_t *b, vcode_type_t type, int64_t value,
+                               vcode_reg_t *reg)
+{
+   if (b->consts == NULL) {
+      b->consts = ihash_new(256);
+
+      for (int i = 0; i < b->ops.count; i++) {
+         const op_t *o = &(b->ops.items[i]);
+         if (o->kind == VCODE_OP_CONST)
+            ihash_put(b->consts, const_index_key(o->type, o->value),
+                      (void *)(uintptr_t)(i + 1));
+      }
+   }
+
+   const uint64_t key = const_index_key(type, value);
+   const uintptr_t index = (uintptr_t)ihash_get(b->consts, key);
+   if (index == 0)
+      return false;
+
+   // A colliding key can only cause a missed reuse
+   const op_t *other = &(b->ops.items[index - 1]);
+   if (other->kind != VCODE_OP_CONST || other->value != value
+       || !vtype_eq(type, other->type))
+      return false;
+
+   *reg = other->result;
+   return true;
+}
+
 vcode_reg_t emit_const(vcode_type_t type, int64_t value)
 {
-   // Reuse any previous constant in this block with the same type and value
-   VCODE_FOR_EACH_MATCHING_OP(other, VCODE_OP_CONST) {
-      if (other->value == value && vtype_eq(type, other->type))
-         return other->result;
+   block_t *b = vcode_block_data();
+
+   // Reuse any previous constant in this block with the same type and
+   // value: large constant aggregates can emit thousands of these into
+   // a single block so switch to a hash lookup past a threshold
+   if (b->consts != NULL || b->ops.count >= INDEX_THRESH) {
+      vcode_reg_t reg;
+      if (const_index_lookup(b, type, value, &reg))
+         return reg;
+   }
+   else {
+      VCODE_FOR_EACH_MATCHING_OP(other, VCODE_OP_CONST) {
+         if (other->value == value && vtype_eq(type, other->type))
+            return other->result;
+      }
    }
 
    op_t *op = vcode_add_op(VCODE_OP_CONST);
@@ -3544,6 +3679,10 @@ vcode_reg_t emit_const(vcode_type_t type, int64_t value)
    op->type   = type;
    op->result = vcode_add_reg(type, vstamp_int(value, value));
 
+   if (b->consts != NULL)
+      ihash_put(b->consts, const_index_key(type, value),
+                (void *)(uintptr_t)b->ops.count);
+
    vtype_kind_t type_kind = vtype_kind(type);
    VCODE_ASSERT(type_kind == VCODE_TYPE_INT || type_kind == VCODE_TYPE_OFFSET,
                 "constant must have integer or offset type");
@@ -4992,7 +5131,7 @@ void emit_drive_signal(vcode_reg_t target, vcode_reg_t count)
 
 void emit_transfer_signal(vcode_reg_t target, vcode_reg_t source,
                           vcode_reg_t count, vcode_reg_t reject,
-                          vcode_reg_t after)
+                          vcode_reg_t after, vcode_reg_t kind)
 {
    op_t *op = vcode_add_op(VCODE_OP_TRANSFER_SIGNAL);
    vcode_add_arg(op, target);
@@ -5000,6 +5139,7 @@ void emit_transfer_signal(vcode_reg_t target, vcode_reg_t source,
    vcode_add_arg(op, count);
    vcode_add_arg(op, reject);
    vcode_add_arg(op, after);
+   vcode_add_arg(op, kind);
 
    VCODE_ASSERT(vcode_reg_kind(target) == VCODE_TYPE_SIGNAL,
                 "target argument to transfer signal is not a signal");
@@ -5300,10 +5440,21 @@ void emit_copy(vcode_reg_t dest, vcode_reg_t src, vcode_reg_t count)
 
 void emit_sched_event(vcode_reg_t nets, vcode_reg_t n_elems)
 {
+   if (n_elems == VCODE_INVALID_REG) {
+      // Wake up when the trigger condition becomes true
+      op_t *op = vcode_add_op(VCODE_OP_SCHED_EVENT);
+      vcode_add_arg(op, nets);
+
+      VCODE_ASSERT(vcode_reg_kind(nets) == VCODE_TYPE_TRIGGER,
+                   "argument to sched event without count must be trigger");
+      return;
+   }
+
    VCODE_FOR_EACH_OP(other) {
       if (other->kind == VCODE_OP_CLEAR_EVENT)
          break;
       else if (other->kind == VCODE_OP_SCHED_EVENT
+               && other->args.count == 2
                && other->args.items[0] == nets
                && other->args.items[1] == n_elems)
          return;
@@ -6122,6 +6273,48 @@ vcode_reg_t emit_cmp_trigger(vcode_reg_t left, vcode_reg_t right)
    return (op->result = vcode_add_reg(vtype_trigger(), VCODE_INVALID_STAMP));
 }
 
+vcode_reg_t emit_and_trigger(vcode_reg_t left, vcode_reg_t right)
+{
+   op_t *op = vcode_add_op(VCODE_OP_AND_TRIGGER);
+   vcode_add_arg(op, left);
+   vcode_add_arg(op, right);
+
+   VCODE_ASSERT(vcode_reg_kind(left) == VCODE_TYPE_TRIGGER,
+                "and trigger left argument must be trigger");
+   VCODE_ASSERT(vcode_reg_kind(right) == VCODE_TYPE_TRIGGER,
+                "and trigger right argument must be trigger");
+
+   return (op->result = vcode_add_reg(vtype_trigger(), VCODE_INVALID_STAMP));
+}
+
+vcode_reg_t emit_level_trigger(vcode_reg_t nets, vcode_reg_t count)
+{
+   op_t *op = vcode_add_op(VCODE_OP_LEVEL_TRIGGER);
+   vcode_add_arg(op, nets);
+   vcode_add_arg(op, count);
+
+   VCODE_ASSERT(vcode_reg_kind(nets) == VCODE_TYPE_SIGNAL,
+                "level trigger argument must be signal");
+   VCODE_ASSERT(vcode_reg_kind(count) == VCODE_TYPE_OFFSET,
+                "level trigger count argument must be offset");
+
+   return (op->result = vcode_add_reg(vtype_trigger(), VCODE_INVALID_STAMP));
+}
+
+vcode_reg_t emit_edge_trigger(vcode_reg_t nets, vcode_reg_t edge)
+{
+   op_t *op = vcode_add_op(VCODE_OP_EDGE_TRIGGER);
+   vcode_add_arg(op, nets);
+   vcode_add_arg(op, edge);
+
+   VCODE_ASSERT(vcode_reg_kind(nets) == VCODE_TYPE_SIGNAL,
+                "edge trigger argument must be signal");
+   VCODE_ASSERT(vcode_reg_const(edge, NULL),
+                "edge trigger kind must be constant");
+
+   return (op->result = vcode_add_reg(vtype_trigger(), VCODE_INVALID_STAMP));
+}
+
 void emit_add_trigger(vcode_reg_t trigger)
 {
    op_t *op = vcode_add_op(VCODE_OP_ADD_TRIGGER);
@@ -172,6 +172,9 @@ typedef enum {
    VCODE_OP_PUT_DRIVER,
    VCODE_OP_DEPOSIT_SIGNAL,
    VCODE_OP_SCHED_ACTIVE,
+   VCODE_OP_LEVEL_TRIGGER,
+   VCODE_OP_AND_TRIGGER,
+   VCODE_OP_EDGE_TRIGGER,
 } vcode_op_t;
 
 typedef enum {
@@ -502,7 +505,7 @@ void emit_map_const(vcode_reg_t src, vcode_reg_t dst, vcode_reg_t count);
 void emit_drive_signal(vcode_reg_t target, vcode_reg_t count);
 void emit_transfer_signal(vcode_reg_t target, vcode_reg_t source,
                           vcode_reg_t count, vcode_reg_t reject,
-                          vcode_reg_t after);
+                          vcode_reg_t after, vcode_reg_t kind);
 vcode_reg_t emit_resolution_wrapper(vcode_type_t type, vcode_reg_t closure,
                                     vcode_reg_t nlits);
 vcode_reg_t emit_closure(ident_t func, vcode_type_t rtype,
@@ -529,6 +532,9 @@ vcode_reg_t emit_function_trigger(ident_t func, const vcode_reg_t *args,
                                   int nargs);
 vcode_reg_t emit_or_trigger(vcode_reg_t left, vcode_reg_t right);
 vcode_reg_t emit_cmp_trigger(vcode_reg_t left, vcode_reg_t right);
+vcode_reg_t emit_and_trigger(vcode_reg_t left, vcode_reg_t right);
+vcode_reg_t emit_level_trigger(vcode_reg_t nets, vcode_reg_t count);
+vcode_reg_t emit_edge_trigger(vcode_reg_t nets, vcode_reg_t edge);
 void emit_add_trigger(vcode_reg_t trigger);
 void emit_bind_foreign(vcode_reg_t spec, vcode_reg_t length, vcode_reg_t locus);
 vcode_reg_t emit_instance_name(vcode_reg_t kind);
@@ -102,6 +102,7 @@ typedef struct tag_abstractRegion {
    vhpiStringT       FullCaseName;
    vhpiStringT       FullName;
    jit_handle_t      handle;
+   hash_t           *names;
 } c_abstractRegion;
 
 typedef struct {
@@ -503,6 +504,8 @@ typedef struct {
 
 DEF_CLASS(ifGenerate, vhpiIfGenerateK, region.object);
 
+typedef struct _vhpi_batch vhpi_batch_t;
+
 typedef struct {
    c_refcounted  refcounted;
    vhpiStateT    State;
@@ -510,6 +513,7 @@ typedef struct {
    vhpiCbDataT   data;
    vhpiHandleT   handle;
    rt_watch_t   *watch;
+   vhpi_batch_t *batch;
 } c_callback;
 
 DEF_CLASS(callback, vhpiCallbackK, refcounted.object);
@@ -551,6 +555,34 @@ typedef struct {
 
 STATIC_ASSERT(sizeof(handle_slot_t) <= 16);
 
+typedef struct {
+   rt_signal_t *signal;
+   rt_scope_t  *scope;
+   int          offset;
+   int          count;
+} watch_target_t;
+
+typedef struct {
+   vhpi_batch_t *batch;
+   vhpiHandleT   obj;
+   rt_watch_t   *watch;
+   bool          pending;
+   vhpiValueT    value;
+} batch_entry_t;
+
+typedef struct _vhpi_batch {
+   vhpiHandleT       handle;
+   vhpiBatchCbFctT   cb_rtn;
+   void             *user_data;
+   vhpiFormatT       format;
+   bool              scheduled;
+   int32_t           count;
+   int32_t           npending;
+   int32_t          *pending;
+   vhpiValueChangeT *changes;
+   batch_entry_t     entries[0];
+} vhpi_batch_t;
+
 typedef struct _vhpi_context {
    c_tool          *tool;
    c_rootInst      *root;
@@ -570,6 +602,8 @@ typedef struct _vhpi_context {
    mem_pool_t      *pool;
    vhpiObjectListT  recycle;
    vhpiPhaseT       phase;
+   hash_t          *pathcache;
+   A(hash_t *)      nametabs;
 } vhpi_context_t;
 
 static c_typeDecl *cached_typeDecl(type_t type, c_vhpiObject *obj);
@@ -2013,6 +2047,73 @@ static void vhpi_watch_scope(rt_model_t *m, rt_scope_t *s, rt_watch_t *w)
       vhpi_watch_scope(m, s->children.items[i], w);
 }
 
+static bool vhpi_get_watch_target(c_vhpiObject *obj, watch_target_t *wt)
+{
+   wt->signal = NULL;
+   wt->scope  = NULL;
+   wt->offset = 0;
+   wt->count  = INT_MAX;
+
+   c_prefixedName *pn;
+   c_objDecl *decl;
+   if ((decl = is_objDecl(obj))) {
+      if (decl->Type->homogeneous) {
+         if ((wt->signal = vhpi_get_signal_objDecl(decl)) == NULL)
+            return false;
+
+         wt->offset = decl->offset;
+         wt->count = decl->Type->numElems;
+      }
+      else if ((wt->scope = vhpi_get_scope_objDecl(decl)) == NULL)
+         return false;
+   }
+   else if ((pn = is_prefixedName(obj))) {
+      if (pn->name.expr.Type->homogeneous) {
+         if ((wt->signal = vhpi_get_signal_prefixedName(pn)) == NULL)
+            return false;
+
+         c_indexedName *in = is_indexedName(obj);
+         if (in != NULL && pn->name.expr.Type->IsUnconstrained) {
+            vhpi_error(vhpiInternal, &(obj->loc), "value change "
+                       "callback not supported for indexed name "
+                       "with non-static subtype");
+            return false;
+         }
+         else if (in != NULL) {
+            wt->offset = in->offset;
+            wt->count = pn->name.expr.Type->numElems;
+         }
+      }
+      else if ((wt->scope = vhpi_get_scope_prefixedName(pn)) == NULL)
+         return false;
+   }
+   else {
+      vhpi_error(vhpiInternal, &(obj->loc), "cannot register value "
+                 "callback for kind %s", vhpi_class_str(obj->kind));
+      return false;
+   }
+
+   return true;
+}
+
+static rt_watch_t *vhpi_watch_target(rt_model_t *m, const watch_target_t *wt,
+                                     sig_event_fn_t fn, void *user)
+{
+   const int slots =
+      wt->scope != NULL ? vhpi_count_subsignals(m, wt->scope) : 1;
+
+   rt_watch_t *w = watch_new(m, fn, user, WATCH_EVENT, slots);
+
+   if (wt->signal != NULL) {
+      const int count = MIN(wt->count, signal_width(wt->signal));
+      return model_set_event_cb(m, wt->signal, wt->offset, count, w);
+   }
+   else {
+      vhpi_watch_scope(m, wt->scope, w);
+      return w;
+   }
+}
+
 static vhpiStringT vhpi_get_case_name(c_vhpiObject *obj)
 {
    c_abstractDecl *ad = is_abstractDecl(obj);
@@ -2133,6 +2234,44 @@ static bool vhpi_name_cmp(c_vhpiObject *obj, const char *str)
    return strcasecmp((char *)vhpi_get_case_name(obj), str) == 0;
 }
 
+static ident_t vhpi_name_key(const char *str)
+{
+   return ident_downcase(ident_new(str));
+}
+
+static c_vhpiObject *vhpi_find_child(c_abstractRegion *region, ident_t key)
+{
+   if (region->names == NULL) {
+      // Build an index of the declarations and nested regions on the
+      // first lookup so resolving long paths does not compare against
+      // every sibling at each level
+      vhpiObjectListT *decls =
+         expand_lazy_list(&(region->object), &(region->decls));
+      vhpiObjectListT *stmts =
+         expand_lazy_list(&(region->object), &(region->stmts));
+
+      region->names = hash_new(decls->count + stmts->count + 1);
+      APUSH(vhpi_context()->nametabs, region->names);
+
+      // Insert in reverse so the first match wins and declarations
+      // take precedence over statements
+      for (int i = stmts->count - 1; i >= 0; i--) {
+         if (is_abstractRegion(stmts->items[i]) == NULL)
+            continue;
+
+         const char *name = (char *)vhpi_get_case_name(stmts->items[i]);
+         hash_put(region->names, vhpi_name_key(name), stmts->items[i]);
+      }
+
+      for (int i = decls->count - 1; i >= 0; i--) {
+         const char *name = (char *)vhpi_get_case_name(decls->items[i]);
+         hash_put(region->names, vhpi_name_key(name), decls->items[i]);
+      }
+   }
+
+   return hash_get(region->names, key);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Public API
 
@@ -2265,48 +2404,9 @@ vhpiHandleT vhpi_register_cb(vhpiCbDataT *cb_data_p, int32_t flags)
          if (obj == NULL)
             return NULL;
 
-         rt_signal_t *signal = NULL;
-         rt_scope_t *scope = NULL;
-         int offset = 0, count = INT_MAX;
-
-         c_prefixedName *pn;
-         c_objDecl *decl;
-         if ((decl = is_objDecl(obj))) {
-            if (decl->Type->homogeneous) {
-               if ((signal = vhpi_get_signal_objDecl(decl)) == NULL)
-                  return NULL;
-
-               offset = decl->offset;
-               count = decl->Type->numElems;
-            }
-            else if ((scope = vhpi_get_scope_objDecl(decl)) == NULL)
-               return NULL;
-         }
-         else if ((pn = is_prefixedName(obj))) {
-            if (pn->name.expr.Type->homogeneous) {
-               if ((signal = vhpi_get_signal_prefixedName(pn)) == NULL)
-                  return NULL;
-
-               c_indexedName *in = is_indexedName(obj);
-               if (in != NULL && pn->name.expr.Type->IsUnconstrained) {
-                  vhpi_error(vhpiInternal, &(obj->loc), "value change "
-                             "callback not supported for indexed name "
-                             "with non-static subtype");
-                  return NULL;
-               }
-               else if (in != NULL) {
-                  offset = in->offset;
-                  count = pn->name.expr.Type->numElems;
-               }
-            }
-            else if ((scope = vhpi_get_scope_prefixedName(pn)) == NULL)
-               return NULL;
-         }
-         else {
-            vhpi_error(vhpiInternal, &(obj->loc), "cannot register value "
-                       "callback for kind %s", vhpi_class_str(obj->kind));
+         watch_target_t wt;
+         if (!vhpi_get_watch_target(obj, &wt))
             return NULL;
-         }
 
          c_callback *cb = recycle_object(sizeof(c_callback), vhpiCallbackK);
          init_callback(cb, cb_data_p, flags);
@@ -2317,18 +2417,9 @@ vhpiHandleT vhpi_register_cb(vhpiCbDataT *cb_data_p, int32_t flags)
          // returns without affecting registration of the callback.
          cb->data.obj = internal_handle_for(obj);
 
-         const int slots = scope != NULL ? vhpi_count_subsignals(m, scope) : 1;
-
          cb->handle = internal_handle_for(&(cb->refcounted.object));
-         cb->watch = watch_new(m, vhpi_signal_event_cb, cb->handle,
-                               WATCH_EVENT, slots);
-
-         if (signal != NULL) {
-            count = MIN(count, signal_width(signal));
-            cb->watch = model_set_event_cb(m, signal, offset, count, cb->watch);
-         }
-         else
-            vhpi_watch_scope(m, scope, cb->watch);
+         cb->watch = vhpi_watch_target(m, &wt, vhpi_signal_event_cb,
+                                       cb->handle);
 
          if (flags & vhpiReturnCb)
             return user_handle_for(&(cb->refcounted.object));
@@ -2343,6 +2434,156 @@ vhpiHandleT vhpi_register_cb(vhpiCbDataT *cb_data_p, int32_t flags)
    }
 }
 
+static void vhpi_batch_flush_cb(rt_model_t *m, void *user)
+{
+   // The callback may have been removed since the flush was scheduled
+   handle_slot_t *slot = decode_handle(vhpi_context(), user);
+   if (slot == NULL)
+      return;
+
+   c_callback *cb = is_callback(slot->obj);
+   if (cb == NULL || cb->batch == NULL)
+      return;
+
+   vhpi_batch_t *b = cb->batch;
+   b->scheduled = false;
+
+   int count = 0;
+   for (int i = 0; i < b->npending; i++) {
+      batch_entry_t *e = &(b->entries[b->pending[i]]);
+      e->pending = false;
+
+      vhpiValueChangeT *vc = &(b->changes[count]);
+      vc->obj = e->obj;
+      vc->value = NULL;
+
+      if (b->format != 0) {
+         vhpiValueT *v = &(e->value);
+         v->format = b->format;
+
+         int need = vhpi_get_value(e->obj, v);
+         if (need > 0) {
+            v->value.ptr = xrealloc(v->value.ptr, need);
+            v->bufSize = need;
+            need = vhpi_get_value(e->obj, v);
+         }
+
+         if (need != 0)
+            continue;
+
+         vc->value = v;
+      }
+
+      count++;
+   }
+
+   b->npending = 0;
+
+   if (cb->State == vhpiEnable && count > 0)
+      (*b->cb_rtn)(b->changes, count, b->user_data);
+}
+
+static void vhpi_batch_event_cb(uint64_t now, rt_signal_t *signal,
+                                rt_watch_t *watch, void *user)
+{
+   batch_entry_t *e = user;
+   if (e->pending)
+      return;
+
+   vhpi_batch_t *b = e->batch;
+   b->pending[b->npending++] = e - b->entries;
+   e->pending = true;
+
+   if (!b->scheduled) {
+      // Deliver all the changes in this delta cycle together once
+      // every process has run
+      rt_model_t *m = vhpi_context()->model;
+      model_set_phase_cb(m, END_OF_PROCESSES, vhpi_batch_flush_cb, b->handle);
+      b->scheduled = true;
+   }
+}
+
+static void vhpi_free_batch(rt_model_t *m, vhpi_batch_t *b)
+{
+   vhpi_context_t *c = vhpi_context();
+
+   for (int i = 0; i < b->count; i++) {
+      batch_entry_t *e = &(b->entries[i]);
+      if (e->watch != NULL)
+         watch_free(m, e->watch);
+
+      drop_handle(c, e->obj);
+
+      if (b->format != 0 && e->value.bufSize > 0)
+         free(e->value.value.ptr);
+   }
+
+   free(b->pending);
+   free(b->changes);
+   free(b);
+}
+
+DLLEXPORT
+vhpiHandleT vhpi_register_batch_cb(const vhpiHandleT *objs, int32_t count,
+                                   vhpiFormatT format, vhpiBatchCbFctT cb_rtn,
+                                   void *user_data, int32_t flags)
+{
+   vhpi_clear_error();
+
+   VHPI_TRACE("objs=%p count=%d format=%s flags=%x", objs, count,
+              format == 0 ? "0" : vhpi_format_str(format), flags);
+
+   if (count <= 0 || objs == NULL || cb_rtn == NULL) {
+      vhpi_error(vhpiError, NULL, "invalid arguments to "
+                 "vhpi_register_batch_cb");
+      return NULL;
+   }
+
+   vhpi_context_t *c = vhpi_context();
+
+   watch_target_t *targets LOCAL = xmalloc_array(count, sizeof(watch_target_t));
+   for (int i = 0; i < count; i++) {
+      c_vhpiObject *obj = from_handle(objs[i]);
+      if (obj == NULL)
+         return NULL;
+      else if (!vhpi_get_watch_target(obj, &(targets[i])))
+         return NULL;
+   }
+
+   vhpiCbDataT cb_data = {
+      .reason    = vhpiCbValueChangeBatch,
+      .user_data = user_data,
+   };
+
+   c_callback *cb = recycle_object(sizeof(c_callback), vhpiCallbackK);
+   init_callback(cb, &cb_data, flags);
+
+   vhpi_batch_t *b = xcalloc_flex(sizeof(vhpi_batch_t), count,
+                                  sizeof(batch_entry_t));
+   b->cb_rtn    = cb_rtn;
+   b->user_data = user_data;
+   b->format    = format;
+   b->count     = count;
+   b->pending   = xmalloc_array(count, sizeof(int32_t));
+   b->changes   = xmalloc_array(count, sizeof(vhpiValueChangeT));
+
+   cb->batch  = b;
+   cb->handle = b->handle = internal_handle_for(&(cb->refcounted.object));
+
+   for (int i = 0; i < count; i++) {
+      batch_entry_t *e = &(b->entries[i]);
+      e->batch = b;
+      e->obj   = internal_handle_for(from_handle(objs[i]));
+      e->watch = vhpi_watch_target(c->model, &(targets[i]),
+                                   vhpi_batch_event_cb, e);
+   }
+
+   if (flags & vhpiReturnCb)
+      return user_handle_for(&(cb->refcounted.object));
+   else
+      return NULL;
+}
+
 DLLEXPORT
 int vhpi_remove_cb(vhpiHandleT handle)
 {
@@ -2366,6 +2607,10 @@ int vhpi_remove_cb(vhpiHandleT handle)
 
       drop_handle(c, cb->data.obj);
    }
+   else if (cb->Reason == vhpiCbValueChangeBatch) {
+      vhpi_free_batch(c->model, cb->batch);
+      cb->batch = NULL;
+   }
 
    cb->State = vhpiMature;
 
@@ -2628,13 +2873,23 @@ vhpiHandleT vhpi_handle_by_name(const char *name, vhpiHandleT scope)
 
    VHPI_TRACE("name=%s scope=%p", name, scope);
 
+   vhpi_context_t *c = vhpi_context();
+
+   ident_t path = NULL;
+   if (scope == NULL) {
+      // Absolute paths are often looked up repeatedly
+      path = vhpi_name_key(name);
+
+      c_vhpiObject *cached = hash_get(c->pathcache, path);
+      if (cached != NULL)
+         return user_handle_for(cached);
+   }
+
    char *copy LOCAL = xstrdup(name), *saveptr;
    char *elem = strtok_r(copy, ":.", &saveptr);
 
    c_vhpiObject *where = NULL;
    if (scope == NULL) {
-      vhpi_context_t *c = vhpi_context();
-
       if (c->root == NULL) {
          vhpi_error(vhpiError, NULL, "design has not been elaborated");
          return NULL;
@@ -2667,25 +2922,10 @@ vhpiHandleT vhpi_handle_by_name(const char *name, vhpiHandleT scope)
       c_iterator it = {};
       c_abstractRegion *region = is_abstractRegion(where);
       if (region != NULL) {
-         vhpiObjectListT *decls = expand_lazy_list(where, &(region->decls));
-         for (int i = 0; i < decls->count; i++) {
-            if (vhpi_name_cmp(decls->items[i], elem)) {
-               where = decls->items[i];
-               found = true;
-               break;
-            }
-         }
-
-         if (!found) {
-            vhpiObjectListT *stmts = expand_lazy_list(where, &(region->stmts));
-            for (int i = 0; i < stmts->count; i++) {
-               c_abstractRegion *r = is_abstractRegion(stmts->items[i]);
-               if (r != NULL && vhpi_name_cmp(stmts->items[i], elem)) {
-                  where = &(r->object);
-                  found = true;
-                  break;
-               }
-            }
+         c_vhpiObject *child = vhpi_find_child(region, vhpi_name_key(elem));
+         if (child != NULL) {
+            where = child;
+            found = true;
          }
       }
       else if (init_iterator(&it, vhpiSelectedNames, where)) {
@@ -2708,6 +2948,9 @@ vhpiHandleT vhpi_handle_by_name(const char *name, vhpiHandleT scope)
       }
    }
 
+   if (path != NULL)
+      hash_put(c->pathcache, path, where);
+
    return user_handle_for(where);
 }
 
@@ -3583,11 +3826,7 @@ int vhpi_get_value(vhpiHandleT expr, vhpiValueT *value_p)
             return num_elems * sizeof(vhpiSmallEnumT);
 
          value_p->numElems = num_elems;
-
-         const uint8_t *p = value + offset;
-         for (int i = 0; i < value_p->numElems; i++)
-            value_p->value.smallenumvs[i] = *p++;
-
+         memcpy(value_p->value.smallenumvs, value + offset, num_elems);
          return 0;
       }
 
@@ -3652,11 +3891,8 @@ int vhpi_get_value(vhpiHandleT expr, vhpiValueT *value_p)
             return num_elems * sizeof(vhpiRealT);
 
          value_p->numElems = num_elems;
-
-         const double *p = ((const double *)value) + offset;
-         for (int i = 0; i < value_p->numElems; i++)
-            value_p->value.reals[i] = *p++;
-
+         memcpy(value_p->value.reals, ((const double *)value) + offset,
+                num_elems * sizeof(vhpiRealT));
          return 0;
       }
 
@@ -3667,6 +3903,12 @@ int vhpi_get_value(vhpiHandleT expr, vhpiValueT *value_p)
 
          value_p->numElems = num_elems;
 
+         if (size == sizeof(vhpiIntT)) {
+            memcpy(value_p->value.intgs, ((const vhpiIntT *)value) + offset,
+                   num_elems * sizeof(vhpiIntT));
+            return 0;
+         }
+
 #define READ_INTGS(type) do {                                   \
             const type *p = ((const type *)value) + offset;     \
             for (int i = 0; i < value_p->numElems; i++)         \
@@ -3986,6 +4228,234 @@ int vhpi_put_value(vhpiHandleT handle,
    return 1;
 }
 
+static c_typeDecl *vhpi_get_direct_type(c_vhpiObject *obj)
+{
+   c_typeDecl *td;
+   c_prefixedName *pn = is_prefixedName(obj);
+   if (pn != NULL)
+      td = pn->name.expr.Type;
+   else {
+      c_objDecl *decl = cast_objDecl(obj);
+      if (decl == NULL)
+         return NULL;
+      td = decl->Type;
+   }
+
+   if (!td->homogeneous || td->wrapped) {
+      vhpi_error(vhpiError, &(obj->loc), "direct value access requires an "
+                 "object whose elements all have the same type and whose "
+                 "bounds are known at elaboration time");
+      return NULL;
+   }
+
+   return td;
+}
+
+static rt_signal_t *vhpi_get_direct_signal(c_vhpiObject *obj, int *offset)
+{
+   c_prefixedName *pn = is_prefixedName(obj);
+   if (pn != NULL) {
+      c_indexedName *in = is_indexedName(obj);
+      *offset = in ? in->offset : 0;
+      return vhpi_get_signal_prefixedName(pn);
+   }
+
+   c_objDecl *decl = cast_objDecl(obj);
+   assert(decl != NULL);
+
+   *offset = decl->offset;
+   return vhpi_get_signal_objDecl(decl);
+}
+
+static const unsigned char *vhpi_get_direct_data(c_vhpiObject *obj,
+                                                 c_typeDecl *td, int *size,
+                                                 const char *what)
+{
+   switch (vhpi_get_prefix_kind(obj)) {
+   case vhpiGenericDeclK:
+   case vhpiConstDeclK:
+      *size = td->size;
+      return vhpi_get_value_ptr(obj);
+
+   case vhpiSigDeclK:
+   case vhpiPortDeclK:
+      {
+         int offset;
+         rt_signal_t *signal = vhpi_get_direct_signal(obj, &offset);
+         if (signal == NULL)
+            return NULL;
+
+         *size = signal_size(signal);
+         return (const unsigned char *)signal_value(signal) + offset * *size;
+      }
+
+   default:
+      vhpi_error(vhpiError, &(obj->loc), "class kind %s cannot be used with "
+                 "%s", vhpi_class_str(obj->kind), what);
+      return NULL;
+   }
+}
+
+DLLEXPORT
+int vhpi_get_value_direct(vhpiHandleT expr, vhpiDirectValueT *value_p)
+{
+   vhpi_clear_error();
+
+   VHPI_TRACE("expr=%s value_p=%p", handle_pp(expr), value_p);
+
+   c_vhpiObject *obj = from_handle(expr);
+   if (obj == NULL)
+      return 1;
+
+   c_typeDecl *td = vhpi_get_direct_type(obj);
+   if (td == NULL)
+      return 1;
+
+   int size;
+   const unsigned char *data =
+      vhpi_get_direct_data(obj, td, &size, "vhpi_get_value_direct");
+   if (data == NULL)
+      return 1;
+
+   value_p->data     = data;
+   value_p->elemSize = size;
+   value_p->stride   = size;
+   value_p->numElems = td->IsComposite ? td->numElems : 1;
+   value_p->isUp     = 1;
+
+   if (td->IsComposite && type_is_array(td->type))
+      value_p->isUp = direction_of(td->type, 0) == RANGE_TO;
+
+   return 0;
+}
+
+DLLEXPORT
+int vhpi_get_value_packed(vhpiHandleT expr, uint32_t *bits, uint32_t *xmask,
+                          int32_t numWords)
+{
+   vhpi_clear_error();
+
+   VHPI_TRACE("expr=%s bits=%p xmask=%p numWords=%d", handle_pp(expr),
+              bits, xmask, numWords);
+
+   c_vhpiObject *obj = from_handle(expr);
+   if (obj == NULL)
+      return -1;
+
+   c_typeDecl *td = vhpi_get_direct_type(obj);
+   if (td == NULL)
+      return -1;
+
+   if (td->map_str == NULL) {
+      vhpi_error(vhpiError, &(obj->loc), "vhpi_get_value_packed requires "
+                 "an array of BIT, STD_ULOGIC, or STD_LOGIC");
+      return -1;
+   }
+
+   int size;
+   const unsigned char *data =
+      vhpi_get_direct_data(obj, td, &size, "vhpi_get_value_packed");
+   if (data == NULL)
+      return -1;
+
+   assert(size == 1);
+
+   const int num_elems = td->IsComposite ? td->numElems : 1;
+   const int nwords = (num_elems + 31) / 32;
+   if (numWords < nwords)
+      return nwords;
+
+   // Element values of STD_ULOGIC in the order "UX01ZWLH-"
+   static const uint8_t logic_bit[9] = { 0, 0, 0, 1, 0, 0, 0, 1, 0 };
+   static const uint8_t logic_x[9] = { 1, 1, 0, 0, 1, 1, 0, 0, 1 };
+
+   const bool is_logic = td->map_str[1] == 'X';
+
+   for (int i = 0; i < nwords; i++) {
+      uint32_t b = 0, x = 0;
+      const int n = MIN(32, num_elems - i * 32);
+      const unsigned char *p = data + i * 32;
+      if (is_logic) {
+         for (int j = 0; j < n; j++) {
+            b |= (uint32_t)logic_bit[p[j]] << j;
+            x |= (uint32_t)logic_x[p[j]] << j;
+         }
+      }
+      else {
+         for (int j = 0; j < n; j++)
+            b |= (uint32_t)p[j] << j;
+      }
+
+      bits[i] = b;
+      if (xmask != NULL)
+         xmask[i] = x;
+   }
+
+   return 0;
+}
+
+DLLEXPORT
+int vhpi_put_value_direct(vhpiHandleT expr, const void *data, int32_t offset,
+                          int32_t numElems, vhpiPutValueModeT mode)
+{
+   vhpi_clear_error();
+
+   VHPI_TRACE("expr=%s data=%p offset=%d numElems=%d mode=%s",
+              handle_pp(expr), data, offset, numElems,
+              vhpi_put_value_mode_str(mode));
+
+   c_vhpiObject *obj = from_handle(expr);
+   if (obj == NULL)
+      return 1;
+
+   c_typeDecl *td = vhpi_get_direct_type(obj);
+   if (td == NULL)
+      return 1;
+
+   switch (vhpi_get_prefix_kind(obj)) {
+   case vhpiSigDeclK:
+   case vhpiPortDeclK:
+      break;
+   default:
+      vhpi_error(vhpiError, &(obj->loc), "class kind %s cannot be used with "
+                 "vhpi_put_value_direct", vhpi_class_str(obj->kind));
+      return 1;
+   }
+
+   const int width = td->IsComposite ? td->numElems : 1;
+   if (offset < 0 || numElems < 0 || offset + numElems > width) {
+      vhpi_error(vhpiError, &(obj->loc), "elements %d to %d out of range for "
+                 "object with %d elements", offset, offset + numElems - 1,
+                 width);
+      return 1;
+   }
+
+   int base;
+   rt_signal_t *signal = vhpi_get_direct_signal(obj, &base);
+   if (signal == NULL)
+      return 1;
+
+   rt_model_t *model = vhpi_context()->model;
+   if (!model_can_create_delta(model)) {
+      vhpi_error(vhpiError, &(obj->loc), "cannot create delta cycle "
+                 "during current simulation phase");
+      return 1;
+   }
+
+   switch (mode) {
+   case vhpiForcePropagate:
+      force_signal(model, signal, data, base + offset, numElems);
+      return 0;
+   case vhpiDepositPropagate:
+      sched_deposit(model, signal, data, base + offset, numElems, 0, false);
+      return 0;
+   default:
+      vhpi_error(vhpiFailure, &(obj->loc), "mode %s not supported in "
+                 "vhpi_put_value_direct", vhpi_put_value_mode_str(mode));
+      return 1;
+   }
+}
+
 DLLEXPORT
 int vhpi_protected_call(vhpiHandleT varHdl,
                         vhpiUserFctT userFct,
@@ -5416,6 +5886,7 @@ vhpi_context_t *vhpi_context_new(void)
 
    vhpi_context_t *c = global_context = xcalloc(sizeof(vhpi_context_t));
    c->objcache = hash_new(128);
+   c->pathcache = hash_new(128);
    c->pool     = pool_new();
    c->phase    = vhpiRegistrationPhase;
 
@@ -5552,6 +6023,11 @@ void vhpi_context_free(vhpi_context_t *c)
 #endif
 
    hash_free(c->objcache);
+   hash_free(c->pathcache);
+
+   for (int i = 0; i < c->nametabs.count; i++)
+      hash_free(c->nametabs.items[i]);
+   ACLEAR(c->nametabs);
    pool_free(c->pool);
    free(c->handles);
    free(c);
@@ -499,6 +499,7 @@ const char *vhpi_cb_reason_str(int reason)
    case vhpiCbTimeOut: return "vhpiCbTimeOut";
    case vhpiCbRepTimeOut: return "vhpiCbRepTimeOut";
    case vhpiCbSensitivity: return "vhpiCbSensitivity";
+   case vhpiCbValueChangeBatch: return "vhpiCbValueChangeBatch";
    default: return vhpi_fallback_str(reason);
    }
 }
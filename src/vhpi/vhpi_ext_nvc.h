@@ -28,4 +28,59 @@
 #define VHPIEXTEND_INT_PROPERTIES ,             \
    vhpiRandomSeedP = 1100
 
+// Callback reason for batches registered with vhpi_register_batch_cb
+#define vhpiCbValueChangeBatch 1100
+
+// Deliver value changes on a set of objects with a single call at the
+// end of each delta cycle rather than one callback per object.  The
+// value of each changed object is read using FORMAT, or if FORMAT is
+// zero the value field is NULL.  The returned callback handle can be
+// used with vhpi_remove_cb, vhpi_disable_cb and vhpi_enable_cb.
+//
+// vhpi_get_value_direct returns a read-only pointer to the simulator's
+// own storage for a signal or constant along with its layout, which
+// stays valid and up to date for the rest of the simulation.
+// vhpi_get_value_packed reads an array of BIT or STD_ULOGIC with one
+// bit per element, the leftmost element in the least significant bit
+// of the first word.  For STD_ULOGIC '1' and 'H' read as one and the
+// bit is set in XMASK for any element other than '0', '1', 'L', or
+// 'H'.  Returns the number of words required if NUMWORDS is too small.
+// vhpi_put_value_direct deposits or forces elements of a signal from a
+// buffer in the same layout without any format conversion.
+#define VHPIEXTEND_FUNCTIONS                                            \
+   typedef struct vhpiValueChangeS {                                    \
+      vhpiHandleT  obj;                                                 \
+      vhpiValueT  *value;                                               \
+   } vhpiValueChangeT;                                                  \
+                                                                        \
+   typedef void (*vhpiBatchCbFctT)(const vhpiValueChangeT *changes,     \
+                                   int32_t count, void *user_data);     \
+                                                                        \
+   XXTERN vhpiHandleT vhpi_register_batch_cb(const vhpiHandleT *objs,   \
+                                             int32_t count,             \
+                                             vhpiFormatT format,        \
+                                             vhpiBatchCbFctT cb_rtn,    \
+                                             void *user_data,           \
+                                             int32_t flags);            \
+                                                                        \
+   typedef struct vhpiDirectValueS {                                    \
+      const void *data;                                                 \
+      int32_t     elemSize;                                             \
+      int32_t     stride;                                               \
+      int32_t     numElems;                                             \
+      int32_t     isUp;                                                 \
+   } vhpiDirectValueT;                                                  \
+                                                                        \
+   XXTERN int vhpi_get_value_direct(vhpiHandleT expr,                   \
+                                    vhpiDirectValueT *value_p);         \
+   XXTERN int vhpi_get_value_packed(vhpiHandleT expr,                   \
+                                    uint32_t *bits,                     \
+                                    uint32_t *xmask,                    \
+                                    int32_t numWords);                  \
+   XXTERN int vhpi_put_value_direct(vhpiHandleT expr,                   \
+                                    const void *data,                   \
+                                    int32_t offset,                     \
+                                    int32_t numElems,                   \
+                                    vhpiPutValueModeT mode);
+
 #endif  // VHPI_EXT_NVC_H
@@ -22,6 +22,7 @@
 #include "ident.h"
 #include "mir/mir-node.h"
 #include "mir/mir-unit.h"
+#include "option.h"
 #include "printf.h"
 #include "rt/rt.h"
 #include "type.h"
@@ -859,6 +860,56 @@ static bool vlog_has_side_effects(vlog_node_t v)
    }
 }
 
+static mir_type_t vlog_unsigned_type(vlog_gen_t *g, mir_type_t type)
+{
+   const int size = mir_get_size(g->mu, type);
+
+   if (mir_get_class(g->mu, type) == MIR_TYPE_VEC2)
+      return mir_vec2_type(g->mu, size, false);
+   else
+      return mir_vec4_type(g->mu, size, false);
+}
+
+static bool vlog_is_defined_number(vlog_node_t v)
+{
+   return vlog_kind(v) == V_NUMBER && number_is_defined(vlog_number(v));
+}
+
+static mir_value_t vlog_two_state_operand(vlog_gen_t *g, vlog_binary_t binop,
+                                          vlog_node_t expr, mir_value_t value,
+                                          mir_value_t other,
+                                          mir_type_t context)
+{
+   // A literal with no X or Z bits need not make an expression with a
+   // two-state operand four-state, except where the four-state result
+   // could be X such as division by zero
+   if (binop == V_BINARY_DIVIDE || binop == V_BINARY_MOD
+       || binop == V_BINARY_EXP)
+      return value;
+   else if (!mir_is(g->mu, value, MIR_TYPE_VEC4))
+      return value;
+   else if (!mir_is(g->mu, other, MIR_TYPE_VEC2))
+      return value;
+   else if (!vlog_is_defined_number(expr))
+      return value;
+
+   mir_type_t type = mir_get_type(g->mu, value);
+   const int size = mir_get_size(g->mu, type);
+   const bool issigned = mir_get_signed(g->mu, type);
+
+   // Only single word operations have a native two-state form
+   if (size > 64 || mir_get_size(g->mu, mir_get_type(g->mu, other)) > 64)
+      return value;
+   else if (!mir_is_null(context)) {
+      const mir_class_t class = mir_get_class(g->mu, context);
+      if ((class == MIR_TYPE_VEC2 || class == MIR_TYPE_VEC4)
+          && mir_get_size(g->mu, context) > 64)
+         return value;
+   }
+
+   return mir_build_cast(g->mu, mir_vec2_type(g->mu, size, issigned), value);
+}
+
 static mir_value_t vlog_lower_vector_binary(vlog_gen_t *g, vlog_binary_t binop,
                                             mir_value_t left, mir_value_t right,
                                             mir_type_t context)
@@ -904,20 +955,16 @@ static mir_value_t vlog_lower_vector_binary(vlog_gen_t *g, vlog_binary_t binop,
    if (unsigned_numeric && !is_signed) {
       // Mixed signedness binary expressions are evaluated as unsigned, so
       // signed operands must not be sign-extended when resized
-      if (lsigned) {
-         mir_type_t ultype = mir_vec4_type(g->mu, lsize, false);
-         left = mir_build_cast(g->mu, ultype, left);
-      }
+      if (lsigned)
+         left = mir_build_cast(g->mu, vlog_unsigned_type(g, ltype), left);
 
-      if (rsigned) {
-         mir_type_t urtype = mir_vec4_type(g->mu, rsize, false);
-         right = mir_build_cast(g->mu, urtype, right);
-      }
+      if (rsigned)
+         right = mir_build_cast(g->mu, vlog_unsigned_type(g, rtype), right);
    }
 
    mir_value_t lcast = mir_build_cast(g->mu, type, left), rcast;
    if (is_shift) {
-      mir_type_t urtype = mir_vec4_type(g->mu, rsize, false);
+      mir_type_t urtype = vlog_unsigned_type(g, rtype);
       mir_value_t zext = mir_build_cast(g->mu, urtype, right);
       rcast = mir_build_cast(g->mu, type, zext);
    }
@@ -1023,8 +1070,11 @@ static mir_value_t vlog_lower_binary(vlog_gen_t *g, vlog_node_t v,
    mir_value_t right = vlog_lower_with_context(g, rhs_expr, type);
 
    mir_value_t result;
-   if (mir_is_vector(g->mu, left) && mir_is_vector(g->mu, right))
+   if (mir_is_vector(g->mu, left) && mir_is_vector(g->mu, right)) {
+      left = vlog_two_state_operand(g, op, lhs_expr, left, right, context);
+      right = vlog_two_state_operand(g, op, rhs_expr, right, left, context);
       result = vlog_lower_vector_binary(g, op, left, right, context);
+   }
    else {
       mir_type_t ltype = mir_get_type(g->mu, left);
       mir_type_t rtype = mir_get_type(g->mu, right);
@@ -3631,6 +3681,120 @@ static void vlog_lower_convert_out(mir_unit_t *mu, object_t *obj)
    vlog_lower_converter(mu, cf);
 }
 
+static void vlog_count_driver(vlog_node_t v, void *context)
+{
+   hash_t *drivers = context;
+
+   if (vlog_kind(v) != V_REF || !vlog_has_ref(v))
+      return;
+
+   vlog_node_t d = vlog_ref(v);
+   const intptr_t count = (intptr_t)hash_get(drivers, d);
+   hash_put(drivers, d, (void *)(count + 1));
+}
+
+static void vlog_count_force(vlog_node_t v, void *context)
+{
+   vlog_visit(vlog_target(v), vlog_count_driver, context);
+}
+
+static void vlog_count_drivers(vlog_node_t body, hash_t *drivers)
+{
+   const int nstmts = vlog_stmts(body);
+   for (int i = 0; i < nstmts; i++) {
+      vlog_node_t s = vlog_stmt(body, i);
+      switch (vlog_kind(s)) {
+      case V_ASSIGN:
+         vlog_visit(vlog_target(s), vlog_count_driver, drivers);
+         break;
+      case V_GATE_INST:
+         if (vlog_subkind(s) < V_GATE_TRAN) {
+            vlog_visit(vlog_target(s), vlog_count_driver, drivers);
+            break;
+         }
+         // Fall-through
+      default:
+         // Conservatively assume any net referenced here is driven
+         vlog_visit(s, vlog_count_driver, drivers);
+         break;
+      case V_INITIAL:
+      case V_ALWAYS:
+      case V_FINAL:
+         vlog_visit_only(s, vlog_count_force, drivers, V_FORCE);
+         break;
+      }
+   }
+}
+
+static vlog_node_t vlog_alias_source(vlog_gen_t *g, vlog_node_t v,
+                                     hash_t *drivers)
+{
+   // A continuous assignment "assign a = b" where the net "a" has no
+   // other drivers can be collapsed so that "a" shares the signal for
+   // "b" and no process is needed to copy the value
+
+   if (vlog_has_delay(v) || vlog_params(v) > 0)
+      return NULL;
+
+   vlog_node_t target = vlog_target(v), value = vlog_value(v);
+   if (vlog_kind(target) != V_REF || vlog_kind(value) != V_REF)
+      return NULL;
+   else if (!vlog_has_ref(target) || !vlog_has_ref(value))
+      return NULL;
+
+   vlog_node_t d = vlog_ref(target);
+   if (vlog_kind(d) != V_NET_DECL || vlog_subkind(d) != V_NET_WIRE)
+      return NULL;
+   else if (vlog_has_value(d))
+      return NULL;
+   else if ((intptr_t)hash_get(drivers, d) != 1)
+      return NULL;
+
+   int hops;
+   if (!mir_is_null(mir_search_object(g->mu, d, &hops)))
+      return NULL;   // Port
+
+   vlog_node_t src = vlog_ref(value);
+   if (vlog_kind(src) == V_PORT_DECL)
+      src = vlog_ref(src);
+
+   if (src == d || vlog_kind(src) != V_NET_DECL)
+      return NULL;
+
+   const type_info_t *dti = vlog_type_info(g, vlog_type(d));
+   const type_info_t *sti = vlog_type_info(g, vlog_type(src));
+   if (dti->size * vlog_size(d) != sti->size * vlog_size(src))
+      return NULL;
+
+   return src;
+}
+
+static bool vlog_lower_net_alias(vlog_gen_t *g, vlog_node_t v, vlog_node_t src,
+                                 tree_t wrap)
+{
+   int hops;
+   mir_value_t src_var = mir_search_object(g->mu, src, &hops);
+   if (mir_is_null(src_var))
+      return false;   // Source not lowered yet
+
+   assert(hops == 0);
+   assert(wrap != NULL);
+
+   mir_type_t t_net_value = mir_int_type(g->mu, 0, 255);
+   mir_type_t t_net_signal = mir_signal_type(g->mu, t_net_value);
+
+   mir_value_t signal = mir_build_load(g->mu, src_var);
+   mir_value_t locus = mir_build_debug_locus(g->mu, tree_to_object(wrap));
+   mir_build_alias_signal(g->mu, signal, locus);
+
+   mir_value_t var = mir_add_var(g->mu, t_net_signal, MIR_NULL_STAMP,
+                                 vlog_ident(v), MIR_VAR_SIGNAL);
+   mir_build_store(g->mu, var, signal);
+
+   mir_put_object(g->mu, v, var);
+   return true;
+}
+
 void vlog_lower_instance(mir_context_t *mc, vlog_node_t body, ident_t parent,
                          tree_t trans)
 {
@@ -3677,6 +3841,32 @@ void vlog_lower_instance(mir_context_t *mc, vlog_node_t body, ident_t parent,
       vlog_lower_port_decl(&g, d);
    }
 
+   const int nstmts = tree_stmts(trans);
+
+   hash_t *aliases = NULL;
+   if (!opt_get_int(OPT_NO_COLLAPSE)) {
+      hash_t *drivers = hash_new(64);
+      vlog_count_drivers(body, drivers);
+
+      aliases = hash_new(16);
+
+      for (int i = 0; i < nstmts; i++) {
+         tree_t wrap = tree_stmt(trans, i);
+         if (tree_kind(wrap) != T_VERILOG)
+            continue;
+
+         vlog_node_t s = tree_vlog(wrap);
+         if (vlog_kind(s) != V_ASSIGN)
+            continue;
+
+         vlog_node_t src = vlog_alias_source(&g, s, drivers);
+         if (src != NULL)
+            hash_put(aliases, vlog_ref(vlog_target(s)), src);
+      }
+
+      hash_free(drivers);
+   }
+
    for (int i = 0, hops; i < vlog_ndecls; i++) {
       vlog_node_t d = vlog_decl(body, i);
 
@@ -3684,10 +3874,10 @@ void vlog_lower_instance(mir_context_t *mc, vlog_node_t body, ident_t parent,
       case V_PORT_DECL:
          break;   // Translated above
       case V_NET_DECL:
-         if (mir_is_null(mir_search_object(mu, d, &hops)))
-            vlog_lower_net_decl(&g, d, hash_get(map, d), resfn);
-         else
+         if (!mir_is_null(mir_search_object(mu, d, &hops)))
             assert(hops == 0); // Port
+         else if (aliases == NULL || hash_get(aliases, d) == NULL)
+            vlog_lower_net_decl(&g, d, hash_get(map, d), resfn);
          break;
       case V_VAR_DECL:
          if (mir_is_null(mir_search_object(mu, d, &hops)))
@@ -3720,9 +3910,35 @@ void vlog_lower_instance(mir_context_t *mc, vlog_node_t body, ident_t parent,
       }
    }
 
+   if (aliases != NULL) {
+      // Collapsed nets may alias other collapsed nets so repeat until
+      // no further progress is made
+      for (bool progress = true; progress; ) {
+         progress = false;
+         for (int i = 0, hops; i < vlog_ndecls; i++) {
+            vlog_node_t d = vlog_decl(body, i);
+            vlog_node_t src = hash_get(aliases, d);
+            if (src == NULL || !mir_is_null(mir_search_object(mu, d, &hops)))
+               continue;
+            else if (vlog_lower_net_alias(&g, d, src, hash_get(map, d)))
+               progress = true;
+         }
+      }
+
+      // Any remaining nets form a cycle and must be lowered normally
+      for (int i = 0, hops; i < vlog_ndecls; i++) {
+         vlog_node_t d = vlog_decl(body, i);
+         if (hash_get(aliases, d) == NULL)
+            continue;
+         else if (mir_is_null(mir_search_object(mu, d, &hops))) {
+            vlog_lower_net_decl(&g, d, hash_get(map, d), resfn);
+            hash_delete(aliases, d);
+         }
+      }
+   }
+
    mir_value_t self = mir_build_context_upref(mu, 0);
 
-   const int nstmts = tree_stmts(trans);
    for (int i = 0; i < nstmts; i++) {
       tree_t wrap = tree_stmt(trans, i);
       if (tree_kind(wrap) != T_VERILOG)
@@ -3731,8 +3947,13 @@ void vlog_lower_instance(mir_context_t *mc, vlog_node_t body, ident_t parent,
       vlog_node_t s = tree_vlog(wrap);
 
       switch (vlog_kind(s)) {
-      case V_FINAL:
       case V_ASSIGN:
+         if (aliases != NULL && vlog_kind(vlog_target(s)) == V_REF
+             && vlog_has_ref(vlog_target(s))
+             && hash_get(aliases, vlog_ref(vlog_target(s))) != NULL)
+            break;   // Collapsed into an alias
+         // Fall-through
+      case V_FINAL:
       case V_INITIAL:
       case V_ALWAYS:
       case V_GATE_INST:
@@ -3776,6 +3997,9 @@ void vlog_lower_instance(mir_context_t *mc, vlog_node_t body, ident_t parent,
 
    hash_free(map);
 
+   if (aliases != NULL)
+      hash_free(aliases);
+
    mir_optimise(mu, MIR_PASS_O1);
    mir_put_unit(mc, mu);
 }
@@ -123,6 +123,23 @@ static token_t lex_identifier(scan_buf_t buf)
    return make_token(tID, buf, (yylval_t){ .span = buf });
 }
 
+static bool is_passthrough_directive(const char *ptr, size_t len)
+{
+   // Directives handled by the parser which are copied to the output
+   static const char *directives[] = {
+      "`timescale", "`default_nettype", "`resetall", "`pragma",
+      "`unconnected_drive", "`nounconnected_drive", "`begin_keywords",
+      "`end_keywords", "`celldefine", "`endcelldefine",
+   };
+
+   for (int i = 0; i < ARRAY_LEN(directives); i++) {
+      if (strlen(directives[i]) == len && strncmp(ptr, directives[i], len) == 0)
+         return true;
+   }
+
+   return false;
+}
+
 static token_t lex_directive(scan_buf_t buf)
 {
    char ch;
@@ -161,25 +178,7 @@ static token_t lex_directive(scan_buf_t buf)
    if (buf.len == 8 && strncmp(buf.ptr, "`include", buf.len) == 0)
       return make_token(tINCLUDE, buf, (yylval_t){});
 
-   if (buf.len == 10 && strncmp(buf.ptr, "`timescale", buf.len) == 0)
-      return make_token(tTEXT, buf, (yylval_t){ .span = buf });
-   if (buf.len == 16 && strncmp(buf.ptr, "`default_nettype", buf.len) == 0)
-      return make_token(tTEXT, buf, (yylval_t){ .span = buf });
-   if (buf.len == 9 && strncmp(buf.ptr, "`resetall", buf.len) == 0)
-      return make_token(tTEXT, buf, (yylval_t){ .span = buf });
-   if (buf.len == 7 && strncmp(buf.ptr, "`pragma", buf.len) == 0)
-      return make_token(tTEXT, buf, (yylval_t){ .span = buf });
-   if (buf.len == 18 && strncmp(buf.ptr, "`unconnected_drive", buf.len) == 0)
-      return make_token(tTEXT, buf, (yylval_t){ .span = buf });
-   if (buf.len == 20 && strncmp(buf.ptr, "`nounconnected_drive", buf.len) == 0)
-      return make_token(tTEXT, buf, (yylval_t){ .span = buf });
-   if (buf.len == 15 && strncmp(buf.ptr, "`begin_keywords", buf.len) == 0)
-      return make_token(tTEXT, buf, (yylval_t){ .span = buf });
-   if (buf.len == 13 && strncmp(buf.ptr, "`end_keywords", buf.len) == 0)
-      return make_token(tTEXT, buf, (yylval_t){ .span = buf });
-   if (buf.len == 11 && strncmp(buf.ptr, "`celldefine", buf.len) == 0)
-      return make_token(tTEXT, buf, (yylval_t){ .span = buf });
-   if (buf.len == 14 && strncmp(buf.ptr, "`endcelldefine", buf.len) == 0)
+   if (is_passthrough_directive(buf.ptr, buf.len))
       return make_token(tTEXT, buf, (yylval_t){ .span = buf });
 
    return make_token(tMACROUSAGE, buf, (yylval_t){ .span = buf });
@@ -1008,3 +1007,26 @@ void vlog_preprocess(text_buf_t *tb, bool precise)
    if (!opt_get_int(OPT_SINGLE_UNIT))
       free_macros();
 }
+
+bool vlog_needs_preprocess(void)
+{
+   // The preprocessor only changes the text following a backtick so if
+   // every backtick starts a directive that is passed through unchanged
+   // the parser can read the input directly
+   scan_buf_t buf = get_input_buffer();
+   const char *end = buf.ptr + buf.cap;
+
+   for (const char *p = buf.ptr; p < end; p++) {
+      if ((p = memchr(p, '`', end - p)) == NULL)
+         return false;
+
+      const char *q = p + 1;
+      while (q < end && (isalnum_iso88591(*q) || *q == '_'))
+         q++;
+
+      if (!is_passthrough_directive(p, q - p))
+         return true;
+   }
+
+   return false;
+}
@@ -26,6 +26,14 @@
 #include <assert.h>
 #include <stdlib.h>
 
+#define UDP_MAX_TABLE_INPUTS 6
+
+// Entries in the combinational UDP lookup table
+#define UDP_OUTPUT_0    0
+#define UDP_OUTPUT_1    1
+#define UDP_OUTPUT_KEEP 2
+#define UDP_OUTPUT_X    3
+
 #define CANNOT_HANDLE(v) do {                                           \
       fatal_at(vlog_loc(v), "cannot handle %s in %s" ,                  \
                vlog_kind_str(vlog_kind(v)), __FUNCTION__);              \
@@ -61,7 +69,7 @@ static mir_value_t vlog_udp_cmp(mir_unit_t *mu, mir_value_t left,
                                             level_map['1']);
          mir_value_t test0 = mir_build_test(mu, eq0);
          mir_value_t test1 = mir_build_test(mu, eq1);
-         return mir_build_and(mu, test0, test1);
+         return mir_build_or(mu, test0, test1);
       }
    case '*':
       should_not_reach_here();
@@ -74,6 +82,213 @@ static mir_value_t vlog_udp_cmp(mir_unit_t *mu, mir_value_t left,
    }
 }
 
+static void vlog_lower_udp_chain(mir_unit_t *mu, vlog_node_t table,
+                                 int ninputs, const mir_value_t *in_regs,
+                                 const mir_value_t *in_nets,
+                                 const mir_value_t level_map[127],
+                                 mir_value_t result_var, mir_block_t start_bb,
+                                 mir_block_t wait_bb)
+{
+   mir_type_t t_offset = mir_offset_type(mu);
+   mir_value_t one = mir_const(mu, t_offset, 1);
+
+   mir_block_t test_bb = mir_get_cursor(mu, NULL);
+
+   const int nentries = vlog_params(table);
+   for (int i = 0; i < nentries; i++) {
+      vlog_node_t entry = vlog_param(table, i);
+      assert(vlog_kind(entry) == V_UDP_ENTRY);
+
+      mir_block_t hit_bb = mir_add_block(mu);
+      mir_value_t and = MIR_NULL_VALUE;
+
+      int pos = 0;
+      for (int j = 0; j < ninputs; j++) {
+         mir_value_t cmp = MIR_NULL_VALUE;
+         vlog_node_t sym = vlog_param(entry, pos++);
+         assert(vlog_kind(sym) == V_UDP_LEVEL);
+
+         const unsigned val = vlog_ival(sym);
+         if (val == '*')
+            cmp = mir_build_event_flag(mu, in_nets[j], one);
+         else if (val != '?')
+            cmp = vlog_udp_cmp(mu, in_regs[j], val, level_map);
+
+         if (mir_is_null(and))
+            and = cmp;
+         else if (!mir_is_null(cmp))
+            and = mir_build_and(mu, and, cmp);
+      }
+
+      if (mir_is_null(and))
+         mir_build_jump(mu, hit_bb);
+      else {
+         test_bb = mir_add_block(mu);
+         mir_build_cond(mu, and, hit_bb, test_bb);
+      }
+
+      mir_set_cursor(mu, hit_bb, MIR_APPEND);
+
+      vlog_node_t sym = vlog_param(entry, pos++);
+      assert(vlog_kind(sym) == V_UDP_LEVEL);
+      assert(pos == vlog_params(entry));
+
+      mir_value_t drive;
+      switch (vlog_ival(sym)) {
+      case '0':
+      case '1':
+      case 'x':
+      case 'X':
+         drive = level_map[vlog_ival(sym)];
+         break;
+      case '-':
+         // No change, skip assignment to output
+         drive = MIR_NULL_VALUE;
+         mir_build_wait(mu, start_bb);
+
+         if (mir_is_null(and))
+            break;
+
+         mir_set_cursor(mu, test_bb, MIR_APPEND);
+         continue;
+      default:
+         CANNOT_HANDLE(entry);
+      }
+
+      mir_build_store(mu, result_var, drive);
+      mir_build_jump(mu, wait_bb);
+
+      if (mir_is_null(and))
+         break;
+
+      mir_set_cursor(mu, test_bb, MIR_APPEND);
+   }
+
+   mir_set_cursor(mu, test_bb, MIR_APPEND);
+
+   if (!mir_block_finished(mu, test_bb)) {
+      mir_build_store(mu, result_var, level_map['x']);
+      mir_build_jump(mu, wait_bb);
+   }
+}
+
+static bool vlog_udp_level_match(unsigned sym, int code)
+{
+   // Code is the unpacked value where 2 is Z and 3 is X
+   switch (sym) {
+   case '0': return code == 0;
+   case '1': return code == 1;
+   case 'x':
+   case 'X': return code == 3;
+   case 'b': return code == 0 || code == 1;
+   case '?': return true;
+   default: should_not_reach_here();
+   }
+}
+
+static bool vlog_udp_can_tabulate(vlog_node_t table, int ninputs)
+{
+   if (ninputs > UDP_MAX_TABLE_INPUTS)
+      return false;
+
+   const int nentries = vlog_params(table);
+   for (int i = 0; i < nentries; i++) {
+      vlog_node_t entry = vlog_param(table, i);
+      for (int j = 0; j < ninputs; j++) {
+         vlog_node_t sym = vlog_param(entry, j);
+         if (vlog_kind(sym) != V_UDP_LEVEL || vlog_ival(sym) == '*')
+            return false;   // Depends on events as well as levels
+      }
+   }
+
+   return true;
+}
+
+static void vlog_lower_udp_lookup(mir_unit_t *mu, vlog_node_t table,
+                                  int ninputs, const mir_value_t *in_regs,
+                                  const mir_value_t level_map[127],
+                                  mir_value_t result_var, mir_block_t start_bb,
+                                  mir_block_t wait_bb)
+{
+   // Precompute the output for every combination of input values and
+   // find it with a single load indexed by the unpacked inputs
+   const int size = 1 << (2 * ninputs);
+   uint8_t *outputs LOCAL = xmalloc(size);
+
+   const int nentries = vlog_params(table);
+   for (int index = 0; index < size; index++) {
+      outputs[index] = UDP_OUTPUT_X;
+
+      for (int i = 0; i < nentries; i++) {
+         vlog_node_t entry = vlog_param(table, i);
+
+         bool match = true;
+         for (int j = 0; match && j < ninputs; j++) {
+            const int code = (index >> (2 * (ninputs - 1 - j))) & 3;
+            match = vlog_udp_level_match(vlog_ival(vlog_param(entry, j)),
+                                         code);
+         }
+
+         if (!match)
+            continue;
+
+         switch (vlog_ival(vlog_param(entry, ninputs))) {
+         case '0': outputs[index] = UDP_OUTPUT_0; break;
+         case '1': outputs[index] = UDP_OUTPUT_1; break;
+         case '-': outputs[index] = UDP_OUTPUT_KEEP; break;
+         default: outputs[index] = UDP_OUTPUT_X; break;
+         }
+         break;
+      }
+   }
+
+   mir_type_t t_offset = mir_offset_type(mu);
+   mir_type_t t_uint8 = mir_int_type(mu, 0, UINT8_MAX);
+
+   mir_value_t *elems LOCAL = xmalloc_array(size, sizeof(mir_value_t));
+   for (int i = 0; i < size; i++)
+      elems[i] = mir_const(mu, t_uint8, outputs[i]);
+
+   mir_type_t t_table = mir_carray_type(mu, size, t_uint8);
+   mir_value_t lookup = mir_const_array(mu, t_table, elems, size);
+   mir_value_t address = mir_build_address_of(mu, lookup);
+   mir_value_t stride = mir_const(mu, t_offset, 4);
+
+   mir_value_t *args LOCAL = xmalloc_array(ninputs, sizeof(mir_value_t));
+   for (int i = 0; i < ninputs; i++)
+      args[i] = mir_build_unpack(mu, in_regs[i], 0, MIR_NULL_VALUE);
+
+   mir_value_t ptr = mir_build_table_ref(mu, address, stride, args, ninputs);
+   mir_value_t output = mir_build_load(mu, ptr);
+
+   mir_block_t blocks[3] = {
+      mir_add_block(mu), mir_add_block(mu), mir_add_block(mu)
+   };
+   mir_block_t x_bb = mir_add_block(mu);
+
+   const mir_value_t cases[3] = {
+      mir_const(mu, t_uint8, UDP_OUTPUT_0),
+      mir_const(mu, t_uint8, UDP_OUTPUT_1),
+      mir_const(mu, t_uint8, UDP_OUTPUT_KEEP),
+   };
+   mir_build_case(mu, output, x_bb, cases, blocks, 3);
+
+   mir_set_cursor(mu, blocks[0], MIR_APPEND);
+   mir_build_store(mu, result_var, level_map['0']);
+   mir_build_jump(mu, wait_bb);
+
+   mir_set_cursor(mu, blocks[1], MIR_APPEND);
+   mir_build_store(mu, result_var, level_map['1']);
+   mir_build_jump(mu, wait_bb);
+
+   mir_set_cursor(mu, blocks[2], MIR_APPEND);
+   mir_build_wait(mu, start_bb);   // No change, skip assignment to output
+
+   mir_set_cursor(mu, x_bb, MIR_APPEND);
+   mir_build_store(mu, result_var, level_map['x']);
+   mir_build_jump(mu, wait_bb);
+}
+
 static void vlog_lower_comb_udp(mir_unit_t *mu, vlog_node_t udp)
 {
    vlog_node_t table = vlog_stmt(udp, 0);
@@ -158,84 +373,12 @@ static void vlog_lower_comb_udp(mir_unit_t *mu, vlog_node_t udp)
       in_nets[i - 1] = nets;
    }
 
-   mir_block_t test_bb = mir_get_cursor(mu, NULL);
-
-   const int nentries = vlog_params(table);
-   for (int i = 0; i < nentries; i++) {
-      vlog_node_t entry = vlog_param(table, i);
-      assert(vlog_kind(entry) == V_UDP_ENTRY);
-
-      mir_block_t hit_bb = mir_add_block(mu);
-      mir_value_t and = MIR_NULL_VALUE;
-
-      int pos = 0;
-      for (int j = 0; j < nports - 1; j++) {
-         mir_value_t cmp = MIR_NULL_VALUE;
-         vlog_node_t sym = vlog_param(entry, pos++);
-         assert(vlog_kind(sym) == V_UDP_LEVEL);
-
-         const unsigned val = vlog_ival(sym);
-         if (val == '*')
-            cmp = mir_build_event_flag(mu, in_nets[j], one);
-         else if (val != '?')
-            cmp = vlog_udp_cmp(mu, in_regs[j], val, level_map);
-
-         if (mir_is_null(and))
-            and = cmp;
-         else if (!mir_is_null(cmp))
-            and = mir_build_and(mu, and, cmp);
-      }
-
-      if (mir_is_null(and))
-         mir_build_jump(mu, hit_bb);
-      else {
-         test_bb = mir_add_block(mu);
-         mir_build_cond(mu, and, hit_bb, test_bb);
-      }
-
-      mir_set_cursor(mu, hit_bb, MIR_APPEND);
-
-      vlog_node_t sym = vlog_param(entry, pos++);
-      assert(vlog_kind(sym) == V_UDP_LEVEL);
-      assert(pos == vlog_params(entry));
-
-      mir_value_t drive;
-      switch (vlog_ival(sym)) {
-      case '0':
-      case '1':
-      case 'x':
-      case 'X':
-         drive = level_map[vlog_ival(sym)];
-         break;
-      case '-':
-         // No change, skip assignment to output
-         drive = MIR_NULL_VALUE;
-         mir_build_wait(mu, start_bb);
-
-         if (mir_is_null(and))
-            break;
-
-         mir_set_cursor(mu, test_bb, MIR_APPEND);
-         continue;
-      default:
-         CANNOT_HANDLE(entry);
-      }
-
-      mir_build_store(mu, result_var, drive);
-      mir_build_jump(mu, wait_bb);
-
-      if (mir_is_null(and))
-         break;
-
-      mir_set_cursor(mu, test_bb, MIR_APPEND);
-   }
-
-   mir_set_cursor(mu, test_bb, MIR_APPEND);
-
-   if (!mir_block_finished(mu, test_bb)) {
-      mir_build_store(mu, result_var, logicX);
-      mir_build_jump(mu, wait_bb);
-   }
+   if (vlog_udp_can_tabulate(table, nports - 1))
+      vlog_lower_udp_lookup(mu, table, nports - 1, in_regs, level_map,
+                            result_var, start_bb, wait_bb);
+   else
+      vlog_lower_udp_chain(mu, table, nports - 1, in_regs, in_nets,
+                           level_map, result_var, start_bb, wait_bb);
 
    mir_set_cursor(mu, wait_bb, MIR_APPEND);
 
@@ -458,8 +458,26 @@ vlog_node_t vlog_longest_static_prefix(vlog_node_t v)
    }
 }
 
+static vlog_node_t vlog_folded_value(vlog_node_t v)
+{
+   // Look through references to parameters with a constant value
+   if (vlog_kind(v) == V_REF && vlog_has_ref(v)) {
+      vlog_node_t decl = vlog_ref(v);
+      if (vlog_kind(decl) == V_LOCALPARAM) {
+         vlog_node_t value = vlog_value(decl);
+         if (vlog_kind(value) == V_NUMBER)
+            return value;
+      }
+   }
+
+   return v;
+}
+
 bool vlog_equal_node(vlog_node_t a, vlog_node_t b)
 {
+   a = vlog_folded_value(a);
+   b = vlog_folded_value(b);
+
    if (a == b)
       return true;
 
@@ -508,6 +526,8 @@ bool vlog_equal_node(vlog_node_t a, vlog_node_t b)
 
 uint32_t vlog_hash_node(vlog_node_t v)
 {
+   v = vlog_folded_value(v);
+
    switch (vlog_kind(v)) {
    case V_NUMBER:
       return number_hash(vlog_number(v));
@@ -40,6 +40,7 @@
 
 typedef struct {
    PLI_INT32 type;
+   uint32_t  handle;
    loc_t     loc;
 } c_vpiObject;
 
@@ -105,6 +106,7 @@ typedef struct {
    c_tfCall    tfcall;
    c_callback *callback;
    vpiHandle   handle;
+   void       *userdata;
 } c_sysTfCall;
 
 typedef struct {
@@ -146,6 +148,7 @@ typedef struct {
    c_refcounted   refcounted;
    vpiObjectList *list;
    uint32_t       pos;
+   PLI_INT32      filter;
 } c_iterator;
 
 DEF_CLASS(iterator, vpiIterator, refcounted.object);
@@ -198,8 +201,9 @@ typedef enum {
 
 typedef struct {
    c_vpiObject  *obj;
-   handle_kind_t kind;
    uint32_t      generation;
+   uint32_t      kind : 1;
+   uint32_t      refs : 31;
 } handle_slot_t;
 
 STATIC_ASSERT(sizeof(handle_slot_t) <= 16);
@@ -212,7 +216,7 @@ typedef struct _vpi_context {
    jit_t         *jit;
    handle_slot_t *handles;
    unsigned       num_handles;
-   unsigned       free_hint;
+   A(uint32_t)    freelist;
    vpiHandleList  systasks;
    vpiObjectList  syscalls;
    c_sysTfCall   *call;
@@ -266,37 +270,49 @@ static vpiHandle handle_for(c_vpiObject *obj, handle_kind_t kind)
 
    vpi_context_t *c = vpi_context();
 
-   uint32_t index = c->free_hint;
-   if (index >= c->num_handles || c->handles[index].obj != NULL) {
-      for (index = 0; index < c->num_handles; index++) {
-         if (c->handles[index].obj == NULL
-             && c->handles[index].generation < HANDLE_MAX_INDEX)
-            break;
-      }
-   }
+   c_refcounted *rc = is_refcounted(obj);
 
-   if (unlikely(index > HANDLE_MAX_INDEX)) {
-      vpi_error(vpiSystem, NULL, "too many active handles");
-      return NULL;
+   // User handles to the same object are shared so that repeatedly
+   // looking up or scanning an object does not allocate a new slot
+   if (kind == HANDLE_USER && rc == NULL && obj->handle != 0) {
+      const uint32_t index = obj->handle - 1;
+      handle_slot_t *slot = &(c->handles[index]);
+      assert(slot->obj == obj);
+      assert(slot->kind == HANDLE_USER);
+      slot->refs++;
+      return encode_handle(slot, index);
    }
-   else if (index == c->num_handles) {
-      const int new_size = MAX(c->num_handles * 2, 128);
+
+   if (c->freelist.count == 0) {
+      const unsigned old_size = c->num_handles;
+      if (unlikely(old_size > HANDLE_MAX_INDEX)) {
+         vpi_error(vpiSystem, NULL, "too many active handles");
+         return NULL;
+      }
+
+      const unsigned new_size = MAX(c->num_handles * 2, 128);
       c->handles = xrealloc_array(c->handles, new_size, sizeof(handle_slot_t));
       c->num_handles = new_size;
 
-      for (int i = index; i < new_size; i++) {
+      ARESERVE(c->freelist, new_size - old_size);
+
+      for (unsigned i = new_size; i-- > old_size;) {
          c->handles[i].obj = NULL;
          c->handles[i].generation = 1;
+         APUSH(c->freelist, i);
       }
    }
 
+   const uint32_t index = APOP(c->freelist);
+
    handle_slot_t *slot = &(c->handles[index]);
    slot->obj  = obj;
    slot->kind = kind;
+   slot->refs = 1;
 
-   c->free_hint = index + 1;
+   if (kind == HANDLE_USER && rc == NULL)
+      obj->handle = index + 1;
 
-   c_refcounted *rc = is_refcounted(obj);
    if (rc != NULL)
       rc->refcount++;
 
@@ -319,11 +335,21 @@ static void drop_handle(vpi_context_t *c, vpiHandle handle)
    if (slot == NULL)
       return;
 
+   assert(slot->refs > 0);
+   if (--(slot->refs) > 0)
+      return;
+
    c_vpiObject *obj = slot->obj;
    slot->obj = NULL;
-   slot->generation++;
 
-   c->free_hint = slot - c->handles;
+   if (obj->handle != 0) {
+      assert(obj->handle == slot - c->handles + 1);
+      obj->handle = 0;
+   }
+
+   // Retire the slot rather than reuse a generation number
+   if (++(slot->generation) < HANDLE_MAX_INDEX)
+      APUSH(c->freelist, slot - c->handles);
 
    c_refcounted *rc = is_refcounted(obj);
    if (rc != NULL) {
@@ -461,11 +487,10 @@ static void *recycle_object(size_t size, PLI_INT32 type)
 {
    vpi_context_t *c = vpi_context();
 
-   for (int i = 0; i < c->recycle.count; i++) {
+   for (int i = c->recycle.count - 1; i >= 0; i--) {
       c_vpiObject *obj = c->recycle.items[i];
       if (obj->type == type) {
-         for (int j = i; j < c->recycle.count - 1; j++)
-            c->recycle.items[j] = c->recycle.items[j + 1];
+         c->recycle.items[i] = ATOP(c->recycle);
          ATRIM(c->recycle, c->recycle.count - 1);
 
          memset(obj, '\0', size);
@@ -739,6 +764,21 @@ static bool init_iterator(c_iterator *it, PLI_INT32 type, c_vpiObject *obj)
       }
    }
 
+   c_abstractScope *scope = is_abstractScope(obj);
+   if (scope != NULL) {
+      switch (type) {
+      case vpiNet:
+      case vpiReg:
+      case vpiRegArray:
+      case vpiParameter:
+         it->list = expand_lazy_list(&(scope->object), &(scope->decls));
+         it->filter = type;
+         return true;
+      default:
+         return false;
+      }
+   }
+
    return false;
 }
 
@@ -976,6 +1016,26 @@ vpiHandle vpi_handle(PLI_INT32 type, vpiHandle refHandle)
          else
             return NULL;
       }
+
+      return NULL;
+   }
+
+   c_vpiObject *obj = from_handle(refHandle);
+   if (obj == NULL)
+      return NULL;
+
+   switch (type) {
+   case vpiScope:
+      {
+         c_tfCall *call = is_tfCall(obj);
+         if (call != NULL && call->scope != NULL)
+            return user_handle_for(&(call->scope->object));
+
+         c_abstractDecl *decl = is_abstractDecl(obj);
+         if (decl != NULL && decl->scope != NULL)
+            return user_handle_for(&(decl->scope->object));
+      }
+      break;
    }
 
    return NULL;
@@ -1058,8 +1118,11 @@ vpiHandle vpi_scan(vpiHandle iterator)
    if (it == NULL)
       return NULL;
 
-   if (it->pos < it->list->count)
-      return user_handle_for(it->list->items[it->pos++]);
+   while (it->pos < it->list->count) {
+      c_vpiObject *next = it->list->items[it->pos++];
+      if (it->filter == 0 || next->type == it->filter)
+         return user_handle_for(next);
+   }
 
    drop_handle(vpi_context(), iterator);
    return NULL;
@@ -1408,6 +1471,70 @@ vpiHandle vpi_put_value(vpiHandle handle, p_vpi_value value_p,
    return NULL;
 }
 
+DLLEXPORT
+void *vpi_get_userdata(vpiHandle obj)
+{
+   vpi_clear_error();
+
+   VPI_TRACE("obj=%s", handle_pp(obj));
+
+   c_vpiObject *o = from_handle(obj);
+   if (o == NULL)
+      return NULL;
+
+   c_sysTfCall *call = is_sysTfCall(o);
+   if (call == NULL) {
+      vpi_error(vpiError, &(o->loc), "%s is not a system task or function "
+                "call", handle_pp(obj));
+      return NULL;
+   }
+
+   return call->userdata;
+}
+
+DLLEXPORT
+PLI_INT32 vpi_put_userdata(vpiHandle obj, void *userdata)
+{
+   vpi_clear_error();
+
+   VPI_TRACE("obj=%s userdata=%p", handle_pp(obj), userdata);
+
+   c_vpiObject *o = from_handle(obj);
+   if (o == NULL)
+      return 0;
+
+   c_sysTfCall *call = is_sysTfCall(o);
+   if (call == NULL) {
+      vpi_error(vpiError, &(o->loc), "%s is not a system task or function "
+                "call", handle_pp(obj));
+      return 0;
+   }
+
+   call->userdata = userdata;
+   return 1;
+}
+
+vpiHandle vpi_arg_handle(vpiHandle call, int index)
+{
+   c_vpiObject *obj = from_handle(call);
+   if (obj == NULL)
+      return NULL;
+
+   c_sysTfCall *tf = is_sysTfCall(obj);
+   assert(tf != NULL);
+
+   if (index >= tf->tfcall.args.count)
+      return NULL;
+
+   // Owned by the system so may be kept between calls
+   return internal_handle_for(tf->tfcall.args.items[index]);
+}
+
+void *vpi_pool_alloc(size_t size)
+{
+   return pool_malloc(vpi_context()->pool, size);
+}
+
 vpi_context_t *vpi_context_new(void)
 {
    assert(global_context == NULL);
@@ -1507,6 +1634,7 @@ void vpi_context_free(vpi_context_t *c)
    ACLEAR(c->syscalls);
    ACLEAR(c->systasks);
    ACLEAR(c->recycle);
+   ACLEAR(c->freelist);
 
 #ifdef DEBUG
    size_t alloc, npages;
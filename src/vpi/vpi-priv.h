@@ -38,5 +38,7 @@ void vpi_format_number(int size, bool is_signed, const uint64_t *abits,
                        const uint64_t *bbits, s_vpi_value *val,
                        text_buf_t *tb);
 void vpi_format_real(double value, s_vpi_value *val, text_buf_t *tb);
+vpiHandle vpi_arg_handle(vpiHandle call, int index);
+void *vpi_pool_alloc(size_t size);
 
 #endif  // _VPI_PRIV_H
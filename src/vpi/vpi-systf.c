@@ -16,6 +16,7 @@
 //
 
 #include "util.h"
+#include "array.h"
 #include "diag.h"
 #include "jit/jit.h"
 #include "rt/fileio.h"
@@ -39,12 +40,35 @@ typedef struct {
    bool        eof;
 } scan_src_t;
 
-static void format_string(FILE *out, vpiHandle it, int fwidth)
-{
-   vpiHandle arg = vpi_scan(it);
-   if (arg == NULL)
-      return;
+typedef enum {
+   FMT_TEXT,
+   FMT_SPACE,
+   FMT_STRING,
+   FMT_RADIX,
+   FMT_CHAR,
+   FMT_UNKNOWN,
+} format_kind_t;
+
+typedef struct {
+   format_kind_t  kind;
+   char           radix;
+   int            fwidth;
+   int            precision;
+   vpiHandle      arg;
+   const char    *text;
+   size_t         len;
+} format_op_t;
 
+typedef A(format_op_t) format_op_list_t;
+
+typedef struct {
+   vpiHandle   fd;
+   unsigned    count;
+   format_op_t ops[0];
+} format_prog_t;
+
+static void format_string(FILE *out, vpiHandle arg, int fwidth)
+{
    s_vpi_value argval = { .format = vpiStringVal };
    vpi_get_value(arg, &argval);
 
@@ -52,8 +76,6 @@ static void format_string(FILE *out, vpiHandle it, int fwidth)
       fprintf(out, "%*s", fwidth, argval.value.str);
    else
       fputs(argval.value.str, out);
-
-   vpi_release_handle(arg);
 }
 
 static int calc_dec_size(int nr_bits, bool is_signed)
@@ -151,23 +173,8 @@ static void format_radix(FILE *out, vpiHandle arg, char radix, int fwidth,
    }
 }
 
-static void format_number(FILE *out, vpiHandle it, char radix, int fwidth,
-                          int precision)
-{
-   vpiHandle arg = vpi_scan(it);
-   if (arg == NULL)
-      return;
-
-   format_radix(out, arg, radix, fwidth, precision);
-   vpi_release_handle(arg);
-}
-
-static void format_char(FILE *out, vpiHandle it, int fwidth)
+static void format_char(FILE *out, vpiHandle arg, int fwidth)
 {
-   vpiHandle arg = vpi_scan(it);
-   if (arg == NULL)
-      return;
-
    s_vpi_value argval = { .format = vpiDecStrVal };
    vpi_get_value(arg, &argval);
 
@@ -178,34 +185,41 @@ static void format_char(FILE *out, vpiHandle it, int fwidth)
       fprintf(out, "%*c", fwidth, ch);
    else
       fputc(ch, out);
+}
 
-   vpi_release_handle(arg);
+static void add_text(format_op_list_t *ops, const char *text, size_t len)
+{
+   char *copy = vpi_pool_alloc(len);
+   memcpy(copy, text, len);
+
+   const format_op_t op = { .kind = FMT_TEXT, .text = copy, .len = len };
+   APUSH(*ops, op);
 }
 
-static void interpret_format(FILE *out, const char *fmt, vpiHandle it)
+static int compile_format(format_op_list_t *ops, const char *fmt,
+                          vpiHandle call, int argpos)
 {
    const char *start = fmt, *p = fmt;
 
    for (; *p; p++) {
       if (*p == '%') {
          if (start < p)
-            fwrite(start, 1, p - start, out);
+            add_text(ops, start, p - start);
 
          p++;   // Skip over '%'
 
-         int fwidth = -1;
+         format_op_t op = { .fwidth = -1, .precision = -1 };
          if (isdigit_iso88591(*p))
-            fwidth = strtol(p, (char **)&p, 10);
+            op.fwidth = strtol(p, (char **)&p, 10);
 
-         int precision = -1;
          if (*p == '.') {
             p++;
-            precision = strtol(p, (char **)&p, 10);
+            op.precision = strtol(p, (char **)&p, 10);
          }
 
          switch (*p) {
          case 's':
-            format_string(out, it, fwidth);
+            op.kind = FMT_STRING;
             break;
          case 'd':
          case 'b':
@@ -213,16 +227,30 @@ static void interpret_format(FILE *out, const char *fmt, vpiHandle it)
          case 'h':
          case 't':
          case 'f':
-            format_number(out, it, *p, fwidth, precision);
+            op.kind = FMT_RADIX;
+            op.radix = *p;
             break;
          case 'c':
-            format_char(out, it, fwidth);
+            op.kind = FMT_CHAR;
             break;
          case '%':
-            fputc('%', out);
-            break;
+            add_text(ops, "%", 1);
+            start = p + 1;
+            continue;
+         case '\0':
+            return argpos;
          default:
-            jit_msg(NULL, DIAG_WARN, "unknown format specifier '%c'", *p);
+            op.kind = FMT_UNKNOWN;
+            op.radix = *p;
+            APUSH(*ops, op);
+            start = p + 1;
+            continue;
+         }
+
+         // Specifiers without a matching argument print nothing
+         if ((op.arg = vpi_arg_handle(call, argpos)) != NULL) {
+            APUSH(*ops, op);
+            argpos++;
          }
 
          start = p + 1;
@@ -230,34 +258,100 @@ static void interpret_format(FILE *out, const char *fmt, vpiHandle it)
    }
 
    if (start < p)
-      fwrite(start, 1, p - start, out);
+      add_text(ops, start, p - start);
+
+   return argpos;
 }
 
-static void verilog_printf(FILE *out, char default_radix, vpiHandle it)
+static format_prog_t *compile_printf(vpiHandle call, bool to_file,
+                                     char default_radix)
 {
-   vpiHandle arg = vpi_scan(it);
-   while (arg != NULL) {
+   format_op_list_t ops = AINIT;
+
+   vpiHandle arg;
+   for (int pos = to_file ? 1 : 0; (arg = vpi_arg_handle(call, pos)); ) {
       const bool is_null = vpi_get(vpiType, arg) == vpiOperation
          && vpi_get(vpiOpType, arg) == vpiNullOp;
       const bool has_format =
          vpi_get(vpiType, arg) == vpiConstant
          && vpi_get(vpiConstType, arg) == vpiStringConst;
 
-      if (is_null)
-         fputc(' ', out);
+      pos++;
+
+      if (is_null) {
+         const format_op_t op = { .kind = FMT_SPACE };
+         APUSH(ops, op);
+      }
       else if (has_format) {
          s_vpi_value argval = { .format = vpiStringVal };
          vpi_get_value(arg, &argval);
 
-         char *copy = xstrdup(argval.value.str);
-         interpret_format(out, copy, it);
-         free(copy);
+         char *copy LOCAL = xstrdup(argval.value.str);
+         pos = compile_format(&ops, copy, call, pos);
       }
-      else
-         format_radix(out, arg, default_radix, -1, -1);
+      else {
+         const format_op_t op = {
+            .kind = FMT_RADIX,
+            .radix = default_radix,
+            .fwidth = -1,
+            .precision = -1,
+            .arg = arg,
+         };
+         APUSH(ops, op);
+      }
+   }
 
-      vpi_release_handle(arg);
-      arg = vpi_scan(it);
+   format_prog_t *prog = vpi_pool_alloc(
+      sizeof(format_prog_t) + ops.count * sizeof(format_op_t));
+   prog->fd    = to_file ? vpi_arg_handle(call, 0) : NULL;
+   prog->count = ops.count;
+   memcpy(prog->ops, ops.items, ops.count * sizeof(format_op_t));
+
+   ACLEAR(ops);
+   return prog;
+}
+
+static const format_prog_t *get_printf(vpiHandle call, bool to_file,
+                                       char default_radix)
+{
+   // The arguments and format strings of a call site never change so
+   // they are decoded once on the first call and saved with the call
+   format_prog_t *prog = vpi_get_userdata(call);
+   if (prog == NULL) {
+      prog = compile_printf(call, to_file, default_radix);
+      vpi_put_userdata(call, prog);
+   }
+
+   return prog;
+}
+
+static void verilog_printf(FILE *out, const format_prog_t *prog)
+{
+   if (out == stdout || out == stderr)
+      diag_async_flush();   // Keep ordering with queued reports
+
+   for (unsigned i = 0; i < prog->count; i++) {
+      const format_op_t *op = &(prog->ops[i]);
+      switch (op->kind) {
+      case FMT_TEXT:
+         fwrite(op->text, 1, op->len, out);
+         break;
+      case FMT_SPACE:
+         fputc(' ', out);
+         break;
+      case FMT_STRING:
+         format_string(out, op->arg, op->fwidth);
+         break;
+      case FMT_RADIX:
+         format_radix(out, op->arg, op->radix, op->fwidth, op->precision);
+         break;
+      case FMT_CHAR:
+         format_char(out, op->arg, op->fwidth);
+         break;
+      case FMT_UNKNOWN:
+         jit_msg(NULL, DIAG_WARN, "unknown format specifier '%c'", op->radix);
+         break;
+      }
    }
 }
 
@@ -266,10 +360,10 @@ static PLI_INT32 display_tf(PLI_BYTE8 *userdata)
    vpiHandle call = vpi_handle(vpiSysTfCall, NULL);
    assert(call != NULL);
 
-   vpiHandle it = vpi_iterate(vpiArgument, call);
-
-   verilog_printf(stdout, *(char *)userdata, it);
+   verilog_printf(stdout, get_printf(call, false, *(char *)userdata));
    printf("\n");
+
+   vpi_release_handle(call);
    return 0;
 }
 
@@ -278,9 +372,9 @@ static PLI_INT32 write_tf(PLI_BYTE8 *userdata)
    vpiHandle call = vpi_handle(vpiSysTfCall, NULL);
    assert(call != NULL);
 
-   vpiHandle it = vpi_iterate(vpiArgument, call);
+   verilog_printf(stdout, get_printf(call, false, *(char *)userdata));
 
-   verilog_printf(stdout, *(char *)userdata, it);
+   vpi_release_handle(call);
    return 0;
 }
 
@@ -443,17 +537,14 @@ static PLI_INT32 fdisplay_tf(PLI_BYTE8 *userdata)
    vpiHandle call = vpi_handle(vpiSysTfCall, NULL);
    assert(call != NULL);
 
-   vpiHandle argv = vpi_iterate(vpiArgument, call);
-   vpiHandle fd_arg = vpi_scan(argv);
-   if (fd_arg != NULL) {
-      FILE *out = get_file_stream(fd_arg);
-      verilog_printf(out, fmt[0], argv);
+   const format_prog_t *prog = get_printf(call, true, fmt[0]);
+   if (prog->fd != NULL) {
+      FILE *out = get_file_stream(prog->fd);
+      verilog_printf(out, prog);
       if (newline)
          fputc('\n', out);
-      vpi_release_handle(fd_arg);
    }
 
-   vpi_release_handle(argv);
    vpi_release_handle(call);
    return 0;
 }
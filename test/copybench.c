@@ -67,6 +67,52 @@ static inline bool cmp_bytes(const void *a, const void *b, size_t size)
       return memcmp(a, b, size) == 0;
 }
 
+static inline void copy_overlap(void *dst, const void *src, size_t size)
+{
+   // Same sequence as the x86 JIT backend for small constant sizes:
+   // two possibly overlapping loads followed by two stores
+   if (size >= 8 && size <= 16) {
+      uint64_t lo, hi;
+      memcpy(&lo, src, 8);
+      memcpy(&hi, src + size - 8, 8);
+      memcpy(dst + size - 8, &hi, 8);
+      memcpy(dst, &lo, 8);
+   }
+   else if (size >= 4 && size < 8) {
+      uint32_t lo, hi;
+      memcpy(&lo, src, 4);
+      memcpy(&hi, src + size - 4, 4);
+      memcpy(dst + size - 4, &hi, 4);
+      memcpy(dst, &lo, 4);
+   }
+   else if (size < 4) {
+      for (; size > 0; size--, dst++, src++)
+         *(uint8_t *)dst = *(const uint8_t *)src;
+   }
+   else
+      memmove(dst, src, size);
+}
+
+#ifdef __x86_64__
+#include <x86intrin.h>
+
+__attribute__((target("avx2")))
+static bool cmp_bytes_avx2(const void *a, const void *b, size_t size)
+{
+   for (; size > 31; size -= 32, a += 32, b += 32) {
+      __m256i left  = _mm256_loadu_si256((const __m256i *)a);
+      __m256i right = _mm256_loadu_si256((const __m256i *)b);
+      __m256i xor   = _mm256_xor_si256(left, right);
+      if (!_mm256_testz_si256(xor, xor))
+         return false;
+   }
+
+   return cmp_bytes(a, b, size);
+}
+#else
+#define cmp_bytes_avx2 cmp_bytes
+#endif
+
 __attribute__((noinline))
 uint64_t get_timestamp_ns(void)
 {
@@ -100,6 +146,17 @@ static void bench_copy(void *dst, const void *src, int size)
 
       printf("%-7.1f ", (double)(end - start) / ITERS);
    }
+
+   {
+      const uint64_t start = get_timestamp_ns();
+
+      for (int i = 0; i < ITERS; i++)
+         copy_overlap(dst, src, size);
+
+      const uint64_t end = get_timestamp_ns();
+
+      printf("%-7.1f ", (double)(end - start) / ITERS);
+   }
 }
 
 __attribute__((noinline))
@@ -148,6 +205,27 @@ static int bench_cmp(uint8_t *a, uint8_t *b, int size)
       printf("%-7.1f ", (double)(end - start) / ITERS);
    }
 
+   if (__builtin_cpu_supports("avx2")) {
+      const uint64_t start = get_timestamp_ns();
+
+      for (int i = 0; i < ITERS/2; i++) {
+         a[ITERS%size] = 0;
+         sum += cmp_bytes_avx2(a, b, size) == 0;
+      }
+
+      for (int i = 0; i < ITERS/2; i++) {
+         a[ITERS%size] = 1;
+         sum += cmp_bytes_avx2(a, b, size) == 0;
+         a[ITERS%size] = 0;
+      }
+
+      const uint64_t end = get_timestamp_ns();
+
+      printf("%-7.1f ", (double)(end - start) / ITERS);
+   }
+   else
+      printf("-       ");
+
    printf("   (%d)", sum);
    return sum;
 }
@@ -159,7 +237,7 @@ int main(int argc, char **argv)
       50, 100, 200, 1000, 2048, 3000, 10000
    };
 
-   printf("SIZE   MEMCPY  COPY_BYTES  MEMCMP  CMP_BYTES\n");
+   printf("SIZE   MEMCPY  COPY    OVERLAP     MEMCMP  CMP     AVX2\n");
 
    for (unsigned i = 0; i < sizeof(sizes)/sizeof(int); i++) {
       void *src = malloc(sizes[i]);
@@ -56,6 +56,8 @@ typedef A(result_t) result_array_t;
 const char copy_string[] = "";
 const char version_string[] = "";
 
+static bool hw_counters = false;
+
 static double mean(double *arr, int len)
 {
    double r = 0.0;
@@ -72,6 +74,20 @@ static void print_result(double ops_sec, double usec_op)
       printf("%.1f ops/s; %.1f us/op\n", ops_sec, usec_op);
 }
 
+static void print_counters(const nvc_hwcount_t *start,
+                           const nvc_hwcount_t *end, uint64_t iters)
+{
+   const uint64_t cycles = end->cycles - start->cycles;
+   const uint64_t insns = end->instructions - start->instructions;
+
+   printf("Counters:    %.1f cycles/op; %.1f insns/op; %.2f IPC; "
+          "%.2f branch-misses/op; %.2f cache-misses/op\n",
+          (double)cycles / iters, (double)insns / iters,
+          cycles ? (double)insns / cycles : 0.0,
+          (double)(end->branch_misses - start->branch_misses) / iters,
+          (double)(end->cache_misses - start->cache_misses) / iters);
+}
+
 static const result_t *find_baseline_result(const result_array_t *results,
                                             const result_t *ref)
 {
@@ -211,10 +227,11 @@ static result_t run_benchmark(tree_t pack, tree_t proc, unit_registry_t *ur,
 
    jit_t *j = jit_new(ur, mc);
 
-#if defined HAVE_LLVM && 1
+#ifdef HAVE_LLVM
    jit_register_llvm_plugin(j);
-#elif defined ARCH_X86_64 && 0
-   jit_register_native_plugin(j);
+#endif
+#if defined ARCH_X86_64 || defined ARCH_ARM64
+   jit_register_native_plugin(j);   // Must be registered last
 #endif
 
    jit_handle_t hpack = jit_compile(j, tree_ident(pack));
@@ -225,6 +242,8 @@ static result_t run_benchmark(tree_t pack, tree_t proc, unit_registry_t *ur,
       fatal("cannot compile unit %s", istr(name));
 
    double ops_sec[ITERATIONS + 1], usec_op[ITERATIONS + 1];
+   nvc_hwcount_t hw_start = {}, hw_end = {};
+   uint64_t hw_iters = 0;
 
    tlab_t *tlab = tlab_acquire(jit_get_mspace(j));
 
@@ -235,6 +254,10 @@ static result_t run_benchmark(tree_t pack, tree_t proc, unit_registry_t *ur,
          printf("Iteration %d: ", trial);
       fflush(stdout);
 
+      // Warmup iterations are excluded from the hardware counts
+      if (trial == 1 && hw_counters)
+         nvc_hwcount(&hw_start);
+
       const uint64_t start = get_timestamp_us();
       uint64_t now, iters = 0;
       for (; (now = get_timestamp_us()) < start + 1000000; iters++) {
@@ -252,8 +275,14 @@ static result_t run_benchmark(tree_t pack, tree_t proc, unit_registry_t *ur,
 
       print_result(ops_sec[trial], usec_op[trial]);
       fflush(stdout);
+
+      if (trial > 0)
+         hw_iters += iters;
    }
 
+   if (hw_counters && nvc_hwcount(&hw_end))
+      print_counters(&hw_start, &hw_end, hw_iters);
+
    tlab_release(tlab);
 
    jit_free(j);
@@ -337,6 +366,7 @@ static void usage(void)
    printf("Usage: jitperf [OPTION]... [FILE]...\n"
           "\n"
           "     --baseline\t\t Save current results as baseline\n"
+          "     --counters\t\t Report hardware performance counters\n"
           " -f PATTERN\t\t Only run tests matching PATTERN\n"
           " -L PATH\t\tAdd PATH to library search paths\n"
           "\n");
@@ -366,6 +396,7 @@ int main(int argc, char **argv)
 
    static struct option long_options[] = {
       { "baseline", no_argument, 0, 'b' },
+      { "counters", no_argument, 0, 'c' },
       { "std", required_argument, 0, 's' },
       { 0, 0, 0, 0 }
    };
@@ -385,6 +416,13 @@ int main(int argc, char **argv)
       case 'b':
          write_baseline_file = true;
          break;
+      case 'c':
+         {
+            nvc_hwcount_t dummy;
+            if (!(hw_counters = nvc_hwcount(&dummy)))
+               warnf("hardware performance counters are not available");
+         }
+         break;
       case 'L':
          lib_add_search_path(optarg);
          break;
@@ -399,6 +437,7 @@ int main(int argc, char **argv)
          break;
       case 'i':
          opt_set_int(OPT_JIT_THRESHOLD, 0);
+         opt_set_int(OPT_NATIVE_THRESHOLD, 0);
          break;
       default:
          if (optopt == 0)
@@ -4,6 +4,7 @@ end entity;
 architecture test of transfer1 is
     signal a, b, c : integer;
     signal d, e, f : bit_vector(1 to 3);
+    signal g       : bit;
 begin
 
     p1: a <= b;
@@ -17,6 +18,8 @@ begin
 
     p4: d(1) <= reject 2 ns inertial e(2) after 5 ns;
 
+    p5: g <= not g after 5 ns;
+
     issue765: block is
         type a_rec is record
             b : bit_vector(1 downto 0);
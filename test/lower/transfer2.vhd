@@ -0,0 +1,13 @@
+entity transfer2 is
+end entity;
+
+architecture test of transfer2 is
+    signal s : bit;
+begin
+
+    p1: process (s) is
+    begin
+        assert s'stable(1 ns) or s'delayed(2 ns) = '1';
+    end process;
+
+end architecture;
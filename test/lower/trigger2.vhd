@@ -0,0 +1,15 @@
+entity trigger2 is
+end entity;
+
+architecture test of trigger2 is
+    signal clk, x : bit;
+begin
+
+    p1: process (clk) is
+    begin
+        if falling_edge(clk) then
+            x <= not x;
+        end if;
+    end process;
+
+end architecture;
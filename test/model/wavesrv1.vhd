@@ -0,0 +1,10 @@
+entity wavesrv1 is
+end entity;
+
+architecture test of wavesrv1 is
+    signal clk : bit := '0';
+begin
+
+    clk <= not clk after 1 ns;
+
+end architecture;
@@ -0,0 +1,570 @@
+//
+//  Copyright (C) 2026  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "hash.h"
+#include "ident.h"
+#include "option.h"
+#include "rt/copy.h"
+#include "rt/heap.h"
+#include "rt/mspace.h"
+#include "thread.h"
+
+#include <assert.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char copy_string[] = "";
+const char version_string[] = "";
+
+#define MAX_SAMPLES  64
+#define MAX_THREADS  64
+#define HEAP_SIZE    65536
+#define CHASH_KEYS   65536
+
+typedef uint64_t (*bench_fn_t)(int iters, int arg);
+
+typedef struct {
+   const char *name;
+   bench_fn_t  fn;
+   int         iters;
+   int         arg;
+} bench_case_t;
+
+typedef struct {
+   double mean;
+   double ci;
+} bench_result_t;
+
+typedef struct {
+   nvc_thread_t *thread;
+   int           iters;
+   int           nth;
+   uint64_t      sum;
+} __attribute__((aligned(64))) worker_t;
+
+static heap_t  *bench_heap;
+static chash_t *bench_chash;
+static int      bench_threads;
+static volatile uint64_t sink;
+
+static inline uint32_t fast_rand(uint32_t *state)
+{
+   uint32_t x = *state;
+   x ^= (x << 13);
+   x ^= (x >> 17);
+   x ^= (x << 5);
+   return (*state = x);
+}
+
+static const void *chash_key(int n)
+{
+   return (const void *)(uintptr_t)((n + 1) << 4);
+}
+
+static uint64_t bench_heap_insert(int iters, int arg)
+{
+   heap_t *h = heap_new(HEAP_SIZE);
+   uint32_t rng = 12345;
+
+   const uint64_t start = get_timestamp_ns();
+
+   for (int i = 0; i < iters; i++)
+      heap_insert(h, fast_rand(&rng), NULL);
+
+   const uint64_t elapsed = get_timestamp_ns() - start;
+
+   heap_free(h);
+   return elapsed;
+}
+
+static uint64_t bench_heap_extract_min(int iters, int arg)
+{
+   heap_t *h = heap_new(HEAP_SIZE);
+   uint32_t rng = 12345;
+
+   for (int i = 0; i < iters; i++)
+      heap_insert(h, fast_rand(&rng), (void *)(uintptr_t)i);
+
+   const uint64_t start = get_timestamp_ns();
+
+   uintptr_t sum = 0;
+   for (int i = 0; i < iters; i++)
+      sum += (uintptr_t)heap_extract_min(h);
+
+   const uint64_t elapsed = get_timestamp_ns() - start;
+
+   sink += sum;
+   heap_free(h);
+   return elapsed;
+}
+
+static uint64_t bench_heap_churn(int iters, int arg)
+{
+   // Steady state behaviour of the event queue where each extracted
+   // event schedules a new one slightly later
+   heap_t *h = bench_heap ?: (bench_heap = heap_new(HEAP_SIZE));
+   uint32_t rng = 12345;
+
+   while (heap_size(h) < arg)
+      heap_insert(h, fast_rand(&rng) & 0xffff, NULL);
+
+   const uint64_t start = get_timestamp_ns();
+
+   for (int i = 0; i < iters; i++) {
+      const uint64_t key = heap_min_key(h);
+      (void)heap_extract_min(h);
+      heap_insert(h, key + (fast_rand(&rng) & 0xff), NULL);
+   }
+
+   return get_timestamp_ns() - start;
+}
+
+static uint64_t bench_cmp_bytes(int iters, int arg)
+{
+   uint8_t *a = xcalloc(arg);
+   uint8_t *b = xcalloc(arg);
+
+   const uint64_t start = get_timestamp_ns();
+
+   // Half the comparisons differ in the last byte
+   int sum = 0;
+   for (int i = 0; i < iters; i++) {
+      a[arg - 1] = i & 1;
+      sum += cmp_bytes(a, b, arg);
+   }
+
+   const uint64_t elapsed = get_timestamp_ns() - start;
+
+   sink += sum;
+   free(a);
+   free(b);
+   return elapsed;
+}
+
+static uint64_t bench_copy2(int iters, int arg)
+{
+   uint8_t *src = xcalloc(arg);
+   uint8_t *d1 = xcalloc(arg);
+   uint8_t *d2 = xcalloc(arg);
+
+   const uint64_t start = get_timestamp_ns();
+
+   for (int i = 0; i < iters; i++) {
+      src[0] = i;
+      copy2(d1, d2, src, arg);
+   }
+
+   const uint64_t elapsed = get_timestamp_ns() - start;
+
+   sink += d1[0] + d2[0];
+   free(src);
+   free(d1);
+   free(d2);
+   return elapsed;
+}
+
+static uint64_t bench_tlab_alloc(int iters, int arg)
+{
+   mspace_t *m = mspace_new(16 * 1024 * 1024);
+   tlab_t *t = tlab_acquire(m);
+
+   const uint64_t start = get_timestamp_ns();
+
+   for (int i = 0; i < iters; i++) {
+      if (t->alloc + arg > t->limit)
+         tlab_reset(t);
+
+      sink += (uintptr_t)tlab_alloc(t, arg);
+   }
+
+   const uint64_t elapsed = get_timestamp_ns() - start;
+
+   tlab_release(t);
+   mspace_destroy(m);
+   return elapsed;
+}
+
+static uint64_t bench_ident_new(int iters, int arg)
+{
+   char buf[32];
+   const uint64_t start = get_timestamp_ns();
+
+   // Mostly hits existing identifiers after the first sample
+   for (int i = 0; i < iters; i++) {
+      checked_sprintf(buf, sizeof(buf), "ident%d", i % arg);
+      sink += (uintptr_t)ident_new(buf);
+   }
+
+   return get_timestamp_ns() - start;
+}
+
+static uint64_t bench_hash_put(int iters, int arg)
+{
+   uint64_t elapsed = 0;
+
+   // Build tables of ARG keys from the minimum size so growth is included
+   for (int done = 0; done < iters; done += arg) {
+      const uint64_t start = get_timestamp_ns();
+
+      hash_t *h = hash_new(16);
+      for (int i = 0; i < arg; i++)
+         hash_put(h, chash_key(i), (void *)chash_key(i));
+
+      elapsed += get_timestamp_ns() - start;
+
+      sink += hash_members(h);
+      hash_free(h);
+   }
+
+   return elapsed;
+}
+
+static uint64_t bench_hash_get(int iters, int arg)
+{
+   hash_t *h = hash_new(arg);
+   for (int i = 0; i < arg; i++)
+      hash_put(h, chash_key(i), (void *)chash_key(i));
+
+   uint32_t rng = 12345;
+   uintptr_t sum = 0;
+
+   const uint64_t start = get_timestamp_ns();
+
+   // Half of the lookups miss
+   for (int i = 0; i < iters; i++)
+      sum += (uintptr_t)hash_get(h, chash_key(fast_rand(&rng) % (arg * 2)));
+
+   const uint64_t elapsed = get_timestamp_ns() - start;
+
+   sink += sum;
+   hash_free(h);
+   return elapsed;
+}
+
+static uint64_t bench_ihash_get(int iters, int arg)
+{
+   ihash_t *h = ihash_new(arg);
+   for (int i = 0; i < arg; i++)
+      ihash_put(h, i * 7, (void *)chash_key(i));
+
+   uint32_t rng = 12345;
+   uintptr_t sum = 0;
+
+   const uint64_t start = get_timestamp_ns();
+
+   for (int i = 0; i < iters; i++)
+      sum += (uintptr_t)ihash_get(h, (fast_rand(&rng) % arg) * 7);
+
+   const uint64_t elapsed = get_timestamp_ns() - start;
+
+   sink += sum;
+   ihash_free(h);
+   return elapsed;
+}
+
+static chash_t *get_chash(void)
+{
+   if (bench_chash == NULL) {
+      bench_chash = chash_new(CHASH_KEYS);
+      for (int i = 0; i < CHASH_KEYS; i++)
+         chash_put(bench_chash, chash_key(i), (void *)chash_key(i));
+   }
+
+   return bench_chash;
+}
+
+static void *chash_get_worker(void *arg)
+{
+   worker_t *w = arg;
+   chash_t *h = get_chash();
+   uint32_t rng = 12345 + w->nth;
+
+   uint64_t sum = 0;
+   for (int i = 0; i < w->iters; i++)
+      sum += (uintptr_t)chash_get(h, chash_key(fast_rand(&rng) % CHASH_KEYS));
+
+   w->sum = sum;
+   return NULL;
+}
+
+static void *chash_put_worker(void *arg)
+{
+   worker_t *w = arg;
+   chash_t *h = get_chash();
+   uint32_t rng = 12345 + w->nth;
+
+   // Every thread updates the same set of keys so writers contend
+   for (int i = 0; i < w->iters; i++) {
+      const void *key = chash_key(fast_rand(&rng) % CHASH_KEYS);
+      chash_put(h, key, (void *)key);
+   }
+
+   return NULL;
+}
+
+static uint64_t run_workers(thread_fn_t fn, int iters, int nthreads)
+{
+   worker_t workers[MAX_THREADS];
+   const int n = MIN(nthreads, MAX_THREADS);
+
+   (void)get_chash();
+
+   const uint64_t start = get_timestamp_ns();
+
+   for (int i = 0; i < n; i++) {
+      workers[i].iters = iters / n;
+      workers[i].nth = i;
+      workers[i].thread = thread_create(fn, &(workers[i]), "bench %d", i);
+   }
+
+   for (int i = 0; i < n; i++) {
+      thread_join(workers[i].thread);
+      sink += workers[i].sum;
+   }
+
+   return get_timestamp_ns() - start;
+}
+
+static uint64_t bench_chash_get(int iters, int arg)
+{
+   return run_workers(chash_get_worker, iters, arg ?: bench_threads);
+}
+
+static uint64_t bench_chash_put(int iters, int arg)
+{
+   return run_workers(chash_put_worker, iters, arg ?: bench_threads);
+}
+
+static void empty_task(void *context, void *arg)
+{
+}
+
+static uint64_t bench_workq_do(int iters, int arg)
+{
+   workq_t *wq = workq_new(NULL);
+
+   const uint64_t start = get_timestamp_ns();
+
+   for (int i = 0; i < iters; i++)
+      workq_do(wq, empty_task, NULL);
+
+   workq_start(wq);
+   workq_drain(wq);
+
+   const uint64_t elapsed = get_timestamp_ns() - start;
+
+   workq_free(wq);
+   return elapsed;
+}
+
+static const bench_case_t cases[] = {
+   { "heap_insert",      bench_heap_insert,      100000,  0 },
+   { "heap_extract_min", bench_heap_extract_min, 100000,  0 },
+   { "heap_churn/1000",  bench_heap_churn,       1000000, 1000 },
+   { "cmp_bytes/8",      bench_cmp_bytes,        1000000, 8 },
+   { "cmp_bytes/32",     bench_cmp_bytes,        1000000, 32 },
+   { "cmp_bytes/128",    bench_cmp_bytes,        1000000, 128 },
+   { "cmp_bytes/1024",   bench_cmp_bytes,        1000000, 1024 },
+   { "copy2/8",          bench_copy2,            1000000, 8 },
+   { "copy2/32",         bench_copy2,            1000000, 32 },
+   { "copy2/1024",       bench_copy2,            1000000, 1024 },
+   { "tlab_alloc/16",    bench_tlab_alloc,       1000000, 16 },
+   { "tlab_alloc/256",   bench_tlab_alloc,       1000000, 256 },
+   { "ident_new",        bench_ident_new,        1000000, 10000 },
+   { "hash_put/100",     bench_hash_put,         1000000, 100 },
+   { "hash_put/10000",   bench_hash_put,         1000000, 10000 },
+   { "hash_get/100",     bench_hash_get,         1000000, 100 },
+   { "hash_get/100000",  bench_hash_get,         1000000, 100000 },
+   { "ihash_get/1000",   bench_ihash_get,        1000000, 1000 },
+   { "chash_get/1",      bench_chash_get,        1000000, 1 },
+   { "chash_get/all",    bench_chash_get,        4000000, 0 },
+   { "chash_put/1",      bench_chash_put,        1000000, 1 },
+   { "chash_put/all",    bench_chash_put,        4000000, 0 },
+   { "workq_do",         bench_workq_do,         100000,  0 },
+};
+
+static double student_t95(int dof)
+{
+   // Two-sided 95% critical values of the t-distribution
+   static const double table[] = {
+      0.0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+      2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110,
+      2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056,
+      2.052, 2.048, 2.045, 2.042
+   };
+
+   if (dof < ARRAY_LEN(table))
+      return table[dof];
+   else
+      return 1.960;
+}
+
+static bench_result_t run_case(const bench_case_t *bc, int samples)
+{
+   double ns[MAX_SAMPLES];
+
+   // Warm up caches and any lazily allocated state
+   (void)(*bc->fn)(bc->iters / 10, bc->arg);
+
+   for (int i = 0; i < samples; i++)
+      ns[i] = (double)(*bc->fn)(bc->iters, bc->arg) / bc->iters;
+
+   double sum = 0.0;
+   for (int i = 0; i < samples; i++)
+      sum += ns[i];
+
+   const double mean = sum / samples;
+
+   double var = 0.0;
+   for (int i = 0; i < samples; i++)
+      var += (ns[i] - mean) * (ns[i] - mean);
+
+   const double sd = samples > 1 ? sqrt(var / (samples - 1)) : 0.0;
+   const double ci = student_t95(samples - 1) * sd / sqrt(samples);
+
+   return (bench_result_t){ mean, ci };
+}
+
+static bool selected(const char *name, int argc, char **argv)
+{
+   if (optind == argc)
+      return true;
+
+   // Each argument selects all cases with that prefix
+   for (int i = optind; i < argc; i++) {
+      if (strncmp(name, argv[i], strlen(argv[i])) == 0)
+         return true;
+   }
+
+   return false;
+}
+
+static bool find_baseline(FILE *f, const char *name, bench_result_t *r)
+{
+   char line[256], bname[64];
+   rewind(f);
+   while (fgets(line, sizeof(line), f) != NULL) {
+      if (line[0] == '#')
+         continue;
+      else if (sscanf(line, "%63s %lf %lf", bname, &r->mean, &r->ci) != 3)
+         continue;
+      else if (strcmp(bname, name) == 0)
+         return true;
+   }
+
+   return false;
+}
+
+static void usage(void)
+{
+   printf("Usage: nvcbench [OPTION]... [CASE]...\n"
+          "\n"
+          "  -b FILE   Compare against the output of a previous run\n"
+          "  -j N      Number of threads for contended cases\n"
+          "  -l        List the available cases\n"
+          "  -n N      Number of samples per case (default 10)\n"
+          "  -t PCT    Regression threshold for -b (default 5)\n"
+          "\n"
+          "Each CASE selects all cases with that name prefix.\n");
+}
+
+int main(int argc, char **argv)
+{
+   term_init();
+   thread_init();
+   register_signal_handlers();
+   set_default_options();
+
+   int samples = 10;
+   double threshold = 5.0;
+   FILE *baseline = NULL;
+
+   bench_threads = MIN(nvc_nprocs(), MAX_THREADS);
+
+   int c;
+   while ((c = getopt(argc, argv, "b:hj:ln:t:")) != -1) {
+      switch (c) {
+      case 'b':
+         if ((baseline = fopen(optarg, "r")) == NULL)
+            fatal_errno("cannot open %s", optarg);
+         break;
+      case 'j':
+         bench_threads = MAX(1, MIN(atoi(optarg), MAX_THREADS));
+         break;
+      case 'l':
+         for (int i = 0; i < ARRAY_LEN(cases); i++)
+            printf("%s\n", cases[i].name);
+         return 0;
+      case 'n':
+         samples = MAX(1, MIN(atoi(optarg), MAX_SAMPLES));
+         break;
+      case 't':
+         threshold = atof(optarg);
+         break;
+      case 'h':
+         usage();
+         return 0;
+      default:
+         usage();
+         return 1;
+      }
+   }
+
+   printf("# %-18s %10s %10s  (%d samples, %d threads)\n", "case",
+          "ns/op", "+/- 95%", samples, bench_threads);
+
+   int regressions = 0;
+   for (int i = 0; i < ARRAY_LEN(cases); i++) {
+      if (!selected(cases[i].name, argc, argv))
+         continue;
+
+      const bench_result_t r = run_case(&(cases[i]), samples);
+      printf("%-20s %10.3f %10.3f", cases[i].name, r.mean, r.ci);
+
+      bench_result_t base;
+      if (baseline != NULL && find_baseline(baseline, cases[i].name, &base)
+          && base.mean > 0.0) {
+         const double delta = 100.0 * (r.mean - base.mean) / base.mean;
+         printf("  %+6.1f%%", delta);
+
+         // Only report a regression if the confidence intervals of the
+         // two measurements do not overlap
+         if (delta > threshold && r.mean - r.ci > base.mean + base.ci) {
+            printf("  REGRESSION");
+            regressions++;
+         }
+      }
+
+      printf("\n");
+      fflush(stdout);
+   }
+
+   if (baseline != NULL)
+      fclose(baseline);
+
+   if (bench_heap != NULL)
+      heap_free(bench_heap);
+
+   if (bench_chash != NULL)
+      chash_free(bench_chash);
+
+   return regressions > 0 ? 1 : 0;
+}
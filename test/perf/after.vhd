@@ -0,0 +1,46 @@
+-- Stress projected output waveforms with many pending transactions
+--
+entity after is
+end entity;
+
+architecture test of after is
+    constant C_DEPTH : positive := 64;
+    constant C_ITERS : positive := 20000;
+
+    signal clk   : bit := '0';
+    signal chain : bit := '0';
+    signal glitch : integer := 0;
+begin
+
+    -- Clock generator that schedules a long train of transport
+    -- transactions each time it wakes up
+    clkgen: process is
+    begin
+        for i in 1 to C_ITERS loop
+            for j in 1 to C_DEPTH loop
+                clk <= transport not clk after j * 1 ns;
+            end loop;
+            wait for C_DEPTH * 1 ns;
+        end loop;
+        wait;
+    end process;
+
+    -- Waveform with many elements that is overwritten before it
+    -- finishes so later transactions are deleted
+    chainp: process (clk) is
+    begin
+        chain <= '1' after 1 ns, '0' after 2 ns, '1' after 3 ns,
+                 '0' after 4 ns, '1' after 5 ns, '0' after 6 ns,
+                 '1' after 7 ns, '0' after 8 ns;
+    end process;
+
+    -- Inertial assignments with a rejection window covering several
+    -- pending transactions
+    glitchp: process (clk) is
+        variable count : integer := 0;
+    begin
+        count := count + 1;
+        glitch <= reject 5 ns inertial count after 10 ns;
+    end process;
+
+end architecture;
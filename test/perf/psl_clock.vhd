@@ -0,0 +1,45 @@
+-- Evaluate clocked PSL assertions on every cycle of a long simulation
+--
+library ieee;
+use ieee.std_logic_1164.all;
+
+entity psl_clock is
+end entity;
+
+architecture test of psl_clock is
+    constant C_CYCLES : positive := 1000000;
+
+    signal clk  : std_logic := '0';
+    signal req  : std_logic := '0';
+    signal ack  : std_logic := '0';
+    signal busy : std_logic := '0';
+    signal done : boolean := false;
+
+    -- psl default clock is rising_edge(clk);
+begin
+
+    clk <= not clk after 5 ns when not done;
+
+    stim: process is
+    begin
+        for i in 1 to C_CYCLES loop
+            wait until rising_edge(clk);
+            req <= '1' when i mod 3 = 0 else '0';
+        end loop;
+        done <= true;
+        wait;
+    end process;
+
+    dut: process (clk) is
+    begin
+        if rising_edge(clk) then
+            ack  <= req;
+            busy <= req or ack;
+        end if;
+    end process;
+
+    -- psl req_ack: assert always req -> next ack;
+    -- psl ack_busy: assert always {req; ack} |-> busy;
+    -- psl no_idle: cover {req; ack; not req};
+
+end architecture;
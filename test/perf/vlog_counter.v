@@ -0,0 +1,35 @@
+// Clocked Verilog counters driven for a long simulation
+//
+module vlog_counter;
+
+  parameter CYCLES = 1000000;
+  parameter N = 16;
+
+  reg clk = 0;
+  reg rst = 1;
+  reg [31:0] count [0:N-1];
+  reg [31:0] total;
+  integer i, cycle;
+
+  always #5 clk = ~clk;
+
+  always @(posedge clk) begin
+    if (rst) begin
+      for (i = 0; i < N; i = i + 1)
+        count[i] <= 0;
+      total <= 0;
+    end else begin
+      for (i = 0; i < N; i = i + 1)
+        count[i] <= count[i] + i + 1;
+      total <= total + count[N-1];
+    end
+  end
+
+  initial begin
+    #20 rst = 0;
+    for (cycle = 0; cycle < CYCLES; cycle = cycle + 1)
+      @(posedge clk);
+    $finish;
+  end
+
+endmodule
@@ -0,0 +1,64 @@
+entity arith7 is
+end entity;
+
+architecture test of arith7 is
+    type int_vec is array (natural range <>) of integer;
+
+    constant inputs : int_vec := (
+        0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 100, 255, 256, 1023,
+        -1, -2, -3, -4, -5, -7, -8, -9, -15, -16, -17, -100, -255,
+        integer'high, integer'low, integer'low + 1 );
+begin
+
+    check: process is
+        variable x : integer;
+    begin
+        for i in inputs'range loop
+            x := inputs(i);
+
+            -- mod takes the sign of the divisor
+            assert x mod 2 >= 0 and x mod 2 < 2;
+            assert x mod 8 >= 0 and x mod 8 < 8;
+            assert (x - x mod 8) rem 8 = 0;
+            assert x mod 16 = (x rem 16 + 16) rem 16;
+
+            -- rem takes the sign of the dividend
+            assert x rem 4 = x - (x / 4) * 4;
+            assert x rem 1024 = x - (x / 1024) * 1024;
+            if x >= 0 then
+                assert x rem 4 >= 0;
+            else
+                assert x rem 4 <= 0;
+            end if;
+
+            -- Division truncates towards zero
+            if x /= integer'low then
+                assert x / 2 = -((-x) / 2);
+                assert abs (x / 4) = abs x / 4;
+            end if;
+        end loop;
+
+        assert 7 / 2 = 3;
+        x := -7;
+        assert x / 2 = -3;
+        assert x / 4 = -1;
+        assert x rem 4 = -3;
+        assert x mod 4 = 1;
+        assert x / 8 = 0;
+        x := -8;
+        assert x / 8 = -1;
+        assert x rem 8 = 0;
+        assert x mod 8 = 0;
+        x := integer'low;
+        assert x / 2 = -(2 ** 30);
+        assert x rem 2 = 0;
+        assert x mod 16 = 0;
+        x := 12;
+        assert x ** 2 = 144;
+        x := -5;
+        assert x ** 2 = 25;
+
+        wait;
+    end process;
+
+end architecture;
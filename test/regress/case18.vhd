@@ -0,0 +1,81 @@
+entity case18 is
+end entity;
+
+architecture test of case18 is
+    type opcode_t is (NOP, LOAD, STORE, ADD, SUB, MUL, DIV, AND_OP, OR_OP,
+                      XOR_OP, SHL, SHR, JMP, JZ, JNZ, CALL, RET, HALT);
+
+    function decode (x : integer) return integer is
+    begin
+        case x is
+            when 0 => return 10;
+            when 1 => return 11;
+            when 2 => return 12;
+            when 3 | 4 => return 13;
+            when 6 => return 16;
+            when 7 => return 17;
+            when 8 => return 18;
+            when 10 => return 20;
+            when 11 => return 21;
+            when 12 to 14 => return 22;
+            when 17 => return 27;
+            when 19 => return 29;
+            when -3 => return 7;
+            when others => return -1;
+        end case;
+    end function;
+
+    function cost (op : opcode_t) return natural is
+    begin
+        case op is
+            when NOP | HALT => return 0;
+            when LOAD | STORE => return 3;
+            when ADD | SUB | AND_OP | OR_OP | XOR_OP => return 1;
+            when MUL => return 4;
+            when DIV => return 20;
+            when SHL | SHR => return 1;
+            when JMP | JZ | JNZ => return 2;
+            when CALL | RET => return 5;
+        end case;
+    end function;
+
+    function expect (x : integer) return integer is
+    begin
+        if x = -3 then
+            return 7;
+        elsif (x >= 0 and x <= 4) or (x >= 6 and x <= 8)
+            or (x >= 10 and x <= 11) or x = 17 or x = 19
+        then
+            return 10 + x - boolean'pos(x = 4);
+        elsif x >= 12 and x <= 14 then
+            return 22;
+        else
+            return -1;
+        end if;
+    end function;
+
+    signal sum : natural;
+begin
+
+    check: process is
+        variable total : natural := 0;
+    begin
+        for i in -10 to 30 loop
+            assert decode(i) = expect(i)
+                report integer'image(i) & " => " & integer'image(decode(i))
+                severity failure;
+        end loop;
+
+        assert decode(integer'low) = -1;
+        assert decode(integer'high) = -1;
+
+        for op in opcode_t loop
+            total := total + cost(op);
+        end loop;
+        sum <= total;
+        wait for 1 ns;
+        assert sum = 53;
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,20 @@
+set -xe
+
+pwd
+which nvc
+
+cp $TESTDIR/regress/ieee1.vhd .
+nvc --std=1993 -a ieee1.vhd
+
+nvc --std=1993 --make IEEE1-TEST
+
+sleep 1
+touch ieee1.vhd
+
+nvc --std=1993 -e ieee1 2>err
+grep "should be reanalysed" err
+
+nvc --std=1993 --make -j 2 IEEE1-TEST
+
+nvc --std=1993 -e ieee1 2>err
+! grep "should be reanalysed" err
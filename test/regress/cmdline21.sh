@@ -0,0 +1,41 @@
+set -xe
+
+cat >cmdline21.vhd <<EOF
+entity cmdline21 is
+    generic ( G : integer := 1 );
+end entity;
+architecture test of cmdline21 is
+begin
+    process is
+    begin
+        report "G is " & integer'image(G);
+        wait;
+    end process;
+end architecture;
+EOF
+
+nvc -a cmdline21.vhd
+
+nvc -e -V cmdline21 2>err
+! grep "reusing elaborated design" err
+
+# Same arguments and no library changes so elaboration is skipped
+nvc -e -V cmdline21 -r >out 2>&1
+grep "reusing elaborated design" out
+grep "G is 1" out
+
+# Different arguments must elaborate again
+nvc -e -V -gG=2 cmdline21 -r >out 2>&1
+! grep "reusing elaborated design" out
+grep "G is 2" out
+
+nvc -e -V -gG=2 cmdline21 2>err
+grep "reusing elaborated design" err
+
+# Reanalysing a unit invalidates the saved design
+sleep 1
+nvc -a cmdline21.vhd
+
+nvc -e -V -gG=2 cmdline21 -r >out 2>&1
+! grep "reusing elaborated design" out
+grep "G is 2" out
@@ -0,0 +1,57 @@
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+entity collapse1_sub is
+    port ( x : in unsigned(7 downto 0);
+           y : inout std_logic;
+           z : out unsigned(7 downto 0) );
+end entity;
+
+architecture test of collapse1_sub is
+begin
+
+    z <= x + 1;
+
+    drive_p: process (x) is
+    begin
+        y <= x(0);
+    end process;
+
+end architecture;
+
+-------------------------------------------------------------------------------
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+entity collapse1 is
+end entity;
+
+architecture test of collapse1 is
+    signal vec, res : std_logic_vector(7 downto 0);
+    signal flag     : std_logic;
+begin
+
+    uut: entity work.collapse1_sub
+        port map ( unsigned(vec), flag, std_logic_vector(z) => res );
+
+    check_p: process is
+    begin
+        vec <= X"00";
+        wait for 1 ns;
+        assert res = X"01";
+        assert flag = '0';
+        vec <= X"41";
+        wait for 1 ns;
+        assert res = X"42";
+        assert flag = '1';
+        vec <= X"fe";
+        wait for 1 ns;
+        assert res = X"ff";
+        assert flag = '0';
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,26 @@
+library ieee;
+use ieee.std_logic_1164.all;
+
+entity cover30 is
+end entity;
+
+architecture test of cover30 is
+    signal x : std_logic_vector(1 to 2) := "00";
+    signal y : std_logic := '0';
+begin
+
+    stim: process is
+    begin
+        wait for 1 ns;
+        x <= "10";
+        wait for 0 ns;
+        x <= "00";                      -- Reverted in the same time step
+        wait for 0 ns;
+        x(2) <= '1';
+        y <= '1';
+        wait for 1 ns;
+        y <= '0';
+        wait;
+    end process;
+
+end architecture;
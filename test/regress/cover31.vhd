@@ -0,0 +1,20 @@
+entity cover31 is
+end entity;
+
+architecture test of cover31 is
+    signal s : integer := 0;
+begin
+
+    stim: process is
+        variable v : integer := 0;
+    begin
+        loop1: for i in 1 to 10 loop
+            v := v + i;
+        end loop;
+        s <= v;
+        wait for 1 ns;
+        assert s = 55;
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,27 @@
+entity delta1 is
+end entity;
+
+architecture test of delta1 is
+    signal count : natural := 0;
+    signal other : natural := 0;
+begin
+
+    -- Long chain of delta cycles at time zero
+    counter: process (count) is
+    begin
+        if count < 50 then
+            count <= count + 1;
+        end if;
+    end process;
+
+    other <= 1 after 1 ns, 2 after 2 ns;
+
+    check: process is
+    begin
+        wait for 5 ns;
+        assert count = 50;
+        assert other = 2;
+        wait;
+    end process;
+
+end architecture;
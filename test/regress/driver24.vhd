@@ -0,0 +1,90 @@
+library ieee;
+use ieee.std_logic_1164.all;
+
+entity driver24 is
+end entity;
+
+architecture test of driver24 is
+
+    type bit3 is ('0', '1', 'X');
+    type bit3_vector is array (natural range <>) of bit3;
+
+    -- Resolved to '1' iff exactly one driver is '1': this is XOR for two
+    -- drivers but is not equivalent to folding XOR over three drivers
+    function one_hot (x : bit3_vector) return bit3 is
+        variable count : natural := 0;
+    begin
+        for i in x'range loop
+            if x(i) = '1' then
+                count := count + 1;
+            end if;
+        end loop;
+        if count = 1 then
+            return '1';
+        else
+            return '0';
+        end if;
+    end function;
+
+    subtype rbit3 is one_hot bit3;
+    type rbit3_vector is array (natural range <>) of rbit3;
+
+    signal s : std_logic_vector(39 downto 0);
+    signal t : rbit3_vector(19 downto 0);
+
+begin
+
+    p1: process is
+    begin
+        s <= (others => 'Z');
+        t <= (others => '0');
+        wait for 1 ns;
+        s <= (39 downto 20 => '1', others => 'Z');
+        t <= (others => '1');
+        wait for 1 ns;
+        s <= (others => 'L');
+        wait;
+    end process;
+
+    p2: process is
+    begin
+        s <= (others => 'Z');
+        t <= (others => '0');
+        wait for 1 ns;
+        s <= (39 downto 10 => 'Z', others => '0');
+        t <= (others => '1');
+        wait for 1 ns;
+        s <= (others => 'H');
+        wait;
+    end process;
+
+    p3: process is
+    begin
+        s <= (others => 'Z');
+        t <= (others => '0');
+        wait for 1 ns;
+        s <= (39 downto 30 => 'Z', 29 downto 20 => '0', others => 'W');
+        t <= (0 => '1', others => '0');
+        wait for 1 ns;
+        s <= (others => 'Z');
+        wait;
+    end process;
+
+    check: process is
+    begin
+        wait for 0 ns;
+        assert s = (39 downto 0 => 'Z');
+        assert t = (19 downto 0 => '0');
+        wait for 1 ns;
+        assert s(39 downto 30) = (39 downto 30 => '1');
+        assert s(29 downto 20) = (29 downto 20 => 'X');
+        assert s(19 downto 10) = (19 downto 10 => 'W');
+        assert s(9 downto 0) = (9 downto 0 => '0');
+        assert t(0) = '0';
+        assert t(19 downto 1) = (19 downto 1 => '0');
+        wait for 1 ns;
+        assert s = (39 downto 0 => 'W');
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,92 @@
+entity driver25 is
+end entity;
+
+architecture test of driver25 is
+    type int_vector is array (natural range <>) of integer;
+
+    function resolved_max (v : int_vector) return integer is
+        variable result : integer := integer'low;
+    begin
+        for i in v'range loop
+            if v(i) > result then
+                result := v(i);
+            end if;
+        end loop;
+        return result;
+    end function;
+
+    subtype max_int is resolved_max integer;
+
+    type t_rec is record
+        valid : boolean;
+        data  : integer;
+        id    : natural;
+    end record;
+
+    type t_rec_array is array (natural range <>) of t_rec;
+
+    function arbitrate (r : t_rec_array) return t_rec is
+    begin
+        for i in r'range loop
+            if r(i).valid then
+                return r(i);
+            end if;
+        end loop;
+        return (false, 0, 0);
+    end function;
+
+    subtype t_bus is arbitrate t_rec;
+
+    signal m   : max_int := 0;
+    signal b   : t_bus := (false, 0, 0);
+    signal one : max_int := 0;          -- Single driver
+begin
+
+    drv1: process is
+    begin
+        for i in 1 to 20 loop
+            m <= i mod 4;
+            b <= (i mod 3 = 0, i mod 5, 1);
+            one <= i mod 2;
+            wait for 1 ns;
+        end loop;
+        m <= 0;
+        b <= (false, 0, 1);
+        wait;
+    end process;
+
+    drv2: process is
+    begin
+        for i in 1 to 20 loop
+            m <= (i + 1) mod 4;
+            b <= (i mod 2 = 0, i mod 7, 2);
+            wait for 1 ns;
+        end loop;
+        m <= -1;
+        b <= (false, 0, 2);
+        wait;
+    end process;
+
+    check: process is
+    begin
+        wait for 0 ns;
+        for i in 1 to 20 loop
+            wait for 0 ns;
+            assert m = maximum(i mod 4, (i + 1) mod 4);
+            assert one = i mod 2;
+            if i mod 3 = 0 then
+                assert b = (true, i mod 5, 1);
+            elsif i mod 2 = 0 then
+                assert b = (true, i mod 7, 2);
+            else
+                assert b = (false, 0, 0);
+            end if;
+            wait for 1 ns;
+        end loop;
+        wait for 0 ns;
+        assert m = 0;
+        assert b = (false, 0, 0);
+        wait;
+    end process;
+
+end architecture;
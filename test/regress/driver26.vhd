@@ -0,0 +1,46 @@
+entity driver26 is
+end entity;
+
+architecture test of driver26 is
+    type t_abc is (a, b, c);
+    type t_abc_vec is array (natural range <>) of t_abc;
+
+    -- Behaves like MAX for up to three drivers but not for more
+    function resolve (x : t_abc_vec) return t_abc is
+        variable result : t_abc := a;
+    begin
+        if x'length >= 4 then
+            return c;
+        end if;
+        for i in x'range loop
+            if x(i) > result then
+                result := x(i);
+            end if;
+        end loop;
+        return result;
+    end function;
+
+    subtype t_resolved is resolve t_abc;
+
+    signal s3 : t_resolved;
+    signal s4 : t_resolved;
+begin
+
+    s3 <= a;
+    s3 <= b;
+    s3 <= a;
+
+    s4 <= a;
+    s4 <= b;
+    s4 <= a;
+    s4 <= a;
+
+    check: process is
+    begin
+        wait for 1 ns;
+        assert s3 = b report t_abc'image(s3);
+        assert s4 = c report t_abc'image(s4);
+        wait;
+    end process;
+
+end architecture;
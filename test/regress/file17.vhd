@@ -0,0 +1,38 @@
+entity file17 is
+end entity;
+
+use std.textio.all;
+
+architecture test of file17 is
+begin
+
+    process is
+        file f, g : text;
+        variable l : line;
+    begin
+        file_open(f, "tmp.txt", write_mode);
+        for i in 1 to 1000 loop
+            write(l, string'("line "));
+            write(l, i);
+            writeline(f, l);
+        end loop;
+        file_close(f);
+
+        file_open(f, "tmp.txt", read_mode);
+        readline(f, l);
+        assert l.all = "line 1";
+
+        -- Truncate the file through another handle while it is still
+        -- open for reading
+        file_open(g, "tmp.txt", write_mode);
+        file_close(g);
+
+        readline(f, l);
+        assert l'length = 0;
+        assert endfile(f);
+        file_close(f);
+
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,127 @@
+entity ieee21 is
+end entity;
+
+library ieee;
+use ieee.numeric_std.all;
+use ieee.std_logic_1164.all;
+
+architecture test of ieee21 is
+begin
+
+    -- Shifts
+    process is
+        variable u : unsigned(7 downto 0);
+        variable s : signed(7 downto 0);
+    begin
+        u := X"b5";
+        s := X"b5";
+        wait for 1 ns;
+        assert shift_left(u, 0) = X"b5";
+        assert shift_left(u, 3) = X"a8";
+        assert shift_left(u, 8) = X"00";
+        assert shift_left(u, 100) = X"00";
+        assert shift_right(u, 3) = X"16";
+        assert shift_right(u, 9) = X"00";
+        assert shift_left(s, 2) = X"d4";
+        assert shift_right(s, 3) = X"f6";
+        assert shift_right(s, 20) = X"ff";
+        s := X"35";
+        wait for 1 ns;
+        assert shift_right(s, 2) = X"0d";
+        assert shift_right(s, 20) = X"00";
+        wait;
+    end process;
+
+    -- Numeric equality
+    process is
+        variable s4 : signed(3 downto 0);
+        variable s8 : signed(7 downto 0);
+        variable u4 : unsigned(3 downto 0);
+        variable u8 : unsigned(7 downto 0);
+    begin
+        s4 := "1010";
+        s8 := X"fa";
+        u4 := "1010";
+        u8 := X"0a";
+        wait for 1 ns;
+        assert s4 = s8;
+        assert s8 = s4;
+        assert not (s4 = signed'(X"0a"));
+        assert u4 = u8;
+        assert not (u4 = unsigned'(X"fa"));
+        s4 := "H0HL";
+        wait for 1 ns;
+        assert s4 = s8;
+        s4 := "10X0";
+        wait for 1 ns;
+        assert not (s4 = s8);
+        wait;
+    end process;
+
+    -- Matching
+    process is
+        variable a, b : std_ulogic_vector(1 to 100);
+        variable u : unsigned(1 to 3);
+    begin
+        a := (others => '1');
+        b := (others => 'H');
+        wait for 1 ns;
+        assert std_match(a, b);
+        b(77) := '-';
+        assert std_match(a, b);
+        b(99) := '0';
+        assert not std_match(a, b);
+        b(99) := 'L';
+        a(99) := '0';
+        assert std_match(a, b);
+        a(3) := 'X';
+        assert not std_match(a, b);
+        a(3) := '-';
+        assert std_match(a, b);
+        assert not std_match(a, b(1 to 99));
+        u := "1-0";
+        wait for 1 ns;
+        assert std_match(u, "110");
+        assert std_match(u, "100");
+        assert not std_match(u, "111");
+        assert not std_match(u, "U10");
+        wait;
+    end process;
+
+    -- Wide vector operations
+    process is
+        variable a, b, c : std_logic_vector(1 to 150);
+    begin
+        for i in a'range loop
+            a(i) := std_logic'val(i mod 9);
+            b(i) := std_logic'val((i / 9) mod 9);
+        end loop;
+        wait for 1 ns;
+        c := a and b;
+        for i in c'range loop
+            assert c(i) = (a(i) and b(i));
+        end loop;
+        c := a or b;
+        for i in c'range loop
+            assert c(i) = (a(i) or b(i));
+        end loop;
+        c := a xor b;
+        for i in c'range loop
+            assert c(i) = (a(i) xor b(i));
+        end loop;
+        c := not a;
+        for i in c'range loop
+            assert c(i) = not a(i);
+        end loop;
+        c := to_x01(b);
+        for i in c'range loop
+            assert c(i) = to_x01(b(i));
+        end loop;
+        assert a = a;
+        c := a;
+        c(150) := 'Z';
+        assert a /= c;
+        wait;
+    end process;
+
+end architecture;
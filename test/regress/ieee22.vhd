@@ -0,0 +1,57 @@
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.fixed_pkg.all;
+use ieee.fixed_float_types.all;
+
+entity ieee22 is
+end entity;
+
+architecture test of ieee22 is
+begin
+
+    process is
+        variable u1 : ufixed(3 downto -2);
+        variable u2 : ufixed(1 downto -4);
+        variable s1 : sfixed(3 downto -2);
+        variable s2 : sfixed(1 downto -4);
+    begin
+        u1 := to_ufixed(5.25, u1);
+        u2 := to_ufixed(1.0625, u2);
+        assert to_real(u1 + u2) = 6.3125;
+        assert (u1 + u2)'high = 4 and (u1 + u2)'low = -4;
+        assert to_real(u1 - u2) = 4.1875;
+        assert to_real(u1 * u2) = 5.578125;
+        assert (u1 * u2)'high = 5 and (u1 * u2)'low = -6;
+
+        s1 := to_sfixed(-3.75, s1);
+        s2 := to_sfixed(1.5625, s2);
+        assert to_real(s1 + s2) = -2.1875;
+        assert to_real(s1 - s2) = -5.3125;
+        assert to_real(s2 - s1) = 5.3125;
+        assert to_real(s1 * s2) = -5.859375;
+
+        -- Rounding to nearest with ties to even
+        assert to_real(resize(u2, 1, -2)) = 1.0;
+        assert to_real(resize(to_ufixed(1.375, u2), 1, -2)) = 1.5;
+        assert to_real(resize(to_ufixed(1.125, u2), 1, -2)) = 1.0;
+        assert to_real(resize(to_sfixed(-1.375, s2), 1, -2)) = -1.5;
+        assert to_real(resize(to_ufixed(1.125, u2), 1, -2,
+                              round_style => fixed_truncate)) = 1.0;
+
+        -- Overflow
+        assert to_real(resize(u1, 1, -2)) = 3.75;
+        assert to_real(resize(u1, 1, -2, fixed_wrap)) = 1.25;
+        assert to_real(resize(s1, 1, -2)) = -2.0;
+        assert to_real(resize(to_ufixed(3.9375, u2), 1, -2)) = 3.75;
+        assert to_real(resize(to_ufixed(3.9375, u2), 1, -2, fixed_wrap)) = 0.0;
+
+        -- Metavalues are handled by the VHDL body
+        u2 := (others => 'X');
+        assert is_x(u1 + u2);
+        assert is_x(u1 * u2);
+        assert is_x(resize(u2, 3, -2));
+
+        wait;
+    end process;
+
+end architecture;
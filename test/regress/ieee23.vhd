@@ -0,0 +1,40 @@
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+entity ieee23 is
+end entity;
+
+architecture test of ieee23 is
+begin
+
+    process is
+        variable v : std_logic_vector(16 downto 0);
+        variable w : std_logic_vector(39 downto 0);
+        variable n : integer;
+    begin
+        v := "10100101111100001";
+        assert to_hstring(v) = "14BE1";
+        assert to_ostring(v) = "245741";
+        w := X"0123456789";
+        assert to_hstring(w) = "0123456789";
+        w(35 downto 32) := "HLHL";
+        w(4) := 'X';
+        assert to_hstring(w) = "0A234567X9";
+        w := (others => 'Z');
+        assert to_hstring(w) = "ZZZZZZZZZZ";
+        w(0) := '1';
+        assert to_hstring(w) = "ZZZZZZZZZX";
+        assert to_hstring(std_logic_vector'("Z0000")) = "Z0";
+        assert to_ostring(std_logic_vector'("ZZ1")) = "X";
+        assert to_hstring(signed'("1010")) = "A";
+        assert to_hstring(signed'("11010")) = "FA";
+
+        n := 42;
+        assert "x=" & to_hstring(w(7 downto 0)) & " n=" & integer'image(n)
+            = "x=ZX n=42";
+
+        wait;
+    end process;
+
+end architecture;
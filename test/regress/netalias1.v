@@ -0,0 +1,44 @@
+module netalias1;
+  reg [3:0]  r;
+  wire [3:0] a, b, c, d, e;
+  wire       x, y;
+  reg        p, q;
+
+  assign c = b;           // Declared before source
+  assign b = a;
+  assign a = r;
+  assign d = c;
+
+  assign e = r;           // Two drivers: must not be collapsed
+  assign e = 4'bzzzz;
+
+  assign x = p;
+  assign x = q;
+  assign y = x;
+
+  sub u(d);
+
+  initial begin
+    r = 4'b0000;
+    p = 1'b0;
+    q = 1'bz;
+    #1;
+    if (a !== 4'b0000 || b !== 4'b0000 || c !== 4'b0000 || d !== 4'b0000)
+      $display("FAILED 1");
+    if (y !== 1'b0) $display("FAILED 2");
+    r = 4'b10xz;
+    q = 1'b1;
+    #1;
+    if (c !== 4'b10xz || d !== 4'b10xz || e !== 4'b10xz)
+      $display("FAILED 3");
+    if (y !== 1'bx) $display("FAILED 4");
+    $display("PASSED");
+    $finish;
+  end
+endmodule // netalias1
+
+module sub(i);
+  input [3:0] i;
+  wire [3:0]  t;
+  assign t = i;
+endmodule // sub
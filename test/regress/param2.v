@@ -0,0 +1,38 @@
+module param2;
+  wire [7:0] o1, o2, o3;
+
+  wrap1 #(8) u1(o1);
+  wrap2 #(8) u2(o2);
+  wrap1 #(3) u3(o3);
+
+  initial begin
+    #1;
+    $display("%d %d %d", o1, o2, o3);
+    if (o1 === 9 && o2 === 10 && o3 === 4)
+      $display("PASSED");
+    else
+      $display("FAILED");
+    $finish;
+  end
+endmodule // param2
+
+module wrap1(o);
+  output [7:0] o;
+  parameter    w = 1;
+  leaf #(w) u(o);           // Same value as u2.u for u1
+endmodule // wrap1
+
+module wrap2(o);
+  output [7:0] o;
+  parameter    n = 1;
+  localparam   m = n;
+  wire [7:0]   t;
+  leaf #(m) u(t);
+  assign o = t + 1;
+endmodule // wrap2
+
+module leaf(o);
+  output [7:0] o;
+  parameter    x = 0;
+  assign o = x + 1;
+endmodule // leaf
@@ -0,0 +1,17 @@
+entity profile1 is
+end entity;
+
+architecture test of profile1 is
+    signal clk : bit := '0';
+begin
+
+    \quo"te\ : process is
+    begin
+        for i in 1 to 10 loop
+            clk <= not clk;
+            wait for 1 ns;
+        end loop;
+        wait;
+    end process;
+
+end architecture;
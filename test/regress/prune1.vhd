@@ -0,0 +1,146 @@
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+entity prune1 is
+end entity;
+
+architecture test of prune1 is
+    type state_t is (IDLE, LOAD, ADD, SHIFT, DONE);
+
+    signal state   : state_t := IDLE;
+    signal a, b    : unsigned(7 downto 0) := X"00";
+    signal start   : std_logic := '0';
+    signal mode    : std_logic := '0';
+    signal result  : unsigned(7 downto 0);
+    signal next_st : state_t;
+    signal op      : integer range 0 to 7 := 0;
+    signal flags   : std_logic_vector(3 downto 0);
+begin
+
+    next_state: process (all) is
+    begin
+        case state is
+            when IDLE =>
+                if start = '1' then
+                    next_st <= LOAD;
+                else
+                    next_st <= IDLE;
+                end if;
+                result <= X"00";
+            when LOAD =>
+                next_st <= ADD;
+                result <= a;
+            when ADD =>
+                next_st <= SHIFT;
+                result <= a + b;
+            when SHIFT =>
+                next_st <= DONE;
+                if mode = '1' then
+                    result <= shift_left(a, 1);
+                else
+                    result <= shift_right(a, 1);
+                end if;
+            when others =>
+                next_st <= IDLE;
+                result <= b;
+        end case;
+    end process;
+
+    decode: process (all) is
+    begin
+        case op is
+            when 0 | 1 => flags <= (others => '0');
+            when 2 => flags <= std_logic_vector(a(3 downto 0));
+            when 3 => flags <= std_logic_vector(b(7 downto 4));
+            when 4 to 6 => flags <= (0 => mode, others => '1');
+            when others => flags <= std_logic_vector(a(7 downto 4) xor b(3 downto 0));
+        end case;
+    end process;
+
+    check: process is
+    begin
+        wait for 1 ns;
+        assert next_st = IDLE;
+        assert result = X"00";
+        assert flags = "0000";
+
+        a <= X"12";
+        b <= X"34";
+        wait for 1 ns;
+        assert result = X"00";      -- Inputs of other branches changed
+        assert flags = "0000";
+
+        start <= '1';
+        wait for 1 ns;
+        assert next_st = LOAD;
+
+        state <= LOAD;
+        wait for 1 ns;
+        assert next_st = ADD;
+        assert result = X"12";
+
+        a <= X"20";
+        wait for 1 ns;
+        assert result = X"20";      -- Input of selected branch changed
+
+        b <= X"01";
+        wait for 1 ns;
+        assert result = X"20";
+
+        state <= ADD;
+        wait for 1 ns;
+        assert next_st = SHIFT;
+        assert result = X"21";
+
+        b <= X"02";
+        wait for 1 ns;
+        assert result = X"22";
+
+        state <= SHIFT;
+        wait for 1 ns;
+        assert result = X"10";
+        mode <= '1';
+        wait for 1 ns;
+        assert result = X"40";
+
+        state <= DONE;
+        wait for 1 ns;
+        assert next_st = IDLE;
+        assert result = X"02";
+        b <= X"05";
+        wait for 1 ns;
+        assert result = X"05";      -- Others branch
+
+        op <= 2;
+        wait for 1 ns;
+        assert flags = "0000";
+        a <= X"2b";
+        wait for 1 ns;
+        assert flags = "1011";
+        b <= X"c5";
+        wait for 1 ns;
+        assert flags = "1011";
+
+        op <= 3;
+        wait for 1 ns;
+        assert flags = "1100";
+
+        op <= 5;
+        wait for 1 ns;
+        assert flags = "1111";
+        mode <= '0';
+        wait for 1 ns;
+        assert flags = "1110";      -- Range choice
+
+        op <= 7;
+        wait for 1 ns;
+        assert flags = "0111";
+        a <= X"f0";
+        wait for 1 ns;
+        assert flags = "1010";
+
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,30 @@
+entity psl25 is
+end entity;
+
+architecture tb of psl25 is
+
+    signal clk : natural;
+    signal req, busy, ack : bit;
+
+    constant seq_req  : bit_vector := "0100" & "0100" & "1000";
+    constant seq_busy : bit_vector := "0011" & "0010" & "0110";
+    constant seq_ack  : bit_vector := "0000" & "1001" & "0000";
+
+begin
+
+    clkgen: clk <= clk + 1 after 1 ns when clk < 11;
+
+    reqgen: req <= seq_req(clk);
+    busygen: busy <= seq_busy(clk);
+    ackgen: ack <= seq_ack(clk);
+
+    -- psl default clock is clk'delayed(0 ns)'event;
+
+    -- Should fail at 11 ns
+    -- psl one: assert always {req} |=> {busy[*1 to 3]; ack} report "one";
+
+    -- Should not fail
+    -- psl two: assert always (req -> next_e[1 to 3] (busy = '1'))
+    --     report "two";
+
+end architecture;
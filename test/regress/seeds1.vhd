@@ -0,0 +1,22 @@
+entity seeds1 is
+end entity;
+
+library nvc;
+use nvc.random.all;
+
+architecture test of seeds1 is
+begin
+
+    -- Assumes --seed=123 --seeds=3
+    process is
+    begin
+        if get_random = 2991312382 then
+            report "first seed";
+        else
+            report "other seed";
+            assert false severity error;   -- Later runs should fail
+        end if;
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,52 @@
+entity signal38_sub is
+    port ( i : in bit_vector(1 downto 0);
+           o : out bit_vector(1 downto 0) );
+end entity;
+
+architecture test of signal38_sub is
+begin
+    o <= not i;
+end architecture;
+
+-------------------------------------------------------------------------------
+
+entity signal38 is
+end entity;
+
+architecture test of signal38 is
+    signal bus_a : bit_vector(15 downto 0);
+    signal bus_b : bit_vector(0 to 9);
+begin
+
+    u1: entity work.signal38_sub
+        port map ( bus_a(1 downto 0), bus_a(3 downto 2) );
+
+    u2: entity work.signal38_sub
+        port map ( i => bus_a(5 downto 4), o => bus_b(2 to 3) );
+
+    bus_a(4) <= '1';
+    bus_a(5) <= '0';
+    bus_a(7 downto 6) <= "10";
+    bus_a(15 downto 8) <= X"a5";
+
+    drive_b: process is
+    begin
+        bus_b(0) <= '1';
+        bus_b(1) <= '0';
+        bus_b(4 to 9) <= "110011";
+        wait;
+    end process;
+
+    check: process is
+    begin
+        bus_a(1 downto 0) <= "01";
+        wait for 1 ns;
+        assert bus_a = X"a5" & "10011001";
+        assert bus_b = "1010110011";
+        bus_a(1 downto 0) <= "10";
+        wait for 1 ns;
+        assert bus_a(3 downto 0) = "0110";
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,47 @@
+entity textio9 is
+end entity;
+
+use std.textio.all;
+
+architecture test of textio9 is
+begin
+
+    process is
+        file fptr : text;
+        variable l : line;
+        variable s : string(1 to 1000);
+    begin
+        for i in s'range loop
+            s(i) := character'val(character'pos('a') + (i mod 26));
+        end loop;
+
+        file_open(fptr, "tmp.txt", WRITE_MODE);
+        write(fptr, "hello" & CR & LF);
+        write(fptr, "" & LF);
+        write(fptr, s & LF);
+        write(fptr, s(1 to 128) & LF);
+        write(fptr, "last");
+        file_close(fptr);
+
+        file_open(fptr, "tmp.txt", READ_MODE);
+        readline(fptr, l);
+        assert l.all = "hello";
+        assert l'left = 1;
+        readline(fptr, l);
+        assert l'length = 0;
+        readline(fptr, l);
+        assert l'length = 1000;
+        assert l.all = s;
+        readline(fptr, l);
+        assert l.all = s(1 to 128);
+        assert not endfile(fptr);
+        readline(fptr, l);
+        assert l.all = "last";
+        assert endfile(fptr);
+        file_close(fptr);
+
+        deallocate(l);
+        wait;
+    end process;
+
+end architecture;
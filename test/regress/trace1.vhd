@@ -0,0 +1,22 @@
+entity trace1 is
+end entity;
+
+architecture test of trace1 is
+
+    procedure check (n : integer) is
+    begin
+        report "value is " & integer'image(n) severity warning;
+    end procedure;
+
+begin
+
+    p1: process is
+    begin
+        for i in 1 to 15 loop
+            check(i);
+        end loop;
+        report "done";
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,24 @@
+entity vhpi20 is
+end entity;
+
+architecture test of vhpi20 is
+    signal x, y : integer := 0;
+    signal v    : bit_vector(1 to 3) := "000";
+begin
+
+    stim: process is
+    begin
+        wait for 1 ns;
+        x <= 1;
+        y <= 2;
+        v <= "101";
+        wait for 1 ns;
+        x <= 5;
+        wait for 0 ns;
+        y <= 6;
+        wait for 1 ns;
+        v <= "111";
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,22 @@
+entity vhpi21 is
+end entity;
+
+architecture test of vhpi21 is
+    type int_vector is array (natural range <>) of integer;
+
+    constant c   : int_vector(1 to 4) := (10, 20, 30, 40);
+    signal mem   : bit_vector(7 downto 0);
+    signal count : natural;
+begin
+
+    check: process is
+    begin
+        wait for 1 ns;
+        assert mem = X"a5";
+        count <= 42;
+        wait for 1 ns;
+        assert mem(3 downto 0) = X"f";
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,38 @@
+entity vhpi22 is
+end entity;
+
+architecture test of vhpi22 is
+    function count_ones (signal s : in bit_vector) return integer is
+    begin
+        report "should not call this" severity failure;
+    end function;
+
+    attribute foreign of count_ones : function is "VHPIDIRECT vhpi22_count_ones";
+
+    procedure fill (x : out integer_vector; first : in integer) is
+    begin
+        report "should not call this" severity failure;
+    end procedure;
+
+    attribute foreign of fill : procedure is "VHPIDIRECT vhpi22_fill";
+
+    signal data : bit_vector(1 to 100) := (others => '0');
+begin
+
+    check: process is
+        variable v : integer_vector(1 to 5);
+    begin
+        assert count_ones(data) = 0;
+        data(1 to 10) <= (others => '1');
+        data(99) <= '1';
+        wait for 1 ns;
+        assert count_ones(data) = 11;
+        assert count_ones(data(50 to 100)) = 1;
+
+        fill(v, 5);
+        assert v = (5, 6, 7, 8, 9);
+
+        wait;
+    end process;
+
+end architecture;
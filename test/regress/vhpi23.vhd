@@ -0,0 +1,24 @@
+library ieee;
+use ieee.std_logic_1164.all;
+
+entity vhpi23 is
+end entity;
+
+architecture test of vhpi23 is
+    signal v : std_logic_vector(39 downto 0) := (others => '0');
+    signal b : bit_vector(0 to 7) := "10010110";
+    signal i : integer_vector(1 to 3) := (5, 6, 7);
+begin
+
+    stim: process is
+    begin
+        v(0) <= '1';
+        v(1) <= 'H';
+        v(2) <= 'X';
+        v(35) <= '1';
+        v(36) <= 'Z';
+        wait for 1 ns;
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,73 @@
+library ieee;
+use ieee.vital_timing.all;
+use ieee.std_logic_1164.all;
+
+entity vital2 is
+end entity;
+
+architecture test of vital2 is
+    constant tpd_a_y : VitalDelayType01 := (tr01 => 2 ns, tr10 => 3 ns);
+    constant tpd_b_y : VitalDelayType01 := (tr01 => 5 ns, tr10 => 1 ns);
+    constant twire   : VitalDelayType01 := (tr01 => 1 ns, tr10 => 4 ns);
+
+    signal a, b, y, w : std_logic := '0';
+begin
+
+    pathp: process (a, b) is
+        variable GlitchData : VitalGlitchDataType;
+    begin
+        VitalPathDelay01 (
+            OutSignal     => y,
+            GlitchData    => GlitchData,
+            OutSignalName => "y",
+            OutTemp       => a or b,
+            Paths         => (
+                0 => (a'last_event, tpd_a_y, true),
+                1 => (b'last_event, tpd_b_y, true)));
+    end process;
+
+    wirep: process (a) is
+    begin
+        VitalWireDelay(w, a, twire);
+    end process;
+
+    check: process is
+        constant d01z : VitalDelayType01Z :=
+            (1 ns, 2 ns, 3 ns, 4 ns, 5 ns, 6 ns);
+    begin
+        assert VitalCalcDelay('1', '0', tpd_a_y) = 2 ns;
+        assert VitalCalcDelay('0', '1', tpd_a_y) = 3 ns;
+        assert VitalCalcDelay('X', 'Z', tpd_a_y) = 2 ns;
+        assert VitalCalcDelay('X', 'U', tpd_a_y) = 3 ns;
+        assert VitalCalcDelay('Z', '0', d01z) = 3 ns;
+        assert VitalCalcDelay('0', 'Z', d01z) = 6 ns;
+        assert VitalCalcDelay('X', 'Z', d01z) = 4 ns;
+        assert VitalCalcDelay('1', 'X', d01z) = 4 ns;
+
+        wait for 10 ns;
+        a <= '1';
+        wait for 1 ns;
+        assert y = '0';
+        assert w = '1';
+        wait for 1 ns;
+        assert y = '1';
+
+        wait for 8 ns;
+        a <= '0';
+        wait for 3 ns;
+        assert y = '0';
+        assert w = '1';
+        wait for 1 ns;
+        assert w = '0';
+
+        wait for 6 ns;
+        b <= '1';
+        wait for 4 ns;
+        assert y = '0';
+        wait for 1 ns;
+        assert y = '1';
+
+        wait;
+    end process;
+
+end architecture;
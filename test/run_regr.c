@@ -108,6 +108,8 @@
 #define F_ARRAYS  (1 << 26)
 #define F_SEED    (1 << 27)
 #define F_PERFILE (1 << 28)
+#define F_AGGCOLL (1 << 29)
+#define F_PRUNE   (1 << 30)
 
 typedef struct test test_t;
 typedef struct param param_t;
@@ -140,7 +142,10 @@ struct test {
    char      *export;
    char      *plusarg;
    unsigned   arrays;
+   unsigned   deltarep;
    int        seed;
+   unsigned   seeds;
+   bool       profile;
    double     duration;
 };
 
@@ -448,6 +453,10 @@ static bool parse_test_list(void)
             test->flags |= F_PERFILE;
          else if (strcmp(opt, "no-collapse") == 0)
             test->flags |= F_NOCOLL;
+         else if (strcmp(opt, "aggressive-collapse") == 0)
+            test->flags |= F_AGGCOLL;
+         else if (strcmp(opt, "prune-sensitivity") == 0)
+            test->flags |= F_PRUNE;
          else if (strcmp(opt, "dump-arrays") == 0)
             test->flags |= F_ARRAYS;
          else if (strncmp(opt, "dump-arrays=", 12) == 0) {
@@ -458,6 +467,13 @@ static bool parse_test_list(void)
                goto out_close;
             }
          }
+         else if (strncmp(opt, "delta-report=", 13) == 0) {
+            if (sscanf(opt + 13, "%u", &(test->deltarep)) != 1) {
+               fprintf(stderr, "Error on testlist line %d: invalid "
+                       "delta-report argument %s\n", lineno, opt);
+               goto out_close;
+            }
+         }
          else if (strncmp(opt, "seed=", 5) == 0) {
             test->flags |= F_SEED;
             if (sscanf(opt + 5, "%u", &(test->seed)) != 1) {
@@ -466,6 +482,15 @@ static bool parse_test_list(void)
                goto out_close;
             }
          }
+         else if (strcmp(opt, "profile") == 0)
+            test->profile = true;
+         else if (strncmp(opt, "seeds=", 6) == 0) {
+            if (sscanf(opt + 6, "%u", &(test->seeds)) != 1) {
+               fprintf(stderr, "Error on testlist line %d: invalid "
+                               "seeds argument %s\n", lineno, opt);
+               goto out_close;
+            }
+         }
          else if (strncmp(opt, "O", 1) == 0) {
             if (sscanf(opt + 1, "%u", &(test->olevel)) != 1) {
                fprintf(stderr, "Error on testlist line %d: invalid "
@@ -765,6 +790,22 @@ static bool file_exists(const char *fmt, ...)
    return exists;
 }
 
+static bool append_file(FILE *log, const char *path)
+{
+   FILE *f = fopen(path, "r");
+   if (f == NULL)
+      return false;
+
+   char buf[1024];
+   size_t nread;
+   while ((nread = fread(buf, 1, sizeof(buf), f)) > 0)
+      fwrite(buf, 1, nread, log);
+
+   fclose(f);
+   fflush(log);
+   return true;
+}
+
 static bool enter_test_directory(test_t *test, char *dir)
 {
 #ifdef __MINGW32__
@@ -969,6 +1010,12 @@ static bool run_test(test_t *test)
       if (test->flags & F_NOCOLL)
          push_arg(&args, "--no-collapse");
 
+      if (test->flags & F_AGGCOLL)
+         push_arg(&args, "--aggressive-collapse");
+
+      if (test->flags & F_PRUNE)
+         push_arg(&args, "--prune-sensitivity");
+
       if (test->flags & F_COVER) {
          if (test->cover)
             push_arg(&args, "--cover=%s", test->cover);
@@ -1029,12 +1076,21 @@ static bool run_test(test_t *test)
       else if (test->flags & F_ARRAYS)
          push_arg(&args, "--dump-arrays");
 
+      if (test->deltarep > 0)
+         push_arg(&args, "--delta-report=%u", test->deltarep);
+
       if (test->flags & F_GTKW)
          push_arg(&args, "-g");
 
       if (test->flags & F_SHUFFLE)
          push_arg(&args, "--shuffle");
 
+      if (test->seeds > 0)
+         push_arg(&args, "--seeds=%u", test->seeds);
+
+      if (test->profile)
+         push_arg(&args, "--profile-report=%s.json", test->name);
+
       if (test->plusarg != NULL)
          push_arg(&args, "+%s", test->plusarg);
 
@@ -1054,6 +1110,19 @@ static bool run_test(test_t *test)
       goto out_print;
    }
 
+   if (test->profile) {
+      // Append the JSON profile to the output so it can be checked
+      // against the gold file
+      char jsonname[PATH_MAX];
+      snprintf(jsonname, sizeof(jsonname), "%s.json", test->name);
+
+      if (!append_file(outf, jsonname)) {
+         failed("missing profile report");
+         result = false;
+         goto out_print;
+      }
+   }
+
    if ((test->flags & F_COVER) && (test->flags & F_EXPORT)) {
       // Generate and check XML report
       push_arg(&args, "%s/nvc%s", bin_dir, EXEEXT);
@@ -0,0 +1,24 @@
+entity deposit1 is
+end entity;
+
+architecture test of deposit1 is
+    type mem_t is array (0 to 3) of bit_vector(7 downto 0);
+    signal mem : mem_t;
+    signal x   : bit;
+begin
+
+    tb: process is
+    begin
+        wait for 1 ns;
+        assert x = '0';
+        assert mem(0) = X"00";
+        wait for 1 ns;
+        assert x = '1';
+        assert mem(0) = X"12";
+        assert mem(1) = X"34";
+        assert mem(2) = "10101010";
+        assert mem(3) = X"00";
+        wait;
+    end process;
+
+end architecture;
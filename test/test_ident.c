@@ -424,6 +424,28 @@ START_TEST(test_casecmp)
 }
 END_TEST
 
+START_TEST(test_prefix_chain)
+{
+   char buf[2048] = "WORK.TOP";
+   ident_t path = ident_new(buf);
+
+   for (int i = 0; i < 200; i++) {
+      char name[16];
+      checked_sprintf(name, sizeof(name), "U%d", i);
+      path = ident_prefix(path, ident_new(name), '.');
+
+      strcat(buf, ".");
+      strcat(buf, name);
+
+      ck_assert_ptr_eq(path, ident_new(buf));
+      ck_assert_str_eq(istr(path), buf);
+   }
+
+   ck_assert_ptr_eq(ident_prefix(path, ident_new("x"), '\0'),
+                    ident_new(strcat(buf, "x")));
+}
+END_TEST
+
 Suite *get_ident_tests(void)
 {
    Suite *s = suite_create("ident");
@@ -453,6 +475,7 @@ Suite *get_ident_tests(void)
    tcase_add_test(tc_core, test_sprintf);
    tcase_add_test(tc_core, test_new_n);
    tcase_add_test(tc_core, test_casecmp);
+   tcase_add_test(tc_core, test_prefix_chain);
    suite_add_tcase(s, tc_core);
 
    return s;
@@ -33,6 +33,10 @@
 #include <math.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #define REG(r) ((jit_value_t){ .kind = JIT_VALUE_REG, .reg = (r) })
 #define CONST(i) ((jit_value_t){ .kind = JIT_VALUE_INT64, .int64 = (i) })
@@ -2138,6 +2142,96 @@ START_TEST(test_lvn12)
 }
 END_TEST
 
+#ifdef HAVE_LLVM
+static int64_t call_cache1(void)
+{
+   jit_t *j = jit_new(NULL, NULL);
+   jit_register_llvm_plugin(j);
+
+   const char *text1 =
+      "RECV  R0, #0       \n"
+      "RECV  R1, #1       \n"
+      "MUL   R2, R0, R1   \n"
+      "SEND  #0, R2       \n"
+      "RET                \n";
+
+   jit_handle_t h1 = jit_assemble(j, ident_new("cache1"), text1);
+
+   tlab_t tlab = jit_null_tlab(j);
+   jit_scalar_t result, p0 = { .integer = 6 }, p1 = { .integer = 7 };
+   for (int i = 0; i < 3; i++)
+      fail_unless(jit_fastcall(j, h1, &result, p0, p1, &tlab));
+
+   ck_assert_ptr_ne(jit_get_func(j, h1)->entry, jit_interp);
+
+   jit_free(j);
+   return result.integer;
+}
+
+static char *cache_object(const char *dir)
+{
+   DIR *d = opendir(dir);
+   ck_assert_ptr_nonnull(d);
+
+   char *path = NULL;
+   struct dirent *e;
+   while ((e = readdir(d))) {
+      if (e->d_name[0] == '.')
+         continue;
+
+      ck_assert_ptr_null(path);
+      path = xasprintf("%s/%s", dir, e->d_name);
+   }
+
+   closedir(d);
+
+   ck_assert_ptr_nonnull(path);
+   return path;
+}
+
+START_TEST(test_cache1)
+{
+   char *dir LOCAL = xasprintf("%s/nvcXXXXXX", P_tmpdir);
+   ck_assert_ptr_nonnull(mkdtemp(dir));
+
+   opt_set_str(OPT_JIT_CACHE, dir);
+   opt_set_int(OPT_JIT_THRESHOLD, 1);
+   opt_set_int(OPT_JIT_ASYNC, 0);
+
+   ck_assert_int_eq(call_cache1(), 42);
+
+   char *path LOCAL = cache_object(dir);
+
+   struct stat st1;
+   ck_assert_int_eq(stat(path, &st1), 0);
+   ck_assert_int_gt(st1.st_size, 0);
+
+   // Objects are stored by renaming a new file into place so a cache
+   // hit must leave the original file untouched
+   ck_assert_int_eq(call_cache1(), 42);
+
+   struct stat st2;
+   ck_assert_int_eq(stat(path, &st2), 0);
+   ck_assert_int_eq(st2.st_ino, st1.st_ino);
+
+   // An empty object is treated as a miss and compiled again
+   ck_assert_int_eq(truncate(path, 0), 0);
+
+   ck_assert_int_eq(call_cache1(), 42);
+
+   struct stat st3;
+   ck_assert_int_eq(stat(path, &st3), 0);
+   ck_assert_int_ne(st3.st_ino, st1.st_ino);
+   ck_assert_int_eq(st3.st_size, st1.st_size);
+
+   ck_assert_int_eq(remove(path), 0);
+   ck_assert_int_eq(rmdir(dir), 0);
+
+   opt_set_str(OPT_JIT_CACHE, NULL);
+}
+END_TEST
+#endif
+
 Suite *get_jit_tests(void)
 {
    Suite *s = suite_create("jit");
@@ -2196,6 +2290,9 @@ Suite *get_jit_tests(void)
    tcase_add_test(tc, test_trim1);
    tcase_add_test(tc, test_lvn11);
    tcase_add_test(tc, test_lvn12);
+#ifdef HAVE_LLVM
+   tcase_add_test(tc, test_cache1);
+#endif
    suite_add_tcase(s, tc);
 
    return s;
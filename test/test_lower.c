@@ -258,6 +258,7 @@ static void check_bb(int bb, const check_bb_t *expect, int len)
       case VCODE_OP_ADD_TRIGGER:
       case VCODE_OP_OR_TRIGGER:
       case VCODE_OP_CMP_TRIGGER:
+      case VCODE_OP_EDGE_TRIGGER:
       case VCODE_OP_BIND_EXTERNAL:
          break;
 
@@ -5603,6 +5604,7 @@ START_TEST(test_transfer1)
          { VCODE_OP_VAR_UPREF, .hops = 1, .name = "B" },
          { VCODE_OP_LOAD_INDIRECT },
          { VCODE_OP_CONST, .value = 0 },
+         { VCODE_OP_CONST, .value = 0 },
          { VCODE_OP_TRANSFER_SIGNAL },
          { VCODE_OP_RETURN },
       };
@@ -5673,6 +5675,74 @@ START_TEST(test_transfer1)
 
       CHECK_BB(0);
    }
+
+   {
+      vcode_unit_t vu = find_unit("WORK.TRANSFER1.P5");
+      vcode_select_unit(vu);
+
+      EXPECT_BB(0) = {
+         { VCODE_OP_VAR_UPREF, .hops = 1, .name = "G" },
+         { VCODE_OP_LOAD_INDIRECT },
+         { VCODE_OP_CONST, .value = 1 },
+         { VCODE_OP_DRIVE_SIGNAL },
+         { VCODE_OP_CONST, .value = 5000000 },
+         { VCODE_OP_TRANSFER_SIGNAL },
+         { VCODE_OP_RETURN },
+      };
+
+      CHECK_BB(0);
+   }
+}
+END_TEST
+
+START_TEST(test_transfer2)
+{
+   input_from_file(TESTDIR "/lower/transfer2.vhd");
+
+   run_elab();
+
+   {
+      vcode_unit_t vu = find_unit("WORK.TRANSFER2.S$stable_1_NS");
+      vcode_select_unit(vu);
+
+      EXPECT_BB(0) = {
+         { VCODE_OP_VAR_UPREF, .hops = 1, .name = "S$stable_1_NS" },
+         { VCODE_OP_LOAD_INDIRECT },
+         { VCODE_OP_CONST, .value = 1 },
+         { VCODE_OP_DRIVE_SIGNAL },
+         { VCODE_OP_CONST, .value = 1000000 },
+         { VCODE_OP_VAR_UPREF, .hops = 1, .name = "S" },
+         { VCODE_OP_LOAD_INDIRECT },
+         { VCODE_OP_CONST, .value = 3 },
+         { VCODE_OP_TRANSFER_SIGNAL },
+         { VCODE_OP_RETURN },
+      };
+
+      CHECK_BB(0);
+   }
+
+   {
+      vcode_unit_t vu = find_unit("WORK.TRANSFER2.S$delayed_2_NS");
+      vcode_select_unit(vu);
+
+      EXPECT_BB(0) = {
+         { VCODE_OP_VAR_UPREF, .hops = 1, .name = "S$delayed_2_NS" },
+         { VCODE_OP_LOAD_INDIRECT },
+         { VCODE_OP_CONST, .value = 1 },
+         { VCODE_OP_DRIVE_SIGNAL },
+         { VCODE_OP_CONST, .value = 2000000 },
+         { VCODE_OP_VAR_UPREF, .hops = 1, .name = "S" },
+         { VCODE_OP_LOAD_INDIRECT },
+         { VCODE_OP_CONST, .value = 0 },
+         { VCODE_OP_CONST, .value = 0 },
+         { VCODE_OP_TRANSFER_SIGNAL },
+         { VCODE_OP_RETURN },
+      };
+
+      CHECK_BB(0);
+   }
+
+   fail_if_errors();
 }
 END_TEST
 
@@ -6296,6 +6366,37 @@ START_TEST(test_trigger1)
 }
 END_TEST
 
+START_TEST(test_trigger2)
+{
+   set_standard(STD_08);
+
+   input_from_file(TESTDIR "/lower/trigger2.vhd");
+
+   run_elab();
+
+   vcode_unit_t vu = find_unit("WORK.TRIGGER2.P1");
+   vcode_select_unit(vu);
+
+   EXPECT_BB(0) = {
+      { VCODE_OP_VAR_UPREF, .name = "X", .hops = 1 },
+      { VCODE_OP_LOAD_INDIRECT },
+      { VCODE_OP_CONST, .value = 1 },
+      { VCODE_OP_DRIVE_SIGNAL },
+      { VCODE_OP_VAR_UPREF, .name = "CLK", .hops = 1 },
+      { VCODE_OP_LOAD_INDIRECT },
+      { VCODE_OP_SCHED_EVENT },
+      { VCODE_OP_CONST, .value = 0 },
+      { VCODE_OP_EDGE_TRIGGER },
+      { VCODE_OP_ADD_TRIGGER },
+      { VCODE_OP_RETURN },
+   };
+
+   CHECK_BB(0);
+
+   fail_if_errors();
+}
+END_TEST
+
 START_TEST(test_issue859)
 {
    set_standard(STD_08);
@@ -7287,6 +7388,7 @@ Suite *get_lower_tests(void)
    tcase_add_test(tc, test_issue756);
    tcase_add_test(tc, test_const3);
    tcase_add_test(tc, test_transfer1);
+   tcase_add_test(tc, test_transfer2);
    tcase_add_test(tc, test_subtype1);
    tcase_add_test(tc, test_alias1);
    tcase_add_test(tc, test_issue768);
@@ -7300,6 +7402,7 @@ Suite *get_lower_tests(void)
    tcase_add_test(tc, test_directmap6);
    tcase_add_test(tc, test_issue844);
    tcase_add_test(tc, test_trigger1);
+   tcase_add_test(tc, test_trigger2);
    tcase_add_test(tc, test_issue859);
    tcase_add_test(tc, test_issue934);
    tcase_add_test(tc, test_issue972);
@@ -1294,6 +1294,199 @@ START_TEST(test_gvn2)
 }
 END_TEST
 
+START_TEST(test_licm1)
+{
+   mir_context_t *mc = mir_context_new();
+
+   mir_unit_t *mu = mir_unit_new(mc, ident_new("licm1"), NULL,
+                                 MIR_UNIT_FUNCTION, NULL);
+
+   mir_type_t t_int32 = mir_int_type(mu, INT32_MIN, INT32_MAX);
+
+   mir_set_result(mu, t_int32);
+
+   mir_value_t p1 = mir_add_param(mu, t_int32, MIR_NULL_STAMP, ident_new("p1"));
+   mir_value_t p2 = mir_add_param(mu, t_int32, MIR_NULL_STAMP, ident_new("p2"));
+
+   mir_block_t b1 = mir_add_block(mu);
+   mir_block_t b2 = mir_add_block(mu);
+   mir_block_t b3 = mir_add_block(mu);
+
+   mir_build_jump(mu, b1);
+
+   mir_set_cursor(mu, b1, MIR_APPEND);
+   mir_value_t phi = mir_build_phi(mu, t_int32, 2);
+   mir_value_t add1 = mir_build_add(mu, t_int32, p1, p2);
+   mir_value_t cmp1 = mir_build_cmp(mu, MIR_CMP_LT, phi, add1);
+   mir_build_cond(mu, cmp1, b2, b3);
+
+   mir_set_cursor(mu, b2, MIR_APPEND);
+   mir_value_t add2 = mir_build_add(mu, t_int32, phi, mir_const(mu, t_int32, 1));
+   mir_build_jump(mu, b1);
+
+   mir_set_input(mu, phi, 0, mir_get_block(mu, 0), mir_const(mu, t_int32, 0));
+   mir_set_input(mu, phi, 1, b2, add2);
+
+   mir_set_cursor(mu, b3, MIR_APPEND);
+   mir_build_return(mu, phi);
+
+   mir_optimise(mu, MIR_PASS_LICM);
+
+   static const mir_match_t bb0[] = {
+      { MIR_OP_ADD, PARAM("p1"), PARAM("p2") },
+      { MIR_OP_JUMP, BLOCK(1) },
+   };
+   mir_match(mu, 0, bb0);
+
+   static const mir_match_t bb1[] = {
+      { MIR_OP_PHI, BLOCK(0), CONST(0) },
+      { MIR_OP_CMP, ENUM(MIR_CMP_LT), NODE(1), NODE(2) },
+      { MIR_OP_COND, NODE(3), BLOCK(2), BLOCK(3) },
+   };
+   mir_match(mu, 1, bb1);
+
+   static const mir_match_t bb2[] = {
+      { MIR_OP_ADD, NODE(1), CONST(1) },
+      { MIR_OP_JUMP, BLOCK(1) },
+   };
+   mir_match(mu, 2, bb2);
+
+   mir_unit_free(mu);
+   mir_context_free(mc);
+}
+END_TEST
+
+START_TEST(test_bce1)
+{
+   mir_unit_t *mu = mir_unit_new(get_mir(), ident_new("bce1"), NULL,
+                                 MIR_UNIT_FUNCTION, NULL);
+
+   mir_type_t t_bool = mir_bool_type(mu);
+   mir_type_t t_int32 = mir_int_type(mu, INT32_MIN, INT32_MAX);
+   mir_type_t t_small = mir_int_type(mu, 1, 8);
+   mir_stamp_t s_small = mir_int_stamp(mu, 1, 8);
+
+   mir_value_t p1 = mir_add_param(mu, t_int32, s_small, ident_new("p1"));
+   mir_value_t p2 = mir_add_param(mu, t_int32, MIR_NULL_STAMP,
+                                  ident_new("p2"));
+   mir_value_t p3 = mir_add_param(mu, t_small, MIR_NULL_STAMP,
+                                  ident_new("p3"));
+
+   mir_value_t locus = mir_build_debug_locus(mu, NULL);
+   mir_value_t one = mir_const(mu, t_int32, 1);
+   mir_value_t ten = mir_const(mu, t_int32, 10);
+   mir_value_t to = mir_const(mu, t_bool, RANGE_TO);
+   mir_value_t downto = mir_const(mu, t_bool, RANGE_DOWNTO);
+
+   mir_build_index_check(mu, p1, one, ten, to, locus, MIR_NULL_VALUE);
+   mir_build_index_check(mu, p2, one, ten, to, locus, MIR_NULL_VALUE);
+   mir_build_index_check(mu, p1, ten, one, downto, locus, MIR_NULL_VALUE);
+   mir_build_index_check(mu, p1, ten, one, to, locus, MIR_NULL_VALUE);
+   mir_build_range_check(mu, p2, one, ten, to, locus, MIR_NULL_VALUE);
+   mir_build_index_check(mu, p2, one, ten, to, locus, MIR_NULL_VALUE);
+   mir_build_index_check(mu, p3, one, ten, to, locus, MIR_NULL_VALUE);
+   mir_build_return(mu, MIR_NULL_VALUE);
+
+   mir_optimise(mu, MIR_PASS_BCE);
+
+   static const mir_match_t bb0[] = {
+      { MIR_OP_DEBUG_LOCUS },
+      { MIR_OP_INDEX_CHECK, PARAM("p2"), CONST(1), CONST(10) },
+      { MIR_OP_INDEX_CHECK, PARAM("p1"), CONST(10), CONST(1) },
+      { MIR_OP_RANGE_CHECK, PARAM("p2"), CONST(1), CONST(10) },
+      { MIR_OP_INDEX_CHECK, PARAM("p3"), CONST(1), CONST(10) },
+      { MIR_OP_RETURN },
+   };
+   mir_match(mu, 0, bb0);
+}
+END_TEST
+
+START_TEST(test_inline1)
+{
+   mir_context_t *mc = mir_context_new();
+
+   mir_unit_t *callee = mir_unit_new(mc, ident_new("inline1.callee"), NULL,
+                                     MIR_UNIT_FUNCTION, NULL);
+
+   mir_type_t t_int32 = mir_int_type(callee, INT32_MIN, INT32_MAX);
+
+   mir_set_result(callee, t_int32);
+
+   {
+      mir_value_t p1 = mir_add_param(callee, t_int32, MIR_NULL_STAMP,
+                                     ident_new("p1"));
+      mir_value_t p2 = mir_add_param(callee, t_int32, MIR_NULL_STAMP,
+                                     ident_new("p2"));
+
+      mir_value_t add = mir_build_add(callee, t_int32, p1, p2);
+      mir_value_t two = mir_const(callee, t_int32, 2);
+      mir_build_return(callee, mir_build_mul(callee, t_int32, add, two));
+   }
+
+   mir_put_unit(mc, callee);
+
+   mir_unit_t *mu = mir_unit_new(mc, ident_new("inline1"), NULL,
+                                 MIR_UNIT_FUNCTION, NULL);
+
+   mir_set_result(mu, t_int32);
+
+   mir_value_t x = mir_add_param(mu, t_int32, MIR_NULL_STAMP, ident_new("x"));
+
+   const mir_value_t args[] = { x, mir_const(mu, t_int32, 5) };
+   mir_value_t call = mir_build_fcall(mu, ident_new("inline1.callee"),
+                                      t_int32, MIR_NULL_STAMP, args, 2);
+   mir_build_return(mu, call);
+
+   mir_optimise(mu, MIR_PASS_INLINE);
+
+   static const mir_match_t bb0[] = {
+      { MIR_OP_ADD, PARAM("x"), CONST(5) },
+      { MIR_OP_MUL, NODE(0), CONST(2) },
+      { MIR_OP_RETURN, NODE(1) },
+   };
+   mir_match(mu, 0, bb0);
+
+   mir_unit_free(mu);
+   mir_context_free(mc);
+}
+END_TEST
+
+START_TEST(test_escape1)
+{
+   mir_context_t *mc = mir_context_new();
+
+   mir_unit_t *mu = mir_unit_new(mc, ident_new("escape1"), NULL,
+                                 MIR_UNIT_FUNCTION, NULL);
+
+   mir_type_t t_int32 = mir_int_type(mu, INT32_MIN, INT32_MAX);
+   mir_type_t t_offset = mir_offset_type(mu);
+   mir_type_t t_ptr = mir_pointer_type(mu, t_int32);
+
+   mir_value_t p1 = mir_add_param(mu, t_int32, MIR_NULL_STAMP, ident_new("p1"));
+
+   mir_set_result(mu, t_ptr);
+
+   mir_value_t four = mir_const(mu, t_offset, 4);
+
+   mir_value_t a1 = mir_build_alloc(mu, t_int32, MIR_NULL_STAMP, four);
+   mir_value_t ref1 = mir_build_array_ref(mu, a1, mir_const(mu, t_offset, 2));
+   mir_build_store(mu, ref1, p1);
+
+   mir_value_t a2 = mir_build_alloc(mu, t_int32, MIR_NULL_STAMP, four);
+   mir_value_t ref2 = mir_build_array_ref(mu, a2, mir_const(mu, t_offset, 1));
+   mir_build_store(mu, ref2, mir_build_load(mu, ref1));
+   mir_build_return(mu, ref2);
+
+   mir_optimise(mu, MIR_PASS_ESCAPE);
+
+   ck_assert_int_eq(mir_get_mem(mu, a1), MIR_MEM_STACK);
+   ck_assert_int_eq(mir_get_mem(mu, a2), MIR_MEM_TOP);
+
+   mir_unit_free(mu);
+   mir_context_free(mc);
+}
+END_TEST
+
 Suite *get_mir_tests(void)
 {
    Suite *s = suite_create("mir");
@@ -1324,6 +1517,10 @@ Suite *get_mir_tests(void)
    tcase_add_test(tc, test_cfg1);
    tcase_add_test(tc, test_dce2);
    tcase_add_test(tc, test_gvn2);
+   tcase_add_test(tc, test_licm1);
+   tcase_add_test(tc, test_bce1);
+   tcase_add_test(tc, test_inline1);
+   tcase_add_test(tc, test_escape1);
    suite_add_tcase(s, tc);
 
    return s;
@@ -24,6 +24,7 @@
 #include "printf.h"
 #include "rt/copy.h"
 #include "rt/heap.h"
+#include "rt/wheel.h"
 #include "thread.h"
 #include "util.h"
 #include "stdint.h"
@@ -407,6 +408,143 @@ START_TEST(test_heap_delete)
 }
 END_TEST
 
+START_TEST(test_wheel_basic)
+{
+   wheel_t *w = wheel_new();
+
+   wheel_insert(w, 5, (void*)5);
+   wheel_insert(w, 2, (void*)2);
+   wheel_insert(w, 62, (void*)62);
+   wheel_insert(w, 5000, (void*)5000);
+   wheel_insert(w, UINT64_C(1) << 50, (void*)1);
+
+   ck_assert_int_eq(wheel_size(w), 5);
+   ck_assert_int_eq(wheel_min_key(w), 2);
+   ck_assert_ptr_eq(wheel_min(w), (void*)2);
+
+   ck_assert_ptr_eq(wheel_extract_min(w), (void*)2);
+   ck_assert_ptr_eq(wheel_extract_min(w), (void*)5);
+
+   wheel_insert(w, 5, (void*)6);
+   ck_assert_int_eq(wheel_min_key(w), 5);
+   ck_assert_ptr_eq(wheel_extract_min(w), (void*)6);
+
+   ck_assert_ptr_eq(wheel_extract_min(w), (void*)62);
+   ck_assert_ptr_eq(wheel_min(w), (void*)5000);
+   ck_assert_ptr_eq(wheel_extract_min(w), (void*)5000);
+   ck_assert_int_eq(wheel_min_key(w), UINT64_C(1) << 50);
+   ck_assert_ptr_eq(wheel_min(w), (void*)1);
+   ck_assert_ptr_eq(wheel_extract_min(w), (void*)1);
+
+   ck_assert_int_eq(wheel_size(w), 0);
+
+   wheel_free(w);
+}
+END_TEST
+
+static int key_compar(const void *a, const void *b)
+{
+   const uint64_t ka = *(const uint64_t *)a, kb = *(const uint64_t *)b;
+   return ka < kb ? -1 : (ka > kb ? 1 : 0);
+}
+
+START_TEST(test_wheel_rand)
+{
+   wheel_t *w = wheel_new();
+
+   static const int N = 4096;
+   uint64_t keys[N];
+
+   // Insert new events relative to the current time as the simulation
+   // kernel does with a mixture of near and far future delays
+   uint64_t now = 0;
+   int nkeys = 0, next = 0;
+   for (int i = 0; i < N; i++) {
+      const int shift = rand() % 48;
+      keys[nkeys] = now + ((uint64_t)rand() & ((UINT64_C(1) << shift) - 1));
+      wheel_insert(w, keys[nkeys], (void *)(uintptr_t)keys[nkeys]);
+      nkeys++;
+
+      if (rand() % 3 == 0) {
+         qsort(keys + next, nkeys - next, sizeof(uint64_t), key_compar);
+         ck_assert_int_eq(wheel_min_key(w), keys[next]);
+         ck_assert_ptr_eq(wheel_extract_min(w), (void *)(uintptr_t)keys[next]);
+         now = keys[next++];
+      }
+   }
+
+   qsort(keys + next, nkeys - next, sizeof(uint64_t), key_compar);
+
+   for (int i = next; i < nkeys; i++)
+      ck_assert_ptr_eq(wheel_extract_min(w), (void *)(uintptr_t)keys[i]);
+
+   ck_assert_int_eq(wheel_size(w), 0);
+
+   wheel_free(w);
+}
+END_TEST
+
+START_TEST(test_wheel_gap)
+{
+   wheel_t *w = wheel_new();
+
+   // Events after a gap longer than the span of the wheel are first
+   // stored in the far heap and then the wheel is moved forward
+   uint64_t now = 0;
+   for (int i = 0; i < 4; i++) {
+      now += UINT64_C(1) << 40;
+      wheel_insert(w, now, (void *)(uintptr_t)now);
+      wheel_insert(w, now + 1000, (void *)(uintptr_t)(now + 1000));
+      ck_assert_ptr_eq(wheel_extract_min(w), (void *)(uintptr_t)now);
+
+      for (int j = 5; j > 0; j--)
+         wheel_insert(w, now + j, (void *)(uintptr_t)(now + j));
+
+      for (int j = 1; j <= 5; j++) {
+         ck_assert_int_eq(wheel_min_key(w), now + j);
+         ck_assert_ptr_eq(wheel_extract_min(w), (void *)(uintptr_t)(now + j));
+      }
+
+      ck_assert_ptr_eq(wheel_extract_min(w), (void *)(uintptr_t)(now + 1000));
+      ck_assert_int_eq(wheel_size(w), 0);
+   }
+
+   wheel_free(w);
+}
+END_TEST
+
+START_TEST(test_wheel_delete)
+{
+   wheel_t *w = wheel_new();
+
+   static const int N = 1024;
+   uint64_t keys[N];
+
+   for (int i = 0; i < N; i++) {
+      keys[i] = 1 + rand() % 100000;
+      wheel_insert(w, keys[i], (void *)(uintptr_t)keys[i]);
+   }
+
+   int deleted = 0;
+   for (int i = 0; i < N; i++) {
+      if (rand() % 20 == 0) {
+         ck_assert(wheel_delete(w, heap_delete_cb, (void *)(uintptr_t)keys[i]));
+         keys[i] = 0;
+         deleted++;
+      }
+   }
+
+   ck_assert_int_eq(wheel_size(w), N - deleted);
+
+   qsort(keys, N, sizeof(uint64_t), key_compar);
+
+   for (int i = deleted; i < N; i++)
+      ck_assert_ptr_eq(wheel_extract_min(w), (void *)(uintptr_t)keys[i]);
+
+   wheel_free(w);
+}
+END_TEST
+
 START_TEST(test_strip)
 {
    LOCAL_TEXT_BUF tb = tb_new();
@@ -963,6 +1101,13 @@ Suite *get_misc_tests(void)
    tcase_add_test(tc_heap, test_heap_delete);
    suite_add_tcase(s, tc_heap);
 
+   TCase *tc_wheel = tcase_create("wheel");
+   tcase_add_test(tc_wheel, test_wheel_basic);
+   tcase_add_test(tc_wheel, test_wheel_rand);
+   tcase_add_test(tc_wheel, test_wheel_gap);
+   tcase_add_test(tc_wheel, test_wheel_delete);
+   suite_add_tcase(s, tc_wheel);
+
    TCase *tc_util = tcase_create("util");
    tcase_add_test(tc_util, test_strip);
    suite_add_tcase(s, tc_util);
@@ -22,9 +22,20 @@
 #include "phase.h"
 #include "rt/model.h"
 #include "rt/structs.h"
+#include "rt/wave.h"
 #include "scan.h"
 #include "type.h"
 
+#include <string.h>
+#include <strings.h>
+
+#ifndef __MINGW32__
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
 START_TEST(test_basic1)
 {
    input_from_file(TESTDIR "/model/basic1.vhd");
@@ -96,18 +107,20 @@ START_TEST(test_index1)
    ck_assert_int_eq(ss1->n_nexus, 21);
    ck_assert_int_eq(ss1->nexus.width, 8);
    ck_assert_ptr_nonnull(ss1->index);
-   ck_assert_int_eq(ss1->index->how, 3);
+   ck_assert_int_eq(ss1->index->count, 21);
    ck_assert_ptr_eq(ss1->index->nexus[0], &(ss1->nexus));
    ck_assert_ptr_nonnull(ss1->index->nexus[20]);
-   ck_assert_ptr_null(ss1->index->nexus[21]);
+   ck_assert_int_eq(ss1->index->offsets[1], 8);
+   ck_assert_int_eq(ss1->index->offsets[20], 160);
 
    ck_assert_int_eq(ss2->n_nexus, 41);
    ck_assert_int_eq(ss2->nexus.width, 10);
    ck_assert_ptr_nonnull(ss2->index);
-   ck_assert_int_eq(ss2->index->how, -10);
+   ck_assert_int_eq(ss2->index->count, 41);
    ck_assert_ptr_eq(ss2->index->nexus[0], &(ss2->nexus));
    ck_assert_ptr_nonnull(ss2->index->nexus[40]);
-   ck_assert_ptr_null(ss2->index->nexus[41]);
+   ck_assert_int_eq(ss2->index->offsets[1], 10);
+   ck_assert_int_eq(ss2->index->offsets[40], 400);
 
    model_free(m);
 
@@ -496,6 +509,184 @@ START_TEST(test_split1)
 }
 END_TEST
 
+#ifndef __MINGW32__
+typedef struct {
+   int     fd;
+   uint8_t buf[65536];
+   size_t  len;
+} ws_test_conn_t;
+
+static void ws_test_send(ws_test_conn_t *c, uint8_t op, uint32_t len,
+                         uint32_t arg)
+{
+   const uint8_t msg[] = {
+      op, len, len >> 8, len >> 16, len >> 24,
+      arg, arg >> 8, arg >> 16, arg >> 24
+   };
+   ck_assert_int_eq(send(c->fd, msg, sizeof(msg), 0), sizeof(msg));
+}
+
+static uint32_t ws_test_u32(const uint8_t *p)
+{
+   return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static const uint8_t *ws_test_recv(rt_model_t *m, ws_test_conn_t *c,
+                                   uint8_t op, uint32_t *len)
+{
+   // Keep the simulation running so the server polls its clients and
+   // skip any messages before the first one with opcode OP
+   for (int i = 0; i < 1000; i++) {
+      while (c->len >= 5 && c->len >= 5 + ws_test_u32(c->buf + 1)) {
+         const uint32_t msglen = ws_test_u32(c->buf + 1);
+         if (c->buf[0] == op) {
+            *len = msglen;
+            return c->buf + 5;
+         }
+
+         memmove(c->buf, c->buf + 5 + msglen, c->len - 5 - msglen);
+         c->len -= 5 + msglen;
+      }
+
+      struct pollfd pfd = { .fd = c->fd, .events = POLLIN };
+      if (poll(&pfd, 1, 0) > 0) {
+         ssize_t n = recv(c->fd, c->buf + c->len, sizeof(c->buf) - c->len, 0);
+         if (n <= 0)
+            return NULL;   // Closed by server
+
+         c->len += n;
+      }
+      else {
+         model_step(m);
+         usleep(1100);
+      }
+   }
+
+   ck_abort_msg("timeout waiting for message %02x", op);
+   return NULL;
+}
+
+static void ws_test_consume(ws_test_conn_t *c, uint32_t len)
+{
+   memmove(c->buf, c->buf + 5 + len, c->len - 5 - len);
+   c->len -= 5 + len;
+}
+
+static uint32_t ws_test_find(const uint8_t *p, uint32_t len, uint8_t kind,
+                             const char *name)
+{
+   const uint8_t *end = p + len;
+   const uint32_t count = ws_test_u32(p + 4);
+   p += 8;
+
+   for (uint32_t i = 0; i < count; i++) {
+      ck_assert(p < end);
+      const uint8_t k = *p++;
+      const uint32_t id = ws_test_u32(p);
+      p += 4;
+      if (k == 1)
+         p += 5;   // Size and width
+      const int namelen = p[0] | (p[1] << 8);
+      p += 2;
+      if (k == kind && namelen == strlen(name)
+          && strncasecmp((const char *)p, name, namelen) == 0)
+         return id;
+      p += namelen;
+   }
+
+   ck_abort_msg("cannot find %s in scope listing", name);
+   return UINT32_MAX;
+}
+#endif
+
+START_TEST(test_wavesrv1)
+{
+#ifndef __MINGW32__
+   input_from_file(TESTDIR "/model/wavesrv1.vhd");
+
+   const unsigned port = 20000 + getpid() % 20000;
+   wave_server_t *ws = wave_server_new(port);
+
+   rt_model_t *m = model_new(get_jit(), NULL);
+
+   tree_t top = run_elab_with_model(m);
+   fail_if(top == NULL);
+
+   model_reset(m);
+   wave_server_restart(ws, m);
+
+   ws_test_conn_t *c = xcalloc(sizeof(ws_test_conn_t));
+   c->fd = socket(AF_INET, SOCK_STREAM, 0);
+   ck_assert_int_ge(c->fd, 0);
+
+   struct sockaddr_in addr = {
+      .sin_family      = AF_INET,
+      .sin_port        = htons(port),
+      .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+   };
+   ck_assert_int_eq(connect(c->fd, (struct sockaddr *)&addr,
+                            sizeof(addr)), 0);
+
+   uint32_t len;
+   const uint8_t *msg;
+
+   ws_test_send(c, 0x01, 4, 0);   // WS_LIST root
+   msg = ws_test_recv(m, c, 0x81, &len);
+   ck_assert_ptr_nonnull(msg);
+   ck_assert_int_eq(ws_test_u32(msg), 0);
+   const uint32_t scope = ws_test_find(msg, len, 0, "WAVESRV1");
+   ws_test_consume(c, len);
+
+   ws_test_send(c, 0x01, 4, scope);   // WS_LIST
+   msg = ws_test_recv(m, c, 0x81, &len);
+   ck_assert_ptr_nonnull(msg);
+   ck_assert_int_eq(ws_test_u32(msg), scope);
+   const uint32_t clk = ws_test_find(msg, len, 1, "CLK");
+   ws_test_consume(c, len);
+
+   ws_test_send(c, 0x02, 4, clk);   // WS_SUBSCRIBE
+   msg = ws_test_recv(m, c, 0x83, &len);
+   ck_assert_ptr_nonnull(msg);
+   ck_assert_int_eq(len, 5);
+   ck_assert_int_eq(ws_test_u32(msg), clk);
+   const uint8_t first = msg[4];
+   ws_test_consume(c, len);
+
+   // The value changes every time step after subscribing
+   msg = ws_test_recv(m, c, 0x82, &len);   // WS_TIME
+   ck_assert_ptr_nonnull(msg);
+   ck_assert_int_eq(len, 8);
+   ws_test_consume(c, len);
+
+   msg = ws_test_recv(m, c, 0x83, &len);
+   ck_assert_ptr_nonnull(msg);
+   ck_assert_int_eq(ws_test_u32(msg), clk);
+   ck_assert_int_eq(msg[4], !first);
+   ws_test_consume(c, len);
+
+   ws_test_send(c, 0x01, 4, 12345);
+   msg = ws_test_recv(m, c, 0x84, &len);   // WS_ERROR
+   ck_assert_ptr_nonnull(msg);
+   ws_test_consume(c, len);
+
+   // Oversized requests close the connection
+   ws_test_send(c, 0x01, 1 << 30, 0);
+   msg = ws_test_recv(m, c, 0x84, &len);
+   ck_assert_ptr_nonnull(msg);
+   ws_test_consume(c, len);
+   ck_assert_ptr_null(ws_test_recv(m, c, 0x81, &len));
+
+   close(c->fd);
+   free(c);
+
+   wave_server_free(ws);
+   model_free(m);
+
+   fail_if_errors();
+#endif
+}
+END_TEST
+
 Suite *get_model_tests(void)
 {
    Suite *s = suite_create("model");
@@ -511,6 +702,7 @@ Suite *get_model_tests(void)
    tcase_add_test(tc, test_event1);
    tcase_add_test(tc, test_process1);
    tcase_add_test(tc, test_split1);
+   tcase_add_test(tc, test_wavesrv1);
    suite_add_tcase(s, tc);
 
    return s;
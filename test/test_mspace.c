@@ -16,7 +16,10 @@
 //
 
 #include "test_util.h"
+#include "option.h"
 #include "rt/mspace.h"
+#include "stats.h"
+#include "thread.h"
 
 #include <stdlib.h>
 
@@ -294,6 +297,229 @@ START_TEST(test_end_ptr)
 }
 END_TEST
 
+START_TEST(test_lazy_sweep)
+{
+   opt_set_int(OPT_GC_LAZY_SWEEP, 1);
+
+   mspace_t *m = mspace_new(4096);
+
+   generate_garbage(m, 10, sizeof(int));
+
+   int *volatile* ptr2 = get_indirect(m);
+
+   // Do enough allocations to trigger several collections
+   for (int i = 0; i < 10; i++)
+      generate_garbage(m, 100, (1 + rand() % 10) * sizeof(int));
+
+   ck_assert_int_eq(**ptr2, 42);
+
+   mspace_destroy(m);
+}
+END_TEST
+
+static int helpers_stop = 0;
+
+static void *idle_helper(void *arg)
+{
+   while (!atomic_load(&helpers_stop))
+      thread_sleep(100);
+
+   return NULL;
+}
+
+START_TEST(test_parallel_mark)
+{
+   struct list {
+      struct list *next;
+      int value;
+   };
+
+   nvc_thread_t *helpers[3];
+   for (int i = 0; i < ARRAY_LEN(helpers); i++)
+      helpers[i] = thread_create(idle_helper, NULL, "idle helper %d", i);
+
+   mspace_t *m = mspace_new(256 * 1024);
+
+   // Enough roots that each collection marks in parallel
+   mptr_t roots[300];
+   for (int i = 0; i < ARRAY_LEN(roots); i++) {
+      roots[i] = mptr_new(m, "root");
+
+      struct list **tailp = (struct list **)mptr_get(roots[i]);
+      for (int j = 0; j < 5; j++) {
+         struct list *l = mspace_alloc(m, sizeof(struct list));
+         l->value = i * 5 + j;
+         l->next = NULL;
+
+         *tailp = l;
+         tailp = &(l->next);
+      }
+   }
+
+   // Do enough allocations to trigger a GC
+   generate_garbage(m, 10000, 5 * sizeof(int));
+
+   for (int i = 0; i < ARRAY_LEN(roots); i++) {
+      struct list *it = *mptr_get(roots[i]);
+      for (int j = 0; j < 5; j++, it = it->next)
+         ck_assert_int_eq(it->value, i * 5 + j);
+      ck_assert_ptr_null(it);
+
+      mptr_free(m, &(roots[i]));
+   }
+
+   mspace_destroy(m);
+
+   atomic_store(&helpers_stop, 1);
+   for (int i = 0; i < ARRAY_LEN(helpers); i++)
+      thread_join(helpers[i]);
+}
+END_TEST
+
+START_TEST(test_generational)
+{
+   opt_set_int(OPT_GC_GENERATIONAL, 1);
+
+   mspace_t *m = mspace_new(64 * 1024);
+
+   mptr_t p = mptr_new(m, "test");
+   int **slots = mspace_alloc(m, 10 * sizeof(int *));
+   *mptr_get(p) = slots;
+
+   for (int i = 0; i < 100; i++) {
+      // The slots array becomes old after the first collection so the
+      // only references to these objects are from an old object
+      int *value = mspace_alloc(m, sizeof(int));
+      *value = i;
+      slots[i % 10] = value;
+
+      generate_garbage(m, 100, 5 * sizeof(int));
+
+      for (int j = 0; j <= MIN(i, 9); j++)
+         ck_assert_int_eq(*slots[j], i - (i - j) % 10);
+   }
+
+   mptr_free(m, &p);
+   mspace_destroy(m);
+}
+END_TEST
+
+START_TEST(test_large_object)
+{
+   mspace_t *m = mspace_new(64 * 1024);
+
+   generate_garbage(m, 5, sizeof(int));
+
+   // Larger than the whole heap so must be allocated separately
+   mptr_t p = mptr_new(m, "test");
+   int **big = mspace_alloc(m, LARGE_OBJECT_SIZE * 4);
+   ck_assert_ptr_nonnull(big);
+   *mptr_get(p) = big;
+
+   // Only pointers on touched pages need to be scanned
+   big[LARGE_OBJECT_SIZE / sizeof(int *)] = mspace_alloc(m, sizeof(int));
+   *big[LARGE_OBJECT_SIZE / sizeof(int *)] = 42;
+
+   generate_garbage(m, 10000, 5 * sizeof(int));
+
+   ck_assert_int_eq(*big[LARGE_OBJECT_SIZE / sizeof(int *)], 42);
+
+   mspace_bzero(m, big, LARGE_OBJECT_SIZE * 4);
+   ck_assert_ptr_null(big[LARGE_OBJECT_SIZE / sizeof(int *)]);
+
+   mptr_free(m, &p);
+   mspace_destroy(m);
+}
+END_TEST
+
+START_TEST(test_large_garbage)
+{
+   mspace_t *m = mspace_new(64 * 1024);
+
+   stat_shard_t before;
+   stat_snapshot(&before);
+
+   // Unreachable large objects should eventually trigger a collection
+   // even though the small object heap never fills up
+   for (int i = 0; i < 16; i++) {
+      char *big = mspace_alloc(m, LARGE_OBJECT_SIZE);
+      ck_assert_ptr_nonnull(big);
+      big[0] = i;
+   }
+
+   stat_shard_t after;
+   stat_snapshot(&after);
+
+   ck_assert_int_gt(after.counters[STAT_GC_CYCLES],
+                    before.counters[STAT_GC_CYCLES]);
+
+   mspace_destroy(m);
+}
+END_TEST
+
+START_TEST(test_grow)
+{
+   mspace_t *m = mspace_new(64 * 1024 * 1024);
+
+   // Keep more live data than fits in the initial heap segment
+   const int nobjs = 4096;
+   mptr_t p = mptr_new(m, "test");
+   void **objs = mspace_alloc(m, nobjs * sizeof(void *));
+   *mptr_get(p) = objs;
+
+   for (int i = 0; i < nobjs; i++) {
+      int *obj = objs[i] = mspace_alloc(m, 2048);
+      *obj = i;
+      generate_garbage(m, 10, 512);
+   }
+
+   for (int i = 0; i < nobjs; i++)
+      ck_assert_int_eq(*(int *)objs[i], i);
+
+   mptr_free(m, &p);
+   mspace_destroy(m);
+}
+END_TEST
+
+START_TEST(test_mptr_chunk)
+{
+   mspace_t *m = mspace_new(1024 * 1024);
+
+   // Root slots created together should be adjacent in memory
+   mptr_t roots[100];
+   for (int i = 0; i < ARRAY_LEN(roots); i++) {
+      roots[i] = mptr_new(m, "root");
+      int *obj = *mptr_get(roots[i]) = mspace_alloc(m, sizeof(int));
+      *obj = i;
+   }
+
+   const ptrdiff_t stride =
+      (char *)mptr_get(roots[1]) - (char *)mptr_get(roots[0]);
+   ck_assert_int_gt(stride, 0);
+
+   for (int i = 1; i < ARRAY_LEN(roots); i++)
+      ck_assert_int_eq((char *)mptr_get(roots[i])
+                       - (char *)mptr_get(roots[i - 1]), stride);
+
+   generate_garbage(m, 10000, 64);
+
+   for (int i = 0; i < ARRAY_LEN(roots); i++)
+      ck_assert_int_eq(*(int *)*mptr_get(roots[i]), i);
+
+   // Freed slots are reused before allocating another chunk
+   void **slot = mptr_get(roots[50]);
+   mptr_free(m, &(roots[50]));
+   roots[50] = mptr_new(m, "reused");
+   ck_assert_ptr_eq(mptr_get(roots[50]), slot);
+   ck_assert_ptr_null(*slot);
+
+   for (int i = 0; i < ARRAY_LEN(roots); i++)
+      mptr_free(m, &(roots[i]));
+
+   mspace_destroy(m);
+}
+END_TEST
+
 Suite *get_mspace_tests(void)
 {
    Suite *s = suite_create("mspace");
@@ -308,6 +534,13 @@ Suite *get_mspace_tests(void)
    tcase_add_test(tc, test_linked_list);
    tcase_add_test(tc, test_tlab);
    tcase_add_test(tc, test_end_ptr);
+   tcase_add_test(tc, test_lazy_sweep);
+   tcase_add_test(tc, test_parallel_mark);
+   tcase_add_test(tc, test_generational);
+   tcase_add_test(tc, test_large_object);
+   tcase_add_test(tc, test_large_garbage);
+   tcase_add_test(tc, test_grow);
+   tcase_add_test(tc, test_mptr_chunk);
    suite_add_tcase(s, tc);
 
    return s;
@@ -51,7 +51,7 @@ static jit_handle_t assemble(jit_t *j, const char *text, const char *name,
 
 static jit_t *get_native_jit(void)
 {
-   opt_set_int(OPT_JIT_THRESHOLD, 1);
+   opt_set_int(OPT_NATIVE_THRESHOLD, 1);
    opt_set_int(OPT_JIT_ASYNC, 0);
 
    jit_t *j = jit_new(NULL, NULL);
@@ -642,6 +642,17 @@ START_TEST(test_shift)
    ck_assert_int_eq(jit_call(j, h2, 128, 5).integer, 4);
    ck_assert_int_eq(jit_call(j, h2, 4, 5).integer, 0);
 
+   const char *text3 =
+      "    RECV      R0, #0          \n"
+      "    RECV      R1, #1          \n"
+      "    SHR       R2, R0, R1      \n"
+      "    SEND      #0, R2          \n"
+      "    RET                       \n";
+
+   jit_handle_t h3 = assemble(j, text3, "shift3", "II");
+   ck_assert_int_eq(jit_call(j, h3, 8, 1).integer, 4);
+   ck_assert_int_eq(jit_call(j, h3, INT64_C(-1), 60).integer, 15);
+
    jit_free(j);
 }
 END_TEST
@@ -1102,6 +1113,29 @@ START_TEST(test_ccmp)
 }
 END_TEST
 
+START_TEST(test_fccmp)
+{
+   jit_t *j = get_native_jit();
+
+   const char *text1 =
+      "    RECV     R0, #0          \n"
+      "    FCMP.GE  R0, %0.0        \n"
+      "    FCCMP.LT R0, %1.5        \n"
+      "    CSET     R1              \n"
+      "    SEND     #0, R1          \n"
+      "    RET                      \n";
+
+   jit_handle_t h1 = assemble(j, text1, "fccmp1", "f");
+   ck_assert_int_eq(jit_call(j, h1, 0.0).integer, 1);
+   ck_assert_int_eq(jit_call(j, h1, 1.0).integer, 1);
+   ck_assert_int_eq(jit_call(j, h1, 1.5).integer, 0);
+   ck_assert_int_eq(jit_call(j, h1, -2.0).integer, 0);
+   ck_assert_int_eq(jit_call(j, h1, NAN).integer, 0);
+
+   jit_free(j);
+}
+END_TEST
+
 START_TEST(test_fcmp_nan)
 {
    jit_t *j = get_native_jit();
@@ -1412,6 +1446,7 @@ Suite *get_native_tests(void)
    tcase_add_test(tc, test_exp);
    tcase_add_test(tc, test_float);
    tcase_add_test(tc, test_ccmp);
+   tcase_add_test(tc, test_fccmp);
    tcase_add_test(tc, test_fcmp_nan);
    tcase_add_test(tc, test_memset);
    tcase_add_test(tc, test_move);
@@ -69,6 +69,8 @@ START_TEST(test_examine1)
       { "/a", "'1'" },
       { "/b", "\"01XU\"" },
       { "-hex /b", "\"01XU\"" },   // TODO
+      { "-offset 1 -count 2 /b", "\"1X\"" },
+      { "-offset 3 /b", "\"U\"" },
       { "/s", "\"hello\"" },
       { "/v", "(FOO, BAR, BAZ)" },
       { "/p", "42000000 FS" },
@@ -258,6 +260,58 @@ START_TEST(test_force1)
 }
 END_TEST
 
+START_TEST(test_deposit1)
+{
+   const error_t expect[] = {
+      { LINE_INVALID, "value '11' is not valid for type BIT" },
+      { LINE_INVALID, "cannot load signal /x of type BIT from a file" },
+      { -1, NULL }
+   };
+   expect_errors(expect);
+
+   input_from_file(TESTDIR "/shell/deposit1.vhd");
+
+   mir_context_t *mc = get_mir();
+   unit_registry_t *ur = get_registry();
+   jit_t *j = jit_new(ur, mc);
+
+   tree_t arch = parse_check_and_simplify(T_ENTITY, T_ARCH);
+
+   rt_model_t *m = model_new(j, NULL);
+
+   tree_t top = elab(tree_to_object(arch), j, ur, mc, NULL, NULL, m);
+   fail_if(top == NULL);
+
+   tcl_shell_t *sh = shell_new(top, j, m);
+   shell_reset(sh);
+
+   const char *result = NULL;
+
+   shell_eval(sh, "run 1 ns", &result);
+   ck_assert_str_eq(result, "");
+
+   fail_if(shell_eval(sh, "deposit /x {11}", &result));
+   fail_if(shell_eval(sh, "deposit -file " TESTDIR "/shell/deposit1.mem /x",
+                      &result));
+
+   shell_eval(sh, "deposit /x '1'", &result);
+   ck_assert_str_eq(result, "");
+
+   shell_eval(sh, "deposit -file " TESTDIR "/shell/deposit1.mem /mem",
+              &result);
+   ck_assert_str_eq(result, "");
+
+   shell_eval(sh, "run", &result);
+   ck_assert_str_eq(result, "");
+
+   shell_free(sh);
+   model_free(m);
+   jit_free(j);
+
+   check_expected_errors();
+}
+END_TEST
+
 static void echo_stdout_handler(const char *buf, size_t nchars, void *ctx)
 {
    int *state = ctx;
@@ -339,6 +393,52 @@ START_TEST(test_describe1)
 }
 END_TEST
 
+START_TEST(test_find1)
+{
+   mir_context_t *mc = get_mir();
+   unit_registry_t *ur = get_registry();
+   jit_t *j = jit_new(ur, mc);
+
+   input_from_file(TESTDIR "/shell/describe1.vhd");
+
+   tree_t arch = parse_check_and_simplify(T_ENTITY, T_ARCH);
+
+   rt_model_t *m = model_new(j, NULL);
+
+   tree_t top = elab(tree_to_object(arch), j, ur, mc, NULL, NULL, m);
+   fail_if(top == NULL);
+
+   tcl_shell_t *sh = shell_new(top, j, m);
+   shell_reset(sh);
+
+   const char *result = NULL;
+
+   const char *tests[][2] = {
+      { "signals /*", "/x /b1/y" },
+      { "signals /b1/*", "/b1/y" },
+      { "signals /c*", "" },
+      { "regions *", "/ /b1/" },
+      { "regions /b*", "/b1/" },
+   };
+
+   for (int i = 0; i < ARRAY_LEN(tests); i++) {
+      char script[128];
+      checked_sprintf(script, ARRAY_LEN(script), "find %s", tests[i][0]);
+
+      shell_eval(sh, script, &result);
+      ck_assert_msg(strcmp(result, tests[i][1]) == 0,
+                    "'%s' ==> '%s' (expected '%s')", script, result,
+                    tests[i][1]);
+   }
+
+   shell_free(sh);
+   model_free(m);
+   jit_free(j);
+
+   fail_if_errors();
+}
+END_TEST
+
 Suite *get_shell_tests(void)
 {
    Suite *s = suite_create("shell");
@@ -348,9 +448,11 @@ Suite *get_shell_tests(void)
    tcase_add_test(tc, test_examine1);
    tcase_add_test(tc, test_redirect);
    tcase_add_test(tc, test_force1);
+   tcase_add_test(tc, test_deposit1);
    tcase_add_exit_test(tc, test_exit, 5);
    tcase_add_test(tc, test_echo);
    tcase_add_test(tc, test_describe1);
+   tcase_add_test(tc, test_find1);
    suite_add_tcase(s, tc);
 
    return s;
@@ -107,7 +107,7 @@ int main(int argc, char **argv)
    nfail += RUN_TESTS(jit);
    nfail += RUN_TESTS(mspace);
    nfail += RUN_TESTS(model);
-#if defined ARCH_X86_64
+#if defined ARCH_X86_64 || defined ARCH_ARM64
    nfail += RUN_TESTS(native);
 #endif
    nfail += RUN_TESTS(psl);
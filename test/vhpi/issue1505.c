@@ -40,6 +40,14 @@ static void start_of_sim(const vhpiCbDataT *cb_data)
    h_b1 = VHPI_CHECK(vhpi_handle_by_name("b1", root));
    h_b2 = VHPI_CHECK(vhpi_handle_by_name("b2", root));
 
+   // Absolute paths are cached after the first lookup
+   for (int i = 0; i < 2; i++) {
+      vhpiHandleT h = VHPI_CHECK(vhpi_handle_by_name("ISSUE1505.Entity_1.A",
+                                                     NULL));
+      fail_unless(vhpi_compare_handles(h, h_entity1_a));
+      vhpi_release_handle(h);
+   }
+
    vhpiValueT value = {
       .format = vhpiLogicVal,
    };
@@ -0,0 +1,102 @@
+#include "vhpi_test.h"
+
+#include <string.h>
+
+static vhpiHandleT h_x;
+static vhpiHandleT h_y;
+static vhpiHandleT h_v;
+static vhpiHandleT h_batch;
+static int         ncalls;
+
+static void batch_cb(const vhpiValueChangeT *changes, int32_t count,
+                     void *user_data)
+{
+   fail_unless(user_data == &ncalls);
+
+   vhpi_printf("batch %d with %d changes", ncalls, count);
+
+   switch (ncalls++) {
+   case 0:
+      fail_unless(count == 3);
+      for (int i = 0; i < count; i++) {
+         if (vhpi_compare_handles(changes[i].obj, h_x)) {
+            fail_unless(changes[i].value->value.intg == 1);
+         }
+         else if (vhpi_compare_handles(changes[i].obj, h_y)) {
+            fail_unless(changes[i].value->value.intg == 2);
+         }
+         else {
+            fail_unless(vhpi_compare_handles(changes[i].obj, h_v));
+            fail_unless(changes[i].value->numElems == 3);
+            fail_unless(changes[i].value->value.enumvs[0] == 1);
+            fail_unless(changes[i].value->value.enumvs[1] == 0);
+            fail_unless(changes[i].value->value.enumvs[2] == 1);
+         }
+      }
+      break;
+   case 1:
+      fail_unless(count == 1);
+      fail_unless(vhpi_compare_handles(changes[0].obj, h_x));
+      fail_unless(changes[0].value->value.intg == 5);
+      break;
+   case 2:
+      fail_unless(count == 1);
+      fail_unless(vhpi_compare_handles(changes[0].obj, h_y));
+      fail_unless(changes[0].value->value.intg == 6);
+      break;
+   case 3:
+      fail_unless(count == 1);
+      fail_unless(vhpi_compare_handles(changes[0].obj, h_v));
+      fail_unless(changes[0].value->value.enumvs[1] == 1);
+      break;
+   default:
+      vhpi_assert(vhpiFailure, "unexpected batch %d", ncalls);
+   }
+}
+
+static void end_of_sim(const vhpiCbDataT *cb_data)
+{
+   fail_unless(ncalls == 4);
+
+   VHPI_CHECK(vhpi_remove_cb(h_batch));
+
+   vhpi_release_handle(h_x);
+   vhpi_release_handle(h_y);
+   vhpi_release_handle(h_v);
+}
+
+static void start_of_sim(const vhpiCbDataT *cb_data)
+{
+   vhpiHandleT root = VHPI_CHECK(vhpi_handle(vhpiRootInst, NULL));
+
+   h_x = VHPI_CHECK(vhpi_handle_by_name("x", root));
+   h_y = VHPI_CHECK(vhpi_handle_by_name("y", root));
+   h_v = VHPI_CHECK(vhpi_handle_by_name("v", root));
+
+   const vhpiHandleT objs[] = { h_x, h_y, h_v };
+   h_batch = VHPI_CHECK(vhpi_register_batch_cb(objs, 3, vhpiObjTypeVal,
+                                               batch_cb, &ncalls,
+                                               vhpiReturnCb));
+
+   vhpiCbDataT cb_info;
+   VHPI_CHECK(vhpi_get_cb_info(h_batch, &cb_info));
+   fail_unless(cb_info.reason == vhpiCbValueChangeBatch);
+   fail_unless(cb_info.user_data == &ncalls);
+
+   vhpi_release_handle(root);
+}
+
+void vhpi20_startup(void)
+{
+   vhpiCbDataT cb_data1 = {
+      .reason = vhpiCbStartOfSimulation,
+      .cb_rtn = start_of_sim,
+   };
+   VHPI_CHECK(vhpi_register_cb(&cb_data1, 0));
+
+   vhpiCbDataT cb_data2 = {
+      .reason = vhpiCbEndOfSimulation,
+      .cb_rtn = end_of_sim,
+   };
+   VHPI_CHECK(vhpi_register_cb(&cb_data2, 0));
+}
@@ -0,0 +1,80 @@
+#include "vhpi_test.h"
+
+#include <stdint.h>
+
+static vhpiHandleT h_mem;
+static vhpiHandleT h_count;
+static vhpiDirectValueT v_count;
+
+static void after_delay(const vhpiCbDataT *cb_data)
+{
+   // The pointer tracks the current value of the signal
+   fail_unless(*(const int32_t *)v_count.data == 42);
+
+   const uint8_t ones[] = { 1, 1, 1, 1 };
+   VHPI_CHECK(vhpi_put_value_direct(h_mem, ones, 4, 4, vhpiDepositPropagate));
+
+   vhpi_release_handle(h_mem);
+   vhpi_release_handle(h_count);
+}
+
+static void start_of_sim(const vhpiCbDataT *cb_data)
+{
+   vhpiHandleT root = VHPI_CHECK(vhpi_handle(vhpiRootInst, NULL));
+
+   h_mem = VHPI_CHECK(vhpi_handle_by_name("mem", root));
+   h_count = VHPI_CHECK(vhpi_handle_by_name("count", root));
+
+   vhpiDirectValueT v_mem;
+   VHPI_CHECK(vhpi_get_value_direct(h_mem, &v_mem));
+   fail_unless(v_mem.numElems == 8);
+   fail_unless(v_mem.elemSize == 1);
+   fail_unless(v_mem.stride == 1);
+   fail_unless(!v_mem.isUp);
+
+   const uint8_t a5[] = { 1, 0, 1, 0, 0, 1, 0, 1 };
+   VHPI_CHECK(vhpi_put_value_direct(h_mem, a5, 0, 8, vhpiDepositPropagate));
+
+   fail_unless(vhpi_put_value_direct(h_mem, a5, 4, 8,
+                                     vhpiDepositPropagate) != 0);
+
+   vhpiErrorInfoT info;
+   fail_unless(vhpi_check_error(&info));
+
+   VHPI_CHECK(vhpi_get_value_direct(h_count, &v_count));
+   fail_unless(v_count.numElems == 1);
+   fail_unless(v_count.elemSize == 4);
+   fail_unless(*(const int32_t *)v_count.data == 0);
+
+   vhpiHandleT h_c = VHPI_CHECK(vhpi_handle_by_name("c", root));
+
+   vhpiDirectValueT v_c;
+   VHPI_CHECK(vhpi_get_value_direct(h_c, &v_c));
+   fail_unless(v_c.numElems == 4);
+   fail_unless(v_c.isUp);
+   fail_unless(v_c.elemSize == sizeof(int32_t));
+   fail_unless(((const int32_t *)v_c.data)[2] == 30);
+
+   vhpi_release_handle(h_c);
+
+   vhpiTimeT delay = {
+      .low = 1500000
+   };
+   vhpiCbDataT cb = {
+      .reason = vhpiCbAfterDelay,
+      .cb_rtn = after_delay,
+      .time   = &delay,
+   };
+   VHPI_CHECK(vhpi_register_cb(&cb, 0));
+
+   vhpi_release_handle(root);
+}
+
+void vhpi21_startup(void)
+{
+   vhpiCbDataT cb_data = {
+      .reason = vhpiCbStartOfSimulation,
+      .cb_rtn = start_of_sim,
+   };
+   VHPI_CHECK(vhpi_register_cb(&cb_data, 0));
+}
@@ -0,0 +1,17 @@
+#include "vhpi_test.h"
+
+#include <stdint.h>
+
+int32_t vhpi22_count_ones(const uint8_t *data, int64_t length)
+{
+   int32_t count = 0;
+   for (int64_t i = 0; i < length; i++)
+      count += data[i];
+   return count;
+}
+
+void vhpi22_fill(int32_t *data, int64_t length, int32_t first)
+{
+   for (int64_t i = 0; i < length; i++)
+      data[i] = first + i;
+}
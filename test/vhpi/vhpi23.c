@@ -0,0 +1,65 @@
+#include "vhpi_test.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+static void after_delay(const vhpiCbDataT *cb_data)
+{
+   vhpiHandleT root = VHPI_CHECK(vhpi_handle(vhpiRootInst, NULL));
+
+   vhpiHandleT hv = VHPI_CHECK(vhpi_handle_by_name("v", root));
+
+   uint32_t bits[2], xmask[2];
+   fail_unless(vhpi_get_value_packed(hv, bits, xmask, 1) == 2);
+   VHPI_CHECK(vhpi_get_value_packed(hv, bits, xmask, 2));
+
+   // Leftmost element V(39) is in the least significant bit
+   fail_unless(bits[0] == 0x10);
+   fail_unless(xmask[0] == 0x08);
+   fail_unless(bits[1] == 0xc0);
+   fail_unless(xmask[1] == 0x20);
+
+   vhpi_release_handle(hv);
+
+   vhpiHandleT hb = VHPI_CHECK(vhpi_handle_by_name("b", root));
+
+   VHPI_CHECK(vhpi_get_value_packed(hb, bits, NULL, 1));
+   fail_unless(bits[0] == 0x69);
+
+   vhpi_release_handle(hb);
+
+   vhpiHandleT hi = VHPI_CHECK(vhpi_handle_by_name("i", root));
+
+   fail_unless(vhpi_get_value_packed(hi, bits, xmask, 2) == -1);
+
+   vhpiErrorInfoT info;
+   fail_unless(vhpi_check_error(&info));
+
+   vhpiIntT intgs[3];
+   vhpiValueT value = {
+      .format      = vhpiIntVecVal,
+      .bufSize     = sizeof(intgs),
+      .value.intgs = intgs,
+   };
+   VHPI_CHECK(vhpi_get_value(hi, &value));
+   fail_unless(value.numElems == 3);
+   fail_unless(intgs[0] == 5);
+   fail_unless(intgs[1] == 6);
+   fail_unless(intgs[2] == 7);
+
+   vhpi_release_handle(hi);
+   vhpi_release_handle(root);
+}
+
+void vhpi23_startup(void)
+{
+   vhpiTimeT delay = {
+      .low = 1000000
+   };
+   vhpiCbDataT cb = {
+      .reason = vhpiCbAfterDelay,
+      .cb_rtn = after_delay,
+      .time   = &delay,
+   };
+   VHPI_CHECK(vhpi_register_cb(&cb, 0));
+}
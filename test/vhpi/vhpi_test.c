@@ -64,6 +64,10 @@ static const vhpi_test_t tests[] = {
    { "issue1463", issue1463_startup },
    { "issue1473", issue1473_startup },
    { "issue1505", issue1505_startup },
+   { "vhpi20",    vhpi20_startup },
+   { "vhpi21",    vhpi21_startup },
+   { "vhpi22",    NULL },
+   { "vhpi23",    vhpi23_startup },
    { NULL,        NULL },
 };
 
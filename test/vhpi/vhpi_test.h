@@ -76,5 +76,8 @@ void issue1428_startup(void);
 void issue1463_startup(void);
 void issue1473_startup(void);
 void issue1505_startup(void);
+void vhpi20_startup(void);
+void vhpi21_startup(void);
+void vhpi23_startup(void);
 
 #endif  // _VHPI_TEST_H
@@ -0,0 +1,177 @@
+#!/bin/sh
+#
+# Run the simulation benchmarks in test/perf and print the results as
+# JSON.  Must be run from the build directory.
+#
+# Usage: bench.sh [-n REPS] [-c CPU] [-b BASELINE] [-t PERCENT] [NAME...]
+#
+#   -n REPS      Number of times to run each benchmark (default 3)
+#   -c CPU       Pin the simulation to this CPU with taskset
+#   -b BASELINE  Compare against the JSON output of a previous run
+#   -t PERCENT   Regression threshold for -b (default 5)
+#
+# The median of each measurement over all repetitions is reported.
+# With -b the exit status is non-zero if the run time of any benchmark
+# increased by more than the threshold.
+#
+
+reps=3
+cpu=
+baseline=
+threshold=5
+
+while getopts "n:c:b:t:" opt; do
+  case $opt in
+    n) reps=$OPTARG ;;
+    c) cpu=$OPTARG ;;
+    b) baseline=$OPTARG ;;
+    t) threshold=$OPTARG ;;
+    *) exit 1 ;;
+  esac
+done
+shift $((OPTIND - 1))
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+perf=$root/test/perf
+nvc=${NVC:-./bin/nvc}
+work=$(mktemp -d)
+trap 'rm -rf $work' EXIT
+
+export NVC_LIBPATH=./lib
+export NVC_PIN_THREADS=1
+
+if [ ! -x $nvc ]; then
+  echo "cannot find $nvc: run from the build directory" 1>&2
+  exit 1
+fi
+
+# Name, source file, standard, analysis, elaboration, and run options.
+# The top-level unit has the same name as the source file.
+benchmarks="
+after|after.vhd|08|||
+arraycase|arraycase.vhd|93|||
+bigcase|bigcase.vhd|93|||
+bigram|bigram.vhd|93|||
+dyn_agg|dyn_agg.vhd|08|||
+grind|grind.vhd|93|||
+toggle_cov|toggle_cov.vhd|08||--cover=toggle|
+psl_clock|psl_clock.vhd|08|--psl||
+vlog_counter|vlog_counter.v|08|||
+after_wave|after.vhd|08|||--wave=$work/after.fst
+"
+
+pin=
+if [ -n "$cpu" ]; then
+  if command -v taskset >/dev/null; then
+    pin="taskset -c $cpu"
+  else
+    echo "taskset not found: ignoring -c" 1>&2
+  fi
+fi
+
+now_ms() {
+  echo $(($(date +%s%N) / 1000000))
+}
+
+median() {
+  sort -n | awk '{ v[NR] = $1 } END { print v[int((NR + 1) / 2)] }'
+}
+
+selected() {
+  [ $# -eq 1 ] && return 0
+  name=$1
+  shift 1
+  for n in $*; do
+    [ "$n" = "$name" ] && return 0
+  done
+  return 1
+}
+
+results=$work/results.json
+echo "[" > $results
+
+first=1
+echo "$benchmarks" | while IFS='|' read name file std aopts eopts ropts; do
+  [ -z "$name" ] && continue
+  selected $name "$@" || continue
+
+  top=${file%.*}
+  lib=$work/$name
+
+  echo "running $name" 1>&2
+
+  for i in $(seq $reps); do
+    start=$(now_ms)
+    if ! $nvc --std=$std --work=work:$lib -a $aopts $perf/$file \
+         -e $eopts -O3 $top </dev/null >$work/elab.log 2>&1; then
+      cat $work/elab.log 1>&2
+      exit 1
+    fi
+    echo $(($(now_ms) - start)) >> $work/$name.elab
+
+    if ! $pin $nvc --std=$std --work=work:$lib -r --stats $ropts $top \
+         </dev/null >$work/run.log 2>&1; then
+      cat $work/run.log 1>&2
+      exit 1
+    fi
+
+    sed -n 's/.*setup:\([0-9]*\)ms run:\([0-9]*\)ms .*maxrss:\([0-9]*\)kB.*/\1 \2 \3/p' \
+        $work/run.log > $work/stats
+    read setup run rss < $work/stats
+    echo $setup >> $work/$name.setup
+    echo $run >> $work/$name.run
+    echo $rss >> $work/$name.rss
+  done
+
+  [ $first = 1 ] || echo "," >> $results
+  first=0
+
+  printf '  {"name": "%s", "elab_ms": %d, "setup_ms": %d, "run_ms": %d, "maxrss_kb": %d}' \
+         $name $(median < $work/$name.elab) $(median < $work/$name.setup) \
+         $(median < $work/$name.run) $(median < $work/$name.rss) >> $results
+done || exit 1
+
+echo >> $results
+echo "]" >> $results
+
+cat $results
+
+[ -z "$baseline" ] && exit 0
+
+# Results are printed one per line so they can be compared with awk
+awk -v threshold=$threshold '
+  function field(line, key) {
+    if (match(line, "\"" key "\": *[0-9]+")) {
+      s = substr(line, RSTART, RLENGTH)
+      sub(/.*: */, "", s)
+      return s + 0
+    }
+    return -1
+  }
+  function name(line) {
+    if (match(line, /"name": *"[^"]*"/)) {
+      s = substr(line, RSTART, RLENGTH)
+      sub(/.*: *"/, "", s)
+      sub(/"$/, "", s)
+      return s
+    }
+    return ""
+  }
+  FNR == NR {
+    if ((n = name($0)) != "")
+      base[n] = field($0, "run_ms")
+    next
+  }
+  {
+    if ((n = name($0)) == "" || !(n in base) || base[n] <= 0)
+      next
+    cur = field($0, "run_ms")
+    delta = (cur - base[n]) * 100.0 / base[n]
+    if (delta > threshold) {
+      printf "%s: run time regressed by %.1f%% (%d ms -> %d ms)\n", \
+        n, delta, base[n], cur > "/dev/stderr"
+      failed = 1
+    }
+  }
+  END { exit failed }
+' $baseline $results